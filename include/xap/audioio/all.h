@@ -10,10 +10,35 @@
 //
 //  Imports.
 //
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/audiofile.h>
+#include <xap/audioio/audiofilewriter.h>
+#include <xap/audioio/beamformer.h>
+#include <xap/audioio/binaural.h>
+#include <xap/audioio/dcblocker.h>
 #include <xap/audioio/device.h>
+#include <xap/audioio/dither.h>
+#include <xap/audioio/doaestimator.h>
+#include <xap/audioio/dtmf.h>
+#include <xap/audioio/echocanceller.h>
 #include <xap/audioio/error.h>
+#include <xap/audioio/fingerprint.h>
+#include <xap/audioio/framequeue.h>
+#include <xap/audioio/g711.h>
+#include <xap/audioio/limiter.h>
+#include <xap/audioio/loop.h>
+#include <xap/audioio/lossconcealer.h>
+#include <xap/audioio/microphonearray.h>
+#include <xap/audioio/monitormixer.h>
+#include <xap/audioio/multibandcompressor.h>
 #include <xap/audioio/player.h>
+#include <xap/audioio/playlist.h>
+#include <xap/audioio/promptcache.h>
 #include <xap/audioio/recorder.h>
+#include <xap/audioio/source.h>
+#include <xap/audioio/stage.h>
+#include <xap/audioio/tonegenerator.h>
 #include <xap/audioio/version.h>
 
 #endif  //  #ifndef XAP_AUDIOIO_ALL_H__
\ No newline at end of file
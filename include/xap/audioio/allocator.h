@@ -0,0 +1,251 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_ALLOCATOR_H__
+#define XAP_AUDIOIO_ALLOCATOR_H__
+
+//
+//  Imports.
+//
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Classes.
+//
+
+/**
+ *  Interface of all allocator classes.
+ * 
+ *  All memory owned by the SDK (stream objects, buffers, rings and DSP 
+ *  states) is allocated through an allocator.
+ */
+class IAllocator {
+public:
+    //
+    //  Destructor.
+    //
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~IAllocator() noexcept {}
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Allocate memory.
+     * 
+     *  @param size
+     *      The size (in bytes).
+     *  @param alignment
+     *      The alignment (a power of 2).
+     *  @return
+     *      The memory, nullptr if allocation was failed.
+     */
+    virtual void *allocate(size_t size, size_t alignment) noexcept = 0;
+
+    /**
+     *  Deallocate memory.
+     * 
+     *  @param pointer
+     *      The memory returned by allocate().
+     *  @param size
+     *      The size that was passed to allocate().
+     *  @param alignment
+     *      The alignment that was passed to allocate().
+     */
+    virtual void deallocate(
+        void   *pointer, 
+        size_t  size, 
+        size_t  alignment
+    ) noexcept = 0;
+};
+
+/**
+ *  Default allocator (system aligned allocation).
+ * 
+ *  @extends IAllocator
+ */
+class DefaultAllocator: public xap::audioio::IAllocator {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     */
+    DefaultAllocator() noexcept;
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~DefaultAllocator() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Allocate memory.
+     * 
+     *  @param size
+     *      The size (in bytes).
+     *  @param alignment
+     *      The alignment (a power of 2).
+     *  @return
+     *      The memory, nullptr if allocation was failed.
+     */
+    virtual void *allocate(size_t size, size_t alignment) noexcept override;
+
+    /**
+     *  Deallocate memory.
+     * 
+     *  @param pointer
+     *      The memory returned by allocate().
+     *  @param size
+     *      The size that was passed to allocate().
+     *  @param alignment
+     *      The alignment that was passed to allocate().
+     */
+    virtual void deallocate(
+        void   *pointer, 
+        size_t  size, 
+        size_t  alignment
+    ) noexcept override;
+};
+
+/**
+ *  STL allocator adapter of xap::audioio::IAllocator.
+ */
+template<class T>
+class StlAllocator {
+public:
+    //
+    //  Types.
+    //
+    typedef T value_type;
+
+    //
+    //  Constructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @param allocator
+     *      The allocator.
+     */
+    StlAllocator(xap::audioio::IAllocator *allocator) noexcept :
+        m_allocator(allocator)
+    {}
+
+    /**
+     *  Construct (Copy) the object.
+     * 
+     *  @param src
+     *      The source object.
+     */
+    template<class U>
+    StlAllocator(const xap::audioio::StlAllocator<U> &src) noexcept :
+        m_allocator(src.m_allocator)
+    {}
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Allocate memory.
+     * 
+     *  @throw std::bad_alloc
+     *      Raised if memory allocation was failed.
+     *  @param count
+     *      The count of elements.
+     *  @return
+     *      The memory.
+     */
+    T *allocate(size_t count) {
+        void *pointer = this->m_allocator->allocate(
+            count * sizeof(T), 
+            alignof(T)
+        );
+        if (pointer == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(pointer);
+    }
+
+    /**
+     *  Deallocate memory.
+     * 
+     *  @param pointer
+     *      The memory.
+     *  @param count
+     *      The count of elements.
+     */
+    void deallocate(T *pointer, size_t count) noexcept {
+        this->m_allocator->deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    //
+    //  Members.
+    //
+    xap::audioio::IAllocator *m_allocator;
+};
+
+template<class T, class U>
+bool operator==(
+    const xap::audioio::StlAllocator<T> &a, 
+    const xap::audioio::StlAllocator<U> &b
+) noexcept {
+    return a.m_allocator == b.m_allocator;
+}
+
+template<class T, class U>
+bool operator!=(
+    const xap::audioio::StlAllocator<T> &a, 
+    const xap::audioio::StlAllocator<U> &b
+) noexcept {
+    return a.m_allocator != b.m_allocator;
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Get the default allocator.
+ * 
+ *  @return
+ *      The allocator set by set_default_allocator(), or the system allocator 
+ *      (xap::audioio::DefaultAllocator) if not set.
+ */
+xap::audioio::IAllocator *get_default_allocator() noexcept;
+
+/**
+ *  Set the default allocator.
+ * 
+ *  The default allocator is used by all factories that were constructed 
+ *  without an allocator. It must be set before any SDK object was created 
+ *  and must outlive all SDK objects.
+ * 
+ *  @param allocator
+ *      The allocator, nullptr to restore the system allocator.
+ */
+void set_default_allocator(xap::audioio::IAllocator *allocator) noexcept;
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_ALLOCATOR_H__
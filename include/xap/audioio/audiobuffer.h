@@ -0,0 +1,491 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_AUDIOBUFFER_H__
+#define XAP_AUDIOIO_AUDIOBUFFER_H__
+
+//
+//  Imports.
+//
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/error.h>
+#include <xap/core/buffer/buffer.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Sample format.
+typedef uint8_t SampleFormat;
+const static xap::audioio::SampleFormat SAMPLEFORMAT_INT16   = 1U;
+const static xap::audioio::SampleFormat SAMPLEFORMAT_INT32   = 2U;
+const static xap::audioio::SampleFormat SAMPLEFORMAT_FLOAT32 = 3U;
+const static xap::audioio::SampleFormat SAMPLEFORMAT_ULAW    = 4U;  //  G.711
+const static xap::audioio::SampleFormat SAMPLEFORMAT_ALAW    = 5U;  //  G.711
+
+//  Alignment of the audio buffer storage (in bytes).
+const static size_t AUDIOBUFFER_ALIGNMENT = 64U;
+
+//
+//  Structure.
+//
+typedef struct AudioFormat_ {
+    xap::audioio::SampleFormat sample_format;
+    uint8_t                    channel_count;
+    uint8_t                    __pad1[2];
+
+    uint32_t                   sample_rate;
+} AudioFormat;
+
+//
+//  Declare.
+//
+struct AudioBufferBlock_;
+struct AudioBufferPoolCore_;
+
+//
+//  Public functions.
+//
+
+/**
+ *  Get the size of one sample.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @return
+ *      The size (in bytes), 0 if the format is unknown.
+ */
+size_t get_sample_size(xap::audioio::SampleFormat sample_format) noexcept;
+
+/**
+ *  Get the size of one frame.
+ * 
+ *  @param format
+ *      The audio format.
+ *  @return
+ *      The size (in bytes).
+ */
+size_t get_frame_size(const xap::audioio::AudioFormat &format) noexcept;
+
+//
+//  Classes.
+//
+
+/**
+ *  Pool of fixed-size, aligned audio buffer storage blocks.
+ * 
+ *  Blocks are preallocated, acquiring and releasing blocks is lock-free so 
+ *  that it can be done on the audio thread. Blocks that are still referenced 
+ *  by audio buffers stay valid after the pool was destructed.
+ */
+class AudioBufferPool {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              block_size == 0 or block_count == 0.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param block_size
+     *      The size of each block (in bytes).
+     *  @param block_count
+     *      The count of blocks.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    AudioBufferPool(
+        size_t                    block_size,
+        size_t                    block_count,
+        xap::audioio::IAllocator *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~AudioBufferPool() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get the size of each block.
+     * 
+     *  @return
+     *      The size (in bytes).
+     */
+    size_t get_block_size() const noexcept;
+
+    /**
+     *  Get the count of available (not acquired) blocks.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_available_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    AudioBufferPool(const AudioBufferPool &) = delete;
+    AudioBufferPool &operator=(const AudioBufferPool &) = delete;
+
+    //
+    //  Members.
+    //
+    struct AudioBufferPoolCore_ *m_core;
+
+    //
+    //  Friend classes.
+    //
+    friend class AudioBuffer;
+};
+
+/**
+ *  Frame-aware audio buffer.
+ * 
+ *  An audio buffer is a reference to (a range of) aligned sample storage 
+ *  with its format and timestamp. Copying an audio buffer or taking a slice 
+ *  of it shares the storage (reference counted), so one buffer can be 
+ *  delivered to multiple subscribers without copying.
+ */
+class AudioBuffer {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct an empty object.
+     */
+    AudioBuffer() noexcept;
+
+    /**
+     *  Construct (Copy) the object (shares the storage).
+     * 
+     *  @param src
+     *      The source object.
+     */
+    AudioBuffer(const xap::audioio::AudioBuffer &src) noexcept;
+
+    /**
+     *  Construct (Move) the object.
+     * 
+     *  @param src
+     *      The source object.
+     */
+    AudioBuffer(xap::audioio::AudioBuffer &&src) noexcept;
+
+    /**
+     *  Destruct the object.
+     */
+    ~AudioBuffer() noexcept;
+
+    //
+    //  Operators.
+    //
+    xap::audioio::AudioBuffer &operator=(
+        const xap::audioio::AudioBuffer &src
+    ) noexcept;
+    xap::audioio::AudioBuffer &operator=(
+        xap::audioio::AudioBuffer &&src
+    ) noexcept;
+
+    //
+    //  Public static methods.
+    //
+
+    /**
+     *  Allocate an audio buffer from a pool.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The frames do not fit in a block of the pool or the 
+     *              format is invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              No block is available in the pool.
+     * 
+     *  @param pool
+     *      The pool.
+     *  @param format
+     *      The audio format.
+     *  @param frame_count
+     *      The count of frames.
+     *  @return
+     *      The audio buffer (the content is not initialized).
+     */
+    static xap::audioio::AudioBuffer allocate(
+        xap::audioio::AudioBufferPool     &pool,
+        const xap::audioio::AudioFormat   &format,
+        size_t                             frame_count
+    );
+
+    /**
+     *  Allocate an audio buffer with dedicated storage.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format is invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param format
+     *      The audio format.
+     *  @param frame_count
+     *      The count of frames.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     *  @return
+     *      The audio buffer (the content is not initialized).
+     */
+    static xap::audioio::AudioBuffer allocate(
+        const xap::audioio::AudioFormat   &format,
+        size_t                             frame_count,
+        xap::audioio::IAllocator          *allocator = nullptr
+    );
+
+    /**
+     *  Wrap external memory (without copying).
+     * 
+     *  The audio buffer does not own the memory, the memory must be valid as 
+     *  long as the audio buffer (and its slices) is used.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format is invalid (xap::audioio::ERROR_PARAMETER).
+     *  @param pointer
+     *      The memory.
+     *  @param frame_count
+     *      The count of frames.
+     *  @param format
+     *      The audio format.
+     *  @return
+     *      The audio buffer.
+     */
+    static xap::audioio::AudioBuffer wrap(
+        void                            *pointer,
+        size_t                           frame_count,
+        const xap::audioio::AudioFormat &format
+    );
+
+    /**
+     *  Wrap a buffer (without copying).
+     * 
+     *  The buffer must be valid as long as the audio buffer (and its slices) 
+     *  is used.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format is invalid or the length of the buffer is not 
+     *      a multiple of frame size (xap::audioio::ERROR_PARAMETER).
+     *  @param buffer
+     *      The buffer.
+     *  @param format
+     *      The audio format.
+     *  @return
+     *      The audio buffer.
+     */
+    static xap::audioio::AudioBuffer wrap(
+        xap::core::buffer::Buffer       &buffer,
+        const xap::audioio::AudioFormat &format
+    );
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get a slice (shares the storage).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the range is out of the buffer 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param frame_offset
+     *      The offset of the first frame.
+     *  @param frame_count
+     *      The count of frames.
+     *  @return
+     *      The slice (the timestamp is adjusted by the offset).
+     */
+    xap::audioio::AudioBuffer slice(
+        size_t frame_offset, 
+        size_t frame_count
+    ) const;
+
+    /**
+     *  Copy to a new buffer.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if memory allocation was failed 
+     *      (xap::audioio::ERROR_ALLOC).
+     *  @return
+     *      The buffer.
+     */
+    xap::core::buffer::Buffer to_buffer() const;
+
+    /**
+     *  Get whether the buffer is empty (references no storage).
+     * 
+     *  @return
+     *      True if empty.
+     */
+    bool is_empty() const noexcept;
+
+    /**
+     *  Get whether the storage is referenced by this buffer only (or is not 
+     *  owned by the buffer).
+     * 
+     *  @return
+     *      True if unique.
+     */
+    bool is_unique() const noexcept;
+
+    /**
+     *  Get the pointer of the first frame.
+     * 
+     *  @return
+     *      The pointer.
+     */
+    uint8_t *get_pointer() const noexcept;
+
+    /**
+     *  Get the pointer of the first frame as samples.
+     * 
+     *  @return
+     *      The pointer.
+     */
+    template<class T>
+    T *get_samples() const noexcept {
+        return reinterpret_cast<T *>(this->m_pointer);
+    }
+
+    /**
+     *  Get the length.
+     * 
+     *  @return
+     *      The length (in bytes).
+     */
+    size_t get_length() const noexcept;
+
+    /**
+     *  Get the count of frames.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_frame_count() const noexcept;
+
+    /**
+     *  Get the count of samples (frames * channels).
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_sample_count() const noexcept;
+
+    /**
+     *  Get the audio format.
+     * 
+     *  @return
+     *      The audio format.
+     */
+    const xap::audioio::AudioFormat &get_format() const noexcept;
+
+    /**
+     *  Get the sample format.
+     * 
+     *  @return
+     *      The sample format.
+     */
+    xap::audioio::SampleFormat get_sample_format() const noexcept;
+
+    /**
+     *  Get the count of channels.
+     * 
+     *  @return
+     *      The count.
+     */
+    uint8_t get_channel_count() const noexcept;
+
+    /**
+     *  Get the sample rate.
+     * 
+     *  @return
+     *      The sample rate (in Hz).
+     */
+    uint32_t get_sample_rate() const noexcept;
+
+    /**
+     *  Get the timestamp.
+     * 
+     *  @return
+     *      The position of the first frame in the stream (in frames).
+     */
+    int64_t get_timestamp() const noexcept;
+
+    /**
+     *  Set the timestamp.
+     * 
+     *  @param timestamp
+     *      The position of the first frame in the stream (in frames).
+     */
+    void set_timestamp(int64_t timestamp) noexcept;
+
+    /**
+     *  Truncate the buffer (keeps the storage).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if frame_count is larger than the count of frames 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param frame_count
+     *      The new count of frames.
+     */
+    void truncate(size_t frame_count);
+
+private:
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Release the reference of the storage.
+     */
+    void release() noexcept;
+
+    //
+    //  Members.
+    //
+    struct AudioBufferBlock_  *m_block;
+    uint8_t                   *m_pointer;
+    size_t                     m_frame_count;
+    int64_t                    m_timestamp;
+    xap::audioio::AudioFormat  m_format;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_AUDIOBUFFER_H__
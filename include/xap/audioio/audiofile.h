@@ -0,0 +1,569 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_AUDIOFILE_H__
+#define XAP_AUDIOIO_AUDIOFILE_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Audio file container.
+typedef uint8_t AudioFileContainer;
+const static xap::audioio::AudioFileContainer AUDIOFILE_WAV   = 1U;
+const static xap::audioio::AudioFileContainer AUDIOFILE_AIFF  = 2U;
+const static xap::audioio::AudioFileContainer AUDIOFILE_CAF   = 3U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Audio file information (parsed from the header).
+ */
+typedef struct AudioFileInfo_ {
+    //  Sample rate (in Hz) and count of channels.
+    uint32_t                          sample_rate;
+    uint32_t                          channel_count;
+
+    //  Bits of each sample (8, 16, 24 or 32 for integer samples, 32 or 64 
+    //  for float samples, 8 for G.711 samples).
+    uint32_t                          bits_per_sample;
+
+    //  Container and sample encoding.
+    xap::audioio::AudioFileContainer  container;
+    bool                              is_float;
+    bool                              is_big_endian;
+    bool                              is_unsigned;
+    bool                              is_ulaw;
+    bool                              is_alaw;
+
+    //  Count of frames.
+    uint64_t                          frame_count;
+
+    //  Offset of the first frame (in bytes).
+    uint64_t                          data_offset;
+
+    //  Offset and size of the seek index (in bytes, 0 if the file has no 
+    //  index, see AudioFileIndex).
+    uint64_t                          index_offset;
+    uint64_t                          index_size;
+
+    //  Offset and size of the trim map (in bytes, 0 if no silence was 
+    //  trimmed, see AudioFileTrimEntry).
+    uint64_t                          trim_offset;
+    uint64_t                          trim_size;
+} AudioFileInfo;
+
+/**
+ *  Seek index entry.
+ */
+typedef struct AudioFileIndexEntry_ {
+    //  Position (in file frames).
+    uint64_t  frame;
+
+    //  Wall-clock time at which the frame was recorded (in microseconds 
+    //  since the Unix epoch).
+    int64_t   time;
+
+    //  Offset of the frame (in bytes from the beginning of the file).
+    uint64_t  offset;
+} AudioFileIndexEntry;
+
+/**
+ *  Trim map entry (written by AudioFileWriter where silence was trimmed).
+ */
+typedef struct AudioFileTrimEntry_ {
+    //  Position at which the recording resumed (in file frames).
+    uint64_t  frame;
+
+    //  Position of the same frame in the original recording (in frames, 
+    //  the frames in between were trimmed).
+    uint64_t  source_frame;
+} AudioFileTrimEntry;
+
+/**
+ *  Seek index entries (ordered by position, see AudioFileIndex).
+ */
+typedef std::vector<
+    xap::audioio::AudioFileIndexEntry,
+    xap::audioio::StlAllocator<xap::audioio::AudioFileIndexEntry>
+> AudioFileIndexEntries;
+
+/**
+ *  Trim map entries (ordered by position, see AudioFileIndex).
+ */
+typedef std::vector<
+    xap::audioio::AudioFileTrimEntry,
+    xap::audioio::StlAllocator<xap::audioio::AudioFileTrimEntry>
+> AudioFileTrimEntries;
+
+/**
+ *  Audio file reader options.
+ */
+typedef struct AudioFileReaderOptions_ {
+    //  Count of file frames prefetched ahead of the reader (the prefetch 
+    //  thread refills the buffer when half of it was read).
+    size_t  buffer_frames = 32768U;
+} AudioFileReaderOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Streaming audio file reader (WAV/RF64, AIFF/AIFC and CAF with 
+ *  8/16/24/32-bit integer or 32/64-bit float samples of either byte order, 
+ *  or G.711 samples).
+ * 
+ *  The header is parsed once when the reader is constructed. A process-wide 
+ *  prefetch thread reads the audio data of all readers into their ring 
+ *  buffers, the audio thread only converts it (SIMD kernels) to the output 
+ *  format, so read() never blocks on I/O: frames which were not prefetched 
+ *  yet are missing (played as silence). Mono files can be played on any 
+ *  count of channels and any file can be played on one channel (downmixed), 
+ *  files at other sample rates are resampled (windowed-sinc, polyphase).
+ * 
+ *  Seeking is sample-accurate (in output frames), the frames of the new 
+ *  position are missing until the prefetch thread has read them.
+ * 
+ *  @extends ISource
+ */
+class AudioFileReader: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object (parse the header and prefetch the beginning of 
+     *  the audio data).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The output format or the options are invalid.
+     * 
+     *          - xap::audioio::ERROR_IO:
+     *              The file cannot be opened or read.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The file is malformed, its encoding is not supported or 
+     *              its channels cannot be mapped to the output channels.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              The prefetch thread cannot be started.
+     * 
+     *  @param path
+     *      The path of the file.
+     *  @param output_format
+     *      The output audio format (16-bit, 32-bit or 32-bit float).
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    AudioFileReader(
+        const char                                   *path,
+        const xap::audioio::AudioFormat              &output_format,
+        const xap::audioio::AudioFileReaderOptions   &options = 
+            xap::audioio::AudioFileReaderOptions(),
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~AudioFileReader() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data (on the audio thread, never blocks on I/O).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the output mismatched.
+     * 
+     *          - xap::audioio::ERROR_IO:
+     *              The prefetch thread failed to read the file.
+     * 
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (less than requested at the end of the 
+     *      file, or if the frames were not prefetched yet).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Seek (thread-safe, the position is updated at once, the frames of the 
+     *  new position are read once the prefetch thread has served it).
+     * 
+     *  @param frame
+     *      The position (in output frames, clamped to the length).
+     */
+    void seek(uint64_t frame) noexcept;
+
+    /**
+     *  Get the file information.
+     * 
+     *  @return
+     *      The information.
+     */
+    const xap::audioio::AudioFileInfo &get_info() const noexcept;
+
+    /**
+     *  Get the length of the file (in output frames).
+     * 
+     *  @return
+     *      The length.
+     */
+    uint64_t get_length() const noexcept;
+
+    /**
+     *  Get the position of the next frame read (in output frames).
+     * 
+     *  @return
+     *      The position.
+     */
+    uint64_t get_position() const noexcept;
+
+    /**
+     *  Get whether all frames were read.
+     * 
+     *  @return
+     *      True if so.
+     */
+    bool is_finished() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    AudioFileReader(const AudioFileReader &) = delete;
+    AudioFileReader &operator=(const AudioFileReader &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Serve the pending seek and fill the ring buffer (on the prefetch 
+     *  thread).
+     */
+    void prefetch() noexcept;
+
+    /**
+     *  Get the first file frame which is needed to render an output frame.
+     * 
+     *  @param frame
+     *      The output frame.
+     *  @return
+     *      The file frame (may be negative while resampling, the frames 
+     *      before the file are silent).
+     */
+    int64_t get_first_input(uint64_t frame) const noexcept;
+
+    /**
+     *  Decode file frames to 32-bit float samples in the working channels 
+     *  (downmixed if the output is mono).
+     * 
+     *  @param raw
+     *      The file frames (in the ring buffer).
+     *  @param frame_count
+     *      The count of frames.
+     *  @param output
+     *      The samples (output).
+     */
+    void decode(
+        const uint8_t  *raw,
+        size_t          frame_count,
+        float          *output
+    ) noexcept;
+
+    /**
+     *  Get the head of the ring buffer data of an epoch (on the reader 
+     *  thread).
+     * 
+     *  @param epoch
+     *      The epoch.
+     *  @param tail
+     *      The tail.
+     *  @return
+     *      The head, or the tail if the prefetch thread served another seek 
+     *      meanwhile (the data after the tail may belong to the new epoch).
+     */
+    uint64_t get_epoch_head(uint32_t epoch, uint64_t tail) const noexcept;
+
+    /**
+     *  Append frames to the resampler history.
+     * 
+     *  @param epoch
+     *      The epoch of the reader.
+     *  @param is_end
+     *      True if the prefetch thread reached the end of the file.
+     *  @return
+     *      False if no frame is available yet.
+     */
+    bool fill_history(uint32_t epoch, bool is_end) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFileInfo              m_info;
+    xap::audioio::AudioFormat                m_output_format;
+    xap::audioio::AudioFileReaderOptions     m_options;
+    FILE                                    *m_file;
+    uint8_t                                 *m_ring;
+    size_t                                   m_capacity;
+    size_t                                   m_frame_size;
+    size_t                                   m_work_channels;
+    size_t                                   m_half;
+    size_t                                   m_tap_count;
+    size_t                                   m_history_capacity;
+    uint64_t                                 m_rate_in;
+    uint64_t                                 m_rate_out;
+    uint64_t                                 m_length;
+    bool                                     m_is_resampling;
+    bool                                     m_is_direct;
+    uint8_t                                  __pad1[6];
+
+    //  Seek requests (any thread) and the seeks served by the prefetch 
+    //  thread (the ring buffer data of an epoch starts at 'epoch_head', the 
+    //  epoch is 0 while the prefetch thread updates the snapshot).
+    std::atomic<uint64_t>                    m_seek_target;
+    std::atomic<uint32_t>                    m_seek_epoch;
+    std::atomic<uint32_t>                    m_epoch;
+    std::atomic<uint32_t>                    m_end_epoch;
+    std::atomic<bool>                        m_has_error;
+    std::atomic<uint64_t>                    m_epoch_target;
+    std::atomic<uint64_t>                    m_epoch_head;
+    std::atomic<uint64_t>                    m_head;
+    std::atomic<uint64_t>                    m_tail;
+
+    //  Prefetch thread state.
+    uint32_t                                 m_producer_epoch;
+    uint64_t                                 m_file_frame;
+
+    //  Reader state.
+    uint32_t                                 m_consumer_epoch;
+    int64_t                                  m_input;
+    uint64_t                                 m_phase;
+    int64_t                                  m_history_start;
+    size_t                                   m_history_count;
+    std::atomic<uint64_t>                    m_position;
+    std::atomic<bool>                        m_is_finished;
+    xap::audioio::AudioBuffer                m_taps;
+    xap::audioio::AudioBuffer                m_history;
+    xap::audioio::AudioBuffer                m_decoded;
+    xap::audioio::AudioBuffer                m_work;
+
+    friend class AudioFilePrefetcher;
+};
+
+/**
+ *  Seek index of an audio file (written by AudioFileWriter).
+ * 
+ *  The index is loaded with a single read when the object is constructed.
+ *  Each entry maps a position and the wall-clock time at which it was 
+ *  recorded to its byte offset, so any position of a long recording is 
+ *  located with a binary search (the frames between two entries have a 
+ *  constant size).
+ * 
+ *  If silence was trimmed (see AudioFileWriterOptions::trim_silence), the 
+ *  trim map is loaded as well, so positions are translated between the 
+ *  file and the original recording.
+ */
+class AudioFileIndex {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object (load the index).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_IO:
+     *              The file cannot be opened or read.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The file is malformed, not supported or has no index.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param path
+     *      The path of the file.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    explicit AudioFileIndex(
+        const char                *path,
+        xap::audioio::IAllocator  *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~AudioFileIndex() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get the file information.
+     * 
+     *  @return
+     *      The information.
+     */
+    const xap::audioio::AudioFileInfo &get_info() const noexcept;
+
+    /**
+     *  Get the count of frames between two entries.
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    uint32_t get_granularity() const noexcept;
+
+    /**
+     *  Get the entries (ordered by position).
+     * 
+     *  @return
+     *      The entries.
+     */
+    const xap::audioio::AudioFileIndexEntries &get_entries() const noexcept;
+
+    /**
+     *  Find the last entry at or before a position.
+     * 
+     *  @param frame
+     *      The position (in file frames).
+     *  @return
+     *      The entry (nullptr if the index is empty).
+     */
+    const xap::audioio::AudioFileIndexEntry *find_frame(uint64_t frame)
+        const noexcept;
+
+    /**
+     *  Find the last entry recorded at or before a wall-clock time.
+     * 
+     *  @param time
+     *      The time (in microseconds since the Unix epoch).
+     *  @return
+     *      The entry (nullptr if the time is before the first entry).
+     */
+    const xap::audioio::AudioFileIndexEntry *find_time(int64_t time)
+        const noexcept;
+
+    /**
+     *  Locate a position.
+     * 
+     *  @param frame
+     *      The position (in file frames, clamped to the length).
+     *  @return
+     *      The offset of the frame (in bytes from the beginning of the file).
+     */
+    uint64_t locate(uint64_t frame) const noexcept;
+
+    /**
+     *  Get the trim map entries (ordered by position, empty if no silence 
+     *  was trimmed).
+     * 
+     *  @return
+     *      The entries.
+     */
+    const xap::audioio::AudioFileTrimEntries &get_trims() const noexcept;
+
+    /**
+     *  Translate a position of the file to the original recording.
+     * 
+     *  @param frame
+     *      The position (in file frames).
+     *  @return
+     *      The position (in frames of the original recording).
+     */
+    uint64_t get_source_frame(uint64_t frame) const noexcept;
+
+    /**
+     *  Translate a position of the original recording to the file (a 
+     *  trimmed position is translated to the frame at which the recording 
+     *  resumed).
+     * 
+     *  @param source_frame
+     *      The position (in frames of the original recording).
+     *  @return
+     *      The position (in file frames).
+     */
+    uint64_t get_file_frame(uint64_t source_frame) const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    AudioFileIndex(const AudioFileIndex &) = delete;
+    AudioFileIndex &operator=(const AudioFileIndex &) = delete;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFileInfo            m_info;
+    uint32_t                               m_granularity;
+    uint8_t                                __pad1[4];
+    xap::audioio::AudioFileIndexEntries    m_entries;
+    xap::audioio::AudioFileTrimEntries     m_trims;
+};
+
+//
+//  Public functions.
+//
+
+/**
+ *  Parse the header of an audio file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file cannot be opened or read (xap::audioio::ERROR_IO) 
+ *      or is malformed or not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param path
+ *      The path of the file.
+ *  @return
+ *      The information.
+ */
+xap::audioio::AudioFileInfo audiofile_probe(const char *path);
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_AUDIOFILE_H__
@@ -0,0 +1,274 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_AUDIOFILEWRITER_H__
+#define XAP_AUDIOIO_AUDIOFILEWRITER_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/audiofile.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+template<class T> class MpscQueue;
+
+//
+//  Structures.
+//
+
+/**
+ *  Audio file writer options.
+ */
+typedef struct AudioFileWriterOptions_ {
+    //  Count of frames buffered for the writer thread (frames which do not 
+    //  fit are dropped, see AudioFileWriter::get_dropped_frame_count()).
+    size_t    buffer_frames = 65536U;
+
+    //  Interval of the seek index entries (in milliseconds, 0 to write no 
+    //  index).
+    uint32_t  index_interval = 1000U;
+
+    //  Trim silent spans (periods whose energy is below the threshold are 
+    //  not written once the span lasted longer than the hangover, a trim 
+    //  map of the original timeline is written with the seek index, so the 
+    //  index must not be disabled).
+    bool      trim_silence = false;
+
+    //  Silence threshold (in dBFS, of the mean energy of a period).
+    float     silence_threshold = -60.0F;
+
+    //  Silence kept at the beginning of each silent span (in milliseconds, 
+    //  0 to skip silent spans entirely).
+    uint32_t  silence_hangover = 250U;
+} AudioFileWriterOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Recorder file sink (writes WAV files, RF64 beyond 4GB).
+ * 
+ *  The stage appends each period to the file and passes the audio data on 
+ *  unchanged. 16-bit, 32-bit, 32-bit float and G.711 (see G711Encoder) 
+ *  audio data is written as it is. On the audio thread the period is only 
+ *  copied to a ring buffer, a process-wide writer thread writes the ring 
+ *  buffers of all writers to their files, so process() never blocks on 
+ *  I/O.
+ * 
+ *  A seek index is embedded in the file (an 'xidx' chunk after the audio 
+ *  data, see AudioFileIndex). It maps positions and the wall-clock times at 
+ *  which they were recorded to byte offsets at a fixed interval.
+ * 
+ *  If silence is trimmed (see AudioFileWriterOptions::trim_silence), each 
+ *  period is tested with a vectorized energy sum (which stops as soon as 
+ *  the period turns out to be loud) and the silent periods beyond the 
+ *  hangover are not written. Each position at which the recording resumed 
+ *  is mapped to its position in the original recording (an 'xtrm' chunk 
+ *  after the seek index, see AudioFileIndex::get_source_frame()). Frames 
+ *  dropped because the writer thread fell behind are mapped the same way.
+ * 
+ *  @extends IStage
+ */
+class AudioFileWriter: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object (create the file and write the header).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format or the options are invalid.
+     * 
+     *          - xap::audioio::ERROR_IO:
+     *              The file cannot be created or written.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              The writer thread cannot be started.
+     * 
+     *  @param path
+     *      The path of the file (replaced if it exists).
+     *  @param format
+     *      The audio format (16-bit, 32-bit, 32-bit float or G.711).
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    AudioFileWriter(
+        const char                                   *path,
+        const xap::audioio::AudioFormat              &format,
+        const xap::audioio::AudioFileWriterOptions   &options = 
+            xap::audioio::AudioFileWriterOptions(),
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object (close the file, errors are ignored).
+     */
+    virtual ~AudioFileWriter() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Append audio data (on the audio thread, never blocks on I/O).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio data mismatched.
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The file was closed.
+     * 
+     *          - xap::audioio::ERROR_IO:
+     *              The writer thread failed to write the file.
+     * 
+     *  @param data
+     *      The audio data (unchanged).
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Close the file (write the remaining audio data, the index and the 
+     *  sizes). The stage must not be processing meanwhile (e.g. stop the 
+     *  recorder first).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the file cannot be written (xap::audioio::ERROR_IO).
+     */
+    void close();
+
+    /**
+     *  Get the count of frames appended.
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    uint64_t get_frame_count() const noexcept;
+
+    /**
+     *  Get the count of frames dropped (the writer thread fell behind).
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    uint64_t get_dropped_frame_count() const noexcept;
+
+    /**
+     *  Get the count of silent frames trimmed.
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    uint64_t get_trimmed_frame_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    AudioFileWriter(const AudioFileWriter &) = delete;
+    AudioFileWriter &operator=(const AudioFileWriter &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Test whether a period is silent.
+     * 
+     *  @param data
+     *      The audio data.
+     *  @return
+     *      True if the energy of the period is below the threshold.
+     */
+    bool is_silent(const xap::audioio::AudioBuffer &data) const noexcept;
+
+    /**
+     *  Write the buffered audio data and collect the index entries (on the 
+     *  writer thread).
+     */
+    void flush() noexcept;
+
+    /**
+     *  Write the index and the sizes.
+     * 
+     *  @return
+     *      True if succeed.
+     */
+    bool finalize() noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat                          m_format;
+    xap::audioio::AudioFileWriterOptions               m_options;
+    FILE                                              *m_file;
+    uint8_t                                           *m_ring;
+    size_t                                             m_capacity;
+    size_t                                             m_frame_size;
+    uint64_t                                           m_granularity;
+    uint64_t                                           m_hangover;
+    float                                              m_silence_energy;
+    uint8_t                                            __pad1[4];
+
+    //  Shared by the audio thread and the writer thread.
+    std::atomic<uint64_t>                              m_head;
+    std::atomic<uint64_t>                              m_tail;
+    std::atomic<uint64_t>                              m_dropped_count;
+    std::atomic<uint64_t>                              m_trimmed_count;
+    std::atomic<bool>                                  m_has_error;
+    std::atomic<bool>                                  m_is_closed;
+    uint8_t                                            __pad2[6];
+    xap::audioio::MpscQueue<xap::audioio::AudioFileIndexEntry>
+                                                      *m_pending_entries;
+    xap::audioio::MpscQueue<xap::audioio::AudioFileTrimEntry>
+                                                      *m_pending_trims;
+
+    //  Audio thread state.
+    uint64_t                                           m_source_count;
+    uint64_t                                           m_silent_count;
+    uint64_t                                           m_trim_offset;
+    xap::audioio::AudioFileTrimEntry                   m_trim;
+    bool                                               m_has_trim;
+    uint8_t                                            __pad3[7];
+
+    //  Writer thread state.
+    uint64_t                                           m_written_count;
+    xap::audioio::AudioFileIndexEntries                m_entries;
+    xap::audioio::AudioFileTrimEntries                 m_trims;
+
+    friend class AudioFileFlusher;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_AUDIOFILEWRITER_H__
@@ -0,0 +1,297 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_BEAMFORMER_H__
+#define XAP_AUDIOIO_BEAMFORMER_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/microphonearray.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Beamforming methods.
+typedef uint8_t BeamformerMethod;
+const static xap::audioio::BeamformerMethod BEAMFORMER_DELAYANDSUM = 0U;
+const static xap::audioio::BeamformerMethod BEAMFORMER_MVDR = 1U;
+
+//
+//  Structures.
+//
+typedef struct BeamformerOptions_ {
+    xap::audioio::BeamformerMethod  method = xap::audioio::BEAMFORMER_MVDR;
+    uint8_t                         __pad1[3];
+
+    //  Look direction (in degrees, see MicrophonePosition).
+    float                           azimuth = 0.0F;
+    float                           elevation = 0.0F;
+
+    //  MVDR: size of the STFT frames (a power of 2, the hop is half of it),
+    //  time constant of the covariance estimates and interval of the weight
+    //  updates (in milliseconds), diagonal loading (relative to the mean
+    //  power of the microphones).
+    uint32_t                        fft_size = 512U;
+    uint32_t                        covariance_time = 500U;
+    uint32_t                        update_interval = 100U;
+    float                           diagonal_loading = 0.01F;
+    uint8_t                         __pad2[4];
+
+    //  Maximum count of frames of each call of process().
+    size_t                          max_frames = 4096U;
+} BeamformerOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Beamformer stage: combines the channels of a microphone array into one
+ *  enhanced channel focused on the look direction.
+ *
+ *  Two methods are available:
+ *
+ *      - BEAMFORMER_DELAYANDSUM:
+ *          The channels are aligned with fractional delays (windowed-sinc
+ *          interpolators) and averaged.
+ *
+ *      - BEAMFORMER_MVDR:
+ *          Minimum variance distortionless response in the STFT domain: the
+ *          spatial covariance of each bin is tracked on the audio thread
+ *          and the weights are recomputed periodically from a snapshot of
+ *          it on a worker thread.
+ *
+ *  New weights (after a covariance update or set_direction()) are computed
+ *  on the worker thread and swapped in lock-free (triple buffering), the
+ *  audio thread never blocks or allocates.
+ *
+ *  @extends IStage
+ */
+class Beamformer: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     *
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     *
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The array mismatched the input format or the options are
+     *              invalid.
+     *
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The input format is neither 16-bit nor 32-bit float.
+     *
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     *
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              The worker thread could not be started.
+     *
+     *  @param input_format
+     *      The input audio format (one channel per microphone).
+     *  @param array
+     *      The geometry of the microphone array.
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    Beamformer(
+        const xap::audioio::AudioFormat        &input_format,
+        const xap::audioio::MicrophoneArray    &array,
+        const xap::audioio::BeamformerOptions  &options,
+        xap::audioio::IAllocator               *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object (stop the worker thread).
+     */
+    virtual ~Beamformer() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Process audio data (replaced by the mono output).
+     *
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     *
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio data mismatched.
+     *
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              Too many frames (more than options.max_frames).
+     *
+     *          - xap::audioio::ERROR_ALLOC:
+     *              No output block is available.
+     *
+     *  @param data
+     *      The audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Set the look direction (thread-safe, applied asynchronously by the
+     *  worker thread).
+     *
+     *  @param azimuth
+     *      The azimuth (in degrees).
+     *  @param elevation
+     *      The elevation (in degrees).
+     */
+    void set_direction(float azimuth, float elevation) noexcept;
+
+    /**
+     *  Get the output audio format.
+     *
+     *  @return
+     *      The audio format.
+     */
+    xap::audioio::AudioFormat get_output_format() const noexcept;
+
+    /**
+     *  Get the delay of the output (in frames, the largest one for
+     *  BEAMFORMER_DELAYANDSUM).
+     *
+     *  @return
+     *      The delay.
+     */
+    size_t get_latency() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    Beamformer(const Beamformer &) = delete;
+    Beamformer &operator=(const Beamformer &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Delay, filter and sum a pass of deinterleaved frames.
+     *
+     *  @param count
+     *      The count of frames.
+     *  @param output
+     *      The output.
+     */
+    void process_delay_and_sum(size_t count, float *output) noexcept;
+
+    /**
+     *  Process one STFT hop (the input frames are in the analysis buffers),
+     *  appending 'hop' frames to the output queue.
+     */
+    void process_hop() noexcept;
+
+    /**
+     *  Swap in the latest weights published by the worker thread (if any).
+     */
+    void acquire_weights() noexcept;
+
+    /**
+     *  Compute weights (worker thread).
+     *
+     *  @param weights
+     *      The index of the weight set to write.
+     *  @param azimuth
+     *      The azimuth (in degrees).
+     *  @param elevation
+     *      The elevation (in degrees).
+     */
+    void compute_weights(
+        size_t  weights,
+        float   azimuth,
+        float   elevation
+    ) noexcept;
+
+    /**
+     *  Run the worker thread.
+     */
+    void run_worker() noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat               m_input_format;
+    xap::audioio::AudioFormat               m_output_format;
+    xap::audioio::MicrophoneArray           m_array;
+    xap::audioio::BeamformerOptions         m_options;
+    size_t                                  m_channel_count;
+
+    //  Delay-and-sum.
+    size_t                                  m_max_delay;
+    size_t                                  m_history;
+    size_t                                  m_line_length;
+    xap::audioio::AudioBuffer               m_lines;
+
+    //  MVDR (STFT).
+    class Fft                              *m_fft;
+    size_t                                  m_hop;
+    size_t                                  m_bin_count;
+    size_t                                  m_bin_stride;
+    size_t                                  m_pair_count;
+    size_t                                  m_fill;
+    size_t                                  m_update_hops;
+    size_t                                  m_hops;
+    float                                   m_smoothing;
+    uint8_t                                 __pad1[4];
+    xap::audioio::AudioBuffer               m_window;
+    xap::audioio::AudioBuffer               m_frames;
+    xap::audioio::AudioBuffer               m_spectra;
+    xap::audioio::AudioBuffer               m_covariance;
+    xap::audioio::AudioBuffer               m_overlap;
+    xap::audioio::AudioBuffer               m_queue;
+    size_t                                  m_queue_count;
+
+    //  Weights (3 sets: front, exchanged and back).
+    size_t                                  m_weight_size;
+    xap::audioio::AudioBuffer               m_weights;
+    size_t                                  m_front;
+    std::atomic<uint32_t>                   m_exchange;
+
+    //  Worker thread.
+    xap::audioio::AudioBuffer               m_snapshot;
+    xap::audioio::AudioBuffer               m_worker_covariance;
+    std::atomic<uint32_t>                   m_snapshot_state;
+    std::atomic<uint32_t>                   m_direction_version;
+    std::atomic<float>                      m_azimuth;
+    std::atomic<float>                      m_elevation;
+    std::atomic<bool>                       m_is_stopping;
+    std::mutex                              m_wakeup_lock;
+    std::condition_variable                 m_wakeup;
+    std::thread                             m_worker;
+
+    xap::audioio::AudioBuffer               m_scratch;
+    xap::audioio::AudioBufferPool           m_pool;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_BEAMFORMER_H__
@@ -0,0 +1,451 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_BINAURAL_H__
+#define XAP_AUDIOIO_BINAURAL_H__
+
+//
+//  Imports.
+//
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+template<class T> class MpscQueue;
+struct BinauralVoice_;
+struct BinauralCommand_;
+
+//
+//  Constants.
+//
+
+//  Default count of frames of the FFT partitions.
+const static size_t BINAURAL_DEFAULT_BLOCK_FRAMES = 128U;
+
+//  Count of measurement points interpolated for a direction.
+const static size_t BINAURAL_INTERPOLATION_POINTS = 3U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Direction of a sound (as seen from the listener).
+ * 
+ *  Azimuth is in degrees (0 in front, 90 to the left, -90 to the right), 
+ *  elevation is in degrees (0 in the horizontal plane, 90 above).
+ */
+typedef struct BinauralDirection_ {
+    float azimuth = 0.0F;
+    float elevation = 0.0F;
+} BinauralDirection;
+
+/**
+ *  Binaural mixer options.
+ */
+typedef struct BinauralMixerOptions_ {
+    //  Maximum count of voices.
+    size_t max_voices = 32U;
+} BinauralMixerOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Set of head-related impulse responses (HRIR).
+ * 
+ *  Holds the HRIR pair (left and right ear) measured at each of a set of 
+ *  directions, transformed once to the spectra of FFT partitions of 
+ *  'block_frames' frames. The set is immutable after construction, so one 
+ *  set (held by std::shared_ptr) is shared by all voices of all mixers.
+ */
+class HrirSet {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              A count is 0, the sample rate is 0 or the block size is 
+     *              not a power of 2 (or < 16).
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param directions
+     *      The direction of each measurement point.
+     *  @param point_count
+     *      The count of measurement points.
+     *  @param left
+     *      The impulse responses of the left ear ('tap_count' taps of each 
+     *      point, one after another).
+     *  @param right
+     *      The impulse responses of the right ear (the same layout).
+     *  @param tap_count
+     *      The count of taps of each impulse response.
+     *  @param sample_rate
+     *      The sample rate of the impulse responses.
+     *  @param block_frames
+     *      The count of frames of the FFT partitions (a power of 2, the 
+     *      block size of the mixers).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    HrirSet(
+        const xap::audioio::BinauralDirection  *directions,
+        size_t                                  point_count,
+        const float                            *left,
+        const float                            *right,
+        size_t                                  tap_count,
+        uint32_t                                sample_rate,
+        size_t                                  block_frames = 
+            xap::audioio::BINAURAL_DEFAULT_BLOCK_FRAMES,
+        xap::audioio::IAllocator               *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~HrirSet() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get the count of measurement points.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_point_count() const noexcept;
+
+    /**
+     *  Get the count of taps of each impulse response.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_tap_count() const noexcept;
+
+    /**
+     *  Get the sample rate.
+     * 
+     *  @return
+     *      The sample rate.
+     */
+    uint32_t get_sample_rate() const noexcept;
+
+    /**
+     *  Get the count of frames of the FFT partitions.
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    size_t get_block_frames() const noexcept;
+
+    /**
+     *  Get the count of FFT partitions of each impulse response.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_partition_count() const noexcept;
+
+    /**
+     *  Find the measurement points interpolated for a direction.
+     * 
+     *  The nearest points (by the angle between the directions) are 
+     *  weighted by their inverse squared angular distance, a direction on a 
+     *  measurement point gets the HRIR of that point only.
+     * 
+     *  @param direction
+     *      The direction.
+     *  @param points
+     *      The indices of the points (output, BINAURAL_INTERPOLATION_POINTS 
+     *      entries).
+     *  @param weights
+     *      The weights of the points (output, summing up to 1, 0 for unused 
+     *      entries).
+     */
+    void interpolate(
+        const xap::audioio::BinauralDirection  &direction,
+        size_t                                 *points,
+        float                                  *weights
+    ) const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    HrirSet(const HrirSet &) = delete;
+    HrirSet &operator=(const HrirSet &) = delete;
+
+    //
+    //  Members.
+    //
+    size_t                      m_point_count;
+    size_t                      m_tap_count;
+    uint32_t                    m_sample_rate;
+    uint8_t                     __pad1[4];
+    size_t                      m_block;
+    size_t                      m_bin_stride;
+    size_t                      m_partition_count;
+    xap::audioio::AudioBuffer   m_vectors;
+    xap::audioio::AudioBuffer   m_spectra;
+
+    //
+    //  Friend classes.
+    //
+    friend class BinauralMixer;
+};
+
+/**
+ *  Binaural mixer.
+ * 
+ *  Mixes mono voices (e.g. the participants of a conference) to a stereo 
+ *  output, each voice spatialized at its own direction by the HRIR pair 
+ *  interpolated from the nearest measurement points of a shared HrirSet.
+ * 
+ *  The impulse responses are applied by uniformly partitioned overlap-save 
+ *  convolution: each voice transforms one block of its audio data per 
+ *  period, the products of all voices are summed in the frequency domain, 
+ *  so the mixer transforms back only once per ear. When a voice moves, its 
+ *  HRIR pair is interpolated again and the output of the old and the new 
+ *  pair is cross-faded over one block.
+ * 
+ *  Voices are added, moved and removed from any thread without blocking 
+ *  the audio thread (read()), changes take effect at the next block.
+ * 
+ *  @extends ISource
+ */
+class BinauralMixer: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The HRIR set is nullptr or the options are invalid.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The output format is not stereo 32-bit float at the sample 
+     *              rate of the HRIR set.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param hrirs
+     *      The HRIR set.
+     *  @param output_format
+     *      The output audio format.
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    BinauralMixer(
+        const std::shared_ptr<const xap::audioio::HrirSet>  &hrirs,
+        const xap::audioio::AudioFormat                     &output_format,
+        const xap::audioio::BinauralMixerOptions            &options = 
+            xap::audioio::BinauralMixerOptions(),
+        xap::audioio::IAllocator                            *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~BinauralMixer() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data (the mix of all voices).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED) or a voice failed.
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (always all frames, missing audio data 
+     *      of the voices is silent).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Add a voice (thread-safe).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The source is nullptr.
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The maximum count of voices was reached.
+     * 
+     *  @param source
+     *      The source of the voice (mono 32-bit float audio data at the 
+     *      sample rate of the output).
+     *  @param direction
+     *      The initial direction.
+     *  @return
+     *      The identifier of the voice.
+     */
+    size_t add_voice(
+        const std::shared_ptr<xap::audioio::ISource>  &source,
+        const xap::audioio::BinauralDirection         &direction = 
+            xap::audioio::BinauralDirection()
+    );
+
+    /**
+     *  Remove a voice (thread-safe, the source is released once the audio 
+     *  thread dropped the voice).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the voice does not exist 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param voice
+     *      The identifier of the voice.
+     */
+    void remove_voice(size_t voice);
+
+    /**
+     *  Move a voice (thread-safe, lock-free on the audio thread).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the voice does not exist 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param voice
+     *      The identifier of the voice.
+     *  @param direction
+     *      The direction.
+     */
+    void set_direction(
+        size_t                                    voice,
+        const xap::audioio::BinauralDirection    &direction
+    );
+
+    /**
+     *  Get the count of voices (thread-safe, including voices being 
+     *  removed).
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_voice_count();
+
+private:
+    //
+    //  Constructors.
+    //
+    BinauralMixer(const BinauralMixer &) = delete;
+    BinauralMixer &operator=(const BinauralMixer &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Apply the pending commands (audio thread).
+     */
+    void apply_commands() noexcept;
+
+    /**
+     *  Render one block of all voices.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if a voice failed.
+     */
+    void render_block();
+
+    /**
+     *  Interpolate the HRIR pair of a voice (to its other filter slot).
+     * 
+     *  @param voice
+     *      The voice.
+     *  @param direction
+     *      The direction.
+     */
+    void update_filters(
+        struct xap::audioio::BinauralVoice_       &voice,
+        const xap::audioio::BinauralDirection     &direction
+    ) noexcept;
+
+    /**
+     *  Release the voices retired by the audio thread (the voice lock must 
+     *  be held).
+     */
+    void release_retired() noexcept;
+
+    /**
+     *  Find the slot of a voice (the voice lock must be held).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the voice does not exist 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param voice
+     *      The identifier of the voice.
+     *  @return
+     *      The slot.
+     */
+    size_t find_voice(size_t voice);
+
+    //
+    //  Members.
+    //
+    std::shared_ptr<const xap::audioio::HrirSet>   m_hrirs;
+    xap::audioio::AudioFormat                      m_format;
+    xap::audioio::IAllocator                      *m_allocator;
+    size_t                                         m_max_voices;
+    size_t                                         m_block;
+    size_t                                         m_bin_stride;
+    size_t                                         m_partition_count;
+    class Fft                                     *m_fft;
+    struct xap::audioio::BinauralVoice_           *m_voices;
+    std::mutex                                     m_voice_lock;
+    size_t                                         m_voice_count;
+    size_t                                         m_next_id;
+    xap::audioio::MpscQueue<struct xap::audioio::BinauralCommand_>
+                                                  *m_commands;
+    xap::audioio::MpscQueue<size_t>               *m_retired;
+    xap::audioio::AudioBuffer                      m_spectra;
+    xap::audioio::AudioBuffer                      m_time;
+    xap::audioio::AudioBuffer                      m_rendered;
+    size_t                                         m_rendered_offset;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_BINAURAL_H__
@@ -0,0 +1,211 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_DCBLOCKER_H__
+#define XAP_AUDIOIO_DCBLOCKER_H__
+
+//
+//  Imports.
+//
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Structures.
+//
+
+/**
+ *  DC blocker options.
+ */
+typedef struct DcBlockerOptions_ {
+    //  Cutoff frequency of the high-pass filter (in Hz, -3dB).
+    double  cutoff = 20.0;
+} DcBlockerOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  DC blocker stage (for recorders).
+ * 
+ *  Removes the DC offset of each channel with a first order high-pass 
+ *  filter (y[n] = x[n] - x[n - 1] + R * y[n - 1]). The following 
+ *  conversions are supported:
+ * 
+ *      - 16-bit to 32-bit float:
+ *          The samples are converted and filtered in the same pass. Each 
+ *          call replaces the audio data with an audio buffer taken from a 
+ *          pool of the stage.
+ * 
+ *      - 16-bit to 16-bit:
+ *          The samples are filtered in place in fixed point (the rounding 
+ *          error is fed back, so no DC offset is left by the rounding).
+ * 
+ *      - 32-bit float to 32-bit float:
+ *          The samples are filtered in place.
+ * 
+ *  @extends IStage
+ */
+class DcBlocker: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The input format is invalid, max_frames == 0 or the 
+     *              cutoff frequency is not between 0 and the Nyquist 
+     *              frequency.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The conversion is not supported.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param input_format
+     *      The input audio format (the format of the recorder).
+     *  @param output_sample_format
+     *      The output sample format.
+     *  @param max_frames
+     *      The maximum count of frames of each call (the frames per buffer 
+     *      of the recorder, or RECORDER_DEFAULT_BLOCK_FRAMES).
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    DcBlocker(
+        const xap::audioio::AudioFormat        &input_format,
+        xap::audioio::SampleFormat              output_sample_format,
+        size_t                                  max_frames,
+        const xap::audioio::DcBlockerOptions   &options = 
+            xap::audioio::DcBlockerOptions(),
+        xap::audioio::IAllocator               *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~DcBlocker() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Filter audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio data mismatched.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The audio data has more than 'max_frames' frames.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              No pooled audio buffer is available.
+     * 
+     *  @param data
+     *      The audio data (filtered in place, or replaced by the converted 
+     *      audio data).
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Reset the filter state.
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the output audio format.
+     * 
+     *  @return
+     *      The audio format.
+     */
+    const xap::audioio::AudioFormat &get_output_format() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    DcBlocker(const DcBlocker &) = delete;
+    DcBlocker &operator=(const DcBlocker &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Filter 16-bit samples to 32-bit float samples.
+     * 
+     *  @param input
+     *      The input samples.
+     *  @param output
+     *      The output samples.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void filter_int16_float(
+        const int16_t  *input,
+        float          *output,
+        size_t          frame_count
+    ) noexcept;
+
+    /**
+     *  Filter 16-bit samples in place (in fixed point).
+     * 
+     *  @param samples
+     *      The samples.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void filter_int16(int16_t *samples, size_t frame_count) noexcept;
+
+    /**
+     *  Filter 32-bit float samples in place.
+     * 
+     *  @param samples
+     *      The samples.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void filter_float(float *samples, size_t frame_count) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat      m_input_format;
+    xap::audioio::AudioFormat      m_output_format;
+    size_t                         m_max_frames;
+    float                          m_coefficient;
+    uint8_t                        __pad1[4];
+    int64_t                        m_fixed_coefficient;
+    xap::audioio::AudioBuffer      m_states;
+    xap::audioio::AudioBuffer      m_fixed_states;
+    xap::audioio::AudioBufferPool  m_pool;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_DCBLOCKER_H__
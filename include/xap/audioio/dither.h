@@ -0,0 +1,266 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_DITHER_H__
+#define XAP_AUDIOIO_DITHER_H__
+
+//
+//  Imports.
+//
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Types.
+//
+
+//  Noise shaping filter.
+typedef uint8_t NoiseShaping;
+
+//
+//  Constants.
+//
+
+//  Noise shaping filters (the error is fed back through 1 - H(z), first 
+//  order: (1 - z^-1), second order: (1 - z^-1)^2).
+const static NoiseShaping NOISESHAPING_NONE = 0U;
+const static NoiseShaping NOISESHAPING_FIRST_ORDER = 1U;
+const static NoiseShaping NOISESHAPING_SECOND_ORDER = 2U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Dither options.
+ */
+typedef struct DitherOptions_ {
+    //  Noise shaping filter.
+    xap::audioio::NoiseShaping  noise_shaping = NOISESHAPING_NONE;
+
+    //  Reserved.
+    uint8_t                     __pad1[3];
+
+    //  Seed of the noise generator (0 for a random seed, any other value 
+    //  makes the output deterministic).
+    uint32_t                    seed = 0U;
+} DitherOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Requantizer (32-bit float to 16-bit with TPDF dither).
+ * 
+ *  Triangular dither of +/-1 LSB (the difference of two uniform random 
+ *  values) is added before rounding, so the quantization error is 
+ *  independent of the signal instead of being audible distortion at low 
+ *  levels. The noise is generated by xorshift generators running in SIMD 
+ *  lanes, blocks of noise are generated ahead of the conversion. Noise 
+ *  shaping optionally moves the error towards high frequencies.
+ */
+class Dither {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The count of channels is 0 or the noise shaping filter is 
+     *              invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param channel_count
+     *      The count of channels.
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    explicit Dither(
+        uint8_t                               channel_count,
+        const xap::audioio::DitherOptions    &options = 
+            xap::audioio::DitherOptions(),
+        xap::audioio::IAllocator             *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~Dither() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Requantize audio data (interleaved, full scale is [-1, 1)).
+     * 
+     *  @param input
+     *      The samples (32-bit float).
+     *  @param output
+     *      The samples (16-bit, saturated).
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void requantize(
+        const float  *input,
+        int16_t      *output,
+        size_t        frame_count
+    ) noexcept;
+
+    /**
+     *  Reset (clear the noise shaping state and restart the noise from the 
+     *  seed).
+     */
+    void reset() noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    Dither(const Dither &) = delete;
+    Dither &operator=(const Dither &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Generate TPDF noise.
+     * 
+     *  @param noise
+     *      The noise (in LSB, output).
+     *  @param count
+     *      The count of samples (a multiple of 4).
+     */
+    void generate(float *noise, size_t count) noexcept;
+
+    //
+    //  Members.
+    //
+    size_t                        m_channel_count;
+    xap::audioio::NoiseShaping    m_noise_shaping;
+    uint8_t                       __pad1[3];
+    uint32_t                      m_seed;
+    uint32_t                      m_states[8];
+    xap::audioio::AudioBuffer     m_errors;
+};
+
+/**
+ *  Dither source (for 16-bit players).
+ * 
+ *  Reads 32-bit float audio data from an upstream source (e.g. a mixer) 
+ *  and requantizes it to 16-bit with TPDF dither (see Dither), as the final 
+ *  conversion stage of the player.
+ * 
+ *  @extends ISource
+ */
+class DitherSource: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The upstream source is nullptr, the output format or the 
+     *              options are invalid.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The output format is not 16-bit.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param upstream
+     *      The upstream source (32-bit float audio data with the channel 
+     *      count and the sample rate of the output format).
+     *  @param output_format
+     *      The output audio format (the format of the player).
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    DitherSource(
+        const std::shared_ptr<xap::audioio::ISource> &upstream,
+        const xap::audioio::AudioFormat              &output_format,
+        const xap::audioio::DitherOptions            &options = 
+            xap::audioio::DitherOptions(),
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~DitherSource() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED) or the upstream source failed.
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (fewer than requested if the upstream 
+     *      source ran out of audio data).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Reset the dither state.
+     */
+    void reset() noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    DitherSource(const DitherSource &) = delete;
+    DitherSource &operator=(const DitherSource &) = delete;
+
+    //
+    //  Members.
+    //
+    std::shared_ptr<xap::audioio::ISource>  m_upstream;
+    xap::audioio::AudioFormat               m_output_format;
+    xap::audioio::AudioBuffer               m_input;
+    xap::audioio::Dither                    m_dither;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_DITHER_H__
@@ -0,0 +1,261 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_DOAESTIMATOR_H__
+#define XAP_AUDIOIO_DOAESTIMATOR_H__
+
+//
+//  Imports.
+//
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/microphonearray.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Structures.
+//
+
+/**
+ *  Direction-of-arrival estimator options.
+ */
+typedef struct DoaEstimatorOptions_ {
+    //  Size of the STFT frames (a power of 2, the hop is half of it).
+    uint32_t  fft_size = 512U;
+
+    //  Count of directions of the grid (evenly spaced azimuths, all at the 
+    //  same elevation, in degrees).
+    uint32_t  direction_count = 72U;
+    float     elevation = 0.0F;
+
+    //  Frequency band of the estimate (in Hz).
+    float     min_frequency = 300.0F;
+    float     max_frequency = 4000.0F;
+
+    //  Interval of the estimates (in milliseconds).
+    uint32_t  report_interval = 100U;
+
+    //  Frames with a lower mean level (in dBFS) are ignored.
+    float     min_level = -60.0F;
+    uint8_t   __pad1[4];
+} DoaEstimatorOptions;
+
+/**
+ *  Direction-of-arrival event.
+ */
+typedef struct DoaEvent_ {
+    //  The timestamp of the end of the interval (in frames).
+    int64_t   timestamp;
+
+    //  The azimuth (in degrees, [0, 360), see MicrophonePosition).
+    float     azimuth;
+
+    //  The confidence (the normalized steered response power of the 
+    //  direction, 0 if the interval was silent, up to 1 for one coherent 
+    //  source).
+    float     confidence;
+} DoaEvent;
+
+//
+//  Classes.
+//
+
+/**
+ *  Direction-of-arrival estimator (SRP-PHAT).
+ * 
+ *  Each channel is transformed once per hop, the phase-transformed cross 
+ *  spectra of all microphone pairs are accumulated over the interval, then 
+ *  turned into GCC-PHAT correlations (4x interpolated). The steered 
+ *  response power of each direction of the grid is the sum of the 
+ *  correlations at the pair delays of the direction, which are precomputed 
+ *  when the estimator is constructed.
+ * 
+ *  As a recorder stage, the audio data passes through unchanged, the 
+ *  estimate of each interval is published through the event callback.
+ * 
+ *  @extends IStage
+ */
+class DoaEstimator: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The array mismatched the input format, the options are 
+     *              invalid or the aperture of the array is too large for 
+     *              the size of the frames.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The input format is neither 16-bit nor 32-bit float.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param input_format
+     *      The input audio format (one channel per microphone).
+     *  @param array
+     *      The geometry of the microphone array.
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    DoaEstimator(
+        const xap::audioio::AudioFormat          &input_format,
+        const xap::audioio::MicrophoneArray      &array,
+        const xap::audioio::DoaEstimatorOptions  &options,
+        xap::audioio::IAllocator                 *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~DoaEstimator() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Estimate the direction of arrival of audio data (as a recorder 
+     *  stage, the audio data is not changed).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio data mismatched.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              The event callback occurred error.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *  @param data
+     *      The audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Set event callback (called on the thread calling process()).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error.
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    void set_event_callback(
+        std::function<void(const xap::audioio::DoaEvent &)> &callback
+    );
+
+    /**
+     *  Reset the state (the current interval is dropped).
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the count of directions of the grid.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_direction_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    DoaEstimator(const DoaEstimator &) = delete;
+    DoaEstimator &operator=(const DoaEstimator &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Process one STFT hop (the input frames are in the analysis buffers).
+     */
+    void process_hop() noexcept;
+
+    /**
+     *  Estimate the direction of the interval.
+     * 
+     *  @param event
+     *      The event (output).
+     */
+    void evaluate(xap::audioio::DoaEvent &event) noexcept;
+
+    /**
+     *  Emit event callback.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param event
+     *      The event.
+     */
+    void emit_event_callback(const xap::audioio::DoaEvent &event);
+
+    //
+    //  Members.
+    //
+    std::function<void(const xap::audioio::DoaEvent &)>  m_event_callback;
+    std::mutex                                           m_event_callback_lock;
+    xap::audioio::AudioFormat                            m_input_format;
+    xap::audioio::DoaEstimatorOptions                    m_options;
+    size_t                                               m_channel_count;
+    size_t                                               m_pair_count;
+    size_t                                               m_direction_count;
+    size_t                                               m_hop;
+    size_t                                               m_bin_stride;
+    size_t                                               m_min_bin;
+    size_t                                               m_max_bin;
+    size_t                                               m_lag_radius;
+    size_t                                               m_fill;
+    size_t                                               m_report_hops;
+    size_t                                               m_hops;
+    size_t                                               m_active_hops;
+    float                                                m_min_power;
+    uint8_t                                              __pad1[4];
+    class Fft                                           *m_fft;
+    class Fft                                           *m_correlation_fft;
+    xap::audioio::AudioBuffer                            m_window;
+    xap::audioio::AudioBuffer                            m_frames;
+    xap::audioio::AudioBuffer                            m_spectra;
+    xap::audioio::AudioBuffer                            m_cross;
+    xap::audioio::AudioBuffer                            m_lag_index;
+    xap::audioio::AudioBuffer                            m_lag_fraction;
+    xap::audioio::AudioBuffer                            m_response;
+    xap::audioio::AudioBuffer                            m_scratch;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_DOAESTIMATOR_H__
@@ -0,0 +1,268 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_DTMF_H__
+#define XAP_AUDIOIO_DTMF_H__
+
+//
+//  Imports.
+//
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Count of DTMF frequencies (4 rows, 4 columns).
+const static size_t DTMF_FREQUENCY_COUNT = 8U;
+
+//
+//  Structures.
+//
+
+/**
+ *  DTMF digit event.
+ */
+typedef struct DtmfEvent_ {
+    //  The timestamp of the start of the digit (in frames).
+    int64_t   timestamp;
+
+    //  The index of the stream (the channel for recorder stages).
+    uint32_t  stream;
+
+    //  The digit ('0' - '9', '*', '#', 'A' - 'D').
+    char      digit;
+    uint8_t   __pad1[3];
+} DtmfEvent;
+
+//
+//  Classes.
+//
+
+/**
+ *  DTMF detector.
+ * 
+ *  Detects DTMF digits in many streams at once: a bank of Goertzel filters 
+ *  is evaluated with one SIMD lane per stream, all state is allocated when 
+ *  the detector is constructed. A digit is reported once when both tones 
+ *  are present in two consecutive blocks (25.6ms each) and pass the level, 
+ *  twist, relative peak and energy ratio checks. It is released after one 
+ *  quiet block or two blocks without it, so the same digit pressed again 
+ *  after the minimum pause (40ms) is reported again.
+ * 
+ *  As a recorder stage, each channel is a stream and the audio data passes 
+ *  through unchanged.
+ * 
+ *  @extends IStage
+ */
+class DtmfDetector: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              stream_count == 0 or the sample rate is lower than 
+     *              4kHz.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param stream_count
+     *      The count of streams.
+     *  @param sample_rate
+     *      The sample rate of all streams.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    DtmfDetector(
+        size_t                     stream_count,
+        uint32_t                   sample_rate = 8000U,
+        xap::audioio::IAllocator  *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~DtmfDetector() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Detect digits in interleaved audio data (one sample per stream in each 
+     *  frame).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the event callback occurred error 
+     *      (xap::audioio::ERROR_CALLBACK, xap::audioio::ERROR_SYSTEMCALL).
+     *  @param samples
+     *      The samples.
+     *  @param frame_count
+     *      The count of frames.
+     *  @param timestamp
+     *      The timestamp of the first frame.
+     */
+    void process(
+        const int16_t *samples, 
+        size_t         frame_count, 
+        int64_t        timestamp
+    );
+
+    /**
+     *  Detect digits in separate audio data of each stream.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the event callback occurred error 
+     *      (xap::audioio::ERROR_CALLBACK, xap::audioio::ERROR_SYSTEMCALL).
+     *  @param streams
+     *      The samples of each stream (all streams have 'frame_count' 
+     *      samples).
+     *  @param frame_count
+     *      The count of frames.
+     *  @param timestamp
+     *      The timestamp of the first frame.
+     */
+    void process(
+        const int16_t *const *streams, 
+        size_t                frame_count, 
+        int64_t               timestamp
+    );
+
+    /**
+     *  Detect digits in audio data (as a recorder stage, the audio data is 
+     *  not changed).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The audio data is not 16-bit, or its channel count or 
+     *              sample rate mismatched.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              The event callback occurred error.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *  @param data
+     *      The audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Set event callback (called on the thread calling process()).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error. 
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    void set_event_callback(
+        std::function<void(const xap::audioio::DtmfEvent &)> &callback
+    );
+
+    /**
+     *  Reset the state of all streams.
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the count of streams.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_stream_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    DtmfDetector(const DtmfDetector &) = delete;
+    DtmfDetector &operator=(const DtmfDetector &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Run the filter bank over one frame (in m_column).
+     */
+    void step() noexcept;
+
+    /**
+     *  Evaluate the filter bank at the end of a block and report digits.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the event callback occurred error.
+     */
+    void evaluate();
+
+    /**
+     *  Emit event callback.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param event
+     *      The event.
+     */
+    void emit_event_callback(const xap::audioio::DtmfEvent &event);
+
+    //
+    //  Members.
+    //
+    std::function<void(const xap::audioio::DtmfEvent &)>  m_event_callback;
+    std::mutex                                            m_event_callback_lock;
+    size_t                                                m_stream_count;
+    size_t                                                m_lane_count;
+    uint32_t                                              m_sample_rate;
+    size_t                                                m_block_size;
+    size_t                                                m_block_offset;
+    int64_t                                               m_block_start;
+    int64_t                                               m_previous_start;
+    float                m_coefficients[xap::audioio::DTMF_FREQUENCY_COUNT];
+    float                                                *m_s1;
+    float                                                *m_s2;
+    float                                                *m_energy;
+    float                                                *m_column;
+    char                                                 *m_last_digit;
+    char                                                 *m_current_digit;
+    void                                                 *m_memory;
+    size_t                                                m_allocated_size;
+    xap::audioio::IAllocator                             *m_allocator;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_DTMF_H__
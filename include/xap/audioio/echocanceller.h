@@ -0,0 +1,274 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_ECHOCANCELLER_H__
+#define XAP_AUDIOIO_ECHOCANCELLER_H__
+
+//
+//  Imports.
+//
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/source.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Structures.
+//
+
+/**
+ *  Echo canceller options.
+ */
+typedef struct EchoCancellerOptions_ {
+    //  Count of frames of each block (a power of 2, the partitions of the 
+    //  adaptive filter have the same length).
+    uint32_t  block_frames = 128U;
+
+    //  Length of the adaptive filter (in milliseconds, the longest echo 
+    //  path which can be cancelled).
+    uint32_t  filter_length = 250U;
+
+    //  Maximum attenuation of the residual echo suppressor (in dB, 0 to 
+    //  disable it).
+    float     suppression = 40.0F;
+
+    //  Double-talk is declared when the error power exceeds the expected 
+    //  residual echo power by this ratio.
+    float     double_talk_threshold = 4.0F;
+
+    //  The far-end signal is active above this level (in dBFS).
+    float     far_end_level = -60.0F;
+    uint8_t   __pad1[4];
+
+    //  Maximum count of frames read from the far-end source at once (longer 
+    //  audio data is processed in pieces).
+    size_t    max_frames = 4096U;
+} EchoCancellerOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Acoustic echo canceller (mono).
+ * 
+ *  The echo of the far-end signal (the audio data played) is removed from 
+ *  the near-end signal (the audio data captured) by a partitioned-block 
+ *  frequency-domain adaptive filter (MDF, NLMS normalized by the far-end 
+ *  power of each bin). The step size of each bin is controlled by the 
+ *  estimated leakage of the echo into the error, and adaptation is frozen 
+ *  while double-talk is detected. A residual echo suppressor attenuates the 
+ *  echo left in the output.
+ * 
+ *  All state is allocated when the canceller is constructed. As a recorder 
+ *  stage, the near-end audio data is processed in place and the far-end 
+ *  audio data is read from the far-end source (e.g. a FrameQueue which the 
+ *  playback path pushes to), the same count of frames for each period.
+ *  The output is delayed by get_latency() frames.
+ * 
+ *  @extends IStage
+ */
+class EchoCanceller: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The options are invalid.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format is not mono 16-bit or 32-bit float.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param format
+     *      The audio format (of both the near-end and the far-end signal).
+     *  @param far_end
+     *      The far-end source (nullptr if only the frame-based process() 
+     *      is used).
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    EchoCanceller(
+        const xap::audioio::AudioFormat              &format,
+        std::shared_ptr<xap::audioio::ISource>        far_end,
+        const xap::audioio::EchoCancellerOptions     &options = 
+            xap::audioio::EchoCancellerOptions(),
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~EchoCanceller() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Cancel the echo of a near-end period (in place), the far-end audio 
+     *  data is read from the far-end source (missing frames are silent).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio data mismatched.
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              No far-end source.
+     * 
+     *          - Other errors raised by the far-end source.
+     * 
+     *  @param data
+     *      The near-end audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Cancel the echo of near-end frames (samples in the audio format of 
+     *  the canceller, output may be the near-end samples).
+     * 
+     *  @param near_end
+     *      The near-end samples.
+     *  @param far_end
+     *      The far-end samples (played at the same time).
+     *  @param output
+     *      The output samples.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void process(
+        const void  *near_end,
+        const void  *far_end,
+        void        *output,
+        size_t       frame_count
+    ) noexcept;
+
+    /**
+     *  Reset the adaptive filter and all state.
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the delay of the output (in frames).
+     * 
+     *  @return
+     *      The delay.
+     */
+    size_t get_latency() const noexcept;
+
+    /**
+     *  Get the echo return loss enhancement of the adaptive filter (in dB, 
+     *  averaged over the blocks with far-end activity).
+     * 
+     *  @return
+     *      The echo return loss enhancement.
+     */
+    float get_erle() const noexcept;
+
+    /**
+     *  Get whether double-talk is detected (in the last block).
+     * 
+     *  @return
+     *      True if so.
+     */
+    bool is_double_talk() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    EchoCanceller(const EchoCanceller &) = delete;
+    EchoCanceller &operator=(const EchoCanceller &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Process one block (in m_near_block and m_far_block), appending 
+     *  'block_frames' frames to the output queue.
+     */
+    void process_block() noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat                 m_format;
+    std::shared_ptr<xap::audioio::ISource>    m_far_end;
+    xap::audioio::EchoCancellerOptions        m_options;
+    size_t                                    m_block;
+    size_t                                    m_size;
+    size_t                                    m_bin_stride;
+    size_t                                    m_partition_count;
+    size_t                                    m_head;
+    size_t                                    m_constrained;
+    size_t                                    m_fill;
+    size_t                                    m_queue_count;
+    size_t                                    m_active_blocks;
+    size_t                                    m_double_talk_hangover;
+    float                                     m_min_power;
+    float                                     m_min_gain;
+    float                                     m_leak;
+    float                                     m_echo_error_covariance;
+    float                                     m_echo_variance;
+    float                                     m_near_average;
+    float                                     m_error_average;
+    bool                                      m_is_adapted;
+    bool                                      m_is_double_talk;
+    uint8_t                                   __pad1[2];
+    class Fft                                *m_fft;
+
+    //  Frequency domain (split complex, 'bin_stride' floats per part).
+    float                                    *m_filter;
+    float                                    *m_far_spectra;
+    float                                    *m_far_power;
+    float                                    *m_echo;
+    float                                    *m_error;
+    float                                    *m_error_window;
+    float                                    *m_echo_window;
+    float                                    *m_error_mean;
+    float                                    *m_echo_mean;
+    float                                    *m_error_power;
+    float                                    *m_residual_power;
+
+    //  Time domain.
+    float                                    *m_window;
+    float                                    *m_far_frame;
+    float                                    *m_error_frame;
+    float                                    *m_echo_frame;
+    float                                    *m_overlap;
+    float                                    *m_time;
+    float                                    *m_near_block;
+    float                                    *m_far_block;
+    float                                    *m_queue;
+    xap::audioio::AudioBuffer                 m_state;
+    xap::audioio::AudioBuffer                 m_far_buffer;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_ECHOCANCELLER_H__
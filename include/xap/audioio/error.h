@@ -30,6 +30,7 @@ const static uint16_t ERROR_INVALIDOPERATION = 5006U;
 const static uint16_t ERROR_UNEXPECTED       = 5007U;
 const static uint16_t ERROR_CALLBACK         = 5008U;
 const static uint16_t ERROR_NODEVICE         = 5008U;
+const static uint16_t ERROR_IO               = 5009U;
 
 //
 //  Classes.
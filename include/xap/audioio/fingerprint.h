@@ -0,0 +1,514 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_FINGERPRINT_H__
+#define XAP_AUDIOIO_FINGERPRINT_H__
+
+//
+//  Imports.
+//
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+struct FingerprintShard_;
+struct FingerprintStream_;
+
+//
+//  Constants.
+//
+
+//  Maximum count of spectral peaks picked in each hop.
+const static size_t FINGERPRINT_MAX_PEAKS = 8U;
+
+//  Maximum count of anchor peaks paired with each peak.
+const static size_t FINGERPRINT_MAX_FAN_OUT = 8U;
+
+//  Maximum distance (in hops) of an anchor peak.
+const static size_t FINGERPRINT_MAX_DELTA = 63U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Fingerprint (a pair of spectral peaks).
+ */
+typedef struct Fingerprint_ {
+    //  The hash (the frequency bins of both peaks and their distance).
+    uint32_t  hash;
+
+    //  The time of the anchor peak (in hops since the stream started).
+    uint32_t  time;
+} Fingerprint;
+
+/**
+ *  Posting of an indexed fingerprint.
+ */
+typedef struct FingerprintPosting_ {
+    //  The track.
+    uint32_t  track;
+
+    //  The time of the fingerprint in the track (in hops).
+    uint32_t  time;
+} FingerprintPosting;
+
+/**
+ *  Match of a captured stream with an indexed track.
+ */
+typedef struct FingerprintMatch_ {
+    //  The timestamp (in frames) at which the start of the track was (or 
+    //  would have been, if the capture started within the track) captured.
+    int64_t   timestamp;
+
+    //  The index of the stream (the channel for recorder stages).
+    uint32_t  stream;
+
+    //  The track.
+    uint32_t  track;
+
+    //  The count of fingerprints that matched at the same offset.
+    uint32_t  count;
+    uint8_t   __pad1[4];
+} FingerprintMatch;
+
+/**
+ *  Fingerprint extractor options.
+ * 
+ *  Fingerprints only match if the reference and the captured audio data 
+ *  were extracted at the same sample rate with the same options.
+ */
+typedef struct FingerprintOptions_ {
+    //  Size of the FFT frames (a power of 2, 64 - 2048).
+    size_t    fft_size = 512U;
+
+    //  Count of frames between FFT frames (1 - fft_size).
+    size_t    hop_frames = 128U;
+
+    //  Count of bands (and so the maximum count of peaks) of each hop 
+    //  (1 - FINGERPRINT_MAX_PEAKS).
+    size_t    peaks_per_hop = 4U;
+
+    //  Count of anchor peaks paired with each peak 
+    //  (1 - FINGERPRINT_MAX_FAN_OUT).
+    size_t    fan_out = 4U;
+
+    //  Maximum distance of an anchor peak (in hops, 1 - 
+    //  FINGERPRINT_MAX_DELTA).
+    size_t    max_delta = 16U;
+
+    //  Count of fingerprints that must match at the same offset to report a 
+    //  match (> 0).
+    uint32_t  min_matches = 20U;
+    uint8_t   __pad1[4];
+
+    //  Count of hops after which the matches of an offset expire 
+    //  (>= max_delta).
+    size_t    window_hops = 256U;
+} FingerprintOptions;
+
+/**
+ *  Fingerprint index options.
+ */
+typedef struct FingerprintIndexOptions_ {
+    //  Count of shards (each shard has its own write lock and a share of 
+    //  the capacity).
+    size_t  shard_count = 16U;
+
+    //  Maximum count of indexed fingerprints.
+    size_t  capacity = 1U << 20U;
+} FingerprintIndexOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  In-memory inverted index of fingerprints (hash to postings).
+ * 
+ *  The index is sharded by hash, each shard is a hash table of posting 
+ *  lists in memory allocated when the index is constructed. Adding takes 
+ *  the write lock of the shards only, lookups never lock: postings are 
+ *  only prepended and published with release semantics, so any count of 
+ *  threads can look up while fingerprints are added.
+ */
+class FingerprintIndex {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The count of shards or the capacity is invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    explicit FingerprintIndex(
+        const xap::audioio::FingerprintIndexOptions  &options = 
+            xap::audioio::FingerprintIndexOptions(),
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~FingerprintIndex() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Add the fingerprints of a track (thread-safe).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              A shard is full (the fingerprints added before remain).
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *  @param track
+     *      The track.
+     *  @param fingerprints
+     *      The fingerprints.
+     *  @param count
+     *      The count of fingerprints.
+     */
+    void add(
+        uint32_t                              track,
+        const xap::audioio::Fingerprint      *fingerprints,
+        size_t                                count
+    );
+
+    /**
+     *  Look up the postings of a hash (thread-safe, lock-free, the most 
+     *  recently added first).
+     * 
+     *  @param hash
+     *      The hash.
+     *  @param postings
+     *      The postings (output).
+     *  @param max_count
+     *      The maximum count of postings.
+     *  @return
+     *      The count of postings.
+     */
+    size_t find(
+        uint32_t                              hash,
+        xap::audioio::FingerprintPosting     *postings,
+        size_t                                max_count
+    ) const noexcept;
+
+    /**
+     *  Get the count of indexed fingerprints.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_size() const noexcept;
+
+    /**
+     *  Get the maximum count of indexed fingerprints.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_capacity() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    FingerprintIndex(const FingerprintIndex &) = delete;
+    FingerprintIndex &operator=(const FingerprintIndex &) = delete;
+
+    //
+    //  Members.
+    //
+    struct FingerprintShard_     *m_shards;
+    size_t                        m_shard_count;
+    size_t                        m_shard_capacity;
+};
+
+/**
+ *  Spectral-peak fingerprint extractor.
+ * 
+ *  Each hop, the newest FFT frame of each stream is split into bands and 
+ *  the strongest local maximum of each band is picked as a peak if it 
+ *  exceeds a decaying threshold of its bin (raised around each peak, so 
+ *  that sustained tones are picked at their onset only). Each peak is 
+ *  paired with the most recent earlier peaks (anchors) within 'max_delta' 
+ *  hops, each pair is a fingerprint. Extraction is incremental and all 
+ *  state is allocated when the extractor is constructed.
+ * 
+ *  With an index, the fingerprints of each stream are looked up as they 
+ *  are extracted and voted for by track and time offset, a match is 
+ *  reported once 'min_matches' fingerprints matched a track at the same 
+ *  offset (e.g. hold music or a recorded announcement was captured).
+ * 
+ *  As a recorder stage, each channel is a stream and the audio data passes 
+ *  through unchanged.
+ * 
+ *  @extends IStage
+ */
+class FingerprintExtractor: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              stream_count == 0, the sample rate is 0 or the options 
+     *              are invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param stream_count
+     *      The count of streams.
+     *  @param sample_rate
+     *      The sample rate of all streams.
+     *  @param options
+     *      The options.
+     *  @param index
+     *      The index to match against (nullptr to extract only).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    FingerprintExtractor(
+        size_t                                                stream_count,
+        uint32_t                                              sample_rate,
+        const xap::audioio::FingerprintOptions               &options = 
+            xap::audioio::FingerprintOptions(),
+        const std::shared_ptr<const xap::audioio::FingerprintIndex> &index = 
+            nullptr,
+        xap::audioio::IAllocator                             *allocator = 
+            nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~FingerprintExtractor() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Extract fingerprints from audio data (as a recorder stage, the audio 
+     *  data is not changed).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The audio data is not 16-bit or 32-bit float, or its 
+     *              channel count or sample rate mismatched.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              A callback occurred error.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *  @param data
+     *      The audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Set fingerprint callback (called on the thread calling process(), 
+     *  with the fingerprints of one stream extracted in one hop).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error.
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback (the stream, the fingerprints and their count).
+     */
+    void set_fingerprint_callback(
+        std::function<
+            void(uint32_t, const xap::audioio::Fingerprint *, size_t)
+        > &callback
+    );
+
+    /**
+     *  Set match callback (called on the thread calling process()).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error.
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    void set_match_callback(
+        std::function<void(const xap::audioio::FingerprintMatch &)> &callback
+    );
+
+    /**
+     *  Reset the state of all streams (the next audio data starts at hop 
+     *  0).
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the count of streams.
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_stream_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    FingerprintExtractor(const FingerprintExtractor &) = delete;
+    FingerprintExtractor &operator=(const FingerprintExtractor &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Analyze the newest FFT frame of a stream (at the end of a hop).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if a callback occurred error.
+     *  @param index
+     *      The index of the stream.
+     */
+    void analyze(size_t index);
+
+    /**
+     *  Vote for the tracks matching the fingerprints of a stream.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the match callback occurred error.
+     *  @param index
+     *      The index of the stream.
+     *  @param fingerprints
+     *      The fingerprints.
+     *  @param count
+     *      The count of fingerprints.
+     */
+    void vote(
+        size_t                                index,
+        const xap::audioio::Fingerprint      *fingerprints,
+        size_t                                count
+    );
+
+    /**
+     *  Emit fingerprint callback.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param stream
+     *      The stream.
+     *  @param fingerprints
+     *      The fingerprints.
+     *  @param count
+     *      The count of fingerprints.
+     */
+    void emit_fingerprint_callback(
+        uint32_t                              stream,
+        const xap::audioio::Fingerprint      *fingerprints,
+        size_t                                count
+    );
+
+    /**
+     *  Emit match callback.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param match
+     *      The match.
+     */
+    void emit_match_callback(const xap::audioio::FingerprintMatch &match);
+
+    //
+    //  Members.
+    //
+    std::function<
+        void(uint32_t, const xap::audioio::Fingerprint *, size_t)
+    >                                               m_fingerprint_callback;
+    std::mutex                                      m_fingerprint_callback_lock;
+    std::function<void(const xap::audioio::FingerprintMatch &)>
+                                                    m_match_callback;
+    std::mutex                                      m_match_callback_lock;
+    std::shared_ptr<const xap::audioio::FingerprintIndex>
+                                                    m_index;
+    size_t                                          m_stream_count;
+    uint32_t                                        m_sample_rate;
+    uint8_t                                         __pad1[4];
+    xap::audioio::FingerprintOptions                m_options;
+    size_t                                          m_band_edges[
+        xap::audioio::FINGERPRINT_MAX_PEAKS + 1U
+    ];
+    size_t                                          m_hop_offset;
+    int64_t                                         m_start;
+    bool                                            m_is_started;
+    uint8_t                                         __pad2[7];
+    class Fft                                      *m_fft;
+    struct xap::audioio::FingerprintStream_        *m_streams;
+    xap::audioio::AudioBuffer                       m_windows;
+    xap::audioio::AudioBuffer                       m_thresholds;
+    xap::audioio::AudioBuffer                       m_scratch;
+    xap::audioio::IAllocator                       *m_allocator;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_FINGERPRINT_H__
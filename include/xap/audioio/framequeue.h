@@ -0,0 +1,222 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_FRAMEQUEUE_H__
+#define XAP_AUDIOIO_FRAMEQUEUE_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+struct FrameQueueCell_;
+
+//
+//  Classes.
+//
+
+/**
+ *  Lock-free multi-producer, single-consumer frame queue.
+ * 
+ *  Any number of threads can push audio data, the player (the single 
+ *  consumer) reads it on the audio thread in batches. The queue is bounded: 
+ *  its capacity is 'slot_count' slots of up to 'slot_frames' frames each, a 
+ *  push which does not fit is rejected (back-pressure) instead of blocking 
+ *  the audio thread. The frames of one push are always played contiguously.
+ * 
+ *  @extends ISource
+ */
+class FrameQueue: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format is invalid, slot_frames == 0 or 
+     *              slot_count is not a power of 2.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param format
+     *      The audio format (must match the player).
+     *  @param slot_frames
+     *      The maximum count of frames of each slot.
+     *  @param slot_count
+     *      The count of slots (a power of 2).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    FrameQueue(
+        const xap::audioio::AudioFormat &format,
+        size_t                           slot_frames,
+        size_t                           slot_count,
+        xap::audioio::IAllocator        *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~FrameQueue() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Push audio data without waiting (thread-safe, lock-free).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the frames can never fit in the queue 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param data
+     *      The audio data (interleaved, in the format of the queue).
+     *  @param frame_count
+     *      The count of frames.
+     *  @return
+     *      True if pushed, false if the queue is full (back-pressure).
+     */
+    bool try_push(const void *data, size_t frame_count);
+
+    /**
+     *  Push an audio buffer without waiting (thread-safe, lock-free).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The frames can never fit in the queue.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio buffer mismatched.
+     * 
+     *  @param data
+     *      The audio buffer.
+     *  @return
+     *      True if pushed, false if the queue is full (back-pressure).
+     */
+    bool try_push(const xap::audioio::AudioBuffer &data);
+
+    /**
+     *  Push audio data, waiting for free slots (thread-safe).
+     * 
+     *  The producer backs off (yields, then sleeps) while the queue is full, 
+     *  the consumer is never blocked.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the frames can never fit in the queue 
+     *      (xap::audioio::ERROR_PARAMETER).
+     *  @param data
+     *      The audio data (interleaved, in the format of the queue).
+     *  @param frame_count
+     *      The count of frames.
+     *  @param timeout
+     *      The timeout (in milliseconds).
+     *  @return
+     *      True if pushed, false if timed out.
+     */
+    bool push(const void *data, size_t frame_count, uint32_t timeout);
+
+    /**
+     *  Read audio data (the consumer, on the audio thread).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read.
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Get the audio format.
+     * 
+     *  @return
+     *      The audio format.
+     */
+    const xap::audioio::AudioFormat &get_format() const noexcept;
+
+    /**
+     *  Get the capacity.
+     * 
+     *  @return
+     *      The maximum count of frames that can be queued.
+     */
+    size_t get_capacity() const noexcept;
+
+    /**
+     *  Get the count of slots in use (approximately, thread-safe).
+     * 
+     *  @return
+     *      The count.
+     */
+    size_t get_pending_slot_count() const noexcept;
+
+    /**
+     *  Get the count of rejected pushes (the queue was full).
+     * 
+     *  @return
+     *      The count.
+     */
+    uint64_t get_rejected_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    FrameQueue(const FrameQueue &) = delete;
+    FrameQueue &operator=(const FrameQueue &) = delete;
+
+    //
+    //  Members.
+    //
+
+    //  Shared by producers.
+    std::atomic<size_t>            m_enqueue_position;
+    std::atomic<uint64_t>          m_rejected_count;
+    uint8_t                        __pad1[48];
+
+    //  Owned by the consumer (the position is read by other threads).
+    std::atomic<size_t>            m_dequeue_position;
+    size_t                         m_read_offset;
+    uint8_t                        __pad2[48];
+
+    //  Read-only.
+    xap::audioio::AudioFormat      m_format;
+    size_t                         m_frame_size;
+    size_t                         m_slot_frames;
+    size_t                         m_slot_count;
+    size_t                         m_slot_size;
+    struct FrameQueueCell_        *m_cells;
+    uint8_t                       *m_storage;
+    size_t                         m_allocated_size;
+    xap::audioio::IAllocator      *m_allocator;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_FRAMEQUEUE_H__
@@ -0,0 +1,399 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_G711_H__
+#define XAP_AUDIOIO_G711_H__
+
+//
+//  Imports.
+//
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/source.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Sample rate of G.711 audio data.
+const static uint32_t G711_SAMPLE_RATE = 8000U;
+
+//
+//  Public functions.
+//
+
+/**
+ *  Encode 16-bit linear samples to G.711 u-law (the fastest path available, 
+ *  vectorized if supported).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The u-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_ulaw_encode(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept;
+
+/**
+ *  Encode 16-bit linear samples to G.711 u-law (lookup table path).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The u-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_ulaw_encode_table(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept;
+
+/**
+ *  Decode G.711 u-law samples to 16-bit linear samples.
+ * 
+ *  @param input
+ *      The u-law samples.
+ *  @param output
+ *      The linear samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_ulaw_decode(
+    const uint8_t *input, 
+    int16_t       *output, 
+    size_t         count
+) noexcept;
+
+/**
+ *  Encode 16-bit linear samples to G.711 A-law (the fastest path available, 
+ *  vectorized if supported).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The A-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_alaw_encode(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept;
+
+/**
+ *  Encode 16-bit linear samples to G.711 A-law (lookup table path).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The A-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_alaw_encode_table(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept;
+
+/**
+ *  Decode G.711 A-law samples to 16-bit linear samples.
+ * 
+ *  @param input
+ *      The A-law samples.
+ *  @param output
+ *      The linear samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_alaw_decode(
+    const uint8_t *input, 
+    int16_t       *output, 
+    size_t         count
+) noexcept;
+
+//
+//  Classes.
+//
+
+/**
+ *  G.711 encoder stage (for recorders).
+ * 
+ *  Converts 16-bit linear audio data to G.711 at 8kHz. If the input sample 
+ *  rate is a multiple of 8kHz, the audio data is low-pass filtered and 
+ *  decimated in the same pass that encodes it. Each call replaces the audio 
+ *  data with an audio buffer taken from a pool of the stage.
+ * 
+ *  @extends IStage
+ */
+class G711Encoder: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The law is not SAMPLEFORMAT_ULAW / SAMPLEFORMAT_ALAW, 
+     *              max_frames == 0 or the input format is invalid.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The input format is not 16-bit or the input sample rate 
+     *              is not a multiple of 8kHz.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param law
+     *      The law (xap::audioio::SAMPLEFORMAT_ULAW or 
+     *      xap::audioio::SAMPLEFORMAT_ALAW).
+     *  @param input_format
+     *      The input audio format (the format of the recorder).
+     *  @param max_frames
+     *      The maximum count of input frames of each call (the frames per 
+     *      buffer of the recorder, or RECORDER_DEFAULT_BLOCK_FRAMES).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    G711Encoder(
+        xap::audioio::SampleFormat       law,
+        const xap::audioio::AudioFormat &input_format,
+        size_t                           max_frames,
+        xap::audioio::IAllocator        *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~G711Encoder() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Encode audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format of the audio data mismatched.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The audio data has more than 'max_frames' frames.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              No pooled audio buffer is available.
+     * 
+     *  @param data
+     *      The audio data (replaced by the encoded audio data).
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Reset the filter state.
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the output audio format.
+     * 
+     *  @return
+     *      The audio format.
+     */
+    const xap::audioio::AudioFormat &get_output_format() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    G711Encoder(const G711Encoder &) = delete;
+    G711Encoder &operator=(const G711Encoder &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Encode linear samples with the law of the stage.
+     * 
+     *  @param input
+     *      The linear samples.
+     *  @param output
+     *      The encoded samples.
+     *  @param count
+     *      The count of samples.
+     */
+    void encode(const int16_t *input, uint8_t *output, size_t count) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::SampleFormat     m_law;
+    xap::audioio::AudioFormat      m_input_format;
+    xap::audioio::AudioFormat      m_output_format;
+    size_t                         m_max_frames;
+    size_t                         m_factor;
+    size_t                         m_tap_count;
+    size_t                         m_phase;
+    size_t                         m_line_length;
+    xap::audioio::AudioBuffer      m_taps;
+    xap::audioio::AudioBuffer      m_lines;
+    xap::audioio::AudioBuffer      m_scratch;
+    xap::audioio::AudioBufferPool  m_pool;
+};
+
+/**
+ *  G.711 decoder source (for players).
+ * 
+ *  Reads G.711 audio data at 8kHz from an upstream source (e.g. a frame 
+ *  queue of u-law frames) and decodes it to 16-bit linear audio data. If the 
+ *  output sample rate is a multiple of 8kHz, the audio data is interpolated 
+ *  with a polyphase low-pass filter.
+ * 
+ *  @extends ISource
+ */
+class G711Decoder: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The upstream source is nullptr, the law is not 
+     *              SAMPLEFORMAT_ULAW / SAMPLEFORMAT_ALAW or the output format 
+     *              is invalid.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The output format is not 16-bit or the output sample 
+     *              rate is not a multiple of 8kHz.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param upstream
+     *      The upstream source (G.711 audio data, 8kHz, with the channel 
+     *      count of the output format).
+     *  @param law
+     *      The law (xap::audioio::SAMPLEFORMAT_ULAW or 
+     *      xap::audioio::SAMPLEFORMAT_ALAW).
+     *  @param output_format
+     *      The output audio format (the format of the player).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    G711Decoder(
+        const std::shared_ptr<xap::audioio::ISource> &upstream,
+        xap::audioio::SampleFormat                    law,
+        const xap::audioio::AudioFormat              &output_format,
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~G711Decoder() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED) or the upstream source failed.
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (fewer than requested if the upstream 
+     *      source ran out of audio data).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Reset the filter state.
+     */
+    void reset() noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    G711Decoder(const G711Decoder &) = delete;
+    G711Decoder &operator=(const G711Decoder &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Decode (and interpolate) audio data read from the upstream source.
+     * 
+     *  @param input
+     *      The encoded audio data.
+     *  @param frame_count
+     *      The count of input frames.
+     *  @param output
+     *      The output (frame_count * factor frames).
+     */
+    void decode(
+        const uint8_t *input, 
+        size_t         frame_count, 
+        int16_t       *output
+    ) noexcept;
+
+    //
+    //  Members.
+    //
+    std::shared_ptr<xap::audioio::ISource>  m_upstream;
+    xap::audioio::SampleFormat              m_law;
+    xap::audioio::AudioFormat               m_input_format;
+    xap::audioio::AudioFormat               m_output_format;
+    size_t                                  m_factor;
+    size_t                                  m_tap_count;
+    size_t                                  m_line_length;
+    xap::audioio::AudioBuffer               m_taps;
+    xap::audioio::AudioBuffer               m_lines;
+    xap::audioio::AudioBuffer               m_input;
+    xap::audioio::AudioBuffer               m_scratch;
+    xap::audioio::AudioBuffer               m_pending;
+    size_t                                  m_pending_offset;
+    size_t                                  m_pending_count;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_G711_H__
@@ -0,0 +1,267 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_LIMITER_H__
+#define XAP_AUDIOIO_LIMITER_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Types.
+//
+
+//  Limiter mode.
+typedef uint8_t LimiterMode;
+
+//
+//  Constants.
+//
+
+//  Limiter modes:
+//
+//    - NONE: The audio data is not changed (samples reaching full scale are 
+//            still counted).
+//    - SOFT_CLIP: Samples above the threshold are bent smoothly towards full 
+//                 scale (no latency).
+//    - PEAK: Look-ahead limiter on the sample peaks.
+//    - TRUE_PEAK: Look-ahead limiter on the peaks between the samples 
+//                 (estimated by 4x cubic interpolation).
+const static LimiterMode LIMITERMODE_NONE = 0U;
+const static LimiterMode LIMITERMODE_SOFT_CLIP = 1U;
+const static LimiterMode LIMITERMODE_PEAK = 2U;
+const static LimiterMode LIMITERMODE_TRUE_PEAK = 3U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Limiter options.
+ */
+typedef struct LimiterOptions_ {
+    //  Mode.
+    xap::audioio::LimiterMode  mode = LIMITERMODE_NONE;
+    uint8_t                    __pad1[3];
+
+    //  Threshold (in dBFS, at most 0).
+    float                      threshold = -1.0F;
+
+    //  Look-ahead time of the look-ahead modes (in milliseconds, the gain 
+    //  reaches its minimum over this time, at most 100).
+    float                      lookahead = 1.5F;
+
+    //  Release time of the look-ahead modes (in milliseconds, the time 
+    //  constant of the gain recovery).
+    float                      release = 50.0F;
+} LimiterOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Output safety limiter.
+ * 
+ *  The final protection of the output against clipping (e.g. of several 
+ *  sources mixed into one player, see PlayerOptions::limiter). The 
+ *  look-ahead modes delay the audio data by get_latency() frames and reduce 
+ *  the gain smoothly before each peak so that no sample (or, in true-peak 
+ *  mode, no estimated peak between samples) exceeds the threshold. The gain 
+ *  is linked over all channels.
+ * 
+ *  Blocks whose peak stays below the threshold while the gain is fully 
+ *  recovered are bypassed (only delayed). The peak scan and the gain 
+ *  computation are vectorized.
+ * 
+ *  @extends IStage
+ */
+class Limiter: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format is not 16-bit or 32-bit float, or the options 
+     *              are invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param format
+     *      The format of the audio data.
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    Limiter(
+        const xap::audioio::AudioFormat      &format,
+        const xap::audioio::LimiterOptions   &options = 
+            xap::audioio::LimiterOptions(),
+        xap::audioio::IAllocator             *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~Limiter() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Process audio data (in place).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the audio data mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param data
+     *      The audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Limit 16-bit audio data (in place, the format must be 16-bit).
+     * 
+     *  @param samples
+     *      The samples (interleaved).
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void limit(int16_t *samples, size_t frame_count) noexcept;
+
+    /**
+     *  Limit 32-bit float audio data (in place, the format must be 32-bit 
+     *  float).
+     * 
+     *  @param samples
+     *      The samples (interleaved).
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void limit(float *samples, size_t frame_count) noexcept;
+
+    /**
+     *  Reset (clear the delay line and recover the gain, the count of clips 
+     *  is kept).
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the count of samples which reached full scale before the limiter 
+     *  (thread-safe).
+     * 
+     *  @return
+     *      The count.
+     */
+    uint64_t get_clip_count() const noexcept;
+
+    /**
+     *  Get the latency (the delay of the audio data).
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    size_t get_latency() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    Limiter(const Limiter &) = delete;
+    Limiter &operator=(const Limiter &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Limit one block of 32-bit float audio data.
+     * 
+     *  @param samples
+     *      The samples (interleaved).
+     *  @param frame_count
+     *      The count of frames (at most the block size).
+     */
+    void limit_block(float *samples, size_t frame_count) noexcept;
+
+    /**
+     *  Detect the peaks of one block (look-ahead modes).
+     * 
+     *  @param samples
+     *      The samples (interleaved).
+     *  @param frame_count
+     *      The count of frames.
+     *  @param peaks
+     *      The peak of each frame (output, delayed by the detector).
+     */
+    void detect(
+        const float  *samples,
+        size_t        frame_count,
+        float        *peaks
+    ) noexcept;
+
+    /**
+     *  Exchange one block with the delay line (look-ahead modes).
+     * 
+     *  @param samples
+     *      The samples (replaced with the delayed samples).
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void delay(float *samples, size_t frame_count) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat     m_format;
+    xap::audioio::LimiterMode     m_mode;
+    uint8_t                       __pad1[3];
+    float                         m_threshold;
+    float                         m_release;
+    float                         m_gain;
+    size_t                        m_channel_count;
+    size_t                        m_window;
+    size_t                        m_latency;
+    xap::audioio::AudioBuffer     m_delay;
+    size_t                        m_delay_position;
+    xap::audioio::AudioBuffer     m_extended;
+    xap::audioio::AudioBuffer     m_minimum_values;
+    xap::audioio::AudioBuffer     m_minimum_indices;
+    size_t                        m_minimum_head;
+    size_t                        m_minimum_count;
+    xap::audioio::AudioBuffer     m_average;
+    size_t                        m_average_position;
+    double                        m_average_sum;
+    uint64_t                      m_index;
+    uint64_t                      m_quiet_frames;
+    std::atomic<uint64_t>         m_clip_count;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_LIMITER_H__
@@ -0,0 +1,284 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_LOOP_H__
+#define XAP_AUDIOIO_LOOP_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Structures.
+//
+
+/**
+ *  Loop region.
+ */
+typedef struct LoopRegion_ {
+    //  First frame of the loop.
+    size_t  loop_start = 0U;
+
+    //  Frame after the last frame of the loop (0 for the end of the audio 
+    //  data).
+    size_t  loop_end = 0U;
+
+    //  Count of frames by which the end of the loop is crossfaded into its 
+    //  start (equal-power, at most half of the loop, 0 to jump without 
+    //  crossfading).
+    size_t  crossfade_frames = 0U;
+} LoopRegion;
+
+/**
+ *  Loop source options.
+ */
+typedef struct LoopSourceOptions_ {
+    //  Position of the first frame played (in frames of the audio data).
+    size_t    start_frame = 0U;
+
+    //  Count of times the loop repeats before the audio data is played to 
+    //  its end (0 to repeat until LoopSource::release() is called).
+    uint64_t  loop_count = 0U;
+} LoopSourceOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Loop (decoded audio data with a loop region).
+ * 
+ *  The audio data and the crossfaded seam of the loop (the end of the loop 
+ *  crossfaded into its start) are immutable once the loop is constructed, 
+ *  so one loop can be shared by any count of sources (see LoopSource), each 
+ *  source only keeps its position.
+ */
+class LoopBuffer {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object (compute the seam).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The region is out of the audio data, or the audio data 
+     *              cannot be crossfaded (not 16-bit, 32-bit or 32-bit 
+     *              float).
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param data
+     *      The audio data (shared, e.g. a prompt of PromptCache).
+     *  @param region
+     *      The loop region.
+     *  @param allocator
+     *      The allocator of the seam (nullptr for the default allocator).
+     */
+    explicit LoopBuffer(
+        const xap::audioio::AudioBuffer    &data,
+        const xap::audioio::LoopRegion     &region = 
+            xap::audioio::LoopRegion(),
+        xap::audioio::IAllocator           *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~LoopBuffer() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get the audio data.
+     * 
+     *  @return
+     *      The audio data.
+     */
+    const xap::audioio::AudioBuffer &get_data() const noexcept;
+
+    /**
+     *  Get the seam (the last frames of the loop crossfaded into its first 
+     *  frames).
+     * 
+     *  @return
+     *      The seam (no frame if the loop is not crossfaded).
+     */
+    const xap::audioio::AudioBuffer &get_seam() const noexcept;
+
+    /**
+     *  Get the first frame of the loop.
+     * 
+     *  @return
+     *      The position (in frames).
+     */
+    size_t get_loop_start() const noexcept;
+
+    /**
+     *  Get the frame after the last frame of the loop.
+     * 
+     *  @return
+     *      The position (in frames).
+     */
+    size_t get_loop_end() const noexcept;
+
+    /**
+     *  Get the count of frames of the crossfade (clamped to half of the 
+     *  loop).
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    size_t get_crossfade_frames() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    LoopBuffer(const LoopBuffer &) = delete;
+    LoopBuffer &operator=(const LoopBuffer &) = delete;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioBuffer     m_data;
+    xap::audioio::AudioBuffer     m_seam;
+    size_t                        m_loop_start;
+    size_t                        m_loop_end;
+    size_t                        m_crossfade_frames;
+};
+
+/**
+ *  Source which plays a loop (see LoopBuffer).
+ * 
+ *  The source plays the audio data up to the seam, the seam, then the loop 
+ *  from the frame after the crossfaded frames of its start, so the period 
+ *  of the loop is the length of the loop less the crossfade. After the 
+ *  last repetition (or after release()), the audio data is played to its 
+ *  end instead of the seam.
+ * 
+ *  @extends ISource
+ */
+class LoopSource: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the loop is nullptr or the start frame is out of the 
+     *      audio data (xap::audioio::ERROR_PARAMETER).
+     *  @param loop
+     *      The loop (shared).
+     *  @param options
+     *      The options.
+     */
+    explicit LoopSource(
+        const std::shared_ptr<const xap::audioio::LoopBuffer>  &loop,
+        const xap::audioio::LoopSourceOptions                  &options = 
+            xap::audioio::LoopSourceOptions()
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~LoopSource() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (less than requested at the end of the 
+     *      audio data).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Seek (on the audio thread, or while the source is not played).
+     * 
+     *  @param frame
+     *      The position (in frames of the audio data, clamped to its 
+     *      length).
+     */
+    void seek(size_t frame) noexcept;
+
+    /**
+     *  Stop repeating (thread-safe), the audio data is played to its end 
+     *  once the end of the loop is reached.
+     */
+    void release() noexcept;
+
+    /**
+     *  Get the count of times the loop repeated.
+     * 
+     *  @return
+     *      The count.
+     */
+    uint64_t get_loop_index() const noexcept;
+
+    /**
+     *  Get whether all frames were read.
+     * 
+     *  @return
+     *      True if so.
+     */
+    bool is_finished() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    LoopSource(const LoopSource &) = delete;
+    LoopSource &operator=(const LoopSource &) = delete;
+
+    //
+    //  Members.
+    //
+    std::shared_ptr<const xap::audioio::LoopBuffer>    m_loop;
+    uint64_t                                           m_loop_count;
+    size_t                                             m_frame_size;
+    size_t                                             m_position;
+    bool                                               m_is_in_seam;
+    std::atomic<bool>                                  m_is_released;
+    std::atomic<bool>                                  m_is_finished;
+    uint8_t                                            __pad1[5];
+    std::atomic<uint64_t>                              m_loop_index;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_LOOP_H__
@@ -0,0 +1,229 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_LOSSCONCEALER_H__
+#define XAP_AUDIOIO_LOSSCONCEALER_H__
+
+//
+//  Imports.
+//
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Classes.
+//
+
+/**
+ *  Packet loss concealer (in the style of ITU-T G.711 Appendix I).
+ * 
+ *  The concealer wraps an upstream source (typically a network-fed source 
+ *  like FrameQueue or G711Decoder) and treats the frames it does not 
+ *  provide (see ISource::read()) as lost. Lost frames are replaced by 
+ *  repeating the last pitch period of the audio data (extended to 2 and 3 
+ *  periods after 10ms and 20ms), with overlap-add at each boundary, 
+ *  attenuated by 20% per 10ms after the first 10ms so that losses longer 
+ *  than 60ms fade to silence. The first frames received after a loss are 
+ *  overlap-added with the synthetic audio data.
+ * 
+ *  To overlap-add at the beginning of a loss, the output is delayed by a 
+ *  quarter of the maximum pitch period (3.75ms, see get_latency()). All 
+ *  memory is allocated on construction, read() never allocates.
+ * 
+ *  @extends ISource
+ */
+class LossConcealer: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The upstream source is nullptr or the format is invalid.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The sample format is neither 16-bit nor 32-bit float or 
+     *              the sample rate is lower than 8kHz.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param upstream
+     *      The upstream source (in the format of the output).
+     *  @param format
+     *      The audio format (the format of the player).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    LossConcealer(
+        const std::shared_ptr<xap::audioio::ISource> &upstream,
+        const xap::audioio::AudioFormat              &format,
+        xap::audioio::IAllocator                     *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~LossConcealer() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED) or the upstream source failed.
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames of the output (lost frames are concealed).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Reset the state (clear the history).
+     */
+    void reset() noexcept;
+
+    /**
+     *  Get the delay of the output (in frames).
+     * 
+     *  @return
+     *      The delay.
+     */
+    size_t get_latency() const noexcept;
+
+    /**
+     *  Get the count of frames concealed since construction (or reset()).
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    uint64_t get_concealed_frame_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    LossConcealer(const LossConcealer &) = delete;
+    LossConcealer &operator=(const LossConcealer &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Append received frames to the history of one channel.
+     * 
+     *  @param channel
+     *      The channel index.
+     *  @param input
+     *      The received samples.
+     *  @param count
+     *      The count of samples.
+     *  @param state
+     *      The concealment state (updated).
+     */
+    void append_received(
+        size_t                          channel,
+        const float                    *input,
+        size_t                          count,
+        struct LossConcealerState_     &state
+    ) noexcept;
+
+    /**
+     *  Append synthetic frames to the history of one channel.
+     * 
+     *  @param channel
+     *      The channel index.
+     *  @param count
+     *      The count of samples.
+     *  @param state
+     *      The concealment state (updated).
+     */
+    void append_concealed(
+        size_t                          channel,
+        size_t                          count,
+        struct LossConcealerState_     &state
+    ) noexcept;
+
+    /**
+     *  Synthesize the next samples of one channel.
+     * 
+     *  @param channel
+     *      The channel index.
+     *  @param output
+     *      The output.
+     *  @param count
+     *      The count of samples.
+     *  @param state
+     *      The concealment state (updated).
+     */
+    void synthesize(
+        size_t                          channel,
+        float                          *output,
+        size_t                          count,
+        struct LossConcealerState_     &state
+    ) const noexcept;
+
+    /**
+     *  Begin concealing a loss: estimate the pitch period, save the pitch 
+     *  buffers and overlap-add the end of the history.
+     */
+    void begin_loss() noexcept;
+
+    /**
+     *  Estimate the pitch period of the history.
+     * 
+     *  @return
+     *      The pitch period (in frames).
+     */
+    size_t find_pitch() noexcept;
+
+    //
+    //  Members.
+    //
+    std::shared_ptr<xap::audioio::ISource>  m_upstream;
+    xap::audioio::AudioFormat               m_format;
+    size_t                                  m_channel_count;
+    size_t                                  m_pitch_min;
+    size_t                                  m_pitch_max;
+    size_t                                  m_correlation_length;
+    size_t                                  m_overlap_max;
+    size_t                                  m_frames_10ms;
+    size_t                                  m_frames_4ms;
+    size_t                                  m_history_length;
+    size_t                                  m_history_capacity;
+    size_t                                  m_history_end;
+    xap::audioio::AudioBuffer               m_history;
+    xap::audioio::AudioBuffer               m_pitch_buffers;
+    xap::audioio::AudioBuffer               m_work;
+    xap::audioio::AudioBuffer               m_mixdown;
+    struct LossConcealerState_             *m_state;
+    uint64_t                                m_concealed;
+    xap::audioio::IAllocator               *m_allocator;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_LOSSCONCEALER_H__
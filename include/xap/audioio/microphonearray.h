@@ -0,0 +1,59 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_MICROPHONEARRAY_H__
+#define XAP_AUDIOIO_MICROPHONEARRAY_H__
+
+//
+//  Imports.
+//
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Maximum count of microphones of an array.
+const static size_t MICROPHONEARRAY_MAX_CHANNELS = 16U;
+
+//  Speed of sound in air at 20 degrees Celsius (in m/s).
+const static float MICROPHONEARRAY_SPEED_OF_SOUND = 343.0F;
+
+//
+//  Structures.
+//
+
+/**
+ *  Position of a microphone (in meters).
+ * 
+ *  Directions are given as azimuth (in degrees, 0 towards +x, 90 towards 
+ *  +y) and elevation (in degrees, 0 in the x-y plane, 90 towards +z).
+ */
+typedef struct MicrophonePosition_ {
+    float x;
+    float y;
+    float z;
+} MicrophonePosition;
+
+/**
+ *  Geometry of a microphone array, the microphone i is the channel i of the 
+ *  multi-channel input.
+ */
+typedef struct MicrophoneArray_ {
+    xap::audioio::MicrophonePosition 
+                positions[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS] = {};
+    uint32_t    channel_count = 0U;
+    float       speed_of_sound = xap::audioio::MICROPHONEARRAY_SPEED_OF_SOUND;
+} MicrophoneArray;
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_MICROPHONEARRAY_H__
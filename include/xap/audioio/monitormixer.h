@@ -0,0 +1,191 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_MONITORMIXER_H__
+#define XAP_AUDIOIO_MONITORMIXER_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/device.h>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Maximum count of output channels of direct monitoring.
+const static size_t MONITOR_MAX_CHANNELS = 32U;
+
+//  Maximum gain of direct monitoring (in dB).
+const static float MONITOR_MAX_GAIN = 24.0F;
+
+//  Special channel map entries of direct monitoring:
+//
+//    - NONE: The output channel plays no input.
+//    - DEFAULT: The output channel plays the input channel of the same index 
+//               (modulo the count of input channels, e.g. a mono input is 
+//               played on all output channels).
+const static int8_t MONITOR_CHANNEL_NONE = -1;
+const static int8_t MONITOR_CHANNEL_DEFAULT = -2;
+
+//
+//  Structures.
+//
+
+/**
+ *  Direct monitoring options.
+ */
+typedef struct MonitorOptions_ {
+    //  Enable direct monitoring: the stream is opened in duplex mode and the 
+    //  input is mixed into the output in the same callback (a latency of 
+    //  one period, the input is not processed by the stages).
+    bool                       enabled = false;
+
+    //  Count of input channels.
+    uint8_t                    channel_count = 1U;
+    uint8_t                    __pad1[2];
+
+    //  Gain (in dB, at most MONITOR_MAX_GAIN, see 
+    //  IPlayer::set_monitor_gain()).
+    float                      gain = 0.0F;
+
+    //  Input device (of the same host API as the output device, opened with 
+    //  its default low input latency).
+    xap::audioio::InputDevice  device;
+
+    //  Input channel played on each output channel (or MONITOR_CHANNEL_*).
+    int8_t                     channel_map[MONITOR_MAX_CHANNELS] = {
+        -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, 
+        -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2, -2
+    };
+} MonitorOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Direct monitoring mixer (of a player).
+ * 
+ *  Mixes 16-bit input frames into a 32-bit float mix bus (full scale is 
+ *  1.0) through a channel map. The sum is not saturated, so the limiter of 
+ *  the bus sees every sample which would clip. Gain changes are ramped 
+ *  linearly over the next call so that they do not click.
+ */
+class MonitorMixer {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if direct monitoring is enabled and the options are 
+     *      invalid, i.e. no input channel, more than MONITOR_MAX_CHANNELS 
+     *      output channels, a gain above MONITOR_MAX_GAIN or a channel map 
+     *      entry out of range (xap::audioio::ERROR_PARAMETER).
+     *  @param options
+     *      The options (the mixer does nothing if not enabled).
+     *  @param output_channel_count
+     *      The count of output channels.
+     */
+    MonitorMixer(
+        const xap::audioio::MonitorOptions &options,
+        size_t                              output_channel_count
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~MonitorMixer() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get whether direct monitoring is enabled.
+     * 
+     *  @return
+     *      True if enabled.
+     */
+    bool is_enabled() const noexcept;
+
+    /**
+     *  Get the input channel played on an output channel.
+     * 
+     *  @param output_channel
+     *      The output channel.
+     *  @return
+     *      The input channel, or SIZE_MAX if the output channel plays no 
+     *      input (or direct monitoring is not enabled).
+     */
+    size_t get_input_channel(size_t output_channel) const noexcept;
+
+    /**
+     *  Set the gain (thread-safe, lock-free, ramped over the next call of 
+     *  mix()).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              Direct monitoring is not enabled.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The gain is above MONITOR_MAX_GAIN.
+     * 
+     *  @param gain
+     *      The gain (in dB, -INFINITY to mute).
+     */
+    void set_gain(float gain);
+
+    /**
+     *  Mix input frames into the mix bus (the audio thread).
+     * 
+     *  @param input
+     *      The input samples (interleaved, nullptr if not available).
+     *  @param bus
+     *      The samples of the mix bus (interleaved, the output channels).
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void mix(
+        const int16_t  *input,
+        float          *bus,
+        size_t          frame_count
+    ) noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    MonitorMixer(const MonitorMixer &) = delete;
+    MonitorMixer &operator=(const MonitorMixer &) = delete;
+
+    //
+    //  Members.
+    //
+    size_t              m_input_count;
+    size_t              m_output_count;
+    size_t              m_map[xap::audioio::MONITOR_MAX_CHANNELS];
+    std::atomic<float>  m_gain;
+    float               m_ramp_gain;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_MONITORMIXER_H__
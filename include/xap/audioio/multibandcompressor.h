@@ -0,0 +1,250 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_MULTIBANDCOMPRESSOR_H__
+#define XAP_AUDIOIO_MULTIBANDCOMPRESSOR_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/stage.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+template<class T> class MpscQueue;
+struct CompressorUpdate_;
+
+//
+//  Constants.
+//
+
+//  Minimum and maximum count of bands.
+const static size_t COMPRESSOR_MIN_BANDS = 3U;
+const static size_t COMPRESSOR_MAX_BANDS = 5U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Compressor band parameters.
+ */
+typedef struct CompressorBand_ {
+    //  Threshold (in dBFS).
+    float  threshold = -20.0F;
+
+    //  Ratio (1 for no compression).
+    float  ratio = 4.0F;
+
+    //  Attack time (in milliseconds).
+    float  attack = 10.0F;
+
+    //  Release time (in milliseconds).
+    float  release = 100.0F;
+
+    //  Width of the soft knee (in dB, 0 for a hard knee).
+    float  knee = 6.0F;
+
+    //  Make-up gain (in dB).
+    float  makeup = 0.0F;
+} CompressorBand;
+
+/**
+ *  Multi-band compressor options.
+ */
+typedef struct MultibandCompressorOptions_ {
+    //  Count of bands (3 to 5).
+    uint8_t                       band_count = 3U;
+    uint8_t                       __pad1[3];
+
+    //  Crossover frequencies (in Hz, ascending, band_count - 1 are used).
+    float                         crossovers[COMPRESSOR_MAX_BANDS - 1U] = {
+        200.0F, 3000.0F, 8000.0F, 14000.0F
+    };
+
+    //  Parameters of each band (from the lowest band).
+    xap::audioio::CompressorBand  bands[COMPRESSOR_MAX_BANDS];
+} MultibandCompressorOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Multi-band dynamics compressor.
+ * 
+ *  The audio data is split into bands by 4th-order Linkwitz-Riley 
+ *  crossovers (the lower bands are passed through the all-pass responses 
+ *  of the higher crossovers, so the bands sum up flat). Each band of each 
+ *  channel has a peak envelope follower and a soft-knee gain computer (at 
+ *  a control rate of 16 frames, the gain is ramped in between), then the 
+ *  bands are summed.
+ * 
+ *  The filters and the envelope followers process 4 channels per SIMD 
+ *  vector, each band in turn. The band parameters can be changed from any 
+ *  thread while the compressor runs (see set_band()), the audio thread 
+ *  picks the changes up lock-free at the next call of process().
+ * 
+ *  @extends IStage
+ */
+class MultibandCompressor: public xap::audioio::IStage {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format is not 16-bit or 32-bit float, or the options 
+     *              are invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param format
+     *      The format of the audio data.
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    MultibandCompressor(
+        const xap::audioio::AudioFormat                   &format,
+        const xap::audioio::MultibandCompressorOptions    &options = 
+            xap::audioio::MultibandCompressorOptions(),
+        xap::audioio::IAllocator                          *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~MultibandCompressor() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Process audio data (in place).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the audio data mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param data
+     *      The audio data.
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) override;
+
+    /**
+     *  Change the parameters of a band (thread-safe, lock-free, applied at 
+     *  the next call of process()).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The band or the parameters are invalid.
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              Too many changes are pending.
+     * 
+     *  @param band
+     *      The index of the band (0 for the lowest band).
+     *  @param parameters
+     *      The parameters.
+     */
+    void set_band(
+        size_t                                band,
+        const xap::audioio::CompressorBand   &parameters
+    );
+
+    /**
+     *  Get the gain reduction of a band (thread-safe, the largest over all 
+     *  channels at the end of the last call of process()).
+     * 
+     *  @param band
+     *      The index of the band.
+     *  @return
+     *      The gain reduction (in dB, not less than 0, excluding the make-up 
+     *      gain).
+     */
+    float get_gain_reduction(size_t band) const noexcept;
+
+    /**
+     *  Reset (clear the filters and the envelopes).
+     */
+    void reset() noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    MultibandCompressor(const MultibandCompressor &) = delete;
+    MultibandCompressor &operator=(const MultibandCompressor &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Apply the pending parameter changes.
+     */
+    void apply_updates() noexcept;
+
+    /**
+     *  Compress one block of 32-bit float audio data.
+     * 
+     *  @param samples
+     *      The samples (interleaved, in place).
+     *  @param frame_count
+     *      The count of frames (at most the block size).
+     */
+    void compress(float *samples, size_t frame_count) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat                  m_format;
+    size_t                                     m_channel_count;
+    size_t                                     m_group_count;
+    size_t                                     m_band_count;
+    xap::audioio::CompressorBand               m_bands[COMPRESSOR_MAX_BANDS];
+    float                                      m_attacks[COMPRESSOR_MAX_BANDS];
+    float                                      m_releases[COMPRESSOR_MAX_BANDS];
+    float                                      m_coefficients[
+        (COMPRESSOR_MAX_BANDS - 1U) * 15U
+    ];
+    xap::audioio::AudioBuffer                  m_states;
+    xap::audioio::AudioBuffer                  m_envelopes;
+    xap::audioio::AudioBuffer                  m_gains;
+    xap::audioio::AudioBuffer                  m_lanes;
+    xap::audioio::AudioBuffer                  m_block;
+    xap::audioio::MpscQueue<struct xap::audioio::CompressorUpdate_>
+                                              *m_updates;
+    std::atomic<float>                         m_reductions[
+        COMPRESSOR_MAX_BANDS
+    ];
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_MULTIBANDCOMPRESSOR_H__
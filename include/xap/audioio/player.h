@@ -10,8 +10,16 @@
 //
 //  Imports.
 //
+#include <functional>
+#include <memory>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
 #include <xap/audioio/device.h>
 #include <xap/audioio/error.h>
+#include <xap/audioio/limiter.h>
+#include <xap/audioio/monitormixer.h>
+#include <xap/audioio/source.h>
+#include <xap/audioio/stage.h>
 #include <xap/core/buffer/buffer.h>
 
 namespace xap {
@@ -20,6 +28,10 @@ namespace audioio {
 //
 //  Structure.
 //
+
+/**
+ *  Player options.
+ */
 typedef struct PlayerOptions_ {
     xap::audioio::OutputDevice device;
     uint8_t                    channel_count;
@@ -30,6 +42,29 @@ typedef struct PlayerOptions_ {
 
     double                     suggested_latency;
     size_t                     frame_pre_buffer;
+
+    //  Prime the output buffers of the host with audio data provided by the 
+    //  pre-roll and the audio callback instead of zeros 
+    //  (paPrimeOutputBuffersUsingStreamCallback).
+    bool                       prime_output_buffers = false;
+    uint8_t                    __pad3[7];
+
+    //  Count of pooled audio buffers of the source and the frame callback 
+    //  (each period takes one, so the frame callback may retain at most 
+    //  this count minus one, otherwise the period is played silent and the 
+    //  error callback receives xap::audioio::ERROR_ALLOC).
+    size_t                     frame_pool_blocks = 16U;
+
+    //  Output safety limiter (applied on a 32-bit float mix bus to all audio 
+    //  data played and the monitored input, samples reaching full scale on 
+    //  the bus are counted in every mode, see IPlayer::get_clip_count()). 
+    //  In LIMITERMODE_NONE without direct monitoring, the 16-bit output is 
+    //  only scanned for clips (no mix bus).
+    xap::audioio::LimiterOptions limiter;
+
+    //  Direct monitoring of an input device (mixed on the bus before the 
+    //  limiter).
+    xap::audioio::MonitorOptions monitor;
 } PlayerOptions;
 
 /**
@@ -78,6 +113,75 @@ public:
         std::function <void(xap::core::buffer::Buffer &)> &callback
     ) = 0;
 
+    /**
+     *  Set frame callback.
+     * 
+     *  The callback fills an audio buffer (aligned, pooled storage, silence 
+     *  initially) with the audio data of the next period. If set, it is used 
+     *  instead of the audio callback. The audio buffer (or slices of it) can 
+     *  be retained after the callback returned without copying.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error. 
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    virtual void set_frame_callback(
+        std::function <void(xap::audioio::AudioBuffer &)> &callback
+    ) = 0;
+
+    /**
+     *  Set audio source.
+     * 
+     *  If set, the source provides the audio data instead of the audio and 
+     *  frame callbacks.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the player is running 
+     *      (xap::audioio::ERROR_INVALIDOPERATION).
+     *  @param source
+     *      The source (nullptr to remove the source).
+     */
+    virtual void set_source(
+        const std::shared_ptr<xap::audioio::ISource> &source
+    ) = 0;
+
+    /**
+     *  Append a processing stage.
+     * 
+     *  Stages process each period of the source or the frame callback in 
+     *  the order they were added before it is played (the audio data of the 
+     *  audio callback and the pre-rolled audio data are played unprocessed). 
+     *  Stages must keep the format (16-bit) and the count of frames, 
+     *  otherwise the period is played silent and the error callback 
+     *  receives xap::audioio::ERROR_UNSUPPORTED.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player is running.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The stage is nullptr.
+     * 
+     *  @param stage
+     *      The stage.
+     */
+    virtual void add_stage(
+        const std::shared_ptr<xap::audioio::IStage> &stage
+    ) = 0;
+
+    /**
+     *  Remove all processing stages.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the player is running 
+     *      (xap::audioio::ERROR_INVALIDOPERATION).
+     */
+    virtual void clear_stages() = 0;
+
     /**
      *  Set error callback.
      * 
@@ -106,6 +210,119 @@ public:
      *      True if forcibly.
      */
     virtual void stop(bool forcibly) = 0;
+
+    /**
+     *  Pause player.
+     * 
+     *  The device stream keeps running and outputs silence (and the input 
+     *  of direct monitoring), the audio callback is suspended until the 
+     *  player was resumed.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player is not running or was already paused.
+     */
+    virtual void pause() = 0;
+
+    /**
+     *  Resume player.
+     * 
+     *  The audio callback is invoked again from the next period, no audio 
+     *  data of the callback is skipped or repeated.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player is not running or is not paused.
+     */
+    virtual void resume() = 0;
+
+    /**
+     *  Get whether the player is paused.
+     * 
+     *  @return
+     *      True if paused.
+     */
+    virtual bool is_paused() const noexcept = 0;
+
+    /**
+     *  Pre-roll audio data.
+     * 
+     *  The pre-rolled audio data is played before any data of the audio 
+     *  callback. If the player was opened with 'prime_output_buffers', it is 
+     *  also used to prime the output buffers of the host.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player was already running.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The length of the data is not a multiple of frame size.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param data
+     *      The audio data.
+     */
+    virtual void preroll(xap::core::buffer::Buffer &data) = 0;
+
+    /**
+     *  Get the time to first sample of the last start.
+     * 
+     *  The time is measured from the call of start() (before the stream 
+     *  starts) to the DAC output time of the first sample, plus the latency 
+     *  of the limiter. If the output buffers were primed with pre-rolled 
+     *  audio data, the first sample is the first primed one (dated from the 
+     *  first callback which is not priming the output buffers).
+     * 
+     *  @return
+     *      The time (in seconds), or a negative value if the first sample was 
+     *      not output yet.
+     */
+    virtual double get_time_to_first_sample() const noexcept = 0;
+
+    /**
+     *  Get the count of samples which reached full scale on the mix bus 
+     *  before the output safety limiter, i.e. the samples which would have 
+     *  clipped without it (see PlayerOptions::limiter, thread-safe).
+     * 
+     *  @return
+     *      The count.
+     */
+    virtual uint64_t get_clip_count() const noexcept = 0;
+
+    /**
+     *  Get the latency of the output safety limiter (the look-ahead delay of 
+     *  the audio data, 0 if the mode has no look-ahead).
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    virtual size_t get_limiter_latency() const noexcept = 0;
+
+    /**
+     *  Set the gain of direct monitoring (thread-safe, lock-free, ramped 
+     *  over the next period).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              Direct monitoring is not enabled.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The gain is above MONITOR_MAX_GAIN.
+     * 
+     *  @param gain
+     *      The gain (in dB, -INFINITY to mute).
+     */
+    virtual void set_monitor_gain(float gain) = 0;
 };
 
 /**
@@ -118,10 +335,19 @@ public:
     //
 
     /**
-     *  Construct the object.
+     *  Construct the object (with the default allocator).
      */
     PlayerFactory() noexcept;
 
+    /**
+     *  Construct the object.
+     * 
+     *  @param allocator
+     *      The allocator used by all players created by the factory (must 
+     *      outlive the players).
+     */
+    explicit PlayerFactory(xap::audioio::IAllocator *allocator) noexcept;
+
     /**
      *  Destruct the object.
      */
@@ -140,6 +366,10 @@ public:
      *          - xap::audioio::ERROR_UNSUPPORTED:
      *              Player cannot supported this format.
      * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The options of the limiter, of the monitor or of the 
+     *              frame pool are invalid.
+     * 
      *          - xap::audioio::ERROR_PORTAUDIOCALL:
      *              PortAudio calling occurred error.
      * 
@@ -162,6 +392,10 @@ public:
      *          - xap::audioio::ERROR_UNSUPPORTED:
      *              Player cannot supported this format.
      * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The options of the limiter, of the monitor or of the 
+     *              frame pool are invalid.
+     * 
      *          - xap::audioio::ERROR_PORTAUDIOCALL:
      *              PortAudio calling occurred error.
      * 
@@ -184,6 +418,10 @@ public:
      *          - xap::audioio::ERROR_UNSUPPORTED:
      *              Player cannot supported this format.
      * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The options of the limiter, of the monitor or of the 
+     *              frame pool are invalid.
+     * 
      *          - xap::audioio::ERROR_PORTAUDIOCALL:
      *              PortAudio calling occurred error.
      * 
@@ -213,6 +451,12 @@ public:
      *      The instance.
      */
     void free_instance(xap::audioio::IPlayer **instance);
+
+private:
+    //
+    //  Members.
+    //
+    xap::audioio::IAllocator *m_allocator;
 };
 
 }  //  namespace audioio
@@ -0,0 +1,316 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_PLAYLIST_H__
+#define XAP_AUDIOIO_PLAYLIST_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/promptcache.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+template<class T> class MpscQueue;
+struct PlaylistItem_;
+
+//
+//  Types.
+//
+
+//  Playlist event type.
+typedef uint8_t PlaylistEventType;
+
+//
+//  Constants.
+//
+
+//  Playlist event types.
+const static PlaylistEventType PLAYLISTEVENT_STARTED = 1U;
+const static PlaylistEventType PLAYLISTEVENT_FINISHED = 2U;
+const static PlaylistEventType PLAYLISTEVENT_FAILED = 3U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Playlist event.
+ */
+typedef struct PlaylistEvent_ {
+    //  Type.
+    xap::audioio::PlaylistEventType  type;
+
+    //  Reserved.
+    uint8_t                          __pad1[1];
+
+    //  Error code (PLAYLISTEVENT_FAILED only).
+    uint16_t                         error;
+
+    //  Reserved.
+    uint8_t                          __pad2[4];
+
+    //  Item (see PlaylistSource::append()).
+    uint64_t                         item;
+
+    //  Position in the output of the playlist (in frames, the first frame 
+    //  of the item for PLAYLISTEVENT_STARTED, the frame after its last 
+    //  frame for PLAYLISTEVENT_FINISHED, the position when the failure was 
+    //  noticed for PLAYLISTEVENT_FAILED).
+    uint64_t                         frame;
+} PlaylistEvent;
+
+/**
+ *  Playlist options.
+ */
+typedef struct PlaylistOptions_ {
+    //  Count of frames by which consecutive items overlap (equal-power 
+    //  crossfade, 0 to splice the items without overlapping).
+    size_t                      crossfade_frames = 0U;
+
+    //  Count of items decoded ahead of the item being played.
+    size_t                      lookahead = 2U;
+
+    //  Cache which decodes the items (nullptr for the process-wide cache, 
+    //  see get_default_prompt_cache()).
+    xap::audioio::PromptCache  *cache = nullptr;
+} PlaylistOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Source which plays audio files one after another without gaps.
+ * 
+ *  Items are appended on any thread. A process-wide decoder thread decodes 
+ *  the items ahead of the one being played (through a prompt cache, so the 
+ *  prompts shared by many playlists are decoded once), the audio thread 
+ *  only copies the decoded frames and splices the next item at the frame 
+ *  after the last frame of the current one (or crossfades them), so read() 
+ *  never blocks on I/O. Item transitions are reported through a lock-free 
+ *  event queue (see poll_event()).
+ * 
+ *  @extends ISource
+ */
+class PlaylistSource: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format or the options are invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              The decoder thread cannot be started.
+     * 
+     *  @param format
+     *      The audio format (16-bit, 32-bit or 32-bit float).
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    explicit PlaylistSource(
+        const xap::audioio::AudioFormat          &format,
+        const xap::audioio::PlaylistOptions      &options = 
+            xap::audioio::PlaylistOptions(),
+        xap::audioio::IAllocator                 *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~PlaylistSource() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Append an item (thread-safe).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if memory allocation was failed 
+     *      (xap::audioio::ERROR_ALLOC).
+     *  @param path
+     *      The path of the audio file.
+     *  @return
+     *      The item (identifies the item in the events, starts from 1).
+     */
+    uint64_t append(const char *path);
+
+    /**
+     *  Read audio data (on the audio thread, never blocks on I/O).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (less than requested if all items were 
+     *      played, or if the next item was not decoded yet).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Get the next event (single consumer).
+     * 
+     *  Events are dropped if they are not polled (the queue holds 256 
+     *  events). Failures are reported by the decoder thread, so they may be 
+     *  reported before the items ahead of the failed one finished.
+     * 
+     *  @param event
+     *      The event (output).
+     *  @return
+     *      True if an event was got.
+     */
+    bool poll_event(xap::audioio::PlaylistEvent &event) noexcept;
+
+    /**
+     *  Get whether all items appended were played (or failed).
+     * 
+     *  @return
+     *      True if so.
+     */
+    bool is_finished() const noexcept;
+
+    /**
+     *  Get the count of frames missing between items (the next item was not 
+     *  decoded in time).
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    uint64_t get_gap_frame_count() const noexcept;
+
+private:
+    //
+    //  Types.
+    //
+
+    //  Path of an item (allocated by the allocator of the source).
+    typedef std::basic_string<
+        char,
+        std::char_traits<char>,
+        xap::audioio::StlAllocator<char>
+    > PendingPath;
+
+    //  Item not decoded yet (the item and the path of the file).
+    typedef std::pair<uint64_t, PendingPath> PendingItem;
+
+    //
+    //  Constructors.
+    //
+    PlaylistSource(const PlaylistSource &) = delete;
+    PlaylistSource &operator=(const PlaylistSource &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Decode the items ahead and release the items played (on the decoder 
+     *  thread).
+     */
+    void serve() noexcept;
+
+    /**
+     *  Emit an event (dropped if the queue is full).
+     * 
+     *  @param type
+     *      The type.
+     *  @param item
+     *      The item.
+     *  @param frame
+     *      The position.
+     *  @param error
+     *      The error code.
+     */
+    void emit(
+        xap::audioio::PlaylistEventType  type,
+        uint64_t                         item,
+        uint64_t                         frame,
+        uint16_t                         error = 0U
+    ) noexcept;
+
+    /**
+     *  Hand an item over to the decoder thread for releasing it (on the 
+     *  audio thread).
+     * 
+     *  @param item
+     *      The item.
+     */
+    void retire(struct xap::audioio::PlaylistItem_ *item) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat                             m_format;
+    xap::audioio::PlaylistOptions                         m_options;
+    xap::audioio::IAllocator                             *m_allocator;
+    size_t                                                m_frame_size;
+
+    //  Items not decoded yet (guarded by the lock).
+    std::mutex                                            m_lock;
+    std::deque<
+        xap::audioio::PlaylistSource::PendingItem,
+        xap::audioio::StlAllocator<xap::audioio::PlaylistSource::PendingItem>
+    >                                                     m_pending;
+    uint64_t                                              m_last_item;
+
+    //  Shared by the threads.
+    xap::audioio::MpscQueue<struct xap::audioio::PlaylistItem_ *>
+                                                         *m_ready;
+    xap::audioio::MpscQueue<struct xap::audioio::PlaylistItem_ *>
+                                                         *m_retired;
+    xap::audioio::MpscQueue<xap::audioio::PlaylistEvent> *m_events;
+    std::atomic<size_t>                                   m_ready_count;
+    std::atomic<uint64_t>                                 m_remaining_count;
+    std::atomic<uint64_t>                                 m_gap_count;
+    std::atomic<uint64_t>                                 m_frame_position;
+
+    //  Audio thread state.
+    struct xap::audioio::PlaylistItem_                   *m_current;
+    struct xap::audioio::PlaylistItem_                   *m_next;
+    size_t                                                m_current_position;
+    size_t                                                m_next_position;
+    size_t                                                m_fade_length;
+    bool                                                  m_has_played;
+
+    friend class PlaylistDecoder;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_PLAYLIST_H__
@@ -0,0 +1,318 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_PROMPTCACHE_H__
+#define XAP_AUDIOIO_PROMPTCACHE_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Declare.
+//
+struct PromptCacheShard_;
+
+//
+//  Structures.
+//
+
+/**
+ *  Prompt cache options.
+ */
+typedef struct PromptCacheOptions_ {
+    //  Budget of the decoded audio data (in bytes).
+    size_t  budget = 256U * 1024U * 1024U;
+
+    //  Count of shards (each shard has its own lock and a share of the 
+    //  budget).
+    size_t  shard_count = 16U;
+} PromptCacheOptions;
+
+//
+//  Classes.
+//
+
+/**
+ *  Cache of decoded prompts (audio files).
+ * 
+ *  Prompts are decoded once (see AudioFileReader) to the audio format they 
+ *  are played in and kept as audio buffers. A lookup returns a reference to 
+ *  the cached audio buffer (the storage is shared, not copied), so any 
+ *  count of players can play a prompt from a single decoded copy (see 
+ *  PromptSource). The least recently used prompts are evicted when the 
+ *  budget is exceeded, the storage of an evicted prompt is released when 
+ *  the last player stopped referencing it.
+ * 
+ *  Prompts are distributed to shards by their path and format, lookups of 
+ *  different shards never contend and a prompt is decoded without holding 
+ *  the lock of its shard.
+ */
+class PromptCache {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The count of shards is 0.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param options
+     *      The options.
+     *  @param allocator
+     *      The allocator of the decoded audio data and the prompts cached 
+     *      (nullptr for the default allocator).
+     */
+    explicit PromptCache(
+        const xap::audioio::PromptCacheOptions  &options = 
+            xap::audioio::PromptCacheOptions(),
+        xap::audioio::IAllocator                *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    ~PromptCache() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Load a prompt (thread-safe, decodes the file if it is not cached).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_IO:
+     *              The file cannot be opened or read.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The file is not supported or cannot be converted to the 
+     *              format.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The format is invalid.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param path
+     *      The path of the file.
+     *  @param format
+     *      The audio format (16-bit, 32-bit or 32-bit float).
+     *  @return
+     *      The decoded audio data (shared with the cache, must not be 
+     *      modified).
+     */
+    xap::audioio::AudioBuffer load(
+        const char                       *path,
+        const xap::audioio::AudioFormat  &format
+    );
+
+    /**
+     *  Remove a prompt (in all formats, thread-safe).
+     * 
+     *  @param path
+     *      The path of the file.
+     */
+    void remove(const char *path) noexcept;
+
+    /**
+     *  Remove all prompts (thread-safe).
+     */
+    void clear() noexcept;
+
+    /**
+     *  Set the budget (thread-safe, evicts prompts if needed).
+     * 
+     *  @param budget
+     *      The budget (in bytes).
+     */
+    void set_budget(size_t budget) noexcept;
+
+    /**
+     *  Get the budget.
+     * 
+     *  @return
+     *      The budget (in bytes).
+     */
+    size_t get_budget() const noexcept;
+
+    /**
+     *  Get the size of the cached audio data.
+     * 
+     *  @return
+     *      The size (in bytes).
+     */
+    size_t get_size() const noexcept;
+
+    /**
+     *  Get the count of lookups which found the prompt cached.
+     * 
+     *  @return
+     *      The count of lookups.
+     */
+    uint64_t get_hit_count() const noexcept;
+
+    /**
+     *  Get the count of lookups which decoded the prompt.
+     * 
+     *  @return
+     *      The count of lookups.
+     */
+    uint64_t get_miss_count() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    PromptCache(const PromptCache &) = delete;
+    PromptCache &operator=(const PromptCache &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Evict the least recently used prompts of a shard until it fits in 
+     *  its share of the budget (the lock of the shard is held).
+     * 
+     *  @param shard
+     *      The shard.
+     */
+    void evict(struct PromptCacheShard_ *shard) noexcept;
+
+    //
+    //  Members.
+    //
+    struct PromptCacheShard_     *m_shards;
+    size_t                        m_shard_count;
+    xap::audioio::IAllocator     *m_allocator;
+    std::atomic<size_t>           m_budget;
+    std::atomic<size_t>           m_size;
+};
+
+/**
+ *  Source which plays a decoded prompt (see PromptCache).
+ * 
+ *  The source references the audio data of the prompt, read() copies the 
+ *  frames of each period to the output.
+ * 
+ *  @extends ISource
+ */
+class PromptSource: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @param prompt
+     *      The decoded audio data (shared).
+     */
+    explicit PromptSource(const xap::audioio::AudioBuffer &prompt) noexcept;
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~PromptSource() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (less than requested at the end of the 
+     *      prompt).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Seek (on the audio thread, or while the source is not played).
+     * 
+     *  @param frame
+     *      The position (in frames, clamped to the length).
+     */
+    void seek(size_t frame) noexcept;
+
+    /**
+     *  Get the position of the next frame read.
+     * 
+     *  @return
+     *      The position (in frames).
+     */
+    size_t get_position() const noexcept;
+
+    /**
+     *  Get whether all frames were read.
+     * 
+     *  @return
+     *      True if so.
+     */
+    bool is_finished() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    PromptSource(const PromptSource &) = delete;
+    PromptSource &operator=(const PromptSource &) = delete;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioBuffer     m_prompt;
+    size_t                        m_frame_size;
+    std::atomic<size_t>           m_position;
+};
+
+//
+//  Public functions.
+//
+
+/**
+ *  Get the process-wide prompt cache (created with the default options at 
+ *  the first call).
+ * 
+ *  @return
+ *      The prompt cache.
+ */
+xap::audioio::PromptCache &get_default_prompt_cache();
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_PROMPTCACHE_H__
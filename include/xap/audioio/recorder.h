@@ -10,8 +10,13 @@
 //
 //  Imports.
 //
+#include <functional>
+#include <memory>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
 #include <xap/audioio/error.h>
 #include <xap/audioio/device.h>
+#include <xap/audioio/stage.h>
 #include <xap/core/buffer/buffer.h>
 
 namespace xap {
@@ -78,6 +83,56 @@ public:
         std::function<void(const xap::core::buffer::Buffer &)> &callback
     ) = 0;
 
+    /**
+     *  Set frame callback.
+     * 
+     *  The callback receives each captured period as an audio buffer with 
+     *  aligned, pooled storage. The audio buffer (or slices of it) can be 
+     *  retained after the callback returned without copying.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error. 
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    virtual void set_frame_callback(
+        std::function<void(const xap::audioio::AudioBuffer &)> &callback
+    ) = 0;
+
+    /**
+     *  Append a processing stage.
+     * 
+     *  Stages process each captured period in the order they were added 
+     *  before it is passed to the frame callback (the audio callback always 
+     *  receives the unprocessed audio data). Stages run even if no frame 
+     *  callback was set.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The recorder is running.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The stage is nullptr.
+     * 
+     *  @param stage
+     *      The stage.
+     */
+    virtual void add_stage(
+        const std::shared_ptr<xap::audioio::IStage> &stage
+    ) = 0;
+
+    /**
+     *  Remove all processing stages.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the recorder is running 
+     *      (xap::audioio::ERROR_INVALIDOPERATION).
+     */
+    virtual void clear_stages() = 0;
+
     /**
      *  Set error callback.
      * 
@@ -104,6 +159,41 @@ public:
      *      True if forcibly
      */
     virtual void stop(bool forcibly = false) = 0;
+
+    /**
+     *  Pause recorder.
+     * 
+     *  The device stream keeps running, captured audio data is discarded 
+     *  until the recorder was resumed.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The recorder is not running or was already paused.
+     */
+    virtual void pause() = 0;
+
+    /**
+     *  Resume recorder.
+     * 
+     *  The audio callback is invoked again from the next captured period.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The recorder is not running or is not paused.
+     */
+    virtual void resume() = 0;
+
+    /**
+     *  Get whether the recorder is paused.
+     * 
+     *  @return
+     *      True if paused.
+     */
+    virtual bool is_paused() const noexcept = 0;
 };
 
 /**
@@ -116,10 +206,19 @@ public:
     //
 
     /**
-     *  Construct the object.
+     *  Construct the object (with the default allocator).
      */
     RecorderFactory() noexcept;
 
+    /**
+     *  Construct the object.
+     * 
+     *  @param allocator
+     *      The allocator used by all recorders created by the factory (must 
+     *      outlive the recorders).
+     */
+    explicit RecorderFactory(xap::audioio::IAllocator *allocator) noexcept;
+
     /**
      *  Destruct the object.
      */
@@ -211,6 +310,12 @@ public:
      *      The instance.
      */
     void free_instance(xap::audioio::IRecorder **instance);
+
+private:
+    //
+    //  Members.
+    //
+    xap::audioio::IAllocator *m_allocator;
 };
 
 }  //  namespace audioio
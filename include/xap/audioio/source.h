@@ -0,0 +1,64 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_SOURCE_H__
+#define XAP_AUDIOIO_SOURCE_H__
+
+//
+//  Imports.
+//
+#include <stddef.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Classes.
+//
+
+/**
+ *  Interface of all audio source classes.
+ * 
+ *  A source provides the audio data of a player (see IPlayer::set_source()). 
+ *  read() is called on the audio thread, so it must not block or allocate.
+ */
+class ISource {
+public:
+    //
+    //  Destructor.
+    //
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~ISource() noexcept {}
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the source cannot provide audio data in the format of 
+     *      the output (xap::audioio::ERROR_UNSUPPORTED) or other errors.
+     *  @param output
+     *      The output (silence initially), the count of frames requested is 
+     *      the count of frames of the output.
+     *  @return
+     *      The count of frames read, the remaining frames of the output are 
+     *      missing (e.g. not yet received) and are played as silence.
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) = 0;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_SOURCE_H__
@@ -0,0 +1,61 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_STAGE_H__
+#define XAP_AUDIOIO_STAGE_H__
+
+//
+//  Imports.
+//
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Classes.
+//
+
+/**
+ *  Interface of all processing stage classes.
+ * 
+ *  Stages are attached to a pipeline (see IRecorder::add_stage()) and are 
+ *  called in order on the audio thread for each period, so process() must 
+ *  not block or allocate.
+ */
+class IStage {
+public:
+    //
+    //  Destructor.
+    //
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~IStage() noexcept {}
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Process audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the stage cannot process the format of the audio data 
+     *      (xap::audioio::ERROR_UNSUPPORTED) or other errors.
+     *  @param data
+     *      The audio data. The stage either processes it in place or replaces 
+     *      it with its own output (e.g. if the format was changed).
+     */
+    virtual void process(xap::audioio::AudioBuffer &data) = 0;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_STAGE_H__
@@ -0,0 +1,284 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_TONEGENERATOR_H__
+#define XAP_AUDIOIO_TONEGENERATOR_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/source.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Maximum count of segments of a tone sequence.
+const static size_t TONEGENERATOR_MAX_SEGMENTS = 16U;
+
+//  Duration of the amplitude ramps at tone boundaries (in milliseconds).
+const static uint32_t TONEGENERATOR_RAMP_DURATION = 4U;
+
+//
+//  Structures.
+//
+
+/**
+ *  Tone segment: up to 2 tones that are on for 'on_duration', followed by 
+ *  silence for 'off_duration'.
+ */
+typedef struct ToneSegment_ {
+    //  Frequencies (in Hz, 0 if unused).
+    float     frequencies[2];
+
+    //  Amplitudes (linear, 1.0 is full scale).
+    float     levels[2];
+
+    //  Durations (in milliseconds).
+    uint32_t  on_duration;
+    uint32_t  off_duration;
+} ToneSegment;
+
+/**
+ *  Tone sequence (cadence).
+ */
+typedef struct ToneSequence_ {
+    xap::audioio::ToneSegment  
+        segments[xap::audioio::TONEGENERATOR_MAX_SEGMENTS];
+    uint32_t                   segment_count;
+
+    //  Count of repeats of all segments (0 to repeat until stopped).
+    uint32_t                   repeat_count;
+} ToneSequence;
+
+//
+//  Declare.
+//
+struct ToneCommand_;
+struct ToneVoice_;
+template<class T> class MpscQueue;
+
+//
+//  Public functions.
+//
+
+/**
+ *  Build a tone sequence of DTMF digits.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if a digit is invalid or there are too many digits 
+ *      (xap::audioio::ERROR_PARAMETER).
+ *  @param digits
+ *      The digits ('0' - '9', '*', '#', 'A' - 'D').
+ *  @param on_duration
+ *      The duration of each digit (in milliseconds).
+ *  @param off_duration
+ *      The pause after each digit (in milliseconds).
+ *  @param level
+ *      The amplitude of each tone (linear, 1.0 is full scale).
+ *  @return
+ *      The tone sequence (played once).
+ */
+xap::audioio::ToneSequence build_dtmf_sequence(
+    const char *digits,
+    uint32_t    on_duration = 100U,
+    uint32_t    off_duration = 100U,
+    float       level = 0.25F
+);
+
+//
+//  Classes.
+//
+
+/**
+ *  Tone generator source.
+ * 
+ *  Plays tone sequences (call-progress tones, DTMF). Sequences are started 
+ *  and stopped with commands that can be posted from any thread without 
+ *  locking, optionally at an exact frame of the output. Tone boundaries are 
+ *  ramped and a replaced sequence is faded out while the next one starts, 
+ *  so there are no clicks. Oscillators are phase-continuous across reads 
+ *  and render 4 frames per SIMD operation.
+ * 
+ *  @extends ISource
+ */
+class ToneGenerator: public xap::audioio::ISource {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The command capacity is not a power of 2.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              The format is not 16-bit or 32-bit float.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param format
+     *      The audio format (the format of the player).
+     *  @param command_capacity
+     *      The maximum count of pending commands (a power of 2).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    ToneGenerator(
+        const xap::audioio::AudioFormat &format,
+        size_t                           command_capacity = 64U,
+        xap::audioio::IAllocator        *allocator = nullptr
+    );
+
+    /**
+     *  Destruct the object.
+     */
+    virtual ~ToneGenerator() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Play a tone sequence (thread-safe, lock-free), replacing the current 
+     *  one.
+     * 
+     *  Commands are applied in the order they were posted, so their start 
+     *  frames should not decrease.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the sequence is invalid (no segment, too many segments 
+     *      or a segment without duration) (xap::audioio::ERROR_PARAMETER).
+     *  @param sequence
+     *      The tone sequence.
+     *  @param start
+     *      The frame to start at (see get_position(), negative to start 
+     *      immediately).
+     *  @return
+     *      True if posted, false if too many commands are pending.
+     */
+    bool play(const xap::audioio::ToneSequence &sequence, int64_t start = -1);
+
+    /**
+     *  Stop the current tone sequence (thread-safe, lock-free).
+     * 
+     *  @param start
+     *      The frame to stop at (see get_position(), negative to stop 
+     *      immediately).
+     *  @return
+     *      True if posted, false if too many commands are pending.
+     */
+    bool stop(int64_t start = -1) noexcept;
+
+    /**
+     *  Read audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the format of the output mismatched 
+     *      (xap::audioio::ERROR_UNSUPPORTED).
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read (always all frames, silence if no tone 
+     *      is playing).
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override;
+
+    /**
+     *  Get the count of frames generated so far.
+     * 
+     *  @return
+     *      The count.
+     */
+    int64_t get_position() const noexcept;
+
+    /**
+     *  Get whether a tone sequence was playing (or a command was pending) 
+     *  at the end of the last read.
+     * 
+     *  @return
+     *      True if so.
+     */
+    bool is_active() const noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    ToneGenerator(const ToneGenerator &) = delete;
+    ToneGenerator &operator=(const ToneGenerator &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Apply a command.
+     * 
+     *  @param command
+     *      The command.
+     */
+    void apply(const struct ToneCommand_ &command) noexcept;
+
+    /**
+     *  Load the current segment of a voice.
+     * 
+     *  @param voice
+     *      The voice.
+     */
+    void load_segment(struct ToneVoice_ &voice) noexcept;
+
+    /**
+     *  Render a voice (added to the mix).
+     * 
+     *  @param voice
+     *      The voice.
+     *  @param mix
+     *      The mix.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void render(
+        struct ToneVoice_ &voice, 
+        float             *mix, 
+        size_t             frame_count
+    ) noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::AudioFormat                               m_format;
+    double                                                  m_frames_per_ms;
+    size_t                                                  m_ramp_frames;
+    xap::audioio::MpscQueue<struct ToneCommand_>           *m_commands;
+    struct ToneCommand_                                    *m_next;
+    bool                                                    m_has_next;
+    uint8_t                                                 __pad1[7];
+    struct ToneVoice_                                      *m_voices;
+    float                                                  *m_mix;
+    std::atomic<int64_t>                                    m_position;
+    std::atomic<bool>                                       m_is_active;
+    xap::audioio::IAllocator                               *m_allocator;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_TONEGENERATOR_H__
@@ -0,0 +1,220 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+
+#include <atomic>
+#include <stdlib.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/error.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private structures.
+//
+typedef struct AllocatorObjectHeader_ {
+    xap::audioio::IAllocator *allocator;
+    size_t                    size;
+} AllocatorObjectHeader;
+
+//
+//  Private variables.
+//
+static xap::audioio::DefaultAllocator          g_system_allocator;
+static std::atomic<xap::audioio::IAllocator *> g_default_allocator(nullptr);
+
+//
+//  DefaultAllocator constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ */
+DefaultAllocator::DefaultAllocator() noexcept {
+    //  Do nothing.
+}
+
+/**
+ *  Destruct the object.
+ */
+DefaultAllocator::~DefaultAllocator() noexcept {
+    //  Do nothing.
+}
+
+//
+//  DefaultAllocator public methods.
+//
+
+/**
+ *  Allocate memory.
+ * 
+ *  @param size
+ *      The size (in bytes).
+ *  @param alignment
+ *      The alignment (a power of 2).
+ *  @return
+ *      The memory, nullptr if allocation was failed.
+ */
+void *DefaultAllocator::allocate(size_t size, size_t alignment) noexcept {
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+    if (size == 0U) {
+        size = alignment;
+    }
+
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void *pointer = nullptr;
+    if (posix_memalign(&pointer, alignment, size) != 0) {
+        return nullptr;
+    }
+    return pointer;
+#endif
+}
+
+/**
+ *  Deallocate memory.
+ * 
+ *  @param pointer
+ *      The memory returned by allocate().
+ *  @param size
+ *      The size that was passed to allocate().
+ *  @param alignment
+ *      The alignment that was passed to allocate().
+ */
+void DefaultAllocator::deallocate(
+    void   *pointer, 
+    size_t  size, 
+    size_t  alignment
+) noexcept {
+    (void)size;
+    (void)alignment;
+
+#if defined(_WIN32)
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Get the default allocator.
+ * 
+ *  @return
+ *      The allocator set by set_default_allocator(), or the system allocator 
+ *      (xap::audioio::DefaultAllocator) if not set.
+ */
+xap::audioio::IAllocator *get_default_allocator() noexcept {
+    xap::audioio::IAllocator *allocator = g_default_allocator.load();
+    if (allocator == nullptr) {
+        return &g_system_allocator;
+    }
+    return allocator;
+}
+
+/**
+ *  Set the default allocator.
+ * 
+ *  @param allocator
+ *      The allocator, nullptr to restore the system allocator.
+ */
+void set_default_allocator(xap::audioio::IAllocator *allocator) noexcept {
+    g_default_allocator.store(allocator);
+}
+
+/**
+ *  Resolve an allocator.
+ * 
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ *  @return
+ *      The allocator.
+ */
+xap::audioio::IAllocator *resolve_allocator(
+    xap::audioio::IAllocator *allocator
+) noexcept {
+    if (allocator == nullptr) {
+        return xap::audioio::get_default_allocator();
+    }
+    return allocator;
+}
+
+/**
+ *  Allocate memory for an object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed (xap::audioio::ERROR_ALLOC).
+ *  @param allocator
+ *      The allocator.
+ *  @param size
+ *      The size of the object.
+ *  @return
+ *      The memory (aligned to ALLOCATOR_OBJECT_HEADER_SIZE).
+ */
+void *allocate_object(xap::audioio::IAllocator *allocator, size_t size) {
+    static_assert(
+        sizeof(AllocatorObjectHeader) <= ALLOCATOR_OBJECT_HEADER_SIZE,
+        "Object header is too large."
+    );
+
+    size_t total = size + ALLOCATOR_OBJECT_HEADER_SIZE;
+    uint8_t *base = static_cast<uint8_t *>(
+        allocator->allocate(total, ALLOCATOR_OBJECT_HEADER_SIZE)
+    );
+    if (base == nullptr) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+
+    AllocatorObjectHeader *header = 
+        reinterpret_cast<AllocatorObjectHeader *>(base);
+    header->allocator = allocator;
+    header->size = total;
+
+    return base + ALLOCATOR_OBJECT_HEADER_SIZE;
+}
+
+/**
+ *  Release memory allocated by allocate_object().
+ * 
+ *  @param pointer
+ *      The memory.
+ */
+void free_object(void *pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    uint8_t *base = static_cast<uint8_t *>(pointer) - 
+                    ALLOCATOR_OBJECT_HEADER_SIZE;
+    AllocatorObjectHeader *header = 
+        reinterpret_cast<AllocatorObjectHeader *>(base);
+    header->allocator->deallocate(
+        base, 
+        header->size, 
+        ALLOCATOR_OBJECT_HEADER_SIZE
+    );
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,98 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_ALLOCATOR_P_H__
+#define XAP_AUDIOIO_ALLOCATOR_P_H__
+
+//
+//  Imports.
+//
+#include <new>
+#include <stddef.h>
+#include <utility>
+#include <xap/audioio/allocator.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+
+//  Size of the header placed before each object allocated by 
+//  allocate_object() (also the alignment of the object).
+const static size_t ALLOCATOR_OBJECT_HEADER_SIZE = 64U;
+
+//
+//  Public functions.
+//
+
+/**
+ *  Resolve an allocator.
+ * 
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ *  @return
+ *      The allocator.
+ */
+xap::audioio::IAllocator *resolve_allocator(
+    xap::audioio::IAllocator *allocator
+) noexcept;
+
+/**
+ *  Allocate memory for an object.
+ * 
+ *  The allocator is recorded in a header before the object so that the 
+ *  memory can be released by free_object() (usually from the class-specific 
+ *  'operator delete').
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed (xap::audioio::ERROR_ALLOC).
+ *  @param allocator
+ *      The allocator.
+ *  @param size
+ *      The size of the object.
+ *  @return
+ *      The memory (aligned to ALLOCATOR_OBJECT_HEADER_SIZE).
+ */
+void *allocate_object(xap::audioio::IAllocator *allocator, size_t size);
+
+/**
+ *  Release memory allocated by allocate_object().
+ * 
+ *  @param pointer
+ *      The memory.
+ */
+void free_object(void *pointer) noexcept;
+
+/**
+ *  Allocate and construct an object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed (xap::audioio::ERROR_ALLOC) or 
+ *      the constructor raised.
+ *  @param allocator
+ *      The allocator.
+ *  @param args
+ *      The arguments of the constructor.
+ *  @return
+ *      The object.
+ */
+template<class T, class... Args>
+T *new_object(xap::audioio::IAllocator *allocator, Args&&... args) {
+    void *pointer = xap::audioio::allocate_object(allocator, sizeof(T));
+    try {
+        return ::new (pointer) T(std::forward<Args>(args)...);
+    } catch (...) {
+        xap::audioio::free_object(pointer);
+        throw;
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_ALLOCATOR_P_H__
@@ -0,0 +1,900 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <new>
+#include <string.h>
+#include <xap/audioio/audiobuffer.h>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Index of no block (end of the free list).
+const static uint32_t AUDIOBUFFER_NOBLOCK = 0xFFFFFFFFU;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Storage block (header, followed by the aligned sample storage).
+ */
+typedef struct AudioBufferBlock_ {
+    std::atomic<uint32_t>          references;
+    std::atomic<uint32_t>          next;
+    struct AudioBufferPoolCore_   *pool;
+    xap::audioio::IAllocator      *allocator;
+    size_t                         capacity;
+    size_t                         allocated_size;
+    uint32_t                       index;
+} AudioBufferBlock;
+
+/**
+ *  Pool core (header, followed by the blocks).
+ */
+typedef struct AudioBufferPoolCore_ {
+    std::atomic<uint64_t>          free_head;
+    std::atomic<size_t>            references;
+    std::atomic<size_t>            available;
+    xap::audioio::IAllocator      *allocator;
+    size_t                         block_size;
+    size_t                         block_stride;
+    size_t                         block_count;
+    size_t                         allocated_size;
+} AudioBufferPoolCore;
+
+static_assert(
+    sizeof(AudioBufferBlock) <= xap::audioio::AUDIOBUFFER_ALIGNMENT,
+    "Block header is too large."
+);
+static_assert(
+    sizeof(AudioBufferPoolCore) <= xap::audioio::AUDIOBUFFER_ALIGNMENT,
+    "Pool header is too large."
+);
+
+//
+//  Private functions.
+//
+
+/**
+ *  Round up the size to the alignment.
+ * 
+ *  @param size
+ *      The size.
+ *  @return
+ *      The aligned size.
+ */
+static inline size_t align_size(size_t size) noexcept {
+    return (size + xap::audioio::AUDIOBUFFER_ALIGNMENT - 1U) & 
+           ~(xap::audioio::AUDIOBUFFER_ALIGNMENT - 1U);
+}
+
+/**
+ *  Get the sample storage of a block.
+ * 
+ *  @param block
+ *      The block.
+ *  @return
+ *      The storage.
+ */
+static inline uint8_t *block_get_storage(AudioBufferBlock *block) noexcept {
+    return reinterpret_cast<uint8_t *>(block) + 
+           xap::audioio::AUDIOBUFFER_ALIGNMENT;
+}
+
+/**
+ *  Get a block of a pool.
+ * 
+ *  @param core
+ *      The pool core.
+ *  @param index
+ *      The index of the block.
+ *  @return
+ *      The block.
+ */
+static inline AudioBufferBlock *pool_get_block(
+    AudioBufferPoolCore *core, 
+    uint32_t             index
+) noexcept {
+    return reinterpret_cast<AudioBufferBlock *>(
+        reinterpret_cast<uint8_t *>(core) + 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT + 
+        static_cast<size_t>(index) * core->block_stride
+    );
+}
+
+/**
+ *  Release a reference of a pool core (and release the memory if it was the 
+ *  last reference).
+ * 
+ *  @param core
+ *      The pool core.
+ */
+static void pool_release(AudioBufferPoolCore *core) noexcept {
+    if (core->references.fetch_sub(1U, std::memory_order_acq_rel) == 1U) {
+        xap::audioio::IAllocator *allocator = core->allocator;
+        size_t allocated_size = core->allocated_size;
+        core->~AudioBufferPoolCore();
+        allocator->deallocate(
+            core, 
+            allocated_size, 
+            xap::audioio::AUDIOBUFFER_ALIGNMENT
+        );
+    }
+}
+
+/**
+ *  Pop a block from the free list of a pool (lock-free).
+ * 
+ *  @param core
+ *      The pool core.
+ *  @return
+ *      The block, nullptr if no block is available.
+ */
+static AudioBufferBlock *pool_pop(AudioBufferPoolCore *core) noexcept {
+    uint64_t head = core->free_head.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t index = static_cast<uint32_t>(head & 0xFFFFFFFFU);
+        if (index == AUDIOBUFFER_NOBLOCK) {
+            return nullptr;
+        }
+
+        AudioBufferBlock *block = pool_get_block(core, index);
+        uint32_t next = block->next.load(std::memory_order_relaxed);
+
+        //  The tag (high 32 bits) prevents the ABA problem.
+        uint64_t tag = (head >> 32) + 1U;
+        uint64_t desired = (tag << 32) | static_cast<uint64_t>(next);
+        if (core->free_head.compare_exchange_weak(
+            head, 
+            desired, 
+            std::memory_order_acq_rel,
+            std::memory_order_acquire
+        )) {
+            core->available.fetch_sub(1U, std::memory_order_relaxed);
+            return block;
+        }
+    }
+}
+
+/**
+ *  Push a block to the free list of a pool (lock-free).
+ * 
+ *  @param core
+ *      The pool core.
+ *  @param block
+ *      The block.
+ */
+static void pool_push(
+    AudioBufferPoolCore *core, 
+    AudioBufferBlock    *block
+) noexcept {
+    uint64_t head = core->free_head.load(std::memory_order_acquire);
+    while (true) {
+        block->next.store(
+            static_cast<uint32_t>(head & 0xFFFFFFFFU),
+            std::memory_order_relaxed
+        );
+        uint64_t tag = (head >> 32) + 1U;
+        uint64_t desired = (tag << 32) | static_cast<uint64_t>(block->index);
+        if (core->free_head.compare_exchange_weak(
+            head, 
+            desired, 
+            std::memory_order_acq_rel,
+            std::memory_order_acquire
+        )) {
+            core->available.fetch_add(1U, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+/**
+ *  Release a reference of a block (and return it to its pool or release its 
+ *  memory if it was the last reference).
+ * 
+ *  @param block
+ *      The block.
+ */
+static void block_release(AudioBufferBlock *block) noexcept {
+    if (block->references.fetch_sub(1U, std::memory_order_acq_rel) != 1U) {
+        return;
+    }
+
+    if (block->pool != nullptr) {
+        AudioBufferPoolCore *core = block->pool;
+        pool_push(core, block);
+        pool_release(core);
+    } else {
+        xap::audioio::IAllocator *allocator = block->allocator;
+        size_t allocated_size = block->allocated_size;
+        block->~AudioBufferBlock();
+        allocator->deallocate(
+            block, 
+            allocated_size, 
+            xap::audioio::AUDIOBUFFER_ALIGNMENT
+        );
+    }
+}
+
+/**
+ *  Assert the audio format is valid.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format is invalid (xap::audioio::ERROR_PARAMETER).
+ *  @param format
+ *      The audio format.
+ */
+static void assert_format(const xap::audioio::AudioFormat &format) {
+    if (xap::audioio::get_sample_size(format.sample_format) == 0U || 
+        format.channel_count == 0U) {
+        throw xap::audioio::Exception(
+            "Invalid audio format.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Get the size of one sample.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @return
+ *      The size (in bytes), 0 if the format is unknown.
+ */
+size_t get_sample_size(xap::audioio::SampleFormat sample_format) noexcept {
+    switch (sample_format) {
+    case xap::audioio::SAMPLEFORMAT_ULAW:
+    case xap::audioio::SAMPLEFORMAT_ALAW:
+        return 1U;
+    case xap::audioio::SAMPLEFORMAT_INT16:
+        return 2U;
+    case xap::audioio::SAMPLEFORMAT_INT32:
+    case xap::audioio::SAMPLEFORMAT_FLOAT32:
+        return 4U;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ *  Get the size of one frame.
+ * 
+ *  @param format
+ *      The audio format.
+ *  @return
+ *      The size (in bytes).
+ */
+size_t get_frame_size(const xap::audioio::AudioFormat &format) noexcept {
+    return xap::audioio::get_sample_size(format.sample_format) * 
+           static_cast<size_t>(format.channel_count);
+}
+
+//
+//  AudioBufferPool constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              block_size == 0 or block_count == 0.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param block_size
+ *      The size of each block (in bytes).
+ *  @param block_count
+ *      The count of blocks.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+AudioBufferPool::AudioBufferPool(
+    size_t                    block_size,
+    size_t                    block_count,
+    xap::audioio::IAllocator *allocator
+) :
+    m_core(nullptr)
+{
+    if (block_size == 0U || block_count == 0U || 
+        block_count >= static_cast<size_t>(AUDIOBUFFER_NOBLOCK)) {
+        throw xap::audioio::Exception(
+            "Invalid block size or block count.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    size_t block_stride = xap::audioio::AUDIOBUFFER_ALIGNMENT + 
+                          align_size(block_size);
+    size_t allocated_size = xap::audioio::AUDIOBUFFER_ALIGNMENT + 
+                            block_stride * block_count;
+    void *memory = allocator->allocate(
+        allocated_size, 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT
+    );
+    if (memory == nullptr) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+
+    AudioBufferPoolCore *core = new (memory) AudioBufferPoolCore();
+    core->free_head.store(static_cast<uint64_t>(AUDIOBUFFER_NOBLOCK));
+    core->references.store(1U);
+    core->available.store(0U);
+    core->allocator = allocator;
+    core->block_size = block_size;
+    core->block_stride = block_stride;
+    core->block_count = block_count;
+    core->allocated_size = allocated_size;
+
+    for (size_t i = block_count; i > 0U; --i) {
+        uint32_t index = static_cast<uint32_t>(i - 1U);
+        AudioBufferBlock *block = 
+            new (pool_get_block(core, index)) AudioBufferBlock();
+        block->references.store(0U);
+        block->pool = core;
+        block->allocator = allocator;
+        block->capacity = block_size;
+        block->allocated_size = 0U;
+        block->index = index;
+        pool_push(core, block);
+    }
+
+    this->m_core = core;
+}
+
+/**
+ *  Destruct the object.
+ */
+AudioBufferPool::~AudioBufferPool() noexcept {
+    pool_release(this->m_core);
+}
+
+//
+//  AudioBufferPool public methods.
+//
+
+/**
+ *  Get the size of each block.
+ * 
+ *  @return
+ *      The size (in bytes).
+ */
+size_t AudioBufferPool::get_block_size() const noexcept {
+    return this->m_core->block_size;
+}
+
+/**
+ *  Get the count of available (not acquired) blocks.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t AudioBufferPool::get_available_count() const noexcept {
+    return this->m_core->available.load(std::memory_order_relaxed);
+}
+
+//
+//  AudioBuffer constructor & destructor.
+//
+
+/**
+ *  Construct an empty object.
+ */
+AudioBuffer::AudioBuffer() noexcept :
+    m_block(nullptr),
+    m_pointer(nullptr),
+    m_frame_count(0U),
+    m_timestamp(0),
+    m_format()
+{}
+
+/**
+ *  Construct (Copy) the object (shares the storage).
+ * 
+ *  @param src
+ *      The source object.
+ */
+AudioBuffer::AudioBuffer(const xap::audioio::AudioBuffer &src) noexcept :
+    m_block(src.m_block),
+    m_pointer(src.m_pointer),
+    m_frame_count(src.m_frame_count),
+    m_timestamp(src.m_timestamp),
+    m_format(src.m_format)
+{
+    if (this->m_block != nullptr) {
+        this->m_block->references.fetch_add(1U, std::memory_order_relaxed);
+    }
+}
+
+/**
+ *  Construct (Move) the object.
+ * 
+ *  @param src
+ *      The source object.
+ */
+AudioBuffer::AudioBuffer(xap::audioio::AudioBuffer &&src) noexcept :
+    m_block(src.m_block),
+    m_pointer(src.m_pointer),
+    m_frame_count(src.m_frame_count),
+    m_timestamp(src.m_timestamp),
+    m_format(src.m_format)
+{
+    src.m_block = nullptr;
+    src.m_pointer = nullptr;
+    src.m_frame_count = 0U;
+}
+
+/**
+ *  Destruct the object.
+ */
+AudioBuffer::~AudioBuffer() noexcept {
+    this->release();
+}
+
+//
+//  AudioBuffer operators.
+//
+xap::audioio::AudioBuffer &AudioBuffer::operator=(
+    const xap::audioio::AudioBuffer &src
+) noexcept {
+    if (this != &src) {
+        if (src.m_block != nullptr) {
+            src.m_block->references.fetch_add(1U, std::memory_order_relaxed);
+        }
+        this->release();
+        this->m_block = src.m_block;
+        this->m_pointer = src.m_pointer;
+        this->m_frame_count = src.m_frame_count;
+        this->m_timestamp = src.m_timestamp;
+        this->m_format = src.m_format;
+    }
+    return *this;
+}
+
+xap::audioio::AudioBuffer &AudioBuffer::operator=(
+    xap::audioio::AudioBuffer &&src
+) noexcept {
+    if (this != &src) {
+        this->release();
+        this->m_block = src.m_block;
+        this->m_pointer = src.m_pointer;
+        this->m_frame_count = src.m_frame_count;
+        this->m_timestamp = src.m_timestamp;
+        this->m_format = src.m_format;
+        src.m_block = nullptr;
+        src.m_pointer = nullptr;
+        src.m_frame_count = 0U;
+    }
+    return *this;
+}
+
+//
+//  AudioBuffer public static methods.
+//
+
+/**
+ *  Allocate an audio buffer from a pool.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The frames do not fit in a block of the pool or the 
+ *              format is invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              No block is available in the pool.
+ * 
+ *  @param pool
+ *      The pool.
+ *  @param format
+ *      The audio format.
+ *  @param frame_count
+ *      The count of frames.
+ *  @return
+ *      The audio buffer (the content is not initialized).
+ */
+xap::audioio::AudioBuffer AudioBuffer::allocate(
+    xap::audioio::AudioBufferPool     &pool,
+    const xap::audioio::AudioFormat   &format,
+    size_t                             frame_count
+) {
+    assert_format(format);
+
+    AudioBufferPoolCore *core = pool.m_core;
+    if (frame_count * xap::audioio::get_frame_size(format) > 
+        core->block_size) {
+        throw xap::audioio::Exception(
+            "The frames do not fit in a block of the pool.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    AudioBufferBlock *block = pool_pop(core);
+    if (block == nullptr) {
+        throw xap::audioio::Exception(
+            "No block is available in the pool.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+    core->references.fetch_add(1U, std::memory_order_relaxed);
+    block->references.store(1U, std::memory_order_relaxed);
+
+    xap::audioio::AudioBuffer rst;
+    rst.m_block = block;
+    rst.m_pointer = block_get_storage(block);
+    rst.m_frame_count = frame_count;
+    rst.m_format = format;
+    return rst;
+}
+
+/**
+ *  Allocate an audio buffer with dedicated storage.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format is invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param format
+ *      The audio format.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ *  @return
+ *      The audio buffer (the content is not initialized).
+ */
+xap::audioio::AudioBuffer AudioBuffer::allocate(
+    const xap::audioio::AudioFormat   &format,
+    size_t                             frame_count,
+    xap::audioio::IAllocator          *allocator
+) {
+    assert_format(format);
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    size_t capacity = frame_count * xap::audioio::get_frame_size(format);
+    size_t allocated_size = xap::audioio::AUDIOBUFFER_ALIGNMENT + 
+                            align_size(capacity);
+    void *memory = allocator->allocate(
+        allocated_size, 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT
+    );
+    if (memory == nullptr) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+
+    AudioBufferBlock *block = new (memory) AudioBufferBlock();
+    block->references.store(1U, std::memory_order_relaxed);
+    block->pool = nullptr;
+    block->allocator = allocator;
+    block->capacity = capacity;
+    block->allocated_size = allocated_size;
+    block->index = AUDIOBUFFER_NOBLOCK;
+
+    xap::audioio::AudioBuffer rst;
+    rst.m_block = block;
+    rst.m_pointer = block_get_storage(block);
+    rst.m_frame_count = frame_count;
+    rst.m_format = format;
+    return rst;
+}
+
+/**
+ *  Wrap external memory (without copying).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format is invalid (xap::audioio::ERROR_PARAMETER).
+ *  @param pointer
+ *      The memory.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param format
+ *      The audio format.
+ *  @return
+ *      The audio buffer.
+ */
+xap::audioio::AudioBuffer AudioBuffer::wrap(
+    void                            *pointer,
+    size_t                           frame_count,
+    const xap::audioio::AudioFormat &format
+) {
+    assert_format(format);
+
+    xap::audioio::AudioBuffer rst;
+    rst.m_pointer = static_cast<uint8_t *>(pointer);
+    rst.m_frame_count = frame_count;
+    rst.m_format = format;
+    return rst;
+}
+
+/**
+ *  Wrap a buffer (without copying).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format is invalid or the length of the buffer is not 
+ *      a multiple of frame size (xap::audioio::ERROR_PARAMETER).
+ *  @param buffer
+ *      The buffer.
+ *  @param format
+ *      The audio format.
+ *  @return
+ *      The audio buffer.
+ */
+xap::audioio::AudioBuffer AudioBuffer::wrap(
+    xap::core::buffer::Buffer       &buffer,
+    const xap::audioio::AudioFormat &format
+) {
+    assert_format(format);
+
+    size_t frame_size = xap::audioio::get_frame_size(format);
+    if (buffer.get_length() % frame_size != 0U) {
+        throw xap::audioio::Exception(
+            "The length of the buffer is not a multiple of frame size.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    return xap::audioio::AudioBuffer::wrap(
+        buffer.get_pointer(), 
+        buffer.get_length() / frame_size, 
+        format
+    );
+}
+
+//
+//  AudioBuffer public methods.
+//
+
+/**
+ *  Get a slice (shares the storage).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the range is out of the buffer 
+ *      (xap::audioio::ERROR_PARAMETER).
+ *  @param frame_offset
+ *      The offset of the first frame.
+ *  @param frame_count
+ *      The count of frames.
+ *  @return
+ *      The slice (the timestamp is adjusted by the offset).
+ */
+xap::audioio::AudioBuffer AudioBuffer::slice(
+    size_t frame_offset, 
+    size_t frame_count
+) const {
+    if (frame_offset > this->m_frame_count || 
+        frame_count > this->m_frame_count - frame_offset) {
+        throw xap::audioio::Exception(
+            "The range is out of the buffer.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::AudioBuffer rst(*this);
+    rst.m_pointer += frame_offset * xap::audioio::get_frame_size(this->m_format);
+    rst.m_frame_count = frame_count;
+    rst.m_timestamp += static_cast<int64_t>(frame_offset);
+    return rst;
+}
+
+/**
+ *  Copy to a new buffer.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed 
+ *      (xap::audioio::ERROR_ALLOC).
+ *  @return
+ *      The buffer.
+ */
+xap::core::buffer::Buffer AudioBuffer::to_buffer() const {
+    try {
+        return xap::core::buffer::Buffer(this->m_pointer, this->get_length());
+    } catch (xap::core::buffer::BufferException &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_ALLOC
+        );
+    } catch (std::bad_alloc &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+}
+
+/**
+ *  Get whether the buffer is empty (references no storage).
+ * 
+ *  @return
+ *      True if empty.
+ */
+bool AudioBuffer::is_empty() const noexcept {
+    return this->m_pointer == nullptr;
+}
+
+/**
+ *  Get whether the storage is referenced by this buffer only (or is not 
+ *  owned by the buffer).
+ * 
+ *  @return
+ *      True if unique.
+ */
+bool AudioBuffer::is_unique() const noexcept {
+    return this->m_block == nullptr || 
+           this->m_block->references.load(std::memory_order_acquire) == 1U;
+}
+
+/**
+ *  Get the pointer of the first frame.
+ * 
+ *  @return
+ *      The pointer.
+ */
+uint8_t *AudioBuffer::get_pointer() const noexcept {
+    return this->m_pointer;
+}
+
+/**
+ *  Get the length.
+ * 
+ *  @return
+ *      The length (in bytes).
+ */
+size_t AudioBuffer::get_length() const noexcept {
+    return this->m_frame_count * xap::audioio::get_frame_size(this->m_format);
+}
+
+/**
+ *  Get the count of frames.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t AudioBuffer::get_frame_count() const noexcept {
+    return this->m_frame_count;
+}
+
+/**
+ *  Get the count of samples (frames * channels).
+ * 
+ *  @return
+ *      The count.
+ */
+size_t AudioBuffer::get_sample_count() const noexcept {
+    return this->m_frame_count * 
+           static_cast<size_t>(this->m_format.channel_count);
+}
+
+/**
+ *  Get the audio format.
+ * 
+ *  @return
+ *      The audio format.
+ */
+const xap::audioio::AudioFormat &AudioBuffer::get_format() const noexcept {
+    return this->m_format;
+}
+
+/**
+ *  Get the sample format.
+ * 
+ *  @return
+ *      The sample format.
+ */
+xap::audioio::SampleFormat AudioBuffer::get_sample_format() const noexcept {
+    return this->m_format.sample_format;
+}
+
+/**
+ *  Get the count of channels.
+ * 
+ *  @return
+ *      The count.
+ */
+uint8_t AudioBuffer::get_channel_count() const noexcept {
+    return this->m_format.channel_count;
+}
+
+/**
+ *  Get the sample rate.
+ * 
+ *  @return
+ *      The sample rate (in Hz).
+ */
+uint32_t AudioBuffer::get_sample_rate() const noexcept {
+    return this->m_format.sample_rate;
+}
+
+/**
+ *  Get the timestamp.
+ * 
+ *  @return
+ *      The position of the first frame in the stream (in frames).
+ */
+int64_t AudioBuffer::get_timestamp() const noexcept {
+    return this->m_timestamp;
+}
+
+/**
+ *  Set the timestamp.
+ * 
+ *  @param timestamp
+ *      The position of the first frame in the stream (in frames).
+ */
+void AudioBuffer::set_timestamp(int64_t timestamp) noexcept {
+    this->m_timestamp = timestamp;
+}
+
+/**
+ *  Truncate the buffer (keeps the storage).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if frame_count is larger than the count of frames 
+ *      (xap::audioio::ERROR_PARAMETER).
+ *  @param frame_count
+ *      The new count of frames.
+ */
+void AudioBuffer::truncate(size_t frame_count) {
+    if (frame_count > this->m_frame_count) {
+        throw xap::audioio::Exception(
+            "frame_count is larger than the count of frames.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    this->m_frame_count = frame_count;
+}
+
+//
+//  AudioBuffer private methods.
+//
+
+/**
+ *  Release the reference of the storage.
+ */
+void AudioBuffer::release() noexcept {
+    if (this->m_block != nullptr) {
+        block_release(this->m_block);
+        this->m_block = nullptr;
+    }
+    this->m_pointer = nullptr;
+    this->m_frame_count = 0U;
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,2025 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fir_p.h"
+#include "worker_p.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/audiofile.h>
+#include <xap/audioio/g711.h>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double AUDIOFILE_PI = 3.14159265358979323846;
+
+//  Count of frames converted per pass.
+const static size_t AUDIOFILE_CHUNK_FRAMES = 256U;
+
+//  Resampler: count of phases of the coefficient table (interpolated 
+//  linearly), half of the count of taps (when upsampling, scaled by the 
+//  ratio when downsampling) and the pass band (relative to the Nyquist 
+//  frequency of the lower rate).
+const static size_t AUDIOFILE_RESAMPLER_PHASES = 64U;
+const static size_t AUDIOFILE_RESAMPLER_HALF_TAPS = 16U;
+const static double AUDIOFILE_RESAMPLER_BANDWIDTH = 0.9;
+
+//  Seek index chunk: a header (version, granularity) and entries (frame, 
+//  time, offset), little-endian.
+const static uint32_t AUDIOFILE_INDEX_VERSION = 1U;
+const static uint64_t AUDIOFILE_INDEX_HEADER_SIZE = 8U;
+const static uint64_t AUDIOFILE_INDEX_ENTRY_SIZE = 24U;
+
+//  Trim map chunk: a header (version) and entries (frame, source frame), 
+//  little-endian.
+const static uint32_t AUDIOFILE_TRIM_VERSION = 1U;
+const static uint64_t AUDIOFILE_TRIM_HEADER_SIZE = 4U;
+const static uint64_t AUDIOFILE_TRIM_ENTRY_SIZE = 16U;
+
+//  Poll interval of the prefetch thread.
+const static std::chrono::milliseconds AUDIOFILE_PREFETCH_TIMEOUT(10);
+
+//
+//  Private classes.
+//
+
+/**
+ *  Task of the prefetch thread (a friend of the reader).
+ */
+class AudioFilePrefetcher {
+public:
+    /**
+     *  Serve the pending seek and fill the ring buffer of a reader.
+     * 
+     *  @param reader
+     *      The reader.
+     */
+    static void prefetch(void *reader) noexcept {
+        static_cast<xap::audioio::AudioFileReader *>(reader)->prefetch();
+    }
+};
+//
+//  Private functions.
+//
+
+/**
+ *  Get the prefetch thread (reads the audio data of all readers).
+ * 
+ *  @return
+ *      The prefetch thread.
+ */
+static xap::audioio::Worker &get_prefetcher() noexcept {
+    static xap::audioio::Worker prefetcher(
+        &AudioFilePrefetcher::prefetch,
+        AUDIOFILE_PREFETCH_TIMEOUT
+    );
+    return prefetcher;
+}
+
+/**
+ *  Load unsigned integers (of either byte order).
+ * 
+ *  @param p
+ *      The bytes.
+ *  @return
+ *      The integer.
+ */
+static inline uint16_t load_u16_le(const uint8_t *p) noexcept {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+static inline uint16_t load_u16_be(const uint8_t *p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+static inline uint32_t load_u32_le(const uint8_t *p) noexcept {
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+static inline uint32_t load_u32_be(const uint8_t *p) noexcept {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) |
+           static_cast<uint32_t>(p[3]);
+}
+static inline uint64_t load_u64_be(const uint8_t *p) noexcept {
+    return (static_cast<uint64_t>(load_u32_be(p)) << 32) |
+           static_cast<uint64_t>(load_u32_be(p + 4));
+}
+static inline uint64_t load_u64_le(const uint8_t *p) noexcept {
+    return (static_cast<uint64_t>(load_u32_le(p + 4)) << 32) |
+           static_cast<uint64_t>(load_u32_le(p));
+}
+
+/**
+ *  Parse an 80-bit IEEE extended float (big-endian, AIFF sample rates).
+ * 
+ *  @param p
+ *      The bytes.
+ *  @return
+ *      The value.
+ */
+static double load_extended(const uint8_t *p) noexcept {
+    int exponent = ((p[0] & 0x7F) << 8) | p[1];
+    uint64_t mantissa = load_u64_be(p + 2);
+    if (exponent == 0 && mantissa == 0U) {
+        return 0.0;
+    }
+    double value = ldexp(static_cast<double>(mantissa), exponent - 16383 - 63);
+    return (p[0] & 0x80) != 0 ? -value : value;
+}
+
+/**
+ *  Check whether the host is little-endian.
+ * 
+ *  @return
+ *      True if so.
+ */
+static bool is_little_endian_host() noexcept {
+    uint16_t probe = 1U;
+    uint8_t first;
+    memcpy(&first, &probe, 1U);
+    return first == 1U;
+}
+
+/**
+ *  Seek a file.
+ * 
+ *  @param file
+ *      The file.
+ *  @param offset
+ *      The offset (in bytes).
+ *  @return
+ *      True if succeed.
+ */
+static bool seek_file(FILE *file, uint64_t offset) noexcept {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+/**
+ *  Get the size of a file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file cannot be read (xap::audioio::ERROR_IO).
+ *  @param file
+ *      The file.
+ *  @return
+ *      The size (in bytes).
+ */
+static uint64_t get_file_size(FILE *file) {
+#if defined(_WIN32)
+    if (_fseeki64(file, 0, SEEK_END) == 0) {
+        __int64 size = _ftelli64(file);
+        if (size >= 0) {
+            return static_cast<uint64_t>(size);
+        }
+    }
+#else
+    if (fseeko(file, 0, SEEK_END) == 0) {
+        off_t size = ftello(file);
+        if (size >= 0) {
+            return static_cast<uint64_t>(size);
+        }
+    }
+#endif
+    throw xap::audioio::Exception(
+        "Cannot read the audio file.",
+        xap::audioio::ERROR_IO
+    );
+}
+
+/**
+ *  Read bytes of a file (a header structure).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file is truncated (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param file
+ *      The file.
+ *  @param offset
+ *      The offset (in bytes).
+ *  @param buffer
+ *      The buffer (output).
+ *  @param size
+ *      The count of bytes.
+ */
+static void read_header(
+    FILE      *file,
+    uint64_t   offset,
+    uint8_t   *buffer,
+    size_t     size
+) {
+    if (!seek_file(file, offset) || fread(buffer, 1U, size, file) != size) {
+        throw xap::audioio::Exception(
+            "The audio file is truncated.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+}
+
+/**
+ *  Throw an exception for a malformed or unsupported file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Always (xap::audioio::ERROR_UNSUPPORTED).
+ */
+static void throw_unsupported() {
+    throw xap::audioio::Exception(
+        "The audio file is malformed or not supported.",
+        xap::audioio::ERROR_UNSUPPORTED
+    );
+}
+
+/**
+ *  Parse the chunks of a WAV (or RF64) file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file is malformed or not supported 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param file
+ *      The file.
+ *  @param file_size
+ *      The size of the file.
+ *  @param info
+ *      The information (output).
+ *  @return
+ *      The size of the audio data (in bytes).
+ */
+static uint64_t parse_wav(
+    FILE                         *file,
+    uint64_t                      file_size,
+    xap::audioio::AudioFileInfo  &info
+) {
+    bool has_format = false;
+    bool has_data = false;
+    uint64_t data_size = 0U;
+    uint64_t data_size64 = UINT64_MAX;
+    uint64_t offset = 12U;
+    while (offset + 8U <= file_size) {
+        uint8_t header[8];
+        read_header(file, offset, header, 8U);
+        uint64_t size = load_u32_le(header + 4);
+        uint64_t body = offset + 8U;
+        if (has_data) {
+            //  Only the seek index and the trim map (written after it) are 
+            //  looked for after the audio data (a partially written file 
+            //  may end with garbage).
+            if (body + size > file_size) {
+                break;
+            }
+            if (memcmp(header, "xidx", 4U) == 0) {
+                info.index_offset = body;
+                info.index_size = size;
+            } else if (memcmp(header, "xtrm", 4U) == 0) {
+                info.trim_offset = body;
+                info.trim_size = size;
+                break;
+            }
+        } else if (memcmp(header, "ds64", 4U) == 0) {
+            uint8_t sizes[16];
+            if (size < 16U) {
+                throw_unsupported();
+            }
+            read_header(file, body, sizes, 16U);
+            data_size64 = load_u64_le(sizes + 8);
+        } else if (memcmp(header, "fmt ", 4U) == 0) {
+            uint8_t format[40];
+            if (size < 16U) {
+                throw_unsupported();
+            }
+            read_header(file, body, format, size < 40U ? 16U : 40U);
+            uint32_t code = load_u16_le(format);
+            if (code == 0xFFFEU) {
+                if (size < 40U) {
+                    throw_unsupported();
+                }
+                code = load_u16_le(format + 24);
+            }
+            if (code != 1U && code != 3U && code != 6U && code != 7U) {
+                throw_unsupported();
+            }
+            info.channel_count = load_u16_le(format + 2);
+            info.sample_rate = load_u32_le(format + 4);
+            info.bits_per_sample = load_u16_le(format + 14);
+            info.is_float = (code == 3U);
+            info.is_big_endian = false;
+            info.is_alaw = (code == 6U);
+            info.is_ulaw = (code == 7U);
+            info.is_unsigned = (code == 1U && info.bits_per_sample == 8U);
+            if (load_u16_le(format + 12) != 
+                    info.channel_count * (info.bits_per_sample / 8U)) {
+                throw_unsupported();
+            }
+            has_format = true;
+        } else if (memcmp(header, "data", 4U) == 0) {
+            if (!has_format) {
+                throw_unsupported();
+            }
+            if (size == 0xFFFFFFFFU && data_size64 != UINT64_MAX) {
+                size = data_size64;
+            }
+            info.data_offset = body;
+            data_size = std::min<uint64_t>(size, file_size - body);
+            has_data = true;
+        }
+        offset = body + size + (size & 1U);
+    }
+    if (!has_data) {
+        throw_unsupported();
+    }
+    return data_size;
+}
+
+/**
+ *  Parse the chunks of an AIFF or AIFC file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file is malformed or not supported 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param file
+ *      The file.
+ *  @param file_size
+ *      The size of the file.
+ *  @param is_aifc
+ *      True if the file is AIFC.
+ *  @param info
+ *      The information (output).
+ *  @return
+ *      The size of the audio data (in bytes).
+ */
+static uint64_t parse_aiff(
+    FILE                         *file,
+    uint64_t                      file_size,
+    bool                          is_aifc,
+    xap::audioio::AudioFileInfo  &info
+) {
+    bool has_common = false;
+    uint64_t frame_count = 0U;
+    uint64_t offset = 12U;
+    while (offset + 8U <= file_size) {
+        uint8_t header[8];
+        read_header(file, offset, header, 8U);
+        uint64_t size = load_u32_be(header + 4);
+        uint64_t body = offset + 8U;
+        if (memcmp(header, "COMM", 4U) == 0) {
+            uint8_t common[22];
+            size_t length = is_aifc ? 22U : 18U;
+            if (size < length) {
+                throw_unsupported();
+            }
+            read_header(file, body, common, length);
+            info.channel_count = load_u16_be(common);
+            frame_count = load_u32_be(common + 2);
+            info.bits_per_sample = (load_u16_be(common + 6) + 7U) & ~7U;
+            double rate = load_extended(common + 8);
+            if (!(rate >= 1.0 && rate <= 4294967295.0)) {
+                throw_unsupported();
+            }
+            info.sample_rate = static_cast<uint32_t>(lrint(rate));
+            info.is_float = false;
+            info.is_big_endian = true;
+            info.is_unsigned = false;
+            if (is_aifc) {
+                const uint8_t *type = common + 18;
+                if (memcmp(type, "sowt", 4U) == 0) {
+                    info.is_big_endian = false;
+                } else if (memcmp(type, "fl32", 4U) == 0 || 
+                           memcmp(type, "FL32", 4U) == 0) {
+                    info.is_float = true;
+                    info.bits_per_sample = 32U;
+                } else if (memcmp(type, "fl64", 4U) == 0 || 
+                           memcmp(type, "FL64", 4U) == 0) {
+                    info.is_float = true;
+                    info.bits_per_sample = 64U;
+                } else if (memcmp(type, "ulaw", 4U) == 0 || 
+                           memcmp(type, "ULAW", 4U) == 0) {
+                    info.is_ulaw = true;
+                    info.bits_per_sample = 8U;
+                } else if (memcmp(type, "alaw", 4U) == 0 || 
+                           memcmp(type, "ALAW", 4U) == 0) {
+                    info.is_alaw = true;
+                    info.bits_per_sample = 8U;
+                } else if (memcmp(type, "NONE", 4U) != 0 && 
+                           memcmp(type, "twos", 4U) != 0) {
+                    throw_unsupported();
+                }
+            }
+            has_common = true;
+        } else if (memcmp(header, "SSND", 4U) == 0) {
+            uint8_t sound[8];
+            if (!has_common || size < 8U) {
+                throw_unsupported();
+            }
+            read_header(file, body, sound, 8U);
+            uint64_t skip = 8U + load_u32_be(sound);
+            if (skip > size || body + skip > file_size) {
+                throw_unsupported();
+            }
+            info.data_offset = body + skip;
+            uint64_t data_size = std::min<uint64_t>(
+                size - skip,
+                file_size - info.data_offset
+            );
+            uint64_t frame_size = 
+                info.channel_count * (info.bits_per_sample / 8U);
+            return std::min<uint64_t>(data_size, frame_count * frame_size);
+        }
+        offset = body + size + (size & 1U);
+    }
+    throw_unsupported();
+    return 0U;
+}
+
+/**
+ *  Parse the chunks of a CAF file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file is malformed or not supported 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param file
+ *      The file.
+ *  @param file_size
+ *      The size of the file.
+ *  @param info
+ *      The information (output).
+ *  @return
+ *      The size of the audio data (in bytes).
+ */
+static uint64_t parse_caf(
+    FILE                         *file,
+    uint64_t                      file_size,
+    xap::audioio::AudioFileInfo  &info
+) {
+    bool has_description = false;
+    uint64_t offset = 8U;
+    while (offset + 12U <= file_size) {
+        uint8_t header[12];
+        read_header(file, offset, header, 12U);
+        uint64_t size = load_u64_be(header + 4);
+        uint64_t body = offset + 12U;
+        if (memcmp(header, "desc", 4U) == 0) {
+            uint8_t description[32];
+            if (size < 32U) {
+                throw_unsupported();
+            }
+            read_header(file, body, description, 32U);
+            uint64_t bits = load_u64_be(description);
+            double rate;
+            memcpy(&rate, &bits, sizeof(rate));
+            uint32_t flags = load_u32_be(description + 12);
+            info.channel_count = load_u32_be(description + 24);
+            info.bits_per_sample = load_u32_be(description + 28);
+            info.is_float = ((flags & 1U) != 0U);
+            info.is_big_endian = ((flags & 2U) == 0U);
+            info.is_unsigned = false;
+            info.is_ulaw = (memcmp(description + 8, "ulaw", 4U) == 0);
+            info.is_alaw = (memcmp(description + 8, "alaw", 4U) == 0);
+            if (info.is_ulaw || info.is_alaw) {
+                info.is_float = false;
+            } else if (memcmp(description + 8, "lpcm", 4U) != 0) {
+                throw_unsupported();
+            }
+            if (
+                load_u32_be(description + 20) != 1U || 
+                load_u32_be(description + 16) != 
+                    info.channel_count * (info.bits_per_sample / 8U) || 
+                !(rate >= 1.0 && rate <= 4294967295.0)) {
+                throw_unsupported();
+            }
+            info.sample_rate = static_cast<uint32_t>(lrint(rate));
+            has_description = true;
+        } else if (memcmp(header, "data", 4U) == 0) {
+            //  The data starts with an edit count, the size of the last 
+            //  chunk may be unknown (-1).
+            if (!has_description || body + 4U > file_size) {
+                throw_unsupported();
+            }
+            info.data_offset = body + 4U;
+            uint64_t available = file_size - info.data_offset;
+            if (size == UINT64_MAX || size < 4U) {
+                return available;
+            }
+            return std::min<uint64_t>(size - 4U, available);
+        }
+        if (size > file_size) {
+            throw_unsupported();
+        }
+        offset = body + size;
+    }
+    throw_unsupported();
+    return 0U;
+}
+
+/**
+ *  Parse the header of an audio file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file cannot be read (xap::audioio::ERROR_IO) or is 
+ *      malformed or not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param file
+ *      The file.
+ *  @return
+ *      The information.
+ */
+static xap::audioio::AudioFileInfo parse_header(FILE *file) {
+    xap::audioio::AudioFileInfo info;
+    memset(&info, 0, sizeof(info));
+    uint64_t file_size = get_file_size(file);
+    uint8_t magic[12];
+    read_header(file, 0U, magic, 12U);
+    uint64_t data_size = 0U;
+    if ((memcmp(magic, "RIFF", 4U) == 0 || memcmp(magic, "RF64", 4U) == 0) && 
+        memcmp(magic + 8, "WAVE", 4U) == 0) {
+        info.container = xap::audioio::AUDIOFILE_WAV;
+        data_size = parse_wav(file, file_size, info);
+    } else if (memcmp(magic, "FORM", 4U) == 0 && 
+               (memcmp(magic + 8, "AIFF", 4U) == 0 || 
+                memcmp(magic + 8, "AIFC", 4U) == 0)) {
+        info.container = xap::audioio::AUDIOFILE_AIFF;
+        data_size = parse_aiff(
+            file,
+            file_size,
+            memcmp(magic + 8, "AIFC", 4U) == 0,
+            info
+        );
+    } else if (memcmp(magic, "caff", 4U) == 0) {
+        info.container = xap::audioio::AUDIOFILE_CAF;
+        data_size = parse_caf(file, file_size, info);
+    } else {
+        throw_unsupported();
+    }
+
+    uint32_t bits = info.bits_per_sample;
+    bool is_valid_bits;
+    if (info.is_float) {
+        is_valid_bits = (bits == 32U || bits == 64U);
+    } else if (info.is_ulaw || info.is_alaw) {
+        is_valid_bits = (bits == 8U);
+    } else {
+        is_valid_bits = (bits == 8U || bits == 16U || bits == 24U || 
+                         bits == 32U);
+    }
+    if (!is_valid_bits || 
+        info.channel_count == 0U || info.channel_count > 255U || 
+        info.sample_rate == 0U) {
+        throw_unsupported();
+    }
+    info.frame_count = data_size / (info.channel_count * (bits / 8U));
+    return info;
+}
+
+/**
+ *  Decode samples to 32-bit float (full scale is 1.0).
+ * 
+ *  @param info
+ *      The file information (the encoding).
+ *  @param raw
+ *      The encoded samples.
+ *  @param count
+ *      The count of samples.
+ *  @param output
+ *      The samples (output).
+ */
+static void decode_samples(
+    const xap::audioio::AudioFileInfo  &info,
+    const uint8_t                      *raw,
+    size_t                              count,
+    float                              *output
+) noexcept {
+    bool is_big_endian = info.is_big_endian;
+    size_t i = 0U;
+    if (info.is_float && info.bits_per_sample == 32U) {
+#if defined(__SSE2__)
+        for (; i + 4U <= count; i += 4U) {
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(raw + 4U * i)
+            );
+            if (is_big_endian) {
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+            }
+            _mm_storeu_ps(output + i, _mm_castsi128_ps(v));
+        }
+#endif
+        for (; i < count; ++i) {
+            uint32_t bits = is_big_endian ? 
+                load_u32_be(raw + 4U * i) :
+                load_u32_le(raw + 4U * i);
+            memcpy(output + i, &bits, sizeof(float));
+        }
+    } else if (info.is_float) {
+        for (; i < count; ++i) {
+            uint64_t bits = is_big_endian ? 
+                load_u64_be(raw + 8U * i) :
+                load_u64_le(raw + 8U * i);
+            double value;
+            memcpy(&value, &bits, sizeof(double));
+            output[i] = static_cast<float>(value);
+        }
+    } else if (info.bits_per_sample == 16U) {
+#if defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(1.0F / 32768.0F);
+        for (; i + 8U <= count; i += 8U) {
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(raw + 2U * i)
+            );
+            if (is_big_endian) {
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            }
+            __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+            _mm_storeu_ps(
+                output + i + 4U,
+                _mm_mul_ps(_mm_cvtepi32_ps(high), scale)
+            );
+        }
+#endif
+        for (; i < count; ++i) {
+            uint16_t bits = is_big_endian ? 
+                load_u16_be(raw + 2U * i) :
+                load_u16_le(raw + 2U * i);
+            output[i] = static_cast<float>(static_cast<int16_t>(bits)) / 
+                        32768.0F;
+        }
+    } else if (info.bits_per_sample == 32U) {
+#if defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(1.0F / 2147483648.0F);
+        for (; i + 4U <= count; i += 4U) {
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(raw + 4U * i)
+            );
+            if (is_big_endian) {
+                v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+            }
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+        }
+#endif
+        for (; i < count; ++i) {
+            uint32_t bits = is_big_endian ? 
+                load_u32_be(raw + 4U * i) :
+                load_u32_le(raw + 4U * i);
+            output[i] = static_cast<float>(static_cast<int32_t>(bits)) / 
+                        2147483648.0F;
+        }
+    } else if (info.bits_per_sample == 24U) {
+        //  Assembled into the top bytes of 32-bit integers (sign extended).
+        for (; i < count; ++i) {
+            const uint8_t *p = raw + 3U * i;
+            uint32_t bits = is_big_endian ? 
+                ((static_cast<uint32_t>(p[0]) << 24) |
+                 (static_cast<uint32_t>(p[1]) << 16) |
+                 (static_cast<uint32_t>(p[2]) << 8)) :
+                ((static_cast<uint32_t>(p[2]) << 24) |
+                 (static_cast<uint32_t>(p[1]) << 16) |
+                 (static_cast<uint32_t>(p[0]) << 8));
+            output[i] = static_cast<float>(static_cast<int32_t>(bits)) / 
+                        2147483648.0F;
+        }
+    } else if (info.is_ulaw || info.is_alaw) {
+        //  Expanded to 16-bit linear samples in pieces (on the stack).
+        int16_t linear[64];
+        while (i < count) {
+            size_t piece = std::min<size_t>(count - i, 64U);
+            if (info.is_ulaw) {
+                xap::audioio::g711_ulaw_decode(raw + i, linear, piece);
+            } else {
+                xap::audioio::g711_alaw_decode(raw + i, linear, piece);
+            }
+            for (size_t k = 0U; k < piece; ++k) {
+                output[i + k] = static_cast<float>(linear[k]) / 32768.0F;
+            }
+            i += piece;
+        }
+    } else if (info.is_unsigned) {
+        for (; i < count; ++i) {
+            output[i] = static_cast<float>(static_cast<int>(raw[i]) - 128) / 
+                        128.0F;
+        }
+    } else {
+        for (; i < count; ++i) {
+            output[i] = static_cast<float>(static_cast<int8_t>(raw[i])) / 
+                        128.0F;
+        }
+    }
+}
+
+/**
+ *  Map the working channels to the output channels (in place, mono is 
+ *  duplicated) and encode the samples in the output format.
+ * 
+ *  @param samples
+ *      The samples (room for the output channels).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param work_channels
+ *      The count of working channels.
+ *  @param format
+ *      The output audio format.
+ *  @param destination
+ *      The output (encoded).
+ */
+static void encode_frames(
+    float                            *samples,
+    size_t                            frame_count,
+    size_t                            work_channels,
+    const xap::audioio::AudioFormat  &format,
+    uint8_t                          *destination
+) noexcept {
+    size_t channel_count = static_cast<size_t>(format.channel_count);
+    if (work_channels != channel_count) {
+        for (size_t i = frame_count; i > 0U; --i) {
+            float value = samples[i - 1U];
+            for (size_t c = 0U; c < channel_count; ++c) {
+                samples[(i - 1U) * channel_count + c] = value;
+            }
+        }
+    }
+
+    size_t count = frame_count * channel_count;
+    size_t i = 0U;
+    if (format.sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32) {
+        memcpy(destination, samples, count * sizeof(float));
+    } else if (format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+        int16_t *output = reinterpret_cast<int16_t *>(destination);
+#if defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(32768.0F);
+        for (; i + 8U <= count; i += 8U) {
+            __m128i low = _mm_cvtps_epi32(
+                _mm_mul_ps(_mm_loadu_ps(samples + i), scale)
+            );
+            __m128i high = _mm_cvtps_epi32(
+                _mm_mul_ps(_mm_loadu_ps(samples + i + 4U), scale)
+            );
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i *>(output + i),
+                _mm_packs_epi32(low, high)
+            );
+        }
+#endif
+        for (; i < count; ++i) {
+            output[i] = xap::audioio::fir_saturate_int16(samples[i] * 32768.0F);
+        }
+    } else {
+        int32_t *output = reinterpret_cast<int32_t *>(destination);
+        const float upper = 2147483520.0F;
+        const float lower = -2147483648.0F;
+#if defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(2147483648.0F);
+        const __m128 maximum = _mm_set1_ps(upper);
+        const __m128 minimum = _mm_set1_ps(lower);
+        for (; i + 4U <= count; i += 4U) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(samples + i), scale);
+            v = _mm_max_ps(_mm_min_ps(v, maximum), minimum);
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i *>(output + i),
+                _mm_cvtps_epi32(v)
+            );
+        }
+#endif
+        for (; i < count; ++i) {
+            float v = samples[i] * 2147483648.0F;
+            v = v > upper ? upper : (v < lower ? lower : v);
+            output[i] = static_cast<int32_t>(lrintf(v));
+        }
+    }
+}
+
+/**
+ *  Build the audio format of the reader state (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Get the greatest common divisor.
+ * 
+ *  @param a
+ *      The number a.
+ *  @param b
+ *      The number b.
+ *  @return
+ *      The greatest common divisor.
+ */
+static uint64_t get_gcd(uint64_t a, uint64_t b) noexcept {
+    while (b != 0U) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+//
+//  AudioFileReader constructor & destructor.
+//
+
+/**
+ *  Construct the object (parse the header and prefetch the beginning of 
+ *  the audio data).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The output format or the options are invalid.
+ * 
+ *          - xap::audioio::ERROR_IO:
+ *              The file cannot be opened or read.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The file is malformed, its encoding is not supported or 
+ *              its channels cannot be mapped to the output channels.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              The prefetch thread cannot be started.
+ * 
+ *  @param path
+ *      The path of the file.
+ *  @param output_format
+ *      The output audio format (16-bit, 32-bit or 32-bit float).
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+AudioFileReader::AudioFileReader(
+    const char                                   *path,
+    const xap::audioio::AudioFormat              &output_format,
+    const xap::audioio::AudioFileReaderOptions   &options,
+    xap::audioio::IAllocator                     *allocator
+) :
+    m_info(),
+    m_output_format(output_format),
+    m_options(options),
+    m_file(nullptr),
+    m_ring(nullptr),
+    m_capacity(options.buffer_frames),
+    m_frame_size(0U),
+    m_work_channels(0U),
+    m_half(0U),
+    m_tap_count(0U),
+    m_history_capacity(0U),
+    m_rate_in(1U),
+    m_rate_out(1U),
+    m_length(0U),
+    m_is_resampling(false),
+    m_is_direct(false),
+    m_seek_target(0U),
+    m_seek_epoch(1U),
+    m_epoch(0U),
+    m_end_epoch(0U),
+    m_has_error(false),
+    m_epoch_target(0U),
+    m_epoch_head(0U),
+    m_head(0U),
+    m_tail(0U),
+    m_producer_epoch(0U),
+    m_file_frame(0U),
+    m_consumer_epoch(0U),
+    m_input(0),
+    m_phase(0U),
+    m_history_start(0),
+    m_history_count(0U),
+    m_position(0U),
+    m_is_finished(false),
+    m_taps(),
+    m_history(),
+    m_decoded(),
+    m_work()
+{
+    if ((output_format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         output_format.sample_format != xap::audioio::SAMPLEFORMAT_INT32 && 
+         output_format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        output_format.channel_count == 0U || 
+        output_format.sample_rate == 0U || 
+        options.buffer_frames < 2U * AUDIOFILE_CHUNK_FRAMES) {
+        throw xap::audioio::Exception(
+            "Invalid output format or options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    this->m_file = fopen(path, "rb");
+    if (this->m_file == nullptr) {
+        throw xap::audioio::Exception(
+            "Cannot open the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+    try {
+        this->m_info = parse_header(this->m_file);
+
+        //
+        //  Channel mapping: same channels, mono to all channels or all 
+        //  channels to mono.
+        //
+        size_t file_channels = this->m_info.channel_count;
+        size_t channel_count = output_format.channel_count;
+        if (file_channels == channel_count) {
+            this->m_work_channels = channel_count;
+        } else if (file_channels == 1U || channel_count == 1U) {
+            this->m_work_channels = 1U;
+        } else {
+            throw xap::audioio::Exception(
+                "The channels of the audio file cannot be mapped.",
+                xap::audioio::ERROR_UNSUPPORTED
+            );
+        }
+        this->m_frame_size = 
+            file_channels * (this->m_info.bits_per_sample / 8U);
+
+        //
+        //  Rate conversion (exact ratio).
+        //
+        uint64_t gcd = get_gcd(
+            this->m_info.sample_rate,
+            output_format.sample_rate
+        );
+        this->m_rate_in = this->m_info.sample_rate / gcd;
+        this->m_rate_out = output_format.sample_rate / gcd;
+        this->m_is_resampling = (this->m_rate_in != this->m_rate_out);
+        if (this->m_is_resampling) {
+            this->m_length = 
+                (this->m_info.frame_count * this->m_rate_out + 
+                 this->m_rate_in - 1U) / this->m_rate_in;
+        } else {
+            this->m_length = this->m_info.frame_count;
+        }
+
+        //
+        //  16-bit, 32-bit and 32-bit float (little-endian) files are copied 
+        //  to outputs of the same format.
+        //
+        const xap::audioio::AudioFileInfo &info = this->m_info;
+        bool is_same_encoding = 
+            (!info.is_float && info.bits_per_sample == 16U && 
+             output_format.sample_format == 
+                 xap::audioio::SAMPLEFORMAT_INT16) || 
+            (!info.is_float && info.bits_per_sample == 32U && 
+             output_format.sample_format == 
+                 xap::audioio::SAMPLEFORMAT_INT32) || 
+            (info.is_float && info.bits_per_sample == 32U && 
+             output_format.sample_format == 
+                 xap::audioio::SAMPLEFORMAT_FLOAT32);
+        this->m_is_direct = 
+            is_same_encoding && !info.is_big_endian && 
+            is_little_endian_host() && !this->m_is_resampling && 
+            file_channels == channel_count;
+
+        //
+        //  Buffers.
+        //
+        this->m_ring = static_cast<uint8_t *>(
+            xap::audioio::allocate_object(
+                allocator,
+                this->m_capacity * this->m_frame_size
+            )
+        );
+        xap::audioio::AudioFormat state_format = 
+            build_state_format(output_format.sample_rate);
+        this->m_decoded = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            AUDIOFILE_CHUNK_FRAMES * std::max(file_channels, channel_count),
+            allocator
+        );
+        if (this->m_is_resampling) {
+            //
+            //  Polyphase windowed-sinc, the coefficients of the phase p are 
+            //  centered on the fractional position p / PHASES (one more 
+            //  phase for the interpolation).
+            //
+            double ratio = static_cast<double>(this->m_rate_in) / 
+                           static_cast<double>(this->m_rate_out);
+            double scale = ratio > 1.0 ? ratio : 1.0;
+            size_t half = static_cast<size_t>(ceil(
+                static_cast<double>(AUDIOFILE_RESAMPLER_HALF_TAPS) * scale
+            ));
+            half = (half + 1U) & ~static_cast<size_t>(1U);
+            size_t tap_count = 2U * half;
+            this->m_half = half;
+            this->m_tap_count = tap_count;
+            this->m_taps = xap::audioio::AudioBuffer::allocate(
+                state_format,
+                (AUDIOFILE_RESAMPLER_PHASES + 1U) * tap_count,
+                allocator
+            );
+            double cutoff = 0.5 * AUDIOFILE_RESAMPLER_BANDWIDTH / scale;
+            float *taps = this->m_taps.get_samples<float>();
+            for (size_t p = 0U; p <= AUDIOFILE_RESAMPLER_PHASES; ++p) {
+                float *row = taps + p * tap_count;
+                double sum = 0.0;
+                for (size_t k = 0U; k < tap_count; ++k) {
+                    double d = static_cast<double>(k) - 
+                               static_cast<double>(half) + 1.0 - 
+                               static_cast<double>(p) / 
+                               static_cast<double>(AUDIOFILE_RESAMPLER_PHASES);
+                    double value = 0.0;
+                    if (fabs(d) < static_cast<double>(half)) {
+                        double x = 2.0 * cutoff * d;
+                        double sinc = fabs(x) < 1e-9 ? 
+                            1.0 :
+                            sin(AUDIOFILE_PI * x) / (AUDIOFILE_PI * x);
+                        double w = AUDIOFILE_PI * d / static_cast<double>(half);
+                        value = 2.0 * cutoff * sinc * 
+                                (0.42 + 0.5 * cos(w) + 0.08 * cos(2.0 * w));
+                    }
+                    row[k] = static_cast<float>(value);
+                    sum += value;
+                }
+                for (size_t k = 0U; k < tap_count; ++k) {
+                    row[k] = static_cast<float>(
+                        static_cast<double>(row[k]) / sum
+                    );
+                }
+            }
+            this->m_history_capacity = tap_count + AUDIOFILE_CHUNK_FRAMES;
+            this->m_history = xap::audioio::AudioBuffer::allocate(
+                state_format,
+                this->m_work_channels * this->m_history_capacity,
+                allocator
+            );
+            this->m_work = xap::audioio::AudioBuffer::allocate(
+                state_format,
+                AUDIOFILE_CHUNK_FRAMES * channel_count,
+                allocator
+            );
+        }
+
+        //
+        //  Prefetch the beginning, then hand the reader over to the 
+        //  prefetch thread.
+        //
+        this->prefetch();
+        if (this->m_has_error.load()) {
+            throw xap::audioio::Exception(
+                "Cannot read the audio file.",
+                xap::audioio::ERROR_IO
+            );
+        }
+        get_prefetcher().add(this);
+    } catch (...) {
+        xap::audioio::free_object(this->m_ring);
+        fclose(this->m_file);
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+AudioFileReader::~AudioFileReader() noexcept {
+    get_prefetcher().remove(this);
+    xap::audioio::free_object(this->m_ring);
+    fclose(this->m_file);
+}
+
+//
+//  AudioFileReader public methods.
+//
+
+/**
+ *  Read audio data (on the audio thread, never blocks on I/O).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the output mismatched.
+ * 
+ *          - xap::audioio::ERROR_IO:
+ *              The prefetch thread failed to read the file.
+ * 
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (less than requested at the end of the 
+ *      file, or if the frames were not prefetched yet).
+ */
+size_t AudioFileReader::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_output_format.sample_format || 
+        output.get_channel_count() != this->m_output_format.channel_count || 
+        output.get_sample_rate() != this->m_output_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (this->m_has_error.load(std::memory_order_acquire)) {
+        throw xap::audioio::Exception(
+            "Cannot read the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+
+    //
+    //  Wait (with silence) until the prefetch thread served the last seek, 
+    //  then start reading at the data of its epoch.
+    //
+    uint32_t requested = this->m_seek_epoch.load(std::memory_order_acquire);
+    uint32_t served = this->m_epoch.load(std::memory_order_acquire);
+    if (served != requested) {
+        get_prefetcher().wake();
+        return 0U;
+    }
+    if (this->m_consumer_epoch != served) {
+        //
+        //  The snapshot is consistent only if the epoch did not change 
+        //  while it was loaded (the prefetch thread invalidates the epoch 
+        //  before it updates the snapshot).
+        //
+        uint64_t target = this->m_epoch_target.load(std::memory_order_acquire);
+        uint64_t epoch_head = 
+            this->m_epoch_head.load(std::memory_order_acquire);
+        if (this->m_epoch.load(std::memory_order_acquire) != served) {
+            //  Served another seek meanwhile.
+            return 0U;
+        }
+
+        //  The tail never moves backwards (the reader never consumes data 
+        //  after the head of a later epoch).
+        if (epoch_head > this->m_tail.load(std::memory_order_relaxed)) {
+            this->m_tail.store(epoch_head, std::memory_order_release);
+        }
+        this->m_consumer_epoch = served;
+        if (this->m_is_resampling) {
+            uint64_t scaled = target * this->m_rate_in;
+            this->m_input = static_cast<int64_t>(scaled / this->m_rate_out);
+            this->m_phase = scaled % this->m_rate_out;
+            this->m_history_start = this->get_first_input(target);
+            this->m_history_count = 0U;
+            if (this->m_history_start < 0) {
+                //  Silence before the file.
+                this->m_history_count = 
+                    static_cast<size_t>(-(this->m_history_start));
+                for (size_t w = 0U; w < this->m_work_channels; ++w) {
+                    memset(
+                        this->m_history.get_samples<float>() + 
+                            w * this->m_history_capacity,
+                        0,
+                        this->m_history_count * sizeof(float)
+                    );
+                }
+            }
+        }
+        this->m_position.store(target, std::memory_order_relaxed);
+        this->m_is_finished.store(
+            target >= this->m_length,
+            std::memory_order_release
+        );
+    }
+
+    size_t frame_count = output.get_frame_count();
+    size_t output_frame_size = 
+        xap::audioio::get_sample_size(this->m_output_format.sample_format) * 
+        static_cast<size_t>(this->m_output_format.channel_count);
+    uint8_t *destination = output.get_pointer();
+    size_t done = 0U;
+    bool is_finished = this->m_is_finished.load(std::memory_order_relaxed);
+    if (!is_finished && !this->m_is_resampling) {
+        float *decoded = this->m_decoded.get_samples<float>();
+        while (done < frame_count) {
+            bool is_end = (this->m_end_epoch.load(std::memory_order_acquire) == 
+                           served);
+            uint64_t tail = this->m_tail.load(std::memory_order_relaxed);
+            uint64_t head = this->get_epoch_head(served, tail);
+            if (head == tail) {
+                is_finished = is_end && 
+                              this->m_epoch.load(std::memory_order_acquire) == 
+                                  served;
+                break;
+            }
+            size_t index = static_cast<size_t>(tail % this->m_capacity);
+            size_t count = static_cast<size_t>(head - tail);
+            count = std::min(count, frame_count - done);
+            count = std::min(count, AUDIOFILE_CHUNK_FRAMES);
+            count = std::min(count, this->m_capacity - index);
+            const uint8_t *raw = this->m_ring + index * this->m_frame_size;
+            if (this->m_is_direct) {
+                memcpy(
+                    destination + done * output_frame_size,
+                    raw,
+                    count * this->m_frame_size
+                );
+            } else {
+                this->decode(raw, count, decoded);
+                encode_frames(
+                    decoded,
+                    count,
+                    this->m_work_channels,
+                    this->m_output_format,
+                    destination + done * output_frame_size
+                );
+            }
+            this->m_tail.store(tail + count, std::memory_order_release);
+            done += count;
+        }
+    } else if (!is_finished) {
+        //
+        //  Each output frame is interpolated from the taps around its input 
+        //  position (the history holds the input frames of all working 
+        //  channels, planar).
+        //
+        size_t work_channels = this->m_work_channels;
+        size_t tap_count = this->m_tap_count;
+        int64_t half = static_cast<int64_t>(this->m_half);
+        int64_t frames_in_file = static_cast<int64_t>(this->m_info.frame_count);
+        const float *taps = this->m_taps.get_samples<float>();
+        const float *history = this->m_history.get_samples<float>();
+        float *work = this->m_work.get_samples<float>();
+        bool is_stalled = false;
+        while (done < frame_count && !is_finished && !is_stalled) {
+            size_t count = std::min(frame_count - done, AUDIOFILE_CHUNK_FRAMES);
+            size_t produced = 0U;
+            while (produced < count) {
+                if (this->m_input >= frames_in_file) {
+                    is_finished = true;
+                    break;
+                }
+                if (this->m_history_start + 
+                        static_cast<int64_t>(this->m_history_count) <= 
+                    this->m_input + half) {
+                    bool is_end = 
+                        (this->m_end_epoch.load(std::memory_order_acquire) == 
+                         served);
+                    if (!this->fill_history(served, is_end)) {
+                        is_stalled = true;
+                        break;
+                    }
+                    continue;
+                }
+                uint64_t scaled = this->m_phase * AUDIOFILE_RESAMPLER_PHASES;
+                size_t phase = static_cast<size_t>(scaled / this->m_rate_out);
+                float fraction = 
+                    static_cast<float>(scaled % this->m_rate_out) / 
+                    static_cast<float>(this->m_rate_out);
+                const float *taps0 = taps + phase * tap_count;
+                const float *taps1 = taps0 + tap_count;
+                size_t offset = static_cast<size_t>(
+                    this->m_input - half + 1 - this->m_history_start
+                );
+                for (size_t w = 0U; w < work_channels; ++w) {
+                    const float *x = 
+                        history + w * this->m_history_capacity + offset;
+                    float y0 = xap::audioio::fir_dot(taps0, x, tap_count);
+                    float y1 = xap::audioio::fir_dot(taps1, x, tap_count);
+                    work[produced * work_channels + w] = 
+                        y0 + fraction * (y1 - y0);
+                }
+                this->m_phase += this->m_rate_in;
+                this->m_input += 
+                    static_cast<int64_t>(this->m_phase / this->m_rate_out);
+                this->m_phase %= this->m_rate_out;
+                ++produced;
+            }
+            encode_frames(
+                work,
+                produced,
+                work_channels,
+                this->m_output_format,
+                destination + done * output_frame_size
+            );
+            done += produced;
+        }
+    }
+
+    //
+    //  Refill when half of the ring buffer was read.
+    //
+    if (this->m_head.load(std::memory_order_relaxed) - 
+            this->m_tail.load(std::memory_order_relaxed) <
+        this->m_capacity / 2U) {
+        get_prefetcher().wake();
+    }
+    this->m_position.fetch_add(done, std::memory_order_release);
+    if (is_finished) {
+        this->m_is_finished.store(true, std::memory_order_release);
+    }
+    return done;
+}
+
+/**
+ *  Seek (thread-safe, the position is updated at once, the frames of the 
+ *  new position are read once the prefetch thread has served it).
+ * 
+ *  @param frame
+ *      The position (in output frames, clamped to the length).
+ */
+void AudioFileReader::seek(uint64_t frame) noexcept {
+    if (frame > this->m_length) {
+        frame = this->m_length;
+    }
+    this->m_seek_target.store(frame, std::memory_order_relaxed);
+    if (this->m_seek_epoch.fetch_add(1U, std::memory_order_release) == 
+            UINT32_MAX) {
+        //  Epoch 0 marks a snapshot being updated.
+        this->m_seek_epoch.fetch_add(1U, std::memory_order_release);
+    }
+    this->m_position.store(frame, std::memory_order_release);
+    this->m_is_finished.store(
+        frame >= this->m_length,
+        std::memory_order_release
+    );
+    get_prefetcher().wake();
+}
+
+/**
+ *  Get the file information.
+ * 
+ *  @return
+ *      The information.
+ */
+const xap::audioio::AudioFileInfo &AudioFileReader::get_info()
+    const noexcept {
+    return this->m_info;
+}
+
+/**
+ *  Get the length of the file (in output frames).
+ * 
+ *  @return
+ *      The length.
+ */
+uint64_t AudioFileReader::get_length() const noexcept {
+    return this->m_length;
+}
+
+/**
+ *  Get the position of the next frame read (in output frames).
+ * 
+ *  @return
+ *      The position.
+ */
+uint64_t AudioFileReader::get_position() const noexcept {
+    return this->m_position.load(std::memory_order_acquire);
+}
+
+/**
+ *  Get whether all frames were read.
+ * 
+ *  @return
+ *      True if so.
+ */
+bool AudioFileReader::is_finished() const noexcept {
+    return this->m_is_finished.load(std::memory_order_acquire);
+}
+
+//
+//  AudioFileReader private methods.
+//
+
+/**
+ *  Serve the pending seek and fill the ring buffer (on the prefetch 
+ *  thread).
+ */
+void AudioFileReader::prefetch() noexcept {
+    if (this->m_has_error.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    //
+    //  A new epoch starts at the current head (the reader skips the data 
+    //  of older epochs).
+    //
+    uint64_t head = this->m_head.load(std::memory_order_relaxed);
+    uint32_t requested = this->m_seek_epoch.load(std::memory_order_acquire);
+    bool is_new = (requested != this->m_producer_epoch);
+    if (is_new) {
+        uint64_t target = this->m_seek_target.load(std::memory_order_relaxed);
+        int64_t first = this->get_first_input(target);
+        this->m_file_frame = first < 0 ? 0U : static_cast<uint64_t>(first);
+        if (!seek_file(
+                this->m_file,
+                this->m_info.data_offset + 
+                    this->m_file_frame * this->m_frame_size
+            )) {
+            this->m_has_error.store(true, std::memory_order_release);
+            return;
+        }
+        //
+        //  Invalidate the epoch while its snapshot is updated (like a 
+        //  sequence lock, the reader discards a snapshot loaded meanwhile).
+        //
+        this->m_epoch.store(0U, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        this->m_epoch_target.store(target, std::memory_order_relaxed);
+        this->m_epoch_head.store(head, std::memory_order_relaxed);
+        this->m_epoch.store(requested, std::memory_order_release);
+        this->m_producer_epoch = requested;
+    }
+    if (this->m_end_epoch.load(std::memory_order_relaxed) == 
+            this->m_producer_epoch) {
+        return;
+    }
+
+    //
+    //  Read in large pieces (at least a quarter of the ring buffer unless 
+    //  the file ends earlier).
+    //
+    uint64_t remaining = this->m_info.frame_count - this->m_file_frame;
+    uint64_t tail = this->m_tail.load(std::memory_order_acquire);
+    size_t free = this->m_capacity - static_cast<size_t>(head - tail);
+    if (!is_new && 
+        static_cast<uint64_t>(free) < remaining && 
+        free < this->m_capacity / 4U) {
+        return;
+    }
+    while (free > 0U && remaining > 0U) {
+        size_t index = static_cast<size_t>(head % this->m_capacity);
+        size_t count = std::min(free, this->m_capacity - index);
+        if (static_cast<uint64_t>(count) > remaining) {
+            count = static_cast<size_t>(remaining);
+        }
+        if (fread(
+                this->m_ring + index * this->m_frame_size,
+                this->m_frame_size,
+                count,
+                this->m_file
+            ) != count) {
+            this->m_has_error.store(true, std::memory_order_release);
+            return;
+        }
+        this->m_file_frame += count;
+        remaining -= count;
+        head += count;
+        free -= count;
+        this->m_head.store(head, std::memory_order_release);
+    }
+    if (remaining == 0U) {
+        this->m_end_epoch.store(
+            this->m_producer_epoch,
+            std::memory_order_release
+        );
+    }
+}
+
+/**
+ *  Get the first file frame which is needed to render an output frame.
+ * 
+ *  @param frame
+ *      The output frame.
+ *  @return
+ *      The file frame (may be negative while resampling, the frames 
+ *      before the file are silent).
+ */
+int64_t AudioFileReader::get_first_input(uint64_t frame) const noexcept {
+    if (!this->m_is_resampling) {
+        return static_cast<int64_t>(frame);
+    }
+    int64_t input = 
+        static_cast<int64_t>(frame * this->m_rate_in / this->m_rate_out);
+    return input - static_cast<int64_t>(this->m_half) + 1;
+}
+
+/**
+ *  Decode file frames to 32-bit float samples in the working channels 
+ *  (downmixed if the output is mono).
+ * 
+ *  @param raw
+ *      The file frames (in the ring buffer).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param output
+ *      The samples (output).
+ */
+void AudioFileReader::decode(
+    const uint8_t  *raw,
+    size_t          frame_count,
+    float          *output
+) noexcept {
+    size_t file_channels = this->m_info.channel_count;
+    decode_samples(this->m_info, raw, frame_count * file_channels, output);
+    if (this->m_work_channels != file_channels) {
+        float scale = 1.0F / static_cast<float>(file_channels);
+        for (size_t i = 0U; i < frame_count; ++i) {
+            float sum = 0.0F;
+            for (size_t c = 0U; c < file_channels; ++c) {
+                sum += output[i * file_channels + c];
+            }
+            output[i] = sum * scale;
+        }
+    }
+}
+
+/**
+ *  Get the head of the ring buffer data of an epoch (on the reader 
+ *  thread).
+ * 
+ *  @param epoch
+ *      The epoch.
+ *  @param tail
+ *      The tail.
+ *  @return
+ *      The head, or the tail if the prefetch thread served another seek 
+ *      meanwhile (the data after the tail may belong to the new epoch).
+ */
+uint64_t AudioFileReader::get_epoch_head(
+    uint32_t  epoch,
+    uint64_t  tail
+) const noexcept {
+    //
+    //  The prefetch thread publishes a new epoch before it writes the data 
+    //  of that epoch, so a head which covers such data comes with the new 
+    //  epoch.
+    //
+    uint64_t head = this->m_head.load(std::memory_order_acquire);
+    if (this->m_epoch.load(std::memory_order_acquire) != epoch) {
+        return tail;
+    }
+    return head;
+}
+
+/**
+ *  Append frames to the resampler history.
+ * 
+ *  @param epoch
+ *      The epoch of the reader.
+ *  @param is_end
+ *      True if the prefetch thread reached the end of the file.
+ *  @return
+ *      False if no frame is available yet.
+ */
+bool AudioFileReader::fill_history(uint32_t epoch, bool is_end) noexcept {
+    size_t work_channels = this->m_work_channels;
+    size_t capacity = this->m_history_capacity;
+    float *history = this->m_history.get_samples<float>();
+
+    //
+    //  Drop the frames before the taps of the current position.
+    //
+    int64_t first = this->m_input - static_cast<int64_t>(this->m_half) + 1;
+    if (first > this->m_history_start && 
+        this->m_history_count + AUDIOFILE_CHUNK_FRAMES > capacity) {
+        size_t drop = static_cast<size_t>(first - this->m_history_start);
+        if (drop > this->m_history_count) {
+            drop = this->m_history_count;
+        }
+        for (size_t w = 0U; w < work_channels; ++w) {
+            float *line = history + w * capacity;
+            memmove(
+                line,
+                line + drop,
+                (this->m_history_count - drop) * sizeof(float)
+            );
+        }
+        this->m_history_start += static_cast<int64_t>(drop);
+        this->m_history_count -= drop;
+    }
+    size_t space = std::min(
+        capacity - this->m_history_count,
+        AUDIOFILE_CHUNK_FRAMES
+    );
+
+    uint64_t tail = this->m_tail.load(std::memory_order_relaxed);
+    uint64_t head = this->get_epoch_head(epoch, tail);
+    if (head == tail) {
+        if (!is_end || 
+            this->m_epoch.load(std::memory_order_acquire) != epoch) {
+            return false;
+        }
+
+        //  Silence after the file (the taps of the last frames).
+        for (size_t w = 0U; w < work_channels; ++w) {
+            memset(
+                history + w * capacity + this->m_history_count,
+                0,
+                space * sizeof(float)
+            );
+        }
+        this->m_history_count += space;
+        return true;
+    }
+
+    size_t index = static_cast<size_t>(tail % this->m_capacity);
+    size_t count = static_cast<size_t>(head - tail);
+    count = std::min(count, space);
+    count = std::min(count, this->m_capacity - index);
+    float *decoded = this->m_decoded.get_samples<float>();
+    this->decode(this->m_ring + index * this->m_frame_size, count, decoded);
+    for (size_t w = 0U; w < work_channels; ++w) {
+        float *line = history + w * capacity + this->m_history_count;
+        for (size_t i = 0U; i < count; ++i) {
+            line[i] = decoded[i * work_channels + w];
+        }
+    }
+    this->m_tail.store(tail + count, std::memory_order_release);
+    this->m_history_count += count;
+    return true;
+}
+
+//
+//  AudioFileIndex constructor & destructor.
+//
+
+/**
+ *  Construct the object (load the index).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_IO:
+ *              The file cannot be opened or read.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The file is malformed, not supported or has no index.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param path
+ *      The path of the file.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+AudioFileIndex::AudioFileIndex(
+    const char                *path,
+    xap::audioio::IAllocator  *allocator
+) :
+    m_info(),
+    m_granularity(0U),
+    m_entries(
+        xap::audioio::StlAllocator<xap::audioio::AudioFileIndexEntry>(
+            xap::audioio::resolve_allocator(allocator)
+        )
+    ),
+    m_trims(
+        xap::audioio::StlAllocator<xap::audioio::AudioFileTrimEntry>(
+            xap::audioio::resolve_allocator(allocator)
+        )
+    )
+{
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        throw xap::audioio::Exception(
+            "Cannot open the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+    try {
+        this->m_info = parse_header(file);
+        uint64_t size = this->m_info.index_size;
+        if (this->m_info.index_offset == 0U || 
+            size < AUDIOFILE_INDEX_HEADER_SIZE || 
+            (size - AUDIOFILE_INDEX_HEADER_SIZE) %
+                AUDIOFILE_INDEX_ENTRY_SIZE != 0U) {
+            throw xap::audioio::Exception(
+                "The audio file has no seek index.",
+                xap::audioio::ERROR_UNSUPPORTED
+            );
+        }
+
+        //
+        //  The whole index is read at once.
+        //
+        std::vector<uint8_t, xap::audioio::StlAllocator<uint8_t>> bytes(
+            static_cast<size_t>(size),
+            0U,
+            xap::audioio::StlAllocator<uint8_t>(
+                xap::audioio::resolve_allocator(allocator)
+            )
+        );
+        if (!seek_file(file, this->m_info.index_offset) || 
+            fread(bytes.data(), 1U, bytes.size(), file) != bytes.size()) {
+            throw xap::audioio::Exception(
+                "Cannot read the audio file.",
+                xap::audioio::ERROR_IO
+            );
+        }
+        if (load_u32_le(bytes.data()) != AUDIOFILE_INDEX_VERSION) {
+            throw_unsupported();
+        }
+        this->m_granularity = load_u32_le(bytes.data() + 4);
+        size_t count = static_cast<size_t>(
+            (size - AUDIOFILE_INDEX_HEADER_SIZE) / AUDIOFILE_INDEX_ENTRY_SIZE
+        );
+        this->m_entries.resize(count);
+        for (size_t i = 0U; i < count; ++i) {
+            const uint8_t *p = bytes.data() + AUDIOFILE_INDEX_HEADER_SIZE + 
+                               i * AUDIOFILE_INDEX_ENTRY_SIZE;
+            xap::audioio::AudioFileIndexEntry &entry = this->m_entries[i];
+            entry.frame = load_u64_le(p);
+            entry.time = static_cast<int64_t>(load_u64_le(p + 8));
+            entry.offset = load_u64_le(p + 16);
+            if (i != 0U && entry.frame <= this->m_entries[i - 1U].frame) {
+                throw_unsupported();
+            }
+        }
+
+        //
+        //  Trim map (optional).
+        //
+        size = this->m_info.trim_size;
+        if (this->m_info.trim_offset != 0U) {
+            if (size < AUDIOFILE_TRIM_HEADER_SIZE || 
+                (size - AUDIOFILE_TRIM_HEADER_SIZE) % 
+                    AUDIOFILE_TRIM_ENTRY_SIZE != 0U) {
+                throw_unsupported();
+            }
+            bytes.resize(static_cast<size_t>(size));
+            if (!seek_file(file, this->m_info.trim_offset) || 
+                fread(bytes.data(), 1U, bytes.size(), file) != bytes.size()) {
+                throw xap::audioio::Exception(
+                    "Cannot read the audio file.",
+                    xap::audioio::ERROR_IO
+                );
+            }
+            if (load_u32_le(bytes.data()) != AUDIOFILE_TRIM_VERSION) {
+                throw_unsupported();
+            }
+            count = static_cast<size_t>(
+                (size - AUDIOFILE_TRIM_HEADER_SIZE) / AUDIOFILE_TRIM_ENTRY_SIZE
+            );
+            this->m_trims.resize(count);
+            for (size_t i = 0U; i < count; ++i) {
+                const uint8_t *p = bytes.data() + AUDIOFILE_TRIM_HEADER_SIZE + 
+                                   i * AUDIOFILE_TRIM_ENTRY_SIZE;
+                xap::audioio::AudioFileTrimEntry &trim = this->m_trims[i];
+                trim.frame = load_u64_le(p);
+                trim.source_frame = load_u64_le(p + 8);
+
+                //  Frames are only ever trimmed, never inserted.
+                const xap::audioio::AudioFileTrimEntry *previous = 
+                    (i != 0U ? &this->m_trims[i - 1U] : nullptr);
+                uint64_t frame = (previous != nullptr ? previous->frame : 0U);
+                uint64_t source_frame = 
+                    (previous != nullptr ? previous->source_frame : 0U);
+                if ((previous != nullptr && trim.frame <= frame) || 
+                    trim.source_frame < source_frame || 
+                    trim.source_frame - source_frame <= trim.frame - frame) {
+                    throw_unsupported();
+                }
+            }
+        }
+        fclose(file);
+    } catch (std::bad_alloc &) {
+        fclose(file);
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    } catch (...) {
+        fclose(file);
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+AudioFileIndex::~AudioFileIndex() noexcept {}
+
+//
+//  AudioFileIndex public methods.
+//
+
+/**
+ *  Get the file information.
+ * 
+ *  @return
+ *      The information.
+ */
+const xap::audioio::AudioFileInfo &AudioFileIndex::get_info() const noexcept {
+    return this->m_info;
+}
+
+/**
+ *  Get the count of frames between two entries.
+ * 
+ *  @return
+ *      The count of frames.
+ */
+uint32_t AudioFileIndex::get_granularity() const noexcept {
+    return this->m_granularity;
+}
+
+/**
+ *  Get the entries (ordered by position).
+ * 
+ *  @return
+ *      The entries.
+ */
+const xap::audioio::AudioFileIndexEntries &
+    AudioFileIndex::get_entries() const noexcept {
+    return this->m_entries;
+}
+
+/**
+ *  Find the last entry at or before a position.
+ * 
+ *  @param frame
+ *      The position (in file frames).
+ *  @return
+ *      The entry (nullptr if the index is empty).
+ */
+const xap::audioio::AudioFileIndexEntry *AudioFileIndex::find_frame(
+    uint64_t frame
+) const noexcept {
+    //  Entries may be missing (if the writer fell behind), so the position 
+    //  is searched rather than computed from the granularity.
+    auto found = std::upper_bound(
+        this->m_entries.begin(),
+        this->m_entries.end(),
+        frame,
+        [](uint64_t value, const xap::audioio::AudioFileIndexEntry &entry) {
+            return value < entry.frame;
+        }
+    );
+    if (found == this->m_entries.begin()) {
+        return nullptr;
+    }
+    return &(*(found - 1));
+}
+
+/**
+ *  Find the last entry recorded at or before a wall-clock time.
+ * 
+ *  @param time
+ *      The time (in microseconds since the Unix epoch).
+ *  @return
+ *      The entry (nullptr if the time is before the first entry).
+ */
+const xap::audioio::AudioFileIndexEntry *AudioFileIndex::find_time(
+    int64_t time
+) const noexcept {
+    auto found = std::upper_bound(
+        this->m_entries.begin(),
+        this->m_entries.end(),
+        time,
+        [](int64_t value, const xap::audioio::AudioFileIndexEntry &entry) {
+            return value < entry.time;
+        }
+    );
+    if (found == this->m_entries.begin()) {
+        return nullptr;
+    }
+    return &(*(found - 1));
+}
+
+/**
+ *  Locate a position.
+ * 
+ *  @param frame
+ *      The position (in file frames, clamped to the length).
+ *  @return
+ *      The offset of the frame (in bytes from the beginning of the file).
+ */
+uint64_t AudioFileIndex::locate(uint64_t frame) const noexcept {
+    if (frame > this->m_info.frame_count) {
+        frame = this->m_info.frame_count;
+    }
+    uint64_t frame_size = 
+        this->m_info.channel_count * (this->m_info.bits_per_sample / 8U);
+    const xap::audioio::AudioFileIndexEntry *entry = this->find_frame(frame);
+    if (entry == nullptr) {
+        return this->m_info.data_offset + frame * frame_size;
+    }
+    return entry->offset + (frame - entry->frame) * frame_size;
+}
+
+/**
+ *  Get the trim map entries (ordered by position, empty if no silence was 
+ *  trimmed).
+ * 
+ *  @return
+ *      The entries.
+ */
+const xap::audioio::AudioFileTrimEntries &
+    AudioFileIndex::get_trims() const noexcept {
+    return this->m_trims;
+}
+
+/**
+ *  Translate a position of the file to the original recording.
+ * 
+ *  @param frame
+ *      The position (in file frames).
+ *  @return
+ *      The position (in frames of the original recording).
+ */
+uint64_t AudioFileIndex::get_source_frame(uint64_t frame) const noexcept {
+    auto found = std::upper_bound(
+        this->m_trims.begin(),
+        this->m_trims.end(),
+        frame,
+        [](uint64_t value, const xap::audioio::AudioFileTrimEntry &trim) {
+            return value < trim.frame;
+        }
+    );
+    if (found == this->m_trims.begin()) {
+        return frame;
+    }
+    --found;
+    return found->source_frame + (frame - found->frame);
+}
+
+/**
+ *  Translate a position of the original recording to the file (a trimmed 
+ *  position is translated to the frame at which the recording resumed).
+ * 
+ *  @param source_frame
+ *      The position (in frames of the original recording).
+ *  @return
+ *      The position (in file frames).
+ */
+uint64_t AudioFileIndex::get_file_frame(uint64_t source_frame) const noexcept {
+    auto found = std::upper_bound(
+        this->m_trims.begin(),
+        this->m_trims.end(),
+        source_frame,
+        [](uint64_t value, const xap::audioio::AudioFileTrimEntry &trim) {
+            return value < trim.source_frame;
+        }
+    );
+
+    //  The span before the found entry is either kept (up to the frame at 
+    //  which the recording resumed) or trimmed.
+    uint64_t frame = 0U;
+    uint64_t start = 0U;
+    if (found != this->m_trims.begin()) {
+        frame = (found - 1)->frame;
+        start = (found - 1)->source_frame;
+    }
+    frame += source_frame - start;
+    if (found != this->m_trims.end() && frame > found->frame) {
+        frame = found->frame;
+    }
+    return frame;
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Parse the header of an audio file.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file cannot be opened or read (xap::audioio::ERROR_IO) 
+ *      or is malformed or not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param path
+ *      The path of the file.
+ *  @return
+ *      The information.
+ */
+xap::audioio::AudioFileInfo audiofile_probe(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        throw xap::audioio::Exception(
+            "Cannot open the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+    try {
+        xap::audioio::AudioFileInfo info = parse_header(file);
+        fclose(file);
+        return info;
+    } catch (...) {
+        fclose(file);
+        throw;
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
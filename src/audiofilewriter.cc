@@ -0,0 +1,951 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "mpscqueue_p.h"
+#include "worker_p.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/audiofilewriter.h>
+#include <xap/audioio/g711.h>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Layout of the header: RIFF header, a JUNK chunk (replaced by a ds64 
+//  chunk if the file exceeds 4GB), the fmt chunk and the data chunk header.
+const static size_t AUDIOFILEWRITER_JUNK_OFFSET = 12U;
+const static size_t AUDIOFILEWRITER_JUNK_SIZE = 28U;
+const static size_t AUDIOFILEWRITER_DATA_SIZE_OFFSET = 78U;
+const static size_t AUDIOFILEWRITER_DATA_OFFSET = 82U;
+
+//  Seek index chunk (see AudioFileIndex).
+const static uint32_t AUDIOFILEWRITER_INDEX_VERSION = 1U;
+
+//  Capacity of the queue of index entries (power of 2).
+const static size_t AUDIOFILEWRITER_ENTRY_CAPACITY = 256U;
+
+//  Trim map chunk (see AudioFileIndex) and the capacity of the queue of its 
+//  entries (power of 2).
+const static uint32_t AUDIOFILEWRITER_TRIM_VERSION = 1U;
+const static size_t AUDIOFILEWRITER_TRIM_CAPACITY = 256U;
+
+//  Count of samples summed before the energy of a period is compared with 
+//  the silence threshold (a loud period is usually rejected by the first 
+//  block).
+const static size_t AUDIOFILEWRITER_SILENCE_BLOCK = 256U;
+
+//  Poll interval of the writer thread.
+const static std::chrono::milliseconds AUDIOFILEWRITER_FLUSH_TIMEOUT(10);
+
+//
+//  Private classes.
+//
+
+/**
+ *  Task of the writer thread (a friend of the writer).
+ */
+class AudioFileFlusher {
+public:
+    /**
+     *  Write the pending audio data of a writer.
+     * 
+     *  @param writer
+     *      The writer.
+     */
+    static void flush(void *writer) noexcept {
+        static_cast<xap::audioio::AudioFileWriter *>(writer)->flush();
+    }
+};
+//
+//  Private functions.
+//
+
+/**
+ *  Get the writer thread (writes the audio data of all writers).
+ * 
+ *  @return
+ *      The writer thread.
+ */
+static xap::audioio::Worker &get_flusher() noexcept {
+    static xap::audioio::Worker flusher(
+        &AudioFileFlusher::flush,
+        AUDIOFILEWRITER_FLUSH_TIMEOUT
+    );
+    return flusher;
+}
+
+/**
+ *  Store unsigned integers (little-endian).
+ * 
+ *  @param p
+ *      The bytes (output).
+ *  @param value
+ *      The integer.
+ */
+static inline void store_u16_le(uint8_t *p, uint16_t value) noexcept {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+static inline void store_u32_le(uint8_t *p, uint32_t value) noexcept {
+    for (size_t i = 0U; i < 4U; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8U * i));
+    }
+}
+static inline void store_u64_le(uint8_t *p, uint64_t value) noexcept {
+    for (size_t i = 0U; i < 8U; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8U * i));
+    }
+}
+
+/**
+ *  Seek a file.
+ * 
+ *  @param file
+ *      The file.
+ *  @param offset
+ *      The offset (in bytes).
+ *  @return
+ *      True if succeed.
+ */
+static bool seek_file(FILE *file, uint64_t offset) noexcept {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+/**
+ *  Write bytes at an offset of a file.
+ * 
+ *  @param file
+ *      The file.
+ *  @param offset
+ *      The offset (in bytes).
+ *  @param bytes
+ *      The bytes.
+ *  @param size
+ *      The count of bytes.
+ *  @return
+ *      True if succeed.
+ */
+static bool write_at(
+    FILE           *file,
+    uint64_t        offset,
+    const uint8_t  *bytes,
+    size_t          size
+) noexcept {
+    return seek_file(file, offset) && fwrite(bytes, 1U, size, file) == size;
+}
+
+/**
+ *  Get the WAV format code and the bits of each sample.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @param bits
+ *      The bits of each sample (output).
+ *  @return
+ *      The format code (0 if not supported).
+ */
+static uint16_t get_format_code(
+    xap::audioio::SampleFormat  sample_format,
+    uint16_t                   &bits
+) noexcept {
+    switch (sample_format) {
+    case xap::audioio::SAMPLEFORMAT_INT16:
+        bits = 16U;
+        return 1U;
+    case xap::audioio::SAMPLEFORMAT_INT32:
+        bits = 32U;
+        return 1U;
+    case xap::audioio::SAMPLEFORMAT_FLOAT32:
+        bits = 32U;
+        return 3U;
+    case xap::audioio::SAMPLEFORMAT_ALAW:
+        bits = 8U;
+        return 6U;
+    case xap::audioio::SAMPLEFORMAT_ULAW:
+        bits = 8U;
+        return 7U;
+    default:
+        bits = 0U;
+        return 0U;
+    }
+}
+
+#if defined(__SSE2__)
+
+/**
+ *  Sum the lanes of a vector.
+ * 
+ *  @param v
+ *      The vector.
+ *  @return
+ *      The sum.
+ */
+static inline float sse2_sum(__m128 v) noexcept {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+#endif  //  #if defined(__SSE2__)
+
+/**
+ *  Sum the squares of samples (vectorized if supported).
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param count
+ *      The count of samples.
+ *  @return
+ *      The sum (in the unit of the samples squared).
+ */
+static float sum_squares_int16(const int16_t *samples, size_t count) noexcept {
+    float sum = 0.0F;
+    size_t i = 0U;
+#if defined(__SSE2__)
+    //  -32768 is clamped, two of them would overflow a 32-bit pair sum.
+    const __m128i floor = _mm_set1_epi16(-32767);
+    __m128 lanes = _mm_setzero_ps();
+    for (; i + 8U <= count; i += 8U) {
+        __m128i v = _mm_max_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i)),
+            floor
+        );
+        lanes = _mm_add_ps(lanes, _mm_cvtepi32_ps(_mm_madd_epi16(v, v)));
+    }
+    sum = sse2_sum(lanes);
+#endif
+    for (; i < count; ++i) {
+        float value = static_cast<float>(samples[i]);
+        sum += value * value;
+    }
+    return sum;
+}
+static float sum_squares_int32(const int32_t *samples, size_t count) noexcept {
+    float sum = 0.0F;
+    size_t i = 0U;
+#if defined(__SSE2__)
+    __m128 lanes = _mm_setzero_ps();
+    for (; i + 4U <= count; i += 4U) {
+        __m128 v = _mm_cvtepi32_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i))
+        );
+        lanes = _mm_add_ps(lanes, _mm_mul_ps(v, v));
+    }
+    sum = sse2_sum(lanes);
+#endif
+    for (; i < count; ++i) {
+        float value = static_cast<float>(samples[i]);
+        sum += value * value;
+    }
+    return sum;
+}
+static float sum_squares_float32(const float *samples, size_t count) noexcept {
+    float sum = 0.0F;
+    size_t i = 0U;
+#if defined(__SSE2__)
+    __m128 lanes = _mm_setzero_ps();
+    for (; i + 4U <= count; i += 4U) {
+        __m128 v = _mm_loadu_ps(samples + i);
+        lanes = _mm_add_ps(lanes, _mm_mul_ps(v, v));
+    }
+    sum = sse2_sum(lanes);
+#endif
+    for (; i < count; ++i) {
+        sum += samples[i] * samples[i];
+    }
+    return sum;
+}
+
+//
+//  AudioFileWriter constructor & destructor.
+//
+
+/**
+ *  Construct the object (create the file and write the header).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format or the options are invalid.
+ * 
+ *          - xap::audioio::ERROR_IO:
+ *              The file cannot be created or written.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              The writer thread cannot be started.
+ * 
+ *  @param path
+ *      The path of the file (replaced if it exists).
+ *  @param format
+ *      The audio format (16-bit, 32-bit, 32-bit float or G.711).
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+AudioFileWriter::AudioFileWriter(
+    const char                                   *path,
+    const xap::audioio::AudioFormat              &format,
+    const xap::audioio::AudioFileWriterOptions   &options,
+    xap::audioio::IAllocator                     *allocator
+) :
+    m_format(format),
+    m_options(options),
+    m_file(nullptr),
+    m_ring(nullptr),
+    m_capacity(options.buffer_frames),
+    m_frame_size(xap::audioio::get_frame_size(format)),
+    m_granularity(0U),
+    m_hangover(
+        static_cast<uint64_t>(format.sample_rate) * 
+            options.silence_hangover / 1000U
+    ),
+    m_silence_energy(
+        static_cast<float>(
+            pow(10.0, static_cast<double>(options.silence_threshold) / 10.0)
+        )
+    ),
+    m_head(0U),
+    m_tail(0U),
+    m_dropped_count(0U),
+    m_trimmed_count(0U),
+    m_has_error(false),
+    m_is_closed(false),
+    m_pending_entries(nullptr),
+    m_pending_trims(nullptr),
+    m_source_count(0U),
+    m_silent_count(0U),
+    m_trim_offset(0U),
+    m_trim(),
+    m_has_trim(false),
+    m_written_count(0U),
+    m_entries(
+        xap::audioio::StlAllocator<xap::audioio::AudioFileIndexEntry>(
+            xap::audioio::resolve_allocator(allocator)
+        )
+    ),
+    m_trims(
+        xap::audioio::StlAllocator<xap::audioio::AudioFileTrimEntry>(
+            xap::audioio::resolve_allocator(allocator)
+        )
+    )
+{
+    uint16_t bits = 0U;
+    uint16_t code = get_format_code(format.sample_format, bits);
+    if (code == 0U || 
+        format.channel_count == 0U || 
+        format.sample_rate == 0U || 
+        options.buffer_frames == 0U || 
+        (options.trim_silence && 
+            (options.index_interval == 0U || 
+             !(options.silence_threshold <= 0.0F)))) {
+        throw xap::audioio::Exception(
+            "Invalid format or options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+    if (options.index_interval != 0U) {
+        this->m_granularity = std::max<uint64_t>(
+            static_cast<uint64_t>(format.sample_rate) * 
+                options.index_interval / 1000U,
+            1U
+        );
+    }
+
+    //
+    //  Header (the sizes are written when the file is closed).
+    //
+    uint8_t header[AUDIOFILEWRITER_DATA_OFFSET];
+    memset(header, 0, sizeof(header));
+    memcpy(header, "RIFF", 4U);
+    memcpy(header + 8, "WAVE", 4U);
+    memcpy(header + AUDIOFILEWRITER_JUNK_OFFSET, "JUNK", 4U);
+    store_u32_le(
+        header + AUDIOFILEWRITER_JUNK_OFFSET + 4,
+        static_cast<uint32_t>(AUDIOFILEWRITER_JUNK_SIZE)
+    );
+    uint8_t *chunk = header + AUDIOFILEWRITER_JUNK_OFFSET + 8 + 
+                     AUDIOFILEWRITER_JUNK_SIZE;
+    memcpy(chunk, "fmt ", 4U);
+    store_u32_le(chunk + 4, 18U);
+    store_u16_le(chunk + 8, code);
+    store_u16_le(chunk + 10, format.channel_count);
+    store_u32_le(chunk + 12, format.sample_rate);
+    store_u32_le(
+        chunk + 16,
+        static_cast<uint32_t>(format.sample_rate * this->m_frame_size)
+    );
+    store_u16_le(chunk + 20, static_cast<uint16_t>(this->m_frame_size));
+    store_u16_le(chunk + 22, bits);
+    memcpy(header + AUDIOFILEWRITER_DATA_SIZE_OFFSET - 4, "data", 4U);
+
+    this->m_file = fopen(path, "wb");
+    if (this->m_file == nullptr) {
+        throw xap::audioio::Exception(
+            "Cannot create the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+    try {
+        if (fwrite(header, 1U, sizeof(header), this->m_file) != 
+                sizeof(header)) {
+            throw xap::audioio::Exception(
+                "Cannot write the audio file.",
+                xap::audioio::ERROR_IO
+            );
+        }
+        this->m_ring = static_cast<uint8_t *>(
+            xap::audioio::allocate_object(
+                allocator,
+                this->m_capacity * this->m_frame_size
+            )
+        );
+        this->m_pending_entries = xap::audioio::new_object<
+            xap::audioio::MpscQueue<xap::audioio::AudioFileIndexEntry>
+        >(allocator, AUDIOFILEWRITER_ENTRY_CAPACITY, allocator);
+        try {
+            if (options.trim_silence) {
+                this->m_pending_trims = xap::audioio::new_object<
+                    xap::audioio::MpscQueue<xap::audioio::AudioFileTrimEntry>
+                >(allocator, AUDIOFILEWRITER_TRIM_CAPACITY, allocator);
+            }
+            try {
+                get_flusher().add(this);
+            } catch (...) {
+                if (this->m_pending_trims != nullptr) {
+                    this->m_pending_trims->~MpscQueue<
+                        xap::audioio::AudioFileTrimEntry
+                    >();
+                    xap::audioio::free_object(this->m_pending_trims);
+                }
+                throw;
+            }
+        } catch (...) {
+            this->m_pending_entries->~MpscQueue<
+                xap::audioio::AudioFileIndexEntry
+            >();
+            xap::audioio::free_object(this->m_pending_entries);
+            throw;
+        }
+    } catch (...) {
+        xap::audioio::free_object(this->m_ring);
+        fclose(this->m_file);
+        remove(path);
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object (close the file, errors are ignored).
+ */
+AudioFileWriter::~AudioFileWriter() noexcept {
+    try {
+        this->close();
+    } catch (...) {
+        //  Do nothing.
+    }
+    this->m_pending_entries->~MpscQueue<xap::audioio::AudioFileIndexEntry>();
+    xap::audioio::free_object(this->m_pending_entries);
+    if (this->m_pending_trims != nullptr) {
+        this->m_pending_trims->~MpscQueue<xap::audioio::AudioFileTrimEntry>();
+        xap::audioio::free_object(this->m_pending_trims);
+    }
+}
+
+//
+//  AudioFileWriter public methods.
+//
+
+/**
+ *  Append audio data (on the audio thread, never blocks on I/O).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio data mismatched.
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The file was closed.
+ * 
+ *          - xap::audioio::ERROR_IO:
+ *              The writer thread failed to write the file.
+ * 
+ *  @param data
+ *      The audio data (unchanged).
+ */
+void AudioFileWriter::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_format.sample_format || 
+        data.get_channel_count() != this->m_format.channel_count || 
+        data.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (this->m_is_closed.load(std::memory_order_relaxed)) {
+        throw xap::audioio::Exception(
+            "The audio file was closed.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    if (this->m_has_error.load(std::memory_order_acquire)) {
+        throw xap::audioio::Exception(
+            "Cannot write the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+
+    size_t frame_count = data.get_frame_count();
+    uint64_t source_frame = this->m_source_count;
+    this->m_source_count = source_frame + frame_count;
+
+    //
+    //  Silence trimming (the beginning of each silent span is kept). While 
+    //  a trim map entry waits for room in the queue, nothing is trimmed.
+    //
+    if (this->m_options.trim_silence) {
+        if (this->m_has_trim && 
+            this->m_pending_trims->try_push(this->m_trim)) {
+            this->m_has_trim = false;
+        }
+        if (!this->is_silent(data)) {
+            this->m_silent_count = 0U;
+        } else {
+            bool is_kept = (this->m_silent_count < this->m_hangover) || 
+                           this->m_has_trim;
+            this->m_silent_count += frame_count;
+            if (!is_kept) {
+                this->m_trimmed_count.fetch_add(
+                    frame_count,
+                    std::memory_order_relaxed
+                );
+                return;
+            }
+        }
+    }
+
+    //
+    //  Copy the frames which fit (in up to two pieces at the wrap).
+    //
+    uint64_t head = this->m_head.load(std::memory_order_relaxed);
+    uint64_t tail = this->m_tail.load(std::memory_order_acquire);
+    size_t used = static_cast<size_t>(head - tail);
+    size_t count = std::min(frame_count, this->m_capacity - used);
+    const uint8_t *source = data.get_pointer();
+    size_t index = static_cast<size_t>(head % this->m_capacity);
+    size_t first = std::min(count, this->m_capacity - index);
+    memcpy(
+        this->m_ring + index * this->m_frame_size,
+        source,
+        first * this->m_frame_size
+    );
+    memcpy(
+        this->m_ring,
+        source + first * this->m_frame_size,
+        (count - first) * this->m_frame_size
+    );
+
+    //
+    //  Index entries of the positions in this period, the period was 
+    //  captured just before now.
+    //
+    uint64_t granularity = this->m_granularity;
+    if (granularity != 0U && count != 0U) {
+        int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+        double rate = static_cast<double>(this->m_format.sample_rate);
+        uint64_t frame = (head + granularity - 1U) / granularity * granularity;
+        for (; frame < head + count; frame += granularity) {
+            double age = static_cast<double>(
+                frame_count - static_cast<size_t>(frame - head)
+            ) / rate;
+            xap::audioio::AudioFileIndexEntry entry;
+            entry.frame = frame;
+            entry.time = now - static_cast<int64_t>(age * 1000000.0);
+            entry.offset = 0U;
+
+            //  An entry which does not fit is skipped (the index is searched, 
+            //  so a missing entry only makes its interval longer).
+            this->m_pending_entries->try_push(entry);
+        }
+    }
+
+    //
+    //  Trim map entry where the recording resumed after trimmed (or 
+    //  dropped) frames.
+    //
+    if (this->m_options.trim_silence && 
+        count != 0U && 
+        source_frame - head != this->m_trim_offset) {
+        this->m_trim_offset = source_frame - head;
+        xap::audioio::AudioFileTrimEntry trim;
+        trim.frame = head;
+        trim.source_frame = source_frame;
+
+        //  The entries must stay in order, so an entry which does not fit 
+        //  waits behind the pending one (which is only replaced if frames 
+        //  were dropped meanwhile, the writer thread fell far behind then).
+        if (this->m_has_trim || !this->m_pending_trims->try_push(trim)) {
+            this->m_trim = trim;
+            this->m_has_trim = true;
+        }
+    }
+
+    this->m_head.store(head + count, std::memory_order_release);
+    if (count != frame_count) {
+        this->m_dropped_count.fetch_add(
+            frame_count - count,
+            std::memory_order_relaxed
+        );
+    }
+    if (used + count >= this->m_capacity / 4U) {
+        get_flusher().wake();
+    }
+}
+
+/**
+ *  Close the file (write the remaining audio data, the index and the 
+ *  sizes). The stage must not be processing meanwhile (e.g. stop the 
+ *  recorder first).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file cannot be written (xap::audioio::ERROR_IO).
+ */
+void AudioFileWriter::close() {
+    if (this->m_is_closed.exchange(true)) {
+        return;
+    }
+    get_flusher().remove(this);
+    this->flush();
+    bool is_succeed = !this->m_has_error.load() && this->finalize();
+    is_succeed = (fclose(this->m_file) == 0) && is_succeed;
+    xap::audioio::free_object(this->m_ring);
+    this->m_file = nullptr;
+    this->m_ring = nullptr;
+    if (!is_succeed) {
+        throw xap::audioio::Exception(
+            "Cannot write the audio file.",
+            xap::audioio::ERROR_IO
+        );
+    }
+}
+
+/**
+ *  Get the count of frames appended.
+ * 
+ *  @return
+ *      The count of frames.
+ */
+uint64_t AudioFileWriter::get_frame_count() const noexcept {
+    return this->m_head.load(std::memory_order_acquire);
+}
+
+/**
+ *  Get the count of frames dropped (the writer thread fell behind).
+ * 
+ *  @return
+ *      The count of frames.
+ */
+uint64_t AudioFileWriter::get_dropped_frame_count() const noexcept {
+    return this->m_dropped_count.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Get the count of silent frames trimmed.
+ * 
+ *  @return
+ *      The count of frames.
+ */
+uint64_t AudioFileWriter::get_trimmed_frame_count() const noexcept {
+    return this->m_trimmed_count.load(std::memory_order_relaxed);
+}
+
+//
+//  AudioFileWriter private methods.
+//
+
+/**
+ *  Test whether a period is silent.
+ * 
+ *  @param data
+ *      The audio data.
+ *  @return
+ *      True if the energy of the period is below the threshold.
+ */
+bool AudioFileWriter::is_silent(
+    const xap::audioio::AudioBuffer &data
+) const noexcept {
+    size_t count = data.get_frame_count() * this->m_format.channel_count;
+    const uint8_t *samples = data.get_pointer();
+    xap::audioio::SampleFormat sample_format = this->m_format.sample_format;
+
+    //  The threshold is scaled to the unit of the samples squared (the full 
+    //  scale of G.711 samples is the one of the decoded 16-bit samples).
+    double limit = static_cast<double>(this->m_silence_energy) * 
+                   static_cast<double>(count);
+    if (sample_format == xap::audioio::SAMPLEFORMAT_INT32) {
+        limit *= 4611686018427387904.0;
+    } else if (sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) {
+        limit *= 1073741824.0;
+    }
+
+    //
+    //  The sum stops at the first block which exceeds the threshold.
+    //
+    double sum = 0.0;
+    int16_t decoded[AUDIOFILEWRITER_SILENCE_BLOCK];
+    for (size_t i = 0U; i < count; i += AUDIOFILEWRITER_SILENCE_BLOCK) {
+        size_t block = std::min(count - i, AUDIOFILEWRITER_SILENCE_BLOCK);
+        switch (sample_format) {
+        case xap::audioio::SAMPLEFORMAT_INT16:
+            sum += sum_squares_int16(
+                reinterpret_cast<const int16_t *>(samples) + i,
+                block
+            );
+            break;
+        case xap::audioio::SAMPLEFORMAT_INT32:
+            sum += sum_squares_int32(
+                reinterpret_cast<const int32_t *>(samples) + i,
+                block
+            );
+            break;
+        case xap::audioio::SAMPLEFORMAT_FLOAT32:
+            sum += sum_squares_float32(
+                reinterpret_cast<const float *>(samples) + i,
+                block
+            );
+            break;
+        case xap::audioio::SAMPLEFORMAT_ALAW:
+            xap::audioio::g711_alaw_decode(samples + i, decoded, block);
+            sum += sum_squares_int16(decoded, block);
+            break;
+        default:
+            xap::audioio::g711_ulaw_decode(samples + i, decoded, block);
+            sum += sum_squares_int16(decoded, block);
+            break;
+        }
+        if (sum >= limit) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *  Write the buffered audio data and collect the index entries (on the 
+ *  writer thread).
+ */
+void AudioFileWriter::flush() noexcept {
+    uint64_t head = this->m_head.load(std::memory_order_acquire);
+    uint64_t tail = this->m_tail.load(std::memory_order_relaxed);
+    while (tail != head) {
+        size_t index = static_cast<size_t>(tail % this->m_capacity);
+        size_t count = std::min(
+            static_cast<size_t>(head - tail),
+            this->m_capacity - index
+        );
+        if (!this->m_has_error.load(std::memory_order_relaxed)) {
+            if (fwrite(
+                    this->m_ring + index * this->m_frame_size,
+                    this->m_frame_size,
+                    count,
+                    this->m_file
+                ) != count) {
+                //  The audio data is discarded from now on.
+                this->m_has_error.store(true, std::memory_order_release);
+            } else {
+                this->m_written_count += count;
+            }
+        }
+        tail += count;
+        this->m_tail.store(tail, std::memory_order_release);
+    }
+
+    xap::audioio::AudioFileIndexEntry entry;
+    while (this->m_pending_entries->try_pop(entry)) {
+        entry.offset = AUDIOFILEWRITER_DATA_OFFSET + 
+                       entry.frame * this->m_frame_size;
+        try {
+            this->m_entries.push_back(entry);
+        } catch (...) {
+            //  The entry is skipped.
+        }
+    }
+
+    if (this->m_pending_trims != nullptr) {
+        xap::audioio::AudioFileTrimEntry trim;
+        while (this->m_pending_trims->try_pop(trim)) {
+            try {
+                this->m_trims.push_back(trim);
+            } catch (...) {
+                //  The original timeline is lost (reported as a write 
+                //  error).
+                this->m_has_error.store(true, std::memory_order_release);
+            }
+        }
+    }
+}
+
+/**
+ *  Write the index and the sizes.
+ * 
+ *  @return
+ *      True if succeed.
+ */
+bool AudioFileWriter::finalize() noexcept {
+    FILE *file = this->m_file;
+    uint64_t data_size = this->m_written_count * this->m_frame_size;
+    if ((data_size & 1U) != 0U && fputc(0, file) == EOF) {
+        return false;
+    }
+    uint64_t end = AUDIOFILEWRITER_DATA_OFFSET + data_size + (data_size & 1U);
+
+    //
+    //  Seek index chunk.
+    //
+    if (this->m_granularity != 0U) {
+        uint8_t header[16];
+        memcpy(header, "xidx", 4U);
+        store_u32_le(
+            header + 4,
+            static_cast<uint32_t>(8U + 24U * this->m_entries.size())
+        );
+        store_u32_le(header + 8, AUDIOFILEWRITER_INDEX_VERSION);
+        store_u32_le(header + 12, static_cast<uint32_t>(this->m_granularity));
+        if (fwrite(header, 1U, sizeof(header), file) != sizeof(header)) {
+            return false;
+        }
+        end += sizeof(header);
+        for (const xap::audioio::AudioFileIndexEntry &entry : this->m_entries) {
+            if (entry.frame >= this->m_written_count) {
+                break;
+            }
+            uint8_t bytes[24];
+            store_u64_le(bytes, entry.frame);
+            store_u64_le(bytes + 8, static_cast<uint64_t>(entry.time));
+            store_u64_le(bytes + 16, entry.offset);
+            if (fwrite(bytes, 1U, sizeof(bytes), file) != sizeof(bytes)) {
+                return false;
+            }
+            end += sizeof(bytes);
+        }
+
+        //  Entries of frames which were never written are left out.
+        uint64_t index_size = end - AUDIOFILEWRITER_DATA_OFFSET - data_size - 
+                              (data_size & 1U) - 8U;
+        uint8_t size[4];
+        store_u32_le(size, static_cast<uint32_t>(index_size));
+        if (!write_at(file, end - index_size - 4U, size, 4U) || 
+            !seek_file(file, end)) {
+            return false;
+        }
+    }
+
+    //
+    //  Trim map chunk (entries of frames which were never written are left 
+    //  out).
+    //
+    size_t trim_count = 0U;
+    while (trim_count < this->m_trims.size() && 
+           this->m_trims[trim_count].frame < this->m_written_count) {
+        ++trim_count;
+    }
+    if (trim_count != 0U) {
+        uint8_t header[12];
+        memcpy(header, "xtrm", 4U);
+        store_u32_le(header + 4, static_cast<uint32_t>(4U + 16U * trim_count));
+        store_u32_le(header + 8, AUDIOFILEWRITER_TRIM_VERSION);
+        if (fwrite(header, 1U, sizeof(header), file) != sizeof(header)) {
+            return false;
+        }
+        end += sizeof(header);
+        for (size_t i = 0U; i < trim_count; ++i) {
+            uint8_t bytes[16];
+            store_u64_le(bytes, this->m_trims[i].frame);
+            store_u64_le(bytes + 8, this->m_trims[i].source_frame);
+            if (fwrite(bytes, 1U, sizeof(bytes), file) != sizeof(bytes)) {
+                return false;
+            }
+            end += sizeof(bytes);
+        }
+    }
+
+    //
+    //  Sizes (RF64 if the file exceeds the 32-bit sizes of RIFF).
+    //
+    uint64_t riff_size = end - 8U;
+    if (riff_size > 0xFFFFFFFFU) {
+        uint8_t ds64[8U + AUDIOFILEWRITER_JUNK_SIZE];
+        memset(ds64, 0, sizeof(ds64));
+        memcpy(ds64, "ds64", 4U);
+        store_u32_le(
+            ds64 + 4, 
+            static_cast<uint32_t>(AUDIOFILEWRITER_JUNK_SIZE)
+        );
+        store_u64_le(ds64 + 8, riff_size);
+        store_u64_le(ds64 + 16, data_size);
+        store_u64_le(ds64 + 24, this->m_written_count);
+        const uint8_t magic[8] = {'R', 'F', '6', '4', 0xFF, 0xFF, 0xFF, 0xFF};
+        const uint8_t unknown[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+        if (!write_at(file, 0U, magic, sizeof(magic)) || 
+            !write_at(file, AUDIOFILEWRITER_JUNK_OFFSET, ds64, sizeof(ds64)) || 
+            !write_at(
+                file,
+                AUDIOFILEWRITER_DATA_SIZE_OFFSET,
+                unknown,
+                sizeof(unknown)
+            )) {
+            return false;
+        }
+    } else {
+        uint8_t size[4];
+        store_u32_le(size, static_cast<uint32_t>(riff_size));
+        if (!write_at(file, 4U, size, 4U)) {
+            return false;
+        }
+        store_u32_le(size, static_cast<uint32_t>(data_size));
+        if (!write_at(file, AUDIOFILEWRITER_DATA_SIZE_OFFSET, size, 4U)) {
+            return false;
+        }
+    }
+    return fflush(file) == 0;
+}
+
+}  //  namespace audioio
+}  //  namespace xap
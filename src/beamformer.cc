@@ -0,0 +1,1094 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fft_p.h"
+#include "fir_p.h"
+#include "microphonearray_p.h"
+
+#include <chrono>
+#include <complex>
+#include <math.h>
+#include <string.h>
+#include <system_error>
+#include <xap/audioio/beamformer.h>
+#include <xap/audioio/error.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of taps of the fractional delay interpolators.
+const static size_t BEAMFORMER_TAPS = 16U;
+
+//  Count of frames processed per pass (delay-and-sum).
+const static size_t BEAMFORMER_CHUNK_FRAMES = 256U;
+
+//  Count of output blocks.
+const static size_t BEAMFORMER_POOL_BLOCK_COUNT = 16U;
+
+//  Flag of the exchanged weight set: published but not acquired yet.
+const static uint32_t BEAMFORMER_FRESH = 4U;
+
+//  States of the covariance snapshot.
+const static uint32_t BEAMFORMER_SNAPSHOT_IDLE = 0U;
+const static uint32_t BEAMFORMER_SNAPSHOT_READY = 1U;
+
+//  Longest time the worker thread sleeps without checking for work (the 
+//  audio thread notifies it without locking, so a wakeup can be missed).
+const static std::chrono::milliseconds BEAMFORMER_WORKER_TIMEOUT(20);
+
+//
+//  Private functions.
+//
+
+/**
+ *  Validate the options of a beamformer.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the parameters are invalid (xap::audioio::ERROR_PARAMETER) 
+ *      or the input format is not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param input_format
+ *      The input audio format.
+ *  @param array
+ *      The microphone array.
+ *  @param options
+ *      The options.
+ *  @return
+ *      The count of channels.
+ */
+static size_t validate_options(
+    const xap::audioio::AudioFormat        &input_format,
+    const xap::audioio::MicrophoneArray    &array,
+    const xap::audioio::BeamformerOptions  &options
+) {
+    if (input_format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+        input_format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) {
+        throw xap::audioio::Exception(
+            "Only 16-bit or 32-bit float audio data is supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t channel_count = static_cast<size_t>(input_format.channel_count);
+    xap::audioio::microphonearray_validate(array, channel_count);
+    if (input_format.sample_rate == 0U || options.max_frames == 0U || 
+        (options.method != xap::audioio::BEAMFORMER_DELAYANDSUM && 
+         options.method != xap::audioio::BEAMFORMER_MVDR)) {
+        throw xap::audioio::Exception(
+            "Invalid beamformer options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (options.method == xap::audioio::BEAMFORMER_MVDR) {
+        size_t size = static_cast<size_t>(options.fft_size);
+        if (size < 16U || (size & (size - 1U)) != 0U || 
+            options.covariance_time == 0U || 
+            !(options.diagonal_loading >= 0.0F)) {
+            throw xap::audioio::Exception(
+                "Invalid MVDR options.",
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+    }
+    return channel_count;
+}
+
+/**
+ *  Build the audio format of the beamformer state (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Build the output audio format of a beamformer (mono).
+ * 
+ *  @param input_format
+ *      The input audio format.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_output_format(
+    const xap::audioio::AudioFormat &input_format
+) {
+    xap::audioio::AudioFormat format = input_format;
+    format.channel_count = 1U;
+    return format;
+}
+
+//
+//  Beamformer constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The array mismatched the input format or the options are 
+ *              invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The input format is neither 16-bit nor 32-bit float.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              The worker thread could not be started.
+ * 
+ *  @param input_format
+ *      The input audio format (one channel per microphone).
+ *  @param array
+ *      The geometry of the microphone array.
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+Beamformer::Beamformer(
+    const xap::audioio::AudioFormat        &input_format,
+    const xap::audioio::MicrophoneArray    &array,
+    const xap::audioio::BeamformerOptions  &options,
+    xap::audioio::IAllocator               *allocator
+) :
+    m_input_format(input_format),
+    m_output_format(build_output_format(input_format)),
+    m_array(array),
+    m_options(options),
+    m_channel_count(validate_options(input_format, array, options)),
+    m_max_delay(0U),
+    m_history(0U),
+    m_line_length(0U),
+    m_lines(),
+    m_fft(nullptr),
+    m_hop(0U),
+    m_bin_count(0U),
+    m_bin_stride(0U),
+    m_pair_count(0U),
+    m_fill(0U),
+    m_update_hops(1U),
+    m_hops(0U),
+    m_smoothing(0.0F),
+    m_window(),
+    m_frames(),
+    m_spectra(),
+    m_covariance(),
+    m_overlap(),
+    m_queue(),
+    m_queue_count(0U),
+    m_weight_size(0U),
+    m_weights(),
+    m_front(0U),
+    m_exchange(1U),
+    m_snapshot(),
+    m_worker_covariance(),
+    m_snapshot_state(BEAMFORMER_SNAPSHOT_IDLE),
+    m_direction_version(0U),
+    m_azimuth(options.azimuth),
+    m_elevation(options.elevation),
+    m_is_stopping(false),
+    m_wakeup_lock(),
+    m_wakeup(),
+    m_worker(),
+    m_scratch(),
+    m_pool(
+        options.max_frames * 
+            xap::audioio::get_sample_size(input_format.sample_format),
+        BEAMFORMER_POOL_BLOCK_COUNT,
+        allocator
+    )
+{
+    size_t channel_count = this->m_channel_count;
+    double sample_rate = static_cast<double>(input_format.sample_rate);
+    xap::audioio::AudioFormat state_format = 
+        build_state_format(input_format.sample_rate);
+
+    if (options.method == xap::audioio::BEAMFORMER_DELAYANDSUM) {
+        //
+        //  Delay lines: the longest delay is the travel time across the 
+        //  aperture of the array.
+        //
+        this->m_max_delay = static_cast<size_t>(ceil(
+            xap::audioio::microphonearray_get_aperture(array) / 
+            static_cast<double>(array.speed_of_sound) * sample_rate
+        )) + 1U;
+        this->m_history = this->m_max_delay + BEAMFORMER_TAPS - 1U;
+        this->m_line_length = this->m_history + BEAMFORMER_CHUNK_FRAMES;
+        this->m_lines = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            this->m_line_length * channel_count,
+            allocator
+        );
+        memset(this->m_lines.get_pointer(), 0, this->m_lines.get_length());
+        this->m_scratch = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            BEAMFORMER_CHUNK_FRAMES,
+            allocator
+        );
+
+        //  Per channel: the delay, then the taps.
+        this->m_weight_size = channel_count * (1U + BEAMFORMER_TAPS);
+    } else {
+        size_t size = static_cast<size_t>(options.fft_size);
+        this->m_hop = size / 2U;
+        this->m_bin_count = size / 2U + 1U;
+        this->m_bin_stride = (this->m_bin_count + 3U) &
+                             ~static_cast<size_t>(3U);
+        this->m_pair_count = channel_count * (channel_count + 1U) / 2U;
+        this->m_smoothing = static_cast<float>(1.0 - exp(
+            -static_cast<double>(this->m_hop) / 
+            (sample_rate * static_cast<double>(options.covariance_time) / 
+                1000.0)
+        ));
+        this->m_update_hops = static_cast<size_t>(
+            sample_rate * static_cast<double>(options.update_interval) / 
+            1000.0 / static_cast<double>(this->m_hop)
+        );
+        if (this->m_update_hops == 0U) {
+            this->m_update_hops = 1U;
+        }
+
+        //
+        //  Square root of the periodic Hann window for both analysis and 
+        //  synthesis (the squares overlap-add to 1 at a hop of size / 2).
+        //
+        this->m_window = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            size,
+            allocator
+        );
+        float *window = this->m_window.get_samples<float>();
+        for (size_t n = 0U; n < size; ++n) {
+            window[n] = static_cast<float>(sqrt(
+                0.5 - 0.5 * cos(
+                    2.0 * xap::audioio::MICROPHONEARRAY_PI * 
+                    static_cast<double>(n) / static_cast<double>(size)
+                )
+            ));
+        }
+
+        size_t spectrum = 2U * this->m_bin_stride;
+        size_t covariance = this->m_pair_count * spectrum;
+        this->m_frames = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            size * channel_count,
+            allocator
+        );
+        this->m_spectra = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            spectrum * channel_count,
+            allocator
+        );
+        this->m_covariance = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            covariance,
+            allocator
+        );
+        this->m_snapshot = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            covariance,
+            allocator
+        );
+        this->m_worker_covariance = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            covariance,
+            allocator
+        );
+        this->m_overlap = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            size,
+            allocator
+        );
+        this->m_queue = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            options.max_frames + size,
+            allocator
+        );
+
+        //  Output spectrum and frame.
+        this->m_scratch = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            spectrum + size,
+            allocator
+        );
+        memset(this->m_frames.get_pointer(), 0, this->m_frames.get_length());
+        memset(
+            this->m_spectra.get_pointer(),
+            0,
+            this->m_spectra.get_length()
+        );
+        memset(
+            this->m_covariance.get_pointer(),
+            0,
+            this->m_covariance.get_length()
+        );
+        memset(
+            this->m_worker_covariance.get_pointer(),
+            0,
+            this->m_worker_covariance.get_length()
+        );
+        memset(
+            this->m_overlap.get_pointer(),
+            0,
+            this->m_overlap.get_length()
+        );
+        memset(this->m_scratch.get_pointer(), 0, this->m_scratch.get_length());
+
+        //
+        //  Prime the output queue with one hop of silence, so that a hop of 
+        //  output is always ready before it is needed.
+        //
+        memset(this->m_queue.get_pointer(), 0, this->m_hop * sizeof(float));
+        this->m_queue_count = this->m_hop;
+
+        this->m_fft = xap::audioio::new_object<xap::audioio::Fft>(
+            allocator != nullptr ? 
+                allocator :
+                xap::audioio::get_default_allocator(),
+            size,
+            allocator
+        );
+
+        //  Per channel: the real parts, then the imaginary parts.
+        this->m_weight_size = channel_count * spectrum;
+    }
+
+    try {
+        this->m_weights = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            3U * this->m_weight_size,
+            allocator
+        );
+        memset(this->m_weights.get_pointer(), 0, this->m_weights.get_length());
+        this->compute_weights(0U, options.azimuth, options.elevation);
+
+        try {
+            this->m_worker = std::thread(&Beamformer::run_worker, this);
+        } catch (std::system_error &error) {
+            throw xap::audioio::Exception(
+                error.what(),
+                xap::audioio::ERROR_SYSTEMCALL
+            );
+        }
+    } catch (...) {
+        if (this->m_fft != nullptr) {
+            this->m_fft->~Fft();
+            xap::audioio::free_object(this->m_fft);
+        }
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object (stop the worker thread).
+ */
+Beamformer::~Beamformer() noexcept {
+    {
+        std::lock_guard<std::mutex> locked(this->m_wakeup_lock);
+        this->m_is_stopping.store(true);
+    }
+    this->m_wakeup.notify_one();
+    this->m_worker.join();
+
+    if (this->m_fft != nullptr) {
+        this->m_fft->~Fft();
+        xap::audioio::free_object(this->m_fft);
+    }
+}
+
+//
+//  Beamformer public methods.
+//
+
+/**
+ *  Process audio data (replaced by the mono output).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio data mismatched.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              Too many frames (more than options.max_frames).
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              No output block is available.
+ * 
+ *  @param data
+ *      The audio data.
+ */
+void Beamformer::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_input_format.sample_format || 
+        data.get_channel_count() != this->m_input_format.channel_count || 
+        data.get_sample_rate() != this->m_input_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t frame_count = data.get_frame_count();
+    if (frame_count > this->m_options.max_frames) {
+        throw xap::audioio::Exception(
+            "Too many frames.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    xap::audioio::AudioBuffer output = xap::audioio::AudioBuffer::allocate(
+        this->m_pool,
+        this->m_output_format,
+        frame_count
+    );
+    output.set_timestamp(data.get_timestamp());
+
+    size_t channel_count = this->m_channel_count;
+    bool is_float = 
+        (this->m_input_format.sample_format == 
+            xap::audioio::SAMPLEFORMAT_FLOAT32);
+    const float *input_float = data.get_samples<float>();
+    const int16_t *input_int16 = data.get_samples<int16_t>();
+    float *output_float = output.get_samples<float>();
+    int16_t *output_int16 = output.get_samples<int16_t>();
+
+    if (this->m_options.method == xap::audioio::BEAMFORMER_DELAYANDSUM) {
+        float *lines = this->m_lines.get_samples<float>();
+        float *result = this->m_scratch.get_samples<float>();
+        for (size_t offset = 0U; offset < frame_count; ) {
+            size_t count = frame_count - offset;
+            if (count > BEAMFORMER_CHUNK_FRAMES) {
+                count = BEAMFORMER_CHUNK_FRAMES;
+            }
+
+            //
+            //  Deinterleave after the history.
+            //
+            for (size_t c = 0U; c < channel_count; ++c) {
+                float *line = lines + c * this->m_line_length + this->m_history;
+                size_t index = offset * channel_count + c;
+                for (size_t i = 0U; i < count; ++i) {
+                    line[i] = is_float ? 
+                        input_float[index] :
+                        static_cast<float>(input_int16[index]);
+                    index += channel_count;
+                }
+            }
+
+            this->acquire_weights();
+            this->process_delay_and_sum(count, result);
+            if (is_float) {
+                memcpy(output_float + offset, result, count * sizeof(float));
+            } else {
+                for (size_t i = 0U; i < count; ++i) {
+                    output_int16[offset + i] = 
+                        xap::audioio::fir_saturate_int16(result[i]);
+                }
+            }
+
+            //
+            //  Keep the history.
+            //
+            for (size_t c = 0U; c < channel_count; ++c) {
+                float *line = lines + c * this->m_line_length;
+                memmove(line, line + count, this->m_history * sizeof(float));
+            }
+            offset += count;
+        }
+    } else {
+        size_t size = static_cast<size_t>(this->m_options.fft_size);
+        size_t tail = size - this->m_hop;
+        float *frames = this->m_frames.get_samples<float>();
+        for (size_t offset = 0U; offset < frame_count; ) {
+            size_t count = this->m_hop - this->m_fill;
+            if (count > frame_count - offset) {
+                count = frame_count - offset;
+            }
+
+            //
+            //  Deinterleave into the newest hop of the analysis buffers.
+            //
+            for (size_t c = 0U; c < channel_count; ++c) {
+                float *frame = frames + c * size + tail + this->m_fill;
+                size_t index = offset * channel_count + c;
+                for (size_t i = 0U; i < count; ++i) {
+                    frame[i] = is_float ? 
+                        input_float[index] :
+                        static_cast<float>(input_int16[index]);
+                    index += channel_count;
+                }
+            }
+            this->m_fill += count;
+            offset += count;
+
+            if (this->m_fill == this->m_hop) {
+                this->process_hop();
+                this->m_fill = 0U;
+            }
+        }
+
+        //
+        //  Deliver the oldest frames of the output queue.
+        //
+        float *queue = this->m_queue.get_samples<float>();
+        if (is_float) {
+            memcpy(output_float, queue, frame_count * sizeof(float));
+        } else {
+            for (size_t i = 0U; i < frame_count; ++i) {
+                output_int16[i] = xap::audioio::fir_saturate_int16(queue[i]);
+            }
+        }
+        this->m_queue_count -= frame_count;
+        memmove(
+            queue,
+            queue + frame_count,
+            this->m_queue_count * sizeof(float)
+        );
+    }
+
+    data = output;
+}
+
+/**
+ *  Set the look direction (thread-safe, applied asynchronously by the 
+ *  worker thread).
+ * 
+ *  @param azimuth
+ *      The azimuth (in degrees).
+ *  @param elevation
+ *      The elevation (in degrees).
+ */
+void Beamformer::set_direction(float azimuth, float elevation) noexcept {
+    this->m_azimuth.store(azimuth);
+    this->m_elevation.store(elevation);
+    this->m_direction_version.fetch_add(1U, std::memory_order_release);
+    this->m_wakeup.notify_one();
+}
+
+/**
+ *  Get the output audio format.
+ * 
+ *  @return
+ *      The audio format.
+ */
+xap::audioio::AudioFormat Beamformer::get_output_format() const noexcept {
+    return this->m_output_format;
+}
+
+/**
+ *  Get the delay of the output (in frames, the largest one for 
+ *  BEAMFORMER_DELAYANDSUM).
+ * 
+ *  @return
+ *      The delay.
+ */
+size_t Beamformer::get_latency() const noexcept {
+    if (this->m_options.method == xap::audioio::BEAMFORMER_DELAYANDSUM) {
+        return this->m_max_delay + BEAMFORMER_TAPS / 2U - 1U;
+    }
+    return static_cast<size_t>(this->m_options.fft_size);
+}
+
+//
+//  Beamformer private methods.
+//
+
+/**
+ *  Delay, filter and sum a pass of deinterleaved frames.
+ * 
+ *  @param count
+ *      The count of frames.
+ *  @param output
+ *      The output.
+ */
+void Beamformer::process_delay_and_sum(size_t count, float *output) noexcept {
+    const float *weights = 
+        this->m_weights.get_samples<float>() + 
+        this->m_front * this->m_weight_size;
+    const float *lines = this->m_lines.get_samples<float>();
+    memset(output, 0, count * sizeof(float));
+    for (size_t c = 0U; c < this->m_channel_count; ++c) {
+        const float *channel = weights + c * (1U + BEAMFORMER_TAPS);
+        size_t delay = static_cast<size_t>(channel[0]);
+        const float *taps = channel + 1U;
+        const float *line = lines + c * this->m_line_length + 
+                            this->m_history - delay - (BEAMFORMER_TAPS - 1U);
+
+        //  Tap by tap, so that the inner loop over frames vectorizes.
+        for (size_t k = 0U; k < BEAMFORMER_TAPS; ++k) {
+            float tap = taps[k];
+            const float *delayed = line + k;
+            for (size_t i = 0U; i < count; ++i) {
+                output[i] += tap * delayed[i];
+            }
+        }
+    }
+}
+
+/**
+ *  Process one STFT hop (the input frames are in the analysis buffers), 
+ *  appending 'hop' frames to the output queue.
+ */
+void Beamformer::process_hop() noexcept {
+    size_t size = static_cast<size_t>(this->m_options.fft_size);
+    size_t stride = this->m_bin_stride;
+    size_t tail = size - this->m_hop;
+    size_t channel_count = this->m_channel_count;
+    const float *window = this->m_window.get_samples<float>();
+    float *frames = this->m_frames.get_samples<float>();
+    float *spectra = this->m_spectra.get_samples<float>();
+    float *covariance = this->m_covariance.get_samples<float>();
+    float *output_re = this->m_scratch.get_samples<float>();
+    float *output_im = output_re + stride;
+    float *frame = output_im + stride;
+
+    //
+    //  Analysis.
+    //
+    for (size_t c = 0U; c < channel_count; ++c) {
+        float *source = frames + c * size;
+        for (size_t n = 0U; n < size; ++n) {
+            frame[n] = source[n] * window[n];
+        }
+        float *spectrum = spectra + c * 2U * stride;
+        this->m_fft->forward(frame, spectrum, spectrum + stride);
+        memmove(source, source + this->m_hop, tail * sizeof(float));
+    }
+
+    //
+    //  Update the covariance estimates (upper triangle, R += a(x x^H - R)).
+    //
+    float a = this->m_smoothing;
+    float *pair = covariance;
+    for (size_t i = 0U; i < channel_count; ++i) {
+        const float *xi_re = spectra + i * 2U * stride;
+        const float *xi_im = xi_re + stride;
+        for (size_t j = i; j < channel_count; ++j) {
+            const float *xj_re = spectra + j * 2U * stride;
+            const float *xj_im = xj_re + stride;
+            float *r_re = pair;
+            float *r_im = pair + stride;
+            size_t b = 0U;
+#if defined(__SSE2__)
+            __m128 va = _mm_set1_ps(a);
+            for (; b < stride; b += 4U) {
+                __m128 ar = _mm_loadu_ps(xi_re + b);
+                __m128 ai = _mm_loadu_ps(xi_im + b);
+                __m128 br = _mm_loadu_ps(xj_re + b);
+                __m128 bi = _mm_loadu_ps(xj_im + b);
+                __m128 pr = _mm_add_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+                __m128 pi = _mm_sub_ps(_mm_mul_ps(ai, br), _mm_mul_ps(ar, bi));
+                __m128 rr = _mm_loadu_ps(r_re + b);
+                __m128 ri = _mm_loadu_ps(r_im + b);
+                _mm_storeu_ps(
+                    r_re + b,
+                    _mm_add_ps(rr, _mm_mul_ps(va, _mm_sub_ps(pr, rr)))
+                );
+                _mm_storeu_ps(
+                    r_im + b,
+                    _mm_add_ps(ri, _mm_mul_ps(va, _mm_sub_ps(pi, ri)))
+                );
+            }
+#endif
+            for (; b < stride; ++b) {
+                float pr = xi_re[b] * xj_re[b] + xi_im[b] * xj_im[b];
+                float pi = xi_im[b] * xj_re[b] - xi_re[b] * xj_im[b];
+                r_re[b] += a * (pr - r_re[b]);
+                r_im[b] += a * (pi - r_im[b]);
+            }
+            pair += 2U * stride;
+        }
+    }
+
+    //
+    //  Hand a snapshot to the worker thread periodically (skipped while it 
+    //  has not taken the previous one).
+    //
+    if (++(this->m_hops) >= this->m_update_hops && 
+        this->m_snapshot_state.load(std::memory_order_acquire) == 
+            BEAMFORMER_SNAPSHOT_IDLE) {
+        memcpy(
+            this->m_snapshot.get_pointer(),
+            covariance,
+            this->m_covariance.get_length()
+        );
+        this->m_snapshot_state.store(
+            BEAMFORMER_SNAPSHOT_READY,
+            std::memory_order_release
+        );
+        this->m_wakeup.notify_one();
+        this->m_hops = 0U;
+    }
+
+    //
+    //  Apply the weights (y = w^H x).
+    //
+    this->acquire_weights();
+    const float *weights = 
+        this->m_weights.get_samples<float>() + 
+        this->m_front * this->m_weight_size;
+    memset(output_re, 0, 2U * stride * sizeof(float));
+    for (size_t c = 0U; c < channel_count; ++c) {
+        const float *x_re = spectra + c * 2U * stride;
+        const float *x_im = x_re + stride;
+        const float *w_re = weights + c * 2U * stride;
+        const float *w_im = w_re + stride;
+        size_t b = 0U;
+#if defined(__SSE2__)
+        for (; b < stride; b += 4U) {
+            __m128 xr = _mm_loadu_ps(x_re + b);
+            __m128 xi = _mm_loadu_ps(x_im + b);
+            __m128 wr = _mm_loadu_ps(w_re + b);
+            __m128 wi = _mm_loadu_ps(w_im + b);
+            _mm_storeu_ps(output_re + b, _mm_add_ps(
+                _mm_loadu_ps(output_re + b),
+                _mm_add_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi))
+            ));
+            _mm_storeu_ps(output_im + b, _mm_add_ps(
+                _mm_loadu_ps(output_im + b),
+                _mm_sub_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr))
+            ));
+        }
+#endif
+        for (; b < stride; ++b) {
+            output_re[b] += w_re[b] * x_re[b] + w_im[b] * x_im[b];
+            output_im[b] += w_re[b] * x_im[b] - w_im[b] * x_re[b];
+        }
+    }
+
+    //
+    //  Synthesis (overlap-add), the first hop of the overlap buffer is 
+    //  complete.
+    //
+    this->m_fft->inverse(output_re, output_im, frame);
+    float *overlap = this->m_overlap.get_samples<float>();
+    for (size_t n = 0U; n < size; ++n) {
+        overlap[n] += frame[n] * window[n];
+    }
+    float *queue = this->m_queue.get_samples<float>();
+    memcpy(
+        queue + this->m_queue_count,
+        overlap,
+        this->m_hop * sizeof(float)
+    );
+    this->m_queue_count += this->m_hop;
+    memmove(overlap, overlap + this->m_hop, tail * sizeof(float));
+    memset(overlap + tail, 0, this->m_hop * sizeof(float));
+}
+
+/**
+ *  Swap in the latest weights published by the worker thread (if any).
+ */
+void Beamformer::acquire_weights() noexcept {
+    if ((this->m_exchange.load(std::memory_order_acquire) &
+         BEAMFORMER_FRESH) != 0U) {
+        this->m_front = static_cast<size_t>(
+            this->m_exchange.exchange(
+                static_cast<uint32_t>(this->m_front),
+                std::memory_order_acq_rel
+            ) & ~BEAMFORMER_FRESH
+        );
+    }
+}
+
+/**
+ *  Compute weights (worker thread).
+ * 
+ *  @param weights
+ *      The index of the weight set to write.
+ *  @param azimuth
+ *      The azimuth (in degrees).
+ *  @param elevation
+ *      The elevation (in degrees).
+ */
+void Beamformer::compute_weights(
+    size_t  weights,
+    float   azimuth,
+    float   elevation
+) noexcept {
+    size_t channel_count = this->m_channel_count;
+    double sample_rate = static_cast<double>(this->m_input_format.sample_rate);
+    float *destination = 
+        this->m_weights.get_samples<float>() + weights * this->m_weight_size;
+    double direction[3];
+    xap::audioio::microphonearray_get_direction(
+        static_cast<double>(azimuth),
+        static_cast<double>(elevation),
+        direction
+    );
+    double leads[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS];
+    for (size_t c = 0U; c < channel_count; ++c) {
+        leads[c] = xap::audioio::microphonearray_get_lead(
+            this->m_array,
+            c,
+            direction
+        );
+    }
+
+    if (this->m_options.method == xap::audioio::BEAMFORMER_DELAYANDSUM) {
+        //
+        //  Delay the channels the wavefront reaches early, each with an 
+        //  integer delay and a windowed-sinc interpolator for the fraction 
+        //  (stored reversed, normalized to the gain 1 / channel count).
+        //
+        double earliest = leads[0];
+        for (size_t c = 1U; c < channel_count; ++c) {
+            if (leads[c] < earliest) {
+                earliest = leads[c];
+            }
+        }
+        double center = static_cast<double>(BEAMFORMER_TAPS / 2U - 1U);
+        double half = static_cast<double>(BEAMFORMER_TAPS / 2U);
+        for (size_t c = 0U; c < channel_count; ++c) {
+            double delay = (leads[c] - earliest) * sample_rate;
+            double integer = floor(delay);
+            if (integer > static_cast<double>(this->m_max_delay - 1U)) {
+                integer = static_cast<double>(this->m_max_delay - 1U);
+            }
+            double fraction = delay - integer;
+            float *channel = destination + c * (1U + BEAMFORMER_TAPS);
+            channel[0] = static_cast<float>(integer);
+
+            double taps[BEAMFORMER_TAPS];
+            double sum = 0.0;
+            for (size_t k = 0U; k < BEAMFORMER_TAPS; ++k) {
+                double t = static_cast<double>(k) - center - fraction;
+                double sinc = 1.0;
+                if (fabs(t) > 1e-9) {
+                    sinc = sin(xap::audioio::MICROPHONEARRAY_PI * t) / 
+                           (xap::audioio::MICROPHONEARRAY_PI * t);
+                }
+                double window = 
+                    0.42 + 
+                    0.5 * cos(xap::audioio::MICROPHONEARRAY_PI * t / half) + 
+                    0.08 * cos(
+                        2.0 * xap::audioio::MICROPHONEARRAY_PI * t / half
+                    );
+                taps[k] = sinc * window;
+                sum += taps[k];
+            }
+            double gain = 1.0 / (sum * static_cast<double>(channel_count));
+            for (size_t k = 0U; k < BEAMFORMER_TAPS; ++k) {
+                channel[1U + BEAMFORMER_TAPS - 1U - k] = 
+                    static_cast<float>(taps[k] * gain);
+            }
+        }
+        return;
+    }
+
+    //
+    //  MVDR: w = R^-1 d / (d^H R^-1 d) per bin, with the steering vector d 
+    //  relative to the origin of the array and diagonal loading.
+    //
+    typedef std::complex<double> Complex;
+    size_t stride = this->m_bin_stride;
+    size_t size = static_cast<size_t>(this->m_options.fft_size);
+    const float *covariance = this->m_worker_covariance.get_samples<float>();
+    Complex r[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS]
+             [xap::audioio::MICROPHONEARRAY_MAX_CHANNELS];
+    Complex l[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS]
+             [xap::audioio::MICROPHONEARRAY_MAX_CHANNELS];
+    Complex d[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS];
+    Complex z[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS];
+    for (size_t b = 0U; b < stride; ++b) {
+        if (b >= this->m_bin_count) {
+            for (size_t c = 0U; c < channel_count; ++c) {
+                destination[c * 2U * stride + b] = 0.0F;
+                destination[c * 2U * stride + stride + b] = 0.0F;
+            }
+            continue;
+        }
+
+        double frequency = static_cast<double>(b) * sample_rate / 
+                           static_cast<double>(size);
+        for (size_t c = 0U; c < channel_count; ++c) {
+            d[c] = std::polar(
+                1.0,
+                2.0 * xap::audioio::MICROPHONEARRAY_PI * frequency * leads[c]
+            );
+        }
+
+        //
+        //  Rebuild the Hermitian matrix and load its diagonal.
+        //
+        const float *pair = covariance;
+        double trace = 0.0;
+        for (size_t i = 0U; i < channel_count; ++i) {
+            for (size_t j = i; j < channel_count; ++j) {
+                Complex value(
+                    static_cast<double>(pair[b]),
+                    static_cast<double>(pair[stride + b])
+                );
+                r[i][j] = value;
+                r[j][i] = std::conj(value);
+                pair += 2U * stride;
+            }
+            trace += r[i][i].real();
+        }
+        double loading = 
+            static_cast<double>(this->m_options.diagonal_loading) * 
+            trace / static_cast<double>(channel_count);
+        if (!(loading > 1e-20)) {
+            loading = 1e-20;
+        }
+        if (!(trace > 0.0)) {
+            for (size_t i = 0U; i < channel_count; ++i) {
+                for (size_t j = 0U; j < channel_count; ++j) {
+                    r[i][j] = Complex(i == j ? 1.0 : 0.0, 0.0);
+                }
+            }
+        }
+        for (size_t i = 0U; i < channel_count; ++i) {
+            r[i][i] += loading;
+        }
+
+        //
+        //  Cholesky decomposition (R = L L^H), then solve L L^H z = d.
+        //
+        bool is_singular = false;
+        for (size_t j = 0U; j < channel_count && !is_singular; ++j) {
+            double diagonal = r[j][j].real();
+            for (size_t k = 0U; k < j; ++k) {
+                diagonal -= std::norm(l[j][k]);
+            }
+            if (!(diagonal > 0.0)) {
+                is_singular = true;
+                break;
+            }
+            l[j][j] = Complex(sqrt(diagonal), 0.0);
+            for (size_t i = j + 1U; i < channel_count; ++i) {
+                Complex value = r[i][j];
+                for (size_t k = 0U; k < j; ++k) {
+                    value -= l[i][k] * std::conj(l[j][k]);
+                }
+                l[i][j] = value / l[j][j].real();
+            }
+        }
+        if (is_singular) {
+            for (size_t c = 0U; c < channel_count; ++c) {
+                z[c] = d[c];
+            }
+        } else {
+            for (size_t i = 0U; i < channel_count; ++i) {
+                Complex value = d[i];
+                for (size_t k = 0U; k < i; ++k) {
+                    value -= l[i][k] * z[k];
+                }
+                z[i] = value / l[i][i].real();
+            }
+            for (size_t i = channel_count; i-- > 0U; ) {
+                Complex value = z[i];
+                for (size_t k = i + 1U; k < channel_count; ++k) {
+                    value -= std::conj(l[k][i]) * z[k];
+                }
+                z[i] = value / l[i][i].real();
+            }
+        }
+
+        Complex denominator(0.0, 0.0);
+        for (size_t c = 0U; c < channel_count; ++c) {
+            denominator += std::conj(d[c]) * z[c];
+        }
+        if (std::abs(denominator) < 1e-30) {
+            denominator = Complex(1.0, 0.0);
+        }
+        for (size_t c = 0U; c < channel_count; ++c) {
+            Complex w = z[c] / denominator;
+            destination[c * 2U * stride + b] = static_cast<float>(w.real());
+            destination[c * 2U * stride + stride + b] = 
+                static_cast<float>(w.imag());
+        }
+    }
+}
+
+/**
+ *  Run the worker thread.
+ */
+void Beamformer::run_worker() noexcept {
+    size_t back = 2U;
+    uint32_t version = 0U;
+    bool is_mvdr = (this->m_options.method == xap::audioio::BEAMFORMER_MVDR);
+    std::unique_lock<std::mutex> locked(this->m_wakeup_lock);
+    while (!this->m_is_stopping.load()) {
+        this->m_wakeup.wait_for(locked, BEAMFORMER_WORKER_TIMEOUT, [&]() {
+            return this->m_is_stopping.load() || 
+                   this->m_snapshot_state.load() == 
+                       BEAMFORMER_SNAPSHOT_READY || 
+                   this->m_direction_version.load() != version;
+        });
+        if (this->m_is_stopping.load()) {
+            break;
+        }
+        locked.unlock();
+
+        //
+        //  Take the covariance snapshot and the direction.
+        //
+        bool is_dirty = false;
+        if (is_mvdr && 
+            this->m_snapshot_state.load(std::memory_order_acquire) == 
+                BEAMFORMER_SNAPSHOT_READY) {
+            memcpy(
+                this->m_worker_covariance.get_pointer(),
+                this->m_snapshot.get_pointer(),
+                this->m_snapshot.get_length()
+            );
+            this->m_snapshot_state.store(
+                BEAMFORMER_SNAPSHOT_IDLE,
+                std::memory_order_release
+            );
+            is_dirty = true;
+        }
+        uint32_t current = 
+            this->m_direction_version.load(std::memory_order_acquire);
+        if (current != version) {
+            version = current;
+            is_dirty = true;
+        }
+
+        //
+        //  Compute and publish.
+        //
+        if (is_dirty) {
+            this->compute_weights(
+                back,
+                this->m_azimuth.load(),
+                this->m_elevation.load()
+            );
+            back = static_cast<size_t>(
+                this->m_exchange.exchange(
+                    static_cast<uint32_t>(back) | BEAMFORMER_FRESH,
+                    std::memory_order_acq_rel
+                ) & ~BEAMFORMER_FRESH
+            );
+        }
+
+        locked.lock();
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,1097 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fft_p.h"
+#include "mpscqueue_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <new>
+#include <string.h>
+#include <xap/audioio/binaural.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double BINAURAL_PI = 3.14159265358979323846;
+
+//  Directions closer than this angle (in radians) to a measurement point 
+//  get the HRIR of that point only.
+const static double BINAURAL_SNAP_ANGLE = 1e-3;
+
+//  Count of ears.
+const static size_t BINAURAL_EARS = 2U;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Voice (a slot of the mixer).
+ */
+struct BinauralVoice_ {
+    //  Control side (guarded by the voice lock): the identifier (0 if free 
+    //  or being removed), whether the slot is used (until retired) and the 
+    //  source.
+    size_t                                      id = 0U;
+    bool                                        is_used = false;
+    std::shared_ptr<xap::audioio::ISource>      source;
+
+    //  The direction (packed azimuth and elevation, written by the control 
+    //  side, read by the audio thread).
+    std::atomic<uint64_t>                       direction;
+
+    //  Audio side: whether the voice is mixed, the direction the filters 
+    //  were interpolated for, the filter slot in use and the newest 
+    //  partition of the history.
+    bool                                        is_active = false;
+    uint64_t                                    applied = 0U;
+    size_t                                      current = 0U;
+    size_t                                      head = 0U;
+
+    //  The input block, and the filters (2 slots of both ears), the spectra 
+    //  of the input history (one per partition) and the input frame (2 
+    //  blocks) in one buffer.
+    xap::audioio::AudioBuffer                   input;
+    xap::audioio::AudioBuffer                   state;
+    float                                      *filters = nullptr;
+    float                                      *history = nullptr;
+    float                                      *frame = nullptr;
+
+    BinauralVoice_() noexcept : direction(0U) {}
+};
+
+/**
+ *  Command from a control thread to the audio thread.
+ */
+struct BinauralCommand_ {
+    //  The slot of the voice.
+    size_t  slot;
+
+    //  True to add the voice, false to remove it.
+    bool    is_add;
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build the audio format of internal buffers (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Round a value up to a power of 2 (at least 2).
+ * 
+ *  @param value
+ *      The value.
+ *  @return
+ *      The power of 2.
+ */
+static size_t round_to_power_of_two(size_t value) noexcept {
+    size_t result = 2U;
+    while (result < value) {
+        result <<= 1U;
+    }
+    return result;
+}
+
+/**
+ *  Pack a direction (for an atomic variable).
+ * 
+ *  @param direction
+ *      The direction.
+ *  @return
+ *      The packed direction.
+ */
+static uint64_t pack_direction(
+    const xap::audioio::BinauralDirection &direction
+) noexcept {
+    uint32_t azimuth = 0U;
+    uint32_t elevation = 0U;
+    memcpy(&azimuth, &(direction.azimuth), sizeof(azimuth));
+    memcpy(&elevation, &(direction.elevation), sizeof(elevation));
+    return (static_cast<uint64_t>(azimuth) << 32U) |
+           static_cast<uint64_t>(elevation);
+}
+
+/**
+ *  Unpack a direction.
+ * 
+ *  @param packed
+ *      The packed direction.
+ *  @return
+ *      The direction.
+ */
+static xap::audioio::BinauralDirection unpack_direction(
+    uint64_t packed
+) noexcept {
+    uint32_t azimuth = static_cast<uint32_t>(packed >> 32U);
+    uint32_t elevation = static_cast<uint32_t>(packed & 0xFFFFFFFFU);
+    xap::audioio::BinauralDirection direction;
+    memcpy(&(direction.azimuth), &azimuth, sizeof(azimuth));
+    memcpy(&(direction.elevation), &elevation, sizeof(elevation));
+    return direction;
+}
+
+/**
+ *  Get the unit vector of a direction (x in front, y to the left, z 
+ *  above).
+ * 
+ *  @param direction
+ *      The direction.
+ *  @param vector
+ *      The vector (output, 3 elements).
+ */
+static void get_unit_vector(
+    const xap::audioio::BinauralDirection  &direction,
+    double                                 *vector
+) noexcept {
+    double azimuth = static_cast<double>(direction.azimuth) * 
+                     BINAURAL_PI / 180.0;
+    double elevation = static_cast<double>(direction.elevation) * 
+                       BINAURAL_PI / 180.0;
+    vector[0] = cos(elevation) * cos(azimuth);
+    vector[1] = cos(elevation) * sin(azimuth);
+    vector[2] = sin(elevation);
+}
+
+/**
+ *  Multiply and accumulate split complex vectors (y += w * x).
+ * 
+ *  @param y_re
+ *      The real parts of the accumulator.
+ *  @param y_im
+ *      The imaginary parts of the accumulator.
+ *  @param w_re
+ *      The real parts of the vector w.
+ *  @param w_im
+ *      The imaginary parts of the vector w.
+ *  @param x_re
+ *      The real parts of the vector x.
+ *  @param x_im
+ *      The imaginary parts of the vector x.
+ *  @param count
+ *      The count of elements (a multiple of 4).
+ */
+static inline void complex_multiply_accumulate(
+    float        *y_re,
+    float        *y_im,
+    const float  *w_re,
+    const float  *w_im,
+    const float  *x_re,
+    const float  *x_im,
+    size_t        count
+) noexcept {
+    size_t b = 0U;
+#if defined(__SSE2__)
+    for (; b < count; b += 4U) {
+        __m128 wr = _mm_loadu_ps(w_re + b);
+        __m128 wi = _mm_loadu_ps(w_im + b);
+        __m128 xr = _mm_loadu_ps(x_re + b);
+        __m128 xi = _mm_loadu_ps(x_im + b);
+        _mm_storeu_ps(y_re + b, _mm_add_ps(
+            _mm_loadu_ps(y_re + b),
+            _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi))
+        ));
+        _mm_storeu_ps(y_im + b, _mm_add_ps(
+            _mm_loadu_ps(y_im + b),
+            _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr))
+        ));
+    }
+#endif
+    for (; b < count; ++b) {
+        y_re[b] += w_re[b] * x_re[b] - w_im[b] * x_im[b];
+        y_im[b] += w_re[b] * x_im[b] + w_im[b] * x_re[b];
+    }
+}
+
+//
+//  HrirSet constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              A count is 0, the sample rate is 0 or the block size is 
+ *              not a power of 2 (or < 16).
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param directions
+ *      The direction of each measurement point.
+ *  @param point_count
+ *      The count of measurement points.
+ *  @param left
+ *      The impulse responses of the left ear ('tap_count' taps of each 
+ *      point, one after another).
+ *  @param right
+ *      The impulse responses of the right ear (the same layout).
+ *  @param tap_count
+ *      The count of taps of each impulse response.
+ *  @param sample_rate
+ *      The sample rate of the impulse responses.
+ *  @param block_frames
+ *      The count of frames of the FFT partitions (a power of 2, the block 
+ *      size of the mixers).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+HrirSet::HrirSet(
+    const xap::audioio::BinauralDirection  *directions,
+    size_t                                  point_count,
+    const float                            *left,
+    const float                            *right,
+    size_t                                  tap_count,
+    uint32_t                                sample_rate,
+    size_t                                  block_frames,
+    xap::audioio::IAllocator               *allocator
+) :
+    m_point_count(point_count),
+    m_tap_count(tap_count),
+    m_sample_rate(sample_rate),
+    m_block(block_frames),
+    m_bin_stride((block_frames + 1U + 3U) & ~static_cast<size_t>(3U)),
+    m_partition_count(0U),
+    m_vectors(),
+    m_spectra()
+{
+    if (directions == nullptr || left == nullptr || right == nullptr || 
+        point_count == 0U || 
+        tap_count == 0U || 
+        sample_rate == 0U || 
+        block_frames < 16U || 
+        (block_frames & (block_frames - 1U)) != 0U) {
+        throw xap::audioio::Exception(
+            "The impulse responses are invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+    size_t block = this->m_block;
+    size_t stride = this->m_bin_stride;
+    size_t spectrum = 2U * stride;
+    size_t partitions = (tap_count + block - 1U) / block;
+    this->m_partition_count = partitions;
+
+    //
+    //  Unit vectors of the directions (for the nearest points).
+    //
+    xap::audioio::AudioFormat state_format = build_state_format(sample_rate);
+    this->m_vectors = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        3U * point_count,
+        allocator
+    );
+    float *vectors = this->m_vectors.get_samples<float>();
+    for (size_t i = 0U; i < point_count; ++i) {
+        double vector[3];
+        get_unit_vector(directions[i], vector);
+        for (size_t k = 0U; k < 3U; ++k) {
+            vectors[3U * i + k] = static_cast<float>(vector[k]);
+        }
+    }
+
+    //
+    //  Spectra of each partition (zero-padded to 2 blocks) of both ears of 
+    //  each point.
+    //
+    this->m_spectra = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        point_count * BINAURAL_EARS * partitions * spectrum,
+        allocator
+    );
+    memset(this->m_spectra.get_pointer(), 0, this->m_spectra.get_length());
+    xap::audioio::AudioBuffer frame_buffer = 
+        xap::audioio::AudioBuffer::allocate(
+            state_format,
+            2U * block,
+            allocator
+        );
+    float *frame = frame_buffer.get_samples<float>();
+    xap::audioio::Fft fft(2U * block, allocator);
+    float *spectra = this->m_spectra.get_samples<float>();
+    for (size_t i = 0U; i < point_count; ++i) {
+        for (size_t ear = 0U; ear < BINAURAL_EARS; ++ear) {
+            const float *taps = (ear == 0U ? left : right) + i * tap_count;
+            for (size_t k = 0U; k < partitions; ++k) {
+                size_t offset = k * block;
+                size_t count = std::min(block, tap_count - offset);
+                memset(frame, 0, 2U * block * sizeof(float));
+                memcpy(frame, taps + offset, count * sizeof(float));
+                float *re = spectra + 
+                            ((i * BINAURAL_EARS + ear) * partitions + k) * 
+                            spectrum;
+                fft.forward(frame, re, re + stride);
+            }
+        }
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+HrirSet::~HrirSet() noexcept {}
+
+//
+//  HrirSet public methods.
+//
+
+/**
+ *  Get the count of measurement points.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t HrirSet::get_point_count() const noexcept {
+    return this->m_point_count;
+}
+
+/**
+ *  Get the count of taps of each impulse response.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t HrirSet::get_tap_count() const noexcept {
+    return this->m_tap_count;
+}
+
+/**
+ *  Get the sample rate.
+ * 
+ *  @return
+ *      The sample rate.
+ */
+uint32_t HrirSet::get_sample_rate() const noexcept {
+    return this->m_sample_rate;
+}
+
+/**
+ *  Get the count of frames of the FFT partitions.
+ * 
+ *  @return
+ *      The count of frames.
+ */
+size_t HrirSet::get_block_frames() const noexcept {
+    return this->m_block;
+}
+
+/**
+ *  Get the count of FFT partitions of each impulse response.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t HrirSet::get_partition_count() const noexcept {
+    return this->m_partition_count;
+}
+
+/**
+ *  Find the measurement points interpolated for a direction.
+ * 
+ *  The nearest points (by the angle between the directions) are weighted 
+ *  by their inverse squared angular distance, a direction on a measurement 
+ *  point gets the HRIR of that point only.
+ * 
+ *  @param direction
+ *      The direction.
+ *  @param points
+ *      The indices of the points (output, BINAURAL_INTERPOLATION_POINTS 
+ *      entries).
+ *  @param weights
+ *      The weights of the points (output, summing up to 1, 0 for unused 
+ *      entries).
+ */
+void HrirSet::interpolate(
+    const xap::audioio::BinauralDirection  &direction,
+    size_t                                 *points,
+    float                                  *weights
+) const noexcept {
+    double vector[3];
+    get_unit_vector(direction, vector);
+
+    //
+    //  The nearest points (largest dot products first).
+    //
+    const float *vectors = this->m_vectors.get_samples<float>();
+    double dots[BINAURAL_INTERPOLATION_POINTS];
+    size_t count = 0U;
+    for (size_t i = 0U; i < this->m_point_count; ++i) {
+        double dot = vector[0] * static_cast<double>(vectors[3U * i]) + 
+                     vector[1] * static_cast<double>(vectors[3U * i + 1U]) + 
+                     vector[2] * static_cast<double>(vectors[3U * i + 2U]);
+        if (count == BINAURAL_INTERPOLATION_POINTS) {
+            if (dot <= dots[count - 1U]) {
+                continue;
+            }
+            --count;
+        }
+        size_t k = count;
+        for (; k > 0U && dots[k - 1U] < dot; --k) {
+            dots[k] = dots[k - 1U];
+            points[k] = points[k - 1U];
+        }
+        dots[k] = dot;
+        points[k] = i;
+        ++count;
+    }
+
+    //
+    //  Inverse squared angular distances.
+    //
+    double angles[BINAURAL_INTERPOLATION_POINTS] = {0.0};
+    for (size_t k = 0U; k < count; ++k) {
+        angles[k] = acos(std::min(std::max(dots[k], -1.0), 1.0));
+    }
+    if (count != 0U && angles[0] < BINAURAL_SNAP_ANGLE) {
+        count = 1U;
+    }
+    double total = 0.0;
+    double inverses[BINAURAL_INTERPOLATION_POINTS];
+    for (size_t k = 0U; k < count; ++k) {
+        inverses[k] = count == 1U ? 1.0 : 1.0 / (angles[k] * angles[k]);
+        total += inverses[k];
+    }
+    for (size_t k = 0U; k < BINAURAL_INTERPOLATION_POINTS; ++k) {
+        if (k < count) {
+            weights[k] = static_cast<float>(inverses[k] / total);
+        } else {
+            points[k] = count != 0U ? points[0] : 0U;
+            weights[k] = 0.0F;
+        }
+    }
+}
+
+//
+//  BinauralMixer constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The HRIR set is nullptr or the options are invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The output format is not stereo 32-bit float at the sample 
+ *              rate of the HRIR set.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param hrirs
+ *      The HRIR set.
+ *  @param output_format
+ *      The output audio format.
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+BinauralMixer::BinauralMixer(
+    const std::shared_ptr<const xap::audioio::HrirSet>  &hrirs,
+    const xap::audioio::AudioFormat                     &output_format,
+    const xap::audioio::BinauralMixerOptions            &options,
+    xap::audioio::IAllocator                            *allocator
+) :
+    m_hrirs(hrirs),
+    m_format(output_format),
+    m_allocator(allocator),
+    m_max_voices(options.max_voices),
+    m_block(0U),
+    m_bin_stride(0U),
+    m_partition_count(0U),
+    m_fft(nullptr),
+    m_voices(nullptr),
+    m_voice_lock(),
+    m_voice_count(0U),
+    m_next_id(1U),
+    m_commands(nullptr),
+    m_retired(nullptr),
+    m_spectra(),
+    m_time(),
+    m_rendered(),
+    m_rendered_offset(0U)
+{
+    if (!hrirs || options.max_voices == 0U) {
+        throw xap::audioio::Exception(
+            "The HRIR set or the options are invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (output_format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32 || 
+        output_format.channel_count != 2U || 
+        output_format.sample_rate != hrirs->get_sample_rate()) {
+        throw xap::audioio::Exception(
+            "Only stereo 32-bit float audio data at the sample rate of the "
+            "HRIR set is supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+        this->m_allocator = allocator;
+    }
+    this->m_block = hrirs->m_block;
+    this->m_bin_stride = hrirs->m_bin_stride;
+    this->m_partition_count = hrirs->m_partition_count;
+    size_t block = this->m_block;
+    size_t spectrum = 2U * this->m_bin_stride;
+    size_t partitions = this->m_partition_count;
+
+    //
+    //  The accumulated spectra (of both ears, of the new filters and of the 
+    //  differences to the old filters), the time frame and the rendered 
+    //  block (empty initially).
+    //
+    xap::audioio::AudioFormat state_format = 
+        build_state_format(output_format.sample_rate);
+    this->m_spectra = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        2U * BINAURAL_EARS * spectrum,
+        allocator
+    );
+    this->m_time = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        2U * block,
+        allocator
+    );
+    this->m_rendered = xap::audioio::AudioBuffer::allocate(
+        output_format,
+        block,
+        allocator
+    );
+    this->m_rendered_offset = block;
+
+    size_t constructed = 0U;
+    try {
+        this->m_fft = xap::audioio::new_object<xap::audioio::Fft>(
+            allocator,
+            2U * block,
+            allocator
+        );
+        this->m_commands = xap::audioio::new_object<
+            xap::audioio::MpscQueue<struct xap::audioio::BinauralCommand_>
+        >(allocator, round_to_power_of_two(2U * options.max_voices), allocator);
+        this->m_retired = xap::audioio::new_object<
+            xap::audioio::MpscQueue<size_t>
+        >(allocator, round_to_power_of_two(options.max_voices), allocator);
+
+        //
+        //  Voice slots (all memory of the voices is allocated up front).
+        //
+        this->m_voices = static_cast<struct xap::audioio::BinauralVoice_ *>(
+            allocator->allocate(
+                sizeof(struct xap::audioio::BinauralVoice_) * 
+                    options.max_voices,
+                alignof(struct xap::audioio::BinauralVoice_)
+            )
+        );
+        if (this->m_voices == nullptr) {
+            throw xap::audioio::Exception(
+                "Memory allocation was failed.",
+                xap::audioio::ERROR_ALLOC
+            );
+        }
+        for (; constructed < options.max_voices; ++constructed) {
+            struct xap::audioio::BinauralVoice_ *voice = 
+                new (&(this->m_voices[constructed]))
+                    xap::audioio::BinauralVoice_();
+            voice->input = xap::audioio::AudioBuffer::allocate(
+                state_format,
+                block,
+                allocator
+            );
+            voice->state = xap::audioio::AudioBuffer::allocate(
+                state_format,
+                2U * BINAURAL_EARS * partitions * spectrum + 
+                    partitions * spectrum + 
+                    2U * block,
+                allocator
+            );
+            voice->filters = voice->state.get_samples<float>();
+            voice->history = 
+                voice->filters + 2U * BINAURAL_EARS * partitions * spectrum;
+            voice->frame = voice->history + partitions * spectrum;
+        }
+    } catch (...) {
+        if (this->m_voices != nullptr) {
+            //  The slot being constructed when failed is destroyed as well.
+            size_t count = std::min(constructed + 1U, options.max_voices);
+            for (size_t i = 0U; i < count; ++i) {
+                this->m_voices[i].~BinauralVoice_();
+            }
+            allocator->deallocate(
+                this->m_voices,
+                sizeof(struct xap::audioio::BinauralVoice_) * 
+                    options.max_voices,
+                alignof(struct xap::audioio::BinauralVoice_)
+            );
+        }
+        if (this->m_retired != nullptr) {
+            this->m_retired->~MpscQueue<size_t>();
+            xap::audioio::free_object(this->m_retired);
+        }
+        if (this->m_commands != nullptr) {
+            this->m_commands->~MpscQueue<
+                struct xap::audioio::BinauralCommand_
+            >();
+            xap::audioio::free_object(this->m_commands);
+        }
+        if (this->m_fft != nullptr) {
+            this->m_fft->~Fft();
+            xap::audioio::free_object(this->m_fft);
+        }
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+BinauralMixer::~BinauralMixer() noexcept {
+    for (size_t i = 0U; i < this->m_max_voices; ++i) {
+        this->m_voices[i].~BinauralVoice_();
+    }
+    this->m_allocator->deallocate(
+        this->m_voices,
+        sizeof(struct xap::audioio::BinauralVoice_) * this->m_max_voices,
+        alignof(struct xap::audioio::BinauralVoice_)
+    );
+    this->m_retired->~MpscQueue<size_t>();
+    xap::audioio::free_object(this->m_retired);
+    this->m_commands->~MpscQueue<struct xap::audioio::BinauralCommand_>();
+    xap::audioio::free_object(this->m_commands);
+    this->m_fft->~Fft();
+    xap::audioio::free_object(this->m_fft);
+}
+
+//
+//  BinauralMixer public methods.
+//
+
+/**
+ *  Read audio data (the mix of all voices).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED) or a voice failed.
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (always all frames, missing audio data of 
+ *      the voices is silent).
+ */
+size_t BinauralMixer::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_format.sample_format || 
+        output.get_channel_count() != this->m_format.channel_count || 
+        output.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t frame_count = output.get_frame_count();
+    float *samples = output.get_samples<float>();
+    const float *rendered = this->m_rendered.get_samples<float>();
+    size_t offset = 0U;
+    while (offset < frame_count) {
+        if (this->m_rendered_offset == this->m_block) {
+            this->apply_commands();
+            this->render_block();
+            this->m_rendered_offset = 0U;
+        }
+        size_t count = std::min(
+            frame_count - offset,
+            this->m_block - this->m_rendered_offset
+        );
+        memcpy(
+            samples + 2U * offset,
+            rendered + 2U * this->m_rendered_offset,
+            2U * count * sizeof(float)
+        );
+        this->m_rendered_offset += count;
+        offset += count;
+    }
+    return frame_count;
+}
+
+/**
+ *  Add a voice (thread-safe).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The source is nullptr.
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The maximum count of voices was reached.
+ * 
+ *  @param source
+ *      The source of the voice (mono 32-bit float audio data at the sample 
+ *      rate of the output).
+ *  @param direction
+ *      The initial direction.
+ *  @return
+ *      The identifier of the voice.
+ */
+size_t BinauralMixer::add_voice(
+    const std::shared_ptr<xap::audioio::ISource>  &source,
+    const xap::audioio::BinauralDirection         &direction
+) {
+    if (!source) {
+        throw xap::audioio::Exception(
+            "The source is null.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    std::lock_guard<std::mutex> locked(this->m_voice_lock);
+    this->release_retired();
+    size_t slot = 0U;
+    while (slot < this->m_max_voices && this->m_voices[slot].is_used) {
+        ++slot;
+    }
+    if (slot == this->m_max_voices) {
+        throw xap::audioio::Exception(
+            "The maximum count of voices was reached.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    //  The queue holds an add and a remove command of each slot at most.
+    struct xap::audioio::BinauralVoice_ &voice = this->m_voices[slot];
+    voice.id = this->m_next_id++;
+    voice.is_used = true;
+    voice.source = source;
+    voice.direction.store(
+        pack_direction(direction),
+        std::memory_order_relaxed
+    );
+    struct xap::audioio::BinauralCommand_ command;
+    command.slot = slot;
+    command.is_add = true;
+    this->m_commands->try_push(command);
+    ++(this->m_voice_count);
+
+    return voice.id;
+}
+
+/**
+ *  Remove a voice (thread-safe, the source is released once the audio 
+ *  thread dropped the voice).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the voice does not exist (xap::audioio::ERROR_PARAMETER).
+ *  @param voice
+ *      The identifier of the voice.
+ */
+void BinauralMixer::remove_voice(size_t voice) {
+    std::lock_guard<std::mutex> locked(this->m_voice_lock);
+    this->release_retired();
+    size_t slot = this->find_voice(voice);
+    this->m_voices[slot].id = 0U;
+    struct xap::audioio::BinauralCommand_ command;
+    command.slot = slot;
+    command.is_add = false;
+    this->m_commands->try_push(command);
+}
+
+/**
+ *  Move a voice (thread-safe, lock-free on the audio thread).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the voice does not exist (xap::audioio::ERROR_PARAMETER).
+ *  @param voice
+ *      The identifier of the voice.
+ *  @param direction
+ *      The direction.
+ */
+void BinauralMixer::set_direction(
+    size_t                                    voice,
+    const xap::audioio::BinauralDirection    &direction
+) {
+    std::lock_guard<std::mutex> locked(this->m_voice_lock);
+    size_t slot = this->find_voice(voice);
+    this->m_voices[slot].direction.store(
+        pack_direction(direction),
+        std::memory_order_relaxed
+    );
+}
+
+/**
+ *  Get the count of voices (thread-safe, including voices being removed).
+ * 
+ *  @return
+ *      The count.
+ */
+size_t BinauralMixer::get_voice_count() {
+    std::lock_guard<std::mutex> locked(this->m_voice_lock);
+    this->release_retired();
+    return this->m_voice_count;
+}
+
+//
+//  BinauralMixer private methods.
+//
+
+/**
+ *  Apply the pending commands (audio thread).
+ */
+void BinauralMixer::apply_commands() noexcept {
+    struct xap::audioio::BinauralCommand_ command;
+    while (this->m_commands->try_pop(command)) {
+        struct xap::audioio::BinauralVoice_ &voice = 
+            this->m_voices[command.slot];
+        if (command.is_add) {
+            size_t spectrum = 2U * this->m_bin_stride;
+            memset(
+                voice.history,
+                0,
+                (this->m_partition_count * spectrum + 2U * this->m_block) * 
+                    sizeof(float)
+            );
+            voice.head = 0U;
+            voice.applied = voice.direction.load(std::memory_order_relaxed);
+            this->update_filters(voice, unpack_direction(voice.applied));
+            voice.is_active = true;
+        } else {
+            //  The retired queue holds each slot once at most.
+            voice.is_active = false;
+            this->m_retired->try_push(command.slot);
+        }
+    }
+}
+
+/**
+ *  Render one block of all voices.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if a voice failed.
+ */
+void BinauralMixer::render_block() {
+    size_t block = this->m_block;
+    size_t stride = this->m_bin_stride;
+    size_t spectrum = 2U * stride;
+    size_t partitions = this->m_partition_count;
+    size_t filter_size = BINAURAL_EARS * partitions * spectrum;
+    float *sums = this->m_spectra.get_samples<float>();
+    float *differences = sums + BINAURAL_EARS * spectrum;
+    float *time = this->m_time.get_samples<float>();
+    float *rendered = this->m_rendered.get_samples<float>();
+    memset(sums, 0, 2U * BINAURAL_EARS * spectrum * sizeof(float));
+
+    bool is_moving = false;
+    for (size_t i = 0U; i < this->m_max_voices; ++i) {
+        struct xap::audioio::BinauralVoice_ &voice = this->m_voices[i];
+        if (!voice.is_active) {
+            continue;
+        }
+
+        //
+        //  Spectrum of the newest frame, replacing the oldest partition.
+        //
+        memset(voice.input.get_pointer(), 0, voice.input.get_length());
+        voice.source->read(voice.input);
+        memmove(voice.frame, voice.frame + block, block * sizeof(float));
+        memcpy(
+            voice.frame + block,
+            voice.input.get_pointer(),
+            block * sizeof(float)
+        );
+        voice.head = (voice.head + partitions - 1U) % partitions;
+        float *newest = voice.history + voice.head * spectrum;
+        this->m_fft->forward(voice.frame, newest, newest + stride);
+
+        //
+        //  Moved: interpolate the new filters, keep the differences of the 
+        //  old filters (cross-faded out over this block).
+        //
+        uint64_t direction = voice.direction.load(std::memory_order_relaxed);
+        bool is_voice_moving = (direction != voice.applied);
+        if (is_voice_moving) {
+            this->update_filters(voice, unpack_direction(direction));
+            voice.applied = direction;
+            const float *filter = voice.filters + voice.current * filter_size;
+            float *old = voice.filters + (1U - voice.current) * filter_size;
+            for (size_t n = 0U; n < filter_size; ++n) {
+                old[n] -= filter[n];
+            }
+            is_moving = true;
+        }
+
+        //
+        //  Accumulate the products of all partitions.
+        //
+        for (size_t ear = 0U; ear < BINAURAL_EARS; ++ear) {
+            const float *filter = 
+                voice.filters + voice.current * filter_size + 
+                ear * partitions * spectrum;
+            const float *old = 
+                voice.filters + (1U - voice.current) * filter_size + 
+                ear * partitions * spectrum;
+            float *sum = sums + ear * spectrum;
+            float *difference = differences + ear * spectrum;
+            for (size_t k = 0U; k < partitions; ++k) {
+                const float *x = 
+                    voice.history + ((voice.head + k) % partitions) * spectrum;
+                const float *w = filter + k * spectrum;
+                complex_multiply_accumulate(
+                    sum,
+                    sum + stride,
+                    w,
+                    w + stride,
+                    x,
+                    x + stride,
+                    stride
+                );
+                if (is_voice_moving) {
+                    w = old + k * spectrum;
+                    complex_multiply_accumulate(
+                        difference,
+                        difference + stride,
+                        w,
+                        w + stride,
+                        x,
+                        x + stride,
+                        stride
+                    );
+                }
+            }
+        }
+    }
+
+    //
+    //  Back to the time domain (overlap-save, the second half of the frame), 
+    //  the differences fade out linearly.
+    //
+    for (size_t ear = 0U; ear < BINAURAL_EARS; ++ear) {
+        float *sum = sums + ear * spectrum;
+        this->m_fft->inverse(sum, sum + stride, time);
+        for (size_t i = 0U; i < block; ++i) {
+            rendered[2U * i + ear] = time[block + i];
+        }
+        if (is_moving) {
+            float *difference = differences + ear * spectrum;
+            this->m_fft->inverse(difference, difference + stride, time);
+            float step = 1.0F / static_cast<float>(block);
+            for (size_t i = 0U; i < block; ++i) {
+                float fade = 1.0F - static_cast<float>(i + 1U) * step;
+                rendered[2U * i + ear] += fade * time[block + i];
+            }
+        }
+    }
+}
+
+/**
+ *  Interpolate the HRIR pair of a voice (to its other filter slot).
+ * 
+ *  @param voice
+ *      The voice.
+ *  @param direction
+ *      The direction.
+ */
+void BinauralMixer::update_filters(
+    struct xap::audioio::BinauralVoice_       &voice,
+    const xap::audioio::BinauralDirection     &direction
+) noexcept {
+    size_t points[BINAURAL_INTERPOLATION_POINTS];
+    float weights[BINAURAL_INTERPOLATION_POINTS];
+    this->m_hrirs->interpolate(direction, points, weights);
+
+    size_t filter_size = 
+        BINAURAL_EARS * this->m_partition_count * 2U * this->m_bin_stride;
+    size_t target = 1U - voice.current;
+    float *filter = voice.filters + target * filter_size;
+    const float *spectra = this->m_hrirs->m_spectra.get_samples<float>();
+    memset(filter, 0, filter_size * sizeof(float));
+    for (size_t k = 0U; k < BINAURAL_INTERPOLATION_POINTS; ++k) {
+        float weight = weights[k];
+        if (weight == 0.0F) {
+            continue;
+        }
+        const float *source = spectra + points[k] * filter_size;
+        for (size_t n = 0U; n < filter_size; ++n) {
+            filter[n] += weight * source[n];
+        }
+    }
+    voice.current = target;
+}
+
+/**
+ *  Release the voices retired by the audio thread (the voice lock must be 
+ *  held).
+ */
+void BinauralMixer::release_retired() noexcept {
+    size_t slot = 0U;
+    while (this->m_retired->try_pop(slot)) {
+        struct xap::audioio::BinauralVoice_ &voice = this->m_voices[slot];
+        voice.source.reset();
+        voice.is_used = false;
+        --(this->m_voice_count);
+    }
+}
+
+/**
+ *  Find the slot of a voice (the voice lock must be held).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the voice does not exist (xap::audioio::ERROR_PARAMETER).
+ *  @param voice
+ *      The identifier of the voice.
+ *  @return
+ *      The slot.
+ */
+size_t BinauralMixer::find_voice(size_t voice) {
+    for (size_t slot = 0U; slot < this->m_max_voices; ++slot) {
+        if (voice != 0U && this->m_voices[slot].id == voice) {
+            return slot;
+        }
+    }
+    throw xap::audioio::Exception(
+        "The voice does not exist.",
+        xap::audioio::ERROR_PARAMETER
+    );
+}
+
+}  //  namespace audioio
+}  //  namespace xap
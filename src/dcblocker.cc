@@ -0,0 +1,475 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/dcblocker.h>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of pooled output audio buffers (16-bit to 32-bit float only).
+const static size_t DCBLOCKER_POOL_BLOCK_COUNT = 16U;
+
+//  Fraction bits of the fixed-point coefficient and accumulator.
+const static int DCBLOCKER_FIXED_BITS = 30;
+
+//  Filter states below this magnitude are flushed to zero (avoid denormals 
+//  on a constant input).
+const static float DCBLOCKER_FLUSH_LEVEL = 1e-20F;
+
+//  Count of states of each channel (the previous input, the previous output 
+//  and, in fixed point, the rounding error).
+const static size_t DCBLOCKER_STATES = 2U;
+const static size_t DCBLOCKER_FIXED_STATES = 3U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Test whether the stage converts the audio data (to a pooled buffer).
+ * 
+ *  @param input_format
+ *      The input audio format.
+ *  @param output_sample_format
+ *      The output sample format.
+ *  @return
+ *      True if converted.
+ */
+static bool is_converting(
+    const xap::audioio::AudioFormat &input_format,
+    xap::audioio::SampleFormat       output_sample_format
+) noexcept {
+    return input_format.sample_format != output_sample_format;
+}
+
+/**
+ *  Get the block size of the output pool.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the parameters are invalid (xap::audioio::ERROR_PARAMETER) 
+ *      or the conversion is not supported 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param input_format
+ *      The input audio format.
+ *  @param output_sample_format
+ *      The output sample format.
+ *  @param max_frames
+ *      The maximum count of frames of each call.
+ *  @param options
+ *      The options.
+ *  @return
+ *      The block size (in bytes, a single byte if the audio data is filtered 
+ *      in place).
+ */
+static size_t get_block_size(
+    const xap::audioio::AudioFormat        &input_format,
+    xap::audioio::SampleFormat              output_sample_format,
+    size_t                                  max_frames,
+    const xap::audioio::DcBlockerOptions   &options
+) {
+    if (input_format.channel_count == 0U || 
+        input_format.sample_rate == 0U || 
+        max_frames == 0U || 
+        !(options.cutoff > 0.0) || 
+        !(options.cutoff <
+            0.5 * static_cast<double>(input_format.sample_rate))) {
+        throw xap::audioio::Exception(
+            "Invalid audio format, maximum count of frames or cutoff.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    bool is_supported = 
+        (input_format.sample_format == xap::audioio::SAMPLEFORMAT_INT16 && 
+            (output_sample_format == xap::audioio::SAMPLEFORMAT_INT16 || 
+             output_sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32)) || 
+        (input_format.sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32 && 
+            output_sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32);
+    if (!is_supported) {
+        throw xap::audioio::Exception(
+            "Only 16-bit to 16-bit or 32-bit float and 32-bit float to 32-bit "
+            "float conversions are supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (!is_converting(input_format, output_sample_format)) {
+        return 1U;
+    }
+    return max_frames * 
+           static_cast<size_t>(input_format.channel_count) * 
+           sizeof(float);
+}
+
+/**
+ *  Build the audio format of filter state (mono).
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint32_t                    sample_rate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Saturate a sample to 16-bit.
+ * 
+ *  @param value
+ *      The sample.
+ *  @return
+ *      The saturated sample.
+ */
+static inline int16_t saturate_int16(int32_t value) noexcept {
+    if (value > 32767) {
+        return 32767;
+    }
+    if (value < -32768) {
+        return -32768;
+    }
+    return static_cast<int16_t>(value);
+}
+
+//
+//  DcBlocker constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The input format is invalid, max_frames == 0 or the cutoff 
+ *              frequency is not between 0 and the Nyquist frequency.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The conversion is not supported.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param input_format
+ *      The input audio format (the format of the recorder).
+ *  @param output_sample_format
+ *      The output sample format.
+ *  @param max_frames
+ *      The maximum count of frames of each call (the frames per buffer of 
+ *      the recorder, or RECORDER_DEFAULT_BLOCK_FRAMES).
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+DcBlocker::DcBlocker(
+    const xap::audioio::AudioFormat        &input_format,
+    xap::audioio::SampleFormat              output_sample_format,
+    size_t                                  max_frames,
+    const xap::audioio::DcBlockerOptions   &options,
+    xap::audioio::IAllocator               *allocator
+) :
+    m_input_format(input_format),
+    m_output_format(input_format),
+    m_max_frames(max_frames),
+    m_coefficient(0.0F),
+    m_fixed_coefficient(0),
+    m_states(),
+    m_fixed_states(),
+    m_pool(
+        get_block_size(input_format, output_sample_format, max_frames, options),
+        is_converting(input_format, output_sample_format) ? 
+            DCBLOCKER_POOL_BLOCK_COUNT :
+            1U,
+        allocator
+    )
+{
+    this->m_output_format.sample_format = output_sample_format;
+
+    //
+    //  Pole of the filter (the -3dB frequency of 1 - z^-1 / 1 - R * z^-1 
+    //  is close to the cutoff for R close to 1).
+    //
+    double pole = exp(
+        -2.0 * 3.14159265358979323846 * options.cutoff / 
+            static_cast<double>(input_format.sample_rate)
+    );
+    this->m_coefficient = static_cast<float>(pole);
+    this->m_fixed_coefficient = static_cast<int64_t>(
+        llround(pole * static_cast<double>(1LL << DCBLOCKER_FIXED_BITS))
+    );
+
+    size_t channel_count = static_cast<size_t>(input_format.channel_count);
+    if (output_sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+        this->m_fixed_states = xap::audioio::AudioBuffer::allocate(
+            build_state_format(
+                xap::audioio::SAMPLEFORMAT_INT32,
+                input_format.sample_rate
+            ),
+            DCBLOCKER_FIXED_STATES * channel_count,
+            allocator
+        );
+    } else {
+        this->m_states = xap::audioio::AudioBuffer::allocate(
+            build_state_format(
+                xap::audioio::SAMPLEFORMAT_FLOAT32,
+                input_format.sample_rate
+            ),
+            DCBLOCKER_STATES * channel_count,
+            allocator
+        );
+    }
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+DcBlocker::~DcBlocker() noexcept {}
+
+//
+//  DcBlocker public methods.
+//
+
+/**
+ *  Filter audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio data mismatched.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The audio data has more than 'max_frames' frames.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              No pooled audio buffer is available.
+ * 
+ *  @param data
+ *      The audio data (filtered in place, or replaced by the converted audio 
+ *      data).
+ */
+void DcBlocker::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_input_format.sample_format || 
+        data.get_channel_count() != this->m_input_format.channel_count || 
+        data.get_sample_rate() != this->m_input_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t frame_count = data.get_frame_count();
+    if (frame_count > this->m_max_frames) {
+        throw xap::audioio::Exception(
+            "Too many frames.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  32-bit float output of 16-bit input: convert and filter in one pass.
+    //
+    if (this->m_input_format.sample_format != 
+            this->m_output_format.sample_format) {
+        xap::audioio::AudioBuffer output = 
+            xap::audioio::AudioBuffer::allocate(
+                this->m_pool,
+                this->m_output_format,
+                frame_count
+            );
+        this->filter_int16_float(
+            data.get_samples<int16_t>(),
+            output.get_samples<float>(),
+            frame_count
+        );
+        output.set_timestamp(data.get_timestamp());
+        data = output;
+        return;
+    }
+
+    //
+    //  In place.
+    //
+    if (this->m_input_format.sample_format == 
+            xap::audioio::SAMPLEFORMAT_INT16) {
+        this->filter_int16(data.get_samples<int16_t>(), frame_count);
+    } else {
+        this->filter_float(data.get_samples<float>(), frame_count);
+    }
+}
+
+/**
+ *  Reset the filter state.
+ */
+void DcBlocker::reset() noexcept {
+    if (!this->m_states.is_empty()) {
+        memset(this->m_states.get_pointer(), 0, this->m_states.get_length());
+    }
+    if (!this->m_fixed_states.is_empty()) {
+        memset(
+            this->m_fixed_states.get_pointer(),
+            0,
+            this->m_fixed_states.get_length()
+        );
+    }
+}
+
+/**
+ *  Get the output audio format.
+ * 
+ *  @return
+ *      The audio format.
+ */
+const xap::audioio::AudioFormat &DcBlocker::get_output_format()
+    const noexcept {
+    return this->m_output_format;
+}
+
+//
+//  DcBlocker private methods.
+//
+
+/**
+ *  Filter 16-bit samples to 32-bit float samples.
+ * 
+ *  @param input
+ *      The input samples.
+ *  @param output
+ *      The output samples.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void DcBlocker::filter_int16_float(
+    const int16_t  *input,
+    float          *output,
+    size_t          frame_count
+) noexcept {
+    size_t channel_count = 
+        static_cast<size_t>(this->m_input_format.channel_count);
+    float coefficient = this->m_coefficient;
+    float *states = this->m_states.get_samples<float>();
+    for (size_t c = 0U; c < channel_count; ++c) {
+        //  The states stay in registers for the whole channel.
+        float *state = states + c * DCBLOCKER_STATES;
+        float previous_input = state[0];
+        float previous_output = state[1];
+        const int16_t *source = input + c;
+        float *target = output + c;
+        for (size_t i = 0U; i < frame_count; ++i) {
+            float x = static_cast<float>(source[i * channel_count]) * 
+                      (1.0F / 32768.0F);
+            float y = x - previous_input + coefficient * previous_output;
+            target[i * channel_count] = y;
+            previous_input = x;
+            previous_output = y;
+        }
+        if (fabsf(previous_output) < DCBLOCKER_FLUSH_LEVEL) {
+            previous_output = 0.0F;
+        }
+        state[0] = previous_input;
+        state[1] = previous_output;
+    }
+}
+
+/**
+ *  Filter 16-bit samples in place (in fixed point).
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void DcBlocker::filter_int16(int16_t *samples, size_t frame_count) noexcept {
+    size_t channel_count = 
+        static_cast<size_t>(this->m_input_format.channel_count);
+    const int64_t one = static_cast<int64_t>(1) << DCBLOCKER_FIXED_BITS;
+    int64_t coefficient = this->m_fixed_coefficient;
+    int32_t *states = this->m_fixed_states.get_samples<int32_t>();
+    for (size_t c = 0U; c < channel_count; ++c) {
+        int32_t *state = states + c * DCBLOCKER_FIXED_STATES;
+        int32_t previous_input = state[0];
+        int32_t previous_output = state[1];
+        int64_t error = static_cast<int64_t>(state[2]);
+        int16_t *sample = samples + c;
+        for (size_t i = 0U; i < frame_count; ++i) {
+            int32_t x = static_cast<int32_t>(sample[i * channel_count]);
+
+            //  The accumulator keeps the fraction which was truncated from 
+            //  the previous output (error feedback), so the truncation 
+            //  leaves no offset.
+            int64_t accumulator = 
+                static_cast<int64_t>(x - previous_input) * one + 
+                coefficient * static_cast<int64_t>(previous_output) + 
+                error;
+            int32_t y = static_cast<int32_t>(
+                accumulator >> DCBLOCKER_FIXED_BITS
+            );
+            error = accumulator - static_cast<int64_t>(y) * one;
+            sample[i * channel_count] = saturate_int16(y);
+            previous_input = x;
+            previous_output = y;
+        }
+        state[0] = previous_input;
+        state[1] = previous_output;
+        state[2] = static_cast<int32_t>(error);
+    }
+}
+
+/**
+ *  Filter 32-bit float samples in place.
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void DcBlocker::filter_float(float *samples, size_t frame_count) noexcept {
+    size_t channel_count = 
+        static_cast<size_t>(this->m_input_format.channel_count);
+    float coefficient = this->m_coefficient;
+    float *states = this->m_states.get_samples<float>();
+    for (size_t c = 0U; c < channel_count; ++c) {
+        float *state = states + c * DCBLOCKER_STATES;
+        float previous_input = state[0];
+        float previous_output = state[1];
+        float *sample = samples + c;
+        for (size_t i = 0U; i < frame_count; ++i) {
+            float x = sample[i * channel_count];
+            float y = x - previous_input + coefficient * previous_output;
+            sample[i * channel_count] = y;
+            previous_input = x;
+            previous_output = y;
+        }
+        if (fabsf(previous_output) < DCBLOCKER_FLUSH_LEVEL) {
+            previous_output = 0.0F;
+        }
+        state[0] = previous_input;
+        state[1] = previous_output;
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
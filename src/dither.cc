@@ -0,0 +1,485 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <math.h>
+#include <random>
+#include <string.h>
+#include <xap/audioio/dither.h>
+#include <xap/audioio/error.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of samples requantized per pass (the noise of one pass is generated 
+//  ahead of the conversion, must be a multiple of 4).
+const static size_t DITHER_BLOCK_SAMPLES = 256U;
+
+//  Count of frames read from the upstream source per pass.
+const static size_t DITHER_CHUNK_FRAMES = 256U;
+
+//  Scale of 16-bit samples.
+const static float DITHER_SCALE = 32768.0F;
+
+//  Limit of the fed back error (in LSB, avoids instability while clipping).
+const static float DITHER_ERROR_LIMIT = 2.0F;
+
+//  Scale of the 24 most significant bits of the random values.
+const static float DITHER_UNIFORM_SCALE = 1.0F / 16777216.0F;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the next value of a SplitMix64 generator (used to seed the noise 
+ *  generators).
+ * 
+ *  @param state
+ *      The state (updated).
+ *  @return
+ *      The value.
+ */
+static uint64_t splitmix64(uint64_t &state) noexcept {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#if !defined(__SSE2__)
+/**
+ *  Get the next value of a xorshift32 generator.
+ * 
+ *  @param state
+ *      The state (nonzero, updated).
+ *  @return
+ *      The value.
+ */
+static uint32_t xorshift32(uint32_t &state) noexcept {
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+#endif
+
+/**
+ *  Requantize samples without noise shaping.
+ * 
+ *  @param input
+ *      The samples (32-bit float).
+ *  @param noise
+ *      The noise (in LSB).
+ *  @param output
+ *      The samples (16-bit).
+ *  @param count
+ *      The count of samples.
+ */
+static void requantize_plain(
+    const float  *input,
+    const float  *noise,
+    int16_t      *output,
+    size_t        count
+) noexcept {
+    size_t i = 0U;
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(DITHER_SCALE);
+    const __m128 lower = _mm_set1_ps(-32768.0F);
+    const __m128 upper = _mm_set1_ps(32767.0F);
+    for (; i + 8U <= count; i += 8U) {
+        __m128 y0 = _mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(input + i), scale),
+            _mm_loadu_ps(noise + i)
+        );
+        __m128 y1 = _mm_add_ps(
+            _mm_mul_ps(_mm_loadu_ps(input + i + 4U), scale),
+            _mm_loadu_ps(noise + i + 4U)
+        );
+        y0 = _mm_min_ps(_mm_max_ps(y0, lower), upper);
+        y1 = _mm_min_ps(_mm_max_ps(y1, lower), upper);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(output + i),
+            _mm_packs_epi32(_mm_cvtps_epi32(y0), _mm_cvtps_epi32(y1))
+        );
+    }
+#endif
+    for (; i < count; ++i) {
+        float y = input[i] * DITHER_SCALE + noise[i];
+        if (y < -32768.0F) {
+            y = -32768.0F;
+        } else if (y > 32767.0F) {
+            y = 32767.0F;
+        }
+        output[i] = static_cast<int16_t>(lrintf(y));
+    }
+}
+
+//
+//  Dither constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The count of channels is 0 or the noise shaping filter is 
+ *              invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param channel_count
+ *      The count of channels.
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+Dither::Dither(
+    uint8_t                               channel_count,
+    const xap::audioio::DitherOptions    &options,
+    xap::audioio::IAllocator             *allocator
+) :
+    m_channel_count(static_cast<size_t>(channel_count)),
+    m_noise_shaping(options.noise_shaping),
+    m_seed(options.seed),
+    m_states(),
+    m_errors()
+{
+    if (channel_count == 0U) {
+        throw xap::audioio::Exception(
+            "The count of channels is zero.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (options.noise_shaping > xap::audioio::NOISESHAPING_SECOND_ORDER) {
+        throw xap::audioio::Exception(
+            "The noise shaping filter is invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (this->m_seed == 0U) {
+        std::random_device device;
+        while (this->m_seed == 0U) {
+            this->m_seed = static_cast<uint32_t>(device());
+        }
+    }
+
+    //  Errors of the last two samples of each channel (the sample rate of 
+    //  the state is not used).
+    xap::audioio::AudioFormat state_format;
+    state_format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    state_format.channel_count = channel_count;
+    state_format.sample_rate = 48000U;
+    this->m_errors = 
+        xap::audioio::AudioBuffer::allocate(state_format, 2U, allocator);
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+Dither::~Dither() noexcept {}
+
+//
+//  Dither public methods.
+//
+
+/**
+ *  Requantize audio data (interleaved, full scale is [-1, 1)).
+ * 
+ *  @param input
+ *      The samples (32-bit float).
+ *  @param output
+ *      The samples (16-bit, saturated).
+ *  @param frame_count
+ *      The count of frames.
+ */
+void Dither::requantize(
+    const float  *input,
+    int16_t      *output,
+    size_t        frame_count
+) noexcept {
+    size_t count = frame_count * this->m_channel_count;
+    float noise[DITHER_BLOCK_SAMPLES];
+    float *errors = this->m_errors.get_samples<float>();
+    float *errors1 = errors;
+    float *errors2 = errors + this->m_channel_count;
+
+    //  Coefficients of the error feedback, the noise transfer function is 
+    //  1 - h1 * z^-1 - h2 * z^-2.
+    float h1 = 0.0F;
+    float h2 = 0.0F;
+    if (this->m_noise_shaping == xap::audioio::NOISESHAPING_FIRST_ORDER) {
+        h1 = 1.0F;
+    } else if (
+        this->m_noise_shaping == xap::audioio::NOISESHAPING_SECOND_ORDER
+    ) {
+        h1 = 2.0F;
+        h2 = -1.0F;
+    }
+
+    size_t channel = 0U;
+    for (size_t offset = 0U; offset < count; offset += DITHER_BLOCK_SAMPLES) {
+        size_t block = count - offset;
+        if (block > DITHER_BLOCK_SAMPLES) {
+            block = DITHER_BLOCK_SAMPLES;
+        }
+        this->generate(noise, (block + 3U) & ~static_cast<size_t>(3U));
+
+        if (this->m_noise_shaping == xap::audioio::NOISESHAPING_NONE) {
+            requantize_plain(input + offset, noise, output + offset, block);
+            continue;
+        }
+
+        for (size_t i = 0U; i < block; ++i) {
+            float wanted = input[offset + i] * DITHER_SCALE - 
+                           (h1 * errors1[channel] + h2 * errors2[channel]);
+            float y = wanted + noise[i];
+            if (y < -32768.0F) {
+                y = -32768.0F;
+            } else if (y > 32767.0F) {
+                y = 32767.0F;
+            }
+            float quantized = static_cast<float>(lrintf(y));
+            output[offset + i] = static_cast<int16_t>(quantized);
+
+            float error = quantized - wanted;
+            if (error > DITHER_ERROR_LIMIT) {
+                error = DITHER_ERROR_LIMIT;
+            } else if (error < -DITHER_ERROR_LIMIT) {
+                error = -DITHER_ERROR_LIMIT;
+            }
+            errors2[channel] = errors1[channel];
+            errors1[channel] = error;
+            if (++channel == this->m_channel_count) {
+                channel = 0U;
+            }
+        }
+    }
+}
+
+/**
+ *  Reset (clear the noise shaping state and restart the noise from the 
+ *  seed).
+ */
+void Dither::reset() noexcept {
+    memset(this->m_errors.get_pointer(), 0, this->m_errors.get_length());
+    uint64_t state = static_cast<uint64_t>(this->m_seed);
+    for (size_t i = 0U; i < 8U; ++i) {
+        uint32_t value = static_cast<uint32_t>(splitmix64(state) >> 32);
+        this->m_states[i] = value == 0U ? 0x6D2B79F5U : value;
+    }
+}
+
+//
+//  Dither private methods.
+//
+
+/**
+ *  Generate TPDF noise.
+ * 
+ *  @param noise
+ *      The noise (in LSB, output).
+ *  @param count
+ *      The count of samples (a multiple of 4).
+ */
+void Dither::generate(float *noise, size_t count) noexcept {
+    //  Two generators of 4 lanes each, the noise is the difference of two 
+    //  uniform values (triangular in (-1, 1) LSB).
+#if defined(__SSE2__)
+    __m128i a = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(this->m_states)
+    );
+    __m128i b = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(this->m_states + 4U)
+    );
+    const __m128 scale = _mm_set1_ps(DITHER_UNIFORM_SCALE);
+    for (size_t i = 0U; i < count; i += 4U) {
+        a = _mm_xor_si128(a, _mm_slli_epi32(a, 13));
+        a = _mm_xor_si128(a, _mm_srli_epi32(a, 17));
+        a = _mm_xor_si128(a, _mm_slli_epi32(a, 5));
+        b = _mm_xor_si128(b, _mm_slli_epi32(b, 13));
+        b = _mm_xor_si128(b, _mm_srli_epi32(b, 17));
+        b = _mm_xor_si128(b, _mm_slli_epi32(b, 5));
+        __m128 u1 = _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_srli_epi32(a, 8)),
+            scale
+        );
+        __m128 u2 = _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_srli_epi32(b, 8)),
+            scale
+        );
+        _mm_storeu_ps(noise + i, _mm_sub_ps(u1, u2));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(this->m_states), a);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(this->m_states + 4U), b);
+#else
+    for (size_t i = 0U; i < count; i += 4U) {
+        for (size_t lane = 0U; lane < 4U; ++lane) {
+            uint32_t a = xorshift32(this->m_states[lane]);
+            uint32_t b = xorshift32(this->m_states[4U + lane]);
+            noise[i + lane] = 
+                static_cast<float>(a >> 8) * DITHER_UNIFORM_SCALE - 
+                static_cast<float>(b >> 8) * DITHER_UNIFORM_SCALE;
+        }
+    }
+#endif
+}
+
+//
+//  DitherSource constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The upstream source is nullptr, the output format or the 
+ *              options are invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The output format is not 16-bit.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param upstream
+ *      The upstream source (32-bit float audio data with the channel 
+ *      count and the sample rate of the output format).
+ *  @param output_format
+ *      The output audio format (the format of the player).
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+DitherSource::DitherSource(
+    const std::shared_ptr<xap::audioio::ISource> &upstream,
+    const xap::audioio::AudioFormat              &output_format,
+    const xap::audioio::DitherOptions            &options,
+    xap::audioio::IAllocator                     *allocator
+) :
+    m_upstream(upstream),
+    m_output_format(output_format),
+    m_input(),
+    m_dither(output_format.channel_count, options, allocator)
+{
+    if (!upstream) {
+        throw xap::audioio::Exception(
+            "The upstream source is null.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (output_format.sample_format != xap::audioio::SAMPLEFORMAT_INT16) {
+        throw xap::audioio::Exception(
+            "The output format is not 16-bit.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    xap::audioio::AudioFormat input_format = output_format;
+    input_format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    this->m_input = xap::audioio::AudioBuffer::allocate(
+        input_format,
+        DITHER_CHUNK_FRAMES,
+        allocator
+    );
+}
+
+/**
+ *  Destruct the object.
+ */
+DitherSource::~DitherSource() noexcept {}
+
+//
+//  DitherSource public methods.
+//
+
+/**
+ *  Read audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED) or the upstream source failed.
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (fewer than requested if the upstream 
+ *      source ran out of audio data).
+ */
+size_t DitherSource::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_output_format.sample_format || 
+        output.get_channel_count() != this->m_output_format.channel_count || 
+        output.get_sample_rate() != this->m_output_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    size_t frame_count = output.get_frame_count();
+    size_t channel_count = 
+        static_cast<size_t>(this->m_output_format.channel_count);
+    int16_t *destination = output.get_samples<int16_t>();
+    size_t delivered = 0U;
+    while (delivered < frame_count) {
+        size_t needed = frame_count - delivered;
+        if (needed > DITHER_CHUNK_FRAMES) {
+            needed = DITHER_CHUNK_FRAMES;
+        }
+        xap::audioio::AudioBuffer input = this->m_input.slice(0U, needed);
+        memset(input.get_pointer(), 0, input.get_length());
+        size_t read = this->m_upstream->read(input);
+        if (read > needed) {
+            read = needed;
+        }
+
+        //  Frames the upstream source did not deliver stay silence (not 
+        //  dithered).
+        this->m_dither.requantize(
+            input.get_samples<float>(),
+            destination + delivered * channel_count,
+            read
+        );
+        delivered += read;
+        if (read < needed) {
+            break;
+        }
+    }
+
+    return delivered;
+}
+
+/**
+ *  Reset the dither state.
+ */
+void DitherSource::reset() noexcept {
+    this->m_dither.reset();
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,781 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fft_p.h"
+#include "microphonearray_p.h"
+
+#include <math.h>
+#include <string.h>
+#include <system_error>
+#include <xap/audioio/doaestimator.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Interpolation factor of the GCC-PHAT correlations.
+const static size_t DOAESTIMATOR_UPSAMPLING = 4U;
+
+//  Floor of the magnitude of the spectra (phase transform).
+const static float DOAESTIMATOR_MIN_MAGNITUDE = 1e-20F;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Validate the options of a direction-of-arrival estimator.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the parameters are invalid (xap::audioio::ERROR_PARAMETER) 
+ *      or the input format is not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param input_format
+ *      The input audio format.
+ *  @param array
+ *      The microphone array.
+ *  @param options
+ *      The options.
+ *  @return
+ *      The count of channels.
+ */
+static size_t validate_options(
+    const xap::audioio::AudioFormat          &input_format,
+    const xap::audioio::MicrophoneArray      &array,
+    const xap::audioio::DoaEstimatorOptions  &options
+) {
+    if (input_format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+        input_format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) {
+        throw xap::audioio::Exception(
+            "Only 16-bit or 32-bit float audio data is supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t channel_count = static_cast<size_t>(input_format.channel_count);
+    xap::audioio::microphonearray_validate(array, channel_count);
+    size_t size = static_cast<size_t>(options.fft_size);
+    if (input_format.sample_rate == 0U || 
+        size < 16U || (size & (size - 1U)) != 0U || 
+        options.direction_count == 0U || 
+        options.report_interval == 0U || 
+        !(options.min_frequency >= 0.0F) || 
+        !(options.max_frequency > options.min_frequency)) {
+        throw xap::audioio::Exception(
+            "Invalid DOA estimator options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    return channel_count;
+}
+
+/**
+ *  Build the audio format of the estimator state (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+//
+//  DoaEstimator constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The array mismatched the input format, the options are 
+ *              invalid or the aperture of the array is too large for 
+ *              the size of the frames.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The input format is neither 16-bit nor 32-bit float.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param input_format
+ *      The input audio format (one channel per microphone).
+ *  @param array
+ *      The geometry of the microphone array.
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+DoaEstimator::DoaEstimator(
+    const xap::audioio::AudioFormat          &input_format,
+    const xap::audioio::MicrophoneArray      &array,
+    const xap::audioio::DoaEstimatorOptions  &options,
+    xap::audioio::IAllocator                 *allocator
+) :
+    m_event_callback(),
+    m_input_format(input_format),
+    m_options(options),
+    m_channel_count(validate_options(input_format, array, options)),
+    m_pair_count(0U),
+    m_direction_count(static_cast<size_t>(options.direction_count)),
+    m_hop(static_cast<size_t>(options.fft_size) / 2U),
+    m_bin_stride(0U),
+    m_min_bin(0U),
+    m_max_bin(0U),
+    m_lag_radius(0U),
+    m_fill(0U),
+    m_report_hops(1U),
+    m_hops(0U),
+    m_active_hops(0U),
+    m_min_power(0.0F),
+    m_fft(nullptr),
+    m_correlation_fft(nullptr),
+    m_window(),
+    m_frames(),
+    m_spectra(),
+    m_cross(),
+    m_lag_index(),
+    m_lag_fraction(),
+    m_response(),
+    m_scratch()
+{
+    size_t channel_count = this->m_channel_count;
+    size_t size = static_cast<size_t>(options.fft_size);
+    size_t half = size / 2U;
+    double sample_rate = static_cast<double>(input_format.sample_rate);
+    xap::audioio::AudioFormat state_format = 
+        build_state_format(input_format.sample_rate);
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    //
+    //  Frequency band (DC and Nyquist bins excluded).
+    //
+    double min_bin = ceil(
+        static_cast<double>(options.min_frequency) * 
+        static_cast<double>(size) / sample_rate
+    );
+    double max_bin = floor(
+        static_cast<double>(options.max_frequency) * 
+        static_cast<double>(size) / sample_rate
+    );
+    if (min_bin < 1.0) {
+        min_bin = 1.0;
+    }
+    if (max_bin > static_cast<double>(half - 1U)) {
+        max_bin = static_cast<double>(half - 1U);
+    }
+    if (max_bin < min_bin) {
+        throw xap::audioio::Exception(
+            "The frequency band is empty.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    this->m_min_bin = static_cast<size_t>(min_bin);
+    this->m_max_bin = static_cast<size_t>(max_bin);
+    this->m_bin_stride = (half + 1U + 3U) & ~static_cast<size_t>(3U);
+    this->m_pair_count = channel_count * (channel_count - 1U) / 2U;
+    this->m_report_hops = static_cast<size_t>(
+        sample_rate * static_cast<double>(options.report_interval) / 
+        1000.0 / static_cast<double>(this->m_hop) + 0.5
+    );
+    if (this->m_report_hops == 0U) {
+        this->m_report_hops = 1U;
+    }
+    this->m_min_power = static_cast<float>(
+        pow(10.0, static_cast<double>(options.min_level) / 10.0)
+    );
+    if (input_format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+        this->m_min_power *= 32768.0F * 32768.0F;
+    }
+
+    //
+    //  The delays between microphones must fit in the (interpolated) 
+    //  correlations.
+    //
+    size_t correlation_size = size * DOAESTIMATOR_UPSAMPLING;
+    double max_lag = 
+        xap::audioio::microphonearray_get_aperture(array) / 
+        static_cast<double>(array.speed_of_sound) * sample_rate * 
+        static_cast<double>(DOAESTIMATOR_UPSAMPLING);
+    this->m_lag_radius = static_cast<size_t>(ceil(max_lag)) + 1U;
+    if (this->m_lag_radius + 1U >= correlation_size / 2U) {
+        throw xap::audioio::Exception(
+            "The aperture of the array is too large.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  Precompute the position of the delay of each pair at each direction 
+    //  (in the interpolated correlations, relative to a lag of -radius).
+    //
+    size_t direction_count = this->m_direction_count;
+    size_t table_size = this->m_pair_count * direction_count;
+    this->m_lag_index = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        table_size,
+        allocator
+    );
+    this->m_lag_fraction = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        table_size,
+        allocator
+    );
+    uint32_t *lag_index = this->m_lag_index.get_samples<uint32_t>();
+    float *lag_fraction = this->m_lag_fraction.get_samples<float>();
+    for (size_t d = 0U; d < direction_count; ++d) {
+        double direction[3];
+        xap::audioio::microphonearray_get_direction(
+            360.0 * static_cast<double>(d) / 
+                static_cast<double>(direction_count),
+            static_cast<double>(options.elevation),
+            direction
+        );
+        double leads[xap::audioio::MICROPHONEARRAY_MAX_CHANNELS];
+        for (size_t c = 0U; c < channel_count; ++c) {
+            leads[c] = xap::audioio::microphonearray_get_lead(
+                array,
+                c,
+                direction
+            );
+        }
+
+        //  The correlation of (i, j) peaks at the lead of j over i.
+        size_t pair = 0U;
+        for (size_t i = 0U; i < channel_count; ++i) {
+            for (size_t j = i + 1U; j < channel_count; ++j) {
+                double position = 
+                    static_cast<double>(this->m_lag_radius) + 
+                    (leads[j] - leads[i]) * sample_rate * 
+                    static_cast<double>(DOAESTIMATOR_UPSAMPLING);
+                double index = floor(position);
+                lag_index[pair * direction_count + d] = 
+                    static_cast<uint32_t>(index);
+                lag_fraction[pair * direction_count + d] = 
+                    static_cast<float>(position - index);
+                ++pair;
+            }
+        }
+    }
+
+    //
+    //  Periodic Hann analysis window.
+    //
+    this->m_window = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        size,
+        allocator
+    );
+    float *window = this->m_window.get_samples<float>();
+    for (size_t n = 0U; n < size; ++n) {
+        window[n] = static_cast<float>(
+            0.5 - 0.5 * cos(
+                2.0 * xap::audioio::MICROPHONEARRAY_PI * 
+                static_cast<double>(n) / static_cast<double>(size)
+            )
+        );
+    }
+
+    size_t spectrum = 2U * this->m_bin_stride;
+    this->m_frames = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        size * channel_count,
+        allocator
+    );
+    this->m_spectra = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        spectrum * channel_count,
+        allocator
+    );
+    this->m_cross = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        spectrum * this->m_pair_count,
+        allocator
+    );
+    this->m_response = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        direction_count,
+        allocator
+    );
+
+    //  Frame, correlation spectrum, correlation and lag windows.
+    this->m_scratch = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        size + 2U * (correlation_size / 2U + 1U) + correlation_size + 
+            this->m_pair_count * (2U * this->m_lag_radius + 2U),
+        allocator
+    );
+
+    this->m_fft = xap::audioio::new_object<xap::audioio::Fft>(
+        allocator,
+        size,
+        allocator
+    );
+    try {
+        this->m_correlation_fft = xap::audioio::new_object<xap::audioio::Fft>(
+            allocator,
+            correlation_size,
+            allocator
+        );
+    } catch (...) {
+        this->m_fft->~Fft();
+        xap::audioio::free_object(this->m_fft);
+        throw;
+    }
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+DoaEstimator::~DoaEstimator() noexcept {
+    this->m_correlation_fft->~Fft();
+    xap::audioio::free_object(this->m_correlation_fft);
+    this->m_fft->~Fft();
+    xap::audioio::free_object(this->m_fft);
+}
+
+//
+//  DoaEstimator public methods.
+//
+
+/**
+ *  Estimate the direction of arrival of audio data (as a recorder 
+ *  stage, the audio data is not changed).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio data mismatched.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              The event callback occurred error.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *  @param data
+ *      The audio data.
+ */
+void DoaEstimator::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_input_format.sample_format || 
+        data.get_channel_count() != this->m_input_format.channel_count || 
+        data.get_sample_rate() != this->m_input_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    size_t channel_count = this->m_channel_count;
+    size_t size = static_cast<size_t>(this->m_options.fft_size);
+    size_t tail = size - this->m_hop;
+    size_t frame_count = data.get_frame_count();
+    bool is_float = 
+        (this->m_input_format.sample_format == 
+            xap::audioio::SAMPLEFORMAT_FLOAT32);
+    const float *input_float = data.get_samples<const float>();
+    const int16_t *input_int16 = data.get_samples<const int16_t>();
+    float *frames = this->m_frames.get_samples<float>();
+    for (size_t offset = 0U; offset < frame_count; ) {
+        size_t count = this->m_hop - this->m_fill;
+        if (count > frame_count - offset) {
+            count = frame_count - offset;
+        }
+
+        //
+        //  Deinterleave into the newest hop of the analysis buffers.
+        //
+        for (size_t c = 0U; c < channel_count; ++c) {
+            float *frame = frames + c * size + tail + this->m_fill;
+            size_t index = offset * channel_count + c;
+            for (size_t i = 0U; i < count; ++i) {
+                frame[i] = is_float ? 
+                    input_float[index] :
+                    static_cast<float>(input_int16[index]);
+                index += channel_count;
+            }
+        }
+        this->m_fill += count;
+        offset += count;
+        if (this->m_fill < this->m_hop) {
+            break;
+        }
+        this->process_hop();
+        this->m_fill = 0U;
+
+        //
+        //  Publish the estimate of the interval.
+        //
+        if (++(this->m_hops) >= this->m_report_hops) {
+            xap::audioio::DoaEvent event;
+            this->evaluate(event);
+            event.timestamp = data.get_timestamp() + 
+                              static_cast<int64_t>(offset);
+            this->emit_event_callback(event);
+        }
+    }
+}
+
+/**
+ *  Set event callback (called on the thread calling process()).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if system (lock) calling occurred error.
+ *      (xap::audioio::ERROR_SYSTEMCALL)
+ *  @param callback
+ *      The callback.
+ */
+void DoaEstimator::set_event_callback(
+    std::function<void(const xap::audioio::DoaEvent &)> &callback
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_event_callback_lock);
+        this->m_event_callback = callback;
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Reset the state (the current interval is dropped).
+ */
+void DoaEstimator::reset() noexcept {
+    this->m_fill = 0U;
+    this->m_hops = 0U;
+    this->m_active_hops = 0U;
+    memset(this->m_frames.get_pointer(), 0, this->m_frames.get_length());
+    memset(this->m_spectra.get_pointer(), 0, this->m_spectra.get_length());
+    memset(this->m_cross.get_pointer(), 0, this->m_cross.get_length());
+}
+
+/**
+ *  Get the count of directions of the grid.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t DoaEstimator::get_direction_count() const noexcept {
+    return this->m_direction_count;
+}
+
+//
+//  DoaEstimator private methods.
+//
+
+/**
+ *  Process one STFT hop (the input frames are in the analysis buffers).
+ */
+void DoaEstimator::process_hop() noexcept {
+    size_t size = static_cast<size_t>(this->m_options.fft_size);
+    size_t tail = size - this->m_hop;
+    size_t stride = this->m_bin_stride;
+    size_t channel_count = this->m_channel_count;
+    size_t begin = this->m_min_bin;
+    size_t end = this->m_max_bin + 1U;
+    const float *window = this->m_window.get_samples<float>();
+    float *frames = this->m_frames.get_samples<float>();
+    float *spectra = this->m_spectra.get_samples<float>();
+    float *frame = this->m_scratch.get_samples<float>();
+
+    //
+    //  Analysis (one transform per channel), silent hops are skipped.
+    //
+    float power = 0.0F;
+    for (size_t c = 0U; c < channel_count; ++c) {
+        float *source = frames + c * size;
+        for (size_t n = 0U; n < size; ++n) {
+            power += source[n] * source[n];
+        }
+    }
+    bool is_active = 
+        (power >= this->m_min_power * static_cast<float>(size * channel_count));
+    for (size_t c = 0U; c < channel_count && is_active; ++c) {
+        float *source = frames + c * size;
+        for (size_t n = 0U; n < size; ++n) {
+            frame[n] = source[n] * window[n];
+        }
+        float *re = spectra + c * 2U * stride;
+        float *im = re + stride;
+        this->m_fft->forward(frame, re, im);
+
+        //  Phase transform (unit magnitude) in the band.
+        size_t b = begin;
+#if defined(__SSE2__)
+        __m128 minimum = _mm_set1_ps(DOAESTIMATOR_MIN_MAGNITUDE);
+        __m128 one = _mm_set1_ps(1.0F);
+        for (; b + 4U <= end; b += 4U) {
+            __m128 xr = _mm_loadu_ps(re + b);
+            __m128 xi = _mm_loadu_ps(im + b);
+            __m128 scale = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(
+                _mm_add_ps(_mm_mul_ps(xr, xr), _mm_mul_ps(xi, xi)),
+                minimum
+            )));
+            _mm_storeu_ps(re + b, _mm_mul_ps(xr, scale));
+            _mm_storeu_ps(im + b, _mm_mul_ps(xi, scale));
+        }
+#endif
+        for (; b < end; ++b) {
+            float magnitude = re[b] * re[b] + im[b] * im[b];
+            if (magnitude < DOAESTIMATOR_MIN_MAGNITUDE) {
+                magnitude = DOAESTIMATOR_MIN_MAGNITUDE;
+            }
+            float scale = 1.0F / sqrtf(magnitude);
+            re[b] *= scale;
+            im[b] *= scale;
+        }
+    }
+    for (size_t c = 0U; c < channel_count; ++c) {
+        float *source = frames + c * size;
+        memmove(source, source + this->m_hop, tail * sizeof(float));
+    }
+    if (!is_active) {
+        return;
+    }
+    ++(this->m_active_hops);
+
+    //
+    //  Accumulate the cross spectra of all pairs (x_i conj(x_j)).
+    //
+    float *pair = this->m_cross.get_samples<float>();
+    for (size_t i = 0U; i < channel_count; ++i) {
+        const float *xi_re = spectra + i * 2U * stride;
+        const float *xi_im = xi_re + stride;
+        for (size_t j = i + 1U; j < channel_count; ++j) {
+            const float *xj_re = spectra + j * 2U * stride;
+            const float *xj_im = xj_re + stride;
+            float *c_re = pair;
+            float *c_im = pair + stride;
+            size_t b = begin;
+#if defined(__SSE2__)
+            for (; b + 4U <= end; b += 4U) {
+                __m128 ar = _mm_loadu_ps(xi_re + b);
+                __m128 ai = _mm_loadu_ps(xi_im + b);
+                __m128 br = _mm_loadu_ps(xj_re + b);
+                __m128 bi = _mm_loadu_ps(xj_im + b);
+                _mm_storeu_ps(c_re + b, _mm_add_ps(
+                    _mm_loadu_ps(c_re + b),
+                    _mm_add_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi))
+                ));
+                _mm_storeu_ps(c_im + b, _mm_add_ps(
+                    _mm_loadu_ps(c_im + b),
+                    _mm_sub_ps(_mm_mul_ps(ai, br), _mm_mul_ps(ar, bi))
+                ));
+            }
+#endif
+            for (; b < end; ++b) {
+                c_re[b] += xi_re[b] * xj_re[b] + xi_im[b] * xj_im[b];
+                c_im[b] += xi_im[b] * xj_re[b] - xi_re[b] * xj_im[b];
+            }
+            pair += 2U * stride;
+        }
+    }
+}
+
+/**
+ *  Estimate the direction of the interval.
+ * 
+ *  @param event
+ *      The event (output).
+ */
+void DoaEstimator::evaluate(xap::audioio::DoaEvent &event) noexcept {
+    size_t size = static_cast<size_t>(this->m_options.fft_size);
+    size_t stride = this->m_bin_stride;
+    size_t direction_count = this->m_direction_count;
+    size_t correlation_size = size * DOAESTIMATOR_UPSAMPLING;
+    size_t correlation_bins = correlation_size / 2U + 1U;
+    size_t radius = this->m_lag_radius;
+    size_t lag_size = 2U * radius + 2U;
+    float *correlation_re = this->m_scratch.get_samples<float>() + size;
+    float *correlation_im = correlation_re + correlation_bins;
+    float *correlation = correlation_im + correlation_bins;
+    float *lags = correlation + correlation_size;
+    float *response = this->m_response.get_samples<float>();
+    const float *cross = this->m_cross.get_samples<float>();
+    const uint32_t *lag_index = this->m_lag_index.get_samples<uint32_t>();
+    const float *lag_fraction = this->m_lag_fraction.get_samples<float>();
+
+    event.timestamp = 0;
+    event.azimuth = 0.0F;
+    event.confidence = 0.0F;
+    if (this->m_active_hops == 0U) {
+        this->m_hops = 0U;
+        return;
+    }
+
+    //
+    //  GCC-PHAT of each pair, interpolated by zero padding and normalized 
+    //  (1 at the peak of a coherent source), the lags around 0 are kept.
+    //
+    float scale = static_cast<float>(correlation_size) / (
+        2.0F * static_cast<float>(this->m_max_bin - this->m_min_bin + 1U) * 
+        static_cast<float>(this->m_active_hops)
+    );
+    memset(correlation_re, 0, 2U * correlation_bins * sizeof(float));
+    for (size_t p = 0U; p < this->m_pair_count; ++p) {
+        const float *c_re = cross + p * 2U * stride;
+        const float *c_im = c_re + stride;
+        for (size_t b = this->m_min_bin; b <= this->m_max_bin; ++b) {
+            correlation_re[b] = c_re[b] * scale;
+            correlation_im[b] = c_im[b] * scale;
+        }
+        this->m_correlation_fft->inverse(
+            correlation_re,
+            correlation_im,
+            correlation
+        );
+        float *window = lags + p * lag_size;
+        for (size_t n = 0U; n < lag_size; ++n) {
+            window[n] = correlation[
+                (n + correlation_size - radius) % correlation_size
+            ];
+        }
+    }
+
+    //
+    //  Steered response power of each direction (4 directions at once).
+    //
+    memset(response, 0, direction_count * sizeof(float));
+    for (size_t p = 0U; p < this->m_pair_count; ++p) {
+        const float *window = lags + p * lag_size;
+        const uint32_t *index = lag_index + p * direction_count;
+        const float *fraction = lag_fraction + p * direction_count;
+        size_t d = 0U;
+#if defined(__SSE2__)
+        for (; d + 4U <= direction_count; d += 4U) {
+            __m128 a = _mm_setr_ps(
+                window[index[d]],
+                window[index[d + 1U]],
+                window[index[d + 2U]],
+                window[index[d + 3U]]
+            );
+            __m128 b = _mm_setr_ps(
+                window[index[d] + 1U],
+                window[index[d + 1U] + 1U],
+                window[index[d + 2U] + 1U],
+                window[index[d + 3U] + 1U]
+            );
+            __m128 t = _mm_loadu_ps(fraction + d);
+            _mm_storeu_ps(response + d, _mm_add_ps(
+                _mm_loadu_ps(response + d),
+                _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)))
+            ));
+        }
+#endif
+        for (; d < direction_count; ++d) {
+            float a = window[index[d]];
+            float b = window[index[d] + 1U];
+            response[d] += a + fraction[d] * (b - a);
+        }
+    }
+
+    //
+    //  Peak, refined by a parabola through its neighbours.
+    //
+    size_t peak = 0U;
+    for (size_t d = 1U; d < direction_count; ++d) {
+        if (response[d] > response[peak]) {
+            peak = d;
+        }
+    }
+    float offset = 0.0F;
+    if (direction_count >= 3U) {
+        float left = response[(peak + direction_count - 1U) % direction_count];
+        float right = response[(peak + 1U) % direction_count];
+        float curvature = left - 2.0F * response[peak] + right;
+        if (curvature < 0.0F) {
+            offset = 0.5F * (left - right) / curvature;
+        }
+    }
+    float step = 360.0F / static_cast<float>(direction_count);
+    float azimuth = (static_cast<float>(peak) + offset) * step;
+    if (azimuth < 0.0F) {
+        azimuth += 360.0F;
+    } else if (azimuth >= 360.0F) {
+        azimuth -= 360.0F;
+    }
+    float confidence = 
+        response[peak] / static_cast<float>(this->m_pair_count);
+    event.azimuth = azimuth;
+    event.confidence = 
+        confidence < 0.0F ? 0.0F : (confidence > 1.0F ? 1.0F : confidence);
+
+    //
+    //  Start the next interval.
+    //
+    this->m_hops = 0U;
+    this->m_active_hops = 0U;
+    memset(this->m_cross.get_pointer(), 0, this->m_cross.get_length());
+}
+
+/**
+ *  Emit event callback.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param event
+ *      The event.
+ */
+void DoaEstimator::emit_event_callback(const xap::audioio::DoaEvent &event) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_event_callback_lock);
+
+        if (this->m_event_callback) {
+            this->m_event_callback(event);
+        }
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    } catch (std::exception &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_CALLBACK
+        );
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,516 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <math.h>
+#include <string.h>
+#include <system_error>
+#include <xap/audioio/dtmf.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double DTMF_PI = 3.14159265358979323846;
+
+//  Tone frequencies (rows, then columns).
+const static double DTMF_FREQUENCIES[xap::audioio::DTMF_FREQUENCY_COUNT] = {
+    697.0, 770.0, 852.0, 941.0, 1209.0, 1336.0, 1477.0, 1633.0
+};
+
+//  Digits (indexed by row * 4 + column).
+const static char DTMF_DIGITS[16] = {
+    '1', '2', '3', 'A',
+    '4', '5', '6', 'B',
+    '7', '8', '9', 'C',
+    '*', '0', '#', 'D'
+};
+
+//  Block duration (205 samples at 8kHz).
+const static double DTMF_BLOCK_DURATION = 205.0 / 8000.0;
+
+//  Count of streams per SIMD lane group (the state arrays are padded to it).
+const static size_t DTMF_LANE_WIDTH = 4U;
+
+//  Minimum mean square of each tone (amplitude ~250 of 16-bit full scale).
+const static float DTMF_MIN_TONE_POWER = 31250.0F;
+
+//  Normal twist (row tone stronger, 8dB) and reverse twist (column tone 
+//  stronger, 4dB) limits, as ratios of the column to the row tone power.
+const static float DTMF_NORMAL_TWIST = 0.158F;
+const static float DTMF_REVERSE_TWIST = 2.512F;
+
+//  The strongest tone of each group must exceed the others by 8dB.
+const static float DTMF_RELATIVE_PEAK = 6.3F;
+
+//  Minimum ratio of the power of both tones to the total signal power.
+const static float DTMF_ENERGY_RATIO = 0.5F;
+
+//
+//  DtmfDetector constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              stream_count == 0 or the sample rate is lower than 
+ *              4kHz.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param stream_count
+ *      The count of streams.
+ *  @param sample_rate
+ *      The sample rate of all streams.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+DtmfDetector::DtmfDetector(
+    size_t                     stream_count,
+    uint32_t                   sample_rate,
+    xap::audioio::IAllocator  *allocator
+) :
+    m_event_callback(),
+    m_stream_count(stream_count),
+    m_lane_count(
+        (stream_count + DTMF_LANE_WIDTH - 1U) & ~(DTMF_LANE_WIDTH - 1U)
+    ),
+    m_sample_rate(sample_rate),
+    m_block_size(0U),
+    m_block_offset(0U),
+    m_block_start(0),
+    m_previous_start(0),
+    m_s1(nullptr),
+    m_s2(nullptr),
+    m_energy(nullptr),
+    m_column(nullptr),
+    m_last_digit(nullptr),
+    m_current_digit(nullptr),
+    m_memory(nullptr),
+    m_allocated_size(0U),
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{
+    if (stream_count == 0U || sample_rate < 4000U) {
+        throw xap::audioio::Exception(
+            "Invalid stream count or sample rate.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    this->m_block_size = static_cast<size_t>(
+        DTMF_BLOCK_DURATION * static_cast<double>(sample_rate) + 0.5
+    );
+    for (size_t f = 0U; f < xap::audioio::DTMF_FREQUENCY_COUNT; ++f) {
+        this->m_coefficients[f] = static_cast<float>(2.0 * cos(
+            2.0 * DTMF_PI * DTMF_FREQUENCIES[f] / 
+                static_cast<double>(sample_rate)
+        ));
+    }
+
+    //
+    //  Allocate all state at once (lanes of each frequency are contiguous).
+    //
+    size_t lanes = this->m_lane_count;
+    size_t float_count = 
+        lanes * xap::audioio::DTMF_FREQUENCY_COUNT * 2U +  //  s1, s2
+        lanes +                                             //  energy
+        lanes;                                              //  column
+    this->m_allocated_size = float_count * sizeof(float) + lanes * 2U;
+    this->m_memory = this->m_allocator->allocate(
+        this->m_allocated_size, 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT
+    );
+    if (this->m_memory == nullptr) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+    float *memory = static_cast<float *>(this->m_memory);
+    this->m_s1 = memory;
+    this->m_s2 = this->m_s1 + lanes * xap::audioio::DTMF_FREQUENCY_COUNT;
+    this->m_energy = this->m_s2 + lanes * xap::audioio::DTMF_FREQUENCY_COUNT;
+    this->m_column = this->m_energy + lanes;
+    this->m_last_digit = reinterpret_cast<char *>(this->m_column + lanes);
+    this->m_current_digit = this->m_last_digit + lanes;
+
+    memset(this->m_memory, 0, this->m_allocated_size);
+}
+
+/**
+ *  Destruct the object.
+ */
+DtmfDetector::~DtmfDetector() noexcept {
+    this->m_allocator->deallocate(
+        this->m_memory, 
+        this->m_allocated_size, 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT
+    );
+}
+
+//
+//  DtmfDetector public methods.
+//
+
+/**
+ *  Detect digits in interleaved audio data (one sample per stream in each 
+ *  frame).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the event callback occurred error 
+ *      (xap::audioio::ERROR_CALLBACK, xap::audioio::ERROR_SYSTEMCALL).
+ *  @param samples
+ *      The samples.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param timestamp
+ *      The timestamp of the first frame.
+ */
+void DtmfDetector::process(
+    const int16_t *samples, 
+    size_t         frame_count, 
+    int64_t        timestamp
+) {
+    if (this->m_block_offset == 0U) {
+        this->m_block_start = timestamp;
+    }
+    size_t stream_count = this->m_stream_count;
+    for (size_t n = 0U; n < frame_count; ++n) {
+        const int16_t *frame = samples + n * stream_count;
+        for (size_t s = 0U; s < stream_count; ++s) {
+            this->m_column[s] = static_cast<float>(frame[s]);
+        }
+        this->step();
+        if (++(this->m_block_offset) == this->m_block_size) {
+            this->evaluate();
+            this->m_block_offset = 0U;
+            this->m_block_start = timestamp + static_cast<int64_t>(n + 1U);
+        }
+    }
+}
+
+/**
+ *  Detect digits in separate audio data of each stream.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the event callback occurred error 
+ *      (xap::audioio::ERROR_CALLBACK, xap::audioio::ERROR_SYSTEMCALL).
+ *  @param streams
+ *      The samples of each stream (all streams have 'frame_count' 
+ *      samples).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param timestamp
+ *      The timestamp of the first frame.
+ */
+void DtmfDetector::process(
+    const int16_t *const *streams, 
+    size_t                frame_count, 
+    int64_t               timestamp
+) {
+    if (this->m_block_offset == 0U) {
+        this->m_block_start = timestamp;
+    }
+    size_t stream_count = this->m_stream_count;
+    for (size_t n = 0U; n < frame_count; ++n) {
+        for (size_t s = 0U; s < stream_count; ++s) {
+            this->m_column[s] = static_cast<float>(streams[s][n]);
+        }
+        this->step();
+        if (++(this->m_block_offset) == this->m_block_size) {
+            this->evaluate();
+            this->m_block_offset = 0U;
+            this->m_block_start = timestamp + static_cast<int64_t>(n + 1U);
+        }
+    }
+}
+
+/**
+ *  Detect digits in audio data (as a recorder stage, the audio data is 
+ *  not changed).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The audio data is not 16-bit, or its channel count or 
+ *              sample rate mismatched.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              The event callback occurred error.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *  @param data
+ *      The audio data.
+ */
+void DtmfDetector::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != xap::audioio::SAMPLEFORMAT_INT16 || 
+        static_cast<size_t>(data.get_channel_count()) != 
+            this->m_stream_count || 
+        data.get_sample_rate() != this->m_sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    this->process(
+        data.get_samples<const int16_t>(), 
+        data.get_frame_count(), 
+        data.get_timestamp()
+    );
+}
+
+/**
+ *  Set event callback (called on the thread calling process()).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if system (lock) calling occurred error. 
+ *      (xap::audioio::ERROR_SYSTEMCALL)
+ *  @param callback
+ *      The callback.
+ */
+void DtmfDetector::set_event_callback(
+    std::function<void(const xap::audioio::DtmfEvent &)> &callback
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_event_callback_lock);
+        this->m_event_callback = callback;
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(), 
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Reset the state of all streams.
+ */
+void DtmfDetector::reset() noexcept {
+    this->m_block_offset = 0U;
+    this->m_block_start = 0;
+    this->m_previous_start = 0;
+    memset(this->m_memory, 0, this->m_allocated_size);
+}
+
+/**
+ *  Get the count of streams.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t DtmfDetector::get_stream_count() const noexcept {
+    return this->m_stream_count;
+}
+
+//
+//  DtmfDetector private methods.
+//
+
+/**
+ *  Run the filter bank over one frame (in m_column).
+ */
+void DtmfDetector::step() noexcept {
+    size_t lanes = this->m_lane_count;
+    const float *column = this->m_column;
+
+#if defined(__SSE2__)
+    for (size_t f = 0U; f < xap::audioio::DTMF_FREQUENCY_COUNT; ++f) {
+        __m128 coefficient = _mm_set1_ps(this->m_coefficients[f]);
+        float *s1 = this->m_s1 + f * lanes;
+        float *s2 = this->m_s2 + f * lanes;
+        for (size_t s = 0U; s < lanes; s += DTMF_LANE_WIDTH) {
+            __m128 x = _mm_load_ps(column + s);
+            __m128 a = _mm_load_ps(s1 + s);
+            __m128 b = _mm_load_ps(s2 + s);
+            __m128 y = _mm_sub_ps(_mm_add_ps(x, _mm_mul_ps(coefficient, a)), b);
+            _mm_store_ps(s2 + s, a);
+            _mm_store_ps(s1 + s, y);
+        }
+    }
+    for (size_t s = 0U; s < lanes; s += DTMF_LANE_WIDTH) {
+        __m128 x = _mm_load_ps(column + s);
+        _mm_store_ps(
+            this->m_energy + s, 
+            _mm_add_ps(_mm_load_ps(this->m_energy + s), _mm_mul_ps(x, x))
+        );
+    }
+#else
+    for (size_t f = 0U; f < xap::audioio::DTMF_FREQUENCY_COUNT; ++f) {
+        float coefficient = this->m_coefficients[f];
+        float *s1 = this->m_s1 + f * lanes;
+        float *s2 = this->m_s2 + f * lanes;
+        for (size_t s = 0U; s < lanes; ++s) {
+            float y = column[s] + coefficient * s1[s] - s2[s];
+            s2[s] = s1[s];
+            s1[s] = y;
+        }
+    }
+    for (size_t s = 0U; s < lanes; ++s) {
+        this->m_energy[s] += column[s] * column[s];
+    }
+#endif
+}
+
+/**
+ *  Evaluate the filter bank at the end of a block and report digits.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the event callback occurred error.
+ */
+void DtmfDetector::evaluate() {
+    size_t lanes = this->m_lane_count;
+    float block_size = static_cast<float>(this->m_block_size);
+
+    //  Goertzel power * 2 / N^2 is the mean square of a tone.
+    float scale = 2.0F / (block_size * block_size);
+
+    for (size_t s = 0U; s < this->m_stream_count; ++s) {
+        //
+        //  Tone powers.
+        //
+        float powers[xap::audioio::DTMF_FREQUENCY_COUNT];
+        for (size_t f = 0U; f < xap::audioio::DTMF_FREQUENCY_COUNT; ++f) {
+            float a = this->m_s1[f * lanes + s];
+            float b = this->m_s2[f * lanes + s];
+            powers[f] = (a * a + b * b - this->m_coefficients[f] * a * b) * 
+                        scale;
+        }
+        size_t row = 0U;
+        size_t column = 4U;
+        for (size_t f = 1U; f < 4U; ++f) {
+            if (powers[f] > powers[row]) {
+                row = f;
+            }
+            if (powers[f + 4U] > powers[column]) {
+                column = f + 4U;
+            }
+        }
+
+        //
+        //  Checks: level, twist, relative peak, energy ratio.
+        //
+        char digit = 0;
+        float row_power = powers[row];
+        float column_power = powers[column];
+        float energy = this->m_energy[s] / block_size;
+        if (row_power >= DTMF_MIN_TONE_POWER && 
+            column_power >= DTMF_MIN_TONE_POWER && 
+            column_power >= row_power * DTMF_NORMAL_TWIST && 
+            column_power <= row_power * DTMF_REVERSE_TWIST && 
+            row_power + column_power >= energy * DTMF_ENERGY_RATIO) {
+            bool is_peak = true;
+            for (size_t f = 0U; f < 4U; ++f) {
+                if ((f != row && 
+                     powers[f] * DTMF_RELATIVE_PEAK > row_power) || 
+                    (f + 4U != column && 
+                     powers[f + 4U] * DTMF_RELATIVE_PEAK > column_power)) {
+                    is_peak = false;
+                    break;
+                }
+            }
+            if (is_peak) {
+                digit = DTMF_DIGITS[row * 4U + (column - 4U)];
+            }
+        }
+
+        //
+        //  Report a digit once it was seen in two consecutive blocks, 
+        //  release it after one quiet block (too little energy to hold a 
+        //  tone, e.g. the pause between two presses of the same digit) or 
+        //  after two blocks without it.
+        //
+        bool is_quiet = energy < DTMF_MIN_TONE_POWER;
+        char last = this->m_last_digit[s];
+        if (digit != 0 && digit == last && 
+            digit != this->m_current_digit[s]) {
+            this->m_current_digit[s] = digit;
+
+            xap::audioio::DtmfEvent event;
+            memset(&event, 0, sizeof(event));
+            event.timestamp = this->m_previous_start;
+            event.stream = static_cast<uint32_t>(s);
+            event.digit = digit;
+            this->emit_event_callback(event);
+        } else if (digit == 0 && (last == 0 || is_quiet)) {
+            this->m_current_digit[s] = 0;
+        }
+        this->m_last_digit[s] = digit;
+    }
+
+    //
+    //  Restart the filter bank.
+    //
+    memset(
+        this->m_s1, 
+        0, 
+        lanes * xap::audioio::DTMF_FREQUENCY_COUNT * 2U * sizeof(float)
+    );
+    memset(this->m_energy, 0, lanes * sizeof(float));
+    this->m_previous_start = this->m_block_start;
+}
+
+/**
+ *  Emit event callback.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param event
+ *      The event.
+ */
+void DtmfDetector::emit_event_callback(const xap::audioio::DtmfEvent &event) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_event_callback_lock);
+
+        if (this->m_event_callback) {
+            this->m_event_callback(event);
+        }
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(), 
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    } catch (std::exception &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_CALLBACK
+        );
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
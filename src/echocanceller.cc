@@ -0,0 +1,968 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fft_p.h"
+#include "fir_p.h"
+
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/echocanceller.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double ECHOCANCELLER_PI = 3.14159265358979323846;
+
+//  Step size until the filter has seen one filter length of far-end audio.
+const static float ECHOCANCELLER_INITIAL_STEP = 1.0F;
+
+//  Upper bound of the step size of each bin afterwards.
+const static float ECHOCANCELLER_MAX_STEP = 1.0F;
+
+//  The residual echo is overestimated by this ratio when the step size of 
+//  each bin is derived from it (the step is bounded anyway).
+const static float ECHOCANCELLER_STEP_LEAK = 3.0F;
+
+//  Weight of the ratio of each bin (against the ratio of the whole block) 
+//  in the step size.
+const static float ECHOCANCELLER_STEP_MIX = 0.7F;
+
+//  Lower bound of the leakage estimate.
+const static float ECHOCANCELLER_MIN_LEAK = 0.005F;
+
+//  Count of blocks double-talk is held after it was detected.
+const static size_t ECHOCANCELLER_DOUBLE_TALK_HANGOVER = 8U;
+
+//  Over-subtraction of the residual echo suppressor (single-talk and 
+//  double-talk).
+const static float ECHOCANCELLER_OVER_SUBTRACTION = 2.0F;
+const static float ECHOCANCELLER_DOUBLE_TALK_OVER_SUBTRACTION = 1.0F;
+
+//  Smoothing of the per-bin powers of the residual echo suppressor.
+const static float ECHOCANCELLER_POWER_SMOOTHING = 0.3F;
+
+//  The filter diverged if the error power exceeds the near-end power by 
+//  this ratio (it is scaled down then).
+const static float ECHOCANCELLER_DIVERGENCE = 4.0F;
+
+//  Smoothing of the echo return loss enhancement.
+const static float ECHOCANCELLER_ERLE_SMOOTHING = 0.05F;
+
+//  Floor of powers (avoids divisions by zero).
+const static float ECHOCANCELLER_EPSILON = 1e-20F;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Validate the options of an echo canceller.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the parameters are invalid (xap::audioio::ERROR_PARAMETER) 
+ *      or the format is not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param format
+ *      The audio format.
+ *  @param options
+ *      The options.
+ *  @return
+ *      The count of frames of each block.
+ */
+static size_t validate_options(
+    const xap::audioio::AudioFormat           &format,
+    const xap::audioio::EchoCancellerOptions  &options
+) {
+    if ((format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        format.channel_count != 1U) {
+        throw xap::audioio::Exception(
+            "Only mono 16-bit or 32-bit float audio data is supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t block = static_cast<size_t>(options.block_frames);
+    if (format.sample_rate == 0U || 
+        block < 16U || (block & (block - 1U)) != 0U || 
+        options.filter_length == 0U || 
+        options.max_frames == 0U || 
+        !(options.suppression >= 0.0F) || 
+        !(options.double_talk_threshold > 1.0F)) {
+        throw xap::audioio::Exception(
+            "Invalid echo canceller options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    return block;
+}
+
+/**
+ *  Build the audio format of the canceller state (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Multiply and accumulate split complex vectors (y += w * x).
+ * 
+ *  @param y_re
+ *      The real parts of the accumulator.
+ *  @param y_im
+ *      The imaginary parts of the accumulator.
+ *  @param w_re
+ *      The real parts of the vector w.
+ *  @param w_im
+ *      The imaginary parts of the vector w.
+ *  @param x_re
+ *      The real parts of the vector x.
+ *  @param x_im
+ *      The imaginary parts of the vector x.
+ *  @param count
+ *      The count of elements (a multiple of 4).
+ */
+static inline void complex_multiply_accumulate(
+    float        *y_re,
+    float        *y_im,
+    const float  *w_re,
+    const float  *w_im,
+    const float  *x_re,
+    const float  *x_im,
+    size_t        count
+) noexcept {
+    size_t b = 0U;
+#if defined(__SSE2__)
+    for (; b < count; b += 4U) {
+        __m128 wr = _mm_loadu_ps(w_re + b);
+        __m128 wi = _mm_loadu_ps(w_im + b);
+        __m128 xr = _mm_loadu_ps(x_re + b);
+        __m128 xi = _mm_loadu_ps(x_im + b);
+        _mm_storeu_ps(y_re + b, _mm_add_ps(
+            _mm_loadu_ps(y_re + b),
+            _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi))
+        ));
+        _mm_storeu_ps(y_im + b, _mm_add_ps(
+            _mm_loadu_ps(y_im + b),
+            _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr))
+        ));
+    }
+#endif
+    for (; b < count; ++b) {
+        y_re[b] += w_re[b] * x_re[b] - w_im[b] * x_im[b];
+        y_im[b] += w_re[b] * x_im[b] + w_im[b] * x_re[b];
+    }
+}
+
+/**
+ *  Update filter weights with the normalized gradient 
+ *  (w += step * e * conj(x)).
+ * 
+ *  @param w_re
+ *      The real parts of the weights.
+ *  @param w_im
+ *      The imaginary parts of the weights.
+ *  @param e_re
+ *      The real parts of the error.
+ *  @param e_im
+ *      The imaginary parts of the error.
+ *  @param x_re
+ *      The real parts of the input.
+ *  @param x_im
+ *      The imaginary parts of the input.
+ *  @param step
+ *      The (normalized) step size of each element.
+ *  @param count
+ *      The count of elements (a multiple of 4).
+ */
+static inline void complex_update(
+    float        *w_re,
+    float        *w_im,
+    const float  *e_re,
+    const float  *e_im,
+    const float  *x_re,
+    const float  *x_im,
+    const float  *step,
+    size_t        count
+) noexcept {
+    size_t b = 0U;
+#if defined(__SSE2__)
+    for (; b < count; b += 4U) {
+        __m128 er = _mm_loadu_ps(e_re + b);
+        __m128 ei = _mm_loadu_ps(e_im + b);
+        __m128 xr = _mm_loadu_ps(x_re + b);
+        __m128 xi = _mm_loadu_ps(x_im + b);
+        __m128 mu = _mm_loadu_ps(step + b);
+        _mm_storeu_ps(w_re + b, _mm_add_ps(
+            _mm_loadu_ps(w_re + b),
+            _mm_mul_ps(
+                mu,
+                _mm_add_ps(_mm_mul_ps(er, xr), _mm_mul_ps(ei, xi))
+            )
+        ));
+        _mm_storeu_ps(w_im + b, _mm_add_ps(
+            _mm_loadu_ps(w_im + b),
+            _mm_mul_ps(
+                mu,
+                _mm_sub_ps(_mm_mul_ps(ei, xr), _mm_mul_ps(er, xi))
+            )
+        ));
+    }
+#endif
+    for (; b < count; ++b) {
+        w_re[b] += step[b] * (e_re[b] * x_re[b] + e_im[b] * x_im[b]);
+        w_im[b] += step[b] * (e_im[b] * x_re[b] - e_re[b] * x_im[b]);
+    }
+}
+
+/**
+ *  Accumulate the squared magnitudes of a split complex vector 
+ *  (p += sign * |x|^2).
+ * 
+ *  @param power
+ *      The accumulator.
+ *  @param x_re
+ *      The real parts.
+ *  @param x_im
+ *      The imaginary parts.
+ *  @param sign
+ *      1 to add, -1 to subtract.
+ *  @param count
+ *      The count of elements (a multiple of 4).
+ */
+static inline void accumulate_power(
+    float        *power,
+    const float  *x_re,
+    const float  *x_im,
+    float         sign,
+    size_t        count
+) noexcept {
+    size_t b = 0U;
+#if defined(__SSE2__)
+    __m128 s = _mm_set1_ps(sign);
+    for (; b < count; b += 4U) {
+        __m128 xr = _mm_loadu_ps(x_re + b);
+        __m128 xi = _mm_loadu_ps(x_im + b);
+        _mm_storeu_ps(power + b, _mm_add_ps(
+            _mm_loadu_ps(power + b),
+            _mm_mul_ps(
+                s,
+                _mm_add_ps(_mm_mul_ps(xr, xr), _mm_mul_ps(xi, xi))
+            )
+        ));
+    }
+#endif
+    for (; b < count; ++b) {
+        power[b] += sign * (x_re[b] * x_re[b] + x_im[b] * x_im[b]);
+    }
+}
+
+//
+//  EchoCanceller constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The options are invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format is not mono 16-bit or 32-bit float.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param format
+ *      The audio format (of both the near-end and the far-end signal).
+ *  @param far_end
+ *      The far-end source (nullptr if only the frame-based process() 
+ *      is used).
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+EchoCanceller::EchoCanceller(
+    const xap::audioio::AudioFormat              &format,
+    std::shared_ptr<xap::audioio::ISource>        far_end,
+    const xap::audioio::EchoCancellerOptions     &options,
+    xap::audioio::IAllocator                     *allocator
+) :
+    m_format(format),
+    m_far_end(far_end),
+    m_options(options),
+    m_block(validate_options(format, options)),
+    m_size(2U * m_block),
+    m_bin_stride((m_block + 1U + 3U) & ~static_cast<size_t>(3U)),
+    m_partition_count(0U),
+    m_head(0U),
+    m_constrained(0U),
+    m_fill(0U),
+    m_queue_count(0U),
+    m_active_blocks(0U),
+    m_double_talk_hangover(0U),
+    m_min_power(0.0F),
+    m_min_gain(1.0F),
+    m_leak(1.0F),
+    m_echo_error_covariance(0.0F),
+    m_echo_variance(0.0F),
+    m_near_average(0.0F),
+    m_error_average(0.0F),
+    m_is_adapted(false),
+    m_is_double_talk(false),
+    m_fft(nullptr),
+    m_filter(nullptr),
+    m_far_spectra(nullptr),
+    m_far_power(nullptr),
+    m_echo(nullptr),
+    m_error(nullptr),
+    m_error_window(nullptr),
+    m_echo_window(nullptr),
+    m_error_mean(nullptr),
+    m_echo_mean(nullptr),
+    m_error_power(nullptr),
+    m_residual_power(nullptr),
+    m_window(nullptr),
+    m_far_frame(nullptr),
+    m_error_frame(nullptr),
+    m_echo_frame(nullptr),
+    m_overlap(nullptr),
+    m_time(nullptr),
+    m_near_block(nullptr),
+    m_far_block(nullptr),
+    m_queue(nullptr),
+    m_state(),
+    m_far_buffer()
+{
+    size_t block = this->m_block;
+    size_t size = this->m_size;
+    size_t stride = this->m_bin_stride;
+    double filter_frames = 
+        static_cast<double>(format.sample_rate) * 
+        static_cast<double>(options.filter_length) / 1000.0;
+    this->m_partition_count = static_cast<size_t>(
+        ceil(filter_frames / static_cast<double>(block))
+    );
+    size_t partitions = this->m_partition_count;
+    this->m_min_power = static_cast<float>(
+        pow(10.0, static_cast<double>(options.far_end_level) / 10.0)
+    );
+    this->m_min_gain = static_cast<float>(
+        pow(10.0, -static_cast<double>(options.suppression) / 20.0)
+    );
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    //
+    //  All state in one buffer: the filter and the far-end spectra of each 
+    //  partition, 4 spectra, 6 per-bin arrays, 6 frames and 3 blocks.
+    //
+    size_t spectrum = 2U * stride;
+    this->m_state = xap::audioio::AudioBuffer::allocate(
+        build_state_format(format.sample_rate),
+        2U * partitions * spectrum + 4U * spectrum + 6U * stride + 
+            6U * size + 3U * block,
+        allocator
+    );
+    float *state = this->m_state.get_samples<float>();
+    this->m_filter = state;
+    this->m_far_spectra = this->m_filter + partitions * spectrum;
+    this->m_far_power = this->m_far_spectra + partitions * spectrum;
+    this->m_echo = this->m_far_power + stride;
+    this->m_error = this->m_echo + spectrum;
+    this->m_error_window = this->m_error + spectrum;
+    this->m_echo_window = this->m_error_window + spectrum;
+    this->m_error_mean = this->m_echo_window + spectrum;
+    this->m_echo_mean = this->m_error_mean + stride;
+    this->m_error_power = this->m_echo_mean + stride;
+    this->m_residual_power = this->m_error_power + stride;
+    this->m_window = this->m_residual_power + stride;
+    this->m_far_frame = this->m_window + size;
+    this->m_error_frame = this->m_far_frame + size;
+    this->m_echo_frame = this->m_error_frame + size;
+    this->m_overlap = this->m_echo_frame + size;
+    this->m_time = this->m_overlap + size;
+    this->m_near_block = this->m_time + size;
+    this->m_far_block = this->m_near_block + block;
+    this->m_queue = this->m_far_block + block;
+
+    this->m_far_buffer = xap::audioio::AudioBuffer::allocate(
+        format,
+        options.max_frames,
+        allocator
+    );
+    this->m_fft = xap::audioio::new_object<xap::audioio::Fft>(
+        allocator,
+        size,
+        allocator
+    );
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+EchoCanceller::~EchoCanceller() noexcept {
+    this->m_fft->~Fft();
+    xap::audioio::free_object(this->m_fft);
+}
+
+//
+//  EchoCanceller public methods.
+//
+
+/**
+ *  Cancel the echo of a near-end period (in place), the far-end audio 
+ *  data is read from the far-end source (missing frames are silent).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio data mismatched.
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              No far-end source.
+ * 
+ *          - Other errors raised by the far-end source.
+ * 
+ *  @param data
+ *      The near-end audio data.
+ */
+void EchoCanceller::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_format.sample_format || 
+        data.get_channel_count() != this->m_format.channel_count || 
+        data.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (!this->m_far_end) {
+        throw xap::audioio::Exception(
+            "No far-end source.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    size_t sample_size = 
+        xap::audioio::get_sample_size(this->m_format.sample_format);
+    size_t frame_count = data.get_frame_count();
+    uint8_t *samples = data.get_pointer();
+    for (size_t offset = 0U; offset < frame_count; ) {
+        size_t count = frame_count - offset;
+        if (count > this->m_options.max_frames) {
+            count = this->m_options.max_frames;
+        }
+        xap::audioio::AudioBuffer far_end = this->m_far_buffer.slice(0U, count);
+        size_t read = this->m_far_end->read(far_end);
+        if (read < count) {
+            memset(
+                far_end.get_pointer() + read * sample_size,
+                0,
+                (count - read) * sample_size
+            );
+        }
+        this->process(
+            samples + offset * sample_size,
+            far_end.get_pointer(),
+            samples + offset * sample_size,
+            count
+        );
+        offset += count;
+    }
+}
+
+/**
+ *  Cancel the echo of near-end frames (samples in the audio format of 
+ *  the canceller, output may be the near-end samples).
+ * 
+ *  @param near_end
+ *      The near-end samples.
+ *  @param far_end
+ *      The far-end samples (played at the same time).
+ *  @param output
+ *      The output samples.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void EchoCanceller::process(
+    const void  *near_end,
+    const void  *far_end,
+    void        *output,
+    size_t       frame_count
+) noexcept {
+    bool is_float = 
+        (this->m_format.sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32);
+    const float *near_float = static_cast<const float *>(near_end);
+    const float *far_float = static_cast<const float *>(far_end);
+    float *output_float = static_cast<float *>(output);
+    const int16_t *near_int16 = static_cast<const int16_t *>(near_end);
+    const int16_t *far_int16 = static_cast<const int16_t *>(far_end);
+    int16_t *output_int16 = static_cast<int16_t *>(output);
+    for (size_t offset = 0U; offset < frame_count; ) {
+        size_t count = this->m_block - this->m_fill;
+        if (count > frame_count - offset) {
+            count = frame_count - offset;
+        }
+
+        //
+        //  Take the input first (the output may overwrite it).
+        //
+        float *near_block = this->m_near_block + this->m_fill;
+        float *far_block = this->m_far_block + this->m_fill;
+        if (is_float) {
+            memcpy(near_block, near_float + offset, count * sizeof(float));
+            memcpy(far_block, far_float + offset, count * sizeof(float));
+        } else {
+            for (size_t i = 0U; i < count; ++i) {
+                near_block[i] = 
+                    static_cast<float>(near_int16[offset + i]) / 32768.0F;
+                far_block[i] = 
+                    static_cast<float>(far_int16[offset + i]) / 32768.0F;
+            }
+        }
+
+        //
+        //  Deliver the oldest frames of the output queue (which holds 
+        //  'block - fill' frames).
+        //
+        if (is_float) {
+            memcpy(output_float + offset, this->m_queue, count * sizeof(float));
+        } else {
+            for (size_t i = 0U; i < count; ++i) {
+                output_int16[offset + i] = xap::audioio::fir_saturate_int16(
+                    this->m_queue[i] * 32768.0F
+                );
+            }
+        }
+        this->m_queue_count -= count;
+        memmove(
+            this->m_queue,
+            this->m_queue + count,
+            this->m_queue_count * sizeof(float)
+        );
+
+        this->m_fill += count;
+        offset += count;
+        if (this->m_fill == this->m_block) {
+            this->process_block();
+            this->m_fill = 0U;
+        }
+    }
+}
+
+/**
+ *  Reset the adaptive filter and all state.
+ */
+void EchoCanceller::reset() noexcept {
+    size_t size = this->m_size;
+    memset(this->m_state.get_pointer(), 0, this->m_state.get_length());
+
+    //  Square root of the periodic Hann window (analysis and synthesis).
+    for (size_t n = 0U; n < size; ++n) {
+        this->m_window[n] = static_cast<float>(sqrt(
+            0.5 - 0.5 * cos(
+                2.0 * ECHOCANCELLER_PI * static_cast<double>(n) / 
+                static_cast<double>(size)
+            )
+        ));
+    }
+    //  Prime the output queue with one block of silence.
+    this->m_queue_count = this->m_block;
+    this->m_fill = 0U;
+    this->m_head = 0U;
+    this->m_constrained = 0U;
+    this->m_active_blocks = 0U;
+    this->m_double_talk_hangover = 0U;
+    this->m_leak = 1.0F;
+    this->m_echo_error_covariance = 0.0F;
+    this->m_echo_variance = 0.0F;
+    this->m_near_average = 0.0F;
+    this->m_error_average = 0.0F;
+    this->m_is_adapted = false;
+    this->m_is_double_talk = false;
+}
+
+/**
+ *  Get the delay of the output (in frames).
+ * 
+ *  @return
+ *      The delay.
+ */
+size_t EchoCanceller::get_latency() const noexcept {
+    return 2U * this->m_block;
+}
+
+/**
+ *  Get the echo return loss enhancement of the adaptive filter (in dB, 
+ *  averaged over the blocks with far-end activity).
+ * 
+ *  @return
+ *      The echo return loss enhancement.
+ */
+float EchoCanceller::get_erle() const noexcept {
+    if (!(this->m_error_average > ECHOCANCELLER_EPSILON) || 
+        !(this->m_near_average > ECHOCANCELLER_EPSILON)) {
+        return 0.0F;
+    }
+    return 10.0F * log10f(this->m_near_average / this->m_error_average);
+}
+
+/**
+ *  Get whether double-talk is detected (in the last block).
+ * 
+ *  @return
+ *      True if so.
+ */
+bool EchoCanceller::is_double_talk() const noexcept {
+    return this->m_is_double_talk;
+}
+
+//
+//  EchoCanceller private methods.
+//
+
+/**
+ *  Process one block (in m_near_block and m_far_block), appending 
+ *  'block_frames' frames to the output queue.
+ */
+void EchoCanceller::process_block() noexcept {
+    size_t block = this->m_block;
+    size_t size = this->m_size;
+    size_t stride = this->m_bin_stride;
+    size_t spectrum = 2U * stride;
+    size_t partitions = this->m_partition_count;
+    const float *near_block = this->m_near_block;
+    const float *far_block = this->m_far_block;
+    float *time = this->m_time;
+
+    //
+    //  Spectrum of the newest far-end frame, replacing the oldest partition 
+    //  (the per-bin power of all partitions is maintained incrementally and 
+    //  recomputed once per cycle).
+    //
+    memmove(
+        this->m_far_frame,
+        this->m_far_frame + block,
+        block * sizeof(float)
+    );
+    memcpy(this->m_far_frame + block, far_block, block * sizeof(float));
+    float far_power = 0.0F;
+    for (size_t i = 0U; i < block; ++i) {
+        far_power += far_block[i] * far_block[i];
+    }
+    bool is_far_active = 
+        (far_power >= this->m_min_power * static_cast<float>(block));
+    this->m_head = (this->m_head + partitions - 1U) % partitions;
+    float *newest_re = this->m_far_spectra + this->m_head * spectrum;
+    float *newest_im = newest_re + stride;
+    accumulate_power(this->m_far_power, newest_re, newest_im, -1.0F, stride);
+    this->m_fft->forward(this->m_far_frame, newest_re, newest_im);
+    if (this->m_head == 0U) {
+        memset(this->m_far_power, 0, stride * sizeof(float));
+        for (size_t k = 0U; k < partitions; ++k) {
+            const float *x_re = this->m_far_spectra + k * spectrum;
+            accumulate_power(
+                this->m_far_power,
+                x_re,
+                x_re + stride,
+                1.0F,
+                stride
+            );
+        }
+    } else {
+        accumulate_power(this->m_far_power, newest_re, newest_im, 1.0F, stride);
+        for (size_t b = 0U; b < stride; ++b) {
+            if (this->m_far_power[b] < 0.0F) {
+                this->m_far_power[b] = 0.0F;
+            }
+        }
+    }
+
+    //
+    //  Echo estimate (overlap-save, the second half of the frame).
+    //
+    float *echo_re = this->m_echo;
+    float *echo_im = echo_re + stride;
+    memset(echo_re, 0, spectrum * sizeof(float));
+    for (size_t k = 0U; k < partitions; ++k) {
+        const float *w_re = this->m_filter + k * spectrum;
+        const float *x_re = 
+            this->m_far_spectra + ((this->m_head + k) % partitions) * spectrum;
+        complex_multiply_accumulate(
+            echo_re,
+            echo_im,
+            w_re,
+            w_re + stride,
+            x_re,
+            x_re + stride,
+            stride
+        );
+    }
+    this->m_fft->inverse(echo_re, echo_im, time);
+
+    //
+    //  Error.
+    //
+    memmove(
+        this->m_error_frame,
+        this->m_error_frame + block,
+        block * sizeof(float)
+    );
+    memmove(
+        this->m_echo_frame,
+        this->m_echo_frame + block,
+        block * sizeof(float)
+    );
+    float *error = this->m_error_frame + block;
+    float *echo = this->m_echo_frame + block;
+    float near_power = 0.0F;
+    float error_power = 0.0F;
+    float echo_power = 0.0F;
+    for (size_t i = 0U; i < block; ++i) {
+        echo[i] = time[block + i];
+        error[i] = near_block[i] - echo[i];
+        near_power += near_block[i] * near_block[i];
+        error_power += error[i] * error[i];
+        echo_power += echo[i] * echo[i];
+    }
+
+    //
+    //  Spectra of the error (zero-padded, for the gradient) and windowed 
+    //  spectra of the error and the echo estimate (for the leakage estimate 
+    //  and the residual echo suppressor).
+    //
+    float *error_re = this->m_error;
+    float *error_im = error_re + stride;
+    memset(time, 0, block * sizeof(float));
+    memcpy(time + block, error, block * sizeof(float));
+    this->m_fft->forward(time, error_re, error_im);
+    float *error_window_re = this->m_error_window;
+    float *error_window_im = error_window_re + stride;
+    float *echo_window_re = this->m_echo_window;
+    float *echo_window_im = echo_window_re + stride;
+    for (size_t n = 0U; n < size; ++n) {
+        time[n] = this->m_error_frame[n] * this->m_window[n];
+    }
+    this->m_fft->forward(time, error_window_re, error_window_im);
+    for (size_t n = 0U; n < size; ++n) {
+        time[n] = this->m_echo_frame[n] * this->m_window[n];
+    }
+    this->m_fft->forward(time, echo_window_re, echo_window_im);
+
+    //
+    //  Double-talk: the error is much larger than the residual echo 
+    //  expected from the leakage (an echo path change raises the leakage 
+    //  instead).
+    //
+    float residual = this->m_leak * echo_power + 
+                     this->m_min_power * static_cast<float>(block);
+    if (this->m_is_adapted && is_far_active && 
+        error_power > this->m_options.double_talk_threshold * residual) {
+        this->m_double_talk_hangover = ECHOCANCELLER_DOUBLE_TALK_HANGOVER;
+    }
+    this->m_is_double_talk = (this->m_double_talk_hangover != 0U);
+    if (this->m_double_talk_hangover != 0U) {
+        --(this->m_double_talk_hangover);
+    }
+
+    //
+    //  Leakage estimate: correlation of the power fluctuations of the error 
+    //  and of the echo estimate of each bin. It is also updated during 
+    //  double-talk (slowly, the near-end talker is uncorrelated with the 
+    //  echo estimate), an echo path change raises it and ends the 
+    //  double-talk.
+    //
+    size_t bin_count = block + 1U;
+    float sample_rate = static_cast<float>(this->m_format.sample_rate);
+    if (is_far_active) {
+        float average = static_cast<float>(block) / sample_rate;
+        float covariance = 0.0F;
+        float variance = 0.0F;
+        for (size_t b = 0U; b < bin_count; ++b) {
+            float e = error_window_re[b] * error_window_re[b] + 
+                      error_window_im[b] * error_window_im[b];
+            float y = echo_window_re[b] * echo_window_re[b] + 
+                      echo_window_im[b] * echo_window_im[b];
+            this->m_error_mean[b] += average * (e - this->m_error_mean[b]);
+            this->m_echo_mean[b] += average * (y - this->m_echo_mean[b]);
+            float de = e - this->m_error_mean[b];
+            float dy = y - this->m_echo_mean[b];
+            covariance += de * dy;
+            variance += dy * dy;
+        }
+        float beta = 2.0F * static_cast<float>(block) / sample_rate;
+        float alpha = beta * echo_power / 
+                      (error_power + ECHOCANCELLER_EPSILON);
+        if (alpha > 0.5F * beta) {
+            alpha = 0.5F * beta;
+        }
+        if (this->m_echo_variance == 0.0F) {
+            alpha = 1.0F;
+        }
+        this->m_echo_error_covariance += 
+            alpha * (covariance - this->m_echo_error_covariance);
+        this->m_echo_variance += alpha * (variance - this->m_echo_variance);
+        if (this->m_echo_variance > ECHOCANCELLER_EPSILON) {
+            float leak = this->m_echo_error_covariance / this->m_echo_variance;
+            this->m_leak = leak < ECHOCANCELLER_MIN_LEAK ? 
+                ECHOCANCELLER_MIN_LEAK :
+                (leak > 1.0F ? 1.0F : leak);
+        }
+    }
+
+    //
+    //  Adaptation (normalized by the far-end power of each bin, the step of 
+    //  each bin follows the residual echo to error ratio once adapted).
+    //
+    if (is_far_active && !this->m_is_double_talk) {
+        if (error_power > ECHOCANCELLER_DIVERGENCE * near_power + 
+                          this->m_min_power * static_cast<float>(block)) {
+            for (size_t n = 0U; n < partitions * spectrum; ++n) {
+                this->m_filter[n] *= 0.5F;
+            }
+        }
+
+        //  The step of each bin is kept in the time buffer, the residual to 
+        //  error ratio of the whole block is mixed in so that bins with a 
+        //  poor echo estimate keep adapting.
+        float *step = time;
+        float regularization = 
+            this->m_min_power * static_cast<float>(size * partitions);
+        float block_ratio = ECHOCANCELLER_STEP_LEAK * this->m_leak * 
+                            echo_power / (error_power + ECHOCANCELLER_EPSILON);
+        if (block_ratio > ECHOCANCELLER_MAX_STEP) {
+            block_ratio = ECHOCANCELLER_MAX_STEP;
+        }
+        for (size_t b = 0U; b < stride; ++b) {
+            float mu = ECHOCANCELLER_INITIAL_STEP;
+            if (this->m_is_adapted) {
+                float e = error_window_re[b] * error_window_re[b] + 
+                          error_window_im[b] * error_window_im[b];
+                float y = echo_window_re[b] * echo_window_re[b] + 
+                          echo_window_im[b] * echo_window_im[b];
+                float r = ECHOCANCELLER_STEP_LEAK * this->m_leak * y;
+                if (r > ECHOCANCELLER_MAX_STEP * e) {
+                    r = ECHOCANCELLER_MAX_STEP * e;
+                }
+                mu = ECHOCANCELLER_STEP_MIX * r / (e + ECHOCANCELLER_EPSILON) + 
+                     (1.0F - ECHOCANCELLER_STEP_MIX) * block_ratio;
+            }
+            step[b] = mu / (this->m_far_power[b] + regularization);
+        }
+        for (size_t k = 0U; k < partitions; ++k) {
+            float *w_re = this->m_filter + k * spectrum;
+            const float *x_re = 
+                this->m_far_spectra + 
+                ((this->m_head + k) % partitions) * spectrum;
+            complex_update(
+                w_re,
+                w_re + stride,
+                error_re,
+                error_im,
+                x_re,
+                x_re + stride,
+                step,
+                stride
+            );
+        }
+
+        //
+        //  Gradient constraint of one partition per block (the filter of 
+        //  each partition must stay 'block' taps long).
+        //
+        float *w_re = this->m_filter + this->m_constrained * spectrum;
+        float *w_im = w_re + stride;
+        this->m_fft->inverse(w_re, w_im, time);
+        memset(time + block, 0, block * sizeof(float));
+        this->m_fft->forward(time, w_re, w_im);
+        this->m_constrained = (this->m_constrained + 1U) % partitions;
+
+        if (++(this->m_active_blocks) > partitions) {
+            this->m_is_adapted = true;
+        }
+        this->m_near_average += 
+            ECHOCANCELLER_ERLE_SMOOTHING * (near_power - this->m_near_average);
+        this->m_error_average += 
+            ECHOCANCELLER_ERLE_SMOOTHING * 
+            (error_power - this->m_error_average);
+    }
+
+    //
+    //  Residual echo suppression (Wiener-like gains of the windowed error 
+    //  spectrum, from smoothed powers of the error and of the residual echo 
+    //  expected from the leakage, more conservative during double-talk).
+    //
+    if (this->m_options.suppression > 0.0F && this->m_is_adapted) {
+        float over = this->m_is_double_talk ? 
+            ECHOCANCELLER_DOUBLE_TALK_OVER_SUBTRACTION :
+            ECHOCANCELLER_OVER_SUBTRACTION;
+        for (size_t b = 0U; b < bin_count; ++b) {
+            float e = error_window_re[b] * error_window_re[b] + 
+                      error_window_im[b] * error_window_im[b];
+            float y = echo_window_re[b] * echo_window_re[b] + 
+                      echo_window_im[b] * echo_window_im[b];
+            this->m_error_power[b] += 
+                ECHOCANCELLER_POWER_SMOOTHING * (e - this->m_error_power[b]);
+            this->m_residual_power[b] += 
+                ECHOCANCELLER_POWER_SMOOTHING * 
+                (this->m_leak * y - this->m_residual_power[b]);
+            float gain = 1.0F - over * this->m_residual_power[b] / 
+                                (this->m_error_power[b] + 
+                                 ECHOCANCELLER_EPSILON);
+            if (gain < this->m_min_gain) {
+                gain = this->m_min_gain;
+            }
+            error_window_re[b] *= gain;
+            error_window_im[b] *= gain;
+        }
+    }
+
+    //
+    //  Synthesis (overlap-add), the first half of the overlap buffer is 
+    //  complete.
+    //
+    this->m_fft->inverse(error_window_re, error_window_im, time);
+    for (size_t n = 0U; n < size; ++n) {
+        this->m_overlap[n] += time[n] * this->m_window[n];
+    }
+    memcpy(
+        this->m_queue + this->m_queue_count,
+        this->m_overlap,
+        block * sizeof(float)
+    );
+    this->m_queue_count += block;
+    memmove(this->m_overlap, this->m_overlap + block, block * sizeof(float));
+    memset(this->m_overlap + block, 0, block * sizeof(float));
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,284 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fft_p.h"
+
+#include <math.h>
+#include <xap/audioio/error.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double FFT_PI = 3.14159265358979323846;
+
+//
+//  Fft constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The size is not a power of 2 (or < 4).
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param size
+ *      The size (a power of 2).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+Fft::Fft(size_t size, xap::audioio::IAllocator *allocator) :
+    m_size(size),
+    m_half(size / 2U),
+    m_reverse(nullptr),
+    m_twiddles_re(nullptr),
+    m_twiddles_im(nullptr),
+    m_post_re(nullptr),
+    m_post_im(nullptr),
+    m_scratch_re(nullptr),
+    m_scratch_im(nullptr),
+    m_memory(nullptr)
+{
+    if (size < 4U || (size & (size - 1U)) != 0U) {
+        throw xap::audioio::Exception(
+            "The size is not a power of 2.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    //
+    //  One block: bit-reversal table, twiddles of each stage (half - 1), 
+    //  post-processing twiddles (half + 1) and scratch (half).
+    //
+    size_t half = this->m_half;
+    this->m_memory = xap::audioio::allocate_object(
+        allocator,
+        half * sizeof(uint32_t) + (2U * (half - 1U) + 2U * (half + 1U) + 
+                                   2U * half) * sizeof(float)
+    );
+    this->m_reverse = static_cast<uint32_t *>(this->m_memory);
+    this->m_twiddles_re = reinterpret_cast<float *>(this->m_reverse + half);
+    this->m_twiddles_im = this->m_twiddles_re + (half - 1U);
+    this->m_post_re = this->m_twiddles_im + (half - 1U);
+    this->m_post_im = this->m_post_re + (half + 1U);
+    this->m_scratch_re = this->m_post_im + (half + 1U);
+    this->m_scratch_im = this->m_scratch_re + half;
+
+    size_t bits = 0U;
+    while ((static_cast<size_t>(1U) << bits) < half) {
+        ++bits;
+    }
+    for (size_t i = 0U; i < half; ++i) {
+        size_t reversed = 0U;
+        for (size_t b = 0U; b < bits; ++b) {
+            reversed |= ((i >> b) & 1U) << (bits - 1U - b);
+        }
+        this->m_reverse[i] = static_cast<uint32_t>(reversed);
+    }
+
+    //
+    //  The twiddles of the stage of span 2h start at h - 1.
+    //
+    for (size_t h = 1U; h < half; h <<= 1U) {
+        for (size_t j = 0U; j < h; ++j) {
+            double angle = -FFT_PI * static_cast<double>(j) / 
+                           static_cast<double>(h);
+            this->m_twiddles_re[h - 1U + j] = static_cast<float>(cos(angle));
+            this->m_twiddles_im[h - 1U + j] = static_cast<float>(sin(angle));
+        }
+    }
+    for (size_t k = 0U; k <= half; ++k) {
+        double angle = -2.0 * FFT_PI * static_cast<double>(k) / 
+                       static_cast<double>(size);
+        this->m_post_re[k] = static_cast<float>(cos(angle));
+        this->m_post_im[k] = static_cast<float>(sin(angle));
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+Fft::~Fft() noexcept {
+    xap::audioio::free_object(this->m_memory);
+}
+
+//
+//  Fft public methods.
+//
+
+/**
+ *  Get the size.
+ * 
+ *  @return
+ *      The size.
+ */
+size_t Fft::get_size() const noexcept {
+    return this->m_size;
+}
+
+/**
+ *  Get the count of bins of spectra (size / 2 + 1).
+ * 
+ *  @return
+ *      The count of bins.
+ */
+size_t Fft::get_bin_count() const noexcept {
+    return this->m_half + 1U;
+}
+
+/**
+ *  Transform real samples to a spectrum.
+ * 
+ *  @param input
+ *      The samples ('size' samples).
+ *  @param re
+ *      The real parts of the spectrum (output, size / 2 + 1 bins).
+ *  @param im
+ *      The imaginary parts of the spectrum (output, size / 2 + 1 bins).
+ */
+void Fft::forward(const float *input, float *re, float *im) noexcept {
+    size_t half = this->m_half;
+    float *z_re = this->m_scratch_re;
+    float *z_im = this->m_scratch_im;
+
+    //
+    //  Pack the even and odd samples as one complex signal of half size.
+    //
+    for (size_t n = 0U; n < half; ++n) {
+        uint32_t r = this->m_reverse[n];
+        z_re[r] = input[2U * n];
+        z_im[r] = input[2U * n + 1U];
+    }
+    this->transform();
+
+    //
+    //  Split the spectra of the even and odd samples and combine them.
+    //
+    for (size_t k = 0U; k <= half; ++k) {
+        size_t a = (k == half ? 0U : k);
+        size_t b = (k == 0U ? 0U : half - k);
+        float even_re = 0.5F * (z_re[a] + z_re[b]);
+        float even_im = 0.5F * (z_im[a] - z_im[b]);
+        float odd_re = 0.5F * (z_im[a] + z_im[b]);
+        float odd_im = -0.5F * (z_re[a] - z_re[b]);
+        float w_re = this->m_post_re[k];
+        float w_im = this->m_post_im[k];
+        re[k] = even_re + w_re * odd_re - w_im * odd_im;
+        im[k] = even_im + w_re * odd_im + w_im * odd_re;
+    }
+}
+
+/**
+ *  Transform a spectrum (of a real signal) to real samples.
+ * 
+ *  @param re
+ *      The real parts of the spectrum (size / 2 + 1 bins).
+ *  @param im
+ *      The imaginary parts of the spectrum (size / 2 + 1 bins).
+ *  @param output
+ *      The samples (output, 'size' samples).
+ */
+void Fft::inverse(const float *re, const float *im, float *output) noexcept {
+    size_t half = this->m_half;
+    float *z_re = this->m_scratch_re;
+    float *z_im = this->m_scratch_im;
+
+    //
+    //  Rebuild the packed spectrum (conjugated, so that the forward 
+    //  transform computes the inverse one).
+    //
+    for (size_t k = 0U; k < half; ++k) {
+        float even_re = 0.5F * (re[k] + re[half - k]);
+        float even_im = 0.5F * (im[k] - im[half - k]);
+        float difference_re = 0.5F * (re[k] - re[half - k]);
+        float difference_im = 0.5F * (im[k] + im[half - k]);
+        float w_re = this->m_post_re[k];
+        float w_im = this->m_post_im[k];
+        float odd_re = difference_re * w_re + difference_im * w_im;
+        float odd_im = difference_im * w_re - difference_re * w_im;
+        uint32_t r = this->m_reverse[k];
+        z_re[r] = even_re - odd_im;
+        z_im[r] = -(even_im + odd_re);
+    }
+    this->transform();
+
+    float scale = 1.0F / static_cast<float>(half);
+    for (size_t n = 0U; n < half; ++n) {
+        output[2U * n] = z_re[n] * scale;
+        output[2U * n + 1U] = -z_im[n] * scale;
+    }
+}
+
+//
+//  Fft private methods.
+//
+
+/**
+ *  Complex FFT (of size / 2 points) of the scratch arrays in place (the 
+ *  input is in bit-reversed order).
+ */
+void Fft::transform() noexcept {
+    size_t count = this->m_half;
+    float *z_re = this->m_scratch_re;
+    float *z_im = this->m_scratch_im;
+    for (size_t h = 1U; h < count; h <<= 1U) {
+        const float *w_re = this->m_twiddles_re + (h - 1U);
+        const float *w_im = this->m_twiddles_im + (h - 1U);
+        for (size_t s = 0U; s < count; s += 2U * h) {
+            float *a_re = z_re + s;
+            float *a_im = z_im + s;
+            float *b_re = a_re + h;
+            float *b_im = a_im + h;
+            size_t j = 0U;
+#if defined(__SSE2__)
+            for (; j + 4U <= h; j += 4U) {
+                __m128 wr = _mm_loadu_ps(w_re + j);
+                __m128 wi = _mm_loadu_ps(w_im + j);
+                __m128 br = _mm_loadu_ps(b_re + j);
+                __m128 bi = _mm_loadu_ps(b_im + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+                __m128 ar = _mm_loadu_ps(a_re + j);
+                __m128 ai = _mm_loadu_ps(a_im + j);
+                _mm_storeu_ps(b_re + j, _mm_sub_ps(ar, tr));
+                _mm_storeu_ps(b_im + j, _mm_sub_ps(ai, ti));
+                _mm_storeu_ps(a_re + j, _mm_add_ps(ar, tr));
+                _mm_storeu_ps(a_im + j, _mm_add_ps(ai, ti));
+            }
+#endif
+            for (; j < h; ++j) {
+                float tr = w_re[j] * b_re[j] - w_im[j] * b_im[j];
+                float ti = w_re[j] * b_im[j] + w_im[j] * b_re[j];
+                b_re[j] = a_re[j] - tr;
+                b_im[j] = a_im[j] - ti;
+                a_re[j] += tr;
+                a_im[j] += ti;
+            }
+        }
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,142 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_FFT_P_H__
+#define XAP_AUDIOIO_FFT_P_H__
+
+//
+//  Imports.
+//
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Classes.
+//
+
+/**
+ *  Real FFT of a power-of-2 size.
+ * 
+ *  Spectra are stored in split form (real parts and imaginary parts in 
+ *  separate arrays) of size / 2 + 1 bins, the forward transform is not 
+ *  scaled and the inverse transform is scaled by 1 / size, so that 
+ *  inverse(forward(x)) == x. The object owns scratch memory: one object 
+ *  must not be used by multiple threads at the same time.
+ */
+class Fft {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The size is not a power of 2 (or < 4).
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param size
+     *      The size (a power of 2).
+     *  @param allocator
+     *      The allocator (nullptr for the default allocator).
+     */
+    Fft(size_t size, xap::audioio::IAllocator *allocator = nullptr);
+
+    /**
+     *  Destruct the object.
+     */
+    ~Fft() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Get the size.
+     * 
+     *  @return
+     *      The size.
+     */
+    size_t get_size() const noexcept;
+
+    /**
+     *  Get the count of bins of spectra (size / 2 + 1).
+     * 
+     *  @return
+     *      The count of bins.
+     */
+    size_t get_bin_count() const noexcept;
+
+    /**
+     *  Transform real samples to a spectrum.
+     * 
+     *  @param input
+     *      The samples ('size' samples).
+     *  @param re
+     *      The real parts of the spectrum (output, size / 2 + 1 bins).
+     *  @param im
+     *      The imaginary parts of the spectrum (output, size / 2 + 1 bins).
+     */
+    void forward(const float *input, float *re, float *im) noexcept;
+
+    /**
+     *  Transform a spectrum (of a real signal) to real samples.
+     * 
+     *  @param re
+     *      The real parts of the spectrum (size / 2 + 1 bins).
+     *  @param im
+     *      The imaginary parts of the spectrum (size / 2 + 1 bins).
+     *  @param output
+     *      The samples (output, 'size' samples).
+     */
+    void inverse(const float *re, const float *im, float *output) noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    Fft(const Fft &) = delete;
+    Fft &operator=(const Fft &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Complex FFT (of size / 2 points) of the scratch arrays in place (the 
+     *  input is in bit-reversed order).
+     */
+    void transform() noexcept;
+
+    //
+    //  Members.
+    //
+    size_t      m_size;
+    size_t      m_half;
+    uint32_t   *m_reverse;
+    float      *m_twiddles_re;
+    float      *m_twiddles_im;
+    float      *m_post_re;
+    float      *m_post_im;
+    float      *m_scratch_re;
+    float      *m_scratch_im;
+    void       *m_memory;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_FFT_P_H__
@@ -0,0 +1,1146 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fft_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <new>
+#include <string.h>
+#include <system_error>
+#include <xap/audioio/fingerprint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double FINGERPRINT_PI = 3.14159265358979323846;
+
+//  Lowest frequency of the bands (in Hz).
+const static double FINGERPRINT_MIN_FREQUENCY = 300.0;
+
+//  A peak must exceed the mean power of the bands by this ratio (~5dB).
+const static float FINGERPRINT_PEAK_RATIO = 3.0F;
+
+//  Decay of the peak thresholds in each hop, the margin a peak raises the 
+//  thresholds to (~3dB, so that a sustained tone is picked again after 
+//  ~17 hops) and the spread of a peak to the thresholds of its neighbor 
+//  bins (a Gaussian, 2 bins wide).
+const static float FINGERPRINT_THRESHOLD_DECAY = 0.96F;
+const static float FINGERPRINT_THRESHOLD_MARGIN = 2.0F;
+const static size_t FINGERPRINT_SPREAD_BINS = 4U;
+const static float FINGERPRINT_SPREAD[FINGERPRINT_SPREAD_BINS + 1U] = {
+    1.0F, 0.8825F, 0.6065F, 0.3247F, 0.1353F
+};
+
+//  A candidate peak is dropped if its bin rose by this ratio in the next 
+//  hop.
+const static float FINGERPRINT_RISE_RATIO = 1.2F;
+
+//  Minimum power of a peak (relative to the squared FFT size, about 
+//  -70dBFS for a sine wave).
+const static float FINGERPRINT_MIN_POWER = 1e-8F;
+
+//  Capacity of the peak ring of each stream (peaks of the last 
+//  FINGERPRINT_MAX_DELTA + 1 hops).
+const static size_t FINGERPRINT_PEAK_CAPACITY = 
+    (xap::audioio::FINGERPRINT_MAX_DELTA + 1U) * 
+    xap::audioio::FINGERPRINT_MAX_PEAKS;
+
+//  Count of vote slots of each stream (a power of 2) and the count of 
+//  slots probed for each vote.
+const static size_t FINGERPRINT_VOTE_SLOTS = 1024U;
+const static size_t FINGERPRINT_VOTE_PROBES = 8U;
+
+//  Maximum count of postings looked up for each fingerprint (the postings 
+//  of very common hashes carry little information).
+const static size_t FINGERPRINT_MAX_POSTINGS = 32U;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Indexed fingerprint (a node of a posting list).
+ */
+struct FingerprintNode_ {
+    uint32_t  hash;
+    uint32_t  track;
+    uint32_t  time;
+
+    //  The next node (its index + 1, 0 at the end of the list).
+    uint32_t  next;
+};
+
+/**
+ *  Shard of the index.
+ */
+struct FingerprintShard_ {
+    //  Write lock.
+    std::mutex                                  lock;
+
+    //  The first node of each bucket (its index + 1, 0 if empty).
+    std::atomic<uint32_t>                      *heads = nullptr;
+    size_t                                      bucket_mask = 0U;
+
+    //  The nodes (in the order they were added).
+    struct xap::audioio::FingerprintNode_      *nodes = nullptr;
+    std::atomic<size_t>                         size;
+
+    FingerprintShard_() noexcept : size(0U) {}
+};
+
+/**
+ *  Spectral peak.
+ */
+struct FingerprintPeak_ {
+    uint32_t  hop;
+    uint32_t  bin;
+    float     power;
+};
+
+/**
+ *  Votes for a track at a time offset.
+ */
+struct FingerprintVote_ {
+    uint32_t  track;
+    int32_t   offset;
+    uint32_t  last_hop;
+    uint16_t  count;
+    bool      is_used;
+    bool      is_reported;
+};
+
+/**
+ *  State of a stream.
+ */
+struct FingerprintStream_ {
+    //  The count of hops analyzed.
+    uint32_t                                hop;
+
+    //  The recent peaks (a ring, the newest at 'peak_head - 1').
+    size_t                                  peak_head;
+    size_t                                  peak_count;
+    struct xap::audioio::FingerprintPeak_   peaks[FINGERPRINT_PEAK_CAPACITY];
+
+    //  The candidate peaks of the last hop (confirmed in the next hop).
+    size_t                                  candidate_count;
+    struct xap::audioio::FingerprintPeak_
+        candidates[xap::audioio::FINGERPRINT_MAX_PEAKS];
+
+    //  The votes (open addressing).
+    struct xap::audioio::FingerprintVote_   votes[FINGERPRINT_VOTE_SLOTS];
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Mix the bits of a hash (the finalizer of MurmurHash3).
+ * 
+ *  @param value
+ *      The value.
+ *  @return
+ *      The mixed value.
+ */
+static inline uint32_t mix_hash(uint32_t value) noexcept {
+    value ^= value >> 16U;
+    value *= 0x85EBCA6BU;
+    value ^= value >> 13U;
+    value *= 0xC2B2AE35U;
+    value ^= value >> 16U;
+    return value;
+}
+
+/**
+ *  Build the audio format of internal buffers (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+//
+//  FingerprintIndex constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The count of shards or the capacity is invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+FingerprintIndex::FingerprintIndex(
+    const xap::audioio::FingerprintIndexOptions  &options,
+    xap::audioio::IAllocator                     *allocator
+) :
+    m_shards(nullptr),
+    m_shard_count(options.shard_count),
+    m_shard_capacity(0U)
+{
+    if (options.shard_count == 0U || 
+        options.shard_count > 4096U || 
+        options.capacity == 0U || 
+        options.capacity > (static_cast<size_t>(1U) << 31U)) {
+        throw xap::audioio::Exception(
+            "Invalid count of shards or capacity.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+    size_t capacity = 
+        (options.capacity + options.shard_count - 1U) / options.shard_count;
+    size_t bucket_count = 16U;
+    while (bucket_count < capacity) {
+        bucket_count <<= 1U;
+    }
+    this->m_shard_capacity = capacity;
+
+    this->m_shards = 
+        static_cast<struct xap::audioio::FingerprintShard_*>(
+            xap::audioio::allocate_object(
+                allocator,
+                options.shard_count * 
+                    sizeof(struct xap::audioio::FingerprintShard_)
+            )
+        );
+    for (size_t i = 0U; i < options.shard_count; ++i) {
+        new (&(this->m_shards[i])) struct xap::audioio::FingerprintShard_();
+    }
+    try {
+        for (size_t i = 0U; i < options.shard_count; ++i) {
+            struct xap::audioio::FingerprintShard_ *shard = 
+                &(this->m_shards[i]);
+            shard->heads = static_cast<std::atomic<uint32_t>*>(
+                xap::audioio::allocate_object(
+                    allocator,
+                    bucket_count * sizeof(std::atomic<uint32_t>)
+                )
+            );
+            for (size_t b = 0U; b < bucket_count; ++b) {
+                new (&(shard->heads[b])) std::atomic<uint32_t>(0U);
+            }
+            shard->bucket_mask = bucket_count - 1U;
+            shard->nodes = static_cast<struct xap::audioio::FingerprintNode_*>(
+                xap::audioio::allocate_object(
+                    allocator,
+                    capacity * sizeof(struct xap::audioio::FingerprintNode_)
+                )
+            );
+        }
+    } catch (...) {
+        for (size_t i = 0U; i < options.shard_count; ++i) {
+            struct xap::audioio::FingerprintShard_ *shard = 
+                &(this->m_shards[i]);
+            if (shard->nodes != nullptr) {
+                xap::audioio::free_object(shard->nodes);
+            }
+            if (shard->heads != nullptr) {
+                xap::audioio::free_object(shard->heads);
+            }
+            shard->~FingerprintShard_();
+        }
+        xap::audioio::free_object(this->m_shards);
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+FingerprintIndex::~FingerprintIndex() noexcept {
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        struct xap::audioio::FingerprintShard_ *shard = &(this->m_shards[i]);
+        if (shard->nodes != nullptr) {
+            xap::audioio::free_object(shard->nodes);
+        }
+        if (shard->heads != nullptr) {
+            xap::audioio::free_object(shard->heads);
+        }
+        shard->~FingerprintShard_();
+    }
+    xap::audioio::free_object(this->m_shards);
+}
+
+//
+//  FingerprintIndex public methods.
+//
+
+/**
+ *  Add the fingerprints of a track (thread-safe).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              A shard is full (the fingerprints added before remain).
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *  @param track
+ *      The track.
+ *  @param fingerprints
+ *      The fingerprints.
+ *  @param count
+ *      The count of fingerprints.
+ */
+void FingerprintIndex::add(
+    uint32_t                              track,
+    const xap::audioio::Fingerprint      *fingerprints,
+    size_t                                count
+) {
+    for (size_t i = 0U; i < count; ++i) {
+        const xap::audioio::Fingerprint &fingerprint = fingerprints[i];
+        uint32_t mixed = mix_hash(fingerprint.hash);
+        struct xap::audioio::FingerprintShard_ *shard = 
+            &(this->m_shards[mixed % this->m_shard_count]);
+        std::atomic<uint32_t> &head = 
+            shard->heads[(mixed / this->m_shard_count) & shard->bucket_mask];
+        try {
+            //
+            //  Lock.
+            //
+            std::lock_guard<std::mutex> lock(shard->lock);
+
+            size_t size = shard->size.load(std::memory_order_relaxed);
+            if (size == this->m_shard_capacity) {
+                throw xap::audioio::Exception(
+                    "The index is full.",
+                    xap::audioio::ERROR_INVALIDOPERATION
+                );
+            }
+
+            //  The node is complete before it is published.
+            struct xap::audioio::FingerprintNode_ &node = shard->nodes[size];
+            node.hash = fingerprint.hash;
+            node.track = track;
+            node.time = fingerprint.time;
+            node.next = head.load(std::memory_order_relaxed);
+            head.store(
+                static_cast<uint32_t>(size + 1U),
+                std::memory_order_release
+            );
+            shard->size.store(size + 1U, std::memory_order_relaxed);
+        } catch (std::system_error &error) {
+            throw xap::audioio::Exception(
+                error.what(),
+                xap::audioio::ERROR_SYSTEMCALL
+            );
+        }
+    }
+}
+
+/**
+ *  Look up the postings of a hash (thread-safe, lock-free, the most 
+ *  recently added first).
+ * 
+ *  @param hash
+ *      The hash.
+ *  @param postings
+ *      The postings (output).
+ *  @param max_count
+ *      The maximum count of postings.
+ *  @return
+ *      The count of postings.
+ */
+size_t FingerprintIndex::find(
+    uint32_t                              hash,
+    xap::audioio::FingerprintPosting     *postings,
+    size_t                                max_count
+) const noexcept {
+    uint32_t mixed = mix_hash(hash);
+    const struct xap::audioio::FingerprintShard_ *shard = 
+        &(this->m_shards[mixed % this->m_shard_count]);
+    uint32_t next = 
+        shard->heads[(mixed / this->m_shard_count) & shard->bucket_mask].load(
+            std::memory_order_acquire
+        );
+    size_t count = 0U;
+    while (next != 0U && count < max_count) {
+        const struct xap::audioio::FingerprintNode_ &node = 
+            shard->nodes[next - 1U];
+        if (node.hash == hash) {
+            postings[count].track = node.track;
+            postings[count].time = node.time;
+            ++count;
+        }
+        next = node.next;
+    }
+    return count;
+}
+
+/**
+ *  Get the count of indexed fingerprints.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t FingerprintIndex::get_size() const noexcept {
+    size_t size = 0U;
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        size += this->m_shards[i].size.load(std::memory_order_relaxed);
+    }
+    return size;
+}
+
+/**
+ *  Get the maximum count of indexed fingerprints.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t FingerprintIndex::get_capacity() const noexcept {
+    return this->m_shard_capacity * this->m_shard_count;
+}
+
+//
+//  FingerprintExtractor constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              stream_count == 0, the sample rate is 0 or the options are 
+ *              invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param stream_count
+ *      The count of streams.
+ *  @param sample_rate
+ *      The sample rate of all streams.
+ *  @param options
+ *      The options.
+ *  @param index
+ *      The index to match against (nullptr to extract only).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+FingerprintExtractor::FingerprintExtractor(
+    size_t                                                stream_count,
+    uint32_t                                              sample_rate,
+    const xap::audioio::FingerprintOptions               &options,
+    const std::shared_ptr<const xap::audioio::FingerprintIndex> &index,
+    xap::audioio::IAllocator                             *allocator
+) :
+    m_fingerprint_callback(),
+    m_match_callback(),
+    m_index(index),
+    m_stream_count(stream_count),
+    m_sample_rate(sample_rate),
+    m_options(options),
+    m_hop_offset(0U),
+    m_start(0),
+    m_is_started(false),
+    m_fft(nullptr),
+    m_streams(nullptr),
+    m_windows(),
+    m_thresholds(),
+    m_scratch(),
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{
+    size_t fft_size = options.fft_size;
+    if (stream_count == 0U || 
+        sample_rate == 0U || 
+        fft_size < 64U || 
+        fft_size > 2048U || 
+        (fft_size & (fft_size - 1U)) != 0U || 
+        options.hop_frames == 0U || 
+        options.hop_frames > fft_size || 
+        options.peaks_per_hop == 0U || 
+        options.peaks_per_hop > xap::audioio::FINGERPRINT_MAX_PEAKS || 
+        options.fan_out == 0U || 
+        options.fan_out > xap::audioio::FINGERPRINT_MAX_FAN_OUT || 
+        options.max_delta == 0U || 
+        options.max_delta > xap::audioio::FINGERPRINT_MAX_DELTA || 
+        options.min_matches == 0U || 
+        options.min_matches > UINT16_MAX || 
+        options.window_hops < options.max_delta || 
+        options.window_hops > INT32_MAX) {
+        throw xap::audioio::Exception(
+            "Invalid stream count, sample rate or options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  Band edges (logarithmically spaced from FINGERPRINT_MIN_FREQUENCY up 
+    //  to the bin below the Nyquist frequency, at least one bin each).
+    //
+    double low = std::max(
+        FINGERPRINT_MIN_FREQUENCY * static_cast<double>(fft_size) / 
+            static_cast<double>(sample_rate),
+        1.0
+    );
+    double high = static_cast<double>(fft_size / 2U);
+    size_t band_count = options.peaks_per_hop;
+    this->m_band_edges[0] = static_cast<size_t>(low + 0.5);
+    for (size_t k = 1U; k <= band_count; ++k) {
+        size_t edge = static_cast<size_t>(
+            low * pow(
+                high / low,
+                static_cast<double>(k) / static_cast<double>(band_count)
+            ) + 0.5
+        );
+        this->m_band_edges[k] = std::max(edge, this->m_band_edges[k - 1U] + 1U);
+    }
+    if (low >= high || this->m_band_edges[band_count] > fft_size / 2U) {
+        throw xap::audioio::Exception(
+            "Too many bands for the FFT size and sample rate.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  Input windows and peak thresholds of all streams, the Hann window 
+    //  and the spectrum.
+    //
+    size_t stride = (fft_size / 2U + 1U + 3U) & ~static_cast<size_t>(3U);
+    xap::audioio::AudioFormat state_format = build_state_format(sample_rate);
+    this->m_windows = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        stream_count * fft_size,
+        this->m_allocator
+    );
+    this->m_thresholds = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        stream_count * stride,
+        this->m_allocator
+    );
+    this->m_scratch = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        2U * fft_size + 3U * stride,
+        this->m_allocator
+    );
+    float *hann = this->m_scratch.get_samples<float>();
+    for (size_t i = 0U; i < fft_size; ++i) {
+        hann[i] = static_cast<float>(
+            0.5 - 0.5 * cos(
+                2.0 * FINGERPRINT_PI * static_cast<double>(i) / 
+                    static_cast<double>(fft_size)
+            )
+        );
+    }
+
+    this->m_fft = xap::audioio::new_object<xap::audioio::Fft>(
+        this->m_allocator,
+        fft_size,
+        this->m_allocator
+    );
+    try {
+        this->m_streams = 
+            static_cast<struct xap::audioio::FingerprintStream_*>(
+                xap::audioio::allocate_object(
+                    this->m_allocator,
+                    stream_count * 
+                        sizeof(struct xap::audioio::FingerprintStream_)
+                )
+            );
+    } catch (...) {
+        this->m_fft->~Fft();
+        xap::audioio::free_object(this->m_fft);
+        throw;
+    }
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+FingerprintExtractor::~FingerprintExtractor() noexcept {
+    xap::audioio::free_object(this->m_streams);
+    this->m_fft->~Fft();
+    xap::audioio::free_object(this->m_fft);
+}
+
+//
+//  FingerprintExtractor public methods.
+//
+
+/**
+ *  Extract fingerprints from audio data (as a recorder stage, the audio 
+ *  data is not changed).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The audio data is not 16-bit or 32-bit float, or its channel 
+ *              count or sample rate mismatched.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              A callback occurred error.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *  @param data
+ *      The audio data.
+ */
+void FingerprintExtractor::process(xap::audioio::AudioBuffer &data) {
+    xap::audioio::SampleFormat sample_format = data.get_sample_format();
+    if ((sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        static_cast<size_t>(data.get_channel_count()) != 
+            this->m_stream_count || 
+        data.get_sample_rate() != this->m_sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (!this->m_is_started) {
+        this->m_start = data.get_timestamp();
+        this->m_is_started = true;
+    }
+
+    size_t fft_size = this->m_options.fft_size;
+    size_t hop_frames = this->m_options.hop_frames;
+    size_t stream_count = this->m_stream_count;
+    size_t frame_count = data.get_frame_count();
+    float *windows = this->m_windows.get_samples<float>();
+    size_t offset = 0U;
+    while (offset < frame_count) {
+        //
+        //  Append to the newest hop of each stream.
+        //
+        size_t count = std::min(
+            hop_frames - this->m_hop_offset,
+            frame_count - offset
+        );
+        size_t tail = fft_size - hop_frames + this->m_hop_offset;
+        if (sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+            const int16_t *samples = 
+                data.get_samples<const int16_t>() + offset * stream_count;
+            for (size_t s = 0U; s < stream_count; ++s) {
+                float *window = windows + s * fft_size + tail;
+                for (size_t n = 0U; n < count; ++n) {
+                    window[n] = static_cast<float>(
+                        samples[n * stream_count + s]
+                    ) * (1.0F / 32768.0F);
+                }
+            }
+        } else {
+            const float *samples = 
+                data.get_samples<const float>() + offset * stream_count;
+            for (size_t s = 0U; s < stream_count; ++s) {
+                float *window = windows + s * fft_size + tail;
+                for (size_t n = 0U; n < count; ++n) {
+                    window[n] = samples[n * stream_count + s];
+                }
+            }
+        }
+        this->m_hop_offset += count;
+        offset += count;
+
+        //
+        //  Analyze at the end of the hop.
+        //
+        if (this->m_hop_offset == hop_frames) {
+            for (size_t s = 0U; s < stream_count; ++s) {
+                this->analyze(s);
+                float *window = windows + s * fft_size;
+                memmove(
+                    window,
+                    window + hop_frames,
+                    (fft_size - hop_frames) * sizeof(float)
+                );
+            }
+            this->m_hop_offset = 0U;
+        }
+    }
+}
+
+/**
+ *  Set fingerprint callback (called on the thread calling process(), with 
+ *  the fingerprints of one stream extracted in one hop).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if system (lock) calling occurred error.
+ *      (xap::audioio::ERROR_SYSTEMCALL)
+ *  @param callback
+ *      The callback (the stream, the fingerprints and their count).
+ */
+void FingerprintExtractor::set_fingerprint_callback(
+    std::function<
+        void(uint32_t, const xap::audioio::Fingerprint *, size_t)
+    > &callback
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_fingerprint_callback_lock);
+        this->m_fingerprint_callback = callback;
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Set match callback (called on the thread calling process()).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if system (lock) calling occurred error.
+ *      (xap::audioio::ERROR_SYSTEMCALL)
+ *  @param callback
+ *      The callback.
+ */
+void FingerprintExtractor::set_match_callback(
+    std::function<void(const xap::audioio::FingerprintMatch &)> &callback
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_match_callback_lock);
+        this->m_match_callback = callback;
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Reset the state of all streams (the next audio data starts at hop 0).
+ */
+void FingerprintExtractor::reset() noexcept {
+    this->m_hop_offset = 0U;
+    this->m_start = 0;
+    this->m_is_started = false;
+    memset(this->m_windows.get_pointer(), 0, this->m_windows.get_length());
+    memset(
+        this->m_thresholds.get_pointer(),
+        0,
+        this->m_thresholds.get_length()
+    );
+    memset(
+        this->m_streams,
+        0,
+        this->m_stream_count * sizeof(struct xap::audioio::FingerprintStream_)
+    );
+}
+
+/**
+ *  Get the count of streams.
+ * 
+ *  @return
+ *      The count.
+ */
+size_t FingerprintExtractor::get_stream_count() const noexcept {
+    return this->m_stream_count;
+}
+
+//
+//  FingerprintExtractor private methods.
+//
+
+/**
+ *  Analyze the newest FFT frame of a stream (at the end of a hop).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if a callback occurred error.
+ *  @param index
+ *      The index of the stream.
+ */
+void FingerprintExtractor::analyze(size_t index) {
+    size_t fft_size = this->m_options.fft_size;
+    size_t stride = (fft_size / 2U + 1U + 3U) & ~static_cast<size_t>(3U);
+    const float *window = 
+        this->m_windows.get_samples<const float>() + index * fft_size;
+    float *hann = this->m_scratch.get_samples<float>();
+    float *frame = hann + fft_size;
+    float *re = frame + fft_size;
+    float *im = re + stride;
+    float *power = im + stride;
+    struct xap::audioio::FingerprintStream_ &stream = this->m_streams[index];
+
+    //
+    //  Power spectrum of the windowed frame.
+    //
+    size_t i = 0U;
+#if defined(__SSE2__)
+    for (; i < fft_size; i += 4U) {
+        _mm_storeu_ps(
+            frame + i,
+            _mm_mul_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(hann + i))
+        );
+    }
+#endif
+    for (; i < fft_size; ++i) {
+        frame[i] = window[i] * hann[i];
+    }
+    this->m_fft->forward(frame, re, im);
+    float *thresholds = 
+        this->m_thresholds.get_samples<float>() + index * stride;
+    size_t low = this->m_band_edges[0];
+    size_t high = this->m_band_edges[this->m_options.peaks_per_hop];
+    size_t b = 0U;
+#if defined(__SSE2__)
+    __m128 decay = _mm_set1_ps(FINGERPRINT_THRESHOLD_DECAY);
+    for (; b + 4U <= high + 1U; b += 4U) {
+        __m128 r = _mm_loadu_ps(re + b);
+        __m128 m = _mm_loadu_ps(im + b);
+        _mm_storeu_ps(
+            power + b,
+            _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m))
+        );
+        _mm_storeu_ps(
+            thresholds + b,
+            _mm_mul_ps(_mm_loadu_ps(thresholds + b), decay)
+        );
+    }
+#endif
+    for (; b <= high; ++b) {
+        power[b] = re[b] * re[b] + im[b] * im[b];
+        thresholds[b] *= FINGERPRINT_THRESHOLD_DECAY;
+    }
+    float total = 0.0F;
+    for (b = low; b < high; ++b) {
+        total += power[b];
+    }
+    float minimum = std::max(
+        FINGERPRINT_PEAK_RATIO * total / static_cast<float>(high - low),
+        FINGERPRINT_MIN_POWER * static_cast<float>(fft_size * fft_size)
+    );
+
+    //
+    //  Confirm the candidate peaks of the previous hop that did not keep 
+    //  rising (the FFT frame only covers an onset after some hops), then 
+    //  raise the thresholds around them.
+    //
+    uint32_t hop = stream.hop;
+    struct xap::audioio::FingerprintPeak_
+        peaks[xap::audioio::FINGERPRINT_MAX_PEAKS];
+    size_t peak_count = 0U;
+    for (size_t p = 0U; p < stream.candidate_count; ++p) {
+        const struct xap::audioio::FingerprintPeak_ &candidate = 
+            stream.candidates[p];
+        size_t bin = candidate.bin;
+        float next = std::max(
+            power[bin],
+            std::max(power[bin - 1U], power[bin + 1U])
+        );
+        if (next > candidate.power * FINGERPRINT_RISE_RATIO) {
+            continue;
+        }
+        peaks[peak_count++] = candidate;
+        size_t first = bin > FINGERPRINT_SPREAD_BINS ? 
+                       bin - FINGERPRINT_SPREAD_BINS :
+                       0U;
+        size_t last = std::min(bin + FINGERPRINT_SPREAD_BINS, high);
+        for (b = first; b <= last; ++b) {
+            float spread = candidate.power * FINGERPRINT_THRESHOLD_MARGIN * 
+                           FINGERPRINT_SPREAD[b > bin ? b - bin : bin - b];
+            thresholds[b] = std::max(thresholds[b], spread);
+        }
+    }
+
+    //
+    //  The strongest local maximum of each band above the thresholds (the 
+    //  candidates of this hop).
+    //
+    stream.candidate_count = 0U;
+    for (size_t k = 0U; k < this->m_options.peaks_per_hop; ++k) {
+        size_t best = 0U;
+        for (b = this->m_band_edges[k]; b < this->m_band_edges[k + 1U]; ++b) {
+            if (power[b] > minimum && 
+                power[b] > thresholds[b] && 
+                power[b] >= power[b - 1U] && 
+                power[b] >= power[b + 1U] && 
+                (best == 0U || power[b] > power[best])) {
+                best = b;
+            }
+        }
+        if (best != 0U) {
+            struct xap::audioio::FingerprintPeak_ &candidate = 
+                stream.candidates[stream.candidate_count++];
+            candidate.hop = hop;
+            candidate.bin = static_cast<uint32_t>(best);
+            candidate.power = power[best];
+        }
+    }
+
+    //
+    //  Pair each peak with the most recent anchors (of earlier hops).
+    //
+    xap::audioio::Fingerprint fingerprints[
+        xap::audioio::FINGERPRINT_MAX_PEAKS * 
+        xap::audioio::FINGERPRINT_MAX_FAN_OUT
+    ];
+    size_t fingerprint_count = 0U;
+    for (size_t p = 0U; p < peak_count; ++p) {
+        size_t paired = 0U;
+        for (size_t k = 0U;
+             k < stream.peak_count && paired < this->m_options.fan_out;
+             ++k) {
+            const struct xap::audioio::FingerprintPeak_ &anchor = stream.peaks[
+                (stream.peak_head + FINGERPRINT_PEAK_CAPACITY - 1U - k) %
+                    FINGERPRINT_PEAK_CAPACITY
+            ];
+            uint32_t delta = peaks[p].hop - anchor.hop;
+            if (delta > this->m_options.max_delta) {
+                break;
+            }
+            xap::audioio::Fingerprint &fingerprint = 
+                fingerprints[fingerprint_count++];
+            fingerprint.hash = (anchor.bin << 16U) |
+                               (peaks[p].bin << 6U) |
+                               delta;
+            fingerprint.time = anchor.hop;
+            ++paired;
+        }
+    }
+    for (size_t p = 0U; p < peak_count; ++p) {
+        stream.peaks[stream.peak_head] = peaks[p];
+        stream.peak_head = (stream.peak_head + 1U) % FINGERPRINT_PEAK_CAPACITY;
+        stream.peak_count = 
+            std::min(stream.peak_count + 1U, FINGERPRINT_PEAK_CAPACITY);
+    }
+
+    if (fingerprint_count != 0U) {
+        this->emit_fingerprint_callback(
+            static_cast<uint32_t>(index),
+            fingerprints,
+            fingerprint_count
+        );
+        if (this->m_index) {
+            this->vote(index, fingerprints, fingerprint_count);
+        }
+    }
+    stream.hop = hop + 1U;
+}
+
+/**
+ *  Vote for the tracks matching the fingerprints of a stream.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the match callback occurred error.
+ *  @param index
+ *      The index of the stream.
+ *  @param fingerprints
+ *      The fingerprints.
+ *  @param count
+ *      The count of fingerprints.
+ */
+void FingerprintExtractor::vote(
+    size_t                                index,
+    const xap::audioio::Fingerprint      *fingerprints,
+    size_t                                count
+) {
+    struct xap::audioio::FingerprintStream_ &stream = this->m_streams[index];
+    uint32_t hop = stream.hop;
+    xap::audioio::FingerprintPosting postings[FINGERPRINT_MAX_POSTINGS];
+    for (size_t i = 0U; i < count; ++i) {
+        size_t posting_count = this->m_index->find(
+            fingerprints[i].hash,
+            postings,
+            FINGERPRINT_MAX_POSTINGS
+        );
+        for (size_t k = 0U; k < posting_count; ++k) {
+            uint32_t track = postings[k].track;
+            int32_t offset = 
+                static_cast<int32_t>(postings[k].time - fingerprints[i].time);
+
+            //
+            //  Find the slot of the track and offset, or take a free (or 
+            //  expired) slot, or the slot with the fewest votes.
+            //
+            uint32_t key = mix_hash(track * 0x9E3779B1U ^
+                                    static_cast<uint32_t>(offset));
+            struct xap::audioio::FingerprintVote_ *slot = nullptr;
+            struct xap::audioio::FingerprintVote_ *victim = nullptr;
+            bool is_victim_expired = false;
+            for (size_t p = 0U; p < FINGERPRINT_VOTE_PROBES; ++p) {
+                struct xap::audioio::FingerprintVote_ *candidate = 
+                    &(stream.votes[(key + p) & (FINGERPRINT_VOTE_SLOTS - 1U)]);
+                bool is_expired = 
+                    !candidate->is_used || 
+                    hop - candidate->last_hop > this->m_options.window_hops;
+                if (is_expired) {
+                    if (!is_victim_expired) {
+                        victim = candidate;
+                        is_victim_expired = true;
+                    }
+                } else if (candidate->track == track && 
+                           candidate->offset == offset) {
+                    slot = candidate;
+                    break;
+                } else if (!is_victim_expired && 
+                           (victim == nullptr || 
+                            candidate->count < victim->count)) {
+                    victim = candidate;
+                }
+            }
+            if (slot == nullptr) {
+                slot = victim;
+                slot->track = track;
+                slot->offset = offset;
+                slot->count = 0U;
+                slot->is_used = true;
+                slot->is_reported = false;
+            }
+            slot->last_hop = hop;
+            if (slot->count < UINT16_MAX) {
+                ++(slot->count);
+            }
+
+            //
+            //  Report once per track and offset.
+            //
+            if (!slot->is_reported && 
+                slot->count >= this->m_options.min_matches) {
+                slot->is_reported = true;
+
+                xap::audioio::FingerprintMatch match;
+                memset(&match, 0, sizeof(match));
+                match.timestamp = 
+                    this->m_start - 
+                    static_cast<int64_t>(offset) * 
+                        static_cast<int64_t>(this->m_options.hop_frames);
+                match.stream = static_cast<uint32_t>(index);
+                match.track = track;
+                match.count = slot->count;
+                this->emit_match_callback(match);
+            }
+        }
+    }
+}
+
+/**
+ *  Emit fingerprint callback.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param stream
+ *      The stream.
+ *  @param fingerprints
+ *      The fingerprints.
+ *  @param count
+ *      The count of fingerprints.
+ */
+void FingerprintExtractor::emit_fingerprint_callback(
+    uint32_t                              stream,
+    const xap::audioio::Fingerprint      *fingerprints,
+    size_t                                count
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_fingerprint_callback_lock);
+
+        if (this->m_fingerprint_callback) {
+            this->m_fingerprint_callback(stream, fingerprints, count);
+        }
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    } catch (std::exception &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_CALLBACK
+        );
+    }
+}
+
+/**
+ *  Emit match callback.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param match
+ *      The match.
+ */
+void FingerprintExtractor::emit_match_callback(
+    const xap::audioio::FingerprintMatch &match
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_match_callback_lock);
+
+        if (this->m_match_callback) {
+            this->m_match_callback(match);
+        }
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    } catch (std::exception &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_CALLBACK
+        );
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
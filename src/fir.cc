@@ -0,0 +1,82 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "fir_p.h"
+
+#include <math.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double FIR_PI = 3.14159265358979323846;
+
+//
+//  Public functions.
+//
+
+/**
+ *  Design a linear-phase low-pass FIR filter (Blackman-windowed sinc).
+ * 
+ *  @param taps
+ *      The taps (output).
+ *  @param tap_count
+ *      The count of taps.
+ *  @param cutoff
+ *      The cutoff frequency (relative to the sample rate, 0 < cutoff < 0.5).
+ *  @param gain
+ *      The DC gain.
+ */
+void fir_design_lowpass(
+    float  *taps, 
+    size_t  tap_count, 
+    double  cutoff, 
+    double  gain
+) noexcept {
+    if (tap_count == 0U) {
+        return;
+    }
+    if (tap_count == 1U) {
+        taps[0] = static_cast<float>(gain);
+        return;
+    }
+
+    double center = static_cast<double>(tap_count - 1U) / 2.0;
+    double span = static_cast<double>(tap_count - 1U);
+    double sum = 0.0;
+
+    //
+    //  Windowed sinc.
+    //
+    for (size_t n = 0U; n < tap_count; ++n) {
+        double m = static_cast<double>(n) - center;
+        double sinc = fabs(m) < 1e-9 ? 
+            2.0 * cutoff : 
+            sin(2.0 * FIR_PI * cutoff * m) / (FIR_PI * m);
+        double x = static_cast<double>(n) / span;
+        double window = 0.42 - 
+                        0.5 * cos(2.0 * FIR_PI * x) + 
+                        0.08 * cos(4.0 * FIR_PI * x);
+        taps[n] = static_cast<float>(sinc * window);
+        sum += sinc * window;
+    }
+
+    //
+    //  Normalize the DC gain.
+    //
+    double scale = gain / sum;
+    for (size_t n = 0U; n < tap_count; ++n) {
+        taps[n] = static_cast<float>(static_cast<double>(taps[n]) * scale);
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
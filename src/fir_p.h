@@ -0,0 +1,91 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_FIR_P_H__
+#define XAP_AUDIOIO_FIR_P_H__
+
+//
+//  Imports.
+//
+#include <stddef.h>
+#include <stdint.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Public functions.
+//
+
+/**
+ *  Design a linear-phase low-pass FIR filter (Blackman-windowed sinc).
+ * 
+ *  @param taps
+ *      The taps (output).
+ *  @param tap_count
+ *      The count of taps.
+ *  @param cutoff
+ *      The cutoff frequency (relative to the sample rate, 0 < cutoff < 0.5).
+ *  @param gain
+ *      The DC gain.
+ */
+void fir_design_lowpass(
+    float  *taps, 
+    size_t  tap_count, 
+    double  cutoff, 
+    double  gain
+) noexcept;
+
+/**
+ *  Compute the dot product of two vectors (the inner loop of FIR filters, 
+ *  written with independent accumulators so that it vectorizes).
+ * 
+ *  @param a
+ *      The first vector.
+ *  @param b
+ *      The second vector.
+ *  @param count
+ *      The count of elements.
+ *  @return
+ *      The dot product.
+ */
+inline float fir_dot(const float *a, const float *b, size_t count) noexcept {
+    float acc0 = 0.0F, acc1 = 0.0F, acc2 = 0.0F, acc3 = 0.0F;
+    size_t i = 0U;
+    for (; i + 4U <= count; i += 4U) {
+        acc0 += a[i] * b[i];
+        acc1 += a[i + 1U] * b[i + 1U];
+        acc2 += a[i + 2U] * b[i + 2U];
+        acc3 += a[i + 3U] * b[i + 3U];
+    }
+    for (; i < count; ++i) {
+        acc0 += a[i] * b[i];
+    }
+    return (acc0 + acc1) + (acc2 + acc3);
+}
+
+/**
+ *  Round and saturate a sample to 16-bit.
+ * 
+ *  @param value
+ *      The sample.
+ *  @return
+ *      The 16-bit sample.
+ */
+inline int16_t fir_saturate_int16(float value) noexcept {
+    if (value >= 32767.0F) {
+        return 32767;
+    }
+    if (value <= -32768.0F) {
+        return -32768;
+    }
+    return static_cast<int16_t>(value >= 0.0F ? value + 0.5F : value - 0.5F);
+}
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_FIR_P_H__
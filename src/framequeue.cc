@@ -0,0 +1,401 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <new>
+#include <string.h>
+#include <thread>
+#include <xap/audioio/error.h>
+#include <xap/audioio/framequeue.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of yields before a waiting producer starts to sleep.
+const static size_t FRAMEQUEUE_SPIN_COUNT = 64U;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Slot cell (one cache line each so that producers writing adjacent slots 
+ *  do not share lines).
+ */
+typedef struct FrameQueueCell_ {
+    std::atomic<size_t>  sequence;
+    size_t               frame_count;
+    uint8_t              __pad[48];
+} FrameQueueCell;
+
+//
+//  FrameQueue constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format is invalid, slot_frames == 0 or 
+ *              slot_count is not a power of 2.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param format
+ *      The audio format (must match the player).
+ *  @param slot_frames
+ *      The maximum count of frames of each slot.
+ *  @param slot_count
+ *      The count of slots (a power of 2).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+FrameQueue::FrameQueue(
+    const xap::audioio::AudioFormat &format,
+    size_t                           slot_frames,
+    size_t                           slot_count,
+    xap::audioio::IAllocator        *allocator
+) :
+    m_enqueue_position(0U),
+    m_rejected_count(0U),
+    m_dequeue_position(0U),
+    m_read_offset(0U),
+    m_format(format),
+    m_frame_size(xap::audioio::get_frame_size(format)),
+    m_slot_frames(slot_frames),
+    m_slot_count(slot_count),
+    m_slot_size(0U),
+    m_cells(nullptr),
+    m_storage(nullptr),
+    m_allocated_size(0U),
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{
+    if (this->m_frame_size == 0U || slot_frames == 0U || slot_count < 2U || 
+        (slot_count & (slot_count - 1U)) != 0U) {
+        throw xap::audioio::Exception(
+            "Invalid format, slot frames or slot count.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    this->m_slot_size = (slot_frames * this->m_frame_size + 
+                         xap::audioio::AUDIOBUFFER_ALIGNMENT - 1U) & 
+                        ~(xap::audioio::AUDIOBUFFER_ALIGNMENT - 1U);
+    size_t cells_size = sizeof(FrameQueueCell) * slot_count;
+    this->m_allocated_size = cells_size + this->m_slot_size * slot_count;
+
+    uint8_t *memory = static_cast<uint8_t *>(this->m_allocator->allocate(
+        this->m_allocated_size, 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT
+    ));
+    if (memory == nullptr) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+
+    this->m_cells = reinterpret_cast<FrameQueueCell *>(memory);
+    this->m_storage = memory + cells_size;
+    for (size_t i = 0U; i < slot_count; ++i) {
+        FrameQueueCell *cell = new (&(this->m_cells[i])) FrameQueueCell();
+        cell->sequence.store(i, std::memory_order_relaxed);
+        cell->frame_count = 0U;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+FrameQueue::~FrameQueue() noexcept {
+    for (size_t i = 0U; i < this->m_slot_count; ++i) {
+        this->m_cells[i].~FrameQueueCell();
+    }
+    this->m_allocator->deallocate(
+        this->m_cells, 
+        this->m_allocated_size, 
+        xap::audioio::AUDIOBUFFER_ALIGNMENT
+    );
+}
+
+//
+//  FrameQueue public methods.
+//
+
+/**
+ *  Push audio data without waiting (thread-safe, lock-free).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the frames can never fit in the queue 
+ *      (xap::audioio::ERROR_PARAMETER).
+ *  @param data
+ *      The audio data (interleaved, in the format of the queue).
+ *  @param frame_count
+ *      The count of frames.
+ *  @return
+ *      True if pushed, false if the queue is full (back-pressure).
+ */
+bool FrameQueue::try_push(const void *data, size_t frame_count) {
+    if (frame_count == 0U) {
+        return true;
+    }
+
+    size_t needed = (frame_count + this->m_slot_frames - 1U) / 
+                    this->m_slot_frames;
+    if (needed > this->m_slot_count) {
+        throw xap::audioio::Exception(
+            "The frames can never fit in the queue.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  Reserve 'needed' consecutive slots. The consumer releases slots in 
+    //  order, so the slots are all free if the last one is free.
+    //
+    size_t mask = this->m_slot_count - 1U;
+    size_t position = this->m_enqueue_position.load(std::memory_order_relaxed);
+    while (true) {
+        size_t last = position + needed - 1U;
+        size_t sequence = this->m_cells[last & mask].sequence.load(
+            std::memory_order_acquire
+        );
+        intptr_t diff = static_cast<intptr_t>(sequence) - 
+                        static_cast<intptr_t>(last);
+        if (diff == 0) {
+            if (this->m_enqueue_position.compare_exchange_weak(
+                position, 
+                position + needed, 
+                std::memory_order_relaxed
+            )) {
+                break;
+            }
+        } else if (diff < 0) {
+            this->m_rejected_count.fetch_add(1U, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = this->m_enqueue_position.load(
+                std::memory_order_relaxed
+            );
+        }
+    }
+
+    //
+    //  Fill and publish the slots.
+    //
+    const uint8_t *input = static_cast<const uint8_t *>(data);
+    for (size_t i = 0U; i < needed; ++i) {
+        size_t index = (position + i) & mask;
+        size_t count = frame_count - i * this->m_slot_frames;
+        if (count > this->m_slot_frames) {
+            count = this->m_slot_frames;
+        }
+
+        FrameQueueCell *cell = &(this->m_cells[index]);
+        memcpy(
+            this->m_storage + index * this->m_slot_size, 
+            input + i * this->m_slot_frames * this->m_frame_size, 
+            count * this->m_frame_size
+        );
+        cell->frame_count = count;
+        cell->sequence.store(position + i + 1U, std::memory_order_release);
+    }
+
+    return true;
+}
+
+/**
+ *  Push an audio buffer without waiting (thread-safe, lock-free).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The frames can never fit in the queue.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio buffer mismatched.
+ * 
+ *  @param data
+ *      The audio buffer.
+ *  @return
+ *      True if pushed, false if the queue is full (back-pressure).
+ */
+bool FrameQueue::try_push(const xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_format.sample_format || 
+        data.get_channel_count() != this->m_format.channel_count) {
+        throw xap::audioio::Exception(
+            "The format of the audio buffer mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    return this->try_push(data.get_pointer(), data.get_frame_count());
+}
+
+/**
+ *  Push audio data, waiting for free slots (thread-safe).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the frames can never fit in the queue 
+ *      (xap::audioio::ERROR_PARAMETER).
+ *  @param data
+ *      The audio data (interleaved, in the format of the queue).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param timeout
+ *      The timeout (in milliseconds).
+ *  @return
+ *      True if pushed, false if timed out.
+ */
+bool FrameQueue::push(const void *data, size_t frame_count, uint32_t timeout) {
+    std::chrono::steady_clock::time_point deadline = 
+        std::chrono::steady_clock::now() + 
+        std::chrono::milliseconds(timeout);
+
+    size_t attempts = 0U;
+    while (!this->try_push(data, frame_count)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        if (attempts < FRAMEQUEUE_SPIN_COUNT) {
+            ++attempts;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  Read audio data (the consumer, on the audio thread).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read.
+ */
+size_t FrameQueue::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_format.sample_format || 
+        output.get_channel_count() != this->m_format.channel_count) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    size_t mask = this->m_slot_count - 1U;
+    size_t requested = output.get_frame_count();
+    uint8_t *destination = output.get_pointer();
+
+    //
+    //  Drain consecutive published slots in one batch, the position is owned 
+    //  by the consumer so no read-modify-write is needed (it is atomic only 
+    //  so that get_pending_slot_count() can read it from other threads).
+    //
+    size_t position = this->m_dequeue_position.load(std::memory_order_relaxed);
+    size_t done = 0U;
+    while (done < requested) {
+        size_t index = position & mask;
+        FrameQueueCell *cell = &(this->m_cells[index]);
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (sequence != position + 1U) {
+            break;
+        }
+
+        size_t available = cell->frame_count - this->m_read_offset;
+        size_t count = requested - done;
+        if (count > available) {
+            count = available;
+        }
+        memcpy(
+            destination + done * this->m_frame_size, 
+            this->m_storage + index * this->m_slot_size + 
+                this->m_read_offset * this->m_frame_size, 
+            count * this->m_frame_size
+        );
+        done += count;
+        this->m_read_offset += count;
+
+        if (this->m_read_offset == cell->frame_count) {
+            cell->sequence.store(
+                position + this->m_slot_count, 
+                std::memory_order_release
+            );
+            ++position;
+            this->m_dequeue_position.store(
+                position, 
+                std::memory_order_relaxed
+            );
+            this->m_read_offset = 0U;
+        }
+    }
+
+    return done;
+}
+
+/**
+ *  Get the audio format.
+ * 
+ *  @return
+ *      The audio format.
+ */
+const xap::audioio::AudioFormat &FrameQueue::get_format() const noexcept {
+    return this->m_format;
+}
+
+/**
+ *  Get the capacity.
+ * 
+ *  @return
+ *      The maximum count of frames that can be queued.
+ */
+size_t FrameQueue::get_capacity() const noexcept {
+    return this->m_slot_frames * this->m_slot_count;
+}
+
+/**
+ *  Get the count of slots in use (approximately, thread-safe).
+ * 
+ *  @return
+ *      The count.
+ */
+size_t FrameQueue::get_pending_slot_count() const noexcept {
+    size_t enqueued = this->m_enqueue_position.load(std::memory_order_relaxed);
+    size_t dequeued = this->m_dequeue_position.load(std::memory_order_relaxed);
+    return enqueued >= dequeued ? enqueued - dequeued : 0U;
+}
+
+/**
+ *  Get the count of rejected pushes (the queue was full).
+ * 
+ *  @return
+ *      The count.
+ */
+uint64_t FrameQueue::get_rejected_count() const noexcept {
+    return this->m_rejected_count.load(std::memory_order_relaxed);
+}
+
+}  //  namespace audioio
+}  //  namespace xap
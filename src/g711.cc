@@ -0,0 +1,1155 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "fir_p.h"
+
+#include <string.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/g711.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of filter taps per polyphase branch of the decimation / 
+//  interpolation filters.
+const static size_t G711_TAPS_PER_PHASE = 48U;
+
+//  Cutoff frequency of the decimation / interpolation filters (in Hz).
+const static double G711_CUTOFF = 3500.0;
+
+//  Count of frames (at the higher sample rate for the encoder, at 8kHz for 
+//  the decoder) processed per pass.
+const static size_t G711_CHUNK_FRAMES = 256U;
+
+//  Count of pooled output audio buffers of the encoder.
+const static size_t G711_POOL_BLOCK_COUNT = 16U;
+
+//  Encoded silence.
+const static uint8_t G711_ULAW_SILENCE = 0xFFU;
+const static uint8_t G711_ALAW_SILENCE = 0xD5U;
+
+//
+//  Private functions (reference implementation).
+//
+
+/**
+ *  Encode one 16-bit linear sample to u-law (ITU-T G.711 reference 
+ *  algorithm, the 2 least significant bits are ignored).
+ * 
+ *  @param sample
+ *      The linear sample.
+ *  @return
+ *      The u-law sample.
+ */
+static uint8_t reference_ulaw_encode(int16_t sample) noexcept {
+    int value = static_cast<int>(sample) >> 2;
+    int mask = 0xFF;
+    if (value < 0) {
+        value = -value;
+        mask = 0x7F;
+    }
+    if (value > 8159) {
+        value = 8159;
+    }
+    value += 33;
+
+    int segment = 0;
+    while (segment < 8 && value > (0x40 << segment) - 1) {
+        ++segment;
+    }
+    if (segment >= 8) {
+        return static_cast<uint8_t>(0x7F ^ mask);
+    }
+    return static_cast<uint8_t>(
+        ((segment << 4) | ((value >> (segment + 1)) & 0x0F)) ^ mask
+    );
+}
+
+/**
+ *  Decode one u-law sample.
+ * 
+ *  @param code
+ *      The u-law sample.
+ *  @return
+ *      The 16-bit linear sample.
+ */
+static int16_t reference_ulaw_decode(uint8_t code) noexcept {
+    int value = ~static_cast<int>(code);
+    int magnitude = (((value & 0x0F) << 3) + 0x84) << ((value & 0x70) >> 4);
+    return static_cast<int16_t>(
+        (value & 0x80) != 0 ? 0x84 - magnitude : magnitude - 0x84
+    );
+}
+
+/**
+ *  Encode one 16-bit linear sample to A-law (ITU-T G.711 reference 
+ *  algorithm, the 3 least significant bits are ignored).
+ * 
+ *  @param sample
+ *      The linear sample.
+ *  @return
+ *      The A-law sample.
+ */
+static uint8_t reference_alaw_encode(int16_t sample) noexcept {
+    int value = static_cast<int>(sample) >> 3;
+    int mask = 0xD5;
+    if (value < 0) {
+        value = -value - 1;
+        mask = 0x55;
+    }
+
+    int segment = 0;
+    while (segment < 8 && value > (0x20 << segment) - 1) {
+        ++segment;
+    }
+    if (segment >= 8) {
+        return static_cast<uint8_t>(0x7F ^ mask);
+    }
+    int code = segment << 4;
+    if (segment < 2) {
+        code |= (value >> 1) & 0x0F;
+    } else {
+        code |= (value >> segment) & 0x0F;
+    }
+    return static_cast<uint8_t>(code ^ mask);
+}
+
+/**
+ *  Decode one A-law sample.
+ * 
+ *  @param code
+ *      The A-law sample.
+ *  @return
+ *      The 16-bit linear sample.
+ */
+static int16_t reference_alaw_decode(uint8_t code) noexcept {
+    int value = static_cast<int>(code) ^ 0x55;
+    int magnitude = (value & 0x0F) << 4;
+    int segment = (value & 0x70) >> 4;
+    switch (segment) {
+    case 0:
+        magnitude += 8;
+        break;
+    case 1:
+        magnitude += 0x108;
+        break;
+    default:
+        magnitude += 0x108;
+        magnitude <<= segment - 1;
+        break;
+    }
+    return static_cast<int16_t>((value & 0x80) != 0 ? magnitude : -magnitude);
+}
+
+//
+//  Private structures.
+//
+
+/**
+ *  Lookup tables (built once when the library is loaded).
+ */
+typedef struct G711Tables_ {
+    //  Indexed by the 14 most significant bits of the linear sample.
+    uint8_t  ulaw_encode[16384];
+
+    //  Indexed by the 13 most significant bits of the linear sample.
+    uint8_t  alaw_encode[8192];
+
+    int16_t  ulaw_decode[256];
+    int16_t  alaw_decode[256];
+
+    /**
+     *  Build the tables.
+     */
+    G711Tables_() noexcept {
+        for (size_t i = 0U; i < 16384U; ++i) {
+            this->ulaw_encode[i] = reference_ulaw_encode(
+                static_cast<int16_t>(static_cast<uint16_t>(i << 2))
+            );
+        }
+        for (size_t i = 0U; i < 8192U; ++i) {
+            this->alaw_encode[i] = reference_alaw_encode(
+                static_cast<int16_t>(static_cast<uint16_t>(i << 3))
+            );
+        }
+        for (size_t i = 0U; i < 256U; ++i) {
+            this->ulaw_decode[i] = reference_ulaw_decode(
+                static_cast<uint8_t>(i)
+            );
+            this->alaw_decode[i] = reference_alaw_decode(
+                static_cast<uint8_t>(i)
+            );
+        }
+    }
+} G711Tables;
+
+const static G711Tables G711_TABLES;
+
+//
+//  Private functions (vectorized paths).
+//
+
+#if defined(__SSE2__)
+
+/**
+ *  Encode 8 linear samples to u-law.
+ * 
+ *  The segment and the mantissa are read from the exponent and the leading 
+ *  mantissa bits of the biased magnitude converted to float.
+ * 
+ *  @param samples
+ *      The linear samples.
+ *  @return
+ *      The u-law samples (in the low byte of each 16-bit lane).
+ */
+static inline __m128i sse2_ulaw_encode(__m128i samples) noexcept {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i value = _mm_srai_epi16(samples, 2);
+    __m128i sign = _mm_srai_epi16(value, 15);
+
+    //  Biased magnitude (33 ... 8191, clipping at 8158 + 33 yields the same 
+    //  code as the reference clipping at 8159 + 33).
+    value = _mm_sub_epi16(_mm_xor_si128(value, sign), sign);
+    value = _mm_min_epi16(value, _mm_set1_epi16(8158));
+    value = _mm_add_epi16(value, _mm_set1_epi16(33));
+
+    //  (exponent << 4 | 4 leading mantissa bits) - ((127 + 5) << 4).
+    __m128i lo = _mm_castps_si128(
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero))
+    );
+    __m128i hi = _mm_castps_si128(
+        _mm_cvtepi32_ps(_mm_unpackhi_epi16(value, zero))
+    );
+    const __m128i bias = _mm_set1_epi32(2112);
+    lo = _mm_sub_epi32(_mm_srli_epi32(lo, 19), bias);
+    hi = _mm_sub_epi32(_mm_srli_epi32(hi, 19), bias);
+    __m128i code = _mm_packs_epi32(lo, hi);
+
+    //  Mask: 0xFF (positive) or 0x7F (negative).
+    __m128i mask = _mm_xor_si128(
+        _mm_set1_epi16(0xFF), 
+        _mm_and_si128(sign, _mm_set1_epi16(0x80))
+    );
+    return _mm_xor_si128(code, mask);
+}
+
+/**
+ *  Encode 8 linear samples to A-law.
+ * 
+ *  @param samples
+ *      The linear samples.
+ *  @return
+ *      The A-law samples (in the low byte of each 16-bit lane).
+ */
+static inline __m128i sse2_alaw_encode(__m128i samples) noexcept {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i value = _mm_srai_epi16(samples, 3);
+    __m128i sign = _mm_srai_epi16(value, 15);
+
+    //  Magnitude (0 ... 4095, one's complement of negative samples).
+    value = _mm_xor_si128(value, sign);
+
+    //  Segment 0 shares the step size of segment 1, so shift it into 
+    //  segment 1 and correct the segment afterwards.
+    __m128i small = _mm_cmplt_epi16(value, _mm_set1_epi16(32));
+    value = _mm_add_epi16(value, _mm_and_si128(small, _mm_set1_epi16(32)));
+
+    //  (exponent << 4 | 4 leading mantissa bits) - ((127 + 4) << 4).
+    __m128i lo = _mm_castps_si128(
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero))
+    );
+    __m128i hi = _mm_castps_si128(
+        _mm_cvtepi32_ps(_mm_unpackhi_epi16(value, zero))
+    );
+    const __m128i bias = _mm_set1_epi32(2096);
+    lo = _mm_sub_epi32(_mm_srli_epi32(lo, 19), bias);
+    hi = _mm_sub_epi32(_mm_srli_epi32(hi, 19), bias);
+    __m128i code = _mm_packs_epi32(lo, hi);
+    code = _mm_sub_epi16(code, _mm_and_si128(small, _mm_set1_epi16(16)));
+
+    //  Mask: 0xD5 (positive) or 0x55 (negative).
+    __m128i mask = _mm_xor_si128(
+        _mm_set1_epi16(0xD5), 
+        _mm_and_si128(sign, _mm_set1_epi16(0x80))
+    );
+    return _mm_xor_si128(code, mask);
+}
+
+#endif  //  #if defined(__SSE2__)
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the ratio of a sample rate to 8kHz.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The law or the format is invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format is not 16-bit or the sample rate is not a multiple 
+ *              of 8kHz.
+ * 
+ *  @param law
+ *      The law.
+ *  @param format
+ *      The linear audio format.
+ *  @return
+ *      The ratio.
+ */
+static size_t get_rate_factor(
+    xap::audioio::SampleFormat       law,
+    const xap::audioio::AudioFormat &format
+) {
+    if ((law != xap::audioio::SAMPLEFORMAT_ULAW && 
+         law != xap::audioio::SAMPLEFORMAT_ALAW) || 
+        format.channel_count == 0U) {
+        throw xap::audioio::Exception(
+            "Invalid law or audio format.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 || 
+        format.sample_rate == 0U || 
+        format.sample_rate % xap::audioio::G711_SAMPLE_RATE != 0U) {
+        throw xap::audioio::Exception(
+            "Only 16-bit audio data at multiples of 8kHz is supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    return format.sample_rate / xap::audioio::G711_SAMPLE_RATE;
+}
+
+/**
+ *  Get the block size of the output pool of the encoder.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the parameters are invalid (see get_rate_factor()).
+ *  @param law
+ *      The law.
+ *  @param format
+ *      The input audio format.
+ *  @param max_frames
+ *      The maximum count of input frames of each call.
+ *  @return
+ *      The block size (in bytes).
+ */
+static size_t get_encoder_block_size(
+    xap::audioio::SampleFormat       law,
+    const xap::audioio::AudioFormat &format,
+    size_t                           max_frames
+) {
+    size_t factor = get_rate_factor(law, format);
+    if (max_frames == 0U) {
+        throw xap::audioio::Exception(
+            "Invalid maximum count of frames.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    return (max_frames / factor + 1U) * 
+           static_cast<size_t>(format.channel_count);
+}
+
+/**
+ *  Build the audio format of filter state (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Encode 16-bit linear samples to G.711 u-law (the fastest path available, 
+ *  vectorized if supported).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The u-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_ulaw_encode(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept {
+    size_t i = 0U;
+#if defined(__SSE2__)
+    for (; i + 16U <= count; i += 16U) {
+        __m128i a = sse2_ulaw_encode(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(input + i)
+        ));
+        __m128i b = sse2_ulaw_encode(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(input + i + 8U)
+        ));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(output + i), 
+            _mm_packus_epi16(a, b)
+        );
+    }
+#endif
+    xap::audioio::g711_ulaw_encode_table(input + i, output + i, count - i);
+}
+
+/**
+ *  Encode 16-bit linear samples to G.711 u-law (lookup table path).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The u-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_ulaw_encode_table(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept {
+    const uint8_t *table = G711_TABLES.ulaw_encode;
+    for (size_t i = 0U; i < count; ++i) {
+        output[i] = table[static_cast<uint16_t>(input[i]) >> 2];
+    }
+}
+
+/**
+ *  Decode G.711 u-law samples to 16-bit linear samples.
+ * 
+ *  @param input
+ *      The u-law samples.
+ *  @param output
+ *      The linear samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_ulaw_decode(
+    const uint8_t *input, 
+    int16_t       *output, 
+    size_t         count
+) noexcept {
+    const int16_t *table = G711_TABLES.ulaw_decode;
+    for (size_t i = 0U; i < count; ++i) {
+        output[i] = table[input[i]];
+    }
+}
+
+/**
+ *  Encode 16-bit linear samples to G.711 A-law (the fastest path available, 
+ *  vectorized if supported).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The A-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_alaw_encode(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept {
+    size_t i = 0U;
+#if defined(__SSE2__)
+    for (; i + 16U <= count; i += 16U) {
+        __m128i a = sse2_alaw_encode(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(input + i)
+        ));
+        __m128i b = sse2_alaw_encode(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(input + i + 8U)
+        ));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(output + i), 
+            _mm_packus_epi16(a, b)
+        );
+    }
+#endif
+    xap::audioio::g711_alaw_encode_table(input + i, output + i, count - i);
+}
+
+/**
+ *  Encode 16-bit linear samples to G.711 A-law (lookup table path).
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The A-law samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_alaw_encode_table(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept {
+    const uint8_t *table = G711_TABLES.alaw_encode;
+    for (size_t i = 0U; i < count; ++i) {
+        output[i] = table[static_cast<uint16_t>(input[i]) >> 3];
+    }
+}
+
+/**
+ *  Decode G.711 A-law samples to 16-bit linear samples.
+ * 
+ *  @param input
+ *      The A-law samples.
+ *  @param output
+ *      The linear samples.
+ *  @param count
+ *      The count of samples.
+ */
+void g711_alaw_decode(
+    const uint8_t *input, 
+    int16_t       *output, 
+    size_t         count
+) noexcept {
+    const int16_t *table = G711_TABLES.alaw_decode;
+    for (size_t i = 0U; i < count; ++i) {
+        output[i] = table[input[i]];
+    }
+}
+
+//
+//  G711Encoder constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The law is not SAMPLEFORMAT_ULAW / SAMPLEFORMAT_ALAW, 
+ *              max_frames == 0 or the input format is invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The input format is not 16-bit or the input sample rate 
+ *              is not a multiple of 8kHz.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param law
+ *      The law (xap::audioio::SAMPLEFORMAT_ULAW or 
+ *      xap::audioio::SAMPLEFORMAT_ALAW).
+ *  @param input_format
+ *      The input audio format (the format of the recorder).
+ *  @param max_frames
+ *      The maximum count of input frames of each call (the frames per 
+ *      buffer of the recorder, or RECORDER_DEFAULT_BLOCK_FRAMES).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+G711Encoder::G711Encoder(
+    xap::audioio::SampleFormat       law,
+    const xap::audioio::AudioFormat &input_format,
+    size_t                           max_frames,
+    xap::audioio::IAllocator        *allocator
+) :
+    m_law(law),
+    m_input_format(input_format),
+    m_output_format(),
+    m_max_frames(max_frames),
+    m_factor(1U),
+    m_tap_count(0U),
+    m_phase(0U),
+    m_line_length(0U),
+    m_taps(),
+    m_lines(),
+    m_scratch(),
+    m_pool(
+        get_encoder_block_size(law, input_format, max_frames), 
+        G711_POOL_BLOCK_COUNT, 
+        allocator
+    )
+{
+    this->m_factor = get_rate_factor(law, input_format);
+    this->m_output_format.sample_format = law;
+    this->m_output_format.channel_count = input_format.channel_count;
+    this->m_output_format.sample_rate = xap::audioio::G711_SAMPLE_RATE;
+
+    if (this->m_factor > 1U) {
+        size_t channel_count = static_cast<size_t>(input_format.channel_count);
+
+        //
+        //  Anti-aliasing filter.
+        //
+        this->m_tap_count = G711_TAPS_PER_PHASE * this->m_factor;
+        this->m_taps = xap::audioio::AudioBuffer::allocate(
+            build_state_format(input_format.sample_rate), 
+            this->m_tap_count, 
+            allocator
+        );
+        xap::audioio::fir_design_lowpass(
+            this->m_taps.get_samples<float>(),
+            this->m_tap_count,
+            G711_CUTOFF / static_cast<double>(input_format.sample_rate),
+            1.0
+        );
+
+        //
+        //  Delay lines (one per channel) and quantized output of one pass.
+        //
+        this->m_line_length = this->m_tap_count - 1U + G711_CHUNK_FRAMES;
+        this->m_lines = xap::audioio::AudioBuffer::allocate(
+            build_state_format(input_format.sample_rate), 
+            this->m_line_length * channel_count, 
+            allocator
+        );
+        xap::audioio::AudioFormat scratch_format = input_format;
+        this->m_scratch = xap::audioio::AudioBuffer::allocate(
+            scratch_format, 
+            G711_CHUNK_FRAMES / this->m_factor + 1U, 
+            allocator
+        );
+    }
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+G711Encoder::~G711Encoder() noexcept {}
+
+//
+//  G711Encoder public methods.
+//
+
+/**
+ *  Encode audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format of the audio data mismatched.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The audio data has more than 'max_frames' frames.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              No pooled audio buffer is available.
+ * 
+ *  @param data
+ *      The audio data (replaced by the encoded audio data).
+ */
+void G711Encoder::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_input_format.sample_format || 
+        data.get_channel_count() != this->m_input_format.channel_count || 
+        data.get_sample_rate() != this->m_input_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t frame_count = data.get_frame_count();
+    if (frame_count > this->m_max_frames) {
+        throw xap::audioio::Exception(
+            "Too many frames.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    size_t channel_count = 
+        static_cast<size_t>(this->m_input_format.channel_count);
+    const int16_t *input = data.get_samples<int16_t>();
+
+    //
+    //  8kHz: encode only.
+    //
+    if (this->m_factor == 1U) {
+        xap::audioio::AudioBuffer output = 
+            xap::audioio::AudioBuffer::allocate(
+                this->m_pool, 
+                this->m_output_format, 
+                frame_count
+            );
+        this->encode(
+            input, 
+            output.get_samples<uint8_t>(), 
+            frame_count * channel_count
+        );
+        output.set_timestamp(data.get_timestamp());
+        data = output;
+        return;
+    }
+
+    //
+    //  Decimate (the filter is evaluated at output positions only), quantize 
+    //  and encode, one pass at a time so that the intermediate samples stay 
+    //  in the cache.
+    //
+    size_t first = this->m_phase;
+    size_t output_count = first < frame_count ? 
+        (frame_count - 1U - first) / this->m_factor + 1U : 
+        0U;
+    xap::audioio::AudioBuffer output = xap::audioio::AudioBuffer::allocate(
+        this->m_pool, 
+        this->m_output_format, 
+        output_count
+    );
+    output.set_timestamp(
+        (data.get_timestamp() + static_cast<int64_t>(first)) / 
+            static_cast<int64_t>(this->m_factor)
+    );
+
+    uint8_t *encoded = output.get_samples<uint8_t>();
+    const float *taps = this->m_taps.get_samples<float>();
+    float *lines = this->m_lines.get_samples<float>();
+    int16_t *scratch = this->m_scratch.get_samples<int16_t>();
+    size_t history = this->m_tap_count - 1U;
+
+    size_t offset = 0U;
+    while (offset < frame_count) {
+        size_t count = frame_count - offset;
+        if (count > G711_CHUNK_FRAMES) {
+            count = G711_CHUNK_FRAMES;
+        }
+
+        //
+        //  Deinterleave.
+        //
+        for (size_t c = 0U; c < channel_count; ++c) {
+            float *line = lines + c * this->m_line_length + history;
+            const int16_t *source = input + offset * channel_count + c;
+            for (size_t i = 0U; i < count; ++i) {
+                line[i] = static_cast<float>(source[i * channel_count]);
+            }
+        }
+
+        //
+        //  Filter and decimate.
+        //
+        size_t produced = 0U;
+        size_t position = this->m_phase;
+        for (; position < count; position += this->m_factor) {
+            for (size_t c = 0U; c < channel_count; ++c) {
+                scratch[produced * channel_count + c] = 
+                    xap::audioio::fir_saturate_int16(xap::audioio::fir_dot(
+                        taps, 
+                        lines + c * this->m_line_length + position, 
+                        this->m_tap_count
+                    ));
+            }
+            ++produced;
+        }
+        this->m_phase = position - count;
+
+        //
+        //  Encode.
+        //
+        this->encode(scratch, encoded, produced * channel_count);
+        encoded += produced * channel_count;
+
+        //
+        //  Keep the history.
+        //
+        for (size_t c = 0U; c < channel_count; ++c) {
+            float *line = lines + c * this->m_line_length;
+            memmove(line, line + count, history * sizeof(float));
+        }
+
+        offset += count;
+    }
+
+    data = output;
+}
+
+/**
+ *  Reset the filter state.
+ */
+void G711Encoder::reset() noexcept {
+    this->m_phase = 0U;
+    if (!this->m_lines.is_empty()) {
+        memset(this->m_lines.get_pointer(), 0, this->m_lines.get_length());
+    }
+}
+
+/**
+ *  Get the output audio format.
+ * 
+ *  @return
+ *      The audio format.
+ */
+const xap::audioio::AudioFormat &G711Encoder::get_output_format() 
+    const noexcept {
+    return this->m_output_format;
+}
+
+//
+//  G711Encoder private methods.
+//
+
+/**
+ *  Encode linear samples with the law of the stage.
+ * 
+ *  @param input
+ *      The linear samples.
+ *  @param output
+ *      The encoded samples.
+ *  @param count
+ *      The count of samples.
+ */
+void G711Encoder::encode(
+    const int16_t *input, 
+    uint8_t       *output, 
+    size_t         count
+) noexcept {
+    if (this->m_law == xap::audioio::SAMPLEFORMAT_ULAW) {
+        xap::audioio::g711_ulaw_encode(input, output, count);
+    } else {
+        xap::audioio::g711_alaw_encode(input, output, count);
+    }
+}
+
+//
+//  G711Decoder constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The upstream source is nullptr, the law is not 
+ *              SAMPLEFORMAT_ULAW / SAMPLEFORMAT_ALAW or the output format 
+ *              is invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The output format is not 16-bit or the output sample 
+ *              rate is not a multiple of 8kHz.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param upstream
+ *      The upstream source (G.711 audio data, 8kHz, with the channel 
+ *      count of the output format).
+ *  @param law
+ *      The law (xap::audioio::SAMPLEFORMAT_ULAW or 
+ *      xap::audioio::SAMPLEFORMAT_ALAW).
+ *  @param output_format
+ *      The output audio format (the format of the player).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+G711Decoder::G711Decoder(
+    const std::shared_ptr<xap::audioio::ISource> &upstream,
+    xap::audioio::SampleFormat                    law,
+    const xap::audioio::AudioFormat              &output_format,
+    xap::audioio::IAllocator                     *allocator
+) :
+    m_upstream(upstream),
+    m_law(law),
+    m_input_format(),
+    m_output_format(output_format),
+    m_factor(get_rate_factor(law, output_format)),
+    m_tap_count(0U),
+    m_line_length(0U),
+    m_taps(),
+    m_lines(),
+    m_input(),
+    m_scratch(),
+    m_pending(),
+    m_pending_offset(0U),
+    m_pending_count(0U)
+{
+    if (!upstream) {
+        throw xap::audioio::Exception(
+            "The upstream source is null.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    size_t channel_count = static_cast<size_t>(output_format.channel_count);
+    this->m_input_format.sample_format = law;
+    this->m_input_format.channel_count = output_format.channel_count;
+    this->m_input_format.sample_rate = xap::audioio::G711_SAMPLE_RATE;
+
+    this->m_input = xap::audioio::AudioBuffer::allocate(
+        this->m_input_format, 
+        G711_CHUNK_FRAMES, 
+        allocator
+    );
+    this->m_pending = xap::audioio::AudioBuffer::allocate(
+        output_format, 
+        G711_CHUNK_FRAMES * this->m_factor, 
+        allocator
+    );
+
+    if (this->m_factor > 1U) {
+        //
+        //  Interpolation filter (stored per polyphase branch, reversed, with 
+        //  a gain of 'factor' to compensate the zero stuffing).
+        //
+        this->m_tap_count = G711_TAPS_PER_PHASE;
+        size_t total = this->m_tap_count * this->m_factor;
+        xap::audioio::AudioBuffer prototype = 
+            xap::audioio::AudioBuffer::allocate(
+                build_state_format(output_format.sample_rate), 
+                total, 
+                allocator
+            );
+        xap::audioio::fir_design_lowpass(
+            prototype.get_samples<float>(),
+            total,
+            G711_CUTOFF / static_cast<double>(output_format.sample_rate),
+            static_cast<double>(this->m_factor)
+        );
+        this->m_taps = xap::audioio::AudioBuffer::allocate(
+            build_state_format(output_format.sample_rate), 
+            total, 
+            allocator
+        );
+        const float *h = prototype.get_samples<float>();
+        float *taps = this->m_taps.get_samples<float>();
+        for (size_t p = 0U; p < this->m_factor; ++p) {
+            for (size_t k = 0U; k < this->m_tap_count; ++k) {
+                taps[p * this->m_tap_count + k] = 
+                    h[p + (this->m_tap_count - 1U - k) * this->m_factor];
+            }
+        }
+
+        //
+        //  Delay lines (one per channel) and decoded input of one pass.
+        //
+        this->m_line_length = this->m_tap_count - 1U + G711_CHUNK_FRAMES;
+        this->m_lines = xap::audioio::AudioBuffer::allocate(
+            build_state_format(xap::audioio::G711_SAMPLE_RATE), 
+            this->m_line_length * channel_count, 
+            allocator
+        );
+        xap::audioio::AudioFormat scratch_format = output_format;
+        scratch_format.sample_rate = xap::audioio::G711_SAMPLE_RATE;
+        this->m_scratch = xap::audioio::AudioBuffer::allocate(
+            scratch_format, 
+            G711_CHUNK_FRAMES, 
+            allocator
+        );
+    }
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+G711Decoder::~G711Decoder() noexcept {}
+
+//
+//  G711Decoder public methods.
+//
+
+/**
+ *  Read audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED) or the upstream source failed.
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (fewer than requested if the upstream 
+ *      source ran out of audio data).
+ */
+size_t G711Decoder::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_output_format.sample_format || 
+        output.get_channel_count() != this->m_output_format.channel_count || 
+        output.get_sample_rate() != this->m_output_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    size_t frame_count = output.get_frame_count();
+    size_t frame_size = xap::audioio::get_frame_size(this->m_output_format);
+    uint8_t *destination = static_cast<uint8_t *>(output.get_pointer());
+    const uint8_t *pending = 
+        static_cast<const uint8_t *>(this->m_pending.get_pointer());
+    uint8_t silence = this->m_law == xap::audioio::SAMPLEFORMAT_ULAW ? 
+        G711_ULAW_SILENCE : 
+        G711_ALAW_SILENCE;
+
+    size_t delivered = 0U;
+    size_t valid = 0U;
+    while (delivered < frame_count) {
+        bool is_underrun = false;
+        size_t pending_valid = this->m_pending_count;
+
+        //
+        //  Read and decode the next pass.
+        //
+        if (this->m_pending_count == 0U) {
+            size_t needed = (frame_count - delivered + this->m_factor - 1U) / 
+                            this->m_factor;
+            if (needed > G711_CHUNK_FRAMES) {
+                needed = G711_CHUNK_FRAMES;
+            }
+            xap::audioio::AudioBuffer input = this->m_input.slice(0U, needed);
+            memset(input.get_pointer(), silence, input.get_length());
+            size_t read = this->m_upstream->read(input);
+            if (read > needed) {
+                read = needed;
+            }
+
+            this->decode(
+                static_cast<const uint8_t *>(input.get_pointer()), 
+                needed, 
+                this->m_pending.get_samples<int16_t>()
+            );
+            this->m_pending_offset = 0U;
+            this->m_pending_count = needed * this->m_factor;
+            pending_valid = read * this->m_factor;
+            is_underrun = (read < needed);
+        }
+
+        //
+        //  Deliver.
+        //
+        size_t count = this->m_pending_count;
+        if (count > frame_count - delivered) {
+            count = frame_count - delivered;
+        }
+        memcpy(
+            destination + delivered * frame_size, 
+            pending + this->m_pending_offset * frame_size, 
+            count * frame_size
+        );
+        if (valid == delivered) {
+            valid += pending_valid < count ? pending_valid : count;
+        }
+        delivered += count;
+        this->m_pending_offset += count;
+        this->m_pending_count -= count;
+
+        //
+        //  The upstream source ran out of audio data, the remaining frames of 
+        //  this pass are silence.
+        //
+        if (is_underrun) {
+            this->m_pending_count = 0U;
+            break;
+        }
+    }
+
+    return valid;
+}
+
+/**
+ *  Reset the filter state.
+ */
+void G711Decoder::reset() noexcept {
+    this->m_pending_offset = 0U;
+    this->m_pending_count = 0U;
+    if (!this->m_lines.is_empty()) {
+        memset(this->m_lines.get_pointer(), 0, this->m_lines.get_length());
+    }
+}
+
+//
+//  G711Decoder private methods.
+//
+
+/**
+ *  Decode (and interpolate) audio data read from the upstream source.
+ * 
+ *  @param input
+ *      The encoded audio data.
+ *  @param frame_count
+ *      The count of input frames.
+ *  @param output
+ *      The output (frame_count * factor frames).
+ */
+void G711Decoder::decode(
+    const uint8_t *input, 
+    size_t         frame_count, 
+    int16_t       *output
+) noexcept {
+    size_t channel_count = 
+        static_cast<size_t>(this->m_output_format.channel_count);
+    size_t sample_count = frame_count * channel_count;
+
+    //
+    //  8kHz: decode only.
+    //
+    int16_t *linear = this->m_factor == 1U ? 
+        output : 
+        this->m_scratch.get_samples<int16_t>();
+    if (this->m_law == xap::audioio::SAMPLEFORMAT_ULAW) {
+        xap::audioio::g711_ulaw_decode(input, linear, sample_count);
+    } else {
+        xap::audioio::g711_alaw_decode(input, linear, sample_count);
+    }
+    if (this->m_factor == 1U) {
+        return;
+    }
+
+    //
+    //  Interpolate (one polyphase branch per output phase).
+    //
+    const float *taps = this->m_taps.get_samples<float>();
+    float *lines = this->m_lines.get_samples<float>();
+    size_t history = this->m_tap_count - 1U;
+    for (size_t c = 0U; c < channel_count; ++c) {
+        float *line = lines + c * this->m_line_length + history;
+        for (size_t i = 0U; i < frame_count; ++i) {
+            line[i] = static_cast<float>(linear[i * channel_count + c]);
+        }
+    }
+    for (size_t i = 0U; i < frame_count; ++i) {
+        for (size_t p = 0U; p < this->m_factor; ++p) {
+            int16_t *frame = output + (i * this->m_factor + p) * channel_count;
+            const float *branch = taps + p * this->m_tap_count;
+            for (size_t c = 0U; c < channel_count; ++c) {
+                frame[c] = xap::audioio::fir_saturate_int16(
+                    xap::audioio::fir_dot(
+                        branch, 
+                        lines + c * this->m_line_length + i, 
+                        this->m_tap_count
+                    )
+                );
+            }
+        }
+    }
+    for (size_t c = 0U; c < channel_count; ++c) {
+        float *line = lines + c * this->m_line_length;
+        memmove(line, line + frame_count, history * sizeof(float));
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
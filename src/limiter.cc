@@ -0,0 +1,783 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "fir_p.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/limiter.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of frames processed per pass.
+const static size_t LIMITER_BLOCK_FRAMES = 256U;
+
+//  Count of frames by which the detector lags behind the input (the true 
+//  peak between two samples is interpolated from 4 samples).
+const static size_t LIMITER_DETECTOR_DELAY = 2U;
+
+//  Count of history frames of the detector.
+const static size_t LIMITER_HISTORY_FRAMES = 3U;
+
+//  Samples at or above this level reached full scale (of 16-bit).
+const static float LIMITER_CLIP_LEVEL = 32767.0F / 32768.0F;
+
+//  The interpolated peaks between samples are at most this ratio of the 
+//  sample peak (the sum of the magnitudes of the interpolation weights).
+const static float LIMITER_TRUE_PEAK_RATIO = 1.25F;
+
+//  Maximum look-ahead time (in milliseconds).
+const static float LIMITER_MAX_LOOKAHEAD = 100.0F;
+
+//  Cubic (Catmull-Rom) interpolation weights of the points at 1/4, 1/2 and 
+//  3/4 between the two middle samples of 4.
+const static float LIMITER_INTERPOLATION[3][4] = {
+    {-0.0703125F, 0.8671875F, 0.2265625F, -0.0234375F},
+    {-0.0625F, 0.5625F, 0.5625F, -0.0625F},
+    {-0.0234375F, 0.2265625F, 0.8671875F, -0.0703125F}
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Scan 32-bit float samples (the peak and the count of clips).
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param count
+ *      The count of samples.
+ *  @param peak
+ *      The peak magnitude (output).
+ *  @return
+ *      The count of samples which reached full scale.
+ */
+static uint64_t scan(
+    const float  *samples,
+    size_t        count,
+    float        &peak
+) noexcept {
+    uint64_t clip_count = 0U;
+    float maximum = 0.0F;
+    size_t i = 0U;
+#if defined(__SSE2__)
+    const __m128 magnitude_mask = 
+        _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 clip_level = _mm_set1_ps(LIMITER_CLIP_LEVEL);
+    __m128 maximums = _mm_setzero_ps();
+    for (; i + 4U <= count; i += 4U) {
+        __m128 magnitudes = 
+            _mm_and_ps(_mm_loadu_ps(samples + i), magnitude_mask);
+        maximums = _mm_max_ps(maximums, magnitudes);
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(magnitudes, clip_level));
+        if (mask != 0) {
+            clip_count += static_cast<uint64_t>(
+                (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + 
+                ((mask >> 3) & 1)
+            );
+        }
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, maximums);
+    maximum = std::max(
+        std::max(lanes[0], lanes[1]),
+        std::max(lanes[2], lanes[3])
+    );
+#endif
+    for (; i < count; ++i) {
+        float magnitude = fabsf(samples[i]);
+        maximum = std::max(maximum, magnitude);
+        if (magnitude >= LIMITER_CLIP_LEVEL) {
+            ++clip_count;
+        }
+    }
+    peak = maximum;
+    return clip_count;
+}
+
+/**
+ *  Scan 16-bit samples (the peak and the count of clips).
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param count
+ *      The count of samples.
+ *  @param peak
+ *      The peak magnitude (output, 32767 at most).
+ *  @return
+ *      The count of samples which reached full scale.
+ */
+static uint64_t scan(
+    const int16_t  *samples,
+    size_t          count,
+    int32_t        &peak
+) noexcept {
+    uint64_t clip_count = 0U;
+    int32_t maximum = 0;
+    size_t i = 0U;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i clip_level = _mm_set1_epi16(32766);
+    __m128i maximums = zero;
+    for (; i + 8U <= count; i += 8U) {
+        __m128i values = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(samples + i)
+        );
+        //  Saturated: |-32768| is 32767.
+        __m128i magnitudes = 
+            _mm_max_epi16(values, _mm_subs_epi16(zero, values));
+        maximums = _mm_max_epi16(maximums, magnitudes);
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi16(magnitudes, clip_level));
+        for (; mask != 0; mask >>= 2) {
+            clip_count += static_cast<uint64_t>(mask & 1);
+        }
+    }
+    int16_t lanes[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), maximums);
+    for (size_t k = 0U; k < 8U; ++k) {
+        maximum = std::max(maximum, static_cast<int32_t>(lanes[k]));
+    }
+#endif
+    for (; i < count; ++i) {
+        int32_t magnitude = 
+            std::min(abs(static_cast<int32_t>(samples[i])), 32767);
+        maximum = std::max(maximum, magnitude);
+        if (magnitude >= 32767) {
+            ++clip_count;
+        }
+    }
+    peak = maximum;
+    return clip_count;
+}
+
+/**
+ *  Soft-clip samples (magnitudes above the threshold are bent towards full 
+ *  scale by x / (1 + x)).
+ * 
+ *  @param samples
+ *      The samples (in place).
+ *  @param count
+ *      The count of samples.
+ *  @param threshold
+ *      The threshold.
+ */
+static void soft_clip(float *samples, size_t count, float threshold) noexcept {
+    float knee = 1.0F - threshold;
+    float inverse_knee = knee > 0.0F ? 1.0F / knee : 0.0F;
+    size_t i = 0U;
+#if defined(__SSE2__)
+    const __m128 magnitude_mask = 
+        _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 thresholds = _mm_set1_ps(threshold);
+    const __m128 knees = _mm_set1_ps(knee);
+    const __m128 inverse_knees = _mm_set1_ps(inverse_knee);
+    const __m128 one = _mm_set1_ps(1.0F);
+    for (; i + 4U <= count; i += 4U) {
+        __m128 values = _mm_loadu_ps(samples + i);
+        __m128 magnitudes = _mm_and_ps(values, magnitude_mask);
+        __m128 signs = _mm_andnot_ps(magnitude_mask, values);
+        __m128 over = _mm_mul_ps(
+            _mm_max_ps(_mm_sub_ps(magnitudes, thresholds), _mm_setzero_ps()),
+            inverse_knees
+        );
+        __m128 bent = _mm_add_ps(
+            _mm_min_ps(magnitudes, thresholds),
+            _mm_mul_ps(knees, _mm_div_ps(over, _mm_add_ps(one, over)))
+        );
+        _mm_storeu_ps(samples + i, _mm_or_ps(bent, signs));
+    }
+#endif
+    for (; i < count; ++i) {
+        float magnitude = fabsf(samples[i]);
+        if (magnitude <= threshold) {
+            continue;
+        }
+        float over = (magnitude - threshold) * inverse_knee;
+        samples[i] = copysignf(
+            threshold + knee * over / (1.0F + over),
+            samples[i]
+        );
+    }
+}
+
+/**
+ *  Compute the gain required by each peak (min(1, threshold / peak)).
+ * 
+ *  @param peaks
+ *      The peaks (replaced with the gains).
+ *  @param count
+ *      The count of peaks.
+ *  @param threshold
+ *      The threshold.
+ */
+static void compute_required_gains(
+    float   *peaks,
+    size_t   count,
+    float    threshold
+) noexcept {
+    size_t i = 0U;
+#if defined(__SSE2__)
+    const __m128 thresholds = _mm_set1_ps(threshold);
+    for (; i + 4U <= count; i += 4U) {
+        __m128 values = _mm_max_ps(_mm_loadu_ps(peaks + i), thresholds);
+        _mm_storeu_ps(peaks + i, _mm_div_ps(thresholds, values));
+    }
+#endif
+    for (; i < count; ++i) {
+        peaks[i] = threshold / std::max(peaks[i], threshold);
+    }
+}
+
+//
+//  Limiter constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format is not 16-bit or 32-bit float, or the options 
+ *              are invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param format
+ *      The format of the audio data.
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+Limiter::Limiter(
+    const xap::audioio::AudioFormat      &format,
+    const xap::audioio::LimiterOptions   &options,
+    xap::audioio::IAllocator             *allocator
+) :
+    m_format(format),
+    m_mode(options.mode),
+    m_threshold(1.0F),
+    m_release(1.0F),
+    m_gain(1.0F),
+    m_channel_count(static_cast<size_t>(format.channel_count)),
+    m_window(1U),
+    m_latency(0U),
+    m_delay(),
+    m_delay_position(0U),
+    m_extended(),
+    m_minimum_values(),
+    m_minimum_indices(),
+    m_minimum_head(0U),
+    m_minimum_count(0U),
+    m_average(),
+    m_average_position(0U),
+    m_average_sum(0.0),
+    m_index(0U),
+    m_quiet_frames(0U),
+    m_clip_count(0U)
+{
+    if ((format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        format.channel_count == 0U || 
+        format.sample_rate == 0U) {
+        throw xap::audioio::Exception(
+            "The format of the audio data is invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (options.mode > xap::audioio::LIMITERMODE_TRUE_PEAK || 
+        !(options.threshold <= 0.0F) || 
+        !(options.lookahead >= 0.0F) || 
+        options.lookahead > LIMITER_MAX_LOOKAHEAD || 
+        !(options.release > 0.0F)) {
+        throw xap::audioio::Exception(
+            "The options are invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    this->m_threshold = static_cast<float>(
+        pow(10.0, static_cast<double>(options.threshold) / 20.0)
+    );
+
+    if (this->m_mode == xap::audioio::LIMITERMODE_PEAK || 
+        this->m_mode == xap::audioio::LIMITERMODE_TRUE_PEAK) {
+        double rate = static_cast<double>(format.sample_rate);
+        size_t lookahead = static_cast<size_t>(
+            static_cast<double>(options.lookahead) * rate / 1000.0 + 0.5
+        );
+        this->m_window = lookahead + 1U;
+        this->m_latency = lookahead + LIMITER_DETECTOR_DELAY;
+        this->m_release = static_cast<float>(
+            1.0 - exp(-1000.0 / (static_cast<double>(options.release) * rate))
+        );
+
+        //
+        //  Delay line, detector history (followed by the block being 
+        //  detected), running minimum (of the required gains) and running 
+        //  average (of the minimums).
+        //
+        xap::audioio::AudioFormat state_format;
+        state_format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+        state_format.channel_count = format.channel_count;
+        state_format.sample_rate = format.sample_rate;
+        this->m_delay = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            this->m_latency,
+            allocator
+        );
+        this->m_extended = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            LIMITER_HISTORY_FRAMES + LIMITER_BLOCK_FRAMES,
+            allocator
+        );
+        state_format.channel_count = 1U;
+        this->m_minimum_values = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            this->m_window,
+            allocator
+        );
+        this->m_average = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            this->m_window,
+            allocator
+        );
+        state_format.sample_format = xap::audioio::SAMPLEFORMAT_INT32;
+        this->m_minimum_indices = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            this->m_window,
+            allocator
+        );
+    }
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+Limiter::~Limiter() noexcept {}
+
+//
+//  Limiter public methods.
+//
+
+/**
+ *  Process audio data (in place).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the audio data mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param data
+ *      The audio data.
+ */
+void Limiter::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_format.sample_format || 
+        data.get_channel_count() != this->m_format.channel_count || 
+        data.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    if (this->m_format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+        this->limit(data.get_samples<int16_t>(), data.get_frame_count());
+    } else {
+        this->limit(data.get_samples<float>(), data.get_frame_count());
+    }
+}
+
+/**
+ *  Limit 16-bit audio data (in place, the format must be 16-bit).
+ * 
+ *  @param samples
+ *      The samples (interleaved).
+ *  @param frame_count
+ *      The count of frames.
+ */
+void Limiter::limit(int16_t *samples, size_t frame_count) noexcept {
+    size_t channel_count = this->m_channel_count;
+    float scratch[LIMITER_BLOCK_FRAMES];
+    size_t block_frames = LIMITER_BLOCK_FRAMES / channel_count;
+
+    for (size_t offset = 0U; offset < frame_count; offset += block_frames) {
+        size_t count = std::min(block_frames, frame_count - offset);
+        int16_t *block = samples + offset * channel_count;
+        size_t sample_count = count * channel_count;
+
+        //
+        //  Count clips, no conversion is needed if nothing is changed.
+        //
+        if (this->m_mode == xap::audioio::LIMITERMODE_NONE || 
+            this->m_mode == xap::audioio::LIMITERMODE_SOFT_CLIP) {
+            int32_t peak = 0;
+            uint64_t clip_count = scan(block, sample_count, peak);
+            if (clip_count != 0U) {
+                this->m_clip_count.fetch_add(
+                    clip_count,
+                    std::memory_order_relaxed
+                );
+            }
+            if (this->m_mode == xap::audioio::LIMITERMODE_NONE || 
+                static_cast<float>(peak) <= this->m_threshold * 32768.0F) {
+                continue;
+            }
+        }
+
+        //
+        //  Convert, limit and convert back.
+        //
+        for (size_t i = 0U; i < sample_count; ++i) {
+            scratch[i] = static_cast<float>(block[i]) * (1.0F / 32768.0F);
+        }
+        if (this->m_mode == xap::audioio::LIMITERMODE_SOFT_CLIP) {
+            //  The clips were counted already.
+            soft_clip(scratch, sample_count, this->m_threshold);
+        } else {
+            this->limit_block(scratch, count);
+        }
+        for (size_t i = 0U; i < sample_count; ++i) {
+            block[i] = xap::audioio::fir_saturate_int16(scratch[i] * 32768.0F);
+        }
+    }
+}
+
+/**
+ *  Limit 32-bit float audio data (in place, the format must be 32-bit 
+ *  float).
+ * 
+ *  @param samples
+ *      The samples (interleaved).
+ *  @param frame_count
+ *      The count of frames.
+ */
+void Limiter::limit(float *samples, size_t frame_count) noexcept {
+    size_t channel_count = this->m_channel_count;
+    for (size_t offset = 0U; offset < frame_count;) {
+        size_t count = std::min(LIMITER_BLOCK_FRAMES, frame_count - offset);
+        float *block = samples + offset * channel_count;
+        if (this->m_mode == xap::audioio::LIMITERMODE_NONE || 
+            this->m_mode == xap::audioio::LIMITERMODE_SOFT_CLIP) {
+            float peak = 0.0F;
+            uint64_t clip_count = scan(block, count * channel_count, peak);
+            if (clip_count != 0U) {
+                this->m_clip_count.fetch_add(
+                    clip_count,
+                    std::memory_order_relaxed
+                );
+            }
+            if (this->m_mode == xap::audioio::LIMITERMODE_SOFT_CLIP && 
+                peak > this->m_threshold) {
+                soft_clip(block, count * channel_count, this->m_threshold);
+            }
+        } else {
+            this->limit_block(block, count);
+        }
+        offset += count;
+    }
+}
+
+/**
+ *  Reset (clear the delay line and recover the gain, the count of clips 
+ *  is kept).
+ */
+void Limiter::reset() noexcept {
+    this->m_gain = 1.0F;
+    this->m_delay_position = 0U;
+    this->m_minimum_head = 0U;
+    this->m_minimum_count = 0U;
+    this->m_average_position = 0U;
+    this->m_average_sum = static_cast<double>(this->m_window);
+    this->m_index = 0U;
+    this->m_quiet_frames = 2U * this->m_window;
+    if (this->m_delay.is_empty()) {
+        return;
+    }
+    memset(this->m_delay.get_pointer(), 0, this->m_delay.get_length());
+    memset(this->m_extended.get_pointer(), 0, this->m_extended.get_length());
+    float *average = this->m_average.get_samples<float>();
+    for (size_t i = 0U; i < this->m_window; ++i) {
+        average[i] = 1.0F;
+    }
+}
+
+/**
+ *  Get the count of samples which reached full scale before the limiter 
+ *  (thread-safe).
+ * 
+ *  @return
+ *      The count.
+ */
+uint64_t Limiter::get_clip_count() const noexcept {
+    return this->m_clip_count.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Get the latency (the delay of the audio data).
+ * 
+ *  @return
+ *      The count of frames.
+ */
+size_t Limiter::get_latency() const noexcept {
+    return this->m_latency;
+}
+
+//
+//  Limiter private methods.
+//
+
+/**
+ *  Limit one block of 32-bit float audio data.
+ * 
+ *  @param samples
+ *      The samples (interleaved).
+ *  @param frame_count
+ *      The count of frames (at most the block size).
+ */
+void Limiter::limit_block(float *samples, size_t frame_count) noexcept {
+    size_t channel_count = this->m_channel_count;
+    size_t sample_count = frame_count * channel_count;
+    float peak = 0.0F;
+    uint64_t clip_count = scan(samples, sample_count, peak);
+    if (clip_count != 0U) {
+        this->m_clip_count.fetch_add(clip_count, std::memory_order_relaxed);
+    }
+
+    //
+    //  Bypass (only delay) if the gain is recovered and neither the block 
+    //  nor the frames still in the detector can exceed the threshold.
+    //
+    float history_peak = 0.0F;
+    scan(
+        this->m_extended.get_samples<float>(),
+        LIMITER_HISTORY_FRAMES * channel_count,
+        history_peak
+    );
+    float bound = std::max(peak, history_peak);
+    if (this->m_mode == xap::audioio::LIMITERMODE_TRUE_PEAK) {
+        bound *= LIMITER_TRUE_PEAK_RATIO;
+    }
+    if (bound <= this->m_threshold && 
+        this->m_gain == 1.0F && 
+        this->m_quiet_frames >= 2U * this->m_window) {
+        float *history = this->m_extended.get_samples<float>();
+        if (frame_count >= LIMITER_HISTORY_FRAMES) {
+            memcpy(
+                history,
+                samples + (frame_count - LIMITER_HISTORY_FRAMES) * 
+                          channel_count,
+                LIMITER_HISTORY_FRAMES * channel_count * sizeof(float)
+            );
+        } else {
+            memmove(
+                history,
+                history + frame_count * channel_count,
+                (LIMITER_HISTORY_FRAMES - frame_count) * channel_count * 
+                    sizeof(float)
+            );
+            memcpy(
+                history + 
+                    (LIMITER_HISTORY_FRAMES - frame_count) * channel_count,
+                samples,
+                sample_count * sizeof(float)
+            );
+        }
+
+        //  The running minimum is empty (all ones) while quiet.
+        this->m_minimum_count = 0U;
+        this->m_average_sum = static_cast<double>(this->m_window);
+        this->m_index += frame_count;
+        this->m_quiet_frames += frame_count;
+        this->delay(samples, frame_count);
+        return;
+    }
+
+    //
+    //  Detect the peaks and compute the required gains.
+    //
+    float gains[LIMITER_BLOCK_FRAMES];
+    this->detect(samples, frame_count, gains);
+    compute_required_gains(gains, frame_count, this->m_threshold);
+
+    //
+    //  Running minimum over the window (the gain must be reached before the 
+    //  peak leaves the delay line), running average over the window (smooth 
+    //  attack, never above the minimum of the peak), then release.
+    //
+    float *minimum_values = this->m_minimum_values.get_samples<float>();
+    uint32_t *minimum_indices = this->m_minimum_indices.get_samples<uint32_t>();
+    float *average = this->m_average.get_samples<float>();
+    size_t window = this->m_window;
+    for (size_t i = 0U; i < frame_count; ++i) {
+        float required = gains[i];
+        uint32_t index = static_cast<uint32_t>(this->m_index);
+        if (required < 1.0F) {
+            this->m_quiet_frames = 0U;
+        } else {
+            ++(this->m_quiet_frames);
+        }
+
+        //  Drop the expired front, then the values not below the new one 
+        //  from the back.
+        if (this->m_minimum_count != 0U && 
+            index - minimum_indices[this->m_minimum_head] >= window) {
+            this->m_minimum_head = (this->m_minimum_head + 1U) % window;
+            --(this->m_minimum_count);
+        }
+        while (this->m_minimum_count != 0U) {
+            size_t back = (this->m_minimum_head + this->m_minimum_count - 1U) %
+                          window;
+            if (minimum_values[back] < required) {
+                break;
+            }
+            --(this->m_minimum_count);
+        }
+        size_t tail = (this->m_minimum_head + this->m_minimum_count) % window;
+        minimum_values[tail] = required;
+        minimum_indices[tail] = index;
+        ++(this->m_minimum_count);
+        float minimum = minimum_values[this->m_minimum_head];
+
+        this->m_average_sum += static_cast<double>(minimum) - 
+                               static_cast<double>(
+                                   average[this->m_average_position]
+                               );
+        average[this->m_average_position] = minimum;
+        this->m_average_position = (this->m_average_position + 1U) % window;
+        float target = static_cast<float>(
+            this->m_average_sum / static_cast<double>(window)
+        );
+        target = std::min(target, 1.0F);
+
+        if (target < this->m_gain) {
+            this->m_gain = target;
+        } else {
+            this->m_gain += (target - this->m_gain) * this->m_release;
+            if (this->m_gain > 0.9999F) {
+                this->m_gain = target;
+            }
+        }
+        gains[i] = this->m_gain;
+        ++(this->m_index);
+    }
+
+    //
+    //  Apply the gains to the delayed audio data.
+    //
+    this->delay(samples, frame_count);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        float gain = gains[i];
+        float *frame = samples + i * channel_count;
+        for (size_t c = 0U; c < channel_count; ++c) {
+            frame[c] *= gain;
+        }
+    }
+}
+
+/**
+ *  Detect the peaks of one block (look-ahead modes).
+ * 
+ *  @param samples
+ *      The samples (interleaved).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param peaks
+ *      The peak of each frame (output, delayed by the detector).
+ */
+void Limiter::detect(
+    const float  *samples,
+    size_t        frame_count,
+    float        *peaks
+) noexcept {
+    size_t channel_count = this->m_channel_count;
+    float *extended = this->m_extended.get_samples<float>();
+    memcpy(
+        extended + LIMITER_HISTORY_FRAMES * channel_count,
+        samples,
+        frame_count * channel_count * sizeof(float)
+    );
+
+    //  The peak of frame n - 2 (x1) is detected at frame n (x3), in true-peak 
+    //  mode with the peaks between x1 and x2.
+    bool is_true_peak = (this->m_mode == xap::audioio::LIMITERMODE_TRUE_PEAK);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        const float *x0 = extended + i * channel_count;
+        const float *x1 = x0 + channel_count;
+        const float *x2 = x1 + channel_count;
+        const float *x3 = x2 + channel_count;
+        float peak = 0.0F;
+        for (size_t c = 0U; c < channel_count; ++c) {
+            peak = std::max(peak, fabsf(x1[c]));
+            if (!is_true_peak) {
+                continue;
+            }
+            for (size_t k = 0U; k < 3U; ++k) {
+                const float *w = LIMITER_INTERPOLATION[k];
+                float value = w[0] * x0[c] + w[1] * x1[c] + 
+                              w[2] * x2[c] + w[3] * x3[c];
+                peak = std::max(peak, fabsf(value));
+            }
+        }
+        peaks[i] = peak;
+    }
+
+    memmove(
+        extended,
+        extended + frame_count * channel_count,
+        LIMITER_HISTORY_FRAMES * channel_count * sizeof(float)
+    );
+}
+
+/**
+ *  Exchange one block with the delay line (look-ahead modes).
+ * 
+ *  @param samples
+ *      The samples (replaced with the delayed samples).
+ *  @param frame_count
+ *      The count of frames.
+ */
+void Limiter::delay(float *samples, size_t frame_count) noexcept {
+    size_t channel_count = this->m_channel_count;
+    float *line = this->m_delay.get_samples<float>();
+    size_t offset = 0U;
+    while (offset < frame_count) {
+        size_t count = std::min(
+            frame_count - offset,
+            this->m_latency - this->m_delay_position
+        );
+        std::swap_ranges(
+            samples + offset * channel_count,
+            samples + (offset + count) * channel_count,
+            line + this->m_delay_position * channel_count
+        );
+        offset += count;
+        this->m_delay_position += count;
+        if (this->m_delay_position == this->m_latency) {
+            this->m_delay_position = 0U;
+        }
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
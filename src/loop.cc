@@ -0,0 +1,450 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/loop.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double LOOP_PI = 3.14159265358979323846;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Round and saturate a crossfaded sample.
+ * 
+ *  @param value
+ *      The crossfaded sample.
+ *  @return
+ *      The sample.
+ */
+template<class T>
+static T saturate(double value) noexcept;
+
+template<>
+int16_t saturate<int16_t>(double value) noexcept {
+    return static_cast<int16_t>(
+        std::min(32767.0, std::max(-32768.0, floor(value + 0.5)))
+    );
+}
+
+template<>
+int32_t saturate<int32_t>(double value) noexcept {
+    return static_cast<int32_t>(
+        std::min(2147483647.0, std::max(-2147483648.0, floor(value + 0.5)))
+    );
+}
+
+template<>
+float saturate<float>(double value) noexcept {
+    return static_cast<float>(value);
+}
+
+/**
+ *  Compute the seam of a loop (equal-power crossfade of the end of the loop 
+ *  into its start).
+ * 
+ *  @param seam
+ *      The seam (output).
+ *  @param loop_tail
+ *      The last frames of the loop.
+ *  @param loop_head
+ *      The first frames of the loop.
+ *  @param frame_count
+ *      The count of frames of the crossfade.
+ *  @param channel_count
+ *      The count of channels.
+ */
+template<class T>
+static void compute_seam(
+    T           *seam,
+    const T     *loop_tail,
+    const T     *loop_head,
+    size_t       frame_count,
+    size_t       channel_count
+) noexcept {
+    double step = 0.5 * LOOP_PI / static_cast<double>(frame_count);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        double angle = (static_cast<double>(i) + 0.5) * step;
+        double gain_out = cos(angle);
+        double gain_in = sin(angle);
+        for (size_t c = 0U; c < channel_count; ++c) {
+            size_t k = i * channel_count + c;
+            seam[k] = saturate<T>(
+                static_cast<double>(loop_tail[k]) * gain_out + 
+                static_cast<double>(loop_head[k]) * gain_in
+            );
+        }
+    }
+}
+
+//
+//  LoopBuffer constructor & destructor.
+//
+
+/**
+ *  Construct the object (compute the seam).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The region is out of the audio data, or the audio data cannot 
+ *              be crossfaded (not 16-bit, 32-bit or 32-bit float).
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param data
+ *      The audio data (shared, e.g. a prompt of PromptCache).
+ *  @param region
+ *      The loop region.
+ *  @param allocator
+ *      The allocator of the seam (nullptr for the default allocator).
+ */
+LoopBuffer::LoopBuffer(
+    const xap::audioio::AudioBuffer    &data,
+    const xap::audioio::LoopRegion     &region,
+    xap::audioio::IAllocator           *allocator
+):
+    m_data(data),
+    m_seam(),
+    m_loop_start(region.loop_start),
+    m_loop_end(region.loop_end),
+    m_crossfade_frames(0U)
+{
+    size_t frame_count = data.get_frame_count();
+    if (this->m_loop_end == 0U) {
+        this->m_loop_end = frame_count;
+    }
+    if (this->m_loop_end > frame_count || 
+        this->m_loop_start >= this->m_loop_end) {
+        throw xap::audioio::Exception(
+            "Invalid loop region.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    this->m_crossfade_frames = std::min(
+        region.crossfade_frames,
+        (this->m_loop_end - this->m_loop_start) / 2U
+    );
+
+    xap::audioio::AudioFormat format;
+    format.sample_format = data.get_sample_format();
+    format.channel_count = data.get_channel_count();
+    format.sample_rate = data.get_sample_rate();
+    this->m_seam = xap::audioio::AudioBuffer::allocate(
+        format,
+        this->m_crossfade_frames,
+        allocator
+    );
+    if (this->m_crossfade_frames == 0U) {
+        return;
+    }
+    size_t frame_size = xap::audioio::get_frame_size(format);
+    const uint8_t *tail = 
+        data.get_samples<uint8_t>() + 
+        (this->m_loop_end - this->m_crossfade_frames) * frame_size;
+    const uint8_t *head = 
+        data.get_samples<uint8_t>() + this->m_loop_start * frame_size;
+    switch (format.sample_format) {
+    case xap::audioio::SAMPLEFORMAT_INT16:
+        compute_seam<int16_t>(
+            this->m_seam.get_samples<int16_t>(),
+            reinterpret_cast<const int16_t *>(tail),
+            reinterpret_cast<const int16_t *>(head),
+            this->m_crossfade_frames,
+            format.channel_count
+        );
+        break;
+    case xap::audioio::SAMPLEFORMAT_INT32:
+        compute_seam<int32_t>(
+            this->m_seam.get_samples<int32_t>(),
+            reinterpret_cast<const int32_t *>(tail),
+            reinterpret_cast<const int32_t *>(head),
+            this->m_crossfade_frames,
+            format.channel_count
+        );
+        break;
+    case xap::audioio::SAMPLEFORMAT_FLOAT32:
+        compute_seam<float>(
+            this->m_seam.get_samples<float>(),
+            reinterpret_cast<const float *>(tail),
+            reinterpret_cast<const float *>(head),
+            this->m_crossfade_frames,
+            format.channel_count
+        );
+        break;
+    default:
+        throw xap::audioio::Exception(
+            "The audio data cannot be crossfaded.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+LoopBuffer::~LoopBuffer() noexcept {
+    //  Nothing.
+}
+
+//
+//  LoopBuffer public methods.
+//
+
+/**
+ *  Get the audio data.
+ * 
+ *  @return
+ *      The audio data.
+ */
+const xap::audioio::AudioBuffer &LoopBuffer::get_data() const noexcept {
+    return this->m_data;
+}
+
+/**
+ *  Get the seam (the last frames of the loop crossfaded into its first 
+ *  frames).
+ * 
+ *  @return
+ *      The seam (no frame if the loop is not crossfaded).
+ */
+const xap::audioio::AudioBuffer &LoopBuffer::get_seam() const noexcept {
+    return this->m_seam;
+}
+
+/**
+ *  Get the first frame of the loop.
+ * 
+ *  @return
+ *      The position (in frames).
+ */
+size_t LoopBuffer::get_loop_start() const noexcept {
+    return this->m_loop_start;
+}
+
+/**
+ *  Get the frame after the last frame of the loop.
+ * 
+ *  @return
+ *      The position (in frames).
+ */
+size_t LoopBuffer::get_loop_end() const noexcept {
+    return this->m_loop_end;
+}
+
+/**
+ *  Get the count of frames of the crossfade (clamped to half of the loop).
+ * 
+ *  @return
+ *      The count of frames.
+ */
+size_t LoopBuffer::get_crossfade_frames() const noexcept {
+    return this->m_crossfade_frames;
+}
+
+//
+//  LoopSource constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the loop is nullptr or the start frame is out of the audio 
+ *      data (xap::audioio::ERROR_PARAMETER).
+ *  @param loop
+ *      The loop (shared).
+ *  @param options
+ *      The options.
+ */
+LoopSource::LoopSource(
+    const std::shared_ptr<const xap::audioio::LoopBuffer>  &loop,
+    const xap::audioio::LoopSourceOptions                  &options
+):
+    m_loop(loop),
+    m_loop_count(options.loop_count),
+    m_frame_size(0U),
+    m_position(options.start_frame),
+    m_is_in_seam(false),
+    m_is_released(false),
+    m_is_finished(false),
+    m_loop_index(0U)
+{
+    if (!loop || options.start_frame >= loop->get_data().get_frame_count()) {
+        throw xap::audioio::Exception(
+            "Invalid loop or start frame.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    const xap::audioio::AudioBuffer &data = loop->get_data();
+    this->m_frame_size = data.get_length() / data.get_frame_count();
+}
+
+/**
+ *  Destruct the object.
+ */
+LoopSource::~LoopSource() noexcept {
+    //  Nothing.
+}
+
+//
+//  LoopSource public methods.
+//
+
+/**
+ *  Read audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (less than requested at the end of the audio 
+ *      data).
+ */
+size_t LoopSource::read(xap::audioio::AudioBuffer &output) {
+    const xap::audioio::LoopBuffer &loop = *(this->m_loop);
+    const xap::audioio::AudioBuffer &data = loop.get_data();
+    if (output.get_sample_format() != data.get_sample_format() || 
+        output.get_channel_count() != data.get_channel_count() || 
+        output.get_sample_rate() != data.get_sample_rate()) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t frame_size = this->m_frame_size;
+    size_t crossfade_frames = loop.get_crossfade_frames();
+    size_t frame_count = output.get_frame_count();
+    uint8_t *destination = output.get_samples<uint8_t>();
+    size_t filled = 0U;
+    while (filled < frame_count) {
+        if (this->m_is_in_seam) {
+            //  Play the seam, then the loop after its crossfaded frames.
+            size_t count = std::min(
+                frame_count - filled,
+                crossfade_frames - this->m_position
+            );
+            memcpy(
+                destination + filled * frame_size,
+                loop.get_seam().get_samples<uint8_t>() + 
+                    this->m_position * frame_size,
+                count * frame_size
+            );
+            filled += count;
+            this->m_position += count;
+            if (this->m_position == crossfade_frames) {
+                this->m_is_in_seam = false;
+                this->m_position = loop.get_loop_start() + crossfade_frames;
+                this->m_loop_index.fetch_add(1U, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        uint64_t loop_index = 
+            this->m_loop_index.load(std::memory_order_relaxed);
+        bool is_looping = 
+            !this->m_is_released.load(std::memory_order_relaxed) && 
+            (this->m_loop_count == 0U || loop_index < this->m_loop_count);
+        size_t boundary = data.get_frame_count();
+        if (is_looping && this->m_position <= loop.get_loop_end()) {
+            boundary = loop.get_loop_end() - crossfade_frames;
+        }
+        if (this->m_position >= boundary) {
+            if (boundary == data.get_frame_count()) {
+                this->m_is_finished.store(true, std::memory_order_relaxed);
+                break;
+            }
+
+            //  Reached the end of the loop.
+            if (crossfade_frames == 0U) {
+                this->m_position = loop.get_loop_start();
+                this->m_loop_index.fetch_add(1U, std::memory_order_relaxed);
+            } else {
+                this->m_is_in_seam = true;
+                this->m_position = 0U;
+            }
+            continue;
+        }
+        size_t count = std::min(
+            frame_count - filled,
+            boundary - this->m_position
+        );
+        memcpy(
+            destination + filled * frame_size,
+            data.get_samples<uint8_t>() + this->m_position * frame_size,
+            count * frame_size
+        );
+        filled += count;
+        this->m_position += count;
+    }
+    if (!this->m_is_in_seam && this->m_position >= data.get_frame_count()) {
+        this->m_is_finished.store(true, std::memory_order_relaxed);
+    }
+    return filled;
+}
+
+/**
+ *  Seek (on the audio thread, or while the source is not played).
+ * 
+ *  @param frame
+ *      The position (in frames of the audio data, clamped to its length).
+ */
+void LoopSource::seek(size_t frame) noexcept {
+    size_t frame_count = this->m_loop->get_data().get_frame_count();
+    this->m_position = std::min(frame, frame_count);
+    this->m_is_in_seam = false;
+    this->m_is_finished.store(
+        this->m_position >= frame_count,
+        std::memory_order_relaxed
+    );
+}
+
+/**
+ *  Stop repeating (thread-safe), the audio data is played to its end once 
+ *  the end of the loop is reached.
+ */
+void LoopSource::release() noexcept {
+    this->m_is_released.store(true, std::memory_order_relaxed);
+}
+
+/**
+ *  Get the count of times the loop repeated.
+ * 
+ *  @return
+ *      The count.
+ */
+uint64_t LoopSource::get_loop_index() const noexcept {
+    return this->m_loop_index.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Get whether all frames were read.
+ * 
+ *  @return
+ *      True if so.
+ */
+bool LoopSource::is_finished() const noexcept {
+    return this->m_is_finished.load(std::memory_order_relaxed);
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,713 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fir_p.h"
+
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/lossconcealer.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of frames processed per pass.
+const static size_t LOSSCONCEALER_CHUNK_FRAMES = 256U;
+
+//  Pitch search range and correlation window (in microseconds, 40 to 120 
+//  samples and 160 samples at 8kHz).
+const static uint32_t LOSSCONCEALER_PITCH_MIN = 5000U;
+const static uint32_t LOSSCONCEALER_PITCH_MAX = 15000U;
+const static uint32_t LOSSCONCEALER_CORRELATION = 20000U;
+
+//  Concealment frame (the period count and the attenuation change per 
+//  frame) and the extension of the recovery overlap-add per frame lost.
+const static uint32_t LOSSCONCEALER_FRAME = 10000U;
+const static uint32_t LOSSCONCEALER_RECOVERY_STEP = 4000U;
+
+//  Attenuation per concealment frame (after the first one).
+const static float LOSSCONCEALER_ATTENUATION = 0.2F;
+
+//  Maximum count of pitch periods repeated.
+const static size_t LOSSCONCEALER_MAX_PERIODS = 3U;
+
+//  Modes.
+const static uint32_t LOSSCONCEALER_MODE_RECEIVING = 0U;
+const static uint32_t LOSSCONCEALER_MODE_CONCEALING = 1U;
+const static uint32_t LOSSCONCEALER_MODE_RECOVERING = 2U;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Concealment state (shared by all channels).
+ */
+typedef struct LossConcealerState_ {
+    uint32_t    mode;
+    uint8_t     __pad1[4];
+
+    //  Pitch period and overlap-add length.
+    size_t      pitch;
+    size_t      overlap;
+
+    //  Count of periods repeated and position in them.
+    size_t      periods;
+    size_t      position;
+
+    //  Count of frames synthesized since the loss began.
+    size_t      synthesized;
+
+    //  Overlap-add of the frames received after the loss.
+    size_t      recovery_length;
+    size_t      recovery_position;
+} LossConcealerState;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Convert a duration to a count of frames.
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @param duration
+ *      The duration (in microseconds).
+ *  @return
+ *      The count of frames.
+ */
+static size_t to_frames(uint32_t sample_rate, uint32_t duration) noexcept {
+    return static_cast<size_t>(
+        static_cast<uint64_t>(sample_rate) * duration / 1000000U
+    );
+}
+
+/**
+ *  Validate the audio format of a concealer.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format is invalid (xap::audioio::ERROR_PARAMETER) or 
+ *      not supported (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param format
+ *      The audio format.
+ *  @return
+ *      The count of channels.
+ */
+static size_t validate_format(const xap::audioio::AudioFormat &format) {
+    if (format.channel_count == 0U) {
+        throw xap::audioio::Exception(
+            "Invalid audio format.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if ((format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        format.sample_rate < 8000U) {
+        throw xap::audioio::Exception(
+            "Only 16-bit or 32-bit float audio data at 8kHz or higher is "
+            "supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    return static_cast<size_t>(format.channel_count);
+}
+
+/**
+ *  Build the audio format of the concealer state (mono, 32-bit float).
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_state_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+//
+//  LossConcealer constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The upstream source is nullptr or the format is invalid.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The sample format is neither 16-bit nor 32-bit float or 
+ *              the sample rate is lower than 8kHz.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param upstream
+ *      The upstream source (in the format of the output).
+ *  @param format
+ *      The audio format (the format of the player).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+LossConcealer::LossConcealer(
+    const std::shared_ptr<xap::audioio::ISource> &upstream,
+    const xap::audioio::AudioFormat              &format,
+    xap::audioio::IAllocator                     *allocator
+) : 
+    m_upstream(upstream),
+    m_format(format),
+    m_channel_count(validate_format(format)),
+    m_pitch_min(to_frames(format.sample_rate, LOSSCONCEALER_PITCH_MIN)),
+    m_pitch_max(to_frames(format.sample_rate, LOSSCONCEALER_PITCH_MAX)),
+    m_correlation_length(
+        to_frames(format.sample_rate, LOSSCONCEALER_CORRELATION)
+    ),
+    m_overlap_max(0U),
+    m_frames_10ms(to_frames(format.sample_rate, LOSSCONCEALER_FRAME)),
+    m_frames_4ms(
+        to_frames(format.sample_rate, LOSSCONCEALER_RECOVERY_STEP)
+    ),
+    m_history_length(0U),
+    m_history_capacity(0U),
+    m_history_end(0U),
+    m_history(),
+    m_pitch_buffers(),
+    m_work(),
+    m_mixdown(),
+    m_state(nullptr),
+    m_concealed(0U),
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{
+    if (!upstream) {
+        throw xap::audioio::Exception(
+            "The upstream source is null.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  The history holds 3 pitch periods and the overlap-add of the 
+    //  longest one (48.75ms), plus the frames of one pass.
+    //
+    this->m_overlap_max = this->m_pitch_max / 4U;
+    this->m_history_length = 
+        LOSSCONCEALER_MAX_PERIODS * this->m_pitch_max + this->m_overlap_max;
+    this->m_history_capacity = 
+        this->m_history_length + LOSSCONCEALER_CHUNK_FRAMES;
+
+    xap::audioio::AudioFormat state_format = 
+        build_state_format(format.sample_rate);
+    this->m_history = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        this->m_history_capacity * this->m_channel_count,
+        allocator
+    );
+    this->m_pitch_buffers = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        this->m_history_length * this->m_channel_count,
+        allocator
+    );
+    this->m_work = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        LOSSCONCEALER_CHUNK_FRAMES * this->m_channel_count,
+        allocator
+    );
+    this->m_mixdown = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        this->m_correlation_length + this->m_pitch_max,
+        allocator
+    );
+    this->m_state = xap::audioio::new_object<LossConcealerState>(
+        this->m_allocator
+    );
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+LossConcealer::~LossConcealer() noexcept {
+    xap::audioio::free_object(this->m_state);
+}
+
+//
+//  LossConcealer public methods.
+//
+
+/**
+ *  Read audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED) or the upstream source failed.
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames of the output (lost frames are concealed).
+ */
+size_t LossConcealer::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_format.sample_format || 
+        output.get_channel_count() != this->m_format.channel_count || 
+        output.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    size_t frame_count = output.get_frame_count();
+    size_t received = this->m_upstream->read(output);
+    if (received > frame_count) {
+        received = frame_count;
+    }
+
+    size_t channel_count = this->m_channel_count;
+    bool is_float = 
+        (this->m_format.sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32);
+    float *history = this->m_history.get_samples<float>();
+    float *work = this->m_work.get_samples<float>();
+
+    for (size_t offset = 0U; offset < frame_count; ) {
+        size_t count = frame_count - offset;
+        if (count > LOSSCONCEALER_CHUNK_FRAMES) {
+            count = LOSSCONCEALER_CHUNK_FRAMES;
+        }
+        size_t good = 0U;
+        if (received > offset) {
+            good = received - offset;
+            if (good > count) {
+                good = count;
+            }
+        }
+
+        //
+        //  Discard the oldest history if the frames of this pass do not fit.
+        //
+        if (this->m_history_end + count > this->m_history_capacity) {
+            size_t drop = this->m_history_end - this->m_history_length;
+            for (size_t c = 0U; c < channel_count; ++c) {
+                float *line = history + c * this->m_history_capacity;
+                memmove(
+                    line,
+                    line + drop,
+                    this->m_history_length * sizeof(float)
+                );
+            }
+            this->m_history_end = this->m_history_length;
+        }
+        size_t begin = this->m_history_end;
+
+        //
+        //  Received frames.
+        //
+        if (good != 0U) {
+            if (is_float) {
+                const float *source = output.get_samples<float>() + 
+                                      offset * channel_count;
+                for (size_t i = 0U; i < good; ++i) {
+                    for (size_t c = 0U; c < channel_count; ++c) {
+                        work[c * LOSSCONCEALER_CHUNK_FRAMES + i] = 
+                            source[i * channel_count + c];
+                    }
+                }
+            } else {
+                const int16_t *source = output.get_samples<int16_t>() + 
+                                        offset * channel_count;
+                for (size_t i = 0U; i < good; ++i) {
+                    for (size_t c = 0U; c < channel_count; ++c) {
+                        work[c * LOSSCONCEALER_CHUNK_FRAMES + i] = 
+                            static_cast<float>(source[i * channel_count + c]);
+                    }
+                }
+            }
+
+            if (this->m_state->mode == LOSSCONCEALER_MODE_CONCEALING) {
+                //
+                //  The first frames after a loss: overlap-add with the 
+                //  synthetic audio data for a quarter of the pitch period, 
+                //  extended by 4ms per 10ms lost (up to 10ms).
+                //
+                size_t extension = 0U;
+                if (this->m_state->synthesized != 0U) {
+                    extension = (this->m_state->synthesized - 1U) / 
+                                this->m_frames_10ms;
+                }
+                size_t length = this->m_state->overlap + 
+                                extension * this->m_frames_4ms;
+                if (length > this->m_frames_10ms) {
+                    length = this->m_frames_10ms;
+                }
+                this->m_state->mode = LOSSCONCEALER_MODE_RECOVERING;
+                this->m_state->recovery_length = length;
+                this->m_state->recovery_position = 0U;
+            }
+
+            LossConcealerState state = *(this->m_state);
+            for (size_t c = 0U; c < channel_count; ++c) {
+                state = *(this->m_state);
+                this->append_received(
+                    c,
+                    work + c * LOSSCONCEALER_CHUNK_FRAMES,
+                    good,
+                    state
+                );
+            }
+            *(this->m_state) = state;
+            this->m_history_end += good;
+        }
+
+        //
+        //  Lost frames.
+        //
+        if (good != count) {
+            if (this->m_state->mode != LOSSCONCEALER_MODE_CONCEALING) {
+                this->begin_loss();
+            }
+            LossConcealerState state = *(this->m_state);
+            for (size_t c = 0U; c < channel_count; ++c) {
+                state = *(this->m_state);
+                this->append_concealed(c, count - good, state);
+            }
+            *(this->m_state) = state;
+            this->m_history_end += count - good;
+            this->m_concealed += static_cast<uint64_t>(count - good);
+        }
+
+        //
+        //  Output (delayed).
+        //
+        size_t delayed = begin - this->m_overlap_max;
+        if (is_float) {
+            float *destination = output.get_samples<float>() + 
+                                 offset * channel_count;
+            for (size_t c = 0U; c < channel_count; ++c) {
+                const float *line = 
+                    history + c * this->m_history_capacity + delayed;
+                for (size_t i = 0U; i < count; ++i) {
+                    destination[i * channel_count + c] = line[i];
+                }
+            }
+        } else {
+            int16_t *destination = output.get_samples<int16_t>() + 
+                                   offset * channel_count;
+            for (size_t c = 0U; c < channel_count; ++c) {
+                const float *line = 
+                    history + c * this->m_history_capacity + delayed;
+                for (size_t i = 0U; i < count; ++i) {
+                    destination[i * channel_count + c] = 
+                        xap::audioio::fir_saturate_int16(line[i]);
+                }
+            }
+        }
+
+        offset += count;
+    }
+
+    return frame_count;
+}
+
+/**
+ *  Reset the state (clear the history).
+ */
+void LossConcealer::reset() noexcept {
+    memset(this->m_history.get_pointer(), 0, this->m_history.get_length());
+    memset(
+        this->m_pitch_buffers.get_pointer(),
+        0,
+        this->m_pitch_buffers.get_length()
+    );
+    this->m_history_end = this->m_history_length;
+    memset(this->m_state, 0, sizeof(LossConcealerState));
+    this->m_state->mode = LOSSCONCEALER_MODE_RECEIVING;
+    this->m_concealed = 0U;
+}
+
+/**
+ *  Get the delay of the output (in frames).
+ * 
+ *  @return
+ *      The delay.
+ */
+size_t LossConcealer::get_latency() const noexcept {
+    return this->m_overlap_max;
+}
+
+/**
+ *  Get the count of frames concealed since construction (or reset()).
+ * 
+ *  @return
+ *      The count of frames.
+ */
+uint64_t LossConcealer::get_concealed_frame_count() const noexcept {
+    return this->m_concealed;
+}
+
+//
+//  LossConcealer private methods.
+//
+
+/**
+ *  Append received frames to the history of one channel.
+ * 
+ *  @param channel
+ *      The channel index.
+ *  @param input
+ *      The received samples.
+ *  @param count
+ *      The count of samples.
+ *  @param state
+ *      The concealment state (updated).
+ */
+void LossConcealer::append_received(
+    size_t                          channel,
+    const float                    *input,
+    size_t                          count,
+    struct LossConcealerState_     &state
+) noexcept {
+    float *destination = this->m_history.get_samples<float>() + 
+                         channel * this->m_history_capacity + 
+                         this->m_history_end;
+    size_t i = 0U;
+    if (state.mode == LOSSCONCEALER_MODE_RECOVERING) {
+        i = state.recovery_length - state.recovery_position;
+        if (i > count) {
+            i = count;
+        }
+        this->synthesize(channel, destination, i, state);
+        float length = static_cast<float>(state.recovery_length);
+        for (size_t j = 0U; j < i; ++j) {
+            float weight = 
+                (static_cast<float>(state.recovery_position + j) + 0.5F) / 
+                length;
+            destination[j] = destination[j] * (1.0F - weight) + 
+                             input[j] * weight;
+        }
+        state.recovery_position += i;
+        if (state.recovery_position == state.recovery_length) {
+            state.mode = LOSSCONCEALER_MODE_RECEIVING;
+        }
+    }
+    memcpy(destination + i, input + i, (count - i) * sizeof(float));
+}
+
+/**
+ *  Append synthetic frames to the history of one channel.
+ * 
+ *  @param channel
+ *      The channel index.
+ *  @param count
+ *      The count of samples.
+ *  @param state
+ *      The concealment state (updated).
+ */
+void LossConcealer::append_concealed(
+    size_t                          channel,
+    size_t                          count,
+    struct LossConcealerState_     &state
+) noexcept {
+    this->synthesize(
+        channel,
+        this->m_history.get_samples<float>() + 
+            channel * this->m_history_capacity + 
+            this->m_history_end,
+        count,
+        state
+    );
+}
+
+/**
+ *  Synthesize the next samples of one channel.
+ * 
+ *  @param channel
+ *      The channel index.
+ *  @param output
+ *      The output.
+ *  @param count
+ *      The count of samples.
+ *  @param state
+ *      The concealment state (updated).
+ */
+void LossConcealer::synthesize(
+    size_t                          channel,
+    float                          *output,
+    size_t                          count,
+    struct LossConcealerState_     &state
+) const noexcept {
+    const float *buffer = this->m_pitch_buffers.get_samples<float>() + 
+                          channel * this->m_history_length;
+    size_t end = this->m_history_length;
+    float frame = static_cast<float>(this->m_frames_10ms);
+    for (size_t i = 0U; i < count; ++i) {
+        //
+        //  Wrap around, using 2 periods after 10ms and 3 periods after 20ms 
+        //  (continuing at the same position).
+        //
+        if (state.position == state.periods * state.pitch) {
+            size_t periods = 1U + state.synthesized / this->m_frames_10ms;
+            if (periods > LOSSCONCEALER_MAX_PERIODS) {
+                periods = LOSSCONCEALER_MAX_PERIODS;
+            }
+            if (periods > state.periods) {
+                state.position = (periods - state.periods) * state.pitch;
+                state.periods = periods;
+            } else {
+                state.position = 0U;
+            }
+        }
+
+        //
+        //  Repeat the periods, overlap-adding the end of them with the 
+        //  frames preceding their beginning.
+        //
+        size_t length = state.periods * state.pitch;
+        size_t start = end - length;
+        float value = buffer[start + state.position];
+        if (state.position >= length - state.overlap) {
+            size_t j = state.position - (length - state.overlap);
+            float weight = (static_cast<float>(j) + 0.5F) / 
+                           static_cast<float>(state.overlap);
+            value = value * (1.0F - weight) + 
+                    buffer[start - state.overlap + j] * weight;
+        }
+
+        //
+        //  Attenuate by 20% per 10ms after the first 10ms.
+        //
+        if (state.synthesized >= this->m_frames_10ms) {
+            float gain = 1.0F - LOSSCONCEALER_ATTENUATION * (
+                static_cast<float>(state.synthesized - this->m_frames_10ms) / 
+                frame
+            );
+            value *= (gain > 0.0F ? gain : 0.0F);
+        }
+
+        output[i] = value;
+        ++state.position;
+        ++state.synthesized;
+    }
+}
+
+/**
+ *  Begin concealing a loss: estimate the pitch period, save the pitch 
+ *  buffers and overlap-add the end of the history.
+ */
+void LossConcealer::begin_loss() noexcept {
+    size_t pitch = this->find_pitch();
+    size_t overlap = pitch / 4U;
+    size_t length = this->m_history_length;
+    float *history = this->m_history.get_samples<float>();
+    float *buffers = this->m_pitch_buffers.get_samples<float>();
+    for (size_t c = 0U; c < this->m_channel_count; ++c) {
+        float *line = history + c * this->m_history_capacity + 
+                      this->m_history_end - length;
+        float *buffer = buffers + c * length;
+        memcpy(buffer, line, length * sizeof(float));
+
+        //
+        //  The last quarter of the pitch period is not played yet (see 
+        //  get_latency()), fade it into the one preceding the last period.
+        //
+        for (size_t j = 0U; j < overlap; ++j) {
+            float weight = (static_cast<float>(j) + 0.5F) / 
+                           static_cast<float>(overlap);
+            line[length - overlap + j] = 
+                buffer[length - overlap + j] * (1.0F - weight) + 
+                buffer[length - pitch - overlap + j] * weight;
+        }
+    }
+
+    this->m_state->mode = LOSSCONCEALER_MODE_CONCEALING;
+    this->m_state->pitch = pitch;
+    this->m_state->overlap = overlap;
+    this->m_state->periods = 1U;
+    this->m_state->position = 0U;
+    this->m_state->synthesized = 0U;
+    this->m_state->recovery_length = 0U;
+    this->m_state->recovery_position = 0U;
+}
+
+/**
+ *  Estimate the pitch period of the history.
+ * 
+ *  @return
+ *      The pitch period (in frames).
+ */
+size_t LossConcealer::find_pitch() noexcept {
+    //
+    //  Mix down the channels.
+    //
+    size_t window = this->m_correlation_length;
+    size_t total = window + this->m_pitch_max;
+    const float *history = this->m_history.get_samples<float>();
+    float *mixdown = this->m_mixdown.get_samples<float>();
+    memset(mixdown, 0, total * sizeof(float));
+    for (size_t c = 0U; c < this->m_channel_count; ++c) {
+        const float *line = history + c * this->m_history_capacity + 
+                            this->m_history_end - total;
+        for (size_t i = 0U; i < total; ++i) {
+            mixdown[i] += line[i];
+        }
+    }
+
+    //
+    //  Maximize the normalized cross-correlation of the last 20ms and the 
+    //  20ms one period before, on every other lag first and then refine.
+    //
+    const float *reference = mixdown + this->m_pitch_max;
+    size_t best = this->m_pitch_max;
+    double best_score = 0.0;
+    bool found = false;
+    size_t step = 2U;
+    size_t low = this->m_pitch_min;
+    size_t high = this->m_pitch_max;
+    for (size_t pass = 0U; pass < 2U; ++pass) {
+        for (size_t lag = low; lag <= high; lag += step) {
+            const float *delayed = reference - lag;
+            double energy = static_cast<double>(
+                xap::audioio::fir_dot(delayed, delayed, window)
+            );
+            if (energy <= 0.0) {
+                continue;
+            }
+            double score = static_cast<double>(
+                xap::audioio::fir_dot(reference, delayed, window)
+            ) / sqrt(energy);
+            if (!found || score > best_score) {
+                best = lag;
+                best_score = score;
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        low = best > this->m_pitch_min ? best - 1U : best;
+        high = best < this->m_pitch_max ? best + 1U : best;
+        step = 1U;
+    }
+    return best;
+}
+
+}  //  namespace audioio
+}  //  namespace xap
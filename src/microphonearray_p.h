@@ -0,0 +1,138 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_MICROPHONEARRAY_P_H__
+#define XAP_AUDIOIO_MICROPHONEARRAY_P_H__
+
+//
+//  Imports.
+//
+#include <math.h>
+#include <stddef.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/microphonearray.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Constants.
+//
+const static double MICROPHONEARRAY_PI = 3.14159265358979323846;
+
+//
+//  Public functions.
+//
+
+/**
+ *  Validate the geometry of a microphone array.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the array has less than 2 or more than 
+ *      MICROPHONEARRAY_MAX_CHANNELS microphones, the count of microphones 
+ *      mismatched the count of channels or the speed of sound is not 
+ *      positive (xap::audioio::ERROR_PARAMETER).
+ *  @param array
+ *      The array.
+ *  @param channel_count
+ *      The count of channels of the input.
+ */
+inline void microphonearray_validate(
+    const xap::audioio::MicrophoneArray &array, 
+    size_t                               channel_count
+) {
+    if (array.channel_count < 2U || 
+        array.channel_count > xap::audioio::MICROPHONEARRAY_MAX_CHANNELS || 
+        static_cast<size_t>(array.channel_count) != channel_count || 
+        !(array.speed_of_sound > 0.0F)) {
+        throw xap::audioio::Exception(
+            "Invalid microphone array.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+}
+
+/**
+ *  Get the unit vector of a direction.
+ * 
+ *  @param azimuth
+ *      The azimuth (in degrees).
+ *  @param elevation
+ *      The elevation (in degrees).
+ *  @param vector
+ *      The unit vector (output, x, y and z).
+ */
+inline void microphonearray_get_direction(
+    double  azimuth, 
+    double  elevation, 
+    double *vector
+) noexcept {
+    double a = azimuth * MICROPHONEARRAY_PI / 180.0;
+    double e = elevation * MICROPHONEARRAY_PI / 180.0;
+    vector[0] = cos(e) * cos(a);
+    vector[1] = cos(e) * sin(a);
+    vector[2] = sin(e);
+}
+
+/**
+ *  Get the lead of the wavefront of a far-field source at a microphone over 
+ *  the origin of the array, in seconds (the audio data reaches microphones 
+ *  with larger leads earlier).
+ * 
+ *  @param array
+ *      The array.
+ *  @param channel
+ *      The microphone.
+ *  @param direction
+ *      The unit vector of the direction of the source.
+ *  @return
+ *      The lead.
+ */
+inline double microphonearray_get_lead(
+    const xap::audioio::MicrophoneArray &array, 
+    size_t                               channel, 
+    const double                        *direction
+) noexcept {
+    const xap::audioio::MicrophonePosition &p = array.positions[channel];
+    return (static_cast<double>(p.x) * direction[0] + 
+            static_cast<double>(p.y) * direction[1] + 
+            static_cast<double>(p.z) * direction[2]) / 
+           static_cast<double>(array.speed_of_sound);
+}
+
+/**
+ *  Get the largest distance between 2 microphones of an array.
+ * 
+ *  @param array
+ *      The array.
+ *  @return
+ *      The distance (in meters).
+ */
+inline double microphonearray_get_aperture(
+    const xap::audioio::MicrophoneArray &array
+) noexcept {
+    double rst = 0.0;
+    for (size_t i = 0U; i < array.channel_count; ++i) {
+        for (size_t j = i + 1U; j < array.channel_count; ++j) {
+            double dx = static_cast<double>(array.positions[i].x) - 
+                        static_cast<double>(array.positions[j].x);
+            double dy = static_cast<double>(array.positions[i].y) - 
+                        static_cast<double>(array.positions[j].y);
+            double dz = static_cast<double>(array.positions[i].z) - 
+                        static_cast<double>(array.positions[j].z);
+            double distance = sqrt(dx * dx + dy * dy + dz * dz);
+            if (distance > rst) {
+                rst = distance;
+            }
+        }
+    }
+    return rst;
+}
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_MICROPHONEARRAY_P_H__
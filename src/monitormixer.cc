@@ -0,0 +1,216 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <math.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/monitormixer.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private functions.
+//
+
+/**
+ *  Convert a gain from dB.
+ * 
+ *  @param gain
+ *      The gain (in dB).
+ *  @return
+ *      The gain (linear).
+ */
+static float from_decibels(float gain) noexcept {
+    return static_cast<float>(pow(10.0, static_cast<double>(gain) / 20.0));
+}
+
+//
+//  MonitorMixer constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if direct monitoring is enabled and the options are 
+ *      invalid, i.e. no input channel, more than MONITOR_MAX_CHANNELS 
+ *      output channels, a gain above MONITOR_MAX_GAIN or a channel map 
+ *      entry out of range (xap::audioio::ERROR_PARAMETER).
+ *  @param options
+ *      The options (the mixer does nothing if not enabled).
+ *  @param output_channel_count
+ *      The count of output channels.
+ */
+MonitorMixer::MonitorMixer(
+    const xap::audioio::MonitorOptions &options,
+    size_t                              output_channel_count
+) :
+    m_input_count(0U),
+    m_output_count(0U),
+    m_gain(0.0F),
+    m_ramp_gain(0.0F)
+{
+    for (size_t i = 0U; i < xap::audioio::MONITOR_MAX_CHANNELS; ++i) {
+        this->m_map[i] = SIZE_MAX;
+    }
+    if (!options.enabled) {
+        return;
+    }
+
+    //
+    //  Map the output channels to the input channels.
+    //
+    bool is_valid = 
+        options.channel_count != 0U && 
+        output_channel_count <= xap::audioio::MONITOR_MAX_CHANNELS && 
+        options.gain <= xap::audioio::MONITOR_MAX_GAIN;
+    size_t input_count = static_cast<size_t>(options.channel_count);
+    for (size_t i = 0U; is_valid && i < output_channel_count; ++i) {
+        int8_t entry = options.channel_map[i];
+        if (entry == xap::audioio::MONITOR_CHANNEL_DEFAULT) {
+            this->m_map[i] = i % input_count;
+        } else if (entry == xap::audioio::MONITOR_CHANNEL_NONE) {
+            this->m_map[i] = SIZE_MAX;
+        } else {
+            is_valid = entry >= 0 && 
+                       static_cast<size_t>(entry) < input_count;
+            this->m_map[i] = static_cast<size_t>(entry);
+        }
+    }
+    if (!is_valid) {
+        throw xap::audioio::Exception(
+            "The options of the monitor are invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    this->m_input_count = input_count;
+    this->m_output_count = output_channel_count;
+    this->m_ramp_gain = from_decibels(options.gain);
+    this->m_gain.store(this->m_ramp_gain);
+}
+
+/**
+ *  Destruct the object.
+ */
+MonitorMixer::~MonitorMixer() noexcept {
+    //  Do nothing.
+}
+
+//
+//  MonitorMixer public methods.
+//
+
+/**
+ *  Get whether direct monitoring is enabled.
+ * 
+ *  @return
+ *      True if enabled.
+ */
+bool MonitorMixer::is_enabled() const noexcept {
+    return this->m_input_count != 0U;
+}
+
+/**
+ *  Get the input channel played on an output channel.
+ * 
+ *  @param output_channel
+ *      The output channel.
+ *  @return
+ *      The input channel, or SIZE_MAX if the output channel plays no 
+ *      input (or direct monitoring is not enabled).
+ */
+size_t MonitorMixer::get_input_channel(size_t output_channel) const noexcept {
+    if (output_channel >= this->m_output_count) {
+        return SIZE_MAX;
+    }
+    return this->m_map[output_channel];
+}
+
+/**
+ *  Set the gain (thread-safe, lock-free, ramped over the next call of 
+ *  mix()).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              Direct monitoring is not enabled.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The gain is above MONITOR_MAX_GAIN.
+ * 
+ *  @param gain
+ *      The gain (in dB, -INFINITY to mute).
+ */
+void MonitorMixer::set_gain(float gain) {
+    if (!this->is_enabled()) {
+        throw xap::audioio::Exception(
+            "Direct monitoring is not enabled.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    if (!(gain <= xap::audioio::MONITOR_MAX_GAIN)) {
+        throw xap::audioio::Exception(
+            "The gain is invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    this->m_gain.store(from_decibels(gain), std::memory_order_relaxed);
+}
+
+/**
+ *  Mix input frames into the mix bus (the audio thread).
+ * 
+ *  @param input
+ *      The input samples (interleaved, nullptr if not available).
+ *  @param bus
+ *      The samples of the mix bus (interleaved, the output channels).
+ *  @param frame_count
+ *      The count of frames.
+ */
+void MonitorMixer::mix(
+    const int16_t  *input,
+    float          *bus,
+    size_t          frame_count
+) noexcept {
+    size_t input_count = this->m_input_count;
+    size_t output_count = this->m_output_count;
+    float target = this->m_gain.load(std::memory_order_relaxed);
+    float gain = this->m_ramp_gain;
+    this->m_ramp_gain = target;
+    if (input == nullptr || 
+        input_count == 0U || 
+        frame_count == 0U || 
+        (gain == 0.0F && target == 0.0F)) {
+        return;
+    }
+
+    //
+    //  The gain reaches the target at the last frame, the sum may exceed 
+    //  full scale (until the limiter).
+    //
+    float step = (target - gain) / static_cast<float>(frame_count);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        gain += step;
+        float scale = gain * (1.0F / 32768.0F);
+        const int16_t *source = input + i * input_count;
+        float *destination = bus + i * output_count;
+        for (size_t k = 0U; k < output_count; ++k) {
+            size_t channel = this->m_map[k];
+            if (channel != SIZE_MAX) {
+                destination[k] += static_cast<float>(source[channel]) * scale;
+            }
+        }
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
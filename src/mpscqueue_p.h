@@ -0,0 +1,204 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_MPSCQUEUE_P_H__
+#define XAP_AUDIOIO_MPSCQUEUE_P_H__
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <xap/audioio/allocator.h>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Classes.
+//
+
+/**
+ *  Bounded lock-free multi-producer, single-consumer queue of trivially 
+ *  copyable items (per-cell sequence numbers, as FrameQueue).
+ */
+template<class T>
+class MpscQueue {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The capacity is not a power of 2 (or < 2).
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param capacity
+     *      The capacity (a power of 2).
+     *  @param allocator
+     *      The allocator.
+     */
+    MpscQueue(size_t capacity, xap::audioio::IAllocator *allocator) :
+        m_enqueue_position(0U),
+        m_dequeue_position(0U),
+        m_capacity(capacity),
+        m_cells(nullptr),
+        m_allocator(allocator)
+    {
+        if (capacity < 2U || (capacity & (capacity - 1U)) != 0U) {
+            throw xap::audioio::Exception(
+                "The capacity is not a power of 2.",
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+        this->m_cells = static_cast<Cell *>(this->m_allocator->allocate(
+            sizeof(Cell) * capacity, 
+            alignof(Cell)
+        ));
+        if (this->m_cells == nullptr) {
+            throw xap::audioio::Exception(
+                "Memory allocation was failed.",
+                xap::audioio::ERROR_ALLOC
+            );
+        }
+        for (size_t i = 0U; i < capacity; ++i) {
+            Cell *cell = new (&(this->m_cells[i])) Cell();
+            cell->sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     *  Destruct the object.
+     */
+    ~MpscQueue() noexcept {
+        for (size_t i = 0U; i < this->m_capacity; ++i) {
+            this->m_cells[i].~Cell();
+        }
+        this->m_allocator->deallocate(
+            this->m_cells, 
+            sizeof(Cell) * this->m_capacity, 
+            alignof(Cell)
+        );
+    }
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Push an item (thread-safe, lock-free).
+     * 
+     *  @param item
+     *      The item.
+     *  @return
+     *      True if pushed, false if the queue is full.
+     */
+    bool try_push(const T &item) noexcept {
+        size_t mask = this->m_capacity - 1U;
+        size_t position = this->m_enqueue_position.load(
+            std::memory_order_relaxed
+        );
+        Cell *cell = nullptr;
+        while (true) {
+            cell = &(this->m_cells[position & mask]);
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - 
+                            static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (this->m_enqueue_position.compare_exchange_weak(
+                    position, 
+                    position + 1U, 
+                    std::memory_order_relaxed
+                )) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = this->m_enqueue_position.load(
+                    std::memory_order_relaxed
+                );
+            }
+        }
+
+        cell->item = item;
+        cell->sequence.store(position + 1U, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  Pop an item (the single consumer).
+     * 
+     *  @param item
+     *      The item (output).
+     *  @return
+     *      True if popped, false if the queue is empty.
+     */
+    bool try_pop(T &item) noexcept {
+        Cell *cell = 
+            &(this->m_cells[this->m_dequeue_position & (this->m_capacity - 1U)]);
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (sequence != this->m_dequeue_position + 1U) {
+            return false;
+        }
+
+        item = cell->item;
+        cell->sequence.store(
+            this->m_dequeue_position + this->m_capacity, 
+            std::memory_order_release
+        );
+        ++(this->m_dequeue_position);
+        return true;
+    }
+
+private:
+    //
+    //  Private structures.
+    //
+    struct Cell {
+        std::atomic<size_t>  sequence;
+        T                    item;
+    };
+
+    //
+    //  Constructors.
+    //
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    //
+    //  Members.
+    //
+
+    //  Shared by producers.
+    std::atomic<size_t>              m_enqueue_position;
+    uint8_t                          __pad1[56];
+
+    //  Owned by the consumer.
+    size_t                           m_dequeue_position;
+    uint8_t                          __pad2[56];
+
+    //  Read-only.
+    size_t                           m_capacity;
+    Cell                            *m_cells;
+    xap::audioio::IAllocator        *m_allocator;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_MPSCQUEUE_P_H__
@@ -0,0 +1,832 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fir_p.h"
+#include "mpscqueue_p.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/multibandcompressor.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+const static double COMPRESSOR_PI = 3.14159265358979323846;
+
+//  Quality factor of the crossover biquads (Butterworth, 1 / sqrt(2)).
+const static double COMPRESSOR_CROSSOVER_Q = 0.70710678118654752440;
+
+//  Count of frames processed per pass.
+const static size_t COMPRESSOR_BLOCK_FRAMES = 64U;
+
+//  Count of frames per gain computation (the gain is ramped in between).
+const static size_t COMPRESSOR_CONTROL_FRAMES = 16U;
+
+//  Count of channels per vector (a group).
+const static size_t COMPRESSOR_LANES = 4U;
+
+//  Count of pending parameter changes.
+const static size_t COMPRESSOR_UPDATE_CAPACITY = 64U;
+
+//  Count of coefficients of a biquad (b0, b1, b2, a1, a2).
+const static size_t COMPRESSOR_BIQUAD_COEFFICIENTS = 5U;
+
+//  Count of filters per group (2 low-pass and 2 high-pass biquads per 
+//  crossover, followed by the all-pass biquads of each band).
+const static size_t COMPRESSOR_FILTER_COUNT = 
+    4U * (COMPRESSOR_MAX_BANDS - 1U) + 
+    COMPRESSOR_MAX_BANDS * (COMPRESSOR_MAX_BANDS - 1U);
+
+//  Count of floats of the state of a filter (2 per lane).
+const static size_t COMPRESSOR_FILTER_STATE = 2U * COMPRESSOR_LANES;
+
+//  Filter and envelope states below this magnitude are flushed to zero 
+//  (avoid denormals on silence).
+const static float COMPRESSOR_FLUSH_LEVEL = 1e-20F;
+
+//  Envelopes below this level are treated as -200dBFS.
+const static float COMPRESSOR_FLOOR_LEVEL = 1e-10F;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Pending parameter change.
+ */
+struct CompressorUpdate_ {
+    //  The index of the band.
+    size_t                        band;
+
+    //  The parameters.
+    xap::audioio::CompressorBand  parameters;
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Check the parameters of a band.
+ * 
+ *  @param parameters
+ *      The parameters.
+ *  @return
+ *      True if valid.
+ */
+static bool is_valid_band(
+    const xap::audioio::CompressorBand &parameters
+) noexcept {
+    return parameters.threshold <= 0.0F && 
+           parameters.threshold >= -200.0F && 
+           parameters.ratio >= 1.0F && 
+           parameters.ratio <= 1000.0F && 
+           parameters.attack > 0.0F && 
+           parameters.release > 0.0F && 
+           parameters.knee >= 0.0F && 
+           parameters.knee <= 48.0F && 
+           fabsf(parameters.makeup) <= 48.0F;
+}
+
+/**
+ *  Get the coefficient of a one-pole smoother.
+ * 
+ *  @param time
+ *      The time constant (in milliseconds).
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The coefficient.
+ */
+static float get_smoothing_coefficient(
+    float     time,
+    uint32_t  sample_rate
+) noexcept {
+    return static_cast<float>(1.0 - exp(
+        -1000.0 / (static_cast<double>(time) * static_cast<double>(sample_rate))
+    ));
+}
+
+/**
+ *  Design the biquads of a crossover (Butterworth low-pass and high-pass, 
+ *  cascaded twice for Linkwitz-Riley, and the all-pass response of their 
+ *  sum).
+ * 
+ *  @param frequency
+ *      The crossover frequency.
+ *  @param sample_rate
+ *      The sample rate.
+ *  @param coefficients
+ *      The coefficients (output, low-pass, high-pass and all-pass).
+ */
+static void design_crossover(
+    float      frequency,
+    uint32_t   sample_rate,
+    float     *coefficients
+) noexcept {
+    double w0 = 2.0 * COMPRESSOR_PI * static_cast<double>(frequency) / 
+                static_cast<double>(sample_rate);
+    double c = cos(w0);
+    double alpha = sin(w0) / (2.0 * COMPRESSOR_CROSSOVER_Q);
+    double a0 = 1.0 + alpha;
+    double values[3][5] = {
+        {(1.0 - c) / 2.0, 1.0 - c, (1.0 - c) / 2.0, -2.0 * c, 1.0 - alpha},
+        {(1.0 + c) / 2.0, -(1.0 + c), (1.0 + c) / 2.0, -2.0 * c, 1.0 - alpha},
+        {1.0 - alpha, -2.0 * c, 1.0 + alpha, -2.0 * c, 1.0 - alpha}
+    };
+    for (size_t i = 0U; i < 3U; ++i) {
+        for (size_t k = 0U; k < COMPRESSOR_BIQUAD_COEFFICIENTS; ++k) {
+            coefficients[i * COMPRESSOR_BIQUAD_COEFFICIENTS + k] = 
+                static_cast<float>(values[i][k] / a0);
+        }
+    }
+}
+
+/**
+ *  Filter 4 lanes by a biquad (transposed direct form II).
+ * 
+ *  @param input
+ *      The input (4 lanes per frame).
+ *  @param output
+ *      The output (4 lanes per frame, may be the input).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param coefficients
+ *      The coefficients.
+ *  @param state
+ *      The state (2 per lane).
+ */
+static void filter(
+    const float  *input,
+    float        *output,
+    size_t        frame_count,
+    const float  *coefficients,
+    float        *state
+) noexcept {
+#if defined(__SSE2__)
+    const __m128 b0 = _mm_set1_ps(coefficients[0]);
+    const __m128 b1 = _mm_set1_ps(coefficients[1]);
+    const __m128 b2 = _mm_set1_ps(coefficients[2]);
+    const __m128 a1 = _mm_set1_ps(coefficients[3]);
+    const __m128 a2 = _mm_set1_ps(coefficients[4]);
+    __m128 s1 = _mm_loadu_ps(state);
+    __m128 s2 = _mm_loadu_ps(state + COMPRESSOR_LANES);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        __m128 x = _mm_loadu_ps(input + i * COMPRESSOR_LANES);
+        __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+        s1 = _mm_add_ps(
+            _mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)),
+            s2
+        );
+        s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_storeu_ps(output + i * COMPRESSOR_LANES, y);
+    }
+    _mm_storeu_ps(state, s1);
+    _mm_storeu_ps(state + COMPRESSOR_LANES, s2);
+#else
+    float *s1 = state;
+    float *s2 = state + COMPRESSOR_LANES;
+    for (size_t i = 0U; i < frame_count; ++i) {
+        for (size_t k = 0U; k < COMPRESSOR_LANES; ++k) {
+            float x = input[i * COMPRESSOR_LANES + k];
+            float y = coefficients[0] * x + s1[k];
+            s1[k] = coefficients[1] * x - coefficients[3] * y + s2[k];
+            s2[k] = coefficients[2] * x - coefficients[4] * y;
+            output[i * COMPRESSOR_LANES + k] = y;
+        }
+    }
+#endif
+}
+
+/**
+ *  Follow the peak envelope of 4 lanes.
+ * 
+ *  @param input
+ *      The input (4 lanes per frame).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param attack
+ *      The attack coefficient.
+ *  @param release
+ *      The release coefficient.
+ *  @param envelope
+ *      The envelope of each lane (in place).
+ */
+static void follow(
+    const float  *input,
+    size_t        frame_count,
+    float         attack,
+    float         release,
+    float        *envelope
+) noexcept {
+#if defined(__SSE2__)
+    const __m128 magnitude_mask = 
+        _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 attacks = _mm_set1_ps(attack);
+    const __m128 releases = _mm_set1_ps(release);
+    __m128 values = _mm_loadu_ps(envelope);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        __m128 magnitudes = _mm_and_ps(
+            _mm_loadu_ps(input + i * COMPRESSOR_LANES),
+            magnitude_mask
+        );
+        __m128 rising = _mm_cmpgt_ps(magnitudes, values);
+        __m128 coefficients = _mm_or_ps(
+            _mm_and_ps(rising, attacks),
+            _mm_andnot_ps(rising, releases)
+        );
+        values = _mm_add_ps(
+            values,
+            _mm_mul_ps(coefficients, _mm_sub_ps(magnitudes, values))
+        );
+    }
+    _mm_storeu_ps(envelope, values);
+#else
+    for (size_t i = 0U; i < frame_count; ++i) {
+        for (size_t k = 0U; k < COMPRESSOR_LANES; ++k) {
+            float magnitude = fabsf(input[i * COMPRESSOR_LANES + k]);
+            float coefficient = magnitude > envelope[k] ? attack : release;
+            envelope[k] += coefficient * (magnitude - envelope[k]);
+        }
+    }
+#endif
+}
+
+/**
+ *  Compute the gain reduction of an envelope (soft knee).
+ * 
+ *  @param envelope
+ *      The envelope.
+ *  @param parameters
+ *      The parameters of the band.
+ *  @return
+ *      The gain reduction (in dB, not less than 0).
+ */
+static float compute_reduction(
+    float                                 envelope,
+    const xap::audioio::CompressorBand   &parameters
+) noexcept {
+    float level = 20.0F * log10f(std::max(envelope, COMPRESSOR_FLOOR_LEVEL));
+    float over = level - parameters.threshold;
+    float slope = 1.0F - 1.0F / parameters.ratio;
+    float knee = parameters.knee;
+    if (2.0F * over <= -knee) {
+        return 0.0F;
+    }
+    if (2.0F * over < knee) {
+        float x = over + 0.5F * knee;
+        return slope * x * x / (2.0F * knee);
+    }
+    return slope * over;
+}
+
+/**
+ *  Apply a gain ramp to 4 lanes and add them to the sum.
+ * 
+ *  @param input
+ *      The input (4 lanes per frame).
+ *  @param frame_count
+ *      The count of frames.
+ *  @param gain
+ *      The gain of each lane (in place, ramped to the target).
+ *  @param target
+ *      The target gain of each lane.
+ *  @param sum
+ *      The sum (4 lanes per frame, in place).
+ */
+static void apply_gain(
+    const float  *input,
+    size_t        frame_count,
+    float        *gain,
+    const float  *target,
+    float        *sum
+) noexcept {
+    float scale = 1.0F / static_cast<float>(frame_count);
+#if defined(__SSE2__)
+    __m128 gains = _mm_loadu_ps(gain);
+    __m128 targets = _mm_loadu_ps(target);
+    __m128 steps = _mm_mul_ps(_mm_sub_ps(targets, gains), _mm_set1_ps(scale));
+    for (size_t i = 0U; i < frame_count; ++i) {
+        gains = _mm_add_ps(gains, steps);
+        __m128 values = _mm_mul_ps(
+            _mm_loadu_ps(input + i * COMPRESSOR_LANES),
+            gains
+        );
+        _mm_storeu_ps(
+            sum + i * COMPRESSOR_LANES,
+            _mm_add_ps(_mm_loadu_ps(sum + i * COMPRESSOR_LANES), values)
+        );
+    }
+    _mm_storeu_ps(gain, targets);
+#else
+    for (size_t k = 0U; k < COMPRESSOR_LANES; ++k) {
+        float step = (target[k] - gain[k]) * scale;
+        float value = gain[k];
+        for (size_t i = 0U; i < frame_count; ++i) {
+            value += step;
+            sum[i * COMPRESSOR_LANES + k] += input[i * COMPRESSOR_LANES + k] * 
+                                             value;
+        }
+        gain[k] = target[k];
+    }
+#endif
+}
+
+/**
+ *  Flush tiny values to zero.
+ * 
+ *  @param values
+ *      The values (in place).
+ *  @param count
+ *      The count of values.
+ */
+static void flush(float *values, size_t count) noexcept {
+    for (size_t i = 0U; i < count; ++i) {
+        if (fabsf(values[i]) < COMPRESSOR_FLUSH_LEVEL) {
+            values[i] = 0.0F;
+        }
+    }
+}
+
+//
+//  MultibandCompressor constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format is not 16-bit or 32-bit float, or the options 
+ *              are invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param format
+ *      The format of the audio data.
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+MultibandCompressor::MultibandCompressor(
+    const xap::audioio::AudioFormat                   &format,
+    const xap::audioio::MultibandCompressorOptions    &options,
+    xap::audioio::IAllocator                          *allocator
+) :
+    m_format(format),
+    m_channel_count(static_cast<size_t>(format.channel_count)),
+    m_group_count(
+        (static_cast<size_t>(format.channel_count) + COMPRESSOR_LANES - 1U) / 
+        COMPRESSOR_LANES
+    ),
+    m_band_count(static_cast<size_t>(options.band_count)),
+    m_states(),
+    m_envelopes(),
+    m_gains(),
+    m_lanes(),
+    m_block(),
+    m_updates(nullptr)
+{
+    if ((format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        format.channel_count == 0U || 
+        format.sample_rate == 0U) {
+        throw xap::audioio::Exception(
+            "The format of the audio data is invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    bool is_valid = 
+        this->m_band_count >= COMPRESSOR_MIN_BANDS && 
+        this->m_band_count <= COMPRESSOR_MAX_BANDS;
+    float nyquist = 0.5F * static_cast<float>(format.sample_rate);
+    for (size_t i = 0U; is_valid && i + 1U < this->m_band_count; ++i) {
+        float previous = i == 0U ? 0.0F : options.crossovers[i - 1U];
+        is_valid = options.crossovers[i] > previous && 
+                   options.crossovers[i] < nyquist;
+    }
+    for (size_t i = 0U; is_valid && i < this->m_band_count; ++i) {
+        is_valid = is_valid_band(options.bands[i]);
+    }
+    if (!is_valid) {
+        throw xap::audioio::Exception(
+            "The options are invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+
+    for (size_t i = 0U; i < COMPRESSOR_MAX_BANDS; ++i) {
+        this->m_bands[i] = options.bands[i];
+        this->m_attacks[i] = get_smoothing_coefficient(
+            options.bands[i].attack,
+            format.sample_rate
+        );
+        this->m_releases[i] = get_smoothing_coefficient(
+            options.bands[i].release,
+            format.sample_rate
+        );
+        this->m_reductions[i].store(0.0F, std::memory_order_relaxed);
+    }
+    for (size_t i = 0U; i + 1U < this->m_band_count; ++i) {
+        design_crossover(
+            options.crossovers[i],
+            format.sample_rate,
+            this->m_coefficients + i * 3U * COMPRESSOR_BIQUAD_COEFFICIENTS
+        );
+    }
+
+    //
+    //  Filter states, envelopes and gains (of each group), the lanes of 
+    //  each band followed by the sum, and the block converted from 16-bit.
+    //
+    xap::audioio::AudioFormat state_format;
+    state_format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    state_format.channel_count = 1U;
+    state_format.sample_rate = format.sample_rate;
+    this->m_states = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        this->m_group_count * COMPRESSOR_FILTER_COUNT * COMPRESSOR_FILTER_STATE,
+        allocator
+    );
+    this->m_envelopes = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        this->m_group_count * COMPRESSOR_MAX_BANDS * COMPRESSOR_LANES,
+        allocator
+    );
+    this->m_gains = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        this->m_group_count * COMPRESSOR_MAX_BANDS * COMPRESSOR_LANES,
+        allocator
+    );
+    this->m_lanes = xap::audioio::AudioBuffer::allocate(
+        state_format,
+        (COMPRESSOR_MAX_BANDS + 1U) * COMPRESSOR_BLOCK_FRAMES * 
+            COMPRESSOR_LANES,
+        allocator
+    );
+    if (format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+        state_format.channel_count = format.channel_count;
+        this->m_block = xap::audioio::AudioBuffer::allocate(
+            state_format,
+            COMPRESSOR_BLOCK_FRAMES,
+            allocator
+        );
+    }
+    this->m_updates = xap::audioio::new_object<
+        xap::audioio::MpscQueue<struct xap::audioio::CompressorUpdate_>
+    >(allocator, COMPRESSOR_UPDATE_CAPACITY, allocator);
+
+    this->reset();
+}
+
+/**
+ *  Destruct the object.
+ */
+MultibandCompressor::~MultibandCompressor() noexcept {
+    this->m_updates->~MpscQueue<struct xap::audioio::CompressorUpdate_>();
+    xap::audioio::free_object(this->m_updates);
+}
+
+//
+//  MultibandCompressor public methods.
+//
+
+/**
+ *  Process audio data (in place).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the audio data mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param data
+ *      The audio data.
+ */
+void MultibandCompressor::process(xap::audioio::AudioBuffer &data) {
+    if (data.get_sample_format() != this->m_format.sample_format || 
+        data.get_channel_count() != this->m_format.channel_count || 
+        data.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the audio data mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    this->apply_updates();
+
+    size_t channel_count = this->m_channel_count;
+    size_t frame_count = data.get_frame_count();
+    if (this->m_format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+        int16_t *samples = data.get_samples<int16_t>();
+        float *block = this->m_block.get_samples<float>();
+        for (size_t offset = 0U;
+             offset < frame_count;
+             offset += COMPRESSOR_BLOCK_FRAMES) {
+            size_t count = std::min(
+                COMPRESSOR_BLOCK_FRAMES,
+                frame_count - offset
+            );
+            int16_t *source = samples + offset * channel_count;
+            size_t sample_count = count * channel_count;
+            for (size_t i = 0U; i < sample_count; ++i) {
+                block[i] = static_cast<float>(source[i]) * (1.0F / 32768.0F);
+            }
+            this->compress(block, count);
+            for (size_t i = 0U; i < sample_count; ++i) {
+                source[i] = xap::audioio::fir_saturate_int16(
+                    block[i] * 32768.0F
+                );
+            }
+        }
+    } else {
+        float *samples = data.get_samples<float>();
+        for (size_t offset = 0U;
+             offset < frame_count;
+             offset += COMPRESSOR_BLOCK_FRAMES) {
+            this->compress(
+                samples + offset * channel_count,
+                std::min(COMPRESSOR_BLOCK_FRAMES, frame_count - offset)
+            );
+        }
+    }
+}
+
+/**
+ *  Change the parameters of a band (thread-safe, lock-free, applied at 
+ *  the next call of process()).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The band or the parameters are invalid.
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              Too many changes are pending.
+ * 
+ *  @param band
+ *      The index of the band (0 for the lowest band).
+ *  @param parameters
+ *      The parameters.
+ */
+void MultibandCompressor::set_band(
+    size_t                                band,
+    const xap::audioio::CompressorBand   &parameters
+) {
+    if (band >= this->m_band_count || !is_valid_band(parameters)) {
+        throw xap::audioio::Exception(
+            "The band or the parameters are invalid.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    struct xap::audioio::CompressorUpdate_ update;
+    update.band = band;
+    update.parameters = parameters;
+    if (!this->m_updates->try_push(update)) {
+        throw xap::audioio::Exception(
+            "Too many changes are pending.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+}
+
+/**
+ *  Get the gain reduction of a band (thread-safe, the largest over all 
+ *  channels at the end of the last call of process()).
+ * 
+ *  @param band
+ *      The index of the band.
+ *  @return
+ *      The gain reduction (in dB, not less than 0, excluding the make-up 
+ *      gain).
+ */
+float MultibandCompressor::get_gain_reduction(size_t band) const noexcept {
+    if (band >= this->m_band_count) {
+        return 0.0F;
+    }
+    return this->m_reductions[band].load(std::memory_order_relaxed);
+}
+
+/**
+ *  Reset (clear the filters and the envelopes).
+ */
+void MultibandCompressor::reset() noexcept {
+    memset(this->m_states.get_pointer(), 0, this->m_states.get_length());
+    memset(this->m_envelopes.get_pointer(), 0, this->m_envelopes.get_length());
+    float *gains = this->m_gains.get_samples<float>();
+    for (size_t group = 0U; group < this->m_group_count; ++group) {
+        for (size_t band = 0U; band < COMPRESSOR_MAX_BANDS; ++band) {
+            float makeup = static_cast<float>(pow(
+                10.0,
+                static_cast<double>(this->m_bands[band].makeup) / 20.0
+            ));
+            std::fill_n(
+                gains + (group * COMPRESSOR_MAX_BANDS + band) * 
+                    COMPRESSOR_LANES,
+                COMPRESSOR_LANES,
+                makeup
+            );
+        }
+    }
+    for (size_t i = 0U; i < COMPRESSOR_MAX_BANDS; ++i) {
+        this->m_reductions[i].store(0.0F, std::memory_order_relaxed);
+    }
+}
+
+//
+//  MultibandCompressor private methods.
+//
+
+/**
+ *  Apply the pending parameter changes.
+ */
+void MultibandCompressor::apply_updates() noexcept {
+    struct xap::audioio::CompressorUpdate_ update;
+    while (this->m_updates->try_pop(update)) {
+        this->m_bands[update.band] = update.parameters;
+        this->m_attacks[update.band] = get_smoothing_coefficient(
+            update.parameters.attack,
+            this->m_format.sample_rate
+        );
+        this->m_releases[update.band] = get_smoothing_coefficient(
+            update.parameters.release,
+            this->m_format.sample_rate
+        );
+    }
+}
+
+/**
+ *  Compress one block of 32-bit float audio data.
+ * 
+ *  @param samples
+ *      The samples (interleaved, in place).
+ *  @param frame_count
+ *      The count of frames (at most the block size).
+ */
+void MultibandCompressor::compress(
+    float   *samples,
+    size_t   frame_count
+) noexcept {
+    size_t channel_count = this->m_channel_count;
+    size_t band_count = this->m_band_count;
+    size_t lane_size = COMPRESSOR_BLOCK_FRAMES * COMPRESSOR_LANES;
+    float *lanes = this->m_lanes.get_samples<float>();
+    float *sum = lanes + COMPRESSOR_MAX_BANDS * lane_size;
+    float *rest = lanes + (band_count - 1U) * lane_size;
+    float reductions[COMPRESSOR_MAX_BANDS] = {0.0F};
+
+    for (size_t group = 0U; group < this->m_group_count; ++group) {
+        size_t first = group * COMPRESSOR_LANES;
+        size_t lane_count = std::min(COMPRESSOR_LANES, channel_count - first);
+        float *states = this->m_states.get_samples<float>() + 
+                        group * COMPRESSOR_FILTER_COUNT * 
+                        COMPRESSOR_FILTER_STATE;
+        float *envelopes = this->m_envelopes.get_samples<float>() + 
+                           group * COMPRESSOR_MAX_BANDS * COMPRESSOR_LANES;
+        float *gains = this->m_gains.get_samples<float>() + 
+                       group * COMPRESSOR_MAX_BANDS * COMPRESSOR_LANES;
+
+        //
+        //  Deinterleave (unused lanes are silent).
+        //
+        for (size_t i = 0U; i < frame_count; ++i) {
+            const float *frame = samples + i * channel_count + first;
+            float *lane = rest + i * COMPRESSOR_LANES;
+            for (size_t k = 0U; k < COMPRESSOR_LANES; ++k) {
+                lane[k] = k < lane_count ? frame[k] : 0.0F;
+            }
+        }
+
+        //
+        //  Split: each crossover takes its low band off the rest, then the 
+        //  lower bands are aligned in phase with the higher crossovers.
+        //
+        for (size_t i = 0U; i + 1U < band_count; ++i) {
+            const float *coefficients = 
+                this->m_coefficients + i * 3U * COMPRESSOR_BIQUAD_COEFFICIENTS;
+            float *state = states + 4U * i * COMPRESSOR_FILTER_STATE;
+            float *band = lanes + i * lane_size;
+            filter(rest, band, frame_count, coefficients, state);
+            filter(
+                band,
+                band,
+                frame_count,
+                coefficients,
+                state + COMPRESSOR_FILTER_STATE
+            );
+            coefficients += COMPRESSOR_BIQUAD_COEFFICIENTS;
+            state += 2U * COMPRESSOR_FILTER_STATE;
+            filter(rest, rest, frame_count, coefficients, state);
+            filter(
+                rest,
+                rest,
+                frame_count,
+                coefficients,
+                state + COMPRESSOR_FILTER_STATE
+            );
+        }
+        for (size_t i = 0U; i + 2U < band_count; ++i) {
+            float *band = lanes + i * lane_size;
+            for (size_t k = i + 1U; k + 1U < band_count; ++k) {
+                filter(
+                    band,
+                    band,
+                    frame_count,
+                    this->m_coefficients + 
+                        (3U * k + 2U) * COMPRESSOR_BIQUAD_COEFFICIENTS,
+                    states + (
+                        4U * (COMPRESSOR_MAX_BANDS - 1U) + 
+                        i * (COMPRESSOR_MAX_BANDS - 1U) + k
+                    ) * COMPRESSOR_FILTER_STATE
+                );
+            }
+        }
+
+        //
+        //  Follow the envelopes, compute the gains at the control rate and 
+        //  sum the bands up.
+        //
+        std::fill_n(sum, frame_count * COMPRESSOR_LANES, 0.0F);
+        for (size_t i = 0U; i < band_count; ++i) {
+            const xap::audioio::CompressorBand &parameters = this->m_bands[i];
+            float makeup = parameters.makeup;
+            float *band = lanes + i * lane_size;
+            float *envelope = envelopes + i * COMPRESSOR_LANES;
+            float *gain = gains + i * COMPRESSOR_LANES;
+            float reduction[COMPRESSOR_LANES] = {0.0F};
+            for (size_t offset = 0U;
+                 offset < frame_count;
+                 offset += COMPRESSOR_CONTROL_FRAMES) {
+                size_t count = std::min(
+                    COMPRESSOR_CONTROL_FRAMES,
+                    frame_count - offset
+                );
+                const float *input = band + offset * COMPRESSOR_LANES;
+                follow(
+                    input,
+                    count,
+                    this->m_attacks[i],
+                    this->m_releases[i],
+                    envelope
+                );
+                float target[COMPRESSOR_LANES];
+                for (size_t k = 0U; k < COMPRESSOR_LANES; ++k) {
+                    reduction[k] = compute_reduction(envelope[k], parameters);
+                    target[k] = powf(10.0F, (makeup - reduction[k]) / 20.0F);
+                }
+                apply_gain(
+                    input,
+                    count,
+                    gain,
+                    target,
+                    sum + offset * COMPRESSOR_LANES
+                );
+            }
+            for (size_t k = 0U; k < lane_count; ++k) {
+                reductions[i] = std::max(reductions[i], reduction[k]);
+            }
+        }
+
+        //
+        //  Interleave.
+        //
+        for (size_t i = 0U; i < frame_count; ++i) {
+            float *frame = samples + i * channel_count + first;
+            const float *lane = sum + i * COMPRESSOR_LANES;
+            for (size_t k = 0U; k < lane_count; ++k) {
+                frame[k] = lane[k];
+            }
+        }
+
+        flush(states, COMPRESSOR_FILTER_COUNT * COMPRESSOR_FILTER_STATE);
+        flush(envelopes, COMPRESSOR_MAX_BANDS * COMPRESSOR_LANES);
+    }
+
+    for (size_t i = 0U; i < band_count; ++i) {
+        this->m_reductions[i].store(reductions[i], std::memory_order_relaxed);
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
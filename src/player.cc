@@ -7,14 +7,71 @@
 //
 //  Imports.
 //
+#include "allocator_p.h"
 #include "error_p.h"
+#include "fir_p.h"
 #include "player_p.h"
 
+#include <algorithm>
+#include <string.h>
 #include <xap/audioio/player.h>
 
 namespace xap {
 namespace audioio {
 
+//
+//  Private functions.
+//
+
+/**
+ *  Build the format of the audio data played.
+ * 
+ *  @param options
+ *      The player options.
+ *  @return
+ *      The format (16-bit).
+ */
+static xap::audioio::AudioFormat build_output_format(
+    const xap::audioio::PlayerOptions &options
+) noexcept {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = options.channel_count;
+    format.sample_rate = static_cast<uint32_t>(options.sample_rate);
+    return format;
+}
+
+/**
+ *  Build the format of the mix bus (the limiter).
+ * 
+ *  @param options
+ *      The player options.
+ *  @return
+ *      The format (32-bit float).
+ */
+static xap::audioio::AudioFormat build_mix_format(
+    const xap::audioio::PlayerOptions &options
+) noexcept {
+    xap::audioio::AudioFormat format = build_output_format(options);
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    return format;
+}
+
+/**
+ *  Get whether the player needs the 32-bit float mix bus, i.e. the input is 
+ *  monitored or the limiter changes the audio data (otherwise the limiter 
+ *  only scans the 16-bit output for clips).
+ * 
+ *  @param options
+ *      The player options.
+ *  @return
+ *      True if so.
+ */
+static bool has_mix_bus(const xap::audioio::PlayerOptions &options) noexcept {
+    return options.monitor.enabled || 
+           options.limiter.mode != xap::audioio::LIMITERMODE_NONE;
+}
+
 //
 //  Player constructor & destructor.
 //
@@ -28,21 +85,101 @@ namespace audioio {
  *          - xap::audioio::ERROR_UNSUPPORTED:
  *              Player cannot supported this format.
  * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The options of the limiter, of the monitor or of the frame pool 
+ *              are invalid.
+ * 
  *          - xap::audioio::ERROR_PORTAUDIOCALL:
  *              PortAudio calling occurred error.
  * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
  *  @param options
  *      The player options.
+ *  @param allocator
+ *      The allocator.
  */
-Player::Player(const xap::audioio::PlayerOptions &options) :
+Player::Player(
+    const xap::audioio::PlayerOptions &options,
+    xap::audioio::IAllocator          *allocator
+) :
     m_audio_callback(),
     m_audio_callback_lock(),
+    m_frame_callback(),
+    m_frame_callback_lock(),
     m_error_callback(),
     m_error_callback_lock(),
     m_options(options),
     m_stream(nullptr),
-    m_is_running(false) 
+    m_is_running(false),
+    m_is_paused(false),
+    m_frame_size(static_cast<size_t>(options.channel_count) * 2U),  //  16-bit
+    m_preroll(xap::audioio::StlAllocator<uint8_t>(allocator)),
+    m_preroll_offset(0U),
+    m_start_time(0.0),
+    m_is_first_output(false),
+    m_primed_frames(0U),
+    m_first_dac_time(0.0),
+    m_has_first_dac_time(false),
+    m_has_frame_callback(false),
+    m_max_block_frames(
+        options.frame_pre_buffer != 0U ? 
+            options.frame_pre_buffer : 
+            xap::audioio::PLAYER_DEFAULT_BLOCK_FRAMES
+    ),
+    m_pool(
+        m_max_block_frames * m_frame_size, 
+        options.frame_pool_blocks, 
+        allocator
+    ),
+    m_audio_buffer(),
+    m_audio_offset(0U),
+    m_source(),
+    m_stages(
+        xap::audioio::StlAllocator<std::shared_ptr<xap::audioio::IStage>>(
+            allocator
+        )
+    ),
+    m_position(0),
+    m_has_mix_bus(has_mix_bus(options)),
+    m_mix(
+        m_has_mix_bus ? 
+            xap::audioio::AudioBuffer::allocate(
+                build_mix_format(options), 
+                m_max_block_frames, 
+                allocator
+            ) : 
+            xap::audioio::AudioBuffer()
+    ),
+    m_limiter(
+        m_has_mix_bus ? 
+            build_mix_format(options) : 
+            build_output_format(options), 
+        options.limiter, 
+        allocator
+    ),
+    m_monitor(options.monitor, static_cast<size_t>(options.channel_count))
 {
+    const xap::audioio::MonitorOptions &monitor = options.monitor;
+
+    //
+    //  Preallocate the audio callback buffer (one block, never reallocated 
+    //  in the callback, see m_audio_offset).
+    //
+    try {
+        this->m_audio_buffer = xap::core::buffer::Buffer(
+            this->m_max_block_frames * this->m_frame_size, 
+            false
+        );
+        this->m_audio_offset = this->m_audio_buffer.get_length();
+    } catch (xap::core::buffer::BufferException &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+
     //
     //  Initialzie PortAudio.
     //
@@ -58,8 +195,15 @@ Player::Player(const xap::audioio::PlayerOptions &options) :
     stream_parameters.sampleFormat = paInt16;
     stream_parameters.hostApiSpecificStreamInfo = nullptr;
 
+    PaStreamParameters input_parameters;
+    input_parameters.device = static_cast<int>(monitor.device.device_id);
+    input_parameters.channelCount = static_cast<int>(monitor.channel_count);
+    input_parameters.suggestedLatency = monitor.device.default_low_latency;
+    input_parameters.sampleFormat = paInt16;
+    input_parameters.hostApiSpecificStreamInfo = nullptr;
+
     PaError error = Pa_IsFormatSupported(
-        nullptr,
+        monitor.enabled ? &input_parameters : nullptr,
         &stream_parameters,
         static_cast<double>(options.sample_rate)
     );
@@ -75,11 +219,12 @@ Player::Player(const xap::audioio::PlayerOptions &options) :
     //
     xap::audioio::pacall_assert(Pa_OpenStream(
         &(this->m_stream),
-        nullptr,
+        monitor.enabled ? &input_parameters : nullptr,
         &stream_parameters,
         static_cast<double>(options.sample_rate),
         static_cast<unsigned long>(options.frame_pre_buffer),
-        paNoFlag,
+        options.prime_output_buffers ? 
+            paPrimeOutputBuffersUsingStreamCallback : paNoFlag,
         xap_pa_play_callback,
         static_cast<void *>(this)
     ));
@@ -101,6 +246,52 @@ Player::~Player() noexcept {
     Pa_Terminate();
 }
 
+/**
+ *  Allocate the memory of the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed 
+ *      (xap::audioio::ERROR_ALLOC).
+ *  @param size
+ *      The size of the object.
+ *  @param allocator
+ *      The allocator.
+ *  @return
+ *      The memory.
+ */
+void *Player::operator new(
+    size_t                     size, 
+    xap::audioio::IAllocator  *allocator
+) {
+    return xap::audioio::allocate_object(allocator, size);
+}
+
+/**
+ *  Release the memory of the object (allocated by operator new).
+ * 
+ *  @param pointer
+ *      The memory.
+ */
+void Player::operator delete(void *pointer) noexcept {
+    xap::audioio::free_object(pointer);
+}
+
+/**
+ *  Release the memory of the object if its constructor raised.
+ * 
+ *  @param pointer
+ *      The memory.
+ *  @param allocator
+ *      The allocator.
+ */
+void Player::operator delete(
+    void                      *pointer, 
+    xap::audioio::IAllocator  *allocator
+) noexcept {
+    (void)allocator;
+    xap::audioio::free_object(pointer);
+}
+
 //
 //  Player public methods.
 //
@@ -125,6 +316,18 @@ void Player::start() {
         );
     }
 
+    this->m_is_paused.store(false);
+    this->m_has_first_dac_time.store(false);
+    this->m_is_first_output = true;
+    this->m_primed_frames = 0U;
+    this->m_position = 0;
+    this->m_audio_offset = this->m_audio_buffer.get_length();
+
+    //  The reference is taken before the stream starts so that the start-up 
+    //  latency of the stream is measured (the callbacks priming the output 
+    //  buffers may be invoked before Pa_StartStream() returned).
+    this->m_start_time = Pa_GetStreamTime(this->m_stream);
+
     xap::audioio::pacall_assert(Pa_StartStream(this->m_stream));
 
     this->m_is_running = true; 
@@ -157,6 +360,106 @@ void Player::set_audio_callback(
     }
 }
 
+/**
+ *  Set frame callback.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if system (lock) calling occurred error. 
+ *      (xap::audioio::ERROR_SYSTEMCALL)
+ *  @param callback
+ *      The callback.
+ */
+void Player::set_frame_callback(
+    std::function <void(xap::audioio::AudioBuffer &)> &callback
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_frame_callback_lock);
+
+        this->m_frame_callback = callback;
+        this->m_has_frame_callback.store(static_cast<bool>(callback));
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Set audio source.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the player is running 
+ *      (xap::audioio::ERROR_INVALIDOPERATION).
+ *  @param source
+ *      The source (nullptr to remove the source).
+ */
+void Player::set_source(
+    const std::shared_ptr<xap::audioio::ISource> &source
+) {
+    if (this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The player is running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    this->m_source = source;
+}
+
+/**
+ *  Append a processing stage.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The player is running.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The stage is nullptr.
+ * 
+ *  @param stage
+ *      The stage.
+ */
+void Player::add_stage(const std::shared_ptr<xap::audioio::IStage> &stage) {
+    if (this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The player is running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    if (!stage) {
+        throw xap::audioio::Exception(
+            "The stage is null.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    this->m_stages.push_back(stage);
+}
+
+/**
+ *  Remove all processing stages.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the player is running 
+ *      (xap::audioio::ERROR_INVALIDOPERATION).
+ */
+void Player::clear_stages() {
+    if (this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The player is running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    this->m_stages.clear();
+}
+
 /**
  *  Set error callback.
  * 
@@ -213,6 +516,180 @@ void Player::stop(bool forcibly) {
     }
 
     this->m_is_running = false;
+    this->m_is_paused.store(false);
+
+    //  Drop the pre-rolled audio data which was not played.
+    this->m_preroll.clear();
+    this->m_preroll_offset = 0U;
+}
+
+/**
+ *  Pause player.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The player is not running or was already paused.
+ */
+void Player::pause() {
+    if (!this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The player is not running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    bool expected = false;
+    if (!this->m_is_paused.compare_exchange_strong(expected, true)) {
+        throw xap::audioio::Exception(
+            "The player was already paused.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+}
+
+/**
+ *  Resume player.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The player is not running or is not paused.
+ */
+void Player::resume() {
+    if (!this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The player is not running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    bool expected = true;
+    if (!this->m_is_paused.compare_exchange_strong(expected, false)) {
+        throw xap::audioio::Exception(
+            "The player is not paused.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+}
+
+/**
+ *  Get whether the player is paused.
+ * 
+ *  @return
+ *      True if paused.
+ */
+bool Player::is_paused() const noexcept {
+    return this->m_is_paused.load();
+}
+
+/**
+ *  Pre-roll audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The player was already running.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The length of the data is not a multiple of frame size.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param data
+ *      The audio data.
+ */
+void Player::preroll(xap::core::buffer::Buffer &data) {
+    if (this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The player was already running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    if (data.get_length() % this->m_frame_size != 0U) {
+        throw xap::audioio::Exception(
+            "The length of the data is not a multiple of frame size.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    try {
+        const uint8_t *pointer = data.get_pointer();
+        this->m_preroll.insert(
+            this->m_preroll.end(), 
+            pointer, 
+            pointer + data.get_length()
+        );
+    } catch (std::bad_alloc &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+}
+
+/**
+ *  Get the time to first sample of the last start.
+ * 
+ *  @return
+ *      The time (in seconds), or a negative value if the first sample was 
+ *      not output yet.
+ */
+double Player::get_time_to_first_sample() const noexcept {
+    if (!this->m_has_first_dac_time.load(std::memory_order_acquire)) {
+        return -1.0;
+    }
+
+    //  The limiter delays the audio data.
+    return this->m_first_dac_time.load(std::memory_order_relaxed) - 
+           this->m_start_time + 
+           static_cast<double>(this->m_limiter.get_latency()) / 
+           static_cast<double>(this->m_options.sample_rate);
+}
+
+/**
+ *  Get the count of samples which reached full scale on the mix bus before 
+ *  the output safety limiter (thread-safe).
+ * 
+ *  @return
+ *      The count.
+ */
+uint64_t Player::get_clip_count() const noexcept {
+    return this->m_limiter.get_clip_count();
+}
+
+/**
+ *  Get the latency of the output safety limiter.
+ * 
+ *  @return
+ *      The count of frames.
+ */
+size_t Player::get_limiter_latency() const noexcept {
+    return this->m_limiter.get_latency();
+}
+
+/**
+ *  Set the gain of direct monitoring (thread-safe, lock-free, ramped over 
+ *  the next period).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              Direct monitoring is not enabled.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The gain is above MONITOR_MAX_GAIN.
+ * 
+ *  @param gain
+ *      The gain (in dB, -INFINITY to mute).
+ */
+void Player::set_monitor_gain(float gain) {
+    this->m_monitor.set_gain(gain);
 }
 
 //
@@ -255,6 +732,136 @@ void Player::emit_audio_callback(xap::core::buffer::Buffer &data) {
     }
 }
 
+/**
+ *  Emit frame callback event.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param data
+ *      The audio data (parameter 'data').
+ */
+void Player::emit_frame_callback(xap::audioio::AudioBuffer &data) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_frame_callback_lock);
+
+        this->m_frame_callback(data);
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(), 
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    } catch (std::exception &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_CALLBACK
+        );
+    }
+}
+
+/**
+ *  Render audio data of the source (or the frame callback) to the output.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              No pooled audio buffer is available.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              A stage changed the format or the count of frames of the 
+ *              audio data.
+ * 
+ *          - Errors raised by the source or the stages.
+ * 
+ *      The frames which were not rendered are silent.
+ * 
+ *  @param output
+ *      The output.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param timestamp
+ *      The position of the first frame in the stream.
+ */
+void Player::render_frames(
+    uint8_t *output, 
+    size_t   frame_count, 
+    int64_t  timestamp
+) {
+    xap::audioio::AudioFormat format = build_output_format(this->m_options);
+    size_t offset = 0U;
+    try {
+        while (offset < frame_count) {
+            size_t count = frame_count - offset;
+            if (count > this->m_max_block_frames) {
+                count = this->m_max_block_frames;
+            }
+
+            //  Each period is taken from the pool so that the frame callback 
+            //  may retain it.
+            xap::audioio::AudioBuffer data = 
+                xap::audioio::AudioBuffer::allocate(
+                    this->m_pool, 
+                    format, 
+                    count
+                );
+            data.set_timestamp(timestamp + static_cast<int64_t>(offset));
+            memset(data.get_pointer(), 0, data.get_length());
+
+            if (this->m_source) {
+                //  Missing frames of the source stay silent.
+                this->m_source->read(data);
+            } else {
+                this->emit_frame_callback(data);
+            }
+
+            //  Run stages (a stage may replace the audio data, which must 
+            //  still be played as is).
+            for (auto &stage : this->m_stages) {
+                stage->process(data);
+                if (data.get_sample_format() != format.sample_format || 
+                    data.get_channel_count() != format.channel_count || 
+                    data.get_sample_rate() != format.sample_rate || 
+                    data.get_frame_count() != count) {
+                    throw xap::audioio::Exception(
+                        "A stage changed the format of the audio data.",
+                        xap::audioio::ERROR_UNSUPPORTED
+                    );
+                }
+            }
+
+            memcpy(
+                output + offset * this->m_frame_size, 
+                data.get_pointer(), 
+                count * this->m_frame_size
+            );
+            offset += count;
+        }
+    } catch (xap::audioio::Exception &) {
+        memset(
+            output + offset * this->m_frame_size, 
+            0, 
+            (frame_count - offset) * this->m_frame_size
+        );
+        throw;
+    }
+}
+
 /**
  *  Emit error callback event.
  * 
@@ -291,16 +898,117 @@ void Player::emit_error_callback(const xap::audioio::Exception &e) {
     }
 }
 
+/**
+ *  Copy pre-rolled audio data to the output.
+ * 
+ *  @param output
+ *      The output.
+ *  @param length
+ *      The length of the output (in bytes).
+ *  @return
+ *      The count of bytes copied.
+ */
+size_t Player::consume_preroll(uint8_t *output, size_t length) noexcept {
+    size_t remaining = this->m_preroll.size() - this->m_preroll_offset;
+    if (remaining == 0U) {
+        return 0U;
+    }
+
+    size_t copied = (remaining < length ? remaining : length);
+    memcpy(output, this->m_preroll.data() + this->m_preroll_offset, copied);
+    this->m_preroll_offset += copied;
+
+    return copied;
+}
+
+/**
+ *  Finish a period: widen the output to the 32-bit float mix bus, mix the 
+ *  input in (direct monitoring), protect the output (the limiter) and 
+ *  convert it back to 16-bit. Without the mix bus, the limiter only scans 
+ *  the 16-bit output for clips.
+ * 
+ *  @param input
+ *      The input (nullptr if not available).
+ *  @param output
+ *      The output.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void Player::finish_period(
+    const int16_t  *input,
+    int16_t        *output,
+    size_t          frame_count
+) noexcept {
+    if (!this->m_has_mix_bus) {
+        this->m_limiter.limit(output, frame_count);
+        return;
+    }
+
+    size_t output_count = static_cast<size_t>(this->m_options.channel_count);
+    size_t input_count = 
+        static_cast<size_t>(this->m_options.monitor.channel_count);
+    float *mix = this->m_mix.get_samples<float>();
+
+    for (size_t offset = 0U; offset < frame_count; ) {
+        size_t count = frame_count - offset;
+        if (count > this->m_max_block_frames) {
+            count = this->m_max_block_frames;
+        }
+        int16_t *block = output + offset * output_count;
+        size_t sample_count = count * output_count;
+
+        //
+        //  Widen the output (full scale is 1.0).
+        //
+        for (size_t i = 0U; i < sample_count; ++i) {
+            mix[i] = static_cast<float>(block[i]) * (1.0F / 32768.0F);
+        }
+
+        //
+        //  Mix the input in (not saturated until the limiter).
+        //
+        this->m_monitor.mix(
+            input != nullptr ? input + offset * input_count : nullptr, 
+            mix, 
+            count
+        );
+
+        //
+        //  Limit and convert back (only what the limiter let through is 
+        //  saturated).
+        //
+        this->m_limiter.limit(mix, count);
+        for (size_t i = 0U; i < sample_count; ++i) {
+            block[i] = xap::audioio::fir_saturate_int16(mix[i] * 32768.0F);
+        }
+
+        offset += count;
+    }
+}
+
 //
 //  PlayerFactory constructor & destructor.
 //
 
+/**
+ *  Construct the object (with the default allocator).
+ */
+PlayerFactory::PlayerFactory() noexcept :
+    m_allocator(xap::audioio::get_default_allocator())
+{}
+
 /**
  *  Construct the object.
+ * 
+ *  @param allocator
+ *      The allocator used by all players created by the factory (must 
+ *      outlive the players).
  */
-PlayerFactory::PlayerFactory() noexcept {
-    //  Do nothing.
-}
+PlayerFactory::PlayerFactory(xap::audioio::IAllocator *allocator) noexcept :
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{}
 
 /**
  *  Destruct the object.
@@ -322,6 +1030,10 @@ PlayerFactory::~PlayerFactory() noexcept {
  *          - xap::audioio::ERROR_UNSUPPORTED:
  *              Player cannot supported this format.
  * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The options of the limiter, of the monitor or of the frame pool 
+ *              are invalid.
+ * 
  *          - xap::audioio::ERROR_PORTAUDIOCALL:
  *              PortAudio calling occurred error.
  * 
@@ -335,7 +1047,11 @@ std::unique_ptr<xap::audioio::IPlayer> PlayerFactory::load_unique_pointer(
     const xap::audioio::PlayerOptions &options
 ) {
     try {
-        xap::audioio::IPlayer *ptr = new xap::audioio::Player(options);
+        xap::audioio::IPlayer *ptr = 
+            new (this->m_allocator) xap::audioio::Player(
+                options, 
+                this->m_allocator
+            );
         return std::unique_ptr<xap::audioio::IPlayer>(ptr);
     } catch (std::bad_alloc &error) {
         throw xap::audioio::Exception(
@@ -354,6 +1070,10 @@ std::unique_ptr<xap::audioio::IPlayer> PlayerFactory::load_unique_pointer(
  *          - xap::audioio::ERROR_UNSUPPORTED:
  *              Player cannot supported this format.
  * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The options of the limiter, of the monitor or of the frame pool 
+ *              are invalid.
+ * 
  *          - xap::audioio::ERROR_PORTAUDIOCALL:
  *              PortAudio calling occurred error.
  * 
@@ -367,8 +1087,18 @@ std::shared_ptr<xap::audioio::IPlayer> PlayerFactory::load_shared_pointer(
     const xap::audioio::PlayerOptions &options
 ) {
     try {
-        xap::audioio::IPlayer *ptr = new xap::audioio::Player(options);
-        return std::shared_ptr<xap::audioio::IPlayer>(ptr);
+        xap::audioio::IPlayer *ptr = 
+            new (this->m_allocator) xap::audioio::Player(
+                options, 
+                this->m_allocator
+            );
+        return std::shared_ptr<xap::audioio::IPlayer>(
+            ptr,
+            std::default_delete<xap::audioio::IPlayer>(),
+            xap::audioio::StlAllocator<xap::audioio::IPlayer>(
+                this->m_allocator
+            )
+        );
     } catch (std::bad_alloc &error) {
         throw xap::audioio::Exception(
             error.what(),
@@ -386,6 +1116,10 @@ std::shared_ptr<xap::audioio::IPlayer> PlayerFactory::load_shared_pointer(
  *          - xap::audioio::ERROR_UNSUPPORTED:
  *              Player cannot supported this format.
  * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The options of the limiter, of the monitor or of the frame pool 
+ *              are invalid.
+ * 
  *          - xap::audioio::ERROR_PORTAUDIOCALL:
  *              PortAudio calling occurred error.
  * 
@@ -399,7 +1133,10 @@ xap::audioio::IPlayer* PlayerFactory::new_instance(
     const xap::audioio::PlayerOptions &options
 ) {
     try {
-        return new xap::audioio::Player(options);
+        return new (this->m_allocator) xap::audioio::Player(
+            options, 
+            this->m_allocator
+        );
     } catch (std::bad_alloc &error) {
         throw xap::audioio::Exception(
             error.what(),
@@ -437,7 +1174,8 @@ void PlayerFactory::free_instance(xap::audioio::IPlayer **instance) {
         );
     }
 
-    free(*instance);
+    //  Released by the allocator (see Player::operator delete).
+    delete *instance;
     *instance = nullptr;
 }
 
@@ -475,12 +1213,112 @@ static int xap_pa_play_callback(
 ) {
     xap::audioio::Player *player = 
         reinterpret_cast<xap::audioio::Player *>(user_data);
-    try {
-        size_t datalen = static_cast<size_t>(frames_per_buffer * 2U);
-        xap::core::buffer::Buffer data(datalen, false);
-        player->emit_audio_callback(data);
+    size_t datalen = static_cast<size_t>(frames_per_buffer) * 
+                     player->m_frame_size;
+    uint8_t *output = reinterpret_cast<uint8_t *>(output_buffer);
+
+    //
+    //  Measure time to first sample (from start() to the DAC time), the DAC 
+    //  time of the callbacks priming the output buffers is not reliable, so 
+    //  the first callback which is not priming (and whose DAC time is 
+    //  available, i.e. not 0) dates the primed frames which carried audio 
+    //  data before it.
+    //
+    bool is_priming = (status_flags & paPrimingOutput) != 0U;
+    if (player->m_is_first_output && 
+        !is_priming && 
+        time_info->outputBufferDacTime != 0.0) {
+        player->m_is_first_output = false;
+        player->m_first_dac_time.store(
+            time_info->outputBufferDacTime - 
+                static_cast<double>(player->m_primed_frames) / 
+                static_cast<double>(player->m_options.sample_rate),
+            std::memory_order_relaxed
+        );
+        player->m_has_first_dac_time.store(true, std::memory_order_release);
+    }
+
+    //
+    //  Output silence (and the monitored input) while paused, the audio 
+    //  callback is not invoked so that the audio data continues at the same 
+    //  sample after resumed. Without direct monitoring, there is nothing to 
+    //  do beyond the silence.
+    //
+    int64_t position = player->m_position;
+    player->m_position += static_cast<int64_t>(frames_per_buffer);
+
+    const int16_t *input = reinterpret_cast<const int16_t *>(input_buffer);
+    if (player->m_is_paused.load(std::memory_order_acquire)) {
+        memset(output_buffer, 0, datalen);
+        if (!player->m_monitor.is_enabled()) {
+            return paContinue;
+        }
+        player->finish_period(
+            input, 
+            reinterpret_cast<int16_t *>(output), 
+            static_cast<size_t>(frames_per_buffer)
+        );
+        return paContinue;
+    }
+
+    //
+    //  Play the pre-rolled audio data first.
+    //
+    size_t offset = player->consume_preroll(output, datalen);
+
+    //  The primed frames are played from the first one which carried 
+    //  pre-rolled audio data.
+    if (player->m_is_first_output && 
+        is_priming && 
+        (offset != 0U || player->m_primed_frames != 0U)) {
+        player->m_primed_frames += static_cast<size_t>(frames_per_buffer);
+    }
+    if (offset == datalen) {
+        player->finish_period(
+            input, 
+            reinterpret_cast<int16_t *>(output), 
+            static_cast<size_t>(frames_per_buffer)
+        );
+        return paContinue;
+    }
 
-        memcpy(output_buffer, data.get_pointer(), datalen);
+    try {
+        if (player->m_source || 
+            player->m_has_frame_callback.load(std::memory_order_acquire)) {
+            size_t frame_offset = offset / player->m_frame_size;
+            player->render_frames(
+                output + offset, 
+                static_cast<size_t>(frames_per_buffer) - frame_offset,
+                position + static_cast<int64_t>(frame_offset)
+            );
+        } else {
+            //
+            //  The audio callback fills one block at a time, the audio data 
+            //  not played in this period is played in the next one (the 
+            //  pre-roll may end within the period and the host may vary the 
+            //  count of frames per buffer).
+            //
+            xap::core::buffer::Buffer &data = player->m_audio_buffer;
+            size_t block_length = data.get_length();
+            while (offset < datalen) {
+                if (player->m_audio_offset == block_length) {
+                    memset(data.get_pointer(), 0, block_length);
+                    player->m_audio_offset = 0U;
+                    player->emit_audio_callback(data);
+                }
+                size_t length = std::min(
+                    datalen - offset, 
+                    block_length - player->m_audio_offset
+                );
+                memcpy(
+                    output + offset, 
+                    data.get_pointer() + player->m_audio_offset, 
+                    length
+                );
+                player->m_audio_offset += length;
+                offset += length;
+            }
+        }
     } catch (xap::core::buffer::BufferException &error) {
         try {
             player->emit_error_callback(xap::audioio::Exception(
@@ -498,6 +1336,16 @@ static int xap_pa_play_callback(
         }
     }
 
+    //
+    //  Mix the input in and protect the output (the limiter keeps running 
+    //  on the pre-rolled and the rendered audio data alike).
+    //
+    player->finish_period(
+        input, 
+        reinterpret_cast<int16_t *>(output), 
+        static_cast<size_t>(frames_per_buffer)
+    );
+
     return paContinue;
 }
 
@@ -10,13 +10,25 @@
 //
 //  Imports.
 //
+#include "allocator_p.h"
+
+#include <atomic>
 #include <mutex>
 #include <portaudio.h>
+#include <vector>
 #include <xap/audioio/player.h>
 
 namespace xap {
 namespace audioio {
 
+//
+//  Constants.
+//
+
+//  Count of frames of each pooled audio buffer of the frame callback if the 
+//  frames per buffer was not specified.
+const static size_t PLAYER_DEFAULT_BLOCK_FRAMES = 4096U;
+
 //
 //  Declare.
 //
@@ -62,19 +74,70 @@ public:
      *          - xap::audioio::ERROR_UNSUPPORTED:
      *              Player cannot supported this format.
      * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The options of the limiter, of the monitor or of the 
+     *              frame pool are invalid.
+     * 
      *          - xap::audioio::ERROR_PORTAUDIOCALL:
      *              PortAudio calling occurred error.
      * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
      *  @param options
      *      The player options.
+     *  @param allocator
+     *      The allocator.
      */
-    Player(const xap::audioio::PlayerOptions &options);
+    Player(
+        const xap::audioio::PlayerOptions &options,
+        xap::audioio::IAllocator          *allocator
+    );
 
     /**
      *  Destruct the object.
      */
     virtual ~Player() noexcept;
 
+    /**
+     *  Allocate the memory of the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if memory allocation was failed 
+     *      (xap::audioio::ERROR_ALLOC).
+     *  @param size
+     *      The size of the object.
+     *  @param allocator
+     *      The allocator.
+     *  @return
+     *      The memory.
+     */
+    static void *operator new(
+        size_t                     size, 
+        xap::audioio::IAllocator  *allocator
+    );
+
+    /**
+     *  Release the memory of the object (allocated by operator new).
+     * 
+     *  @param pointer
+     *      The memory.
+     */
+    static void operator delete(void *pointer) noexcept;
+
+    /**
+     *  Release the memory of the object if its constructor raised.
+     * 
+     *  @param pointer
+     *      The memory.
+     *  @param allocator
+     *      The allocator.
+     */
+    static void operator delete(
+        void                      *pointer, 
+        xap::audioio::IAllocator  *allocator
+    ) noexcept;
+
     /**
      *  Start player.
      * 
@@ -102,6 +165,60 @@ public:
         std::function <void(xap::core::buffer::Buffer &)> &callback
     ) override;
 
+    /**
+     *  Set frame callback.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error. 
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    virtual void set_frame_callback(
+        std::function <void(xap::audioio::AudioBuffer &)> &callback
+    ) override;
+
+    /**
+     *  Set audio source.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the player is running 
+     *      (xap::audioio::ERROR_INVALIDOPERATION).
+     *  @param source
+     *      The source (nullptr to remove the source).
+     */
+    virtual void set_source(
+        const std::shared_ptr<xap::audioio::ISource> &source
+    ) override;
+
+    /**
+     *  Append a processing stage.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player is running.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The stage is nullptr.
+     * 
+     *  @param stage
+     *      The stage.
+     */
+    virtual void add_stage(
+        const std::shared_ptr<xap::audioio::IStage> &stage
+    ) override;
+
+    /**
+     *  Remove all processing stages.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the player is running 
+     *      (xap::audioio::ERROR_INVALIDOPERATION).
+     */
+    virtual void clear_stages() override;
+
     /**
      *  Set error callback.
      * 
@@ -131,6 +248,100 @@ public:
      */
     virtual void stop(bool forcibly) override;
 
+    /**
+     *  Pause player.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player is not running or was already paused.
+     */
+    virtual void pause() override;
+
+    /**
+     *  Resume player.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player is not running or is not paused.
+     */
+    virtual void resume() override;
+
+    /**
+     *  Get whether the player is paused.
+     * 
+     *  @return
+     *      True if paused.
+     */
+    virtual bool is_paused() const noexcept override;
+
+    /**
+     *  Pre-roll audio data.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The player was already running.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The length of the data is not a multiple of frame size.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
+     *  @param data
+     *      The audio data.
+     */
+    virtual void preroll(xap::core::buffer::Buffer &data) override;
+
+    /**
+     *  Get the time to first sample of the last start.
+     * 
+     *  @return
+     *      The time (in seconds), or a negative value if the first sample was 
+     *      not output yet.
+     */
+    virtual double get_time_to_first_sample() const noexcept override;
+
+    /**
+     *  Get the count of samples which reached full scale on the mix bus 
+     *  before the output safety limiter (thread-safe).
+     * 
+     *  @return
+     *      The count.
+     */
+    virtual uint64_t get_clip_count() const noexcept override;
+
+    /**
+     *  Get the latency of the output safety limiter.
+     * 
+     *  @return
+     *      The count of frames.
+     */
+    virtual size_t get_limiter_latency() const noexcept override;
+
+    /**
+     *  Set the gain of direct monitoring (thread-safe, lock-free, ramped 
+     *  over the next period).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              Direct monitoring is not enabled.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The gain is above MONITOR_MAX_GAIN.
+     * 
+     *  @param gain
+     *      The gain (in dB, -INFINITY to mute).
+     */
+    virtual void set_monitor_gain(float gain) override;
+
 private:
     //
     //  Private methods.
@@ -152,6 +363,59 @@ private:
      *      The audio data (parameter 'data').
      */
     void emit_audio_callback(xap::core::buffer::Buffer &data);
+
+    /**
+     *  Emit frame callback event.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param data
+     *      The audio data (parameter 'data').
+     */
+    void emit_frame_callback(xap::audioio::AudioBuffer &data);
+
+    /**
+     *  Render audio data of the source (or the frame callback) to the output.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              No pooled audio buffer is available.
+     * 
+     *          - xap::audioio::ERROR_UNSUPPORTED:
+     *              A stage changed the format or the count of frames of the 
+     *              audio data.
+     * 
+     *          - Errors raised by the source or the stages.
+     * 
+     *      The frames which were not rendered are silent.
+     * 
+     *  @param output
+     *      The output.
+     *  @param frame_count
+     *      The count of frames.
+     *  @param timestamp
+     *      The position of the first frame in the stream.
+     */
+    void render_frames(
+        uint8_t *output, 
+        size_t   frame_count, 
+        int64_t  timestamp
+    );
     
     /**
      *  Emit error callback event.
@@ -170,16 +434,74 @@ private:
      */
     void emit_error_callback(const xap::audioio::Exception &error);
 
+    /**
+     *  Copy pre-rolled audio data to the output.
+     * 
+     *  @param output
+     *      The output.
+     *  @param length
+     *      The length of the output (in bytes).
+     *  @return
+     *      The count of bytes copied.
+     */
+    size_t consume_preroll(uint8_t *output, size_t length) noexcept;
+
+    /**
+     *  Finish a period: widen the output to the 32-bit float mix bus, mix 
+     *  the input in (direct monitoring), protect the output (the limiter) 
+     *  and convert it back to 16-bit. Without the mix bus, the limiter only 
+     *  scans the 16-bit output for clips.
+     * 
+     *  @param input
+     *      The input (nullptr if not available).
+     *  @param output
+     *      The output.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void finish_period(
+        const int16_t  *input,
+        int16_t        *output,
+        size_t          frame_count
+    ) noexcept;
+
     //
     //  Members.
     //
     std::function <void(xap::core::buffer::Buffer &)>     m_audio_callback;
     std::mutex                                            m_audio_callback_lock;
+    std::function <void(xap::audioio::AudioBuffer &)>     m_frame_callback;
+    std::mutex                                            m_frame_callback_lock;
     std::function <void(const xap::audioio::Exception &)> m_error_callback;
     std::mutex                                            m_error_callback_lock;
     const xap::audioio::PlayerOptions                     m_options;
     PaStream                                             *m_stream;
     bool                                                  m_is_running;
+    std::atomic<bool>                                     m_is_paused;
+    size_t                                                m_frame_size;
+    std::vector<uint8_t, xap::audioio::StlAllocator<uint8_t>> 
+        m_preroll;
+    size_t                                                m_preroll_offset;
+    PaTime                                                m_start_time;
+    bool                                                  m_is_first_output;
+    size_t                                                m_primed_frames;
+    std::atomic<double>                                   m_first_dac_time;
+    std::atomic<bool>                                     m_has_first_dac_time;
+    std::atomic<bool>                                     m_has_frame_callback;
+    size_t                                                m_max_block_frames;
+    xap::audioio::AudioBufferPool                         m_pool;
+    xap::core::buffer::Buffer                             m_audio_buffer;
+    size_t                                                m_audio_offset;
+    std::shared_ptr<xap::audioio::ISource>                m_source;
+    std::vector<
+        std::shared_ptr<xap::audioio::IStage>, 
+        xap::audioio::StlAllocator<std::shared_ptr<xap::audioio::IStage>>
+    >                                                     m_stages;
+    int64_t                                               m_position;
+    bool                                                  m_has_mix_bus;
+    xap::audioio::AudioBuffer                             m_mix;
+    xap::audioio::Limiter                                 m_limiter;
+    xap::audioio::MonitorMixer                            m_monitor;
 
     //
     //  Friend functions.
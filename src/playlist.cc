@@ -0,0 +1,692 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "mpscqueue_p.h"
+#include "worker_p.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/playlist.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double PLAYLIST_PI = 3.14159265358979323846;
+
+//  Capacity of the event queue (power of 2).
+const static size_t PLAYLIST_EVENT_CAPACITY = 256U;
+
+//  Maximum count of items decoded ahead.
+const static size_t PLAYLIST_MAXIMUM_LOOKAHEAD = 1024U;
+
+//  Poll interval of the decoder thread.
+const static std::chrono::milliseconds PLAYLIST_DECODE_TIMEOUT(10);
+
+//
+//  Private structures.
+//
+
+/**
+ *  Decoded playlist item.
+ */
+struct PlaylistItem_ {
+    //  Item.
+    uint64_t                    id;
+
+    //  Decoded audio data (shared with the prompt cache).
+    xap::audioio::AudioBuffer   buffer;
+
+    //  Count of frames.
+    size_t                      frame_count;
+};
+
+//
+//  Private classes.
+//
+
+/**
+ *  Task of the decoder thread (a friend of the playlist).
+ */
+class PlaylistDecoder {
+public:
+    /**
+     *  Serve the decode-ahead of a playlist.
+     * 
+     *  @param playlist
+     *      The playlist.
+     */
+    static void serve(void *playlist) noexcept {
+        static_cast<xap::audioio::PlaylistSource *>(playlist)->serve();
+    }
+};
+//
+//  Private functions.
+//
+
+/**
+ *  Get the decoder thread (decodes the items of all playlists).
+ * 
+ *  @return
+ *      The decoder thread.
+ */
+static xap::audioio::Worker &get_decoder() noexcept {
+    static xap::audioio::Worker decoder(
+        &PlaylistDecoder::serve,
+        PLAYLIST_DECODE_TIMEOUT
+    );
+    return decoder;
+}
+
+/**
+ *  Round up to a power of 2.
+ * 
+ *  @param value
+ *      The value.
+ *  @return
+ *      The power of 2 (at least 2).
+ */
+static size_t round_to_power_of_two(size_t value) noexcept {
+    size_t result = 2U;
+    while (result < value) {
+        result <<= 1U;
+    }
+    return result;
+}
+
+/**
+ *  Convert a mixed sample.
+ * 
+ *  @param value
+ *      The mixed sample.
+ *  @return
+ *      The sample.
+ */
+template<class T>
+static T to_sample(double value) noexcept;
+
+template<>
+int16_t to_sample<int16_t>(double value) noexcept {
+    return static_cast<int16_t>(
+        std::min(32767.0, std::max(-32768.0, floor(value + 0.5)))
+    );
+}
+
+template<>
+int32_t to_sample<int32_t>(double value) noexcept {
+    return static_cast<int32_t>(
+        std::min(2147483647.0, std::max(-2147483648.0, floor(value + 0.5)))
+    );
+}
+
+template<>
+float to_sample<float>(double value) noexcept {
+    return static_cast<float>(value);
+}
+
+/**
+ *  Crossfade two items (equal-power).
+ * 
+ *  @param output
+ *      The output.
+ *  @param fading_out
+ *      The samples of the item fading out.
+ *  @param fading_in
+ *      The samples of the item fading in.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param channel_count
+ *      The count of channels.
+ *  @param fade_offset
+ *      The offset of the first frame in the crossfade.
+ *  @param fade_length
+ *      The count of frames of the crossfade.
+ */
+template<class T>
+static void crossfade(
+    T           *output,
+    const T     *fading_out,
+    const T     *fading_in,
+    size_t       frame_count,
+    size_t       channel_count,
+    size_t       fade_offset,
+    size_t       fade_length
+) noexcept {
+    double step = 0.5 * PLAYLIST_PI / static_cast<double>(fade_length);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        double angle = (static_cast<double>(fade_offset + i) + 0.5) * step;
+        double gain_out = cos(angle);
+        double gain_in = sin(angle);
+        for (size_t c = 0U; c < channel_count; ++c) {
+            size_t k = i * channel_count + c;
+            output[k] = to_sample<T>(
+                static_cast<double>(fading_out[k]) * gain_out + 
+                static_cast<double>(fading_in[k]) * gain_in
+            );
+        }
+    }
+}
+
+/**
+ *  Release a decoded item.
+ * 
+ *  @param item
+ *      The item (nullptr is ignored).
+ */
+static void release_item(struct xap::audioio::PlaylistItem_ *item) noexcept {
+    if (item == nullptr) {
+        return;
+    }
+    item->~PlaylistItem_();
+    xap::audioio::free_object(item);
+}
+
+//
+//  PlaylistSource constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format or the options are invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              The decoder thread cannot be started.
+ * 
+ *  @param format
+ *      The audio format (16-bit, 32-bit or 32-bit float).
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+PlaylistSource::PlaylistSource(
+    const xap::audioio::AudioFormat          &format,
+    const xap::audioio::PlaylistOptions      &options,
+    xap::audioio::IAllocator                 *allocator
+):
+    m_format(format),
+    m_options(options),
+    m_allocator(allocator),
+    m_frame_size(0U),
+    m_lock(),
+    m_pending(
+        xap::audioio::StlAllocator<
+            xap::audioio::PlaylistSource::PendingItem
+        >(xap::audioio::resolve_allocator(allocator))
+    ),
+    m_last_item(0U),
+    m_ready(nullptr),
+    m_retired(nullptr),
+    m_events(nullptr),
+    m_ready_count(0U),
+    m_remaining_count(0U),
+    m_gap_count(0U),
+    m_frame_position(0U),
+    m_current(nullptr),
+    m_next(nullptr),
+    m_current_position(0U),
+    m_next_position(0U),
+    m_fade_length(0U),
+    m_has_played(false)
+{
+    if ((format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_INT32 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        format.channel_count == 0U || 
+        format.sample_rate == 0U || 
+        options.lookahead == 0U || 
+        options.lookahead > PLAYLIST_MAXIMUM_LOOKAHEAD) {
+        throw xap::audioio::Exception(
+            "Invalid format or options.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+    if (options.cache == nullptr) {
+        this->m_options.cache = &xap::audioio::get_default_prompt_cache();
+    }
+    this->m_allocator = allocator;
+    this->m_frame_size = xap::audioio::get_frame_size(format);
+
+    //  The items in flight are the items decoded ahead, the current and 
+    //  the next item, and the items played since the last visit of the 
+    //  decoder thread (at most the items decoded ahead).
+    size_t capacity = round_to_power_of_two(options.lookahead + 2U);
+    try {
+        this->m_ready = xap::audioio::new_object<
+            xap::audioio::MpscQueue<struct xap::audioio::PlaylistItem_ *>
+        >(allocator, capacity, allocator);
+        this->m_retired = xap::audioio::new_object<
+            xap::audioio::MpscQueue<struct xap::audioio::PlaylistItem_ *>
+        >(allocator, 2U * capacity, allocator);
+        this->m_events = xap::audioio::new_object<
+            xap::audioio::MpscQueue<xap::audioio::PlaylistEvent>
+        >(allocator, PLAYLIST_EVENT_CAPACITY, allocator);
+        get_decoder().add(this);
+    } catch (...) {
+        if (this->m_ready != nullptr) {
+            this->m_ready->~MpscQueue<struct xap::audioio::PlaylistItem_ *>();
+            xap::audioio::free_object(this->m_ready);
+        }
+        if (this->m_retired != nullptr) {
+            this->m_retired->~MpscQueue<
+                struct xap::audioio::PlaylistItem_ * 
+            >();
+            xap::audioio::free_object(this->m_retired);
+        }
+        if (this->m_events != nullptr) {
+            this->m_events->~MpscQueue<xap::audioio::PlaylistEvent>();
+            xap::audioio::free_object(this->m_events);
+        }
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+PlaylistSource::~PlaylistSource() noexcept {
+    get_decoder().remove(this);
+    struct xap::audioio::PlaylistItem_ *item = nullptr;
+    while (this->m_ready->try_pop(item)) {
+        release_item(item);
+    }
+    while (this->m_retired->try_pop(item)) {
+        release_item(item);
+    }
+    release_item(this->m_current);
+    release_item(this->m_next);
+    this->m_ready->~MpscQueue<struct xap::audioio::PlaylistItem_ *>();
+    xap::audioio::free_object(this->m_ready);
+    this->m_retired->~MpscQueue<struct xap::audioio::PlaylistItem_ *>();
+    xap::audioio::free_object(this->m_retired);
+    this->m_events->~MpscQueue<xap::audioio::PlaylistEvent>();
+    xap::audioio::free_object(this->m_events);
+}
+
+//
+//  PlaylistSource public methods.
+//
+
+/**
+ *  Append an item (thread-safe).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed 
+ *      (xap::audioio::ERROR_ALLOC).
+ *  @param path
+ *      The path of the audio file.
+ *  @return
+ *      The item (identifies the item in the events, starts from 1).
+ */
+uint64_t PlaylistSource::append(const char *path) {
+    uint64_t item = 0U;
+    try {
+        std::lock_guard<std::mutex> locked(this->m_lock);
+        item = this->m_last_item + 1U;
+        this->m_pending.emplace_back(
+            item,
+            xap::audioio::PlaylistSource::PendingPath(
+                path,
+                xap::audioio::StlAllocator<char>(this->m_allocator)
+            )
+        );
+        this->m_last_item = item;
+        this->m_remaining_count.fetch_add(1U, std::memory_order_relaxed);
+    } catch (std::bad_alloc &) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+    get_decoder().wake();
+    return item;
+}
+
+/**
+ *  Read audio data (on the audio thread, never blocks on I/O).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (less than requested if all items were 
+ *      played, or if the next item was not decoded yet).
+ */
+size_t PlaylistSource::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_format.sample_format || 
+        output.get_channel_count() != this->m_format.channel_count || 
+        output.get_sample_rate() != this->m_format.sample_rate) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t frame_count = output.get_frame_count();
+    size_t crossfade_frames = this->m_options.crossfade_frames;
+    uint64_t position = this->m_frame_position.load(std::memory_order_relaxed);
+    uint8_t *destination = output.get_samples<uint8_t>();
+    bool is_consumed = false;
+    size_t filled = 0U;
+    while (filled < frame_count) {
+        //  Start the next item.
+        if (this->m_current == nullptr) {
+            if (!this->m_ready->try_pop(this->m_current)) {
+                this->m_current = nullptr;
+                break;
+            }
+            this->m_ready_count.fetch_sub(1U, std::memory_order_relaxed);
+            is_consumed = true;
+            this->m_current_position = 0U;
+            this->emit(
+                xap::audioio::PLAYLISTEVENT_STARTED,
+                this->m_current->id,
+                position + filled
+            );
+        }
+        struct xap::audioio::PlaylistItem_ *current = this->m_current;
+        size_t remaining = current->frame_count - this->m_current_position;
+
+        //  Finish the current item, the next item continues at once.
+        if (remaining == 0U) {
+            this->emit(
+                xap::audioio::PLAYLISTEVENT_FINISHED,
+                current->id,
+                position + filled
+            );
+            this->retire(current);
+            this->m_remaining_count.fetch_sub(1U, std::memory_order_relaxed);
+            this->m_current = this->m_next;
+            this->m_current_position = this->m_next_position;
+            if (this->m_next != nullptr && this->m_fade_length == 0U) {
+                //  Too short to crossfade, spliced instead.
+                this->emit(
+                    xap::audioio::PLAYLISTEVENT_STARTED,
+                    this->m_next->id,
+                    position + filled
+                );
+            }
+            this->m_next = nullptr;
+            this->m_next_position = 0U;
+            this->m_fade_length = 0U;
+            continue;
+        }
+
+        //  Take the next item for the crossfade (if it is decoded).
+        if (this->m_next == nullptr && 
+            crossfade_frames != 0U && 
+            remaining <= crossfade_frames) {
+            if (this->m_ready->try_pop(this->m_next)) {
+                this->m_ready_count.fetch_sub(1U, std::memory_order_relaxed);
+                is_consumed = true;
+                this->m_next_position = 0U;
+                this->m_fade_length = 0U;
+                if (this->m_next->frame_count >= remaining) {
+                    this->m_fade_length = remaining;
+                    this->emit(
+                        xap::audioio::PLAYLISTEVENT_STARTED,
+                        this->m_next->id,
+                        position + filled
+                    );
+                }
+            } else {
+                this->m_next = nullptr;
+            }
+        }
+
+        size_t count = 0U;
+        uint8_t *target = destination + filled * this->m_frame_size;
+        const uint8_t *source = 
+            current->buffer.get_samples<uint8_t>() + 
+            this->m_current_position * this->m_frame_size;
+        if (this->m_next != nullptr && this->m_fade_length != 0U) {
+            //  Crossfade.
+            count = std::min(frame_count - filled, remaining);
+            const uint8_t *incoming = 
+                this->m_next->buffer.get_samples<uint8_t>() + 
+                this->m_next_position * this->m_frame_size;
+            size_t fade_offset = this->m_fade_length - remaining;
+            switch (this->m_format.sample_format) {
+            case xap::audioio::SAMPLEFORMAT_INT16:
+                crossfade<int16_t>(
+                    reinterpret_cast<int16_t *>(target),
+                    reinterpret_cast<const int16_t *>(source),
+                    reinterpret_cast<const int16_t *>(incoming),
+                    count,
+                    this->m_format.channel_count,
+                    fade_offset,
+                    this->m_fade_length
+                );
+                break;
+            case xap::audioio::SAMPLEFORMAT_INT32:
+                crossfade<int32_t>(
+                    reinterpret_cast<int32_t *>(target),
+                    reinterpret_cast<const int32_t *>(source),
+                    reinterpret_cast<const int32_t *>(incoming),
+                    count,
+                    this->m_format.channel_count,
+                    fade_offset,
+                    this->m_fade_length
+                );
+                break;
+            default:
+                crossfade<float>(
+                    reinterpret_cast<float *>(target),
+                    reinterpret_cast<const float *>(source),
+                    reinterpret_cast<const float *>(incoming),
+                    count,
+                    this->m_format.channel_count,
+                    fade_offset,
+                    this->m_fade_length
+                );
+                break;
+            }
+            this->m_next_position += count;
+        } else {
+            //  Copy (up to the start of the crossfade).
+            size_t limit = remaining;
+            if (crossfade_frames != 0U && 
+                this->m_next == nullptr && 
+                remaining > crossfade_frames) {
+                limit = remaining - crossfade_frames;
+            }
+            count = std::min(frame_count - filled, limit);
+            memcpy(target, source, count * this->m_frame_size);
+        }
+        this->m_current_position += count;
+        filled += count;
+        this->m_has_played = true;
+    }
+
+    //  Frames missing while items are pending are gaps.
+    if (filled < frame_count) {
+        if (this->m_remaining_count.load(std::memory_order_relaxed) == 0U) {
+            this->m_has_played = false;
+        } else if (this->m_has_played) {
+            this->m_gap_count.fetch_add(
+                frame_count - filled,
+                std::memory_order_relaxed
+            );
+        }
+    }
+    this->m_frame_position.store(
+        position + frame_count,
+        std::memory_order_relaxed
+    );
+    if (is_consumed) {
+        get_decoder().wake();
+    }
+    return filled;
+}
+
+/**
+ *  Get the next event (single consumer).
+ * 
+ *  Events are dropped if they are not polled (the queue holds 256 events).
+ *  Failures are reported by the decoder thread, so they may be reported 
+ *  before the items ahead of the failed one finished.
+ * 
+ *  @param event
+ *      The event (output).
+ *  @return
+ *      True if an event was got.
+ */
+bool PlaylistSource::poll_event(xap::audioio::PlaylistEvent &event) noexcept {
+    return this->m_events->try_pop(event);
+}
+
+/**
+ *  Get whether all items appended were played (or failed).
+ * 
+ *  @return
+ *      True if so.
+ */
+bool PlaylistSource::is_finished() const noexcept {
+    return this->m_remaining_count.load(std::memory_order_relaxed) == 0U;
+}
+
+/**
+ *  Get the count of frames missing between items (the next item was not 
+ *  decoded in time).
+ * 
+ *  @return
+ *      The count of frames.
+ */
+uint64_t PlaylistSource::get_gap_frame_count() const noexcept {
+    return this->m_gap_count.load(std::memory_order_relaxed);
+}
+
+//
+//  PlaylistSource private methods.
+//
+
+/**
+ *  Decode the items ahead and release the items played (on the decoder 
+ *  thread).
+ */
+void PlaylistSource::serve() noexcept {
+    struct xap::audioio::PlaylistItem_ *item = nullptr;
+    while (this->m_retired->try_pop(item)) {
+        release_item(item);
+    }
+    while (this->m_ready_count.load(std::memory_order_relaxed) <
+           this->m_options.lookahead) {
+        xap::audioio::PlaylistSource::PendingItem pending(
+            0U,
+            xap::audioio::PlaylistSource::PendingPath(
+                xap::audioio::StlAllocator<char>(this->m_allocator)
+            )
+        );
+        {
+            std::lock_guard<std::mutex> locked(this->m_lock);
+            if (this->m_pending.empty()) {
+                break;
+            }
+            pending = std::move(this->m_pending.front());
+            this->m_pending.pop_front();
+        }
+        try {
+            xap::audioio::AudioBuffer buffer = this->m_options.cache->load(
+                pending.second.c_str(),
+                this->m_format
+            );
+            item = xap::audioio::new_object<struct xap::audioio::PlaylistItem_>(
+                this->m_allocator
+            );
+            item->id = pending.first;
+            item->buffer = buffer;
+            item->frame_count = buffer.get_frame_count();
+        } catch (xap::audioio::Exception &error) {
+            this->emit(
+                xap::audioio::PLAYLISTEVENT_FAILED,
+                pending.first,
+                this->m_frame_position.load(std::memory_order_relaxed),
+                error.get_code()
+            );
+            this->m_remaining_count.fetch_sub(1U, std::memory_order_relaxed);
+            continue;
+        } catch (...) {
+            this->emit(
+                xap::audioio::PLAYLISTEVENT_FAILED,
+                pending.first,
+                this->m_frame_position.load(std::memory_order_relaxed),
+                xap::audioio::ERROR_ALLOC
+            );
+            this->m_remaining_count.fetch_sub(1U, std::memory_order_relaxed);
+            continue;
+        }
+
+        //  Never full (see the capacity).
+        this->m_ready_count.fetch_add(1U, std::memory_order_relaxed);
+        this->m_ready->try_push(item);
+    }
+}
+
+/**
+ *  Emit an event (dropped if the queue is full).
+ * 
+ *  @param type
+ *      The type.
+ *  @param item
+ *      The item.
+ *  @param frame
+ *      The position.
+ *  @param error
+ *      The error code.
+ */
+void PlaylistSource::emit(
+    xap::audioio::PlaylistEventType  type,
+    uint64_t                         item,
+    uint64_t                         frame,
+    uint16_t                         error
+) noexcept {
+    xap::audioio::PlaylistEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.error = error;
+    event.item = item;
+    event.frame = frame;
+    this->m_events->try_push(event);
+}
+
+/**
+ *  Hand an item over to the decoder thread for releasing it (on the audio 
+ *  thread).
+ * 
+ *  @param item
+ *      The item.
+ */
+void PlaylistSource::retire(
+    struct xap::audioio::PlaylistItem_ *item
+) noexcept {
+    if (!this->m_retired->try_push(item)) {
+        //  Never happens (see the capacity).
+        release_item(item);
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,724 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <xap/audioio/audiofile.h>
+#include <xap/audioio/promptcache.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+
+//  Count of frames decoded per read.
+const static size_t PROMPTCACHE_DECODE_FRAMES = 4096U;
+
+//  Count of reads which may return no frame (while the prefetch thread 
+//  catches up) before decoding fails.
+const static size_t PROMPTCACHE_DECODE_RETRIES = 100000U;
+
+//  Minimum ring buffer of the decoding reader (see AudioFileReaderOptions).
+const static size_t PROMPTCACHE_MINIMUM_BUFFER_FRAMES = 512U;
+
+//
+//  Private types.
+//
+
+//  String (allocated by the allocator of the cache).
+typedef std::basic_string<
+    char,
+    std::char_traits<char>,
+    xap::audioio::StlAllocator<char>
+> PromptCacheString;
+
+//
+//  Private structures.
+//
+
+/**
+ *  Cached prompt.
+ */
+typedef struct PromptCacheEntry_ {
+    //  Key (the path and the audio format).
+    xap::audioio::PromptCacheString  key;
+
+    //  Path of the file.
+    xap::audioio::PromptCacheString  path;
+
+    //  Decoded audio data.
+    xap::audioio::AudioBuffer        buffer;
+
+    //  Size of the audio data (in bytes).
+    size_t                           size;
+} PromptCacheEntry;
+
+/**
+ *  Hash of the keys of the prompts (FNV-1a).
+ */
+typedef struct PromptCacheKeyHash_ {
+    /**
+     *  Hash a key.
+     * 
+     *  @param key
+     *      The key.
+     *  @return
+     *      The hash.
+     */
+    size_t operator()(
+        const xap::audioio::PromptCacheString  &key
+    ) const noexcept {
+        uint64_t hash = 14695981039346656037ULL;
+        for (char c : key) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+} PromptCacheKeyHash;
+
+//  Prompts of a shard (the most recently used first).
+typedef std::list<
+    xap::audioio::PromptCacheEntry,
+    xap::audioio::StlAllocator<xap::audioio::PromptCacheEntry>
+> PromptCacheList;
+
+//  Prompts of a shard by key.
+typedef std::unordered_map<
+    xap::audioio::PromptCacheString,
+    xap::audioio::PromptCacheList::iterator,
+    xap::audioio::PromptCacheKeyHash,
+    std::equal_to<xap::audioio::PromptCacheString>,
+    xap::audioio::StlAllocator<
+        std::pair<
+            const xap::audioio::PromptCacheString,
+            xap::audioio::PromptCacheList::iterator
+        >
+    >
+> PromptCacheLookup;
+
+/**
+ *  Shard of the prompt cache.
+ */
+struct PromptCacheShard_ {
+    //  Lock.
+    std::mutex                                     lock;
+
+    //  Prompts (the most recently used first).
+    xap::audioio::PromptCacheList                  entries;
+
+    //  Prompts by key.
+    xap::audioio::PromptCacheLookup                lookup;
+
+    //  Size of the audio data of the prompts (in bytes).
+    size_t                                         size = 0U;
+
+    //  Counts of lookups (per shard, so that lookups of different shards 
+    //  share no cache line).
+    std::atomic<uint64_t>                          hit_count;
+    std::atomic<uint64_t>                          miss_count;
+
+    explicit PromptCacheShard_(xap::audioio::IAllocator *allocator):
+        entries(
+            xap::audioio::StlAllocator<xap::audioio::PromptCacheEntry>(
+                allocator
+            )
+        ),
+        lookup(
+            0U,
+            xap::audioio::PromptCacheKeyHash(),
+            std::equal_to<xap::audioio::PromptCacheString>(),
+            xap::audioio::StlAllocator<
+                xap::audioio::PromptCacheLookup::value_type
+            >(allocator)
+        ),
+        hit_count(0U),
+        miss_count(0U) {}
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the key of a prompt.
+ * 
+ *  @param path
+ *      The path of the file.
+ *  @param format
+ *      The audio format.
+ *  @param allocator
+ *      The allocator of the key.
+ *  @return
+ *      The key.
+ */
+static xap::audioio::PromptCacheString get_prompt_key(
+    const char                       *path,
+    const xap::audioio::AudioFormat  &format,
+    xap::audioio::IAllocator         *allocator
+) {
+    char suffix[48];
+    int length = snprintf(
+        suffix,
+        sizeof(suffix),
+        "%u:%u:%u",
+        static_cast<unsigned>(format.sample_format),
+        static_cast<unsigned>(format.channel_count),
+        static_cast<unsigned>(format.sample_rate)
+    );
+    xap::audioio::PromptCacheString key(
+        path,
+        xap::audioio::StlAllocator<char>(allocator)
+    );
+    key.push_back('\0');
+    key.append(suffix, static_cast<size_t>(length));
+    return key;
+}
+
+/**
+ *  Decode a prompt.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the file cannot be decoded (see AudioFileReader).
+ *  @param path
+ *      The path of the file.
+ *  @param format
+ *      The audio format.
+ *  @param allocator
+ *      The allocator of the audio data.
+ *  @return
+ *      The audio data.
+ */
+static xap::audioio::AudioBuffer decode_prompt(
+    const char                       *path,
+    const xap::audioio::AudioFormat  &format,
+    xap::audioio::IAllocator         *allocator
+) {
+    //  Let the reader prefetch the whole file when it is constructed.
+    xap::audioio::AudioFileInfo info = xap::audioio::audiofile_probe(path);
+    xap::audioio::AudioFileReaderOptions options;
+    options.buffer_frames = PROMPTCACHE_MINIMUM_BUFFER_FRAMES;
+    if (info.frame_count < static_cast<uint64_t>(SIZE_MAX - 1U)) {
+        options.buffer_frames = std::max(
+            options.buffer_frames,
+            static_cast<size_t>(info.frame_count) + 1U
+        );
+    }
+    xap::audioio::AudioFileReader reader(path, format, options);
+
+    uint64_t length = reader.get_length();
+    if (length > static_cast<uint64_t>(SIZE_MAX / 2U)) {
+        throw xap::audioio::Exception(
+            "The prompt is too long.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+    size_t frame_count = static_cast<size_t>(length);
+    xap::audioio::AudioBuffer buffer = xap::audioio::AudioBuffer::allocate(
+        format,
+        frame_count,
+        allocator
+    );
+
+    size_t position = 0U;
+    size_t retries = 0U;
+    while (position < frame_count) {
+        xap::audioio::AudioBuffer chunk = buffer.slice(
+            position,
+            std::min(PROMPTCACHE_DECODE_FRAMES, frame_count - position)
+        );
+        size_t read_count = reader.read(chunk);
+        if (read_count == 0U) {
+            if (reader.is_finished()) {
+                break;
+            }
+            if (++retries > PROMPTCACHE_DECODE_RETRIES) {
+                throw xap::audioio::Exception(
+                    "Cannot read the audio file.",
+                    xap::audioio::ERROR_IO
+                );
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        position += read_count;
+    }
+    if (position < frame_count) {
+        //  Shorter than announced (e.g. truncated file).
+        memset(
+            buffer.get_samples<uint8_t>() + 
+                position * xap::audioio::get_frame_size(format),
+            0,
+            (frame_count - position) * xap::audioio::get_frame_size(format)
+        );
+    }
+    buffer.set_timestamp(0);
+    return buffer;
+}
+
+//
+//  PromptCache constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The count of shards is 0.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param options
+ *      The options.
+ *  @param allocator
+ *      The allocator of the decoded audio data and the prompts cached 
+ *      (nullptr for the default allocator).
+ */
+PromptCache::PromptCache(
+    const xap::audioio::PromptCacheOptions  &options,
+    xap::audioio::IAllocator                *allocator
+):
+    m_shards(nullptr),
+    m_shard_count(options.shard_count),
+    m_allocator(allocator),
+    m_budget(options.budget),
+    m_size(0U) {
+    if (options.shard_count == 0U || 
+        options.shard_count > 
+            SIZE_MAX / sizeof(struct xap::audioio::PromptCacheShard_)) {
+        throw xap::audioio::Exception(
+            "Invalid count of shards.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    if (allocator == nullptr) {
+        allocator = xap::audioio::get_default_allocator();
+    }
+    this->m_allocator = allocator;
+    this->m_shards = 
+        static_cast<struct xap::audioio::PromptCacheShard_*>(
+            xap::audioio::allocate_object(
+                allocator,
+                options.shard_count * 
+                    sizeof(struct xap::audioio::PromptCacheShard_)
+            )
+        );
+    size_t i = 0U;
+    try {
+        for (; i < options.shard_count; ++i) {
+            new (&(this->m_shards[i])) struct xap::audioio::PromptCacheShard_(
+                allocator
+            );
+        }
+    } catch (...) {
+        while (i != 0U) {
+            this->m_shards[--i].~PromptCacheShard_();
+        }
+        xap::audioio::free_object(this->m_shards);
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+PromptCache::~PromptCache() noexcept {
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        this->m_shards[i].~PromptCacheShard_();
+    }
+    xap::audioio::free_object(this->m_shards);
+}
+
+//
+//  PromptCache public methods.
+//
+
+/**
+ *  Load a prompt (thread-safe, decodes the file if it is not cached).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_IO:
+ *              The file cannot be opened or read.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The file is not supported or cannot be converted to the 
+ *              format.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The format is invalid.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param path
+ *      The path of the file.
+ *  @param format
+ *      The audio format (16-bit, 32-bit or 32-bit float).
+ *  @return
+ *      The decoded audio data (shared with the cache, must not be 
+ *      modified).
+ */
+xap::audioio::AudioBuffer PromptCache::load(
+    const char                       *path,
+    const xap::audioio::AudioFormat  &format
+) {
+    try {
+        xap::audioio::PromptCacheString key = get_prompt_key(
+            path,
+            format,
+            this->m_allocator
+        );
+        struct xap::audioio::PromptCacheShard_ *shard = 
+            &(this->m_shards[
+                xap::audioio::PromptCacheKeyHash()(key) % this->m_shard_count
+            ]);
+
+        //  Look up.
+        {
+            std::lock_guard<std::mutex> guard(shard->lock);
+            auto it = shard->lookup.find(key);
+            if (it != shard->lookup.end()) {
+                shard->entries.splice(
+                    shard->entries.begin(),
+                    shard->entries,
+                    it->second
+                );
+                shard->hit_count.fetch_add(1U, std::memory_order_relaxed);
+                return it->second->buffer;
+            }
+        }
+
+        //  Decode (without the lock, lookups of the shard go on).
+        shard->miss_count.fetch_add(1U, std::memory_order_relaxed);
+        xap::audioio::AudioBuffer buffer = decode_prompt(
+            path,
+            format,
+            this->m_allocator
+        );
+        size_t size = buffer.get_length();
+        size_t shard_budget = 
+            this->m_budget.load(std::memory_order_relaxed) / 
+            this->m_shard_count;
+        if (size > shard_budget) {
+            //  Never fits, not cached.
+            return buffer;
+        }
+
+        //  Insert (unless another thread has decoded it meanwhile).
+        std::lock_guard<std::mutex> guard(shard->lock);
+        auto it = shard->lookup.find(key);
+        if (it != shard->lookup.end()) {
+            shard->entries.splice(
+                shard->entries.begin(),
+                shard->entries,
+                it->second
+            );
+            return it->second->buffer;
+        }
+        xap::audioio::PromptCacheEntry entry = {
+            key,
+            xap::audioio::PromptCacheString(
+                path,
+                xap::audioio::StlAllocator<char>(this->m_allocator)
+            ),
+            buffer,
+            size
+        };
+        shard->entries.push_front(std::move(entry));
+        try {
+            shard->lookup.emplace(key, shard->entries.begin());
+        } catch (...) {
+            shard->entries.pop_front();
+            throw;
+        }
+        shard->size += size;
+        this->m_size.fetch_add(size, std::memory_order_relaxed);
+        this->evict(shard);
+        return buffer;
+    } catch (std::bad_alloc&) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+}
+
+/**
+ *  Remove a prompt (in all formats, thread-safe).
+ * 
+ *  @param path
+ *      The path of the file.
+ */
+void PromptCache::remove(const char *path) noexcept {
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        struct xap::audioio::PromptCacheShard_ *shard = &(this->m_shards[i]);
+        std::lock_guard<std::mutex> guard(shard->lock);
+        auto it = shard->entries.begin();
+        while (it != shard->entries.end()) {
+            if (it->path.compare(path) != 0) {
+                ++it;
+                continue;
+            }
+            shard->lookup.erase(it->key);
+            shard->size -= it->size;
+            this->m_size.fetch_sub(it->size, std::memory_order_relaxed);
+            it = shard->entries.erase(it);
+        }
+    }
+}
+
+/**
+ *  Remove all prompts (thread-safe).
+ */
+void PromptCache::clear() noexcept {
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        struct xap::audioio::PromptCacheShard_ *shard = &(this->m_shards[i]);
+        std::lock_guard<std::mutex> guard(shard->lock);
+        shard->lookup.clear();
+        shard->entries.clear();
+        this->m_size.fetch_sub(shard->size, std::memory_order_relaxed);
+        shard->size = 0U;
+    }
+}
+
+/**
+ *  Set the budget (thread-safe, evicts prompts if needed).
+ * 
+ *  @param budget
+ *      The budget (in bytes).
+ */
+void PromptCache::set_budget(size_t budget) noexcept {
+    this->m_budget.store(budget, std::memory_order_relaxed);
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        struct xap::audioio::PromptCacheShard_ *shard = &(this->m_shards[i]);
+        std::lock_guard<std::mutex> guard(shard->lock);
+        this->evict(shard);
+    }
+}
+
+/**
+ *  Get the budget.
+ * 
+ *  @return
+ *      The budget (in bytes).
+ */
+size_t PromptCache::get_budget() const noexcept {
+    return this->m_budget.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Get the size of the cached audio data.
+ * 
+ *  @return
+ *      The size (in bytes).
+ */
+size_t PromptCache::get_size() const noexcept {
+    return this->m_size.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Get the count of lookups which found the prompt cached.
+ * 
+ *  @return
+ *      The count of lookups.
+ */
+uint64_t PromptCache::get_hit_count() const noexcept {
+    uint64_t count = 0U;
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        count += this->m_shards[i].hit_count.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+/**
+ *  Get the count of lookups which decoded the prompt.
+ * 
+ *  @return
+ *      The count of lookups.
+ */
+uint64_t PromptCache::get_miss_count() const noexcept {
+    uint64_t count = 0U;
+    for (size_t i = 0U; i < this->m_shard_count; ++i) {
+        count += this->m_shards[i].miss_count.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+//
+//  PromptCache private methods.
+//
+
+/**
+ *  Evict the least recently used prompts of a shard until it fits in its 
+ *  share of the budget (the lock of the shard is held).
+ * 
+ *  @param shard
+ *      The shard.
+ */
+void PromptCache::evict(
+    struct xap::audioio::PromptCacheShard_  *shard
+) noexcept {
+    size_t shard_budget = 
+        this->m_budget.load(std::memory_order_relaxed) / this->m_shard_count;
+    while (shard->size > shard_budget && !shard->entries.empty()) {
+        //  The audio data is released once its last player dropped it.
+        xap::audioio::PromptCacheEntry &entry = shard->entries.back();
+        shard->lookup.erase(entry.key);
+        shard->size -= entry.size;
+        this->m_size.fetch_sub(entry.size, std::memory_order_relaxed);
+        shard->entries.pop_back();
+    }
+}
+
+//
+//  PromptSource constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @param prompt
+ *      The decoded audio data (shared).
+ */
+PromptSource::PromptSource(const xap::audioio::AudioBuffer &prompt) noexcept:
+    m_prompt(prompt),
+    m_frame_size(0U),
+    m_position(0U) {
+    if (prompt.get_frame_count() != 0U) {
+        this->m_frame_size = prompt.get_length() / prompt.get_frame_count();
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+PromptSource::~PromptSource() noexcept {
+    //  Nothing.
+}
+
+//
+//  PromptSource public methods.
+//
+
+/**
+ *  Read audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (less than requested at the end of the 
+ *      prompt).
+ */
+size_t PromptSource::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_prompt.get_sample_format() || 
+        output.get_channel_count() != this->m_prompt.get_channel_count() || 
+        output.get_sample_rate() != this->m_prompt.get_sample_rate()) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    size_t position = this->m_position.load(std::memory_order_relaxed);
+    size_t frame_count = this->m_prompt.get_frame_count();
+    size_t read_count = std::min(
+        output.get_frame_count(),
+        frame_count - std::min(position, frame_count)
+    );
+    if (read_count != 0U) {
+        memcpy(
+            output.get_pointer(),
+            this->m_prompt.get_samples<uint8_t>() + 
+                position * this->m_frame_size,
+            read_count * this->m_frame_size
+        );
+        this->m_position.store(
+            position + read_count,
+            std::memory_order_relaxed
+        );
+    }
+    return read_count;
+}
+
+/**
+ *  Seek (on the audio thread, or while the source is not played).
+ * 
+ *  @param frame
+ *      The position (in frames, clamped to the length).
+ */
+void PromptSource::seek(size_t frame) noexcept {
+    this->m_position.store(
+        std::min(frame, this->m_prompt.get_frame_count()),
+        std::memory_order_relaxed
+    );
+}
+
+/**
+ *  Get the position of the next frame read.
+ * 
+ *  @return
+ *      The position (in frames).
+ */
+size_t PromptSource::get_position() const noexcept {
+    return this->m_position.load(std::memory_order_relaxed);
+}
+
+/**
+ *  Get whether all frames were read.
+ * 
+ *  @return
+ *      True if so.
+ */
+bool PromptSource::is_finished() const noexcept {
+    return this->m_position.load(std::memory_order_relaxed) >= 
+           this->m_prompt.get_frame_count();
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Get the process-wide prompt cache (created with the default options at 
+ *  the first call).
+ * 
+ *  @return
+ *      The prompt cache.
+ */
+xap::audioio::PromptCache &get_default_prompt_cache() {
+    static xap::audioio::PromptCache cache;
+    return cache;
+}
+
+}  //  namespace audioio
+}  //  namespace xap
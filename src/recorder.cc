@@ -7,10 +7,13 @@
 //
 //  Imports.
 //
+#include "allocator_p.h"
 #include "error_p.h"
 #include "recorder_p.h"
 
+#include <algorithm>
 #include <mutex>
+#include <string.h>
 #include <xap/audioio/recorder.h>
 
 namespace xap {
@@ -28,18 +31,68 @@ namespace audioio {
  *          - xap::audioio::ERROR_PORTAUDIOCALL:
  *              PortAudio calling occurred error.
  * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
  *  @param options
  *      The recorder options.
+ *  @param allocator
+ *      The allocator.
  */
 Recorder::Recorder(
-    const xap::audioio::RecorderOptions &options
+    const xap::audioio::RecorderOptions &options,
+    xap::audioio::IAllocator            *allocator
 ) :
     m_audio_callback(),
+    m_frame_callback(),
     m_error_callback(),
     m_options(options),
     m_stream(nullptr),
-    m_is_running(false)
+    m_is_running(false),
+    m_is_paused(false),
+    m_frame_size(static_cast<size_t>(options.channel_count) * 2U),  //  16-bit
+    m_has_audio_callback(false),
+    m_has_frame_callback(false),
+    m_format(),
+    m_max_block_frames(
+        options.frame_pre_buffer != 0U ? 
+            options.frame_pre_buffer : 
+            xap::audioio::RECORDER_DEFAULT_BLOCK_FRAMES
+    ),
+    m_pool(
+        m_max_block_frames * m_frame_size, 
+        xap::audioio::RECORDER_POOL_BLOCK_COUNT, 
+        allocator
+    ),
+    m_audio_buffer(),
+    m_audio_fill(0U),
+    m_position(0),
+    m_stages(
+        xap::audioio::StlAllocator<std::shared_ptr<xap::audioio::IStage>>(
+            allocator
+        )
+    )
 {
+    this->m_format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    this->m_format.channel_count = options.channel_count;
+    this->m_format.sample_rate = static_cast<uint32_t>(options.sample_rate);
+
+    //
+    //  Preallocate the audio callback buffer (one block, never reallocated 
+    //  in the callback, see m_audio_fill).
+    //
+    try {
+        this->m_audio_buffer = xap::core::buffer::Buffer(
+            this->m_max_block_frames * this->m_frame_size, 
+            false
+        );
+    } catch (xap::core::buffer::BufferException &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_ALLOC
+        );
+    }
+
     //
     //  Initialize PortAudio.
     //
@@ -101,6 +154,52 @@ Recorder::~Recorder() noexcept {
     Pa_Terminate();
 }
 
+/**
+ *  Allocate the memory of the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed 
+ *      (xap::audioio::ERROR_ALLOC).
+ *  @param size
+ *      The size of the object.
+ *  @param allocator
+ *      The allocator.
+ *  @return
+ *      The memory.
+ */
+void *Recorder::operator new(
+    size_t                     size, 
+    xap::audioio::IAllocator  *allocator
+) {
+    return xap::audioio::allocate_object(allocator, size);
+}
+
+/**
+ *  Release the memory of the object (allocated by operator new).
+ * 
+ *  @param pointer
+ *      The memory.
+ */
+void Recorder::operator delete(void *pointer) noexcept {
+    xap::audioio::free_object(pointer);
+}
+
+/**
+ *  Release the memory of the object if its constructor raised.
+ * 
+ *  @param pointer
+ *      The memory.
+ *  @param allocator
+ *      The allocator.
+ */
+void Recorder::operator delete(
+    void                      *pointer, 
+    xap::audioio::IAllocator  *allocator
+) noexcept {
+    (void)allocator;
+    xap::audioio::free_object(pointer);
+}
+
 //
 //  Recorder public methods.
 //
@@ -125,6 +224,10 @@ void Recorder::start() {
         );
     }
 
+    this->m_is_paused.store(false);
+    this->m_position = 0;
+    this->m_audio_fill = 0U;
+
     xap::audioio::pacall_assert(Pa_StartStream(this->m_stream));
 
     this->m_is_running = true;
@@ -148,6 +251,7 @@ void Recorder::set_audio_callback(
         //
         std::lock_guard<std::mutex> lock(this->m_audio_callback_lock);
         this->m_audio_callback = callback;
+        this->m_has_audio_callback.store(static_cast<bool>(callback));
     } catch (std::system_error &error) {
         throw xap::audioio::Exception(
             error.what(), 
@@ -156,6 +260,83 @@ void Recorder::set_audio_callback(
     }
 }
 
+/**
+ *  Set frame callback.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if system (lock) calling occurred error. 
+ *      (xap::audioio::ERROR_SYSTEMCALL)
+ *  @param callback
+ *      The callback.
+ */
+void Recorder::set_frame_callback(
+    std::function<void(const xap::audioio::AudioBuffer &)> &callback
+) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_frame_callback_lock);
+        this->m_frame_callback = callback;
+        this->m_has_frame_callback.store(static_cast<bool>(callback));
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(), 
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Append a processing stage.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The recorder is running.
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The stage is nullptr.
+ * 
+ *  @param stage
+ *      The stage.
+ */
+void Recorder::add_stage(const std::shared_ptr<xap::audioio::IStage> &stage) {
+    if (this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The recorder is running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    if (!stage) {
+        throw xap::audioio::Exception(
+            "The stage is null.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    this->m_stages.push_back(stage);
+}
+
+/**
+ *  Remove all processing stages.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the recorder is running 
+ *      (xap::audioio::ERROR_INVALIDOPERATION).
+ */
+void Recorder::clear_stages() {
+    if (this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The recorder is running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    this->m_stages.clear();
+}
+
 /**
  *  Set error callback.
  * 
@@ -211,6 +392,69 @@ void Recorder::stop(bool forcibly) {
     }
 
     this->m_is_running = false;
+    this->m_is_paused.store(false);
+}
+
+/**
+ *  Pause recorder.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The recorder is not running or was already paused.
+ */
+void Recorder::pause() {
+    if (!this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The recorder is not running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    bool expected = false;
+    if (!this->m_is_paused.compare_exchange_strong(expected, true)) {
+        throw xap::audioio::Exception(
+            "The recorder was already paused.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+}
+
+/**
+ *  Resume recorder.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_INVALIDOPERATION:
+ *              The recorder is not running or is not paused.
+ */
+void Recorder::resume() {
+    if (!this->m_is_running) {
+        throw xap::audioio::Exception(
+            "The recorder is not running.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    bool expected = true;
+    if (!this->m_is_paused.compare_exchange_strong(expected, false)) {
+        throw xap::audioio::Exception(
+            "The recorder is not paused.",
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+}
+
+/**
+ *  Get whether the recorder is paused.
+ * 
+ *  @return
+ *      True if paused.
+ */
+bool Recorder::is_paused() const noexcept {
+    return this->m_is_paused.load();
 }
 
 //
@@ -253,6 +497,98 @@ void Recorder::emit_audio_callback(const xap::core::buffer::Buffer &data) {
     }
 }
 
+/**
+ *  Emit frame callback event.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param data
+ *      The audio data (parameter 'data').
+ */
+void Recorder::emit_frame_callback(const xap::audioio::AudioBuffer &data) {
+    try {
+        //
+        //  Lock.
+        //
+        std::lock_guard<std::mutex> lock(this->m_frame_callback_lock);
+
+        this->m_frame_callback(data);
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(), 
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    } catch (std::exception &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_CALLBACK
+        );
+    }
+}
+
+/**
+ *  Deliver captured audio data to the stages and the frame callback 
+ *  (copied to pooled audio buffers, one per period or per pool block).
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              No pooled audio buffer is available.
+ * 
+ *          - xap::audioio::ERROR_SYSTEMCALL:
+ *              System (lock) calling occurred error.
+ * 
+ *          - xap::audioio::ERROR_CALLBACK:
+ *              Callback occurred error.
+ * 
+ *  @param input
+ *      The captured audio data.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void Recorder::dispatch_frames(const uint8_t *input, size_t frame_count) {
+    size_t offset = 0U;
+    while (offset < frame_count) {
+        size_t count = frame_count - offset;
+        if (count > this->m_max_block_frames) {
+            count = this->m_max_block_frames;
+        }
+
+        xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+            this->m_pool, 
+            this->m_format, 
+            count
+        );
+        memcpy(
+            data.get_pointer(), 
+            input + offset * this->m_frame_size, 
+            count * this->m_frame_size
+        );
+        data.set_timestamp(this->m_position + static_cast<int64_t>(offset));
+
+        //
+        //  Run stages.
+        //
+        for (auto &stage : this->m_stages) {
+            stage->process(data);
+        }
+
+        if (this->m_has_frame_callback.load(std::memory_order_acquire)) {
+            this->emit_frame_callback(data);
+        }
+
+        offset += count;
+    }
+}
+
 /**
  *  Emit error callback event.
  * 
@@ -293,12 +629,25 @@ void Recorder::emit_error_callback(const xap::audioio::Exception &error) {
 //  RecorderFactory constructor & destructor.
 //
 
+/**
+ *  Construct the object (with the default allocator).
+ */
+RecorderFactory::RecorderFactory() noexcept :
+    m_allocator(xap::audioio::get_default_allocator())
+{}
+
 /**
  *  Construct the object.
+ * 
+ *  @param allocator
+ *      The allocator used by all recorders created by the factory (must 
+ *      outlive the recorders).
  */
-RecorderFactory::RecorderFactory() noexcept {
-    //  Do nothing.
-}
+RecorderFactory::RecorderFactory(xap::audioio::IAllocator *allocator) noexcept :
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{}
 
 /**
  *  Destruct the object.
@@ -333,7 +682,11 @@ std::unique_ptr<xap::audioio::IRecorder> RecorderFactory::load_unique_pointer(
     const xap::audioio::RecorderOptions &options
 ) {
     try {
-        xap::audioio::IRecorder *ptr = new xap::audioio::Recorder(options);
+        xap::audioio::IRecorder *ptr = 
+            new (this->m_allocator) xap::audioio::Recorder(
+                options, 
+                this->m_allocator
+            );
         return std::unique_ptr<xap::audioio::IRecorder>(ptr);
     } catch (xap::audioio::Exception &error) {
         throw xap::audioio::Exception(error.what(), xap::audioio::ERROR_ALLOC);
@@ -362,8 +715,18 @@ std::shared_ptr<xap::audioio::IRecorder> RecorderFactory::load_shared_pointer(
     const xap::audioio::RecorderOptions &options
 ) {
     try {
-        xap::audioio::IRecorder *ptr = new xap::audioio::Recorder(options);
-        return std::shared_ptr<xap::audioio::IRecorder>(ptr);
+        xap::audioio::IRecorder *ptr = 
+            new (this->m_allocator) xap::audioio::Recorder(
+                options, 
+                this->m_allocator
+            );
+        return std::shared_ptr<xap::audioio::IRecorder>(
+            ptr,
+            std::default_delete<xap::audioio::IRecorder>(),
+            xap::audioio::StlAllocator<xap::audioio::IRecorder>(
+                this->m_allocator
+            )
+        );
     } catch (std::bad_alloc &error) {
         throw xap::audioio::Exception(error.what(), xap::audioio::ERROR_ALLOC);
     }
@@ -391,7 +754,10 @@ xap::audioio::IRecorder *RecorderFactory::new_instance(
     const xap::audioio::RecorderOptions &options
 ) {
     try {
-        return new xap::audioio::Recorder(options);
+        return new (this->m_allocator) xap::audioio::Recorder(
+            options, 
+            this->m_allocator
+        );
     } catch (std::bad_alloc &error) {
         throw xap::audioio::Exception(error.what(), xap::audioio::ERROR_ALLOC);
     }
@@ -426,7 +792,8 @@ void RecorderFactory::free_instance(xap::audioio::IRecorder **instance) {
         );
     }
 
-    free(*instance);
+    //  Released by the allocator (see Recorder::operator delete).
+    delete *instance;
     *instance = nullptr;
 }
 
@@ -463,13 +830,52 @@ static int xap_pa_record_callback(
     void                            *user_data
 ) {
     Recorder *recorder = reinterpret_cast<Recorder *>(user_data);
+    const uint8_t *input = reinterpret_cast<const uint8_t *>(input_buffer);
+    size_t frame_count = static_cast<size_t>(frames_per_buffer);
+
+    //
+    //  Discard captured audio data while paused.
+    //
+    if (recorder->m_is_paused.load(std::memory_order_acquire)) {
+        recorder->m_position += static_cast<int64_t>(frame_count);
+        return paContinue;
+    }
+
     try {
-        xap::core::buffer::Buffer audio_data(
-            reinterpret_cast<const uint8_t *>(input_buffer),
-            static_cast<size_t>(frames_per_buffer) * 2U  //  16-bit
-        );
-        
-        recorder->emit_audio_callback(audio_data);
+        if (recorder->m_has_audio_callback.load(std::memory_order_acquire)) {
+            //
+            //  The audio callback receives one block at a time, the audio 
+            //  data which does not fill a block is kept for the next 
+            //  period (the host may vary the count of frames per buffer).
+            //
+            xap::core::buffer::Buffer &data = recorder->m_audio_buffer;
+            size_t block_length = data.get_length();
+            size_t length = frame_count * recorder->m_frame_size;
+            size_t offset = 0U;
+            while (offset < length) {
+                size_t count = std::min(
+                    length - offset, 
+                    block_length - recorder->m_audio_fill
+                );
+                memcpy(
+                    data.get_pointer() + recorder->m_audio_fill, 
+                    input + offset, 
+                    count
+                );
+                recorder->m_audio_fill += count;
+                offset += count;
+                if (recorder->m_audio_fill == block_length) {
+                    recorder->m_audio_fill = 0U;
+                    recorder->emit_audio_callback(data);
+                }
+            }
+        }
+        if (
+            recorder->m_has_frame_callback.load(std::memory_order_acquire) || 
+            !recorder->m_stages.empty()
+        ) {
+            recorder->dispatch_frames(input, frame_count);
+        }
     } catch (xap::core::buffer::BufferException &error) {
         recorder->emit_error_callback(
             xap::audioio::Exception(
@@ -493,6 +899,8 @@ static int xap_pa_record_callback(
             //  Do nothing.
         }
     }
+
+    recorder->m_position += static_cast<int64_t>(frame_count);
     
     return paContinue;
 }
@@ -10,13 +10,29 @@
 //
 //  Imports.
 //
+#include "allocator_p.h"
+
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <portaudio.h>
+#include <vector>
 #include <xap/audioio/recorder.h>
 
 namespace xap {
 namespace audioio {
 
+//
+//  Constants.
+//
+
+//  Count of frames of each pooled audio buffer if the frames per buffer was 
+//  not specified.
+const static size_t RECORDER_DEFAULT_BLOCK_FRAMES = 4096U;
+
+//  Count of pooled audio buffers.
+const static size_t RECORDER_POOL_BLOCK_COUNT = 16U;
+
 //
 //  Declare.
 //
@@ -73,16 +89,63 @@ public:
      *          - xap::audioio::ERROR_PORTAUDIOCALL:
      *              PortAudio calling occurred error.
      * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              Memory allocation was failed.
+     * 
      *  @param options
      *      The recorder options.
+     *  @param allocator
+     *      The allocator.
      */
-    Recorder(const xap::audioio::RecorderOptions &options);
+    Recorder(
+        const xap::audioio::RecorderOptions &options,
+        xap::audioio::IAllocator            *allocator
+    );
 
     /**
      *  Destruct the object.
      */
     virtual ~Recorder() noexcept;
 
+    /**
+     *  Allocate the memory of the object.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if memory allocation was failed 
+     *      (xap::audioio::ERROR_ALLOC).
+     *  @param size
+     *      The size of the object.
+     *  @param allocator
+     *      The allocator.
+     *  @return
+     *      The memory.
+     */
+    static void *operator new(
+        size_t                     size, 
+        xap::audioio::IAllocator  *allocator
+    );
+
+    /**
+     *  Release the memory of the object (allocated by operator new).
+     * 
+     *  @param pointer
+     *      The memory.
+     */
+    static void operator delete(void *pointer) noexcept;
+
+    /**
+     *  Release the memory of the object if its constructor raised.
+     * 
+     *  @param pointer
+     *      The memory.
+     *  @param allocator
+     *      The allocator.
+     */
+    static void operator delete(
+        void                      *pointer, 
+        xap::audioio::IAllocator  *allocator
+    ) noexcept;
+
     //
     //  Public methods.
     //
@@ -114,6 +177,47 @@ public:
         std::function<void(const xap::core::buffer::Buffer &)> &callback
     ) override;
 
+    /**
+     *  Set frame callback.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if system (lock) calling occurred error. 
+     *      (xap::audioio::ERROR_SYSTEMCALL)
+     *  @param callback
+     *      The callback.
+     */
+    virtual void set_frame_callback(
+        std::function<void(const xap::audioio::AudioBuffer &)> &callback
+    ) override;
+
+    /**
+     *  Append a processing stage.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The recorder is running.
+     * 
+     *          - xap::audioio::ERROR_PARAMETER:
+     *              The stage is nullptr.
+     * 
+     *  @param stage
+     *      The stage.
+     */
+    virtual void add_stage(
+        const std::shared_ptr<xap::audioio::IStage> &stage
+    ) override;
+
+    /**
+     *  Remove all processing stages.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if the recorder is running 
+     *      (xap::audioio::ERROR_INVALIDOPERATION).
+     */
+    virtual void clear_stages() override;
+
     /**
      *  Set error callback.
      * 
@@ -144,6 +248,36 @@ public:
      */
     virtual void stop(bool forcibly = false) override;
 
+    /**
+     *  Pause recorder.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The recorder is not running or was already paused.
+     */
+    virtual void pause() override;
+
+    /**
+     *  Resume recorder.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_INVALIDOPERATION:
+     *              The recorder is not running or is not paused.
+     */
+    virtual void resume() override;
+
+    /**
+     *  Get whether the recorder is paused.
+     * 
+     *  @return
+     *      True if paused.
+     */
+    virtual bool is_paused() const noexcept override;
+
 private:
     //
     //  Private methods.
@@ -166,6 +300,46 @@ private:
      */
     void emit_audio_callback(const xap::core::buffer::Buffer &data);
 
+    /**
+     *  Emit frame callback event.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param data
+     *      The audio data (parameter 'data').
+     */
+    void emit_frame_callback(const xap::audioio::AudioBuffer &data);
+
+    /**
+     *  Deliver captured audio data to the stages and the frame callback 
+     *  (copied to pooled audio buffers, one per period or per pool block).
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised in the following situations:
+     * 
+     *          - xap::audioio::ERROR_ALLOC:
+     *              No pooled audio buffer is available.
+     * 
+     *          - xap::audioio::ERROR_SYSTEMCALL:
+     *              System (lock) calling occurred error.
+     * 
+     *          - xap::audioio::ERROR_CALLBACK:
+     *              Callback occurred error.
+     * 
+     *  @param input
+     *      The captured audio data.
+     *  @param frame_count
+     *      The count of frames.
+     */
+    void dispatch_frames(const uint8_t *input, size_t frame_count);
+
     /**
      *  Emit error callback event.
      * 
@@ -189,6 +363,9 @@ private:
     std::function <void(const xap::core::buffer::Buffer &)> 
         m_audio_callback;
     std::mutex                                        m_audio_callback_lock;
+    std::function <void(const xap::audioio::AudioBuffer &)> 
+        m_frame_callback;
+    std::mutex                                        m_frame_callback_lock;
     std::function <void(const xap::audioio::Exception &)>   
         m_error_callback;
     std::mutex                                        m_error_callback_lock;
@@ -196,6 +373,20 @@ private:
     PaStreamParameters                                m_pa_parameters;
     PaStream                                         *m_stream;
     bool                                              m_is_running;
+    std::atomic<bool>                                 m_is_paused;
+    size_t                                            m_frame_size;
+    std::atomic<bool>                                 m_has_audio_callback;
+    std::atomic<bool>                                 m_has_frame_callback;
+    xap::audioio::AudioFormat                         m_format;
+    size_t                                            m_max_block_frames;
+    xap::audioio::AudioBufferPool                     m_pool;
+    xap::core::buffer::Buffer                         m_audio_buffer;
+    size_t                                            m_audio_fill;
+    int64_t                                           m_position;
+    std::vector<
+        std::shared_ptr<xap::audioio::IStage>, 
+        xap::audioio::StlAllocator<std::shared_ptr<xap::audioio::IStage>>
+    >                                                 m_stages;
 
     //
     //  Friend functions.
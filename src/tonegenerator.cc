@@ -0,0 +1,765 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+#include "fir_p.h"
+#include "mpscqueue_p.h"
+
+#include <math.h>
+#include <string.h>
+#include <xap/audioio/error.h>
+#include <xap/audioio/tonegenerator.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xap {
+namespace audioio {
+
+//
+//  Private constants.
+//
+const static double TONEGENERATOR_PI = 3.14159265358979323846;
+
+//  Count of frames mixed per pass.
+const static size_t TONEGENERATOR_CHUNK_FRAMES = 256U;
+
+//  Command types.
+const static uint32_t TONEGENERATOR_COMMAND_PLAY = 1U;
+const static uint32_t TONEGENERATOR_COMMAND_STOP = 2U;
+
+//  Voices: the playing one and the one fading out.
+const static size_t TONEGENERATOR_VOICE_PLAYING = 0U;
+const static size_t TONEGENERATOR_VOICE_RELEASING = 1U;
+
+//  DTMF frequencies.
+const static float TONEGENERATOR_DTMF_ROWS[4] = {
+    697.0F, 770.0F, 852.0F, 941.0F
+};
+const static float TONEGENERATOR_DTMF_COLUMNS[4] = {
+    1209.0F, 1336.0F, 1477.0F, 1633.0F
+};
+const static char TONEGENERATOR_DTMF_DIGITS[] = "123A456B789C*0#D";
+
+//
+//  Private structures.
+//
+
+/**
+ *  Command.
+ */
+typedef struct ToneCommand_ {
+    int64_t                     start;
+    uint32_t                    type;
+    uint8_t                     __pad1[4];
+    xap::audioio::ToneSequence  sequence;
+} ToneCommand;
+
+/**
+ *  Voice (a playing tone sequence).
+ */
+typedef struct ToneVoice_ {
+    bool                        is_active;
+    bool                        is_releasing;
+    uint8_t                     __pad1[6];
+    xap::audioio::ToneSequence  sequence;
+
+    //  Position in the sequence.
+    size_t                      segment;
+    uint32_t                    repeat;
+    uint8_t                     __pad2[4];
+    size_t                      position;
+
+    //  The current segment (in frames).
+    size_t                      on_frames;
+    size_t                      total_frames;
+    size_t                      ramp_frames;
+
+    //  Oscillators (phase and phase increment per frame, in radians).
+    double                      phases[2];
+    double                      increments[2];
+
+    //  Fade-out.
+    float                       release_gain;
+    uint8_t                     __pad3[4];
+    size_t                      release_position;
+    size_t                      release_frames;
+} ToneVoice;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Add a tone with a linear gain ramp to the mix.
+ * 
+ *  @param mix
+ *      The mix.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param phase
+ *      The phase (updated).
+ *  @param increment
+ *      The phase increment per frame.
+ *  @param gain
+ *      The gain of the first frame.
+ *  @param step
+ *      The gain increment per frame.
+ */
+static void oscillate(
+    float  *mix,
+    size_t  frame_count,
+    double &phase,
+    double  increment,
+    float   gain,
+    float   step
+) noexcept {
+    size_t i = 0U;
+
+#if defined(__SSE2__)
+    //
+    //  4 frames per operation: each lane rotates its phasor by 4 * increment.
+    //
+    if (frame_count >= 4U) {
+        float lane_re[4];
+        float lane_im[4];
+        for (size_t k = 0U; k < 4U; ++k) {
+            double angle = phase + increment * static_cast<double>(k);
+            lane_re[k] = static_cast<float>(cos(angle));
+            lane_im[k] = static_cast<float>(sin(angle));
+        }
+        __m128 re = _mm_loadu_ps(lane_re);
+        __m128 im = _mm_loadu_ps(lane_im);
+        __m128 rotation_re = _mm_set1_ps(static_cast<float>(cos(4.0 * increment)));
+        __m128 rotation_im = _mm_set1_ps(static_cast<float>(sin(4.0 * increment)));
+        __m128 gains = _mm_add_ps(
+            _mm_set1_ps(gain), 
+            _mm_mul_ps(_mm_set1_ps(step), _mm_set_ps(3.0F, 2.0F, 1.0F, 0.0F))
+        );
+        __m128 gain_step = _mm_set1_ps(step * 4.0F);
+        for (; i + 4U <= frame_count; i += 4U) {
+            _mm_storeu_ps(mix + i, _mm_add_ps(
+                _mm_loadu_ps(mix + i), 
+                _mm_mul_ps(gains, im)
+            ));
+            __m128 next_re = _mm_sub_ps(
+                _mm_mul_ps(re, rotation_re), 
+                _mm_mul_ps(im, rotation_im)
+            );
+            im = _mm_add_ps(
+                _mm_mul_ps(re, rotation_im), 
+                _mm_mul_ps(im, rotation_re)
+            );
+            re = next_re;
+            gains = _mm_add_ps(gains, gain_step);
+        }
+    }
+#else
+    //
+    //  Rotating phasor.
+    //
+    float re = static_cast<float>(cos(phase));
+    float im = static_cast<float>(sin(phase));
+    float rotation_re = static_cast<float>(cos(increment));
+    float rotation_im = static_cast<float>(sin(increment));
+    for (; i < frame_count; ++i) {
+        mix[i] += (gain + step * static_cast<float>(i)) * im;
+        float next_re = re * rotation_re - im * rotation_im;
+        im = re * rotation_im + im * rotation_re;
+        re = next_re;
+    }
+#endif
+
+    //
+    //  Remaining frames.
+    //
+    for (; i < frame_count; ++i) {
+        double angle = phase + increment * static_cast<double>(i);
+        mix[i] += (gain + step * static_cast<float>(i)) * 
+                  static_cast<float>(sin(angle));
+    }
+
+    //
+    //  Keep the phase exact (no accumulated drift).
+    //
+    phase = fmod(
+        phase + increment * static_cast<double>(frame_count), 
+        2.0 * TONEGENERATOR_PI
+    );
+}
+
+/**
+ *  Get the envelope of a voice at its position.
+ * 
+ *  @param voice
+ *      The voice.
+ *  @return
+ *      The envelope (0 - 1).
+ */
+static float get_envelope(const ToneVoice &voice) noexcept {
+    if (voice.is_releasing) {
+        return voice.release_gain * (1.0F - 
+            static_cast<float>(voice.release_position) / 
+            static_cast<float>(voice.release_frames));
+    }
+    if (voice.position >= voice.on_frames) {
+        return 0.0F;
+    }
+    size_t ramp = voice.ramp_frames;
+    if (voice.position < ramp) {
+        return static_cast<float>(voice.position) / static_cast<float>(ramp);
+    }
+    if (voice.position >= voice.on_frames - ramp) {
+        return static_cast<float>(voice.on_frames - voice.position) / 
+               static_cast<float>(ramp);
+    }
+    return 1.0F;
+}
+
+//
+//  Public functions.
+//
+
+/**
+ *  Build a tone sequence of DTMF digits.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if a digit is invalid or there are too many digits 
+ *      (xap::audioio::ERROR_PARAMETER).
+ *  @param digits
+ *      The digits ('0' - '9', '*', '#', 'A' - 'D').
+ *  @param on_duration
+ *      The duration of each digit (in milliseconds).
+ *  @param off_duration
+ *      The pause after each digit (in milliseconds).
+ *  @param level
+ *      The amplitude of each tone (linear, 1.0 is full scale).
+ *  @return
+ *      The tone sequence (played once).
+ */
+xap::audioio::ToneSequence build_dtmf_sequence(
+    const char *digits,
+    uint32_t    on_duration,
+    uint32_t    off_duration,
+    float       level
+) {
+    xap::audioio::ToneSequence sequence;
+    memset(&sequence, 0, sizeof(sequence));
+    sequence.repeat_count = 1U;
+
+    size_t length = strlen(digits);
+    if (length == 0U || length > xap::audioio::TONEGENERATOR_MAX_SEGMENTS) {
+        throw xap::audioio::Exception(
+            "Invalid count of digits.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    for (size_t i = 0U; i < length; ++i) {
+        const char *found = strchr(TONEGENERATOR_DTMF_DIGITS, digits[i]);
+        if (found == nullptr) {
+            throw xap::audioio::Exception(
+                "Invalid digit.",
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+        size_t index = static_cast<size_t>(found - TONEGENERATOR_DTMF_DIGITS);
+        xap::audioio::ToneSegment &segment = sequence.segments[i];
+        segment.frequencies[0] = TONEGENERATOR_DTMF_ROWS[index / 4U];
+        segment.frequencies[1] = TONEGENERATOR_DTMF_COLUMNS[index % 4U];
+        segment.levels[0] = level;
+        segment.levels[1] = level;
+        segment.on_duration = on_duration;
+        segment.off_duration = off_duration;
+    }
+    sequence.segment_count = static_cast<uint32_t>(length);
+
+    return sequence;
+}
+
+//
+//  ToneGenerator constructor & destructor.
+//
+
+/**
+ *  Construct the object.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised in the following situations:
+ * 
+ *          - xap::audioio::ERROR_PARAMETER:
+ *              The command capacity is not a power of 2.
+ * 
+ *          - xap::audioio::ERROR_UNSUPPORTED:
+ *              The format is not 16-bit or 32-bit float.
+ * 
+ *          - xap::audioio::ERROR_ALLOC:
+ *              Memory allocation was failed.
+ * 
+ *  @param format
+ *      The audio format (the format of the player).
+ *  @param command_capacity
+ *      The maximum count of pending commands (a power of 2).
+ *  @param allocator
+ *      The allocator (nullptr for the default allocator).
+ */
+ToneGenerator::ToneGenerator(
+    const xap::audioio::AudioFormat &format,
+    size_t                           command_capacity,
+    xap::audioio::IAllocator        *allocator
+) :
+    m_format(format),
+    m_frames_per_ms(static_cast<double>(format.sample_rate) / 1000.0),
+    m_ramp_frames(0U),
+    m_commands(nullptr),
+    m_next(nullptr),
+    m_has_next(false),
+    m_voices(nullptr),
+    m_mix(nullptr),
+    m_position(0),
+    m_is_active(false),
+    m_allocator(
+        allocator != nullptr ? allocator : xap::audioio::get_default_allocator()
+    )
+{
+    if ((format.sample_format != xap::audioio::SAMPLEFORMAT_INT16 && 
+         format.sample_format != xap::audioio::SAMPLEFORMAT_FLOAT32) || 
+        format.channel_count == 0U || 
+        format.sample_rate == 0U) {
+        throw xap::audioio::Exception(
+            "Only 16-bit and 32-bit float audio data is supported.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    this->m_ramp_frames = static_cast<size_t>(
+        this->m_frames_per_ms * 
+            static_cast<double>(xap::audioio::TONEGENERATOR_RAMP_DURATION) + 
+        0.5
+    );
+
+    this->m_commands = xap::audioio::new_object<
+        xap::audioio::MpscQueue<ToneCommand>
+    >(this->m_allocator, command_capacity, this->m_allocator);
+    try {
+        this->m_next = xap::audioio::new_object<ToneCommand>(
+            this->m_allocator
+        );
+        this->m_voices = static_cast<ToneVoice *>(
+            xap::audioio::allocate_object(
+                this->m_allocator, 
+                sizeof(ToneVoice) * 2U
+            )
+        );
+        memset(this->m_voices, 0, sizeof(ToneVoice) * 2U);
+        this->m_mix = static_cast<float *>(xap::audioio::allocate_object(
+            this->m_allocator, 
+            sizeof(float) * TONEGENERATOR_CHUNK_FRAMES
+        ));
+    } catch (...) {
+        if (this->m_voices != nullptr) {
+            xap::audioio::free_object(this->m_voices);
+        }
+        if (this->m_next != nullptr) {
+            xap::audioio::free_object(this->m_next);
+        }
+        this->m_commands->~MpscQueue<ToneCommand>();
+        xap::audioio::free_object(this->m_commands);
+        throw;
+    }
+}
+
+/**
+ *  Destruct the object.
+ */
+ToneGenerator::~ToneGenerator() noexcept {
+    xap::audioio::free_object(this->m_mix);
+    xap::audioio::free_object(this->m_voices);
+    xap::audioio::free_object(this->m_next);
+    this->m_commands->~MpscQueue<ToneCommand>();
+    xap::audioio::free_object(this->m_commands);
+}
+
+//
+//  ToneGenerator public methods.
+//
+
+/**
+ *  Play a tone sequence (thread-safe, lock-free), replacing the current 
+ *  one.
+ * 
+ *  Commands are applied in the order they were posted, so their start 
+ *  frames should not decrease.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the sequence is invalid (no segment, too many segments 
+ *      or a segment without duration) (xap::audioio::ERROR_PARAMETER).
+ *  @param sequence
+ *      The tone sequence.
+ *  @param start
+ *      The frame to start at (see get_position(), negative to start 
+ *      immediately).
+ *  @return
+ *      True if posted, false if too many commands are pending.
+ */
+bool ToneGenerator::play(
+    const xap::audioio::ToneSequence &sequence, 
+    int64_t                           start
+) {
+    if (sequence.segment_count == 0U || 
+        sequence.segment_count > xap::audioio::TONEGENERATOR_MAX_SEGMENTS) {
+        throw xap::audioio::Exception(
+            "Invalid count of segments.",
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    for (size_t i = 0U; i < sequence.segment_count; ++i) {
+        const xap::audioio::ToneSegment &segment = sequence.segments[i];
+        if (static_cast<double>(segment.on_duration + segment.off_duration) * 
+                this->m_frames_per_ms < 1.0) {
+            throw xap::audioio::Exception(
+                "Segment without duration.",
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+    }
+
+    ToneCommand command;
+    memset(&command, 0, sizeof(command));
+    command.start = start;
+    command.type = TONEGENERATOR_COMMAND_PLAY;
+    command.sequence = sequence;
+    return this->m_commands->try_push(command);
+}
+
+/**
+ *  Stop the current tone sequence (thread-safe, lock-free).
+ * 
+ *  @param start
+ *      The frame to stop at (see get_position(), negative to stop 
+ *      immediately).
+ *  @return
+ *      True if posted, false if too many commands are pending.
+ */
+bool ToneGenerator::stop(int64_t start) noexcept {
+    ToneCommand command;
+    memset(&command, 0, sizeof(command));
+    command.start = start;
+    command.type = TONEGENERATOR_COMMAND_STOP;
+    return this->m_commands->try_push(command);
+}
+
+/**
+ *  Read audio data.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if the format of the output mismatched 
+ *      (xap::audioio::ERROR_UNSUPPORTED).
+ *  @param output
+ *      The output.
+ *  @return
+ *      The count of frames read (always all frames, silence if no tone 
+ *      is playing).
+ */
+size_t ToneGenerator::read(xap::audioio::AudioBuffer &output) {
+    if (output.get_sample_format() != this->m_format.sample_format || 
+        output.get_channel_count() != this->m_format.channel_count) {
+        throw xap::audioio::Exception(
+            "The format of the output mismatched.",
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    size_t frame_count = output.get_frame_count();
+    size_t channel_count = static_cast<size_t>(this->m_format.channel_count);
+    int64_t position = this->m_position.load(std::memory_order_relaxed);
+    size_t done = 0U;
+    while (done < frame_count) {
+        size_t count = frame_count - done;
+        if (count > TONEGENERATOR_CHUNK_FRAMES) {
+            count = TONEGENERATOR_CHUNK_FRAMES;
+        }
+
+        //
+        //  Apply due commands, end the pass at the next scheduled one.
+        //
+        while (true) {
+            if (!this->m_has_next) {
+                this->m_has_next = this->m_commands->try_pop(*(this->m_next));
+                if (!this->m_has_next) {
+                    break;
+                }
+            }
+            if (this->m_next->start > position) {
+                if (this->m_next->start < 
+                        position + static_cast<int64_t>(count)) {
+                    count = static_cast<size_t>(this->m_next->start - position);
+                }
+                break;
+            }
+            this->apply(*(this->m_next));
+            this->m_has_next = false;
+        }
+
+        //
+        //  Mix.
+        //
+        float *mix = this->m_mix;
+        memset(mix, 0, count * sizeof(float));
+        this->render(
+            this->m_voices[TONEGENERATOR_VOICE_RELEASING], 
+            mix, 
+            count
+        );
+        this->render(this->m_voices[TONEGENERATOR_VOICE_PLAYING], mix, count);
+
+        //
+        //  Convert.
+        //
+        if (this->m_format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+            int16_t *destination = 
+                output.get_samples<int16_t>() + done * channel_count;
+            for (size_t i = 0U; i < count; ++i) {
+                int16_t sample = 
+                    xap::audioio::fir_saturate_int16(mix[i] * 32767.0F);
+                for (size_t c = 0U; c < channel_count; ++c) {
+                    destination[i * channel_count + c] = sample;
+                }
+            }
+        } else {
+            float *destination = 
+                output.get_samples<float>() + done * channel_count;
+            for (size_t i = 0U; i < count; ++i) {
+                for (size_t c = 0U; c < channel_count; ++c) {
+                    destination[i * channel_count + c] = mix[i];
+                }
+            }
+        }
+
+        position += static_cast<int64_t>(count);
+        done += count;
+    }
+
+    this->m_position.store(position, std::memory_order_release);
+    this->m_is_active.store(
+        this->m_has_next || 
+            this->m_voices[TONEGENERATOR_VOICE_PLAYING].is_active || 
+            this->m_voices[TONEGENERATOR_VOICE_RELEASING].is_active, 
+        std::memory_order_release
+    );
+
+    return frame_count;
+}
+
+/**
+ *  Get the count of frames generated so far.
+ * 
+ *  @return
+ *      The count.
+ */
+int64_t ToneGenerator::get_position() const noexcept {
+    return this->m_position.load(std::memory_order_acquire);
+}
+
+/**
+ *  Get whether a tone sequence was playing (or a command was pending) 
+ *  at the end of the last read.
+ * 
+ *  @return
+ *      True if so.
+ */
+bool ToneGenerator::is_active() const noexcept {
+    return this->m_is_active.load(std::memory_order_acquire);
+}
+
+//
+//  ToneGenerator private methods.
+//
+
+/**
+ *  Apply a command.
+ * 
+ *  @param command
+ *      The command.
+ */
+void ToneGenerator::apply(const ToneCommand &command) noexcept {
+    ToneVoice &playing = this->m_voices[TONEGENERATOR_VOICE_PLAYING];
+    ToneVoice &releasing = this->m_voices[TONEGENERATOR_VOICE_RELEASING];
+
+    //
+    //  Fade out the playing voice (from its current envelope).
+    //
+    if (playing.is_active) {
+        float gain = get_envelope(playing);
+        if (gain > 0.0F && this->m_ramp_frames > 0U) {
+            releasing = playing;
+            releasing.is_releasing = true;
+            releasing.release_gain = gain;
+            releasing.release_position = 0U;
+            releasing.release_frames = this->m_ramp_frames;
+        }
+        playing.is_active = false;
+    }
+
+    //
+    //  Start the new sequence.
+    //
+    if (command.type == TONEGENERATOR_COMMAND_PLAY) {
+        playing.is_active = true;
+        playing.is_releasing = false;
+        playing.sequence = command.sequence;
+        playing.segment = 0U;
+        playing.repeat = 0U;
+        this->load_segment(playing);
+    }
+}
+
+/**
+ *  Load the current segment of a voice.
+ * 
+ *  @param voice
+ *      The voice.
+ */
+void ToneGenerator::load_segment(ToneVoice &voice) noexcept {
+    const xap::audioio::ToneSegment &segment = 
+        voice.sequence.segments[voice.segment];
+    voice.position = 0U;
+    voice.on_frames = static_cast<size_t>(
+        static_cast<double>(segment.on_duration) * this->m_frames_per_ms + 0.5
+    );
+    voice.total_frames = voice.on_frames + static_cast<size_t>(
+        static_cast<double>(segment.off_duration) * this->m_frames_per_ms + 0.5
+    );
+    if (voice.total_frames == 0U) {
+        voice.total_frames = 1U;
+    }
+    voice.ramp_frames = this->m_ramp_frames;
+    if (voice.ramp_frames > voice.on_frames / 2U) {
+        voice.ramp_frames = voice.on_frames / 2U;
+    }
+    for (size_t t = 0U; t < 2U; ++t) {
+        voice.phases[t] = 0.0;
+        voice.increments[t] = 2.0 * TONEGENERATOR_PI * 
+            static_cast<double>(segment.frequencies[t]) / 
+            static_cast<double>(this->m_format.sample_rate);
+    }
+}
+
+/**
+ *  Render a voice (added to the mix).
+ * 
+ *  The voice is rendered in spans of linear gain (ramp up, sustain, ramp 
+ *  down, silence, fade-out).
+ * 
+ *  @param voice
+ *      The voice.
+ *  @param mix
+ *      The mix.
+ *  @param frame_count
+ *      The count of frames.
+ */
+void ToneGenerator::render(
+    ToneVoice &voice, 
+    float     *mix, 
+    size_t     frame_count
+) noexcept {
+    size_t offset = 0U;
+    while (offset < frame_count && voice.is_active) {
+        const xap::audioio::ToneSegment &segment = 
+            voice.sequence.segments[voice.segment];
+        size_t span = frame_count - offset;
+        float gain = 0.0F;
+        float step = 0.0F;
+        bool is_sounding = true;
+
+        if (voice.is_releasing) {
+            //
+            //  Fade-out.
+            //
+            size_t remaining = voice.release_frames - voice.release_position;
+            if (span > remaining) {
+                span = remaining;
+            }
+            gain = get_envelope(voice);
+            step = -voice.release_gain / 
+                   static_cast<float>(voice.release_frames);
+        } else if (voice.position < voice.on_frames) {
+            //
+            //  Ramp up, sustain or ramp down.
+            //
+            size_t ramp = voice.ramp_frames;
+            size_t end = voice.on_frames;
+            if (voice.position < ramp) {
+                end = ramp;
+                step = 1.0F / static_cast<float>(ramp);
+            } else if (voice.position < voice.on_frames - ramp) {
+                end = voice.on_frames - ramp;
+            } else {
+                step = -1.0F / static_cast<float>(ramp);
+            }
+            if (span > end - voice.position) {
+                span = end - voice.position;
+            }
+            gain = get_envelope(voice);
+        } else {
+            //
+            //  Silence.
+            //
+            if (span > voice.total_frames - voice.position) {
+                span = voice.total_frames - voice.position;
+            }
+            is_sounding = false;
+        }
+
+        if (is_sounding) {
+            for (size_t t = 0U; t < 2U; ++t) {
+                float level = segment.levels[t];
+                if (segment.frequencies[t] <= 0.0F || level <= 0.0F) {
+                    continue;
+                }
+                oscillate(
+                    mix + offset, 
+                    span, 
+                    voice.phases[t], 
+                    voice.increments[t], 
+                    gain * level, 
+                    step * level
+                );
+            }
+        }
+        offset += span;
+
+        //
+        //  Advance.
+        //
+        if (voice.is_releasing) {
+            voice.release_position += span;
+            if (voice.release_position >= voice.release_frames) {
+                voice.is_active = false;
+            }
+            continue;
+        }
+        voice.position += span;
+        if (voice.position >= voice.total_frames) {
+            ++(voice.segment);
+            if (voice.segment >= voice.sequence.segment_count) {
+                voice.segment = 0U;
+                ++(voice.repeat);
+                if (voice.sequence.repeat_count != 0U && 
+                    voice.repeat >= voice.sequence.repeat_count) {
+                    voice.is_active = false;
+                    continue;
+                }
+            }
+            this->load_segment(voice);
+        }
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
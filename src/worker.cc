@@ -0,0 +1,168 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "worker_p.h"
+
+#include <algorithm>
+#include <system_error>
+#include <xap/audioio/error.h>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Worker constructor & destructor.
+//
+
+/**
+ *  Construct the object (the thread is started with the first item).
+ * 
+ *  @param task
+ *      The task.
+ *  @param interval
+ *      The poll interval.
+ */
+Worker::Worker(
+    xap::audioio::WorkerTask   task,
+    std::chrono::milliseconds  interval
+) noexcept :
+    m_task(task),
+    m_interval(interval),
+    m_lock(),
+    m_wakeup(),
+    m_idle(),
+    m_items(
+        xap::audioio::StlAllocator<void *>(
+            xap::audioio::get_default_allocator()
+        )
+    ),
+    m_current(nullptr),
+    m_worker(),
+    m_is_running(false),
+    m_is_stopping(false),
+    m_is_pending(false)
+{}
+
+/**
+ *  Destruct the object (stop the thread).
+ */
+Worker::~Worker() noexcept {
+    if (!this->m_is_running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> locked(this->m_lock);
+        this->m_is_stopping.store(true);
+    }
+    this->m_wakeup.notify_one();
+    this->m_worker.join();
+}
+
+//
+//  Worker public methods.
+//
+
+/**
+ *  Add an item.
+ * 
+ *  @throw xap::audioio::Exception
+ *      Raised if memory allocation was failed (xap::audioio::ERROR_ALLOC) 
+ *      or the thread cannot be started (xap::audioio::ERROR_SYSTEMCALL).
+ *  @param item
+ *      The item.
+ */
+void Worker::add(void *item) {
+    try {
+        std::lock_guard<std::mutex> locked(this->m_lock);
+        this->m_items.push_back(item);
+        if (!this->m_is_running) {
+            try {
+                this->m_worker = std::thread(&Worker::run, this);
+            } catch (...) {
+                this->m_items.pop_back();
+                throw;
+            }
+            this->m_is_running = true;
+        }
+    } catch (std::bad_alloc &) {
+        throw xap::audioio::Exception(
+            "Memory allocation was failed.",
+            xap::audioio::ERROR_ALLOC
+        );
+    } catch (std::system_error &error) {
+        throw xap::audioio::Exception(
+            error.what(),
+            xap::audioio::ERROR_SYSTEMCALL
+        );
+    }
+}
+
+/**
+ *  Remove an item (the item is never visited after this returns).
+ * 
+ *  @param item
+ *      The item.
+ */
+void Worker::remove(void *item) noexcept {
+    std::unique_lock<std::mutex> locked(this->m_lock);
+    this->m_items.erase(
+        std::remove(this->m_items.begin(), this->m_items.end(), item),
+        this->m_items.end()
+    );
+    this->m_idle.wait(locked, [&]() {
+        return this->m_current != item;
+    });
+}
+
+/**
+ *  Wake the thread (without blocking).
+ */
+void Worker::wake() noexcept {
+    this->m_is_pending.store(true, std::memory_order_release);
+    this->m_wakeup.notify_one();
+}
+
+//
+//  Worker private methods.
+//
+
+/**
+ *  Thread entry.
+ */
+void Worker::run() noexcept {
+    std::unique_lock<std::mutex> locked(this->m_lock);
+    while (!this->m_is_stopping.load()) {
+        this->m_wakeup.wait_for(locked, this->m_interval, [&]() {
+            return this->m_is_stopping.load() || 
+                   this->m_is_pending.load(std::memory_order_acquire);
+        });
+        if (this->m_is_stopping.load()) {
+            break;
+        }
+        this->m_is_pending.store(false, std::memory_order_relaxed);
+
+        //
+        //  Visit the items without the lock (an item added or removed 
+        //  meanwhile may shift the others, so one of them may wait until 
+        //  the next pass).
+        //
+        for (size_t i = 0U; i < this->m_items.size(); ++i) {
+            void *item = this->m_items[i];
+            this->m_current = item;
+            locked.unlock();
+            this->m_task(item);
+            locked.lock();
+            this->m_current = nullptr;
+            this->m_idle.notify_all();
+        }
+    }
+}
+
+}  //  namespace audioio
+}  //  namespace xap
@@ -0,0 +1,133 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+#ifndef XAP_AUDIOIO_WORKER_P_H__
+#define XAP_AUDIOIO_WORKER_P_H__
+
+//
+//  Imports.
+//
+#include "allocator_p.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xap {
+namespace audioio {
+
+//
+//  Types.
+//
+
+//  Task of a worker (invoked on the worker thread for each item).
+typedef void (*WorkerTask)(void *item);
+
+//
+//  Classes.
+//
+
+/**
+ *  Process-wide worker thread which serves many items (e.g. the prefetch 
+ *  thread of all audio file readers).
+ * 
+ *  The thread visits all items when it is woken. The audio thread wakes it 
+ *  without the lock, so the thread also polls at an interval in case a 
+ *  wake-up was missed. The lock is only held to pick the next item: a slow 
+ *  item (file I/O, decoding) does not stall the other items, and remove() 
+ *  only waits while the item being removed is visited.
+ */
+class Worker {
+public:
+    //
+    //  Constructor & destructor.
+    //
+
+    /**
+     *  Construct the object (the thread is started with the first item).
+     * 
+     *  @param task
+     *      The task.
+     *  @param interval
+     *      The poll interval.
+     */
+    Worker(
+        xap::audioio::WorkerTask   task,
+        std::chrono::milliseconds  interval
+    ) noexcept;
+
+    /**
+     *  Destruct the object (stop the thread).
+     */
+    ~Worker() noexcept;
+
+    //
+    //  Public methods.
+    //
+
+    /**
+     *  Add an item.
+     * 
+     *  @throw xap::audioio::Exception
+     *      Raised if memory allocation was failed (xap::audioio::ERROR_ALLOC) 
+     *      or the thread cannot be started (xap::audioio::ERROR_SYSTEMCALL).
+     *  @param item
+     *      The item.
+     */
+    void add(void *item);
+
+    /**
+     *  Remove an item (the item is never visited after this returns).
+     * 
+     *  @param item
+     *      The item.
+     */
+    void remove(void *item) noexcept;
+
+    /**
+     *  Wake the thread (without blocking).
+     */
+    void wake() noexcept;
+
+private:
+    //
+    //  Constructors.
+    //
+    Worker(const Worker &) = delete;
+    Worker &operator=(const Worker &) = delete;
+
+    //
+    //  Private methods.
+    //
+
+    /**
+     *  Thread entry.
+     */
+    void run() noexcept;
+
+    //
+    //  Members.
+    //
+    xap::audioio::WorkerTask                                 m_task;
+    std::chrono::milliseconds                                m_interval;
+    std::mutex                                               m_lock;
+    std::condition_variable                                  m_wakeup;
+    std::condition_variable                                  m_idle;
+    std::vector<void *, xap::audioio::StlAllocator<void *>>  m_items;
+    void                                                    *m_current;
+    std::thread                                              m_worker;
+    bool                                                     m_is_running;
+    std::atomic<bool>                                        m_is_stopping;
+    std::atomic<bool>                                        m_is_pending;
+};
+
+}  //  namespace audioio
+}  //  namespace xap
+
+#endif  //  #ifndef XAP_AUDIOIO_WORKER_P_H__
@@ -0,0 +1,163 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <stdio.h>
+#include <xap/audioio/all.h>
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build an audio format.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @param channel_count
+ *      The count of channels.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat sample_format,
+    uint8_t                    channel_count
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = channel_count;
+    format.sample_rate = 16000U;
+    return format;
+}
+
+void pool_allocate() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 2U);
+    xap::audioio::AudioBufferPool pool(1024U * 4U, 2U);
+    xap::test::assert_equal<size_t>(pool.get_available_count(), 2U);
+
+    {
+        xap::audioio::AudioBuffer a = 
+            xap::audioio::AudioBuffer::allocate(pool, format, 1024U);
+        xap::audioio::AudioBuffer b = 
+            xap::audioio::AudioBuffer::allocate(pool, format, 512U);
+        xap::test::assert_equal<size_t>(pool.get_available_count(), 0U);
+        xap::test::assert_equal<size_t>(a.get_length(), 4096U);
+        xap::test::assert_equal<size_t>(b.get_sample_count(), 1024U);
+        xap::test::assert_ok(
+            reinterpret_cast<uintptr_t>(a.get_pointer()) % 
+                xap::audioio::AUDIOBUFFER_ALIGNMENT == 0U,
+            "Storage is not aligned."
+        );
+
+        //  Pool exhausted.
+        xap::test::assert_throw<xap::audioio::Exception>(
+            [&]() { xap::audioio::AudioBuffer::allocate(pool, format, 1U); },
+            "Allocated from an exhausted pool."
+        );
+
+        //  Block too small.
+        b = xap::audioio::AudioBuffer();
+        xap::test::assert_throw<xap::audioio::Exception>(
+            [&]() { 
+                xap::audioio::AudioBuffer::allocate(pool, format, 1025U); 
+            },
+            "Allocated more frames than a block."
+        );
+        xap::test::assert_equal<size_t>(pool.get_available_count(), 1U);
+    }
+
+    xap::test::assert_equal<size_t>(pool.get_available_count(), 2U);
+}
+
+void slice_share() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U);
+    xap::audioio::AudioBuffer slice;
+    {
+        xap::audioio::AudioBufferPool pool(256U, 1U);
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(pool, format, 128U);
+        data.set_timestamp(1000);
+        int16_t *samples = data.get_samples<int16_t>();
+        for (size_t i = 0U; i < 128U; ++i) {
+            samples[i] = static_cast<int16_t>(i);
+        }
+
+        slice = data.slice(32U, 16U);
+        xap::test::assert_ok(!data.is_unique(), "Storage is not shared.");
+        xap::test::assert_equal<int64_t>(slice.get_timestamp(), 1032);
+        xap::test::assert_equal<int16_t>(slice.get_samples<int16_t>()[0], 32);
+        xap::test::assert_throw<xap::audioio::Exception>(
+            [&]() { data.slice(120U, 16U); },
+            "Sliced out of the buffer."
+        );
+
+        data = xap::audioio::AudioBuffer();
+        xap::test::assert_equal<size_t>(pool.get_available_count(), 0U);
+    }
+
+    //  The slice keeps the storage valid after the pool was destructed.
+    xap::test::assert_ok(slice.is_unique(), "Slice is not unique.");
+    xap::test::assert_equal<int16_t>(slice.get_samples<int16_t>()[15], 47);
+}
+
+void buffer_conversion() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U);
+    xap::core::buffer::Buffer buffer(64U, true);
+
+    xap::audioio::AudioBuffer data = 
+        xap::audioio::AudioBuffer::wrap(buffer, format);
+    xap::test::assert_equal<size_t>(data.get_frame_count(), 8U);
+    xap::test::assert_ok(
+        data.get_pointer() == buffer.get_pointer(), 
+        "Wrapping copied the buffer."
+    );
+    data.get_samples<float>()[0] = 0.5F;
+
+    xap::core::buffer::Buffer copied = data.to_buffer();
+    xap::test::assert_equal<size_t>(copied.get_length(), 64U);
+    xap::test::assert_ok(
+        *reinterpret_cast<float *>(copied.get_pointer()) == 0.5F,
+        "Copied data mismatched."
+    );
+
+    xap::core::buffer::Buffer odd(63U, true);
+    xap::test::assert_throw<xap::audioio::Exception>(
+        [&]() { xap::audioio::AudioBuffer::wrap(odd, format); },
+        "Wrapped a buffer with partial frame."
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Pool allocation...\n");
+    pool_allocate();
+
+    //
+    //  Case 2.
+    //
+    printf("Slice sharing...\n");
+    slice_share();
+
+    //
+    //  Case 3.
+    //
+    printf("Buffer conversion...\n");
+    buffer_conversion();
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static char *BENCHMARK_PATH = "audiofile.benchmark.tmp";
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t FILE_FRAMES   = 441000U;  //  10s at 44.1kHz.
+
+/**
+ *  Write a 24-bit stereo 44.1kHz WAV file (noise).
+ */
+static void write_file() {
+    const uint32_t data_size = static_cast<uint32_t>(FILE_FRAMES * 6U);
+    uint8_t header[44] = {
+        'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0,
+        0x44, 0xAC, 0, 0, 0x98, 0x09, 0x04, 0, 6, 0, 24, 0,
+        'd', 'a', 't', 'a', 0, 0, 0, 0
+    };
+    for (size_t i = 0U; i < 4U; ++i) {
+        header[4U + i] = static_cast<uint8_t>((data_size + 36U) >> (8U * i));
+        header[40U + i] = static_cast<uint8_t>(data_size >> (8U * i));
+    }
+    std::vector<uint8_t> data(data_size);
+    uint32_t seed = 1U;
+    for (size_t i = 0U; i < data.size(); ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        data[i] = static_cast<uint8_t>(seed >> 24);
+    }
+    FILE *file = fopen(BENCHMARK_PATH, "wb");
+    fwrite(header, 1U, sizeof(header), file);
+    fwrite(data.data(), 1U, data.size(), file);
+    fclose(file);
+}
+
+/**
+ *  Run the benchmark (play the file on many readers at once, stereo 
+ *  output).
+ * 
+ *  @param reader_count
+ *      The count of readers.
+ *  @param sample_format
+ *      The output sample format.
+ *  @param sample_rate
+ *      The output sample rate.
+ */
+static void run(
+    size_t                      reader_count,
+    xap::audioio::SampleFormat  sample_format,
+    uint32_t                    sample_rate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = 2U;
+    format.sample_rate = sample_rate;
+    std::vector<std::unique_ptr<xap::audioio::AudioFileReader>> readers;
+    for (size_t i = 0U; i < reader_count; ++i) {
+        readers.emplace_back(
+            new xap::audioio::AudioFileReader(BENCHMARK_PATH, format)
+        );
+    }
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+
+    //
+    //  Periods are read round-robin (as a mixer would), the time spent 
+    //  waiting for prefetched frames is excluded.
+    //
+    size_t period_count = 0U;
+    size_t underrun_count = 0U;
+    double elapsed = 0.0;
+    while (!readers[0]->is_finished()) {
+        std::chrono::steady_clock::time_point begin = 
+            std::chrono::steady_clock::now();
+        for (size_t i = 0U; i < reader_count; ++i) {
+            if (readers[i]->read(output) != PERIOD_FRAMES && 
+                !readers[i]->is_finished()) {
+                ++underrun_count;
+            }
+        }
+        elapsed += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - begin
+        ).count();
+        ++period_count;
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    double audio = static_cast<double>(period_count * PERIOD_FRAMES) / 
+                   static_cast<double>(sample_rate) * 
+                   static_cast<double>(reader_count);
+
+    printf(
+        "%7zu | %6s %5uHz | %20.1f | %9zu\n",
+        reader_count,
+        sample_format == xap::audioio::SAMPLEFORMAT_INT16 ? "int16" : "float",
+        sample_rate,
+        audio / elapsed,
+        underrun_count
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    write_file();
+
+    //  Real-time factor is the count of streams one core can convert.
+    printf("Readers |        Output | Real-time (x faster) | Underruns\n");
+    run(16U, xap::audioio::SAMPLEFORMAT_INT16, 44100U);
+    run(16U, xap::audioio::SAMPLEFORMAT_FLOAT32, 44100U);
+    run(16U, xap::audioio::SAMPLEFORMAT_FLOAT32, 48000U);
+    run(200U, xap::audioio::SAMPLEFORMAT_FLOAT32, 48000U);
+
+    remove(BENCHMARK_PATH);
+    return 0;
+}
@@ -0,0 +1,675 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Path of the test file (in the working directory).
+const static char *TEST_PATH = "audiofile.unittest.tmp";
+
+//  Period size (10ms at 48kHz).
+const static size_t PERIOD_FRAMES = 480U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Encoding of a test file.
+ */
+typedef struct Encoding_ {
+    xap::audioio::AudioFileContainer  container;
+    uint32_t                          bits;
+    bool                              is_float;
+    bool                              is_big_endian;
+    bool                              is_extensible;
+} Encoding;
+
+/**
+ *  Append an unsigned integer (of either byte order).
+ */
+static void put(
+    std::vector<uint8_t>  &bytes,
+    uint64_t               value,
+    size_t                 size,
+    bool                   is_big_endian
+) {
+    for (size_t i = 0U; i < size; ++i) {
+        size_t shift = is_big_endian ? (size - 1U - i) * 8U : i * 8U;
+        bytes.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+/**
+ *  Append a tag.
+ */
+static void put_tag(std::vector<uint8_t> &bytes, const char *tag) {
+    bytes.insert(bytes.end(), tag, tag + 4);
+}
+
+/**
+ *  Get a sample of the test signal (a different tone on each channel).
+ */
+static double get_sample(size_t frame, size_t channel, uint32_t rate) {
+    double frequency = 440.0 * static_cast<double>(channel + 1U);
+    return 0.5 * sin(
+        2.0 * PI * frequency * static_cast<double>(frame) / 
+        static_cast<double>(rate)
+    );
+}
+
+/**
+ *  Write a test file.
+ * 
+ *  @param encoding
+ *      The encoding.
+ *  @param channel_count
+ *      The count of channels.
+ *  @param sample_rate
+ *      The sample rate.
+ *  @param frame_count
+ *      The count of frames.
+ */
+static void write_file(
+    const Encoding  &encoding,
+    size_t           channel_count,
+    uint32_t         sample_rate,
+    size_t           frame_count
+) {
+    bool be = encoding.is_big_endian;
+    size_t sample_size = encoding.bits / 8U;
+    std::vector<uint8_t> data;
+    for (size_t i = 0U; i < frame_count; ++i) {
+        for (size_t c = 0U; c < channel_count; ++c) {
+            double value = get_sample(i, c, sample_rate);
+            if (encoding.is_float && encoding.bits == 32U) {
+                float f = static_cast<float>(value);
+                uint32_t bits;
+                memcpy(&bits, &f, 4U);
+                put(data, bits, 4U, be);
+            } else if (encoding.is_float) {
+                uint64_t bits;
+                memcpy(&bits, &value, 8U);
+                put(data, bits, 8U, be);
+            } else if (encoding.bits == 8U) {
+                long q = lrint(value * 127.0) + 128;
+                put(data, static_cast<uint64_t>(q), 1U, be);
+            } else {
+                double scale = ldexp(1.0, static_cast<int>(encoding.bits) - 1);
+                long long q = llrint(value * (scale - 1.0));
+                put(data, static_cast<uint64_t>(q), sample_size, be);
+            }
+        }
+    }
+
+    std::vector<uint8_t> bytes;
+    size_t block = channel_count * sample_size;
+    if (encoding.container == xap::audioio::AUDIOFILE_WAV) {
+        size_t format_size = encoding.is_extensible ? 40U : 16U;
+        put_tag(bytes, "RIFF");
+        put(bytes, 4U + 8U + format_size + 8U + 4U + 8U + data.size(), 4U,
+            false);
+        put_tag(bytes, "WAVE");
+        put_tag(bytes, "fmt ");
+        put(bytes, format_size, 4U, false);
+        uint32_t code = encoding.is_float ? 3U : 1U;
+        put(bytes, encoding.is_extensible ? 0xFFFEU : code, 2U, false);
+        put(bytes, channel_count, 2U, false);
+        put(bytes, sample_rate, 4U, false);
+        put(bytes, sample_rate * block, 4U, false);
+        put(bytes, block, 2U, false);
+        put(bytes, encoding.bits, 2U, false);
+        if (encoding.is_extensible) {
+            put(bytes, 22U, 2U, false);
+            put(bytes, encoding.bits, 2U, false);
+            put(bytes, 0U, 4U, false);
+            put(bytes, code, 2U, false);
+            for (size_t i = 0U; i < 14U; ++i) {
+                bytes.push_back(0U);
+            }
+        }
+        //  An unknown (odd-sized, padded) chunk is skipped.
+        put_tag(bytes, "junk");
+        put(bytes, 3U, 4U, false);
+        put(bytes, 0U, 4U, false);
+        put_tag(bytes, "data");
+        put(bytes, data.size(), 4U, false);
+    } else if (encoding.container == xap::audioio::AUDIOFILE_AIFF) {
+        bool is_aifc = encoding.is_float || !be;
+        size_t common_size = is_aifc ? 24U : 18U;
+        put_tag(bytes, "FORM");
+        put(bytes, 4U + 8U + common_size + 16U + data.size(), 4U, true);
+        put_tag(bytes, is_aifc ? "AIFC" : "AIFF");
+        put_tag(bytes, "COMM");
+        put(bytes, common_size, 4U, true);
+        put(bytes, channel_count, 2U, true);
+        put(bytes, frame_count, 4U, true);
+        put(bytes, encoding.bits, 2U, true);
+        int exponent = 0;
+        double mantissa = frexp(static_cast<double>(sample_rate), &exponent);
+        put(bytes, static_cast<uint64_t>(16382 + exponent), 2U, true);
+        put(bytes, static_cast<uint64_t>(ldexp(mantissa, 64)), 8U, true);
+        if (is_aifc) {
+            put_tag(bytes, encoding.is_float ? 
+                (encoding.bits == 32U ? "fl32" : "fl64") :
+                "sowt");
+            put(bytes, 0U, 2U, true);
+        }
+        put_tag(bytes, "SSND");
+        put(bytes, 8U + data.size(), 4U, true);
+        put(bytes, 0U, 8U, true);
+    } else {
+        put_tag(bytes, "caff");
+        put(bytes, 1U, 2U, true);
+        put(bytes, 0U, 2U, true);
+        put_tag(bytes, "desc");
+        put(bytes, 32U, 8U, true);
+        double rate = static_cast<double>(sample_rate);
+        uint64_t rate_bits;
+        memcpy(&rate_bits, &rate, 8U);
+        put(bytes, rate_bits, 8U, true);
+        put_tag(bytes, "lpcm");
+        put(bytes, (encoding.is_float ? 1U : 0U) | (be ? 0U : 2U), 4U, true);
+        put(bytes, block, 4U, true);
+        put(bytes, 1U, 4U, true);
+        put(bytes, channel_count, 4U, true);
+        put(bytes, encoding.bits, 4U, true);
+        put_tag(bytes, "data");
+        put(bytes, UINT64_MAX, 8U, true);
+        put(bytes, 0U, 4U, true);
+    }
+    bytes.insert(bytes.end(), data.begin(), data.end());
+
+    FILE *file = fopen(TEST_PATH, "wb");
+    xap::test::assert_ok(file != nullptr, "Cannot write the test file.");
+    fwrite(bytes.data(), 1U, bytes.size(), file);
+    fclose(file);
+}
+
+/**
+ *  Build an audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint8_t                     channel_count,
+    uint32_t                    sample_rate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = channel_count;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Read a file to its end (in 32-bit float, waits for the prefetch thread 
+ *  when frames are missing).
+ * 
+ *  @param reader
+ *      The reader.
+ *  @param format
+ *      The output format.
+ *  @return
+ *      The samples.
+ */
+static std::vector<float> read_all(
+    xap::audioio::AudioFileReader    &reader,
+    const xap::audioio::AudioFormat  &format
+) {
+    std::vector<float> samples;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    size_t channel_count = format.channel_count;
+    while (!reader.is_finished()) {
+        size_t count = reader.read(output);
+        if (count == 0U) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        for (size_t i = 0U; i < count * channel_count; ++i) {
+            if (format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+                samples.push_back(
+                    output.get_samples<int16_t>()[i] / 32768.0F
+                );
+            } else if (format.sample_format == 
+                       xap::audioio::SAMPLEFORMAT_INT32) {
+                samples.push_back(static_cast<float>(
+                    output.get_samples<int32_t>()[i] / 2147483648.0
+                ));
+            } else {
+                samples.push_back(output.get_samples<float>()[i]);
+            }
+        }
+    }
+    return samples;
+}
+
+/**
+ *  Check that a file decodes to the test signal.
+ * 
+ *  @param encoding
+ *      The encoding.
+ *  @param tolerance
+ *      The tolerance.
+ */
+static void check_encoding(const Encoding &encoding, float tolerance) {
+    const size_t frame_count = 10000U;
+    write_file(encoding, 2U, 48000U, frame_count);
+    xap::audioio::AudioFileInfo info = xap::audioio::audiofile_probe(TEST_PATH);
+    xap::test::assert_equal<uint8_t>(info.container, encoding.container);
+    xap::test::assert_equal<uint32_t>(info.bits_per_sample, encoding.bits);
+    xap::test::assert_equal<bool>(info.is_float, encoding.is_float);
+    xap::test::assert_equal<uint64_t>(info.frame_count, frame_count);
+
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U, 48000U);
+    xap::audioio::AudioFileReader reader(TEST_PATH, format);
+    xap::test::assert_equal<uint64_t>(reader.get_length(), frame_count);
+    std::vector<float> samples = read_all(reader, format);
+    xap::test::assert_equal<size_t>(samples.size(), frame_count * 2U);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        for (size_t c = 0U; c < 2U; ++c) {
+            double expected = get_sample(i, c, 48000U);
+            xap::test::assert_ok(
+                fabs(samples[i * 2U + c] - expected) < tolerance,
+                "Sample mismatched."
+            );
+        }
+    }
+    xap::test::assert_equal<uint64_t>(reader.get_position(), frame_count);
+}
+
+//
+//  Test cases.
+//
+
+void encodings() {
+    const xap::audioio::AudioFileContainer wav = xap::audioio::AUDIOFILE_WAV;
+    const xap::audioio::AudioFileContainer aiff = xap::audioio::AUDIOFILE_AIFF;
+    const xap::audioio::AudioFileContainer caf = xap::audioio::AUDIOFILE_CAF;
+    check_encoding({wav, 8U, false, false, false}, 0.01F);
+    check_encoding({wav, 16U, false, false, false}, 0.0001F);
+    check_encoding({wav, 24U, false, false, true}, 0.00001F);
+    check_encoding({wav, 32U, false, false, false}, 0.00001F);
+    check_encoding({wav, 32U, true, false, false}, 0.00001F);
+    check_encoding({wav, 64U, true, false, true}, 0.00001F);
+    check_encoding({aiff, 16U, false, true, false}, 0.0001F);
+    check_encoding({aiff, 24U, false, true, false}, 0.00001F);
+    check_encoding({aiff, 16U, false, false, false}, 0.0001F);
+    check_encoding({aiff, 32U, true, true, false}, 0.00001F);
+    check_encoding({caf, 24U, false, true, false}, 0.00001F);
+    check_encoding({caf, 32U, true, false, false}, 0.00001F);
+    remove(TEST_PATH);
+}
+
+void direct() {
+    //
+    //  16-bit samples are copied exactly (16-bit output at the file rate).
+    //
+    write_file({xap::audioio::AUDIOFILE_WAV, 16U, false, false, false},
+               2U, 48000U, 5000U);
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 2U, 48000U);
+    xap::audioio::AudioFileReader reader(TEST_PATH, format);
+    std::vector<float> samples = read_all(reader, format);
+    xap::test::assert_equal<size_t>(samples.size(), 10000U);
+    for (size_t i = 0U; i < 5000U; ++i) {
+        for (size_t c = 0U; c < 2U; ++c) {
+            double expected = static_cast<double>(
+                llrint(get_sample(i, c, 48000U) * 32767.0)
+            ) / 32768.0;
+            xap::test::assert_equal<float>(
+                samples[i * 2U + c],
+                static_cast<float>(expected)
+            );
+        }
+    }
+    remove(TEST_PATH);
+}
+
+void channel_mapping() {
+    //
+    //  Mono to stereo (duplicated).
+    //
+    {
+        write_file({xap::audioio::AUDIOFILE_WAV, 16U, false, false, false},
+                   1U, 48000U, 2000U);
+        xap::audioio::AudioFormat format = 
+            build_format(xap::audioio::SAMPLEFORMAT_INT32, 2U, 48000U);
+        xap::audioio::AudioFileReader reader(TEST_PATH, format);
+        std::vector<float> samples = read_all(reader, format);
+        xap::test::assert_equal<size_t>(samples.size(), 4000U);
+        for (size_t i = 0U; i < 2000U; ++i) {
+            xap::test::assert_equal<float>(samples[i * 2U],
+                                           samples[i * 2U + 1U]);
+            xap::test::assert_ok(
+                fabs(samples[i * 2U] - get_sample(i, 0U, 48000U)) < 0.0001
+            );
+        }
+    }
+
+    //
+    //  Stereo to mono (averaged).
+    //
+    {
+        write_file({xap::audioio::AUDIOFILE_WAV, 32U, true, false, false},
+                   2U, 48000U, 2000U);
+        xap::audioio::AudioFormat format = 
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 1U, 48000U);
+        xap::audioio::AudioFileReader reader(TEST_PATH, format);
+        std::vector<float> samples = read_all(reader, format);
+        xap::test::assert_equal<size_t>(samples.size(), 2000U);
+        for (size_t i = 0U; i < 2000U; ++i) {
+            double expected = 0.5 * (get_sample(i, 0U, 48000U) + 
+                                     get_sample(i, 1U, 48000U));
+            xap::test::assert_ok(fabs(samples[i] - expected) < 0.00001);
+        }
+    }
+
+    //
+    //  Stereo to 6 channels is not supported.
+    //
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioFileReader reader(
+            TEST_PATH,
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 6U, 48000U)
+        );
+    });
+    remove(TEST_PATH);
+}
+
+void resampling() {
+    //
+    //  44.1kHz to 48kHz and 48kHz to 16kHz (a 440Hz tone, within the pass 
+    //  band of both).
+    //
+    const uint32_t rates[][2] = {{44100U, 48000U}, {48000U, 16000U}};
+    for (size_t k = 0U; k < 2U; ++k) {
+        uint32_t rate_in = rates[k][0];
+        uint32_t rate_out = rates[k][1];
+        write_file({xap::audioio::AUDIOFILE_WAV, 24U, false, false, false},
+                   1U, rate_in, rate_in);
+        xap::audioio::AudioFormat format = 
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 1U, rate_out);
+        xap::audioio::AudioFileReader reader(TEST_PATH, format);
+        xap::test::assert_equal<uint64_t>(reader.get_length(), rate_out);
+        std::vector<float> samples = read_all(reader, format);
+        xap::test::assert_equal<size_t>(samples.size(), rate_out);
+
+        //  Skip the edges (the taps reach over the ends of the file).
+        double error = 0.0;
+        double energy = 0.0;
+        for (size_t i = 100U; i < rate_out - 100U; ++i) {
+            double expected = get_sample(i, 0U, rate_out);
+            double difference = samples[i] - expected;
+            error += difference * difference;
+            energy += expected * expected;
+        }
+        xap::test::assert_ok(
+            error < energy * 0.0001,
+            "Resampling error is too large."
+        );
+    }
+    remove(TEST_PATH);
+}
+
+void seeking() {
+    //
+    //  Reading after a seek matches a continuous read (with and without 
+    //  resampling).
+    //
+    const uint32_t rates[] = {48000U, 44100U};
+    for (size_t k = 0U; k < 2U; ++k) {
+        write_file({xap::audioio::AUDIOFILE_WAV, 16U, false, false, false},
+                   2U, rates[k], 50000U);
+        xap::audioio::AudioFormat format = 
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U, 48000U);
+        xap::audioio::AudioFileReader reader(TEST_PATH, format);
+        std::vector<float> all = read_all(reader, format);
+        xap::test::assert_equal<size_t>(
+            all.size(),
+            static_cast<size_t>(reader.get_length()) * 2U
+        );
+
+        const uint64_t targets[] = {12345U, 0U, 40001U, 77U};
+        for (uint64_t target : targets) {
+            reader.seek(target);
+            xap::test::assert_ok(!reader.is_finished() || target == 0U);
+            std::vector<float> samples = read_all(reader, format);
+            xap::test::assert_equal<size_t>(
+                samples.size(),
+                all.size() - static_cast<size_t>(target) * 2U
+            );
+            for (size_t i = 0U; i < samples.size(); ++i) {
+                xap::test::assert_equal<float>(
+                    samples[i],
+                    all[static_cast<size_t>(target) * 2U + i]
+                );
+            }
+        }
+
+        //  Seeking past the end clamps.
+        reader.seek(UINT64_MAX);
+        xap::test::assert_equal<size_t>(read_all(reader, format).size(), 0U);
+        xap::test::assert_equal<uint64_t>(
+            reader.get_position(),
+            reader.get_length()
+        );
+    }
+    remove(TEST_PATH);
+}
+
+void concurrency() {
+    //
+    //  Many readers (small ring buffers) are served by one prefetch thread.
+    //
+    write_file({xap::audioio::AUDIOFILE_WAV, 24U, false, false, false},
+               2U, 44100U, 44100U);
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U, 48000U);
+    xap::audioio::AudioFileReaderOptions options;
+    options.buffer_frames = 2048U;
+    std::vector<std::unique_ptr<xap::audioio::AudioFileReader>> readers;
+    for (size_t i = 0U; i < 200U; ++i) {
+        readers.emplace_back(new xap::audioio::AudioFileReader(
+            TEST_PATH,
+            format,
+            options
+        ));
+    }
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    std::vector<size_t> counts(readers.size(), 0U);
+    size_t finished = 0U;
+    while (finished < readers.size()) {
+        finished = 0U;
+        for (size_t i = 0U; i < readers.size(); ++i) {
+            counts[i] += readers[i]->read(output);
+            if (readers[i]->is_finished()) {
+                ++finished;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (size_t i = 0U; i < readers.size(); ++i) {
+        xap::test::assert_equal<size_t>(counts[i], 48000U);
+    }
+    readers.clear();
+
+    //
+    //  Seeking from another thread while reading: each read returns 
+    //  consecutive frames of one position (the samples are the frame 
+    //  indexes).
+    //
+    const size_t ramp_frames = 100000U;
+    std::vector<uint8_t> bytes;
+    put_tag(bytes, "RIFF");
+    put(bytes, 4U + 24U + 8U + ramp_frames * 4U, 4U, false);
+    put_tag(bytes, "WAVE");
+    put_tag(bytes, "fmt ");
+    put(bytes, 16U, 4U, false);
+    put(bytes, 1U, 2U, false);
+    put(bytes, 1U, 2U, false);
+    put(bytes, 48000U, 4U, false);
+    put(bytes, 48000U * 4U, 4U, false);
+    put(bytes, 4U, 2U, false);
+    put(bytes, 32U, 2U, false);
+    put_tag(bytes, "data");
+    put(bytes, ramp_frames * 4U, 4U, false);
+    for (size_t i = 0U; i < ramp_frames; ++i) {
+        put(bytes, i, 4U, false);
+    }
+    FILE *file = fopen(TEST_PATH, "wb");
+    xap::test::assert_ok(file != nullptr, "Cannot write the test file.");
+    fwrite(bytes.data(), 1U, bytes.size(), file);
+    fclose(file);
+
+    xap::audioio::AudioFormat ramp_format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT32, 1U, 48000U);
+    xap::audioio::AudioFileReader reader(TEST_PATH, ramp_format, options);
+    std::atomic<bool> is_done(false);
+    std::thread seeker([&]() {
+        uint64_t target = 0U;
+        while (!is_done.load()) {
+            target = (target + 7919U) % ramp_frames;
+            reader.seek(target);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+    xap::audioio::AudioBuffer ramp = 
+        xap::audioio::AudioBuffer::allocate(ramp_format, PERIOD_FRAMES);
+    size_t total = 0U;
+    std::chrono::steady_clock::time_point end = 
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (std::chrono::steady_clock::now() < end) {
+        size_t count = reader.read(ramp);
+        const int32_t *samples = ramp.get_samples<int32_t>();
+        for (size_t i = 1U; i < count; ++i) {
+            xap::test::assert_equal<int32_t>(samples[i], samples[i - 1U] + 1);
+        }
+        total += count;
+    }
+    is_done.store(true);
+    seeker.join();
+    xap::test::assert_ok(total != 0U);
+    remove(TEST_PATH);
+}
+
+void errors() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 2U, 48000U);
+
+    //
+    //  Missing file.
+    //
+    remove(TEST_PATH);
+    try {
+        xap::audioio::AudioFileReader reader(TEST_PATH, format);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_IO
+        );
+    }
+
+    //
+    //  Not an audio file.
+    //
+    FILE *file = fopen(TEST_PATH, "wb");
+    fputs("This is not an audio file.", file);
+    fclose(file);
+    try {
+        xap::audioio::audiofile_probe(TEST_PATH);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    //
+    //  Mismatched output buffer.
+    //
+    write_file({xap::audioio::AUDIOFILE_WAV, 16U, false, false, false},
+               2U, 48000U, 1000U);
+    xap::audioio::AudioFileReader reader(TEST_PATH, format);
+    xap::audioio::AudioBuffer output = xap::audioio::AudioBuffer::allocate(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 48000U),
+        PERIOD_FRAMES
+    );
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        reader.read(output);
+    });
+    remove(TEST_PATH);
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Encodings...\n");
+    encodings();
+
+    //
+    //  Case 2.
+    //
+    printf("Direct copy...\n");
+    direct();
+
+    //
+    //  Case 3.
+    //
+    printf("Channel mapping...\n");
+    channel_mapping();
+
+    //
+    //  Case 4.
+    //
+    printf("Resampling...\n");
+    resampling();
+
+    //
+    //  Case 5.
+    //
+    printf("Seeking...\n");
+    seeking();
+
+    //
+    //  Case 6.
+    //
+    printf("Concurrency...\n");
+    concurrency();
+
+    //
+    //  Case 7.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
@@ -0,0 +1,602 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Path of the test file (in the working directory).
+const static char *TEST_PATH = "audiofilewriter.unittest.tmp";
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build an audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint8_t                     channel_count,
+    uint32_t                    sample_rate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = channel_count;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Build 16-bit samples of a test signal.
+ */
+static std::vector<int16_t> build_samples(size_t count) {
+    std::vector<int16_t> samples(count);
+    for (size_t i = 0U; i < count; ++i) {
+        samples[i] = static_cast<int16_t>(
+            12000.0 * sin(2.0 * PI * static_cast<double>(i) / 97.0)
+        );
+    }
+    return samples;
+}
+
+/**
+ *  Record samples (in periods) to the test file.
+ * 
+ *  @param format
+ *      The format.
+ *  @param data
+ *      The audio data.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param period_frames
+ *      The count of frames of each period.
+ */
+static void record(
+    const xap::audioio::AudioFormat  &format,
+    const void                       *data,
+    size_t                            frame_count,
+    size_t                            period_frames
+) {
+    xap::audioio::AudioFileWriter writer(TEST_PATH, format);
+    size_t frame_size = xap::audioio::get_frame_size(format);
+    for (size_t offset = 0U; offset < frame_count; offset += period_frames) {
+        size_t count = std::min(period_frames, frame_count - offset);
+        xap::audioio::AudioBuffer period = 
+            xap::audioio::AudioBuffer::allocate(format, count);
+        memcpy(
+            period.get_pointer(),
+            static_cast<const uint8_t *>(data) + offset * frame_size,
+            count * frame_size
+        );
+        writer.process(period);
+    }
+    xap::test::assert_equal<uint64_t>(writer.get_frame_count(), frame_count);
+    xap::test::assert_equal<uint64_t>(writer.get_dropped_frame_count(), 0U);
+    writer.close();
+}
+
+/**
+ *  Read the test file (all frames).
+ * 
+ *  @param format
+ *      The output format.
+ *  @param frame_count
+ *      The count of frames.
+ *  @return
+ *      The audio data.
+ */
+static std::vector<uint8_t> play(
+    const xap::audioio::AudioFormat  &format,
+    size_t                            frame_count
+) {
+    xap::audioio::AudioFileReader reader(TEST_PATH, format);
+    xap::test::assert_equal<uint64_t>(reader.get_length(), frame_count);
+    size_t frame_size = xap::audioio::get_frame_size(format);
+    std::vector<uint8_t> data;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 480U);
+    while (!reader.is_finished()) {
+        size_t count = reader.read(output);
+        if (count == 0U) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        data.insert(
+            data.end(),
+            output.get_pointer(),
+            output.get_pointer() + count * frame_size
+        );
+    }
+    return data;
+}
+
+/**
+ *  Read bytes of the test file.
+ */
+static std::vector<uint8_t> read_bytes(uint64_t offset, size_t size) {
+    std::vector<uint8_t> bytes(size);
+    FILE *file = fopen(TEST_PATH, "rb");
+    xap::test::assert_ok(file != nullptr);
+    fseek(file, static_cast<long>(offset), SEEK_SET);
+    xap::test::assert_equal<size_t>(
+        fread(bytes.data(), 1U, size, file),
+        size
+    );
+    fclose(file);
+    return bytes;
+}
+
+//
+//  Test cases.
+//
+
+void round_trip() {
+    //
+    //  16-bit, 32-bit and 32-bit float audio data is written as it is.
+    //
+    const xap::audioio::SampleFormat formats[] = {
+        xap::audioio::SAMPLEFORMAT_INT16,
+        xap::audioio::SAMPLEFORMAT_INT32,
+        xap::audioio::SAMPLEFORMAT_FLOAT32
+    };
+    std::vector<int16_t> samples = build_samples(2U * 30000U);
+    for (xap::audioio::SampleFormat sample_format : formats) {
+        xap::audioio::AudioFormat format = 
+            build_format(sample_format, 2U, 48000U);
+        size_t sample_size = xap::audioio::get_sample_size(sample_format);
+        std::vector<uint8_t> data(samples.size() * sample_size);
+        for (size_t i = 0U; i < samples.size(); ++i) {
+            if (sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+                memcpy(&data[i * 2U], &samples[i], 2U);
+            } else if (sample_format == xap::audioio::SAMPLEFORMAT_INT32) {
+                int32_t value = static_cast<int32_t>(samples[i]) * 65536;
+                memcpy(&data[i * 4U], &value, 4U);
+            } else {
+                float value = static_cast<float>(samples[i]) / 32768.0F;
+                memcpy(&data[i * 4U], &value, 4U);
+            }
+        }
+        record(format, data.data(), 30000U, 480U);
+
+        xap::audioio::AudioFileInfo info = 
+            xap::audioio::audiofile_probe(TEST_PATH);
+        xap::test::assert_equal<uint8_t>(
+            info.container,
+            xap::audioio::AUDIOFILE_WAV
+        );
+        xap::test::assert_equal<uint64_t>(info.frame_count, 30000U);
+        xap::test::assert_ok(info.index_offset != 0U);
+        xap::test::assert_ok(play(format, 30000U) == data);
+    }
+    remove(TEST_PATH);
+}
+
+void g711() {
+    //
+    //  G.711 audio data (odd count of bytes, padded) is decoded by the 
+    //  reader.
+    //
+    std::vector<int16_t> samples = build_samples(8001U);
+    std::vector<uint8_t> encoded(samples.size());
+    xap::audioio::g711_ulaw_encode(
+        samples.data(),
+        encoded.data(),
+        samples.size()
+    );
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_ULAW, 1U, 8000U);
+    record(format, encoded.data(), encoded.size(), 160U);
+
+    xap::audioio::AudioFileInfo info = xap::audioio::audiofile_probe(TEST_PATH);
+    xap::test::assert_ok(info.is_ulaw);
+    xap::test::assert_equal<uint32_t>(info.bits_per_sample, 8U);
+    std::vector<int16_t> expected(samples.size());
+    xap::audioio::g711_ulaw_decode(
+        encoded.data(),
+        expected.data(),
+        encoded.size()
+    );
+    std::vector<uint8_t> played = play(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U),
+        samples.size()
+    );
+    xap::test::assert_equal<size_t>(played.size(), expected.size() * 2U);
+    xap::test::assert_equal<int>(
+        memcmp(played.data(), expected.data(), played.size()),
+        0
+    );
+    remove(TEST_PATH);
+}
+
+void seek_index() {
+    //
+    //  10s of 16-bit stereo audio data at 8kHz, one entry each second.
+    //
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 2U, 8000U);
+    std::vector<int16_t> samples = build_samples(2U * 80000U);
+    std::chrono::system_clock::time_point begin = 
+        std::chrono::system_clock::now();
+    record(format, samples.data(), 80000U, 160U);
+
+    xap::audioio::AudioFileIndex index(TEST_PATH);
+    xap::test::assert_equal<uint32_t>(index.get_granularity(), 8000U);
+    const xap::audioio::AudioFileIndexEntries &entries = index.get_entries();
+    xap::test::assert_equal<size_t>(entries.size(), 10U);
+    int64_t earliest = std::chrono::duration_cast<std::chrono::microseconds>(
+        begin.time_since_epoch()
+    ).count() - 1000000;
+    for (size_t i = 0U; i < entries.size(); ++i) {
+        xap::test::assert_equal<uint64_t>(entries[i].frame, i * 8000U);
+        xap::test::assert_equal<uint64_t>(
+            entries[i].offset,
+            index.get_info().data_offset + i * 8000U * 4U
+        );
+        xap::test::assert_ok(entries[i].time >= earliest);
+        if (i != 0U) {
+            xap::test::assert_ok(entries[i].time >= entries[i - 1U].time);
+        }
+    }
+
+    //
+    //  Lookups.
+    //
+    xap::test::assert_ok(index.find_frame(0U) == &entries[0]);
+    xap::test::assert_ok(index.find_frame(23999U) == &entries[2]);
+    xap::test::assert_ok(index.find_frame(24000U) == &entries[3]);
+    xap::test::assert_ok(index.find_frame(1000000U) == &entries[9]);
+    xap::test::assert_ok(index.find_time(entries[0].time - 1) == nullptr);
+    const xap::audioio::AudioFileIndexEntry *found = 
+        index.find_time(entries[5].time);
+    xap::test::assert_ok(found != nullptr);
+    xap::test::assert_equal<int64_t>(found->time, entries[5].time);
+    xap::test::assert_ok(found->frame >= 5U * 8000U);
+
+    //
+    //  A position is read with a single read at the located offset.
+    //
+    const uint64_t frames[] = {0U, 1U, 12345U, 64000U, 79999U};
+    for (uint64_t frame : frames) {
+        std::vector<uint8_t> bytes = read_bytes(index.locate(frame), 4U);
+        xap::test::assert_equal<int>(
+            memcmp(bytes.data(), &samples[frame * 2U], 4U),
+            0
+        );
+    }
+    remove(TEST_PATH);
+}
+
+void rf64() {
+    //
+    //  The reader and the index follow the RF64 layout written for files 
+    //  beyond 4GB (the sizes of a small file are patched to it).
+    //
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    std::vector<int16_t> samples = build_samples(20001U);
+    record(format, samples.data(), samples.size(), 160U);
+    xap::audioio::AudioFileInfo info = xap::audioio::audiofile_probe(TEST_PATH);
+
+    FILE *file = fopen(TEST_PATH, "r+b");
+    xap::test::assert_ok(file != nullptr);
+    uint8_t header[12] = {'R', 'F', '6', '4', 0xFF, 0xFF, 0xFF, 0xFF};
+    fwrite(header, 1U, 8U, file);
+    uint8_t ds64[36];
+    memset(ds64, 0, sizeof(ds64));
+    memcpy(ds64, "ds64", 4U);
+    ds64[4] = 28U;
+    uint64_t data_size = samples.size() * 2U;
+    for (size_t i = 0U; i < 8U; ++i) {
+        ds64[16U + i] = static_cast<uint8_t>(data_size >> (8U * i));
+    }
+    fseek(file, 12, SEEK_SET);
+    fwrite(ds64, 1U, sizeof(ds64), file);
+    fseek(file, static_cast<long>(info.data_offset) - 4L, SEEK_SET);
+    fwrite(header + 4, 1U, 4U, file);
+    fclose(file);
+
+    xap::audioio::AudioFileInfo patched = 
+        xap::audioio::audiofile_probe(TEST_PATH);
+    xap::test::assert_equal<uint64_t>(patched.frame_count, samples.size());
+    xap::test::assert_equal<uint64_t>(patched.index_offset, info.index_offset);
+    std::vector<uint8_t> played = play(format, samples.size());
+    xap::test::assert_equal<int>(
+        memcmp(played.data(), samples.data(), played.size()),
+        0
+    );
+    xap::audioio::AudioFileIndex index(TEST_PATH);
+    xap::test::assert_equal<size_t>(index.get_entries().size(), 3U);
+    remove(TEST_PATH);
+}
+
+void trim_silence() {
+    //
+    //  Tone (1s), silence (2s), tone (1s), silence (1.5s), tone (0.5s) at 
+    //  8kHz, the first 250ms of each silent span are kept.
+    //
+    const size_t spans[] = {8000U, 16000U, 8000U, 12000U, 4000U};
+    std::vector<int16_t> samples;
+    for (size_t i = 0U; i < 5U; ++i) {
+        std::vector<int16_t> tone = build_samples(spans[i]);
+        for (size_t j = 0U; j < spans[i]; ++j) {
+            //  Noise far below the threshold in the silent spans.
+            samples.push_back(
+                (i & 1U) == 0U ? 
+                    tone[j] : 
+                    static_cast<int16_t>(static_cast<int>(j * 5U % 7U) - 3)
+            );
+        }
+    }
+    const xap::audioio::SampleFormat formats[] = {
+        xap::audioio::SAMPLEFORMAT_INT16,
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        xap::audioio::SAMPLEFORMAT_ULAW
+    };
+    for (xap::audioio::SampleFormat sample_format : formats) {
+        xap::audioio::AudioFormat format = 
+            build_format(sample_format, 1U, 8000U);
+        size_t sample_size = xap::audioio::get_sample_size(sample_format);
+        std::vector<uint8_t> data(samples.size() * sample_size);
+        for (size_t i = 0U; i < samples.size(); ++i) {
+            if (sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+                memcpy(&data[i * 2U], &samples[i], 2U);
+            } else if (sample_format == xap::audioio::SAMPLEFORMAT_FLOAT32) {
+                float value = static_cast<float>(samples[i]) / 32768.0F;
+                memcpy(&data[i * 4U], &value, 4U);
+            } else {
+                xap::audioio::g711_ulaw_encode(&samples[i], &data[i], 1U);
+            }
+        }
+
+        xap::audioio::AudioFileWriterOptions options;
+        options.trim_silence = true;
+        xap::audioio::AudioFileWriter writer(TEST_PATH, format, options);
+        for (size_t offset = 0U; offset < samples.size(); offset += 160U) {
+            xap::audioio::AudioBuffer period = 
+                xap::audioio::AudioBuffer::allocate(format, 160U);
+            memcpy(
+                period.get_pointer(),
+                data.data() + offset * sample_size,
+                160U * sample_size
+            );
+            writer.process(period);
+        }
+
+        //  13 silent periods (2080 frames) are kept of each silent span.
+        uint64_t trimmed = (16000U - 2080U) + (12000U - 2080U);
+        xap::test::assert_equal<uint64_t>(
+            writer.get_trimmed_frame_count(),
+            trimmed
+        );
+        xap::test::assert_equal<uint64_t>(
+            writer.get_frame_count(),
+            samples.size() - trimmed
+        );
+        writer.close();
+
+        //
+        //  The trim map translates the positions of the file.
+        //
+        xap::audioio::AudioFileIndex index(TEST_PATH);
+        const xap::audioio::AudioFileInfo &info = index.get_info();
+        xap::test::assert_equal<uint64_t>(
+            info.frame_count,
+            samples.size() - trimmed
+        );
+        xap::test::assert_ok(info.trim_offset != 0U);
+        const xap::audioio::AudioFileTrimEntries &trims = index.get_trims();
+        xap::test::assert_equal<size_t>(trims.size(), 2U);
+        xap::test::assert_equal<uint64_t>(trims[0].frame, 10080U);
+        xap::test::assert_equal<uint64_t>(trims[0].source_frame, 24000U);
+        xap::test::assert_equal<uint64_t>(trims[1].frame, 20160U);
+        xap::test::assert_equal<uint64_t>(trims[1].source_frame, 44000U);
+        std::vector<uint8_t> written = read_bytes(
+            info.data_offset,
+            static_cast<size_t>(info.frame_count) * sample_size
+        );
+        for (uint64_t frame = 0U; frame < info.frame_count; ++frame) {
+            uint64_t source_frame = index.get_source_frame(frame);
+            xap::test::assert_equal<int>(
+                memcmp(
+                    &written[frame * sample_size],
+                    &data[source_frame * sample_size],
+                    sample_size
+                ),
+                0
+            );
+            xap::test::assert_equal<uint64_t>(
+                index.get_file_frame(source_frame),
+                frame
+            );
+        }
+        xap::test::assert_equal<uint64_t>(index.get_file_frame(20000U), 10080U);
+        xap::test::assert_equal<uint64_t>(index.get_file_frame(40000U), 20160U);
+
+        //  The seek index counts the frames of the file.
+        xap::test::assert_equal<uint64_t>(
+            index.locate(12345U),
+            info.data_offset + 12345U * sample_size
+        );
+    }
+
+    //
+    //  Silent spans skipped entirely (also at the beginning).
+    //
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    xap::audioio::AudioFileWriterOptions options;
+    options.trim_silence = true;
+    options.silence_hangover = 0U;
+    {
+        xap::audioio::AudioFileWriter writer(TEST_PATH, format, options);
+        xap::audioio::AudioBuffer period = 
+            xap::audioio::AudioBuffer::allocate(format, 160U);
+        memset(period.get_pointer(), 0, period.get_length());
+        writer.process(period);
+        memcpy(period.get_pointer(), samples.data(), 320U);
+        writer.process(period);
+        writer.close();
+        xap::test::assert_equal<uint64_t>(writer.get_frame_count(), 160U);
+        xap::test::assert_equal<uint64_t>(
+            writer.get_trimmed_frame_count(),
+            160U
+        );
+    }
+    xap::audioio::AudioFileIndex index(TEST_PATH);
+    xap::test::assert_equal<size_t>(index.get_trims().size(), 1U);
+    xap::test::assert_equal<uint64_t>(index.get_trims()[0].frame, 0U);
+    xap::test::assert_equal<uint64_t>(index.get_source_frame(10U), 170U);
+    xap::test::assert_equal<uint64_t>(index.get_file_frame(100U), 0U);
+
+    //
+    //  Nothing is trimmed if the signal is never silent.
+    //
+    record(format, samples.data(), 8000U, 160U);
+    xap::audioio::AudioFileInfo info = xap::audioio::audiofile_probe(TEST_PATH);
+    xap::test::assert_equal<uint64_t>(info.trim_offset, 0U);
+    remove(TEST_PATH);
+}
+
+void errors() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+
+    //
+    //  Invalid format or options.
+    //
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioFileWriter writer(
+            TEST_PATH,
+            build_format(9U, 1U, 8000U)
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioFileWriterOptions options;
+        options.buffer_frames = 0U;
+        xap::audioio::AudioFileWriter writer(TEST_PATH, format, options);
+    });
+    try {
+        xap::audioio::AudioFileWriterOptions options;
+        options.trim_silence = true;
+        options.index_interval = 0U;
+        xap::audioio::AudioFileWriter writer(TEST_PATH, format, options);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    //
+    //  The file cannot be created.
+    //
+    try {
+        xap::audioio::AudioFileWriter writer(
+            "missing-directory/audiofilewriter.unittest.tmp",
+            format
+        );
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_IO
+        );
+    }
+
+    //
+    //  Mismatched audio data, processing after the file was closed.
+    //
+    xap::audioio::AudioFileWriter writer(TEST_PATH, format);
+    xap::audioio::AudioBuffer stereo = xap::audioio::AudioBuffer::allocate(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 2U, 8000U),
+        160U
+    );
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        writer.process(stereo);
+    });
+    writer.close();
+    writer.close();
+    xap::audioio::AudioBuffer mono = 
+        xap::audioio::AudioBuffer::allocate(format, 160U);
+    try {
+        writer.process(mono);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    //
+    //  A file without audio data.
+    //
+    xap::audioio::AudioFileInfo info = xap::audioio::audiofile_probe(TEST_PATH);
+    xap::test::assert_equal<uint64_t>(info.frame_count, 0U);
+    xap::audioio::AudioFileIndex index(TEST_PATH);
+    xap::test::assert_ok(index.find_frame(0U) == nullptr);
+    xap::test::assert_equal<uint64_t>(index.locate(100U), info.data_offset);
+    remove(TEST_PATH);
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Round trip...\n");
+    round_trip();
+
+    //
+    //  Case 2.
+    //
+    printf("G.711...\n");
+    g711();
+
+    //
+    //  Case 3.
+    //
+    printf("Seek index...\n");
+    seek_index();
+
+    //
+    //  Case 4.
+    //
+    printf("RF64...\n");
+    rf64();
+
+    //
+    //  Case 5.
+    //
+    printf("Silence trimming...\n");
+    trim_silence();
+
+    //
+    //  Case 6.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
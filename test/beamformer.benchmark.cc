@@ -0,0 +1,85 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+const static size_t PERIOD_FRAMES = 160U;     //  10ms at 16kHz.
+const static size_t PERIOD_COUNT  = 1000U;    //  10s.
+const static uint32_t MICROPHONE_COUNT = 8U;
+
+/**
+ *  Run the benchmark with a circular array of 8 microphones at 16kHz.
+ * 
+ *  @param method
+ *      The beamforming method.
+ *  @param name
+ *      The name of the method.
+ */
+static void run(xap::audioio::BeamformerMethod method, const char *name) {
+    xap::audioio::MicrophoneArray array;
+    array.channel_count = MICROPHONE_COUNT;
+    for (uint32_t m = 0U; m < MICROPHONE_COUNT; ++m) {
+        double angle = 2.0 * PI * static_cast<double>(m) / 
+                       static_cast<double>(MICROPHONE_COUNT);
+        array.positions[m].x = static_cast<float>(0.05 * cos(angle));
+        array.positions[m].y = static_cast<float>(0.05 * sin(angle));
+    }
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = static_cast<uint8_t>(MICROPHONE_COUNT);
+    format.sample_rate = 16000U;
+    xap::audioio::BeamformerOptions options;
+    options.method = method;
+    options.azimuth = 45.0F;
+    xap::audioio::Beamformer beamformer(format, array, options);
+
+    xap::audioio::AudioBuffer period = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    uint32_t seed = 1U;
+    for (size_t i = 0U; i < PERIOD_FRAMES * MICROPHONE_COUNT; ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        period.get_samples<int16_t>()[i] = static_cast<int16_t>(seed >> 20);
+    }
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < PERIOD_COUNT; ++i) {
+        xap::audioio::AudioBuffer data = period;
+        beamformer.process(data);
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_FRAMES * PERIOD_COUNT) / 16000.0;
+
+    printf(
+        "%-13s | %20.1f | %14.2f\n",
+        name,
+        audio / elapsed,
+        elapsed / static_cast<double>(PERIOD_COUNT) * 1000000.0
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Method        | Real-time (x faster) | Period (us/op)\n");
+    run(xap::audioio::BEAMFORMER_DELAYANDSUM, "Delay-and-sum");
+    run(xap::audioio::BEAMFORMER_MVDR, "MVDR");
+
+    return 0;
+}
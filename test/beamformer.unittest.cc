@@ -0,0 +1,449 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Sample rate.
+const static uint32_t SAMPLE_RATE = 16000U;
+
+//  Block size (10ms).
+const static size_t BLOCK_FRAMES = 160U;
+
+/**
+ *  A tone of a plane wave.
+ */
+typedef struct Tone_ {
+    double frequency;
+    double amplitude;
+} Tone;
+
+/**
+ *  Build a linear microphone array (along the x axis).
+ * 
+ *  @param count
+ *      The count of microphones.
+ *  @param spacing
+ *      The spacing (in meters).
+ *  @return
+ *      The array.
+ */
+static xap::audioio::MicrophoneArray build_array(
+    uint32_t  count,
+    float     spacing
+) {
+    xap::audioio::MicrophoneArray array;
+    array.channel_count = count;
+    for (uint32_t m = 0U; m < count; ++m) {
+        array.positions[m].x = spacing * static_cast<float>(m);
+    }
+    return array;
+}
+
+/**
+ *  Build an input audio format.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @param channel_count
+ *      The count of channels.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint32_t                    channel_count
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = static_cast<uint8_t>(channel_count);
+    format.sample_rate = SAMPLE_RATE;
+    return format;
+}
+
+/**
+ *  Render plane waves received by an array (exact fractional delays).
+ * 
+ *  @param array
+ *      The array.
+ *  @param azimuth
+ *      The azimuth of the source (in degrees).
+ *  @param tones
+ *      The tones of the source.
+ *  @param start
+ *      The index of the first frame.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param output
+ *      The output (interleaved, accumulated).
+ */
+static void render(
+    const xap::audioio::MicrophoneArray  &array,
+    double                                azimuth,
+    const std::vector<Tone>              &tones,
+    size_t                                start,
+    size_t                                frame_count,
+    std::vector<double>                  &output
+) {
+    double ux = cos(azimuth * PI / 180.0);
+    double uy = sin(azimuth * PI / 180.0);
+    size_t channel_count = array.channel_count;
+    for (size_t m = 0U; m < channel_count; ++m) {
+        double lead = 
+            (static_cast<double>(array.positions[m].x) * ux + 
+             static_cast<double>(array.positions[m].y) * uy) / 
+            static_cast<double>(array.speed_of_sound) * 
+            static_cast<double>(SAMPLE_RATE);
+        for (size_t i = 0U; i < frame_count; ++i) {
+            double t = static_cast<double>(start + i) + lead;
+            double value = 0.0;
+            for (const Tone &tone : tones) {
+                value += tone.amplitude * sin(
+                    2.0 * PI * tone.frequency * t / 
+                    static_cast<double>(SAMPLE_RATE)
+                );
+            }
+            output[i * channel_count + m] += value;
+        }
+    }
+}
+
+/**
+ *  Run plane waves through a beamformer.
+ * 
+ *  @param beamformer
+ *      The beamformer.
+ *  @param format
+ *      The input audio format.
+ *  @param array
+ *      The array.
+ *  @param sources
+ *      The azimuths and the tones of the sources.
+ *  @param start
+ *      The index of the first frame.
+ *  @param frame_count
+ *      The count of frames (a multiple of BLOCK_FRAMES).
+ *  @return
+ *      The output samples (as float).
+ */
+static std::vector<float> run(
+    xap::audioio::Beamformer                                &beamformer,
+    const xap::audioio::AudioFormat                         &format,
+    const xap::audioio::MicrophoneArray                     &array,
+    const std::vector<std::pair<double, std::vector<Tone>>> &sources,
+    size_t                                                   start,
+    size_t                                                   frame_count
+) {
+    std::vector<float> samples;
+    size_t channel_count = format.channel_count;
+    std::vector<double> mixed(BLOCK_FRAMES * channel_count);
+    for (size_t offset = 0U; offset < frame_count; offset += BLOCK_FRAMES) {
+        std::fill(mixed.begin(), mixed.end(), 0.0);
+        for (const auto &source : sources) {
+            render(
+                array,
+                source.first,
+                source.second,
+                start + offset,
+                BLOCK_FRAMES,
+                mixed
+            );
+        }
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, BLOCK_FRAMES);
+        data.set_timestamp(start + offset);
+        for (size_t i = 0U; i < mixed.size(); ++i) {
+            if (format.sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+                data.get_samples<int16_t>()[i] = 
+                    static_cast<int16_t>(lrint(mixed[i]));
+            } else {
+                data.get_samples<float>()[i] = static_cast<float>(mixed[i]);
+            }
+        }
+        beamformer.process(data);
+        xap::test::assert_equal<uint8_t>(data.get_channel_count(), 1U);
+        xap::test::assert_equal<size_t>(data.get_frame_count(), BLOCK_FRAMES);
+        xap::test::assert_equal<uint64_t>(data.get_timestamp(), start + offset);
+        for (size_t i = 0U; i < BLOCK_FRAMES; ++i) {
+            samples.push_back(
+                format.sample_format == xap::audioio::SAMPLEFORMAT_INT16 ? 
+                    static_cast<float>(data.get_samples<int16_t>()[i]) :
+                    data.get_samples<float>()[i]
+            );
+        }
+    }
+    return samples;
+}
+
+/**
+ *  Measure the amplitude of a tone (the samples span whole periods).
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param frequency
+ *      The frequency.
+ *  @return
+ *      The amplitude.
+ */
+static double measure(const std::vector<float> &samples, double frequency) {
+    double re = 0.0;
+    double im = 0.0;
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        double phase = 2.0 * PI * frequency * static_cast<double>(i) / 
+                       static_cast<double>(SAMPLE_RATE);
+        re += static_cast<double>(samples[i]) * cos(phase);
+        im += static_cast<double>(samples[i]) * sin(phase);
+    }
+    return 2.0 * sqrt(re * re + im * im) / static_cast<double>(samples.size());
+}
+
+/**
+ *  Measure the power of tones.
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param tones
+ *      The tones.
+ *  @return
+ *      The power.
+ */
+static double measure_power(
+    const std::vector<float> &samples,
+    const std::vector<Tone>  &tones
+) {
+    double power = 0.0;
+    for (const Tone &tone : tones) {
+        double amplitude = measure(samples, tone.frequency);
+        power += amplitude * amplitude;
+    }
+    return power;
+}
+
+//
+//  Test cases.
+//
+
+void delay_and_sum() {
+    //
+    //  Integer delays (spacing of one sample), the gain of the look 
+    //  direction is 1 and the opposite direction is attenuated.
+    //
+    xap::audioio::MicrophoneArray array = 
+        build_array(4U, 343.0F / static_cast<float>(SAMPLE_RATE));
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 4U);
+    xap::audioio::BeamformerOptions options;
+    options.method = xap::audioio::BEAMFORMER_DELAYANDSUM;
+    options.azimuth = 180.0F;
+    xap::audioio::Beamformer beamformer(format, array, options);
+    xap::test::assert_equal<uint8_t>(
+        beamformer.get_output_format().channel_count,
+        1U
+    );
+
+    std::vector<Tone> tones = {{3000.0, 0.5}};
+    std::vector<std::pair<double, std::vector<Tone>>> sources = {
+        {0.0, tones}
+    };
+    run(beamformer, format, array, sources, 0U, 1600U);
+    std::vector<float> away = 
+        run(beamformer, format, array, sources, 1600U, 16000U);
+
+    //  Steer to the source (applied asynchronously).
+    beamformer.set_direction(0.0F, 0.0F);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    run(beamformer, format, array, sources, 17600U, 1600U);
+    std::vector<float> toward = 
+        run(beamformer, format, array, sources, 19200U, 16000U);
+
+    double gain_toward = measure(toward, 3000.0) / 0.5;
+    double gain_away = measure(away, 3000.0) / 0.5;
+    xap::test::assert_ok(fabs(gain_toward - 1.0) < 0.01, "Gain mismatched.");
+    xap::test::assert_ok(
+        gain_toward * gain_toward > 3.0 * gain_away * gain_away,
+        "Not attenuated."
+    );
+
+    //  The output is the source delayed by the interpolator.
+    for (size_t i = 7U; i < toward.size(); ++i) {
+        double t = static_cast<double>(19200U + i - 7U);
+        double expected = 
+            0.5 * sin(2.0 * PI * 3000.0 * t / static_cast<double>(SAMPLE_RATE));
+        xap::test::assert_ok(fabs(toward[i] - expected) < 0.005);
+    }
+}
+
+void fractional_int16() {
+    //
+    //  Fractional delays (spacing of half a sample), 16-bit.
+    //
+    xap::audioio::MicrophoneArray array = 
+        build_array(4U, 0.5F * 343.0F / static_cast<float>(SAMPLE_RATE));
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 4U);
+    xap::audioio::BeamformerOptions options;
+    options.method = xap::audioio::BEAMFORMER_DELAYANDSUM;
+    xap::audioio::Beamformer beamformer(format, array, options);
+
+    std::vector<Tone> tones = {{1000.0, 8000.0}, {4000.0, 8000.0}};
+    std::vector<std::pair<double, std::vector<Tone>>> sources = {
+        {0.0, tones}
+    };
+    run(beamformer, format, array, sources, 0U, 1600U);
+    std::vector<float> output = 
+        run(beamformer, format, array, sources, 1600U, 16000U);
+    for (const Tone &tone : tones) {
+        double gain = measure(output, tone.frequency) / tone.amplitude;
+        xap::test::assert_ok(fabs(gain - 1.0) < 0.02, "Gain mismatched.");
+    }
+}
+
+void mvdr() {
+    //
+    //  Target at endfire, interferer at broadside: MVDR rejects the 
+    //  interferer better than delay-and-sum (by > 6dB).
+    //
+    xap::audioio::MicrophoneArray array = build_array(4U, 0.04F);
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 4U);
+    std::vector<Tone> target = {{700.0, 0.1}, {1300.0, 0.1}, {2100.0, 0.1}};
+    std::vector<Tone> interferer = {
+        {500.0, 0.3}, {1100.0, 0.3}, {1700.0, 0.3}, {2500.0, 0.3}
+    };
+    std::vector<std::pair<double, std::vector<Tone>>> sources = {
+        {0.0, target},
+        {90.0, interferer}
+    };
+
+    double sir[2];
+    for (size_t k = 0U; k < 2U; ++k) {
+        xap::audioio::BeamformerOptions options;
+        options.method = (k == 0U ? 
+                          xap::audioio::BEAMFORMER_DELAYANDSUM :
+                          xap::audioio::BEAMFORMER_MVDR);
+        options.covariance_time = 200U;
+        options.update_interval = 50U;
+        xap::audioio::Beamformer beamformer(format, array, options);
+        run(beamformer, format, array, sources, 0U, 16000U);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::vector<float> output = 
+            run(beamformer, format, array, sources, 16000U, 16000U);
+        sir[k] = 10.0 * log10(
+            measure_power(output, target) / measure_power(output, interferer)
+        );
+
+        //  The target is not distorted.
+        for (const Tone &tone : target) {
+            double gain = measure(output, tone.frequency) / tone.amplitude;
+            xap::test::assert_ok(fabs(gain - 1.0) < 0.1, "Gain mismatched.");
+        }
+        if (k == 1U) {
+            xap::test::assert_equal<size_t>(beamformer.get_latency(), 512U);
+        }
+    }
+    printf("SIR: %.1fdB (delay-and-sum), %.1fdB (MVDR).\n", sir[0], sir[1]);
+    xap::test::assert_ok(sir[1] > sir[0] + 6.0, "Interferer not rejected.");
+}
+
+void invalid() {
+    xap::audioio::MicrophoneArray array = build_array(4U, 0.04F);
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 4U);
+    xap::audioio::BeamformerOptions options;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::Beamformer beamformer(
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 3U),
+            array,
+            options
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::Beamformer beamformer(
+            build_format(xap::audioio::SAMPLEFORMAT_INT32, 4U),
+            array,
+            options
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::BeamformerOptions invalid = options;
+        invalid.fft_size = 300U;
+        xap::audioio::Beamformer beamformer(format, array, invalid);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::BeamformerOptions invalid = options;
+        invalid.method = 2U;
+        xap::audioio::Beamformer beamformer(format, array, invalid);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::MicrophoneArray single = build_array(1U, 0.04F);
+        xap::audioio::Beamformer beamformer(
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 1U),
+            single,
+            options
+        );
+    });
+
+    //  Too many frames, or mismatched format.
+    options.max_frames = 256U;
+    xap::audioio::Beamformer beamformer(format, array, options);
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, 257U);
+        beamformer.process(data);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U),
+            256U
+        );
+        beamformer.process(data);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Delay-and-sum...\n");
+    delay_and_sum();
+
+    //
+    //  Case 2.
+    //
+    printf("Delay-and-sum, fractional delays, 16-bit...\n");
+    fractional_int16();
+
+    //
+    //  Case 3.
+    //
+    printf("MVDR...\n");
+    mvdr();
+
+    //
+    //  Case 4.
+    //
+    printf("Invalid arguments...\n");
+    invalid();
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static uint32_t SAMPLE_RATE = 48000U;
+const static size_t POINT_COUNT = 72U;        //  Every 10 degrees, 2 rings.
+const static size_t TAP_COUNT = 256U;
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t PERIOD_COUNT = 1000U;     //  10s.
+
+/**
+ *  Source of a sine wave (mono 32-bit float).
+ */
+class SineSource: public xap::audioio::ISource {
+public:
+    explicit SineSource(double step) : m_step(step), m_phase(0.0) {}
+
+    virtual size_t read(xap::audioio::AudioBuffer &output) override {
+        float *samples = output.get_samples<float>();
+        for (size_t i = 0U; i < output.get_frame_count(); ++i) {
+            samples[i] = static_cast<float>(0.1 * sin(this->m_phase));
+            this->m_phase += this->m_step;
+        }
+        return output.get_frame_count();
+    }
+
+private:
+    double m_step;
+    double m_phase;
+};
+
+/**
+ *  Run the benchmark.
+ * 
+ *  @param voice_count
+ *      The count of voices.
+ *  @param is_moving
+ *      True to move all voices each period.
+ *  @return
+ *      The real-time factor.
+ */
+static double run(size_t voice_count, bool is_moving) {
+    std::vector<xap::audioio::BinauralDirection> directions(POINT_COUNT);
+    std::vector<float> left(POINT_COUNT * TAP_COUNT);
+    std::vector<float> right(POINT_COUNT * TAP_COUNT);
+    for (size_t i = 0U; i < POINT_COUNT; ++i) {
+        directions[i].azimuth = 10.0F * static_cast<float>(i % 36U);
+        directions[i].elevation = i < 36U ? 0.0F : 30.0F;
+    }
+    for (size_t i = 0U; i < left.size(); ++i) {
+        left[i] = static_cast<float>(sin(static_cast<double>(i) * 0.3)) * 
+                  expf(-static_cast<float>(i % TAP_COUNT) * 0.02F);
+        right[i] = static_cast<float>(cos(static_cast<double>(i) * 0.2)) * 
+                   expf(-static_cast<float>(i % TAP_COUNT) * 0.02F);
+    }
+    std::shared_ptr<const xap::audioio::HrirSet> hrirs(
+        new xap::audioio::HrirSet(
+            directions.data(),
+            POINT_COUNT,
+            left.data(),
+            right.data(),
+            TAP_COUNT,
+            SAMPLE_RATE
+        )
+    );
+
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 2U;
+    format.sample_rate = SAMPLE_RATE;
+    xap::audioio::BinauralMixer mixer(hrirs, format);
+    std::vector<size_t> voices;
+    for (size_t i = 0U; i < voice_count; ++i) {
+        xap::audioio::BinauralDirection direction;
+        direction.azimuth = 11.0F * static_cast<float>(i);
+        voices.push_back(mixer.add_voice(
+            std::make_shared<SineSource>(0.01 * static_cast<double>(i + 1U)),
+            direction
+        ));
+    }
+    xap::audioio::AudioBuffer period = xap::audioio::AudioBuffer::allocate(
+        format,
+        PERIOD_FRAMES
+    );
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t k = 0U; k < PERIOD_COUNT; ++k) {
+        if (is_moving) {
+            for (size_t i = 0U; i < voice_count; ++i) {
+                xap::audioio::BinauralDirection direction;
+                direction.azimuth = static_cast<float>(11U * i + k);
+                mixer.set_direction(voices[i], direction);
+            }
+        }
+        mixer.read(period);
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    return static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 
+           static_cast<double>(SAMPLE_RATE) / 
+           elapsed;
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Voices | Static (x real-time) | Moving (x real-time)\n");
+    for (size_t voice_count = 1U; voice_count <= 32U; voice_count *= 2U) {
+        printf(
+            "%6u | %20.1f | %20.1f\n",
+            static_cast<unsigned>(voice_count),
+            run(voice_count, false),
+            run(voice_count, true)
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,472 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+
+//  Sample rate.
+const static uint32_t SAMPLE_RATE = 16000U;
+
+//  Count of measurement points (a ring in the horizontal plane, every 30 
+//  degrees).
+const static size_t POINT_COUNT = 12U;
+
+//  Count of taps of each impulse response (3 partitions of 128 frames).
+const static size_t TAP_COUNT = 300U;
+
+//
+//  Private classes.
+//
+
+/**
+ *  Source of mono test audio data (silent after the end).
+ */
+class DataSource: public xap::audioio::ISource {
+public:
+    /**
+     *  Construct the object.
+     * 
+     *  @param data
+     *      The audio data.
+     */
+    explicit DataSource(const std::vector<float> &data) :
+        m_data(data),
+        m_offset(0U)
+    {}
+
+    /**
+     *  Read audio data.
+     * 
+     *  @param output
+     *      The output.
+     *  @return
+     *      The count of frames read.
+     */
+    virtual size_t read(xap::audioio::AudioBuffer &output) override {
+        float *samples = output.get_samples<float>();
+        size_t count = std::min(
+            output.get_frame_count(),
+            this->m_data.size() - this->m_offset
+        );
+        std::copy(
+            this->m_data.begin() + static_cast<ptrdiff_t>(this->m_offset),
+            this->m_data.begin() + 
+                static_cast<ptrdiff_t>(this->m_offset + count),
+            samples
+        );
+        this->m_offset += count;
+        return count;
+    }
+
+private:
+    std::vector<float>  m_data;
+    size_t              m_offset;
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the output format (stereo 32-bit float).
+ */
+static xap::audioio::AudioFormat get_format() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 2U;
+    format.sample_rate = SAMPLE_RATE;
+    return format;
+}
+
+/**
+ *  Get the delay (in frames) of an ear of a measurement point.
+ */
+static size_t get_delay(size_t point, size_t ear) {
+    return ear == 0U ? 3U * point : 200U + 7U * point;
+}
+
+/**
+ *  Get the gain of an ear of a measurement point.
+ */
+static float get_gain(size_t point, size_t ear) {
+    return ear == 0U ? 
+           0.2F + 0.05F * static_cast<float>(point) :
+           0.9F - 0.05F * static_cast<float>(point);
+}
+
+/**
+ *  Build the test HRIR set (a delayed and scaled impulse of each ear of 
+ *  each point).
+ */
+static std::shared_ptr<const xap::audioio::HrirSet> build_hrirs() {
+    std::vector<xap::audioio::BinauralDirection> directions(POINT_COUNT);
+    std::vector<float> left(POINT_COUNT * TAP_COUNT, 0.0F);
+    std::vector<float> right(POINT_COUNT * TAP_COUNT, 0.0F);
+    for (size_t i = 0U; i < POINT_COUNT; ++i) {
+        directions[i].azimuth = 30.0F * static_cast<float>(i);
+        left[i * TAP_COUNT + get_delay(i, 0U)] = get_gain(i, 0U);
+        right[i * TAP_COUNT + get_delay(i, 1U)] = get_gain(i, 1U);
+    }
+    return std::shared_ptr<const xap::audioio::HrirSet>(
+        new xap::audioio::HrirSet(
+            directions.data(),
+            POINT_COUNT,
+            left.data(),
+            right.data(),
+            TAP_COUNT,
+            SAMPLE_RATE
+        )
+    );
+}
+
+/**
+ *  Build test audio data (pseudo-random noise).
+ */
+static std::vector<float> build_noise(size_t count, uint32_t seed) {
+    std::vector<float> data(count);
+    for (size_t i = 0U; i < count; ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        data[i] = static_cast<float>(seed >> 8U) / 16777216.0F - 0.5F;
+    }
+    return data;
+}
+
+/**
+ *  Read from a mixer (in periods of a count of frames).
+ * 
+ *  @param mixer
+ *      The mixer.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param period_frames
+ *      The count of frames of each period.
+ *  @return
+ *      The interleaved stereo audio data.
+ */
+static std::vector<float> render(
+    xap::audioio::BinauralMixer    &mixer,
+    size_t                          frame_count,
+    size_t                          period_frames
+) {
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(get_format(), period_frames);
+    std::vector<float> rendered;
+    while (rendered.size() < 2U * frame_count) {
+        size_t count = mixer.read(output);
+        xap::test::assert_equal<size_t>(count, period_frames);
+        const float *samples = output.get_samples<float>();
+        rendered.insert(rendered.end(), samples, samples + 2U * count);
+    }
+    return rendered;
+}
+
+/**
+ *  Test a voice on a measurement point (versus direct convolution).
+ */
+static void exact() {
+    std::vector<float> noise = build_noise(2000U, 1U);
+    xap::audioio::BinauralMixer mixer(build_hrirs(), get_format());
+    xap::audioio::BinauralDirection direction;
+    direction.azimuth = 60.0F;
+    mixer.add_voice(std::make_shared<DataSource>(noise), direction);
+
+    //  Odd period, not aligned to the blocks.
+    std::vector<float> rendered = render(mixer, 2500U, 100U);
+    for (size_t ear = 0U; ear < 2U; ++ear) {
+        size_t delay = get_delay(2U, ear);
+        float gain = get_gain(2U, ear);
+        for (size_t i = 0U; i < 2500U; ++i) {
+            float expected = i >= delay && i - delay < noise.size() ? 
+                             gain * noise[i - delay] :
+                             0.0F;
+            xap::test::assert_ok(
+                fabsf(rendered[2U * i + ear] - expected) < 1e-4F
+            );
+        }
+    }
+}
+
+/**
+ *  Test interpolation between measurement points.
+ */
+static void interpolated() {
+    std::shared_ptr<const xap::audioio::HrirSet> hrirs = build_hrirs();
+    xap::test::assert_equal<size_t>(hrirs->get_point_count(), POINT_COUNT);
+    xap::test::assert_equal<size_t>(hrirs->get_partition_count(), 3U);
+
+    //  On a point: that point only.
+    size_t points[xap::audioio::BINAURAL_INTERPOLATION_POINTS];
+    float weights[xap::audioio::BINAURAL_INTERPOLATION_POINTS];
+    xap::audioio::BinauralDirection direction;
+    direction.azimuth = -90.0F;
+    hrirs->interpolate(direction, points, weights);
+    xap::test::assert_equal<size_t>(points[0], 9U);
+    xap::test::assert_ok(fabsf(weights[0] - 1.0F) < 1e-6F);
+    xap::test::assert_ok(weights[1] == 0.0F && weights[2] == 0.0F);
+
+    //  Half-way: both neighbors equally, the third one by 1 / 45^2.
+    direction.azimuth = 45.0F;
+    hrirs->interpolate(direction, points, weights);
+    xap::test::assert_ok(
+        (points[0] == 1U && points[1] == 2U) || 
+        (points[0] == 2U && points[1] == 1U)
+    );
+    xap::test::assert_ok(fabsf(weights[0] - weights[1]) < 1e-5F);
+    xap::test::assert_ok(fabsf(weights[2] - 1.0F / 19.0F) < 1e-5F);
+    xap::test::assert_ok(
+        fabsf(weights[0] + weights[1] + weights[2] - 1.0F) < 1e-5F
+    );
+
+    //  Rendered: the weighted sum of the impulse responses.
+    std::vector<float> impulse(1U, 1.0F);
+    xap::audioio::BinauralMixer mixer(hrirs, get_format());
+    mixer.add_voice(std::make_shared<DataSource>(impulse), direction);
+    std::vector<float> rendered = render(mixer, 512U, 128U);
+    for (size_t ear = 0U; ear < 2U; ++ear) {
+        std::vector<float> expected(512U, 0.0F);
+        for (size_t k = 0U; k < 3U; ++k) {
+            expected[get_delay(points[k], ear)] += 
+                weights[k] * get_gain(points[k], ear);
+        }
+        for (size_t i = 0U; i < 512U; ++i) {
+            xap::test::assert_ok(
+                fabsf(rendered[2U * i + ear] - expected[i]) < 1e-4F
+            );
+        }
+    }
+}
+
+/**
+ *  Test moving a voice (cross-faded, no clicks).
+ */
+static void moving() {
+    //  Direct current, so that the output is the gain of the HRIR.
+    std::vector<float> constant(16000U, 1.0F);
+    xap::audioio::BinauralMixer mixer(build_hrirs(), get_format());
+    size_t voice = mixer.add_voice(std::make_shared<DataSource>(constant));
+    std::vector<float> before = render(mixer, 1024U, 128U);
+    xap::test::assert_ok(
+        fabsf(before[2U * 1023U] - get_gain(0U, 0U)) < 1e-4F
+    );
+
+    xap::audioio::BinauralDirection direction;
+    direction.azimuth = 180.0F;
+    mixer.set_direction(voice, direction);
+    std::vector<float> after = render(mixer, 1024U, 128U);
+
+    //  The gain steps 0.3 at once, the cross-fade spreads the step over a 
+    //  block.
+    float previous = before[2U * 1023U];
+    float largest = 0.0F;
+    for (size_t i = 0U; i < 1024U; ++i) {
+        largest = std::max(largest, fabsf(after[2U * i] - previous));
+        previous = after[2U * i];
+    }
+    xap::test::assert_ok(largest < 0.01F);
+    xap::test::assert_ok(
+        fabsf(after[2U * 1023U] - get_gain(6U, 0U)) < 1e-4F
+    );
+}
+
+/**
+ *  Test mixers sharing a HRIR set.
+ */
+static void shared() {
+    std::shared_ptr<const xap::audioio::HrirSet> hrirs = build_hrirs();
+    xap::audioio::BinauralMixer mixer1(hrirs, get_format());
+    xap::audioio::BinauralMixer mixer2(hrirs, get_format());
+    xap::test::assert_equal<long>(hrirs.use_count(), 3L);
+
+    std::vector<float> noise1 = build_noise(3000U, 1U);
+    std::vector<float> noise2 = build_noise(3000U, 2U);
+    xap::audioio::BinauralDirection direction1;
+    direction1.azimuth = 20.0F;
+    xap::audioio::BinauralDirection direction2;
+    direction2.azimuth = -100.0F;
+    direction2.elevation = 30.0F;
+    mixer1.add_voice(std::make_shared<DataSource>(noise1), direction1);
+    mixer1.add_voice(std::make_shared<DataSource>(noise2), direction2);
+    mixer2.add_voice(std::make_shared<DataSource>(noise2), direction2);
+    mixer2.add_voice(std::make_shared<DataSource>(noise1), direction1);
+    std::vector<float> rendered1 = render(mixer1, 3200U, 160U);
+    std::vector<float> rendered2 = render(mixer2, 3200U, 320U);
+    for (size_t i = 0U; i < rendered1.size(); ++i) {
+        xap::test::assert_ok(fabsf(rendered1[i] - rendered2[i]) < 1e-5F);
+    }
+}
+
+/**
+ *  Test adding and removing voices.
+ */
+static void voices() {
+    xap::audioio::BinauralMixerOptions options;
+    options.max_voices = 2U;
+    xap::audioio::BinauralMixer mixer(build_hrirs(), get_format(), options);
+    std::shared_ptr<DataSource> source = 
+        std::make_shared<DataSource>(build_noise(1000U, 3U));
+    size_t voice1 = mixer.add_voice(source);
+    size_t voice2 = mixer.add_voice(source);
+    xap::test::assert_ok(voice1 != voice2);
+    xap::test::assert_equal<size_t>(mixer.get_voice_count(), 2U);
+    try {
+        mixer.add_voice(source);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+
+    //  The slot is released once the audio thread dropped the voice.
+    mixer.remove_voice(voice1);
+    xap::test::assert_equal<size_t>(mixer.get_voice_count(), 2U);
+    render(mixer, 128U, 128U);
+    xap::test::assert_equal<size_t>(mixer.get_voice_count(), 1U);
+    xap::test::assert_equal<long>(source.use_count(), 2L);
+    try {
+        mixer.remove_voice(voice1);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    size_t voice3 = mixer.add_voice(source);
+    xap::test::assert_ok(voice3 != voice1 && voice3 != voice2);
+    mixer.remove_voice(voice2);
+    mixer.remove_voice(voice3);
+    render(mixer, 128U, 64U);
+    xap::test::assert_equal<size_t>(mixer.get_voice_count(), 0U);
+    xap::test::assert_equal<long>(source.use_count(), 1L);
+
+    //  No voice: silence.
+    std::vector<float> rendered = render(mixer, 256U, 128U);
+    for (size_t i = 0U; i < rendered.size(); ++i) {
+        xap::test::assert_ok(rendered[i] == 0.0F);
+    }
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    std::vector<xap::audioio::BinauralDirection> directions(1U);
+    std::vector<float> taps(16U, 0.0F);
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::HrirSet hrirs(
+            directions.data(),
+            1U,
+            taps.data(),
+            taps.data(),
+            16U,
+            SAMPLE_RATE,
+            100U
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::HrirSet hrirs(
+            directions.data(),
+            0U,
+            taps.data(),
+            taps.data(),
+            16U,
+            SAMPLE_RATE
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::BinauralMixer mixer(nullptr, get_format());
+    });
+
+    std::shared_ptr<const xap::audioio::HrirSet> hrirs = build_hrirs();
+    xap::audioio::AudioFormat format = get_format();
+    format.channel_count = 1U;
+    try {
+        xap::audioio::BinauralMixer mixer(hrirs, format);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    format = get_format();
+    format.sample_rate = 48000U;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::BinauralMixer mixer(hrirs, format);
+    });
+
+    xap::audioio::BinauralMixer mixer(hrirs, get_format());
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        mixer.add_voice(nullptr);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        mixer.set_direction(1U, xap::audioio::BinauralDirection());
+    });
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 128U);
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        mixer.read(output);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Exact...\n");
+    exact();
+
+    //
+    //  Case 2.
+    //
+    printf("Interpolated...\n");
+    interpolated();
+
+    //
+    //  Case 3.
+    //
+    printf("Moving...\n");
+    moving();
+
+    //
+    //  Case 4.
+    //
+    printf("Shared...\n");
+    shared();
+
+    //
+    //  Case 5.
+    //
+    printf("Voices...\n");
+    voices();
+
+    //
+    //  Case 6.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
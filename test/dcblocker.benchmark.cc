@@ -0,0 +1,104 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t PERIOD_COUNT  = 100000U;  //  1000s.
+const static size_t CHANNEL_COUNT = 2U;
+
+/**
+ *  Run the benchmark (stereo 48kHz periods of 16-bit input).
+ * 
+ *  @param name
+ *      The name of the method.
+ *  @param output_sample_format
+ *      The output sample format of the stage.
+ *  @param separate
+ *      True to convert to 32-bit float before filtering (two passes).
+ */
+static void run(
+    const char                  *name,
+    xap::audioio::SampleFormat   output_sample_format,
+    bool                         separate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = static_cast<uint8_t>(CHANNEL_COUNT);
+    format.sample_rate = 48000U;
+    xap::audioio::AudioFormat float_format = format;
+    float_format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+
+    std::vector<int16_t> input(PERIOD_FRAMES * CHANNEL_COUNT);
+    for (size_t i = 0U; i < input.size(); ++i) {
+        input[i] = static_cast<int16_t>(
+            1000.0 + 8000.0 * sin(static_cast<double>(i))
+        );
+    }
+    xap::audioio::DcBlocker stage(
+        separate ? float_format : format,
+        output_sample_format,
+        PERIOD_FRAMES
+    );
+    xap::audioio::AudioBuffer period = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    xap::audioio::AudioBuffer converted = 
+        xap::audioio::AudioBuffer::allocate(float_format, PERIOD_FRAMES);
+
+    double checksum = 0.0;
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t index = 0U; index < PERIOD_COUNT; ++index) {
+        memcpy(
+            period.get_pointer(),
+            input.data(),
+            input.size() * sizeof(int16_t)
+        );
+        xap::audioio::AudioBuffer data = period;
+        if (separate) {
+            const int16_t *source = period.get_samples<int16_t>();
+            float *target = converted.get_samples<float>();
+            for (size_t i = 0U; i < input.size(); ++i) {
+                target[i] = static_cast<float>(source[i]) / 32768.0F;
+            }
+            data = converted;
+        }
+        stage.process(data);
+        if (data.get_sample_format() == xap::audioio::SAMPLEFORMAT_INT16) {
+            checksum += static_cast<double>(data.get_samples<int16_t>()[0]);
+        } else {
+            checksum += static_cast<double>(data.get_samples<float>()[0]);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 
+                   48000.0;
+    printf("%-24s | %20.1f | %g\n", name, audio / elapsed, checksum);
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Method                   | Real-time (x faster) | Checksum\n");
+    run("Convert, then filter", xap::audioio::SAMPLEFORMAT_FLOAT32, true);
+    run("Fused conversion", xap::audioio::SAMPLEFORMAT_FLOAT32, false);
+    run("Fixed point (16-bit)", xap::audioio::SAMPLEFORMAT_INT16, false);
+    return 0;
+}
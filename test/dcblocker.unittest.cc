@@ -0,0 +1,406 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Count of frames of the test signals (2s at 48kHz) and of each period.
+const static size_t FRAME_COUNT = 96000U;
+const static size_t PERIOD_FRAMES = 480U;
+
+//  DC offsets of the channels of the test signals.
+const static int DC_OFFSETS[2] = {8000, -3000};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the format of the test signals (stereo 48kHz).
+ */
+static xap::audioio::AudioFormat get_format(
+    xap::audioio::SampleFormat sample_format
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    return format;
+}
+
+/**
+ *  Build a test signal (a 1kHz sine with a DC offset on each channel).
+ */
+static std::vector<int16_t> build_signal() {
+    std::vector<int16_t> samples(2U * FRAME_COUNT);
+    for (size_t i = 0U; i < FRAME_COUNT; ++i) {
+        double value = 4000.0 * sin(2.0 * PI * static_cast<double>(i) / 48.0);
+        for (size_t c = 0U; c < 2U; ++c) {
+            samples[2U * i + c] = static_cast<int16_t>(
+                lrint(value + static_cast<double>(DC_OFFSETS[c]))
+            );
+        }
+    }
+    return samples;
+}
+
+/**
+ *  Run a stage over samples (in periods).
+ * 
+ *  @param stage
+ *      The stage.
+ *  @param format
+ *      The input format.
+ *  @param input
+ *      The input samples.
+ *  @param output
+ *      The output samples (output).
+ *  @param output_size
+ *      The size of each output sample.
+ */
+static void run(
+    xap::audioio::DcBlocker          &stage,
+    const xap::audioio::AudioFormat  &format,
+    const void                       *input,
+    void                             *output,
+    size_t                            output_size
+) {
+    size_t input_size = xap::audioio::get_sample_size(format.sample_format);
+    for (size_t offset = 0U; offset < FRAME_COUNT; offset += PERIOD_FRAMES) {
+        xap::audioio::AudioBuffer period = 
+            xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+        memcpy(
+            period.get_pointer(),
+            static_cast<const uint8_t *>(input) + offset * 2U * input_size,
+            PERIOD_FRAMES * 2U * input_size
+        );
+        period.set_timestamp(static_cast<int64_t>(offset));
+        stage.process(period);
+        xap::test::assert_equal<uint8_t>(
+            period.get_sample_format(),
+            stage.get_output_format().sample_format
+        );
+        xap::test::assert_equal<size_t>(
+            period.get_frame_count(),
+            PERIOD_FRAMES
+        );
+        xap::test::assert_equal<int64_t>(
+            period.get_timestamp(),
+            static_cast<int64_t>(offset)
+        );
+        memcpy(
+            static_cast<uint8_t *>(output) + offset * 2U * output_size,
+            period.get_pointer(),
+            PERIOD_FRAMES * 2U * output_size
+        );
+    }
+}
+
+/**
+ *  Get the mean and the RMS of a channel over the second half of a signal 
+ *  (after the filter settled, in full scale units).
+ */
+template<class T>
+static void measure(
+    const std::vector<T>  &samples,
+    size_t                 channel,
+    double                 scale,
+    double                &mean,
+    double                &rms
+) {
+    double sum = 0.0;
+    double squares = 0.0;
+    for (size_t i = FRAME_COUNT / 2U; i < FRAME_COUNT; ++i) {
+        double value = static_cast<double>(samples[2U * i + channel]) * scale;
+        sum += value;
+        squares += value * value;
+    }
+    double count = static_cast<double>(FRAME_COUNT / 2U);
+    mean = sum / count;
+    rms = sqrt(squares / count - mean * mean);
+}
+
+//
+//  Test cases.
+//
+
+/**
+ *  Test the 16-bit to 32-bit float conversion.
+ */
+static void conversion() {
+    std::vector<int16_t> samples = build_signal();
+    std::vector<float> output(samples.size());
+    xap::audioio::AudioFormat format = 
+        get_format(xap::audioio::SAMPLEFORMAT_INT16);
+    xap::audioio::DcBlocker stage(
+        format,
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        PERIOD_FRAMES
+    );
+    xap::test::assert_equal<uint32_t>(
+        stage.get_output_format().sample_rate,
+        48000U
+    );
+    run(stage, format, samples.data(), output.data(), sizeof(float));
+
+    //
+    //  The offset is removed, the sine is passed (1kHz is far above the 
+    //  cutoff).
+    //
+    double expected = 4000.0 / 32768.0 / sqrt(2.0);
+    for (size_t c = 0U; c < 2U; ++c) {
+        double mean = 0.0;
+        double rms = 0.0;
+        measure(output, c, 1.0, mean, rms);
+        xap::test::assert_ok(fabs(mean) < 1e-5);
+        xap::test::assert_ok(fabs(rms - expected) < 0.005 * expected);
+    }
+
+    //
+    //  The first sample steps from the zero state.
+    //
+    xap::test::assert_ok(
+        fabs(output[0] - static_cast<float>(samples[0]) / 32768.0F) < 1e-6F
+    );
+
+    //
+    //  32-bit float in place matches the fused conversion exactly.
+    //
+    std::vector<float> converted(samples.size());
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        converted[i] = static_cast<float>(samples[i]) / 32768.0F;
+    }
+    std::vector<float> filtered(samples.size());
+    xap::audioio::AudioFormat float_format = 
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32);
+    xap::audioio::DcBlocker float_stage(
+        float_format,
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        PERIOD_FRAMES
+    );
+    run(
+        float_stage,
+        float_format,
+        converted.data(),
+        filtered.data(),
+        sizeof(float)
+    );
+    xap::test::assert_ok(filtered == output);
+}
+
+/**
+ *  Test the 16-bit fixed-point path.
+ */
+static void fixed_point() {
+    std::vector<int16_t> samples = build_signal();
+    std::vector<int16_t> output(samples.size());
+    std::vector<float> reference(samples.size());
+    xap::audioio::AudioFormat format = 
+        get_format(xap::audioio::SAMPLEFORMAT_INT16);
+    xap::audioio::DcBlocker stage(
+        format,
+        xap::audioio::SAMPLEFORMAT_INT16,
+        PERIOD_FRAMES
+    );
+    run(stage, format, samples.data(), output.data(), sizeof(int16_t));
+    xap::audioio::DcBlocker reference_stage(
+        format,
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        PERIOD_FRAMES
+    );
+    run(
+        reference_stage,
+        format,
+        samples.data(),
+        reference.data(),
+        sizeof(float)
+    );
+
+    //
+    //  The rounding leaves no offset (within a fraction of 1 LSB) and the 
+    //  output follows the floating-point filter.
+    //
+    for (size_t c = 0U; c < 2U; ++c) {
+        double mean = 0.0;
+        double rms = 0.0;
+        measure(output, c, 1.0, mean, rms);
+        xap::test::assert_ok(fabs(mean) < 0.1);
+        xap::test::assert_ok(fabs(rms - 4000.0 / sqrt(2.0)) < 4.0);
+    }
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        double value = static_cast<double>(reference[i]) * 32768.0;
+        xap::test::assert_ok(
+            fabs(static_cast<double>(output[i]) - value) <= 2.0
+        );
+    }
+
+    //
+    //  A step to full scale is saturated, a constant input decays to 0.
+    //
+    std::vector<int16_t> steps(2U * PERIOD_FRAMES * 200U, 0);
+    for (size_t i = 2U * PERIOD_FRAMES; i < steps.size(); ++i) {
+        steps[i] = (i % 2U == 0U) ? 32767 : -32768;
+    }
+    stage.reset();
+    xap::audioio::AudioBuffer period = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    for (size_t offset = 0U; offset < steps.size() / 2U;
+            offset += PERIOD_FRAMES) {
+        memcpy(
+            period.get_pointer(),
+            &steps[2U * offset],
+            PERIOD_FRAMES * 2U * sizeof(int16_t)
+        );
+        stage.process(period);
+        if (offset == PERIOD_FRAMES) {
+            xap::test::assert_equal<int16_t>(
+                period.get_samples<int16_t>()[0],
+                32767
+            );
+            xap::test::assert_equal<int16_t>(
+                period.get_samples<int16_t>()[1],
+                -32768
+            );
+        }
+    }
+    for (size_t i = 0U; i < 2U * PERIOD_FRAMES; ++i) {
+        xap::test::assert_equal<int16_t>(period.get_samples<int16_t>()[i], 0);
+    }
+}
+
+/**
+ *  Test the errors.
+ */
+static void errors() {
+    xap::audioio::AudioFormat format = 
+        get_format(xap::audioio::SAMPLEFORMAT_INT16);
+
+    //
+    //  Invalid parameters.
+    //
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::DcBlocker stage(
+            format,
+            xap::audioio::SAMPLEFORMAT_FLOAT32,
+            0U
+        );
+    });
+    const double cutoffs[] = {0.0, -1.0, 24000.0, NAN};
+    for (double cutoff : cutoffs) {
+        xap::audioio::DcBlockerOptions options;
+        options.cutoff = cutoff;
+        try {
+            xap::audioio::DcBlocker stage(
+                format,
+                xap::audioio::SAMPLEFORMAT_FLOAT32,
+                PERIOD_FRAMES,
+                options
+            );
+            xap::test::assert_ok(false);
+        } catch (xap::audioio::Exception &error) {
+            xap::test::assert_equal<uint16_t>(
+                error.get_code(),
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+    }
+
+    //
+    //  Unsupported conversions.
+    //
+    try {
+        xap::audioio::DcBlocker stage(
+            get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+            xap::audioio::SAMPLEFORMAT_INT16,
+            PERIOD_FRAMES
+        );
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::DcBlocker stage(
+            format,
+            xap::audioio::SAMPLEFORMAT_INT32,
+            PERIOD_FRAMES
+        );
+    });
+
+    //
+    //  Mismatched audio data, too many frames.
+    //
+    xap::audioio::DcBlocker stage(
+        format,
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        PERIOD_FRAMES
+    );
+    xap::audioio::AudioFormat mono_format = format;
+    mono_format.channel_count = 1U;
+    xap::audioio::AudioBuffer mono = 
+        xap::audioio::AudioBuffer::allocate(mono_format, PERIOD_FRAMES);
+    try {
+        stage.process(mono);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+    xap::audioio::AudioBuffer large = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES + 1U);
+    try {
+        stage.process(large);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Conversion...\n");
+    conversion();
+
+    //
+    //  Case 2.
+    //
+    printf("Fixed point...\n");
+    fixed_point();
+
+    //
+    //  Case 3.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
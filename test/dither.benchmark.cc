@@ -0,0 +1,78 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t PERIOD_COUNT  = 100000U;  //  1000s.
+const static size_t CHANNEL_COUNT = 2U;
+
+/**
+ *  Run the benchmark (stereo 48kHz periods).
+ * 
+ *  @param name
+ *      The name of the method.
+ *  @param noise_shaping
+ *      The noise shaping filter (ignored if plain).
+ *  @param plain
+ *      True to convert without dither (rounding only).
+ */
+static void run(
+    const char                  *name,
+    xap::audioio::NoiseShaping   noise_shaping,
+    bool                         plain
+) {
+    std::vector<float> input(PERIOD_FRAMES * CHANNEL_COUNT);
+    for (size_t i = 0U; i < input.size(); ++i) {
+        input[i] = 0.5F * static_cast<float>(sin(static_cast<double>(i)));
+    }
+    std::vector<int16_t> output(input.size());
+    xap::audioio::DitherOptions options;
+    options.noise_shaping = noise_shaping;
+    options.seed = 1U;
+    xap::audioio::Dither dither(CHANNEL_COUNT, options);
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t period = 0U; period < PERIOD_COUNT; ++period) {
+        if (plain) {
+            for (size_t i = 0U; i < input.size(); ++i) {
+                output[i] = static_cast<int16_t>(lrintf(input[i] * 32767.0F));
+            }
+        } else {
+            dither.requantize(input.data(), output.data(), PERIOD_FRAMES);
+        }
+        input[period % input.size()] += static_cast<float>(output[0]) * 1E-9F;
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 
+                   48000.0;
+    printf("%-20s | %20.1f\n", name, audio / elapsed);
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Method               | Real-time (x faster)\n");
+    run("Rounding", xap::audioio::NOISESHAPING_NONE, true);
+    run("TPDF", xap::audioio::NOISESHAPING_NONE, false);
+    run("TPDF, 1st order", xap::audioio::NOISESHAPING_FIRST_ORDER, false);
+    run("TPDF, 2nd order", xap::audioio::NOISESHAPING_SECOND_ORDER, false);
+    return 0;
+}
@@ -0,0 +1,334 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+
+//  Count of samples of the test signals.
+const static size_t SAMPLE_COUNT = 48000U;
+
+//
+//  Private classes.
+//
+
+/**
+ *  Source which plays a fixed 32-bit float signal.
+ */
+class SignalSource: public xap::audioio::ISource {
+public:
+    explicit SignalSource(const std::vector<float> &samples) :
+        m_samples(samples),
+        m_position(0U)
+    {}
+
+    virtual size_t read(xap::audioio::AudioBuffer &output) override {
+        size_t count = output.get_frame_count();
+        if (count > this->m_samples.size() - this->m_position) {
+            count = this->m_samples.size() - this->m_position;
+        }
+        for (size_t i = 0U; i < count; ++i) {
+            output.get_samples<float>()[i] = 
+                this->m_samples[this->m_position + i];
+        }
+        this->m_position += count;
+        return count;
+    }
+
+private:
+    std::vector<float>  m_samples;
+    size_t              m_position;
+};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build a test signal (a low-level sine, mono).
+ */
+static std::vector<float> build_signal() {
+    std::vector<float> samples(SAMPLE_COUNT);
+    for (size_t i = 0U; i < SAMPLE_COUNT; ++i) {
+        samples[i] = 
+            0.001F * static_cast<float>(sin(static_cast<double>(i) * 0.013));
+    }
+    return samples;
+}
+
+/**
+ *  Requantize a signal.
+ */
+static std::vector<int16_t> requantize(
+    const std::vector<float>      &samples,
+    xap::audioio::NoiseShaping     noise_shaping,
+    uint32_t                       seed
+) {
+    xap::audioio::DitherOptions options;
+    options.noise_shaping = noise_shaping;
+    options.seed = seed;
+    xap::audioio::Dither dither(1U, options);
+    std::vector<int16_t> output(samples.size());
+    dither.requantize(samples.data(), output.data(), samples.size());
+    return output;
+}
+
+/**
+ *  Get the lag-1 autocorrelation coefficient of the requantization error.
+ */
+static double get_error_correlation(
+    const std::vector<float>      &samples,
+    const std::vector<int16_t>    &output
+) {
+    double energy = 0.0;
+    double product = 0.0;
+    double previous = 0.0;
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        double error = static_cast<double>(output[i]) - 
+                       static_cast<double>(samples[i]) * 32768.0;
+        energy += error * error;
+        product += error * previous;
+        previous = error;
+    }
+    return product / energy;
+}
+
+/**
+ *  Test the noise.
+ */
+static void noise() {
+    std::vector<float> samples = build_signal();
+
+    //  Same seed, same output, otherwise different output.
+    std::vector<int16_t> first = 
+        requantize(samples, xap::audioio::NOISESHAPING_NONE, 1U);
+    std::vector<int16_t> second = 
+        requantize(samples, xap::audioio::NOISESHAPING_NONE, 1U);
+    std::vector<int16_t> third = 
+        requantize(samples, xap::audioio::NOISESHAPING_NONE, 2U);
+    xap::test::assert_ok(first == second);
+    xap::test::assert_ok(first != third);
+
+    //  A constant level below 1 LSB is preserved on average (the noise is 
+    //  within +/-1 LSB).
+    std::vector<float> constant(SAMPLE_COUNT, 0.25F / 32768.0F);
+    std::vector<int16_t> output = 
+        requantize(constant, xap::audioio::NOISESHAPING_NONE, 3U);
+    double sum = 0.0;
+    for (int16_t sample : output) {
+        xap::test::assert_ok(sample >= -1 && sample <= 1);
+        sum += static_cast<double>(sample);
+    }
+    xap::test::assert_ok(
+        fabs(sum / static_cast<double>(SAMPLE_COUNT) - 0.25) < 0.02
+    );
+
+    //  Reset restarts the noise.
+    xap::audioio::DitherOptions options;
+    options.seed = 1U;
+    xap::audioio::Dither dither(1U, options);
+    std::vector<int16_t> again(SAMPLE_COUNT);
+    dither.requantize(samples.data(), again.data(), 1000U);
+    dither.reset();
+    dither.requantize(samples.data(), again.data(), SAMPLE_COUNT);
+    xap::test::assert_ok(again == first);
+}
+
+/**
+ *  Test the noise shaping.
+ */
+static void noise_shaping() {
+    std::vector<float> samples = build_signal();
+
+    //  The error is white without noise shaping, shaped by (1 - z^-1) or 
+    //  (1 - z^-1)^2 otherwise (autocorrelations of -1/2 and -2/3).
+    double plain = get_error_correlation(
+        samples,
+        requantize(samples, xap::audioio::NOISESHAPING_NONE, 5U)
+    );
+    double first = get_error_correlation(
+        samples,
+        requantize(samples, xap::audioio::NOISESHAPING_FIRST_ORDER, 5U)
+    );
+    double second = get_error_correlation(
+        samples,
+        requantize(samples, xap::audioio::NOISESHAPING_SECOND_ORDER, 5U)
+    );
+    xap::test::assert_ok(fabs(plain) < 0.05);
+    xap::test::assert_ok(fabs(first + 0.5) < 0.05);
+    xap::test::assert_ok(fabs(second + 2.0 / 3.0) < 0.05);
+}
+
+/**
+ *  Test clipping.
+ */
+static void clipping() {
+    std::vector<float> samples(SAMPLE_COUNT);
+    for (size_t i = 0U; i < SAMPLE_COUNT; ++i) {
+        samples[i] = (i & 1U) != 0U ? 2.0F : -2.0F;
+    }
+    for (xap::audioio::NoiseShaping noise_shaping : {
+        xap::audioio::NOISESHAPING_NONE,
+        xap::audioio::NOISESHAPING_FIRST_ORDER,
+        xap::audioio::NOISESHAPING_SECOND_ORDER
+    }) {
+        std::vector<int16_t> output = requantize(samples, noise_shaping, 7U);
+        for (size_t i = 0U; i < SAMPLE_COUNT; ++i) {
+            xap::test::assert_equal<int16_t>(
+                output[i],
+                (i & 1U) != 0U ? 32767 : -32768
+            );
+        }
+    }
+}
+
+/**
+ *  Test the source.
+ */
+static void source() {
+    std::vector<float> samples = build_signal();
+    std::vector<int16_t> expected = 
+        requantize(samples, xap::audioio::NOISESHAPING_SECOND_ORDER, 9U);
+
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 48000U;
+    xap::audioio::DitherOptions options;
+    options.noise_shaping = xap::audioio::NOISESHAPING_SECOND_ORDER;
+    options.seed = 9U;
+    xap::audioio::DitherSource dither(
+        std::make_shared<SignalSource>(samples),
+        format,
+        options
+    );
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 480U);
+    std::vector<int16_t> played;
+    while (true) {
+        memset(output.get_pointer(), 0, output.get_length());
+        size_t count = dither.read(output);
+        played.insert(
+            played.end(),
+            output.get_samples<int16_t>(),
+            output.get_samples<int16_t>() + count
+        );
+        if (count < output.get_frame_count()) {
+            break;
+        }
+    }
+    xap::test::assert_ok(played == expected);
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::DitherOptions options;
+    options.noise_shaping = 3U;
+    try {
+        xap::audioio::Dither dither(1U, options);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    try {
+        xap::audioio::Dither dither(0U);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    try {
+        xap::audioio::DitherSource dither(nullptr, format);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    std::shared_ptr<xap::audioio::ISource> upstream = 
+        std::make_shared<SignalSource>(build_signal());
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    try {
+        xap::audioio::DitherSource dither(upstream, format);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    xap::audioio::DitherSource dither(upstream, format);
+    format.channel_count = 1U;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 160U);
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        dither.read(output);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Noise...\n");
+    noise();
+
+    //
+    //  Case 2.
+    //
+    printf("Noise shaping...\n");
+    noise_shaping();
+
+    //
+    //  Case 3.
+    //
+    printf("Clipping...\n");
+    clipping();
+
+    //
+    //  Case 4.
+    //
+    printf("Source...\n");
+    source();
+
+    //
+    //  Case 5.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
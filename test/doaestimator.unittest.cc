@@ -0,0 +1,373 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Sample rate.
+const static uint32_t SAMPLE_RATE = 16000U;
+
+//  Block size (10ms).
+const static size_t BLOCK_FRAMES = 160U;
+
+//  Count of microphones (circular array).
+const static uint32_t MICROPHONE_COUNT = 6U;
+
+/**
+ *  Build a circular microphone array (radius 5cm).
+ * 
+ *  @return
+ *      The array.
+ */
+static xap::audioio::MicrophoneArray build_array() {
+    xap::audioio::MicrophoneArray array;
+    array.channel_count = MICROPHONE_COUNT;
+    for (uint32_t m = 0U; m < MICROPHONE_COUNT; ++m) {
+        double angle = 2.0 * PI * static_cast<double>(m) / 
+                       static_cast<double>(MICROPHONE_COUNT);
+        array.positions[m].x = static_cast<float>(0.05 * cos(angle));
+        array.positions[m].y = static_cast<float>(0.05 * sin(angle));
+    }
+    return array;
+}
+
+/**
+ *  Build an input audio format.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat sample_format
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = static_cast<uint8_t>(MICROPHONE_COUNT);
+    format.sample_rate = SAMPLE_RATE;
+    return format;
+}
+
+/**
+ *  Source which renders a wideband plane wave (many tones with exact 
+ *  fractional delays) or independent noise on each channel.
+ */
+class Scene {
+public:
+    /**
+     *  Construct the object.
+     * 
+     *  @param array
+     *      The array.
+     *  @param azimuth
+     *      The azimuth of the source (in degrees, negative for independent 
+     *      noise).
+     *  @param amplitude
+     *      The amplitude of each tone.
+     */
+    Scene(
+        const xap::audioio::MicrophoneArray  &array,
+        double                                azimuth,
+        double                                amplitude
+    ) :
+        m_array(array),
+        m_azimuth(azimuth),
+        m_amplitude(amplitude),
+        m_position(0U),
+        m_seed(1U),
+        m_phases()
+    {
+        for (size_t t = 0U; t < 40U; ++t) {
+            this->m_phases.push_back(2.0 * PI * this->random());
+        }
+    }
+
+    /**
+     *  Render a block.
+     * 
+     *  @param data
+     *      The audio data (output).
+     */
+    void render(xap::audioio::AudioBuffer &data) {
+        size_t channel_count = data.get_channel_count();
+        size_t frame_count = data.get_frame_count();
+        bool is_float = 
+            (data.get_sample_format() == xap::audioio::SAMPLEFORMAT_FLOAT32);
+        double ux = cos(this->m_azimuth * PI / 180.0);
+        double uy = sin(this->m_azimuth * PI / 180.0);
+        for (size_t i = 0U; i < frame_count; ++i) {
+            for (size_t m = 0U; m < channel_count; ++m) {
+                double value = 0.0;
+                if (this->m_azimuth < 0.0) {
+                    value = this->m_amplitude * (this->random() - 0.5);
+                } else {
+                    double lead = 
+                        (static_cast<double>(this->m_array.positions[m].x) * 
+                            ux + 
+                         static_cast<double>(this->m_array.positions[m].y) * 
+                            uy) / 
+                        static_cast<double>(this->m_array.speed_of_sound);
+                    double t = 
+                        static_cast<double>(this->m_position + i) / 
+                        static_cast<double>(SAMPLE_RATE) + lead;
+                    for (size_t k = 0U; k < this->m_phases.size(); ++k) {
+                        double frequency = 
+                            350.0 + 90.0 * static_cast<double>(k);
+                        value += this->m_amplitude * sin(
+                            2.0 * PI * frequency * t + this->m_phases[k]
+                        );
+                    }
+                }
+                if (is_float) {
+                    data.get_samples<float>()[i * channel_count + m] = 
+                        static_cast<float>(value);
+                } else {
+                    data.get_samples<int16_t>()[i * channel_count + m] = 
+                        static_cast<int16_t>(lrint(value));
+                }
+            }
+        }
+        data.set_timestamp(static_cast<int64_t>(this->m_position));
+        this->m_position += frame_count;
+    }
+
+private:
+    double random() {
+        this->m_seed = this->m_seed * 1664525U + 1013904223U;
+        return static_cast<double>(this->m_seed >> 8) / 16777216.0;
+    }
+
+    xap::audioio::MicrophoneArray  m_array;
+    double                         m_azimuth;
+    double                         m_amplitude;
+    size_t                         m_position;
+    uint32_t                       m_seed;
+    std::vector<double>            m_phases;
+};
+
+/**
+ *  Run a scene through an estimator.
+ * 
+ *  @param estimator
+ *      The estimator.
+ *  @param format
+ *      The input audio format.
+ *  @param scene
+ *      The scene.
+ *  @param block_count
+ *      The count of blocks.
+ *  @return
+ *      The events.
+ */
+static std::vector<xap::audioio::DoaEvent> run(
+    xap::audioio::DoaEstimator       &estimator,
+    const xap::audioio::AudioFormat  &format,
+    Scene                            &scene,
+    size_t                            block_count
+) {
+    std::vector<xap::audioio::DoaEvent> events;
+    std::function<void(const xap::audioio::DoaEvent &)> callback = 
+        [&](const xap::audioio::DoaEvent &event) {
+            events.push_back(event);
+        };
+    estimator.set_event_callback(callback);
+    xap::audioio::AudioBuffer data = 
+        xap::audioio::AudioBuffer::allocate(format, BLOCK_FRAMES);
+    for (size_t b = 0U; b < block_count; ++b) {
+        scene.render(data);
+        xap::audioio::AudioBuffer input = data;
+        estimator.process(data);
+
+        //  Passed through.
+        xap::test::assert_ok(data.get_pointer() == input.get_pointer());
+    }
+    return events;
+}
+
+/**
+ *  Get the distance between 2 azimuths.
+ * 
+ *  @param a
+ *      The azimuth a.
+ *  @param b
+ *      The azimuth b.
+ *  @return
+ *      The distance (in degrees).
+ */
+static double get_distance(double a, double b) {
+    double distance = fmod(fabs(a - b), 360.0);
+    return distance > 180.0 ? 360.0 - distance : distance;
+}
+
+//
+//  Test cases.
+//
+
+void single_source() {
+    //
+    //  A wideband source is located within the resolution of the grid.
+    //
+    xap::audioio::MicrophoneArray array = build_array();
+    const double azimuths[] = {30.0, 137.0, 251.0, 344.0};
+    for (double azimuth : azimuths) {
+        for (uint32_t directions : {72U, 360U}) {
+            xap::audioio::AudioFormat format = 
+                build_format(xap::audioio::SAMPLEFORMAT_FLOAT32);
+            xap::audioio::DoaEstimatorOptions options;
+            options.direction_count = directions;
+            xap::audioio::DoaEstimator estimator(format, array, options);
+            xap::test::assert_equal<size_t>(
+                estimator.get_direction_count(),
+                directions
+            );
+            Scene scene(array, azimuth, 0.02);
+            std::vector<xap::audioio::DoaEvent> events = 
+                run(estimator, format, scene, 100U);
+
+            //  256 frames per hop, 6 hops (96ms) per estimate.
+            xap::test::assert_equal<size_t>(events.size(), 10U);
+            for (size_t i = 0U; i < events.size(); ++i) {
+                xap::test::assert_equal<int64_t>(
+                    events[i].timestamp,
+                    static_cast<int64_t>(1536U * (i + 1U))
+                );
+                xap::test::assert_ok(
+                    get_distance(events[i].azimuth, azimuth) < 2.5,
+                    "Azimuth mismatched."
+                );
+                xap::test::assert_ok(
+                    events[i].confidence > 0.5F,
+                    "Confidence too low."
+                );
+            }
+        }
+    }
+}
+
+void int16_source() {
+    xap::audioio::MicrophoneArray array = build_array();
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16);
+    xap::audioio::DoaEstimatorOptions options;
+    options.direction_count = 180U;
+    options.report_interval = 200U;
+    xap::audioio::DoaEstimator estimator(format, array, options);
+    Scene scene(array, 200.0, 500.0);
+    std::vector<xap::audioio::DoaEvent> events = 
+        run(estimator, format, scene, 100U);
+
+    //  13 hops (208ms) per estimate.
+    xap::test::assert_equal<size_t>(events.size(), 4U);
+    for (const xap::audioio::DoaEvent &event : events) {
+        xap::test::assert_ok(get_distance(event.azimuth, 200.0) < 2.5);
+    }
+}
+
+void silence_and_noise() {
+    xap::audioio::MicrophoneArray array = build_array();
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32);
+    xap::audioio::DoaEstimatorOptions options;
+    xap::audioio::DoaEstimator estimator(format, array, options);
+
+    //  Silent intervals are still reported (with no confidence).
+    Scene silence(array, 90.0, 0.0);
+    std::vector<xap::audioio::DoaEvent> events = 
+        run(estimator, format, silence, 50U);
+    xap::test::assert_equal<size_t>(events.size(), 5U);
+    for (const xap::audioio::DoaEvent &event : events) {
+        xap::test::assert_ok(event.confidence == 0.0F);
+    }
+
+    //  Independent noise has no direction.
+    estimator.reset();
+    Scene noise(array, -1.0, 0.5);
+    events = run(estimator, format, noise, 100U);
+    xap::test::assert_equal<size_t>(events.size(), 10U);
+    for (const xap::audioio::DoaEvent &event : events) {
+        xap::test::assert_ok(event.confidence < 0.3F, "Confidence too high.");
+    }
+}
+
+void invalid() {
+    xap::audioio::MicrophoneArray array = build_array();
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32);
+    xap::audioio::DoaEstimatorOptions options;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioFormat mismatched = format;
+        mismatched.channel_count = 4U;
+        xap::audioio::DoaEstimator estimator(mismatched, array, options);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::DoaEstimatorOptions invalid = options;
+        invalid.direction_count = 0U;
+        xap::audioio::DoaEstimator estimator(format, array, invalid);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::DoaEstimatorOptions invalid = options;
+        invalid.min_frequency = 9000.0F;
+        invalid.max_frequency = 10000.0F;
+        xap::audioio::DoaEstimator estimator(format, array, invalid);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::MicrophoneArray large = array;
+        large.positions[0].x = 10.0F;
+        xap::audioio::DoaEstimator estimator(format, large, options);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::DoaEstimator estimator(format, array, options);
+        xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+            build_format(xap::audioio::SAMPLEFORMAT_INT16),
+            BLOCK_FRAMES
+        );
+        estimator.process(data);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Single source...\n");
+    single_source();
+
+    //
+    //  Case 2.
+    //
+    printf("Single source, 16-bit...\n");
+    int16_source();
+
+    //
+    //  Case 3.
+    //
+    printf("Silence and diffuse noise...\n");
+    silence_and_noise();
+
+    //
+    //  Case 4.
+    //
+    printf("Invalid arguments...\n");
+    invalid();
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 160U;     //  20ms at 8kHz.
+const static size_t PERIOD_COUNT  = 500U;     //  10s.
+
+/**
+ *  Run the benchmark with 'stream_count' concurrent 8kHz streams.
+ * 
+ *  @param stream_count
+ *      The count of streams.
+ */
+static void run(size_t stream_count) {
+    xap::audioio::DtmfDetector detector(stream_count);
+    size_t event_count = 0U;
+    std::function<void(const xap::audioio::DtmfEvent &)> callback = 
+        [&](const xap::audioio::DtmfEvent &) {
+            ++event_count;
+        };
+    detector.set_event_callback(callback);
+
+    std::vector<int16_t> period(PERIOD_FRAMES * stream_count);
+    uint32_t seed = 1U;
+    for (size_t i = 0U; i < period.size(); ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        period[i] = static_cast<int16_t>(seed >> 20);
+    }
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < PERIOD_COUNT; ++i) {
+        detector.process(
+            period.data(), 
+            PERIOD_FRAMES, 
+            static_cast<int64_t>(i * PERIOD_FRAMES)
+        );
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_FRAMES * PERIOD_COUNT) / 8000.0;
+
+    printf(
+        "%7lu | %20.1f | %14.2f | %lu\n",
+        static_cast<unsigned long>(stream_count),
+        audio / elapsed,
+        elapsed / static_cast<double>(PERIOD_COUNT) * 1000000.0,
+        static_cast<unsigned long>(event_count)
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Streams | Real-time (x faster) | Period (us/op) | Events\n");
+    for (size_t streams = 1U; streams <= 4096U; streams *= 4U) {
+        run(streams);
+    }
+    run(1000U);
+
+    return 0;
+}
@@ -0,0 +1,310 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+const static char DIGITS[] = "123A456B789C*0#D";
+const static double ROWS[4] = {697.0, 770.0, 852.0, 941.0};
+const static double COLUMNS[4] = {1209.0, 1336.0, 1477.0, 1633.0};
+
+//
+//  Private functions.
+//
+
+/**
+ *  Add a DTMF digit to a stream.
+ * 
+ *  @param samples
+ *      The interleaved samples.
+ *  @param stream_count
+ *      The count of streams.
+ *  @param stream
+ *      The stream.
+ *  @param sample_rate
+ *      The sample rate.
+ *  @param digit
+ *      The index of the digit in DIGITS.
+ *  @param start
+ *      The first frame.
+ *  @param length
+ *      The count of frames.
+ *  @param row_amplitude
+ *      The amplitude of the row tone.
+ *  @param column_amplitude
+ *      The amplitude of the column tone.
+ */
+static void add_digit(
+    std::vector<int16_t> &samples,
+    size_t                stream_count,
+    size_t                stream,
+    uint32_t              sample_rate,
+    size_t                digit,
+    size_t                start,
+    size_t                length,
+    double                row_amplitude,
+    double                column_amplitude
+) {
+    double row = ROWS[digit / 4U];
+    double column = COLUMNS[digit % 4U];
+    for (size_t i = 0U; i < length; ++i) {
+        double t = static_cast<double>(i) / static_cast<double>(sample_rate);
+        double value = row_amplitude * sin(2.0 * PI * row * t) + 
+                       column_amplitude * sin(2.0 * PI * column * t);
+        samples[(start + i) * stream_count + stream] = 
+            static_cast<int16_t>(lrint(value));
+    }
+}
+
+//
+//  Test cases.
+//
+
+void many_streams() {
+    const size_t stream_count = 16U;
+    const size_t frame_count = 8000U;
+    std::vector<int16_t> samples(stream_count * frame_count, 0);
+
+    //
+    //  Stream s: digit s at 1000 + 100 * s for 60ms, then again (same digit) 
+    //  60ms later. Low-level noise everywhere.
+    //
+    uint32_t seed = 7U;
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        samples[i] = static_cast<int16_t>(static_cast<int32_t>(seed >> 24) - 128);
+    }
+    for (size_t s = 0U; s < stream_count; ++s) {
+        add_digit(samples, stream_count, s, 8000U, s, 1000U + 100U * s, 480U, 
+                  4000.0, 4000.0);
+        add_digit(samples, stream_count, s, 8000U, s, 1960U + 100U * s, 480U, 
+                  4000.0, 3000.0);
+    }
+
+    std::vector<xap::audioio::DtmfEvent> events;
+    std::function<void(const xap::audioio::DtmfEvent &)> callback = 
+        [&](const xap::audioio::DtmfEvent &event) {
+            events.push_back(event);
+        };
+
+    //
+    //  Interleaved, in periods of 160 frames.
+    //
+    xap::audioio::DtmfDetector detector(stream_count);
+    detector.set_event_callback(callback);
+    for (size_t offset = 0U; offset < frame_count; offset += 160U) {
+        detector.process(
+            samples.data() + offset * stream_count, 
+            160U, 
+            static_cast<int64_t>(offset)
+        );
+    }
+
+    xap::test::assert_equal<size_t>(events.size(), stream_count * 2U);
+    std::vector<size_t> counts(stream_count, 0U);
+    for (size_t i = 0U; i < events.size(); ++i) {
+        const xap::audioio::DtmfEvent &event = events[i];
+        size_t s = static_cast<size_t>(event.stream);
+        xap::test::assert_equal<char>(event.digit, DIGITS[s]);
+        int64_t start = static_cast<int64_t>(
+            (counts[s] == 0U ? 1000U : 1960U) + 100U * s
+        );
+        xap::test::assert_ok(
+            event.timestamp >= start - 205 && event.timestamp <= start + 205,
+            "Timestamp out of range."
+        );
+        ++counts[s];
+    }
+
+    //
+    //  Separate buffers per stream (same results).
+    //
+    std::vector<std::vector<int16_t>> separated(stream_count);
+    std::vector<const int16_t *> pointers(stream_count);
+    for (size_t s = 0U; s < stream_count; ++s) {
+        separated[s].resize(frame_count);
+        for (size_t n = 0U; n < frame_count; ++n) {
+            separated[s][n] = samples[n * stream_count + s];
+        }
+        pointers[s] = separated[s].data();
+    }
+    std::vector<xap::audioio::DtmfEvent> interleaved = events;
+    events.clear();
+    detector.reset();
+    detector.process(pointers.data(), frame_count, 0);
+    xap::test::assert_equal<size_t>(events.size(), interleaved.size());
+    for (size_t i = 0U; i < events.size(); ++i) {
+        xap::test::assert_equal<uint32_t>(
+            events[i].stream, 
+            interleaved[i].stream
+        );
+        xap::test::assert_equal<int64_t>(
+            events[i].timestamp, 
+            interleaved[i].timestamp
+        );
+    }
+}
+
+void rejections() {
+    const size_t frame_count = 4000U;
+    std::vector<xap::audioio::DtmfEvent> events;
+    std::function<void(const xap::audioio::DtmfEvent &)> callback = 
+        [&](const xap::audioio::DtmfEvent &event) {
+            events.push_back(event);
+        };
+    xap::audioio::DtmfDetector detector(4U);
+    detector.set_event_callback(callback);
+
+    std::vector<int16_t> samples(4U * frame_count, 0);
+
+    //  Stream 0: excessive twist (20dB).
+    add_digit(samples, 4U, 0U, 8000U, 5U, 0U, 2000U, 4000.0, 400.0);
+
+    //  Stream 1: a single tone.
+    add_digit(samples, 4U, 1U, 8000U, 5U, 0U, 2000U, 4000.0, 0.0);
+
+    //  Stream 2: too short (20ms).
+    add_digit(samples, 4U, 2U, 8000U, 5U, 0U, 160U, 4000.0, 4000.0);
+
+    //  Stream 3: too quiet.
+    add_digit(samples, 4U, 3U, 8000U, 5U, 0U, 2000U, 50.0, 50.0);
+
+    detector.process(samples.data(), frame_count, 0);
+    xap::test::assert_equal<size_t>(events.size(), 0U);
+}
+
+void recorder_stage() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 2U;
+    format.sample_rate = 16000U;
+
+    std::vector<xap::audioio::DtmfEvent> events;
+    std::function<void(const xap::audioio::DtmfEvent &)> callback = 
+        [&](const xap::audioio::DtmfEvent &event) {
+            events.push_back(event);
+        };
+    xap::audioio::DtmfDetector stage(2U, 16000U);
+    stage.set_event_callback(callback);
+
+    std::vector<int16_t> samples(2U * 16000U, 0);
+    add_digit(samples, 2U, 1U, 16000U, 13U, 4000U, 1600U, 5000.0, 5000.0);
+
+    for (size_t offset = 0U; offset < 16000U; offset += 320U) {
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, 320U);
+        memcpy(
+            data.get_pointer(), 
+            samples.data() + offset * 2U, 
+            data.get_length()
+        );
+        data.set_timestamp(100000 + static_cast<int64_t>(offset));
+        stage.process(data);
+    }
+    xap::test::assert_equal<size_t>(events.size(), 1U);
+    xap::test::assert_equal<char>(events[0].digit, '0');
+    xap::test::assert_equal<uint32_t>(events[0].stream, 1U);
+    xap::test::assert_ok(
+        events[0].timestamp >= 104000 - 410 && 
+            events[0].timestamp <= 104000 + 410,
+        "Timestamp out of range."
+    );
+
+    //  Format mismatch.
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        format.channel_count = 1U;
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, 320U);
+        stage.process(data);
+    });
+}
+
+void repeated_digit() {
+    const size_t stream_count = 16U;
+    const size_t frame_count = 4000U;
+    std::vector<int16_t> samples(stream_count * frame_count, 0);
+
+    //
+    //  Stream s: digit '5' at 1000 + 13 * s for 60ms, then again after the 
+    //  minimum pause (40ms). The streams cover all alignments of the pause 
+    //  to the blocks (205 frames). Low-level noise everywhere.
+    //
+    uint32_t seed = 11U;
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        samples[i] = static_cast<int16_t>(static_cast<int32_t>(seed >> 24) - 128);
+    }
+    for (size_t s = 0U; s < stream_count; ++s) {
+        add_digit(samples, stream_count, s, 8000U, 5U, 1000U + 13U * s, 480U, 
+                  4000.0, 4000.0);
+        add_digit(samples, stream_count, s, 8000U, 5U, 1800U + 13U * s, 480U, 
+                  4000.0, 4000.0);
+    }
+
+    std::vector<xap::audioio::DtmfEvent> events;
+    std::function<void(const xap::audioio::DtmfEvent &)> callback = 
+        [&](const xap::audioio::DtmfEvent &event) {
+            events.push_back(event);
+        };
+    xap::audioio::DtmfDetector detector(stream_count);
+    detector.set_event_callback(callback);
+    detector.process(samples.data(), frame_count, 0);
+
+    //
+    //  Both presses are reported on each stream.
+    //
+    std::vector<size_t> counts(stream_count, 0U);
+    for (size_t i = 0U; i < events.size(); ++i) {
+        xap::test::assert_equal<char>(events[i].digit, '5');
+        ++counts[static_cast<size_t>(events[i].stream)];
+    }
+    for (size_t s = 0U; s < stream_count; ++s) {
+        xap::test::assert_equal<size_t>(counts[s], 2U);
+    }
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Many streams...\n");
+    many_streams();
+
+    //
+    //  Case 2.
+    //
+    printf("Rejections...\n");
+    rejections();
+
+    //
+    //  Case 3.
+    //
+    printf("Recorder stage...\n");
+    recorder_stage();
+
+    //
+    //  Case 4.
+    //
+    printf("Repeated digit...\n");
+    repeated_digit();
+
+    return 0;
+}
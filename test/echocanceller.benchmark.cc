@@ -0,0 +1,82 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 160U;     //  10ms at 16kHz.
+const static size_t PERIOD_COUNT  = 1000U;    //  10s.
+
+/**
+ *  Run the benchmark (mono, 16-bit, 16kHz).
+ * 
+ *  @param filter_length
+ *      The length of the adaptive filter (in milliseconds).
+ */
+static void run(uint32_t filter_length) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 16000U;
+    xap::audioio::EchoCancellerOptions options;
+    options.filter_length = filter_length;
+    xap::audioio::EchoCanceller canceller(format, nullptr, options);
+
+    std::vector<int16_t> near_end(PERIOD_FRAMES);
+    std::vector<int16_t> far_end(PERIOD_FRAMES);
+    uint32_t seed = 1U;
+    for (size_t i = 0U; i < PERIOD_FRAMES; ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        far_end[i] = static_cast<int16_t>(seed >> 20);
+        seed = seed * 1664525U + 1013904223U;
+        near_end[i] = static_cast<int16_t>(seed >> 21);
+    }
+    std::vector<int16_t> output(PERIOD_FRAMES);
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < PERIOD_COUNT; ++i) {
+        canceller.process(
+            near_end.data(),
+            far_end.data(),
+            output.data(),
+            PERIOD_FRAMES
+        );
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_FRAMES * PERIOD_COUNT) / 16000.0;
+
+    printf(
+        "%8ums | %20.1f | %14.2f\n",
+        filter_length,
+        audio / elapsed,
+        elapsed / static_cast<double>(PERIOD_COUNT) * 1000000.0
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    //  Real-time factor is the count of calls one core can serve.
+    printf("    Filter | Real-time (x faster) | Period (us/op)\n");
+    run(64U);
+    run(128U);
+    run(250U);
+    run(500U);
+
+    return 0;
+}
@@ -0,0 +1,545 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Sample rate.
+const static uint32_t SAMPLE_RATE = 16000U;
+
+//  Period size (10ms, not a multiple of the block size).
+const static size_t PERIOD_FRAMES = 160U;
+
+//  Count of periods per second.
+const static size_t PERIODS_PER_SECOND = 100U;
+
+/**
+ *  Build an audio format (mono).
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat sample_format
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = 1U;
+    format.sample_rate = SAMPLE_RATE;
+    return format;
+}
+
+/**
+ *  Synthetic room: the far-end signal (noise), its echo through a decaying 
+ *  random impulse response and an optional near-end talker (tones).
+ */
+class Room {
+public:
+    /**
+     *  Construct the object.
+     * 
+     *  @param seed
+     *      The seed of the impulse response.
+     */
+    explicit Room(uint32_t seed) :
+        m_response(),
+        m_history(),
+        m_position(0U),
+        m_seed(1U)
+    {
+        this->set_response(seed);
+    }
+
+    /**
+     *  Change the echo path.
+     * 
+     *  @param seed
+     *      The seed of the impulse response.
+     */
+    void set_response(uint32_t seed) {
+        //  80ms long, 5ms direct path delay.
+        uint32_t saved = this->m_seed;
+        this->m_seed = seed;
+        this->m_response.assign(1280U, 0.0);
+        for (size_t n = 80U; n < this->m_response.size(); ++n) {
+            double decay = exp(-static_cast<double>(n - 80U) / 240.0);
+            this->m_response[n] = 0.2 * (this->random() - 0.5) * decay;
+        }
+        this->m_seed = saved;
+        if (this->m_history.size() != this->m_response.size()) {
+            this->m_history.assign(this->m_response.size(), 0.0);
+        }
+    }
+
+    /**
+     *  Render a period.
+     * 
+     *  @param far_end
+     *      The far-end samples (output).
+     *  @param near_end
+     *      The near-end samples (echo and talker, output).
+     *  @param talker
+     *      The talker samples alone (output).
+     *  @param frame_count
+     *      The count of frames.
+     *  @param far_amplitude
+     *      The amplitude of the far-end noise.
+     *  @param talker_amplitude
+     *      The amplitude of the talker.
+     */
+    void render(
+        float   *far_end,
+        float   *near_end,
+        float   *talker,
+        size_t   frame_count,
+        double   far_amplitude,
+        double   talker_amplitude
+    ) {
+        size_t length = this->m_response.size();
+        for (size_t i = 0U; i < frame_count; ++i) {
+            double x = far_amplitude * (this->random() - 0.5);
+            this->m_history[this->m_position % length] = x;
+            double echo = 0.0;
+            for (size_t n = 0U; n < length; ++n) {
+                echo += this->m_response[n] * 
+                        this->m_history[(this->m_position + length - n) %
+                                        length];
+            }
+            double t = static_cast<double>(this->m_position) / 
+                       static_cast<double>(SAMPLE_RATE);
+            double voice = talker_amplitude * (
+                sin(2.0 * PI * 310.0 * t) + 
+                0.7 * sin(2.0 * PI * 1230.0 * t) + 
+                0.5 * sin(2.0 * PI * 2170.0 * t)
+            );
+            far_end[i] = static_cast<float>(x);
+            near_end[i] = static_cast<float>(echo + voice);
+            talker[i] = static_cast<float>(voice);
+            ++(this->m_position);
+        }
+    }
+
+private:
+    double random() {
+        this->m_seed = this->m_seed * 1664525U + 1013904223U;
+        return static_cast<double>(this->m_seed >> 8) / 16777216.0;
+    }
+
+    std::vector<double>  m_response;
+    std::vector<double>  m_history;
+    size_t               m_position;
+    uint32_t             m_seed;
+};
+
+/**
+ *  Powers of a run.
+ */
+typedef struct RunResult_ {
+    double  near_power;
+    double  output_power;
+    double  talker_error_power;
+    double  talker_power;
+    size_t  double_talk_periods;
+} RunResult;
+
+/**
+ *  Run periods through a canceller (32-bit float, frame-based API).
+ * 
+ *  @param canceller
+ *      The canceller.
+ *  @param room
+ *      The room.
+ *  @param period_count
+ *      The count of periods.
+ *  @param talker_amplitude
+ *      The amplitude of the near-end talker.
+ *  @return
+ *      The powers (of the last half of the periods).
+ */
+static RunResult run(
+    xap::audioio::EchoCanceller  &canceller,
+    Room                         &room,
+    size_t                        period_count,
+    double                        talker_amplitude
+) {
+    RunResult result = {0.0, 0.0, 0.0, 0.0, 0U};
+    size_t latency = canceller.get_latency();
+    std::vector<float> far_end(PERIOD_FRAMES);
+    std::vector<float> near_end(PERIOD_FRAMES);
+    std::vector<float> talker(PERIOD_FRAMES);
+    std::vector<float> output(PERIOD_FRAMES);
+    std::vector<float> delayed(latency + PERIOD_FRAMES, 0.0F);
+    for (size_t p = 0U; p < period_count; ++p) {
+        room.render(
+            far_end.data(),
+            near_end.data(),
+            talker.data(),
+            PERIOD_FRAMES,
+            0.5,
+            talker_amplitude
+        );
+        canceller.process(
+            near_end.data(),
+            far_end.data(),
+            output.data(),
+            PERIOD_FRAMES
+        );
+        if (canceller.is_double_talk()) {
+            ++(result.double_talk_periods);
+        }
+
+        //  The talker delayed by the latency of the canceller.
+        delayed.erase(delayed.begin(), delayed.begin() + PERIOD_FRAMES);
+        delayed.insert(delayed.end(), talker.begin(), talker.end());
+        if (2U * p < period_count) {
+            continue;
+        }
+        for (size_t i = 0U; i < PERIOD_FRAMES; ++i) {
+            double d = static_cast<double>(near_end[i]);
+            double o = static_cast<double>(output[i]);
+            double v = static_cast<double>(delayed[i]);
+            result.near_power += d * d;
+            result.output_power += o * o;
+            result.talker_error_power += (o - v) * (o - v);
+            result.talker_power += v * v;
+        }
+    }
+    return result;
+}
+
+/**
+ *  Get a power ratio.
+ * 
+ *  @param a
+ *      The power a.
+ *  @param b
+ *      The power b.
+ *  @return
+ *      The ratio (in dB).
+ */
+static double get_ratio(double a, double b) {
+    return 10.0 * log10(a / b);
+}
+
+/**
+ *  Far-end source which replays a buffer and counts the frames read.
+ */
+class Replay: public xap::audioio::ISource {
+public:
+    Replay() :
+        m_data(),
+        m_read(0U)
+    {}
+
+    virtual size_t read(xap::audioio::AudioBuffer &output) override {
+        size_t count = output.get_frame_count();
+        if (count > this->m_data.size()) {
+            count = this->m_data.size();
+        }
+        for (size_t i = 0U; i < count; ++i) {
+            output.get_samples<int16_t>()[i] = this->m_data[i];
+        }
+        this->m_data.erase(this->m_data.begin(), this->m_data.begin() + count);
+        this->m_read += count;
+        return count;
+    }
+
+    std::vector<int16_t>  m_data;
+    size_t                m_read;
+};
+
+//
+//  Test cases.
+//
+
+void transparency() {
+    //
+    //  Without far-end signal, the output is the near-end signal delayed 
+    //  by the latency of the canceller.
+    //
+    xap::audioio::EchoCanceller canceller(
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        nullptr
+    );
+    size_t latency = canceller.get_latency();
+    xap::test::assert_equal<size_t>(latency, 256U);
+    std::vector<float> near_end(4000U);
+    std::vector<float> far_end(near_end.size(), 0.0F);
+    for (size_t i = 0U; i < near_end.size(); ++i) {
+        near_end[i] = static_cast<float>(
+            0.3 * sin(2.0 * PI * 440.0 * static_cast<double>(i) / 16000.0)
+        );
+    }
+
+    //  In place, with odd sizes.
+    std::vector<float> output = near_end;
+    for (size_t offset = 0U, count = 1U; offset < output.size(); ) {
+        if (count > output.size() - offset) {
+            count = output.size() - offset;
+        }
+        canceller.process(
+            output.data() + offset,
+            far_end.data() + offset,
+            output.data() + offset,
+            count
+        );
+        offset += count;
+        count = (count * 7U + 3U) % 301U;
+    }
+    for (size_t i = 0U; i < output.size(); ++i) {
+        float expected = i < latency ? 0.0F : near_end[i - latency];
+        xap::test::assert_ok(
+            fabsf(output[i] - expected) < 1e-5F,
+            "Output mismatched."
+        );
+    }
+    xap::test::assert_ok(!canceller.is_double_talk());
+    xap::test::assert_ok(canceller.get_erle() == 0.0F);
+}
+
+void convergence() {
+    //
+    //  The echo is cancelled by more than 20dB within 2 seconds, residual 
+    //  echo suppression removes much more.
+    //
+    for (float suppression : {0.0F, 40.0F}) {
+        xap::audioio::EchoCancellerOptions options;
+        options.suppression = suppression;
+        xap::audioio::EchoCanceller canceller(
+            build_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+            nullptr,
+            options
+        );
+        Room room(7U);
+        RunResult result = run(canceller, room, 4U * PERIODS_PER_SECOND, 0.0);
+        double attenuation = get_ratio(result.near_power, result.output_power);
+        xap::test::assert_ok(canceller.get_erle() > 20.0F, "ERLE too low.");
+        xap::test::assert_ok(
+            attenuation > (suppression > 0.0F ? 35.0 : 20.0),
+            "Attenuation too low."
+        );
+        xap::test::assert_equal<size_t>(result.double_talk_periods, 0U);
+    }
+}
+
+void double_talk() {
+    //
+    //  The near-end talker is detected and preserved, the filter does not 
+    //  diverge.
+    //
+    xap::audioio::EchoCanceller canceller(
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        nullptr
+    );
+    Room room(7U);
+    run(canceller, room, 3U * PERIODS_PER_SECOND, 0.0);
+    RunResult result = run(canceller, room, 2U * PERIODS_PER_SECOND, 0.1);
+    double distortion = 
+        get_ratio(result.talker_power, result.talker_error_power);
+    xap::test::assert_ok(
+        result.double_talk_periods > PERIODS_PER_SECOND,
+        "Double-talk not detected."
+    );
+    xap::test::assert_ok(distortion > 20.0, "Talker distorted.");
+
+    //  The echo is still cancelled after the double-talk.
+    result = run(canceller, room, 50U, 0.0);
+    xap::test::assert_ok(
+        get_ratio(result.near_power, result.output_power) > 30.0,
+        "Filter diverged."
+    );
+}
+
+void echo_path_change() {
+    xap::audioio::EchoCanceller canceller(
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        nullptr
+    );
+    Room room(7U);
+    run(canceller, room, 3U * PERIODS_PER_SECOND, 0.0);
+    room.set_response(1234U);
+    RunResult result = run(canceller, room, 4U * PERIODS_PER_SECOND, 0.0);
+    double attenuation = get_ratio(result.near_power, result.output_power);
+    xap::test::assert_ok(attenuation > 30.0, "Not recovered.");
+
+    //  Reset.
+    canceller.reset();
+    xap::test::assert_ok(canceller.get_erle() == 0.0F);
+}
+
+void stage() {
+    //
+    //  16-bit recorder stage, the far-end signal comes from a source.
+    //
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16);
+    std::shared_ptr<Replay> far_end = std::make_shared<Replay>();
+    xap::audioio::EchoCancellerOptions options;
+    options.max_frames = 100U;
+    xap::audioio::EchoCanceller canceller(format, far_end, options);
+    Room room(3U);
+    std::vector<float> far_samples(PERIOD_FRAMES);
+    std::vector<float> near_samples(PERIOD_FRAMES);
+    std::vector<float> talker(PERIOD_FRAMES);
+    xap::audioio::AudioBuffer data = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    double near_power = 0.0;
+    double output_power = 0.0;
+    for (size_t p = 0U; p < 4U * PERIODS_PER_SECOND; ++p) {
+        room.render(
+            far_samples.data(),
+            near_samples.data(),
+            talker.data(),
+            PERIOD_FRAMES,
+            0.5,
+            0.0
+        );
+        for (size_t i = 0U; i < PERIOD_FRAMES; ++i) {
+            far_end->m_data.push_back(
+                static_cast<int16_t>(lrintf(far_samples[i] * 32767.0F))
+            );
+            data.get_samples<int16_t>()[i] = 
+                static_cast<int16_t>(lrintf(near_samples[i] * 32767.0F));
+        }
+        for (size_t i = 0U; i < PERIOD_FRAMES && 2U * p >= 400U; ++i) {
+            double d = static_cast<double>(data.get_samples<int16_t>()[i]);
+            near_power += d * d;
+        }
+        xap::audioio::AudioBuffer input = data;
+        canceller.process(data);
+
+        //  In place.
+        xap::test::assert_ok(data.get_pointer() == input.get_pointer());
+        for (size_t i = 0U; i < PERIOD_FRAMES && 2U * p >= 400U; ++i) {
+            double o = static_cast<double>(data.get_samples<int16_t>()[i]);
+            output_power += o * o;
+        }
+    }
+    xap::test::assert_equal<size_t>(
+        far_end->m_read,
+        4U * PERIODS_PER_SECOND * PERIOD_FRAMES
+    );
+    double attenuation = get_ratio(near_power, output_power);
+    xap::test::assert_ok(attenuation > 30.0, "Attenuation too low.");
+
+    //  Missing far-end frames are silent.
+    size_t read = far_end->m_read;
+    canceller.process(data);
+    xap::test::assert_equal<size_t>(far_end->m_read, read);
+}
+
+void invalid() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32);
+    xap::audioio::EchoCancellerOptions options;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioFormat stereo = format;
+        stereo.channel_count = 2U;
+        xap::audioio::EchoCanceller canceller(stereo, nullptr, options);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::EchoCanceller canceller(
+            build_format(xap::audioio::SAMPLEFORMAT_INT32),
+            nullptr,
+            options
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::EchoCancellerOptions invalid = options;
+        invalid.block_frames = 100U;
+        xap::audioio::EchoCanceller canceller(format, nullptr, invalid);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::EchoCancellerOptions invalid = options;
+        invalid.filter_length = 0U;
+        xap::audioio::EchoCanceller canceller(format, nullptr, invalid);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::EchoCancellerOptions invalid = options;
+        invalid.double_talk_threshold = 0.5F;
+        xap::audioio::EchoCanceller canceller(format, nullptr, invalid);
+    });
+
+    //  No far-end source.
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::EchoCanceller canceller(format, nullptr, options);
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+        canceller.process(data);
+    });
+
+    //  Mismatched audio data.
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::EchoCanceller canceller(
+            format,
+            std::make_shared<Replay>(),
+            options
+        );
+        xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+            build_format(xap::audioio::SAMPLEFORMAT_INT16),
+            PERIOD_FRAMES
+        );
+        canceller.process(data);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Transparency...\n");
+    transparency();
+
+    //
+    //  Case 2.
+    //
+    printf("Convergence...\n");
+    convergence();
+
+    //
+    //  Case 3.
+    //
+    printf("Double-talk...\n");
+    double_talk();
+
+    //
+    //  Case 4.
+    //
+    printf("Echo path change...\n");
+    echo_path_change();
+
+    //
+    //  Case 5.
+    //
+    printf("Recorder stage, 16-bit...\n");
+    stage();
+
+    //
+    //  Case 6.
+    //
+    printf("Invalid arguments...\n");
+    invalid();
+
+    return 0;
+}
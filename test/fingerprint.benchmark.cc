@@ -0,0 +1,241 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+const static uint32_t SAMPLE_RATE = 8000U;
+const static size_t TRACK_FRAMES = 80000U;     //  10s.
+const static uint32_t TRACK_COUNT = 100U;
+const static size_t PERIOD_FRAMES = 160U;      //  20ms at 8kHz.
+const static size_t PERIOD_COUNT = 500U;       //  10s.
+const static size_t CHANNEL_COUNT = 64U;       //  Streams of each recorder.
+
+/**
+ *  Build a track (chords of 3 random tones, changing every 100ms).
+ */
+static std::vector<float> build_track(uint32_t seed) {
+    std::vector<float> track(TRACK_FRAMES);
+    double frequencies[3] = {0.0, 0.0, 0.0};
+    double phases[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0U; i < TRACK_FRAMES; ++i) {
+        if (i % 800U == 0U) {
+            for (size_t k = 0U; k < 3U; ++k) {
+                seed = seed * 1664525U + 1013904223U;
+                frequencies[k] = 300.0 + 3200.0 * 
+                                 static_cast<double>(seed >> 8U) / 16777216.0;
+            }
+        }
+        double sample = 0.0;
+        for (size_t k = 0U; k < 3U; ++k) {
+            phases[k] += 2.0 * PI * frequencies[k] / 
+                         static_cast<double>(SAMPLE_RATE);
+            sample += 0.2 * sin(phases[k]);
+        }
+        track[i] = static_cast<float>(sample);
+    }
+    return track;
+}
+
+/**
+ *  Build the index (TRACK_COUNT tracks).
+ */
+static std::shared_ptr<xap::audioio::FingerprintIndex> build_index() {
+    std::shared_ptr<xap::audioio::FingerprintIndex> index = 
+        std::make_shared<xap::audioio::FingerprintIndex>();
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 1U;
+    format.sample_rate = SAMPLE_RATE;
+    for (uint32_t track = 1U; track <= TRACK_COUNT; ++track) {
+        xap::audioio::FingerprintExtractor extractor(1U, SAMPLE_RATE);
+        std::vector<xap::audioio::Fingerprint> fingerprints;
+        std::function<
+            void(uint32_t, const xap::audioio::Fingerprint *, size_t)
+        > callback = [&](
+            uint32_t                            stream,
+            const xap::audioio::Fingerprint    *extracted,
+            size_t                              count
+        ) {
+            (void)stream;
+            fingerprints.insert(
+                fingerprints.end(),
+                extracted,
+                extracted + count
+            );
+        };
+        extractor.set_fingerprint_callback(callback);
+        std::vector<float> samples = build_track(track);
+        xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::wrap(
+            samples.data(),
+            samples.size(),
+            format
+        );
+        extractor.process(data);
+        index->add(track, fingerprints.data(), fingerprints.size());
+    }
+    return index;
+}
+
+/**
+ *  Run the benchmark (16-bit streams captured by recorders of 
+ *  CHANNEL_COUNT channels, every 4th stream plays an indexed track).
+ * 
+ *  @param index
+ *      The index.
+ *  @param stream_count
+ *      The count of streams.
+ *  @param matches
+ *      The count of matches (output).
+ *  @return
+ *      The real-time factor.
+ */
+static double run(
+    const std::shared_ptr<const xap::audioio::FingerprintIndex>  &index,
+    size_t                                                        stream_count,
+    size_t                                                       &matches
+) {
+    size_t channel_count = std::min(stream_count, CHANNEL_COUNT);
+    std::vector<std::unique_ptr<xap::audioio::FingerprintExtractor>>
+        extractors;
+    matches = 0U;
+    std::function<void(const xap::audioio::FingerprintMatch &)> callback = 
+        [&](const xap::audioio::FingerprintMatch &match) {
+            (void)match;
+            ++matches;
+        };
+    for (size_t s = 0U; s < stream_count; s += channel_count) {
+        extractors.emplace_back(new xap::audioio::FingerprintExtractor(
+            channel_count,
+            SAMPLE_RATE,
+            xap::audioio::FingerprintOptions(),
+            index
+        ));
+        extractors.back()->set_match_callback(callback);
+    }
+
+    std::vector<std::vector<float>> sources;
+    for (size_t s = 0U; s < 8U; ++s) {
+        sources.push_back(build_track(
+            static_cast<uint32_t>(s % 2U == 0U ? s + 1U : 1000U + s)
+        ));
+    }
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = static_cast<uint8_t>(channel_count);
+    format.sample_rate = SAMPLE_RATE;
+    std::vector<xap::audioio::AudioBuffer> periods;
+    for (size_t k = 0U; k < PERIOD_COUNT; ++k) {
+        xap::audioio::AudioBuffer period = 
+            xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+        int16_t *samples = period.get_samples<int16_t>();
+        for (size_t n = 0U; n < PERIOD_FRAMES; ++n) {
+            for (size_t s = 0U; s < channel_count; ++s) {
+                const std::vector<float> &source = 
+                    sources[(s / 2U) % sources.size()];
+                samples[n * channel_count + s] = static_cast<int16_t>(
+                    source[(k * PERIOD_FRAMES + n) % source.size()] * 32767.0F
+                );
+            }
+        }
+        period.set_timestamp(static_cast<int64_t>(k * PERIOD_FRAMES));
+        periods.push_back(period);
+    }
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t k = 0U; k < PERIOD_COUNT; ++k) {
+        for (size_t e = 0U; e < extractors.size(); ++e) {
+            extractors[e]->process(periods[k]);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    return static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 
+           static_cast<double>(SAMPLE_RATE) / 
+           elapsed;
+}
+
+/**
+ *  Measure concurrent lookups.
+ * 
+ *  @param index
+ *      The index.
+ *  @param thread_count
+ *      The count of threads.
+ *  @return
+ *      The count of lookups per second (of all threads).
+ */
+static double lookup(
+    const std::shared_ptr<const xap::audioio::FingerprintIndex>  &index,
+    size_t                                                        thread_count
+) {
+    const size_t count = 2000000U;
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t t = 0U; t < thread_count; ++t) {
+        threads.push_back(std::thread([&index, t]() {
+            xap::audioio::FingerprintPosting postings[32];
+            uint32_t seed = static_cast<uint32_t>(t + 1U);
+            size_t found = 0U;
+            for (size_t i = 0U; i < count; ++i) {
+                seed = seed * 1664525U + 1013904223U;
+                found += index->find(seed & 0x03FFFFFFU, postings, 32U);
+            }
+            if (found == SIZE_MAX) {
+                printf("Unreachable.\n");
+            }
+        }));
+    }
+    for (size_t t = 0U; t < thread_count; ++t) {
+        threads[t].join();
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    return static_cast<double>(count * thread_count) / elapsed;
+}
+
+//
+//  Main.
+//
+int main() {
+    std::shared_ptr<const xap::audioio::FingerprintIndex> index = 
+        build_index();
+    printf("Index: %zu fingerprints\n\n", index->get_size());
+
+    printf("Streams | Matches | x real-time\n");
+    for (size_t stream_count = 16U; stream_count <= 512U; stream_count *= 2U) {
+        size_t matches = 0U;
+        double factor = run(index, stream_count, matches);
+        printf("%7zu | %7zu | %11.1f\n", stream_count, matches, factor);
+    }
+
+    printf("\nThreads | Lookups (M/s)\n");
+    for (size_t thread_count = 1U; thread_count <= 4U; thread_count *= 2U) {
+        printf(
+            "%7zu | %13.1f\n",
+            thread_count,
+            lookup(index, thread_count) / 1e6
+        );
+    }
+    return 0;
+}
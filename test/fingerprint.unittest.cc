@@ -0,0 +1,450 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Sample rate.
+const static uint32_t SAMPLE_RATE = 8000U;
+
+//  Count of frames of each track (8s).
+const static size_t TRACK_FRAMES = 64000U;
+
+//  Count of frames of each period.
+const static size_t PERIOD_FRAMES = 160U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Generate a pseudo-random number (0 - 1).
+ */
+static double next_random(uint32_t &seed) {
+    seed = seed * 1664525U + 1013904223U;
+    return static_cast<double>(seed >> 8U) / 16777216.0;
+}
+
+/**
+ *  Build a track (chords of 3 random tones, changing every 100ms).
+ * 
+ *  @param seed
+ *      The seed.
+ *  @return
+ *      The audio data.
+ */
+static std::vector<float> build_track(uint32_t seed) {
+    std::vector<float> track(TRACK_FRAMES);
+    double frequencies[3] = {0.0, 0.0, 0.0};
+    double phases[3] = {0.0, 0.0, 0.0};
+    for (size_t i = 0U; i < TRACK_FRAMES; ++i) {
+        if (i % 800U == 0U) {
+            for (size_t k = 0U; k < 3U; ++k) {
+                frequencies[k] = 300.0 + 3200.0 * next_random(seed);
+            }
+        }
+        double sample = 0.0;
+        for (size_t k = 0U; k < 3U; ++k) {
+            phases[k] += 2.0 * PI * frequencies[k] / 
+                         static_cast<double>(SAMPLE_RATE);
+            sample += 0.2 * sin(phases[k]);
+        }
+        track[i] = static_cast<float>(sample);
+    }
+    return track;
+}
+
+/**
+ *  Get the format of a count of streams.
+ */
+static xap::audioio::AudioFormat get_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint8_t                     stream_count
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = stream_count;
+    format.sample_rate = SAMPLE_RATE;
+    return format;
+}
+
+/**
+ *  Extract the fingerprints of mono audio data.
+ * 
+ *  @param data
+ *      The audio data.
+ *  @param period_frames
+ *      The count of frames of each period.
+ *  @return
+ *      The fingerprints.
+ */
+static std::vector<xap::audioio::Fingerprint> extract(
+    const std::vector<float>  &data,
+    size_t                     period_frames
+) {
+    xap::audioio::FingerprintExtractor extractor(1U, SAMPLE_RATE);
+    std::vector<xap::audioio::Fingerprint> fingerprints;
+    std::function<
+        void(uint32_t, const xap::audioio::Fingerprint *, size_t)
+    > callback = [&](
+        uint32_t                            stream,
+        const xap::audioio::Fingerprint    *extracted,
+        size_t                              count
+    ) {
+        xap::test::assert_equal<uint32_t>(stream, 0U);
+        fingerprints.insert(fingerprints.end(), extracted, extracted + count);
+    };
+    extractor.set_fingerprint_callback(callback);
+    xap::audioio::AudioBuffer period = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 1U),
+        period_frames
+    );
+    for (size_t i = 0U; i + period_frames <= data.size(); i += period_frames) {
+        std::copy(
+            data.begin() + static_cast<ptrdiff_t>(i),
+            data.begin() + static_cast<ptrdiff_t>(i + period_frames),
+            period.get_samples<float>()
+        );
+        extractor.process(period);
+    }
+    return fingerprints;
+}
+
+/**
+ *  Build an index of tracks (tracks 1 - 'track_count').
+ */
+static std::shared_ptr<xap::audioio::FingerprintIndex> build_index(
+    uint32_t track_count
+) {
+    std::shared_ptr<xap::audioio::FingerprintIndex> index = 
+        std::make_shared<xap::audioio::FingerprintIndex>();
+    for (uint32_t track = 1U; track <= track_count; ++track) {
+        std::vector<xap::audioio::Fingerprint> fingerprints = 
+            extract(build_track(track), 1000U);
+        index->add(track, fingerprints.data(), fingerprints.size());
+    }
+    return index;
+}
+
+/**
+ *  Capture 2 streams with an extractor matching against an index.
+ * 
+ *  @param index
+ *      The index.
+ *  @param stream0
+ *      The audio data of stream 0.
+ *  @param stream1
+ *      The audio data of stream 1.
+ *  @param timestamp
+ *      The timestamp of the first frame.
+ *  @return
+ *      The matches.
+ */
+static std::vector<xap::audioio::FingerprintMatch> capture(
+    const std::shared_ptr<const xap::audioio::FingerprintIndex>  &index,
+    const std::vector<float>                                     &stream0,
+    const std::vector<float>                                     &stream1,
+    int64_t                                                       timestamp
+) {
+    xap::audioio::FingerprintExtractor extractor(
+        2U,
+        SAMPLE_RATE,
+        xap::audioio::FingerprintOptions(),
+        index
+    );
+    std::vector<xap::audioio::FingerprintMatch> matches;
+    std::function<void(const xap::audioio::FingerprintMatch &)> callback = 
+        [&](const xap::audioio::FingerprintMatch &match) {
+            matches.push_back(match);
+        };
+    extractor.set_match_callback(callback);
+
+    //  16-bit, as captured by a recorder.
+    xap::audioio::AudioBuffer period = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16, 2U),
+        PERIOD_FRAMES
+    );
+    size_t frame_count = std::min(stream0.size(), stream1.size());
+    for (size_t i = 0U; i + PERIOD_FRAMES <= frame_count; i += PERIOD_FRAMES) {
+        int16_t *samples = period.get_samples<int16_t>();
+        for (size_t n = 0U; n < PERIOD_FRAMES; ++n) {
+            samples[2U * n] = static_cast<int16_t>(stream0[i + n] * 32767.0F);
+            samples[2U * n + 1U] = 
+                static_cast<int16_t>(stream1[i + n] * 32767.0F);
+        }
+        period.set_timestamp(timestamp + static_cast<int64_t>(i));
+        extractor.process(period);
+
+        //  The audio data passes through unchanged.
+        xap::test::assert_equal<int16_t>(
+            samples[0],
+            static_cast<int16_t>(stream0[i] * 32767.0F)
+        );
+    }
+    return matches;
+}
+
+/**
+ *  Test extraction.
+ */
+static void extraction() {
+    std::vector<float> track = build_track(1U);
+    std::vector<xap::audioio::Fingerprint> fingerprints1 = extract(track, 160U);
+    std::vector<xap::audioio::Fingerprint> fingerprints2 = 
+        extract(track, 1000U);
+
+    //  Incremental: independent of the period size.
+    xap::test::assert_ok(fingerprints1.size() > 500U);
+    xap::test::assert_equal<size_t>(fingerprints1.size(), fingerprints2.size());
+    for (size_t i = 0U; i < fingerprints1.size(); ++i) {
+        xap::test::assert_equal<uint32_t>(
+            fingerprints1[i].hash,
+            fingerprints2[i].hash
+        );
+        xap::test::assert_equal<uint32_t>(
+            fingerprints1[i].time,
+            fingerprints2[i].time
+        );
+    }
+
+    //  Silence has no peaks.
+    std::vector<float> silence(TRACK_FRAMES, 0.0F);
+    xap::test::assert_equal<size_t>(extract(silence, 160U).size(), 0U);
+}
+
+/**
+ *  Test the index.
+ */
+static void indexing() {
+    xap::audioio::FingerprintIndexOptions options;
+    options.shard_count = 4U;
+    options.capacity = 4000U;
+    xap::audioio::FingerprintIndex index(options);
+    xap::test::assert_equal<size_t>(index.get_capacity(), 4000U);
+
+    std::vector<xap::audioio::Fingerprint> fingerprints(1000U);
+    for (size_t i = 0U; i < fingerprints.size(); ++i) {
+        fingerprints[i].hash = static_cast<uint32_t>(i % 500U);
+        fingerprints[i].time = static_cast<uint32_t>(i);
+    }
+    index.add(7U, fingerprints.data(), fingerprints.size());
+    xap::test::assert_equal<size_t>(index.get_size(), 1000U);
+    xap::audioio::FingerprintPosting postings[4];
+    xap::test::assert_equal<size_t>(index.find(42U, postings, 4U), 2U);
+    xap::test::assert_equal<uint32_t>(postings[0].track, 7U);
+    xap::test::assert_equal<uint32_t>(postings[0].time, 542U);
+    xap::test::assert_equal<uint32_t>(postings[1].time, 42U);
+    xap::test::assert_equal<size_t>(index.find(42U, postings, 1U), 1U);
+    xap::test::assert_equal<size_t>(index.find(500U, postings, 4U), 0U);
+
+    //  Lock-free lookups while fingerprints are added.
+    std::atomic<bool> is_done(false);
+    std::atomic<size_t> errors(0U);
+    std::vector<std::thread> readers;
+    for (size_t r = 0U; r < 4U; ++r) {
+        readers.push_back(std::thread([&]() {
+            xap::audioio::FingerprintPosting found[8];
+            while (!is_done.load()) {
+                for (uint32_t hash = 0U; hash < 500U; ++hash) {
+                    size_t count = index.find(hash, found, 8U);
+                    for (size_t k = 0U; k < count; ++k) {
+                        if (found[k].time % 500U != hash || 
+                            (found[k].track != 7U && found[k].track != 8U)) {
+                            errors.fetch_add(1U);
+                        }
+                    }
+                }
+            }
+        }));
+    }
+    for (size_t k = 0U; k < 2U; ++k) {
+        index.add(8U, fingerprints.data(), fingerprints.size());
+    }
+    is_done.store(true);
+    for (size_t r = 0U; r < readers.size(); ++r) {
+        readers[r].join();
+    }
+    xap::test::assert_equal<size_t>(errors.load(), 0U);
+    xap::test::assert_equal<size_t>(index.get_size(), 3000U);
+    xap::test::assert_equal<size_t>(index.find(42U, postings, 4U), 4U);
+
+    //  Full.
+    try {
+        index.add(9U, fingerprints.data(), fingerprints.size());
+        index.add(9U, fingerprints.data(), fingerprints.size());
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    xap::test::assert_ok(index.get_size() <= index.get_capacity());
+}
+
+/**
+ *  Test matching captured streams.
+ */
+static void matching() {
+    std::shared_ptr<const xap::audioio::FingerprintIndex> index = 
+        build_index(5U);
+
+    //  Stream 0: 0.4s of quiet noise, then track 3 from 1.6s on. Stream 1:
+    //  a track that is not indexed.
+    uint32_t seed = 12345U;
+    std::vector<float> stream0;
+    for (size_t i = 0U; i < 3200U; ++i) {
+        stream0.push_back(static_cast<float>(0.01 * next_random(seed)));
+    }
+    std::vector<float> track = build_track(3U);
+    stream0.insert(stream0.end(), track.begin() + 12800, track.end());
+    std::vector<float> stream1 = build_track(99U);
+    std::vector<xap::audioio::FingerprintMatch> matches = 
+        capture(index, stream0, stream1, 1000);
+
+    //  Track 3 started (before the capture) at 1000 + 3200 - 12800.
+    bool is_found = false;
+    for (size_t i = 0U; i < matches.size(); ++i) {
+        xap::test::assert_equal<uint32_t>(matches[i].stream, 0U);
+        xap::test::assert_equal<uint32_t>(matches[i].track, 3U);
+        if (matches[i].timestamp == -8600) {
+            is_found = true;
+        }
+    }
+    xap::test::assert_ok(is_found);
+}
+
+/**
+ *  Test matching captured streams (not aligned to the hops, with noise).
+ */
+static void unaligned() {
+    std::shared_ptr<const xap::audioio::FingerprintIndex> index = 
+        build_index(3U);
+
+    uint32_t seed = 54321U;
+    std::vector<float> track = build_track(2U);
+    std::vector<float> stream0(track.begin() + 8037, track.end());
+    for (size_t i = 0U; i < stream0.size(); ++i) {
+        stream0[i] += static_cast<float>(0.02 * (next_random(seed) - 0.5));
+    }
+    std::vector<float> stream1(stream0.size(), 0.0F);
+    std::vector<xap::audioio::FingerprintMatch> matches = 
+        capture(index, stream0, stream1, 0);
+
+    xap::test::assert_ok(!matches.empty());
+    for (size_t i = 0U; i < matches.size(); ++i) {
+        xap::test::assert_equal<uint32_t>(matches[i].stream, 0U);
+        xap::test::assert_equal<uint32_t>(matches[i].track, 2U);
+        xap::test::assert_ok(llabs(matches[i].timestamp + 8037) <= 128);
+    }
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::FingerprintIndexOptions index_options;
+    index_options.shard_count = 0U;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::FingerprintIndex index(index_options);
+    });
+
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::FingerprintExtractor extractor(0U, SAMPLE_RATE);
+    });
+    xap::audioio::FingerprintOptions options;
+    options.fft_size = 500U;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::FingerprintExtractor extractor(1U, SAMPLE_RATE, options);
+    });
+    options = xap::audioio::FingerprintOptions();
+    options.max_delta = 64U;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::FingerprintExtractor extractor(1U, SAMPLE_RATE, options);
+    });
+    options = xap::audioio::FingerprintOptions();
+    options.fft_size = 64U;
+    options.hop_frames = 32U;
+    try {
+        //  No band above the lowest frequency.
+        xap::audioio::FingerprintExtractor extractor(1U, 500U, options);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::FingerprintExtractor extractor(2U, SAMPLE_RATE);
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16, 1U),
+        PERIOD_FRAMES
+    );
+    try {
+        extractor.process(data);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Extraction...\n");
+    extraction();
+
+    //
+    //  Case 2.
+    //
+    printf("Indexing...\n");
+    indexing();
+
+    //
+    //  Case 3.
+    //
+    printf("Matching...\n");
+    matching();
+
+    //
+    //  Case 4.
+    //
+    printf("Unaligned...\n");
+    unaligned();
+
+    //
+    //  Case 5.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
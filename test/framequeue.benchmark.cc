@@ -0,0 +1,117 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t CHUNK_FRAMES      = 160U;     //  20ms at 8kHz.
+const static size_t CHUNKS_PER_THREAD = 20000U;
+const static size_t PERIOD_FRAMES     = 256U;
+
+/**
+ *  Run the benchmark with 'producer_count' producers.
+ * 
+ *  @param producer_count
+ *      The count of producers.
+ */
+static void run(size_t producer_count) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 8000U;
+    xap::audioio::FrameQueue queue(format, CHUNK_FRAMES, 256U);
+
+    std::atomic<bool> started(false);
+    std::atomic<size_t> accepted(0U);
+    std::atomic<size_t> rejected(0U);
+    std::atomic<size_t> finished(0U);
+
+    //
+    //  Producers (pushes which timed out are counted, only the frames 
+    //  accepted are counted in the throughput).
+    //
+    std::vector<std::thread> producers;
+    for (size_t p = 0U; p < producer_count; ++p) {
+        producers.push_back(std::thread([&]() {
+            std::vector<int16_t> chunk(CHUNK_FRAMES, 1);
+            while (!started.load()) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0U; i < CHUNKS_PER_THREAD; ++i) {
+                if (queue.push(chunk.data(), CHUNK_FRAMES, 60000U)) {
+                    accepted.fetch_add(CHUNK_FRAMES);
+                } else {
+                    rejected.fetch_add(1U);
+                }
+            }
+            finished.fetch_add(1U);
+        }));
+    }
+
+    //
+    //  Consumer (the audio thread, reading as fast as possible).
+    //
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    size_t consumed = 0U;
+    size_t reads = 0U;
+    double read_time = 0.0;
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    started.store(true);
+    while (finished.load() < producer_count || consumed < accepted.load()) {
+        std::chrono::steady_clock::time_point t0 = 
+            std::chrono::steady_clock::now();
+        size_t count = queue.read(output);
+        std::chrono::steady_clock::time_point t1 = 
+            std::chrono::steady_clock::now();
+        read_time += std::chrono::duration<double>(t1 - t0).count();
+        ++reads;
+        consumed += count;
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+
+    for (size_t p = 0U; p < producer_count; ++p) {
+        producers[p].join();
+    }
+
+    printf(
+        "%9lu | %14.2f | %12.1f | %15lu | %lu\n",
+        static_cast<unsigned long>(producer_count),
+        static_cast<double>(consumed) / elapsed / 1000000.0,
+        read_time / static_cast<double>(reads) * 1000000000.0,
+        static_cast<unsigned long>(rejected.load()),
+        static_cast<unsigned long>(queue.get_rejected_count())
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    printf(
+        "Producers | Mframes/second | Read (ns/op) | Rejected pushes | "
+        "Full (try_push)\n"
+    );
+    for (size_t producers = 1U; producers <= 16U; producers *= 2U) {
+        run(producers);
+    }
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PRODUCER_COUNT   = 4U;
+const static size_t MESSAGE_COUNT    = 2000U;
+const static size_t MESSAGE_FRAMES   = 37U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build an audio format.
+ * 
+ *  @param channel_count
+ *      The count of channels.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(uint8_t channel_count) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = channel_count;
+    format.sample_rate = 8000U;
+    return format;
+}
+
+void single_producer() {
+    xap::audioio::AudioFormat format = build_format(1U);
+    xap::audioio::FrameQueue queue(format, 128U, 4U);
+    xap::test::assert_equal<size_t>(queue.get_capacity(), 512U);
+
+    std::vector<int16_t> input(300U);
+    for (size_t i = 0U; i < input.size(); ++i) {
+        input[i] = static_cast<int16_t>(i);
+    }
+    xap::test::assert_ok(
+        queue.try_push(input.data(), input.size()), 
+        "Push to an empty queue was rejected."
+    );
+
+    //  Back-pressure.
+    xap::test::assert_ok(
+        !queue.try_push(input.data(), input.size()), 
+        "Push to a full queue was accepted."
+    );
+    xap::test::assert_equal<uint64_t>(queue.get_rejected_count(), 1U);
+    xap::test::assert_throw<xap::audioio::Exception>(
+        [&]() { queue.try_push(input.data(), 513U); },
+        "Pushed more frames than the capacity."
+    );
+
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 256U);
+    xap::test::assert_equal<size_t>(queue.read(output), 256U);
+    for (size_t i = 0U; i < 256U; ++i) {
+        xap::test::assert_equal<int16_t>(
+            output.get_samples<int16_t>()[i], 
+            static_cast<int16_t>(i)
+        );
+    }
+    xap::test::assert_equal<size_t>(queue.read(output), 44U);
+    xap::test::assert_equal<int16_t>(output.get_samples<int16_t>()[0], 256);
+    xap::test::assert_equal<size_t>(queue.read(output), 0U);
+
+    //  Mismatched format.
+    xap::audioio::AudioBuffer stereo = 
+        xap::audioio::AudioBuffer::allocate(build_format(2U), 16U);
+    xap::test::assert_throw<xap::audioio::Exception>(
+        [&]() { queue.read(stereo); },
+        "Read with mismatched format."
+    );
+}
+
+void multiple_producers() {
+    xap::audioio::AudioFormat format = build_format(2U);
+    xap::audioio::FrameQueue queue(format, 16U, 64U);
+
+    //
+    //  Each producer pushes messages whose frames are (producer, sequence).
+    //
+    std::vector<std::thread> producers;
+    for (size_t p = 0U; p < PRODUCER_COUNT; ++p) {
+        producers.push_back(std::thread([&queue, p]() {
+            int16_t message[MESSAGE_FRAMES * 2U];
+            for (size_t m = 0U; m < MESSAGE_COUNT; ++m) {
+                for (size_t i = 0U; i < MESSAGE_FRAMES; ++i) {
+                    message[i * 2U] = static_cast<int16_t>(p);
+                    message[i * 2U + 1U] = static_cast<int16_t>(m);
+                }
+                xap::test::assert_ok(
+                    queue.push(message, MESSAGE_FRAMES, 10000U),
+                    "Push timed out."
+                );
+            }
+        }));
+    }
+
+    //
+    //  Consume and check the order and the contiguity of each message.
+    //
+    std::vector<int32_t> next_message(PRODUCER_COUNT, 0);
+    size_t remaining = PRODUCER_COUNT * MESSAGE_COUNT * MESSAGE_FRAMES;
+    size_t run_frames = 0U;
+    int16_t run_producer = -1;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 64U);
+    while (remaining > 0U) {
+        size_t count = queue.read(output);
+        const int16_t *samples = output.get_samples<int16_t>();
+        for (size_t i = 0U; i < count; ++i) {
+            int16_t producer = samples[i * 2U];
+            int16_t sequence = samples[i * 2U + 1U];
+            if (run_frames == 0U) {
+                xap::test::assert_equal<int32_t>(
+                    sequence, 
+                    next_message[static_cast<size_t>(producer)], 
+                    "Messages of a producer were reordered."
+                );
+                run_producer = producer;
+            } else {
+                xap::test::assert_equal<int16_t>(
+                    producer, 
+                    run_producer, 
+                    "Frames of a message were interleaved."
+                );
+            }
+            if (++run_frames == MESSAGE_FRAMES) {
+                ++(next_message[static_cast<size_t>(producer)]);
+                run_frames = 0U;
+            }
+        }
+        remaining -= count;
+        if (count == 0U) {
+            std::this_thread::yield();
+        }
+    }
+
+    for (size_t p = 0U; p < PRODUCER_COUNT; ++p) {
+        producers[p].join();
+    }
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Single producer...\n");
+    single_producer();
+
+    //
+    //  Case 2.
+    //
+    printf("Multiple producers...\n");
+    multiple_producers();
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t SAMPLE_COUNT = 1U << 20U;
+const static size_t ROUND_COUNT  = 64U;
+const static size_t PERIOD       = 960U;   //  20ms at 48kHz.
+
+/**
+ *  Measure the throughput of a batch operation.
+ * 
+ *  @param name
+ *      The name.
+ *  @param callback
+ *      The operation (processes SAMPLE_COUNT samples).
+ */
+static void measure(const char *name, std::function<void(void)> callback) {
+    callback();  //  Warm up.
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < ROUND_COUNT; ++i) {
+        callback();
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    printf(
+        "%-30s | %16.1f\n", 
+        name, 
+        static_cast<double>(SAMPLE_COUNT * ROUND_COUNT) / elapsed / 1000000.0
+    );
+}
+
+/**
+ *  Measure the encoder stage (input samples per second).
+ * 
+ *  @param name
+ *      The name.
+ *  @param sample_rate
+ *      The input sample rate.
+ *  @param input
+ *      The input samples.
+ */
+static void measure_encoder(
+    const char                 *name, 
+    uint32_t                    sample_rate, 
+    const std::vector<int16_t> &input
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    xap::audioio::G711Encoder encoder(
+        xap::audioio::SAMPLEFORMAT_ULAW, 
+        format, 
+        PERIOD
+    );
+    xap::audioio::AudioBuffer period = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD);
+
+    measure(name, [&]() {
+        for (size_t offset = 0U; 
+             offset + PERIOD <= SAMPLE_COUNT; 
+             offset += PERIOD) {
+            xap::audioio::AudioBuffer data = period;
+            memcpy(
+                data.get_pointer(), 
+                input.data() + offset, 
+                PERIOD * sizeof(int16_t)
+            );
+            encoder.process(data);
+        }
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    std::vector<int16_t> linear(SAMPLE_COUNT);
+    std::vector<uint8_t> encoded(SAMPLE_COUNT);
+    uint32_t seed = 1U;
+    for (size_t i = 0U; i < SAMPLE_COUNT; ++i) {
+        seed = seed * 1664525U + 1013904223U;
+        linear[i] = static_cast<int16_t>(seed >> 16);
+    }
+
+    printf("Operation                      | Msamples/second\n");
+    measure("u-law encode (table)", [&]() {
+        xap::audioio::g711_ulaw_encode_table(
+            linear.data(), 
+            encoded.data(), 
+            SAMPLE_COUNT
+        );
+    });
+    measure("u-law encode (fastest)", [&]() {
+        xap::audioio::g711_ulaw_encode(
+            linear.data(), 
+            encoded.data(), 
+            SAMPLE_COUNT
+        );
+    });
+    measure("u-law decode", [&]() {
+        xap::audioio::g711_ulaw_decode(
+            encoded.data(), 
+            linear.data(), 
+            SAMPLE_COUNT
+        );
+    });
+    measure("A-law encode (table)", [&]() {
+        xap::audioio::g711_alaw_encode_table(
+            linear.data(), 
+            encoded.data(), 
+            SAMPLE_COUNT
+        );
+    });
+    measure("A-law encode (fastest)", [&]() {
+        xap::audioio::g711_alaw_encode(
+            linear.data(), 
+            encoded.data(), 
+            SAMPLE_COUNT
+        );
+    });
+    measure("A-law decode", [&]() {
+        xap::audioio::g711_alaw_decode(
+            encoded.data(), 
+            linear.data(), 
+            SAMPLE_COUNT
+        );
+    });
+    measure_encoder("Encoder stage (8kHz)", 8000U, linear);
+    measure_encoder("Encoder stage (16kHz -> 8kHz)", 16000U, linear);
+    measure_encoder("Encoder stage (48kHz -> 8kHz)", 48000U, linear);
+
+    return 0;
+}
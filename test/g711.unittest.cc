@@ -0,0 +1,497 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Encode one sample to u-law (the scalar reference, as in the ITU-T G.191 
+ *  software tools).
+ * 
+ *  @param sample
+ *      The linear sample.
+ *  @return
+ *      The u-law sample.
+ */
+static uint8_t reference_ulaw(int16_t sample) {
+    static const int16_t seg_end[8] = {
+        0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF
+    };
+    int value = sample >> 2;
+    int mask;
+    if (value < 0) {
+        value = -value;
+        mask = 0x7F;
+    } else {
+        mask = 0xFF;
+    }
+    if (value > 8159) {
+        value = 8159;
+    }
+    value += 0x21;
+    int seg = 0;
+    while (seg < 8 && value > seg_end[seg]) {
+        ++seg;
+    }
+    if (seg >= 8) {
+        return static_cast<uint8_t>(0x7F ^ mask);
+    }
+    return static_cast<uint8_t>(((seg << 4) | ((value >> (seg + 1)) & 0xF)) ^ mask);
+}
+
+/**
+ *  Encode one sample to A-law (the scalar reference).
+ * 
+ *  @param sample
+ *      The linear sample.
+ *  @return
+ *      The A-law sample.
+ */
+static uint8_t reference_alaw(int16_t sample) {
+    static const int16_t seg_end[8] = {
+        0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF
+    };
+    int value = sample >> 3;
+    int mask;
+    if (value >= 0) {
+        mask = 0xD5;
+    } else {
+        mask = 0x55;
+        value = -value - 1;
+    }
+    int seg = 0;
+    while (seg < 8 && value > seg_end[seg]) {
+        ++seg;
+    }
+    if (seg >= 8) {
+        return static_cast<uint8_t>(0x7F ^ mask);
+    }
+    int code = seg << 4;
+    code |= seg < 2 ? (value >> 1) & 0xF : (value >> seg) & 0xF;
+    return static_cast<uint8_t>(code ^ mask);
+}
+
+/**
+ *  Build all 65536 linear samples.
+ * 
+ *  @return
+ *      The samples.
+ */
+static std::vector<int16_t> build_all_samples() {
+    std::vector<int16_t> samples(65536U);
+    for (size_t i = 0U; i < 65536U; ++i) {
+        samples[i] = static_cast<int16_t>(static_cast<int32_t>(i) - 32768);
+    }
+    return samples;
+}
+
+/**
+ *  Build a sine.
+ * 
+ *  @param frequency
+ *      The frequency (in Hz).
+ *  @param sample_rate
+ *      The sample rate.
+ *  @param amplitude
+ *      The amplitude.
+ *  @param count
+ *      The count of samples.
+ *  @return
+ *      The samples.
+ */
+static std::vector<int16_t> build_sine(
+    double   frequency, 
+    uint32_t sample_rate, 
+    double   amplitude, 
+    size_t   count
+) {
+    std::vector<int16_t> samples(count);
+    for (size_t i = 0U; i < count; ++i) {
+        samples[i] = static_cast<int16_t>(lrint(amplitude * sin(
+            2.0 * PI * frequency * static_cast<double>(i) / 
+            static_cast<double>(sample_rate)
+        )));
+    }
+    return samples;
+}
+
+/**
+ *  Get the RMS of samples (skipping the filter transient).
+ * 
+ *  @param samples
+ *      The samples.
+ *  @param skip
+ *      The count of samples to skip.
+ *  @return
+ *      The RMS.
+ */
+static double get_rms(const std::vector<int16_t> &samples, size_t skip) {
+    double sum = 0.0;
+    for (size_t i = skip; i < samples.size(); ++i) {
+        sum += static_cast<double>(samples[i]) * samples[i];
+    }
+    return sqrt(sum / static_cast<double>(samples.size() - skip));
+}
+
+/**
+ *  Build a 16-bit mono audio format.
+ * 
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(uint32_t sample_rate) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Run a tone through the encoder stage and decode the result.
+ * 
+ *  @param law
+ *      The law.
+ *  @param sample_rate
+ *      The input sample rate.
+ *  @param frequency
+ *      The frequency of the tone.
+ *  @return
+ *      The decoded 8kHz samples.
+ */
+static std::vector<int16_t> run_encoder(
+    xap::audioio::SampleFormat law, 
+    uint32_t                   sample_rate, 
+    double                     frequency
+) {
+    const size_t period = 441U;
+    const size_t period_count = 100U;
+    xap::audioio::AudioFormat format = build_format(sample_rate);
+    xap::audioio::G711Encoder encoder(law, format, period);
+    std::vector<int16_t> input = 
+        build_sine(frequency, sample_rate, 10000.0, period * period_count);
+
+    std::vector<int16_t> decoded;
+    int64_t expected_timestamp = 0;
+    for (size_t i = 0U; i < period_count; ++i) {
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, period);
+        memcpy(
+            data.get_pointer(), 
+            input.data() + i * period, 
+            period * sizeof(int16_t)
+        );
+        data.set_timestamp(static_cast<int64_t>(i * period));
+        encoder.process(data);
+
+        xap::test::assert_equal<xap::audioio::SampleFormat>(
+            data.get_sample_format(), 
+            law
+        );
+        xap::test::assert_equal<uint32_t>(data.get_sample_rate(), 8000U);
+        xap::test::assert_equal<int64_t>(
+            data.get_timestamp(), 
+            expected_timestamp, 
+            "Output timestamps are not contiguous."
+        );
+        expected_timestamp += static_cast<int64_t>(data.get_frame_count());
+
+        std::vector<int16_t> linear(data.get_frame_count());
+        if (law == xap::audioio::SAMPLEFORMAT_ULAW) {
+            xap::audioio::g711_ulaw_decode(
+                data.get_samples<uint8_t>(), 
+                linear.data(), 
+                linear.size()
+            );
+        } else {
+            xap::audioio::g711_alaw_decode(
+                data.get_samples<uint8_t>(), 
+                linear.data(), 
+                linear.size()
+            );
+        }
+        decoded.insert(decoded.end(), linear.begin(), linear.end());
+    }
+    xap::test::assert_equal<size_t>(
+        decoded.size(), 
+        period * period_count / (sample_rate / 8000U)
+    );
+    return decoded;
+}
+
+//
+//  Test cases.
+//
+
+void ulaw_exhaustive() {
+    std::vector<int16_t> samples = build_all_samples();
+    std::vector<uint8_t> fast(samples.size());
+    std::vector<uint8_t> table(samples.size());
+    xap::audioio::g711_ulaw_encode(samples.data(), fast.data(), samples.size());
+    xap::audioio::g711_ulaw_encode_table(
+        samples.data(), 
+        table.data(), 
+        samples.size()
+    );
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        uint8_t expected = reference_ulaw(samples[i]);
+        xap::test::assert_equal<uint8_t>(fast[i], expected, "Vector path.");
+        xap::test::assert_equal<uint8_t>(table[i], expected, "Table path.");
+    }
+
+    //  Unaligned, with a tail.
+    xap::audioio::g711_ulaw_encode(
+        samples.data() + 3U, 
+        fast.data() + 1U, 
+        1000U
+    );
+    for (size_t i = 0U; i < 1000U; ++i) {
+        xap::test::assert_equal<uint8_t>(
+            fast[i + 1U], 
+            reference_ulaw(samples[i + 3U])
+        );
+    }
+
+    //  Decode: round trip of all codes (0x7F is negative zero).
+    uint8_t codes[256];
+    int16_t linear[256];
+    uint8_t encoded[256];
+    for (size_t i = 0U; i < 256U; ++i) {
+        codes[i] = static_cast<uint8_t>(i);
+    }
+    xap::audioio::g711_ulaw_decode(codes, linear, 256U);
+    xap::audioio::g711_ulaw_encode(linear, encoded, 256U);
+    xap::test::assert_equal<int16_t>(linear[0xFF], 0);
+    xap::test::assert_equal<int16_t>(linear[0x80], 32124);
+    xap::test::assert_equal<int16_t>(linear[0x00], -32124);
+    for (size_t i = 0U; i < 256U; ++i) {
+        if (i != 0x7FU) {
+            xap::test::assert_equal<uint8_t>(encoded[i], codes[i]);
+        }
+    }
+}
+
+void alaw_exhaustive() {
+    std::vector<int16_t> samples = build_all_samples();
+    std::vector<uint8_t> fast(samples.size());
+    std::vector<uint8_t> table(samples.size());
+    xap::audioio::g711_alaw_encode(samples.data(), fast.data(), samples.size());
+    xap::audioio::g711_alaw_encode_table(
+        samples.data(), 
+        table.data(), 
+        samples.size()
+    );
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        uint8_t expected = reference_alaw(samples[i]);
+        xap::test::assert_equal<uint8_t>(fast[i], expected, "Vector path.");
+        xap::test::assert_equal<uint8_t>(table[i], expected, "Table path.");
+    }
+
+    //  Decode: round trip of all codes.
+    uint8_t codes[256];
+    int16_t linear[256];
+    uint8_t encoded[256];
+    for (size_t i = 0U; i < 256U; ++i) {
+        codes[i] = static_cast<uint8_t>(i);
+    }
+    xap::audioio::g711_alaw_decode(codes, linear, 256U);
+    xap::audioio::g711_alaw_encode(linear, encoded, 256U);
+    xap::test::assert_equal<int16_t>(linear[0xD5], 8);
+    xap::test::assert_equal<int16_t>(linear[0xAA], 32256);
+    for (size_t i = 0U; i < 256U; ++i) {
+        xap::test::assert_equal<uint8_t>(encoded[i], codes[i]);
+    }
+}
+
+void encoder_stage() {
+    //
+    //  Pass band (1kHz) is kept at all supported rates.
+    //
+    const uint32_t rates[3] = {8000U, 16000U, 48000U};
+    for (size_t i = 0U; i < 3U; ++i) {
+        std::vector<int16_t> decoded = 
+            run_encoder(xap::audioio::SAMPLEFORMAT_ULAW, rates[i], 1000.0);
+        double rms = get_rms(decoded, 200U);
+        xap::test::assert_ok(
+            fabs(rms - 10000.0 / sqrt(2.0)) < 0.05 * 10000.0 / sqrt(2.0),
+            "Pass band level mismatched."
+        );
+    }
+    std::vector<int16_t> decoded = 
+        run_encoder(xap::audioio::SAMPLEFORMAT_ALAW, 16000U, 1000.0);
+    xap::test::assert_ok(
+        fabs(get_rms(decoded, 200U) - 10000.0 / sqrt(2.0)) < 
+            0.05 * 10000.0 / sqrt(2.0),
+        "Pass band level mismatched."
+    );
+
+    //
+    //  Stop band (would alias into the pass band) is removed.
+    //
+    decoded = run_encoder(xap::audioio::SAMPLEFORMAT_ULAW, 16000U, 5000.0);
+    xap::test::assert_ok(
+        get_rms(decoded, 200U) < 0.02 * 10000.0 / sqrt(2.0),
+        "Aliasing was not suppressed."
+    );
+    decoded = run_encoder(xap::audioio::SAMPLEFORMAT_ULAW, 48000U, 6000.0);
+    xap::test::assert_ok(
+        get_rms(decoded, 200U) < 0.02 * 10000.0 / sqrt(2.0),
+        "Aliasing was not suppressed."
+    );
+
+    //
+    //  Errors.
+    //
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::G711Encoder encoder(
+            xap::audioio::SAMPLEFORMAT_ULAW, 
+            build_format(44100U), 
+            256U
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::G711Encoder encoder(
+            xap::audioio::SAMPLEFORMAT_INT16, 
+            build_format(16000U), 
+            256U
+        );
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::G711Encoder encoder(
+            xap::audioio::SAMPLEFORMAT_ULAW, 
+            build_format(16000U), 
+            256U
+        );
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(build_format(16000U), 512U);
+        encoder.process(data);
+    });
+}
+
+void decoder_source() {
+    const size_t input_frames = 8000U;
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_ULAW;
+    format.channel_count = 1U;
+    format.sample_rate = 8000U;
+    std::shared_ptr<xap::audioio::FrameQueue> queue = 
+        std::make_shared<xap::audioio::FrameQueue>(format, 160U, 64U);
+
+    //
+    //  Queue 1s of u-law audio data (1kHz).
+    //
+    std::vector<int16_t> linear = 
+        build_sine(1000.0, 8000U, 10000.0, input_frames);
+    std::vector<uint8_t> encoded(input_frames);
+    xap::audioio::g711_ulaw_encode(linear.data(), encoded.data(), input_frames);
+
+    xap::audioio::G711Decoder decoder(
+        queue, 
+        xap::audioio::SAMPLEFORMAT_ULAW, 
+        build_format(48000U)
+    );
+
+    //
+    //  Read 48kHz periods (not a multiple of the ratio) while pushing.
+    //
+    const size_t period = 1001U;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(build_format(48000U), period);
+    std::vector<int16_t> decoded;
+    size_t pushed = 0U;
+    while (true) {
+        while (pushed < input_frames && 
+               queue->try_push(encoded.data() + pushed, 160U)) {
+            pushed += 160U;
+        }
+        memset(output.get_pointer(), 0, output.get_length());
+        size_t count = decoder.read(output);
+        decoded.insert(
+            decoded.end(), 
+            output.get_samples<int16_t>(), 
+            output.get_samples<int16_t>() + count
+        );
+        if (count < period) {
+            break;
+        }
+    }
+    xap::test::assert_equal<size_t>(decoded.size(), input_frames * 6U);
+    double rms = get_rms(decoded, 1000U);
+    xap::test::assert_ok(
+        fabs(rms - 10000.0 / sqrt(2.0)) < 0.05 * 10000.0 / sqrt(2.0),
+        "Pass band level mismatched."
+    );
+
+    //  Drained.
+    xap::test::assert_equal<size_t>(decoder.read(output), 0U);
+
+    //
+    //  Errors.
+    //
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioBuffer wrong = 
+            xap::audioio::AudioBuffer::allocate(build_format(16000U), 100U);
+        decoder.read(wrong);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::G711Decoder invalid(
+            nullptr, 
+            xap::audioio::SAMPLEFORMAT_ULAW, 
+            build_format(48000U)
+        );
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("u-law (all inputs)...\n");
+    ulaw_exhaustive();
+
+    //
+    //  Case 2.
+    //
+    printf("A-law (all inputs)...\n");
+    alaw_exhaustive();
+
+    //
+    //  Case 3.
+    //
+    printf("Encoder stage...\n");
+    encoder_stage();
+
+    //
+    //  Case 4.
+    //
+    printf("Decoder source...\n");
+    decoder_source();
+
+    return 0;
+}
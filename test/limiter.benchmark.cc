@@ -0,0 +1,81 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t PERIOD_COUNT  = 20000U;   //  200s.
+
+/**
+ *  Run the benchmark (stereo 16-bit periods, as played).
+ * 
+ *  @param mode
+ *      The limiter mode.
+ *  @param level
+ *      The level of the signal (full scale is 1).
+ *  @return
+ *      The real-time factor.
+ */
+static double run(xap::audioio::LimiterMode mode, double level) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    std::vector<int16_t> signal(2U * PERIOD_FRAMES * 100U);
+    for (size_t i = 0U; i < signal.size(); ++i) {
+        double value = level * 32767.0 * sin(static_cast<double>(i) * 0.01);
+        signal[i] = static_cast<int16_t>(
+            value > 32767.0 ? 32767.0 : (value < -32768.0 ? -32768.0 : value)
+        );
+    }
+    xap::audioio::LimiterOptions options;
+    options.mode = mode;
+    xap::audioio::Limiter limiter(format, options);
+    std::vector<int16_t> period(2U * PERIOD_FRAMES);
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t k = 0U; k < PERIOD_COUNT; ++k) {
+        const int16_t *source = signal.data() + (k % 100U) * period.size();
+        std::copy(source, source + period.size(), period.begin());
+        limiter.limit(period.data(), PERIOD_FRAMES);
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    return static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 48000.0 / 
+           elapsed;
+}
+
+//
+//  Main.
+//
+int main() {
+    const char *names[] = {"None", "Soft clip", "Peak", "True peak"};
+    printf("Mode       | Quiet (x real-time) | Loud (x real-time)\n");
+    for (xap::audioio::LimiterMode mode = xap::audioio::LIMITERMODE_NONE;
+         mode <= xap::audioio::LIMITERMODE_TRUE_PEAK;
+         ++mode) {
+        printf(
+            "%-10s | %19.1f | %18.1f\n",
+            names[mode],
+            run(mode, 0.5),
+            run(mode, 1.5)
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,405 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+
+//  Count of frames of the test signals.
+const static size_t FRAME_COUNT = 48000U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the format of the test signals (stereo 48kHz).
+ */
+static xap::audioio::AudioFormat get_format(
+    xap::audioio::SampleFormat sample_format
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    return format;
+}
+
+/**
+ *  Build a test signal (a sine of half scale with loud bursts).
+ */
+static std::vector<float> build_signal() {
+    std::vector<float> samples(2U * FRAME_COUNT);
+    for (size_t i = 0U; i < FRAME_COUNT; ++i) {
+        double level = (i >= 10000U && i < 12000U) ? 1.5 : 0.5;
+        if (i >= 15000U && i < 15003U) {
+            level = 3.0;
+        }
+        float value = static_cast<float>(
+            level * sin(static_cast<double>(i) * 0.05)
+        );
+        samples[2U * i] = value;
+        samples[2U * i + 1U] = -0.5F * value;
+    }
+    return samples;
+}
+
+/**
+ *  Get the linear threshold.
+ */
+static float get_threshold(float threshold) {
+    return static_cast<float>(pow(10.0, static_cast<double>(threshold) / 20.0));
+}
+
+/**
+ *  Test clip counting without limiting.
+ */
+static void none() {
+    std::vector<float> samples = build_signal();
+    std::vector<float> output = samples;
+    xap::audioio::Limiter limiter(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32)
+    );
+    limiter.limit(output.data(), FRAME_COUNT);
+    xap::test::assert_ok(output == samples);
+    xap::test::assert_equal<size_t>(limiter.get_latency(), 0U);
+    uint64_t expected = 0U;
+    for (float sample : samples) {
+        if (fabsf(sample) >= 32767.0F / 32768.0F) {
+            ++expected;
+        }
+    }
+    xap::test::assert_ok(expected != 0U);
+    xap::test::assert_equal<uint64_t>(limiter.get_clip_count(), expected);
+
+    //  16-bit (both extremes reach full scale).
+    std::vector<int16_t> data = {0, 32767, -32768, -32767, 100, 32766, 0, 1};
+    xap::audioio::Limiter limiter16(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16)
+    );
+    for (size_t i = 0U; i < 20U; ++i) {
+        data.insert(data.end(), {32767, 0});
+    }
+    std::vector<int16_t> copy = data;
+    limiter16.limit(copy.data(), copy.size() / 2U);
+    xap::test::assert_ok(copy == data);
+    xap::test::assert_equal<uint64_t>(limiter16.get_clip_count(), 23U);
+}
+
+/**
+ *  Test soft clipping.
+ */
+static void soft_clip() {
+    xap::audioio::LimiterOptions options;
+    options.mode = xap::audioio::LIMITERMODE_SOFT_CLIP;
+    options.threshold = -6.0F;
+    float threshold = get_threshold(options.threshold);
+    xap::audioio::Limiter limiter(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        options
+    );
+    std::vector<float> ramp;
+    for (size_t i = 0U; i <= 4000U; ++i) {
+        float value = static_cast<float>(i) * 0.001F;
+        ramp.insert(ramp.end(), {value, -value});
+    }
+    std::vector<float> output = ramp;
+    limiter.limit(output.data(), ramp.size() / 2U);
+
+    //  Unchanged below the threshold, monotonic and below full scale above.
+    for (size_t i = 0U; i < ramp.size(); i += 2U) {
+        xap::test::assert_ok(output[i] == -output[i + 1U]);
+        if (ramp[i] <= threshold) {
+            xap::test::assert_ok(output[i] == ramp[i]);
+        } else {
+            xap::test::assert_ok(output[i] < 1.0F && output[i] <= ramp[i]);
+            xap::test::assert_ok(output[i] >= output[i - 2U]);
+        }
+    }
+    xap::test::assert_ok(output[2U * 4000U] > 0.9F);
+
+    //  16-bit.
+    xap::audioio::Limiter limiter16(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16),
+        options
+    );
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16),
+        1000U
+    );
+    int16_t *samples = data.get_samples<int16_t>();
+    for (size_t i = 0U; i < 2000U; ++i) {
+        samples[i] = (i % 4U == 0U) ? 32767 : 1000;
+    }
+    limiter16.process(data);
+    for (size_t i = 0U; i < 2000U; ++i) {
+        if (i % 4U == 0U) {
+            xap::test::assert_ok(samples[i] < 32767 && samples[i] > 16384);
+        } else {
+            xap::test::assert_equal<int16_t>(samples[i], 1000);
+        }
+    }
+    xap::test::assert_equal<uint64_t>(limiter16.get_clip_count(), 500U);
+}
+
+/**
+ *  Test the look-ahead limiter.
+ */
+static void lookahead() {
+    std::vector<float> samples = build_signal();
+    xap::audioio::LimiterOptions options;
+    options.mode = xap::audioio::LIMITERMODE_PEAK;
+    options.threshold = -3.0F;
+    float threshold = get_threshold(options.threshold);
+    xap::audioio::Limiter limiter(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        options
+    );
+    size_t latency = limiter.get_latency();
+    xap::test::assert_equal<size_t>(latency, 72U + 2U);
+
+    //  In pieces of odd sizes.
+    std::vector<float> output = samples;
+    for (size_t offset = 0U; offset < FRAME_COUNT; offset += 333U) {
+        size_t count = std::min<size_t>(333U, FRAME_COUNT - offset);
+        limiter.limit(output.data() + 2U * offset, count);
+    }
+
+    //  Delayed, never above the threshold, unchanged before the first burst 
+    //  and once the gain recovered.
+    for (size_t i = 0U; i < 2U * latency; ++i) {
+        xap::test::assert_ok(output[i] == 0.0F);
+    }
+    for (size_t i = latency; i < FRAME_COUNT; ++i) {
+        float left = output[2U * i];
+        float right = output[2U * i + 1U];
+        xap::test::assert_ok(fabsf(left) <= threshold + 1E-5F);
+        xap::test::assert_ok(fabsf(right) <= threshold + 1E-5F);
+        float expected = samples[2U * (i - latency)];
+        if (i < 9900U || i > 40000U) {
+            xap::test::assert_ok(left == expected);
+        } else if (i > 10100U && i < 11900U) {
+            //  The gain is held near threshold / 1.5 during the burst.
+            xap::test::assert_ok(
+                fabsf(left - expected * threshold / 1.5F) < 0.02F
+            );
+        }
+    }
+    xap::test::assert_ok(limiter.get_clip_count() != 0U);
+
+    //  The same output when processed at once.
+    xap::audioio::Limiter whole(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        options
+    );
+    std::vector<float> again = samples;
+    whole.limit(again.data(), FRAME_COUNT);
+    xap::test::assert_ok(again == output);
+
+    //  Reset clears the delay line.
+    whole.reset();
+    whole.limit(again.data(), FRAME_COUNT);
+    for (size_t i = 0U; i < 2U * latency; ++i) {
+        xap::test::assert_ok(again[i] == 0.0F);
+    }
+}
+
+/**
+ *  Test the true-peak limiter.
+ */
+static void true_peak() {
+    //  A quarter of the sample rate, the samples are at 0.707 of the peak.
+    std::vector<float> samples(2U * FRAME_COUNT);
+    for (size_t i = 0U; i < FRAME_COUNT; ++i) {
+        float value = ((i / 2U) % 2U == 0U) ? 0.7F : -0.7F;
+        samples[2U * i] = value;
+        samples[2U * i + 1U] = value;
+    }
+    xap::audioio::LimiterOptions options;
+    options.threshold = -2.0F;
+    float threshold = get_threshold(options.threshold);
+
+    options.mode = xap::audioio::LIMITERMODE_PEAK;
+    xap::audioio::Limiter peak(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        options
+    );
+    std::vector<float> output = samples;
+    peak.limit(output.data(), FRAME_COUNT);
+    xap::test::assert_ok(fabsf(output[FRAME_COUNT]) == 0.7F);
+
+    options.mode = xap::audioio::LIMITERMODE_TRUE_PEAK;
+    xap::audioio::Limiter limiter(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+        options
+    );
+    output = samples;
+    limiter.limit(output.data(), FRAME_COUNT);
+    for (size_t i = FRAME_COUNT / 2U; i < 2U * FRAME_COUNT; ++i) {
+        //  The interpolated peak is 1.25 * 0.7.
+        xap::test::assert_ok(
+            fabsf(fabsf(output[i]) - threshold / 1.25F) < 1E-4F
+        );
+    }
+}
+
+/**
+ *  Test the look-ahead limiter on 16-bit audio data.
+ */
+static void int16() {
+    std::vector<float> samples = build_signal();
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16),
+        FRAME_COUNT
+    );
+    int16_t *values = data.get_samples<int16_t>();
+    for (size_t i = 0U; i < 2U * FRAME_COUNT; ++i) {
+        float value = samples[i] * 32768.0F;
+        value = std::min(std::max(value, -32768.0F), 32767.0F);
+        values[i] = static_cast<int16_t>(lrintf(value));
+    }
+    std::vector<int16_t> input(values, values + 2U * FRAME_COUNT);
+    xap::audioio::LimiterOptions options;
+    options.mode = xap::audioio::LIMITERMODE_PEAK;
+    xap::audioio::Limiter limiter(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16),
+        options
+    );
+    limiter.process(data);
+    int16_t limit = static_cast<int16_t>(
+        get_threshold(options.threshold) * 32768.0F + 1.0F
+    );
+    size_t latency = limiter.get_latency();
+    for (size_t i = latency; i < FRAME_COUNT; ++i) {
+        xap::test::assert_ok(abs(values[2U * i]) <= limit);
+        if (i < 9900U || i > 40000U) {
+            xap::test::assert_equal<int16_t>(
+                values[2U * i],
+                input[2U * (i - latency)]
+            );
+        }
+    }
+    xap::test::assert_ok(limiter.get_clip_count() != 0U);
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::LimiterOptions options;
+    options.mode = 4U;
+    try {
+        xap::audioio::Limiter limiter(
+            get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+            options
+        );
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    options.mode = xap::audioio::LIMITERMODE_PEAK;
+    options.threshold = 1.0F;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::Limiter limiter(
+            get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+            options
+        );
+    });
+    options.threshold = -1.0F;
+    options.lookahead = 1000.0F;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::Limiter limiter(
+            get_format(xap::audioio::SAMPLEFORMAT_FLOAT32),
+            options
+        );
+    });
+    try {
+        xap::audioio::Limiter limiter(
+            get_format(xap::audioio::SAMPLEFORMAT_INT32)
+        );
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::Limiter limiter(
+        get_format(xap::audioio::SAMPLEFORMAT_FLOAT32)
+    );
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16),
+        160U
+    );
+    try {
+        limiter.process(data);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("None...\n");
+    none();
+
+    //
+    //  Case 2.
+    //
+    printf("Soft clip...\n");
+    soft_clip();
+
+    //
+    //  Case 3.
+    //
+    printf("Look-ahead...\n");
+    lookahead();
+
+    //
+    //  Case 4.
+    //
+    printf("True peak...\n");
+    true_peak();
+
+    //
+    //  Case 5.
+    //
+    printf("16-bit...\n");
+    int16();
+
+    //
+    //  Case 6.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
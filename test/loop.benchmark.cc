@@ -0,0 +1,91 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t LOOP_FRAMES   = 480000U;  //  10s at 48kHz.
+const static size_t PERIOD_COUNT  = 100U;     //  1s.
+
+/**
+ *  Run the benchmark (many players of one loop at different positions, 
+ *  stereo float output).
+ * 
+ *  @param loop
+ *      The loop.
+ *  @param source_count
+ *      The count of sources.
+ */
+static void run(
+    const std::shared_ptr<const xap::audioio::LoopBuffer>  &loop,
+    size_t                                                  source_count
+) {
+    std::vector<std::unique_ptr<xap::audioio::LoopSource>> sources;
+    for (size_t i = 0U; i < source_count; ++i) {
+        xap::audioio::LoopSourceOptions options;
+        options.start_frame = (i * 4801U) % LOOP_FRAMES;
+        sources.emplace_back(new xap::audioio::LoopSource(loop, options));
+    }
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t period = 0U; period < PERIOD_COUNT; ++period) {
+        for (size_t i = 0U; i < source_count; ++i) {
+            sources[i]->read(output);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 
+                   48000.0 * static_cast<double>(source_count);
+    printf("%7zu | %20.1f\n", source_count, audio / elapsed);
+}
+
+//
+//  Main.
+//
+int main() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    xap::audioio::AudioBuffer data = 
+        xap::audioio::AudioBuffer::allocate(format, LOOP_FRAMES);
+    for (size_t i = 0U; i < 2U * LOOP_FRAMES; ++i) {
+        data.get_samples<float>()[i] = 
+            0.5F * static_cast<float>(sin(static_cast<double>(i) * 0.01));
+    }
+    xap::audioio::LoopRegion region;
+    region.crossfade_frames = 4800U;
+    std::shared_ptr<const xap::audioio::LoopBuffer> loop(
+        new xap::audioio::LoopBuffer(data, region)
+    );
+
+    //  Real-time factor is the count of players one core can serve.
+    printf("Players | Real-time (x faster)\n");
+    run(loop, 100U);
+    run(loop, 1000U);
+    run(loop, 5000U);
+    return 0;
+}
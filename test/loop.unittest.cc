@@ -0,0 +1,291 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Count of frames of the test audio data.
+const static size_t DATA_FRAMES = 1000U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the format of the test audio data (16-bit stereo 8kHz).
+ */
+static xap::audioio::AudioFormat get_format() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 2U;
+    format.sample_rate = 8000U;
+    return format;
+}
+
+/**
+ *  Build the test audio data (the frame index on both channels).
+ */
+static xap::audioio::AudioBuffer build_data() {
+    xap::audioio::AudioBuffer data = 
+        xap::audioio::AudioBuffer::allocate(get_format(), DATA_FRAMES);
+    for (size_t i = 0U; i < DATA_FRAMES; ++i) {
+        data.get_samples<int16_t>()[2U * i] = static_cast<int16_t>(i);
+        data.get_samples<int16_t>()[2U * i + 1U] = static_cast<int16_t>(-i);
+    }
+    return data;
+}
+
+/**
+ *  Play a source until it finished (or up to a count of frames).
+ * 
+ *  @param source
+ *      The source.
+ *  @param period_frames
+ *      The count of frames of each period.
+ *  @param limit
+ *      The maximum count of frames.
+ *  @return
+ *      The left channel of the frames read.
+ */
+static std::vector<int16_t> play(
+    xap::audioio::LoopSource  &source,
+    size_t                     period_frames,
+    size_t                     limit
+) {
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(get_format(), period_frames);
+    std::vector<int16_t> played;
+    while (!source.is_finished() && played.size() < limit) {
+        size_t count = source.read(output);
+        for (size_t i = 0U; i < count; ++i) {
+            played.push_back(output.get_samples<int16_t>()[2U * i]);
+        }
+    }
+    return played;
+}
+
+/**
+ *  Append a range of the test audio data.
+ */
+static void append_range(
+    std::vector<int16_t>  &expected,
+    size_t                 begin,
+    size_t                 end
+) {
+    for (size_t i = begin; i < end; ++i) {
+        expected.push_back(static_cast<int16_t>(i));
+    }
+}
+
+/**
+ *  Test loops without crossfade.
+ */
+static void plain() {
+    xap::audioio::LoopRegion region;
+    region.loop_start = 200U;
+    region.loop_end = 700U;
+    std::shared_ptr<const xap::audioio::LoopBuffer> loop(
+        new xap::audioio::LoopBuffer(build_data(), region)
+    );
+    xap::test::assert_equal<size_t>(loop->get_seam().get_frame_count(), 0U);
+    xap::audioio::LoopSourceOptions options;
+    options.loop_count = 2U;
+
+    std::vector<int16_t> expected;
+    append_range(expected, 0U, 700U);
+    append_range(expected, 200U, 700U);
+    append_range(expected, 200U, 1000U);
+    for (size_t period_frames : {160U, 7U, 1000U}) {
+        xap::audioio::LoopSource source(loop, options);
+        std::vector<int16_t> played = play(source, period_frames, 100000U);
+        xap::test::assert_ok(played == expected);
+        xap::test::assert_equal<uint64_t>(source.get_loop_index(), 2U);
+    }
+}
+
+/**
+ *  Test crossfaded seams.
+ */
+static void crossfaded() {
+    const size_t fade = 50U;
+    xap::audioio::LoopRegion region;
+    region.loop_start = 200U;
+    region.loop_end = 700U;
+    region.crossfade_frames = fade;
+    std::shared_ptr<const xap::audioio::LoopBuffer> loop(
+        new xap::audioio::LoopBuffer(build_data(), region)
+    );
+    xap::test::assert_equal<size_t>(loop->get_crossfade_frames(), fade);
+    xap::audioio::LoopSourceOptions options;
+    options.loop_count = 1U;
+    xap::audioio::LoopSource source(loop, options);
+    std::vector<int16_t> played = play(source, 160U, 100000U);
+
+    //  [0, 650), the seam, then [250, 1000).
+    xap::test::assert_equal<size_t>(played.size(), 650U + fade + 750U);
+    for (size_t i = 0U; i < 650U; ++i) {
+        xap::test::assert_equal<int16_t>(played[i], static_cast<int16_t>(i));
+    }
+    for (size_t i = 0U; i < fade; ++i) {
+        double angle = (static_cast<double>(i) + 0.5) * 0.5 * PI / 
+                       static_cast<double>(fade);
+        double expected = static_cast<double>(650U + i) * cos(angle) + 
+                          static_cast<double>(200U + i) * sin(angle);
+        xap::test::assert_ok(
+            fabs(static_cast<double>(played[650U + i]) - expected) <= 0.5
+        );
+    }
+    for (size_t i = 0U; i < 750U; ++i) {
+        xap::test::assert_equal<int16_t>(
+            played[650U + fade + i],
+            static_cast<int16_t>(250U + i)
+        );
+    }
+
+    //  The crossfade is at most half of the loop.
+    region.crossfade_frames = 10000U;
+    xap::audioio::LoopBuffer clamped(build_data(), region);
+    xap::test::assert_equal<size_t>(clamped.get_crossfade_frames(), 250U);
+}
+
+/**
+ *  Test many sources sharing one loop (at different positions).
+ */
+static void shared() {
+    xap::audioio::LoopRegion region;
+    region.loop_start = 100U;
+    region.loop_end = 900U;
+    region.crossfade_frames = 20U;
+    std::shared_ptr<const xap::audioio::LoopBuffer> loop(
+        new xap::audioio::LoopBuffer(build_data(), region)
+    );
+    const size_t source_count = 1000U;
+    std::vector<std::unique_ptr<xap::audioio::LoopSource>> sources;
+    for (size_t k = 0U; k < source_count; ++k) {
+        xap::audioio::LoopSourceOptions options;
+        options.start_frame = (k * 7U) % 600U;
+        sources.emplace_back(new xap::audioio::LoopSource(loop, options));
+    }
+
+    //  Each source plays its own timeline (the loop period is 780 frames).
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(get_format(), 160U);
+    for (size_t period = 0U; period < 50U; ++period) {
+        for (size_t k = 0U; k < source_count; ++k) {
+            xap::test::assert_equal<size_t>(sources[k]->read(output), 160U);
+            if (k % 97U != 0U) {
+                continue;
+            }
+            size_t start = (k * 7U) % 600U;
+            for (size_t i = 0U; i < 160U; ++i) {
+                size_t t = start + period * 160U + i;
+                if (t >= 880U) {
+                    //  The seam, then the loop after the crossfade.
+                    size_t offset = (t - 880U) % 780U;
+                    if (offset < 20U) {
+                        continue;
+                    }
+                    t = 120U + (offset - 20U);
+                }
+                xap::test::assert_equal<int16_t>(
+                    output.get_samples<int16_t>()[2U * i],
+                    static_cast<int16_t>(t)
+                );
+            }
+        }
+    }
+    xap::test::assert_ok(sources[0]->get_loop_index() >= 9U);
+
+    //  Released sources play to the end.
+    for (size_t k = 0U; k < source_count; ++k) {
+        sources[k]->release();
+    }
+    std::vector<int16_t> tail = play(*sources[0], 160U, 100000U);
+    xap::test::assert_ok(sources[0]->is_finished());
+    xap::test::assert_equal<int16_t>(tail.back(), 999);
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::LoopRegion region;
+    region.loop_start = 500U;
+    region.loop_end = 400U;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::LoopBuffer loop(build_data(), region);
+    });
+    region.loop_start = 0U;
+    region.loop_end = DATA_FRAMES + 1U;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::LoopBuffer loop(build_data(), region);
+    });
+
+    std::shared_ptr<const xap::audioio::LoopBuffer> loop(
+        new xap::audioio::LoopBuffer(build_data())
+    );
+    xap::audioio::LoopSourceOptions options;
+    options.start_frame = DATA_FRAMES;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::LoopSource source(loop, options);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::LoopSource source(nullptr);
+    });
+
+    xap::audioio::LoopSource source(loop);
+    xap::audioio::AudioFormat format = get_format();
+    format.channel_count = 1U;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 160U);
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        source.read(output);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Plain...\n");
+    plain();
+
+    //
+    //  Case 2.
+    //
+    printf("Crossfaded...\n");
+    crossfaded();
+
+    //
+    //  Case 3.
+    //
+    printf("Shared...\n");
+    shared();
+
+    //
+    //  Case 4.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
@@ -0,0 +1,345 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <atomic>
+#include <math.h>
+#include <memory>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Packet size (10ms at 8kHz).
+const static size_t PACKET_FRAMES = 80U;
+
+/**
+ *  Allocator which counts allocations.
+ */
+class CountingAllocator: public xap::audioio::IAllocator {
+public:
+    CountingAllocator() noexcept : m_count(0) {}
+
+    virtual void *allocate(size_t size, size_t alignment) noexcept override {
+        ++(this->m_count);
+        return this->m_system.allocate(size, alignment);
+    }
+
+    virtual void deallocate(
+        void   *pointer, 
+        size_t  size, 
+        size_t  alignment
+    ) noexcept override {
+        this->m_system.deallocate(pointer, size, alignment);
+    }
+
+    int get_count() const noexcept {
+        return this->m_count.load();
+    }
+
+private:
+    xap::audioio::DefaultAllocator m_system;
+    std::atomic<int>               m_count;
+};
+
+/**
+ *  Source of a periodic (voiced-like) signal which loses some packets.
+ */
+class LossySource: public xap::audioio::ISource {
+public:
+    explicit LossySource(const std::set<size_t> &lost) : 
+        m_lost(lost), 
+        m_packet(0U) 
+    {}
+
+    virtual size_t read(xap::audioio::AudioBuffer &output) override {
+        size_t frame_count = output.get_frame_count();
+        size_t packet = this->m_packet++;
+        if (this->m_lost.count(packet) != 0U) {
+            return 0U;
+        }
+        int16_t *samples = output.get_samples<int16_t>();
+        for (size_t i = 0U; i < frame_count; ++i) {
+            samples[i] = get_sample(packet * frame_count + i);
+        }
+        return frame_count;
+    }
+
+    /**
+     *  Get a sample of the signal (harmonics of 125Hz, a pitch period of 
+     *  64 frames).
+     */
+    static int16_t get_sample(size_t index) {
+        double t = static_cast<double>(index) / 8000.0;
+        double value = 6000.0 * sin(2.0 * PI * 125.0 * t) + 
+                       3000.0 * sin(2.0 * PI * 250.0 * t + 0.5) + 
+                       1500.0 * sin(2.0 * PI * 375.0 * t + 1.0);
+        return static_cast<int16_t>(value);
+    }
+
+private:
+    std::set<size_t> m_lost;
+    size_t           m_packet;
+};
+
+/**
+ *  Build a 16-bit mono 8kHz audio format.
+ * 
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 8000U;
+    return format;
+}
+
+/**
+ *  Play packets through a concealer.
+ * 
+ *  @param concealer
+ *      The concealer.
+ *  @param packet_count
+ *      The count of packets.
+ *  @return
+ *      The samples played.
+ */
+static std::vector<int16_t> play(
+    xap::audioio::LossConcealer &concealer, 
+    size_t                       packet_count
+) {
+    std::vector<int16_t> samples;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(build_format(), PACKET_FRAMES);
+    for (size_t i = 0U; i < packet_count; ++i) {
+        memset(output.get_pointer(), 0, output.get_length());
+        xap::test::assert_equal<size_t>(
+            concealer.read(output), 
+            PACKET_FRAMES
+        );
+        samples.insert(
+            samples.end(), 
+            output.get_samples<int16_t>(), 
+            output.get_samples<int16_t>() + PACKET_FRAMES
+        );
+    }
+    return samples;
+}
+
+//
+//  Test cases.
+//
+
+void passthrough() {
+    std::shared_ptr<LossySource> source = 
+        std::make_shared<LossySource>(std::set<size_t>());
+    xap::audioio::LossConcealer concealer(source, build_format());
+    size_t latency = concealer.get_latency();
+    xap::test::assert_equal<size_t>(latency, 30U);
+
+    std::vector<int16_t> samples = play(concealer, 20U);
+    for (size_t i = 0U; i < samples.size(); ++i) {
+        int16_t expected = i < latency ? 
+            0 : 
+            LossySource::get_sample(i - latency);
+        xap::test::assert_equal<int16_t>(samples[i], expected);
+    }
+    xap::test::assert_equal<uint64_t>(
+        concealer.get_concealed_frame_count(), 
+        0U
+    );
+}
+
+void short_loss() {
+    //
+    //  A 20ms loss of a periodic signal is concealed closely and without 
+    //  discontinuities.
+    //
+    std::set<size_t> lost = {10U, 11U};
+    std::shared_ptr<LossySource> source = std::make_shared<LossySource>(lost);
+    xap::audioio::LossConcealer concealer(source, build_format());
+    size_t latency = concealer.get_latency();
+    std::vector<int16_t> samples = play(concealer, 20U);
+
+    double error = 0.0;
+    double energy = 0.0;
+    int max_step = 0;
+    for (size_t i = latency + 1U; i < samples.size(); ++i) {
+        int step = abs(static_cast<int>(samples[i]) - samples[i - 1U]);
+        if (step > max_step) {
+            max_step = step;
+        }
+    }
+    for (size_t i = 800U; i < 880U; ++i) {
+        double expected = LossySource::get_sample(i);
+        double difference = static_cast<double>(samples[i + latency]) - 
+                            expected;
+        error += difference * difference;
+        energy += expected * expected;
+    }
+    xap::test::assert_ok(error < energy * 0.01, "Concealment mismatched.");
+    xap::test::assert_ok(max_step < 2500, "Discontinuity.");
+    xap::test::assert_equal<uint64_t>(
+        concealer.get_concealed_frame_count(), 
+        160U
+    );
+
+    //  Back to the received audio data after the recovery.
+    for (size_t i = 1040U; i < samples.size() - latency; ++i) {
+        xap::test::assert_equal<int16_t>(
+            samples[i + latency], 
+            LossySource::get_sample(i)
+        );
+    }
+}
+
+void long_loss() {
+    //
+    //  A 100ms loss fades to silence after 60ms.
+    //
+    std::set<size_t> lost;
+    for (size_t i = 10U; i < 20U; ++i) {
+        lost.insert(i);
+    }
+    std::shared_ptr<LossySource> source = std::make_shared<LossySource>(lost);
+    CountingAllocator allocator;
+    xap::audioio::LossConcealer concealer(source, build_format(), &allocator);
+    int allocations = allocator.get_count();
+    size_t latency = concealer.get_latency();
+    std::vector<int16_t> samples = play(concealer, 30U);
+
+    int peak_early = 0;
+    for (size_t i = 800U; i < 1200U; ++i) {
+        int value = abs(static_cast<int>(samples[i + latency]));
+        if (value > peak_early) {
+            peak_early = value;
+        }
+    }
+    xap::test::assert_ok(peak_early > 3000, "Concealment missing.");
+    for (size_t i = 800U + 480U; i < 1600U; ++i) {
+        xap::test::assert_equal<int16_t>(samples[i + latency], 0);
+    }
+    for (size_t i = 1600U + 80U; i < samples.size() - latency; ++i) {
+        xap::test::assert_equal<int16_t>(
+            samples[i + latency], 
+            LossySource::get_sample(i)
+        );
+    }
+
+    //  No allocation on the audio thread.
+    xap::test::assert_equal<int>(allocator.get_count(), allocations);
+}
+
+void stereo_float() {
+    //
+    //  Frames lost in the middle of a read (the valid prefix is reported).
+    //
+    class PrefixSource: public xap::audioio::ISource {
+    public:
+        PrefixSource() : m_position(0U) {}
+
+        virtual size_t read(xap::audioio::AudioBuffer &output) override {
+            size_t count = this->m_position == 0U ? 
+                output.get_frame_count() : 
+                100U;
+            float *samples = output.get_samples<float>();
+            for (size_t i = 0U; i < count; ++i) {
+                float value = static_cast<float>(sin(
+                    2.0 * PI * static_cast<double>(this->m_position++) / 50.0
+                ));
+                samples[i * 2U] = value;
+                samples[i * 2U + 1U] = 0.5F * value;
+            }
+            return count;
+        }
+
+    private:
+        size_t m_position;
+    };
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_FLOAT32;
+    format.channel_count = 2U;
+    format.sample_rate = 48000U;
+    xap::audioio::LossConcealer concealer(
+        std::make_shared<PrefixSource>(), 
+        format
+    );
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 1000U);
+    xap::test::assert_equal<size_t>(concealer.read(output), 1000U);
+    xap::test::assert_equal<size_t>(concealer.read(output), 1000U);
+    xap::test::assert_equal<uint64_t>(
+        concealer.get_concealed_frame_count(), 
+        900U
+    );
+
+    //  The first 10ms concealed are not attenuated.
+    const float *samples = output.get_samples<float>();
+    size_t begin = 100U + concealer.get_latency();
+    float peak = 0.0F;
+    for (size_t i = 0U; i < 1000U; ++i) {
+        xap::test::assert_ok(samples[i * 2U + 1U] == 0.5F * samples[i * 2U]);
+        if (i >= begin && i < begin + 480U && samples[i * 2U] > peak) {
+            peak = samples[i * 2U];
+        }
+    }
+    xap::test::assert_ok(peak > 0.95F, "Concealment missing.");
+
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::LossConcealer invalid(nullptr, format);
+    });
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::AudioFormat unsupported = format;
+        unsupported.sample_format = xap::audioio::SAMPLEFORMAT_INT32;
+        xap::audioio::LossConcealer invalid(
+            std::make_shared<PrefixSource>(), 
+            unsupported
+        );
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Passthrough...\n");
+    passthrough();
+
+    //
+    //  Case 2.
+    //
+    printf("Short loss...\n");
+    short_loss();
+
+    //
+    //  Case 3.
+    //
+    printf("Long loss...\n");
+    long_loss();
+
+    //
+    //  Case 4.
+    //
+    printf("Stereo, 32-bit float...\n");
+    stereo_float();
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t CHANNEL_COUNT = 8U;
+const static size_t PERIOD_FRAMES = 480U;     //  10ms at 48kHz.
+const static size_t PERIOD_COUNT  = 3000U;    //  30s.
+
+/**
+ *  Run the benchmark (8-channel periods).
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @param band_count
+ *      The count of bands.
+ *  @return
+ *      The real-time factor.
+ */
+static double run(
+    xap::audioio::SampleFormat  sample_format,
+    uint8_t                     band_count
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = static_cast<uint16_t>(CHANNEL_COUNT);
+    format.sample_rate = 48000U;
+    xap::audioio::MultibandCompressorOptions options;
+    options.band_count = band_count;
+    xap::audioio::MultibandCompressor compressor(format, options);
+    xap::audioio::AudioBuffer period = xap::audioio::AudioBuffer::allocate(
+        format,
+        PERIOD_FRAMES
+    );
+
+    std::vector<float> signal(CHANNEL_COUNT * PERIOD_FRAMES * 100U);
+    for (size_t i = 0U; i < signal.size(); ++i) {
+        signal[i] = static_cast<float>(
+            0.5 * sin(static_cast<double>(i) * 0.01) + 
+            0.3 * sin(static_cast<double>(i) * 0.37)
+        );
+    }
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    size_t period_size = CHANNEL_COUNT * PERIOD_FRAMES;
+    for (size_t k = 0U; k < PERIOD_COUNT; ++k) {
+        const float *source = signal.data() + (k % 100U) * period_size;
+        if (sample_format == xap::audioio::SAMPLEFORMAT_INT16) {
+            int16_t *samples = period.get_samples<int16_t>();
+            for (size_t i = 0U; i < period_size; ++i) {
+                samples[i] = static_cast<int16_t>(source[i] * 32767.0F);
+            }
+        } else {
+            std::copy(
+                source,
+                source + period_size,
+                period.get_samples<float>()
+            );
+        }
+        compressor.process(period);
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    return static_cast<double>(PERIOD_COUNT * PERIOD_FRAMES) / 48000.0 / 
+           elapsed;
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Bands | Float (x real-time) | 16-bit (x real-time)\n");
+    for (uint8_t band_count = 3U; band_count <= 5U; ++band_count) {
+        printf(
+            "%5u | %19.1f | %20.1f\n",
+            static_cast<unsigned>(band_count),
+            run(xap::audioio::SAMPLEFORMAT_FLOAT32, band_count),
+            run(xap::audioio::SAMPLEFORMAT_INT16, band_count)
+        );
+    }
+    return 0;
+}
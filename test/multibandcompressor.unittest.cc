@@ -0,0 +1,391 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+
+//  Count of frames of the test signals.
+const static size_t FRAME_COUNT = 48000U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the format of the test signals (48kHz).
+ */
+static xap::audioio::AudioFormat get_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint16_t                    channel_count
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = channel_count;
+    format.sample_rate = 48000U;
+    return format;
+}
+
+/**
+ *  Build a test signal (a sine of one frequency per channel).
+ */
+static std::vector<float> build_signal(
+    const std::vector<double>  &frequencies,
+    double                      level
+) {
+    size_t channel_count = frequencies.size();
+    std::vector<float> samples(channel_count * FRAME_COUNT);
+    for (size_t i = 0U; i < FRAME_COUNT; ++i) {
+        for (size_t k = 0U; k < channel_count; ++k) {
+            samples[i * channel_count + k] = static_cast<float>(level * sin(
+                2.0 * M_PI * frequencies[k] * static_cast<double>(i) / 48000.0
+            ));
+        }
+    }
+    return samples;
+}
+
+/**
+ *  Get the level of one channel over the second half of a signal.
+ */
+static double get_level(
+    const std::vector<float>  &samples,
+    size_t                     channel_count,
+    size_t                     channel
+) {
+    double sum = 0.0;
+    for (size_t i = FRAME_COUNT / 2U; i < FRAME_COUNT; ++i) {
+        double value = static_cast<double>(
+            samples[i * channel_count + channel]
+        );
+        sum += value * value;
+    }
+    return 10.0 * log10(sum / static_cast<double>(FRAME_COUNT / 2U));
+}
+
+/**
+ *  Get the options of a hard-knee compressor of the middle band only (the
+ *  envelope follows the peaks closely).
+ */
+static xap::audioio::MultibandCompressorOptions get_options() {
+    xap::audioio::MultibandCompressorOptions options;
+    options.crossovers[0] = 200.0F;
+    options.crossovers[1] = 3000.0F;
+    for (size_t i = 0U; i < xap::audioio::COMPRESSOR_MAX_BANDS; ++i) {
+        options.bands[i].ratio = 1.0F;
+        options.bands[i].knee = 0.0F;
+        options.bands[i].attack = 1.0F;
+        options.bands[i].release = 500.0F;
+    }
+    options.bands[1].ratio = 4.0F;
+    return options;
+}
+
+/**
+ *  Test that the bands sum up flat.
+ */
+static void flat() {
+    std::vector<double> frequencies = {
+        30.0, 150.0, 700.0, 2500.0, 7000.0, 11000.0, 16000.0
+    };
+    size_t channel_count = frequencies.size();
+    std::vector<float> samples = build_signal(frequencies, 0.5);
+
+    xap::audioio::MultibandCompressorOptions options;
+    options.band_count = 5U;
+    for (size_t i = 0U; i < xap::audioio::COMPRESSOR_MAX_BANDS; ++i) {
+        options.bands[i].ratio = 1.0F;
+    }
+    xap::audioio::MultibandCompressor compressor(
+        get_format(
+            xap::audioio::SAMPLEFORMAT_FLOAT32,
+            static_cast<uint16_t>(channel_count)
+        ),
+        options
+    );
+
+    //  In periods of odd sizes.
+    std::vector<float> output = samples;
+    for (size_t offset = 0U; offset < FRAME_COUNT; offset += 333U) {
+        size_t count = std::min<size_t>(333U, FRAME_COUNT - offset);
+        xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::wrap(
+            output.data() + offset * channel_count,
+            count,
+            get_format(
+                xap::audioio::SAMPLEFORMAT_FLOAT32,
+                static_cast<uint16_t>(channel_count)
+            )
+        );
+        compressor.process(data);
+    }
+    for (size_t k = 0U; k < channel_count; ++k) {
+        double difference = get_level(output, channel_count, k) - 
+                            get_level(samples, channel_count, k);
+        xap::test::assert_ok(fabs(difference) < 0.1);
+    }
+    for (size_t i = 0U; i < options.band_count; ++i) {
+        xap::test::assert_ok(compressor.get_gain_reduction(i) == 0.0F);
+    }
+}
+
+/**
+ *  Test compression of one band.
+ */
+static void compression() {
+    //  A 1kHz sine at -6dBFS (peak), 14dB above the threshold.
+    std::vector<float> samples = build_signal({1000.0, 1000.0}, 0.5);
+    xap::audioio::MultibandCompressorOptions options = get_options();
+    xap::audioio::AudioFormat format = get_format(
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        2U
+    );
+    xap::audioio::MultibandCompressor compressor(format, options);
+    std::vector<float> output = samples;
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::wrap(
+        output.data(),
+        FRAME_COUNT,
+        format
+    );
+    compressor.process(data);
+
+    xap::test::assert_ok(
+        fabsf(compressor.get_gain_reduction(1U) - 10.5F) < 1.0F
+    );
+    xap::test::assert_ok(compressor.get_gain_reduction(0U) == 0.0F);
+    xap::test::assert_ok(compressor.get_gain_reduction(2U) == 0.0F);
+    for (size_t k = 0U; k < 2U; ++k) {
+        double difference = get_level(output, 2U, k) - 
+                            get_level(samples, 2U, k);
+        xap::test::assert_ok(fabs(difference + 10.5) < 1.0);
+    }
+
+    //  Make-up gain restores the level, reset clears the envelopes.
+    options.bands[1].makeup = 10.5F;
+    xap::audioio::MultibandCompressor makeup(format, options);
+    output = samples;
+    makeup.process(data);
+    for (size_t k = 0U; k < 2U; ++k) {
+        double difference = get_level(output, 2U, k) - 
+                            get_level(samples, 2U, k);
+        xap::test::assert_ok(fabs(difference) < 1.0);
+    }
+    makeup.reset();
+    xap::test::assert_ok(makeup.get_gain_reduction(1U) == 0.0F);
+}
+
+/**
+ *  Test changing the parameters of a band.
+ */
+static void set_band() {
+    std::vector<float> samples = build_signal({1000.0}, 0.5);
+    xap::audioio::MultibandCompressorOptions options = get_options();
+    options.bands[1].ratio = 1.0F;
+    xap::audioio::AudioFormat format = get_format(
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        1U
+    );
+    xap::audioio::MultibandCompressor compressor(format, options);
+    std::vector<float> output = samples;
+    xap::audioio::AudioBuffer first = xap::audioio::AudioBuffer::wrap(
+        output.data(),
+        FRAME_COUNT / 2U,
+        format
+    );
+    compressor.process(first);
+    xap::test::assert_ok(compressor.get_gain_reduction(1U) == 0.0F);
+
+    //  Applied at the next period.
+    xap::audioio::CompressorBand band = options.bands[1];
+    band.ratio = 4.0F;
+    compressor.set_band(1U, band);
+    xap::test::assert_ok(compressor.get_gain_reduction(1U) == 0.0F);
+    xap::audioio::AudioBuffer second = xap::audioio::AudioBuffer::wrap(
+        output.data() + FRAME_COUNT / 2U,
+        FRAME_COUNT / 2U,
+        format
+    );
+    compressor.process(second);
+    xap::test::assert_ok(
+        fabsf(compressor.get_gain_reduction(1U) - 10.5F) < 1.0F
+    );
+    double difference = get_level(output, 1U, 0U) - 
+                        get_level(samples, 1U, 0U);
+    xap::test::assert_ok(fabs(difference + 10.5) < 1.0);
+
+    //  Too many pending changes.
+    try {
+        for (size_t i = 0U; i < 1000U; ++i) {
+            compressor.set_band(0U, band);
+        }
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+    compressor.process(second);
+    compressor.set_band(0U, band);
+
+    //  Invalid band or parameters.
+    try {
+        compressor.set_band(3U, band);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    band.ratio = 0.5F;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        compressor.set_band(0U, band);
+    });
+}
+
+/**
+ *  Test compression of 16-bit audio data.
+ */
+static void int16() {
+    std::vector<float> samples = build_signal({1000.0, 100.0, 1000.0}, 0.5);
+    xap::audioio::AudioFormat format = get_format(
+        xap::audioio::SAMPLEFORMAT_INT16,
+        3U
+    );
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+        format,
+        FRAME_COUNT
+    );
+    int16_t *values = data.get_samples<int16_t>();
+    for (size_t i = 0U; i < 3U * FRAME_COUNT; ++i) {
+        values[i] = static_cast<int16_t>(lrintf(samples[i] * 32767.0F));
+    }
+    xap::audioio::MultibandCompressor compressor(format, get_options());
+    compressor.process(data);
+    std::vector<float> output(3U * FRAME_COUNT);
+    for (size_t i = 0U; i < 3U * FRAME_COUNT; ++i) {
+        output[i] = static_cast<float>(values[i]) / 32767.0F;
+    }
+
+    //  The channel in the low band is not changed.
+    xap::test::assert_ok(
+        fabsf(compressor.get_gain_reduction(1U) - 10.5F) < 1.0F
+    );
+    xap::test::assert_ok(compressor.get_gain_reduction(0U) == 0.0F);
+    double difference = get_level(output, 3U, 0U) - get_level(samples, 3U, 0U);
+    xap::test::assert_ok(fabs(difference + 10.5) < 1.0);
+    difference = get_level(output, 3U, 1U) - get_level(samples, 3U, 1U);
+    xap::test::assert_ok(fabs(difference) < 0.1);
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::AudioFormat format = get_format(
+        xap::audioio::SAMPLEFORMAT_FLOAT32,
+        2U
+    );
+    xap::audioio::MultibandCompressorOptions options;
+    options.band_count = 2U;
+    try {
+        xap::audioio::MultibandCompressor compressor(format, options);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    options.band_count = 4U;
+    options.crossovers[2] = 1000.0F;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::MultibandCompressor compressor(format, options);
+    });
+    options.crossovers[2] = 30000.0F;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::MultibandCompressor compressor(format, options);
+    });
+    options = xap::audioio::MultibandCompressorOptions();
+    options.bands[2].attack = 0.0F;
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::MultibandCompressor compressor(format, options);
+    });
+    try {
+        xap::audioio::MultibandCompressor compressor(get_format(
+            xap::audioio::SAMPLEFORMAT_INT32,
+            2U
+        ));
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::MultibandCompressor compressor(format);
+    xap::audioio::AudioBuffer data = xap::audioio::AudioBuffer::allocate(
+        get_format(xap::audioio::SAMPLEFORMAT_INT16, 2U),
+        160U
+    );
+    try {
+        compressor.process(data);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_UNSUPPORTED
+        );
+    }
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("Flat sum...\n");
+    flat();
+
+    //
+    //  Case 2.
+    //
+    printf("Compression...\n");
+    compression();
+
+    //
+    //  Case 3.
+    //
+    printf("Set band...\n");
+    set_band();
+
+    //
+    //  Case 4.
+    //
+    printf("16-bit...\n");
+    int16();
+
+    //
+    //  Case 5.
+    //
+    printf("Errors...\n");
+    errors();
+
+    return 0;
+}
@@ -0,0 +1,354 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static double PI = 3.14159265358979323846;
+
+//  Count of frames of each period.
+const static size_t PERIOD_FRAMES = 160U;
+
+//  Count of frames of the test items.
+const static size_t ITEM_FRAMES[] = {1000U, 240U, 3001U, 500U, 777U};
+const static size_t ITEM_COUNT = sizeof(ITEM_FRAMES) / sizeof(ITEM_FRAMES[0]);
+
+//
+//  Private functions.
+//
+
+/**
+ *  Get the format of the test items (16-bit mono 8kHz).
+ */
+static xap::audioio::AudioFormat get_format() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 8000U;
+    return format;
+}
+
+/**
+ *  Get the path of a test item.
+ */
+static std::string get_path(size_t item) {
+    return "playlist.unittest." + std::to_string(item) + ".tmp";
+}
+
+/**
+ *  Get a sample of a test item.
+ */
+static int16_t get_sample(size_t item, size_t frame) {
+    return static_cast<int16_t>(1000U * (item + 1U) + frame % 100U);
+}
+
+/**
+ *  Write the test items.
+ */
+static void write_items() {
+    xap::audioio::AudioFormat format = get_format();
+    for (size_t k = 0U; k < ITEM_COUNT; ++k) {
+        xap::audioio::AudioFileWriter writer(get_path(k).c_str(), format);
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, ITEM_FRAMES[k]);
+        for (size_t i = 0U; i < ITEM_FRAMES[k]; ++i) {
+            data.get_samples<int16_t>()[i] = get_sample(k, i);
+        }
+        writer.process(data);
+        writer.close();
+    }
+}
+
+/**
+ *  Remove the test items.
+ */
+static void remove_items() {
+    for (size_t k = 0U; k < ITEM_COUNT; ++k) {
+        remove(get_path(k).c_str());
+    }
+}
+
+/**
+ *  Play a playlist until it finished (one period per millisecond).
+ * 
+ *  @param playlist
+ *      The playlist.
+ *  @param events
+ *      The events (output).
+ *  @return
+ *      The output (all periods, missing frames are silence).
+ */
+static std::vector<int16_t> play(
+    xap::audioio::PlaylistSource              &playlist,
+    std::vector<xap::audioio::PlaylistEvent>  &events
+) {
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(get_format(), PERIOD_FRAMES);
+    std::vector<int16_t> timeline;
+    for (size_t period = 0U; period < 10000U; ++period) {
+        if (playlist.is_finished()) {
+            break;
+        }
+        memset(output.get_pointer(), 0, output.get_length());
+        playlist.read(output);
+        timeline.insert(
+            timeline.end(),
+            output.get_samples<int16_t>(),
+            output.get_samples<int16_t>() + PERIOD_FRAMES
+        );
+        xap::audioio::PlaylistEvent event;
+        while (playlist.poll_event(event)) {
+            events.push_back(event);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    xap::audioio::PlaylistEvent event;
+    while (playlist.poll_event(event)) {
+        events.push_back(event);
+    }
+    return timeline;
+}
+
+/**
+ *  Test gapless playback.
+ */
+static void gapless() {
+    xap::audioio::PromptCache cache;
+    xap::audioio::PlaylistOptions options;
+    options.cache = &cache;
+    xap::audioio::PlaylistSource playlist(get_format(), options);
+    std::vector<uint64_t> items;
+    for (size_t k = 0U; k < ITEM_COUNT; ++k) {
+        items.push_back(playlist.append(get_path(k).c_str()));
+    }
+    xap::test::assert_equal<uint64_t>(items[0], 1U);
+    std::vector<xap::audioio::PlaylistEvent> events;
+    std::vector<int16_t> timeline = play(playlist, events);
+
+    //  Each item starts at the frame after the last frame of the previous.
+    xap::test::assert_equal<size_t>(events.size(), 2U * ITEM_COUNT);
+    uint64_t frame = events[0].frame;
+    for (size_t k = 0U; k < ITEM_COUNT; ++k) {
+        const xap::audioio::PlaylistEvent &started = events[2U * k];
+        const xap::audioio::PlaylistEvent &finished = events[2U * k + 1U];
+        xap::test::assert_equal<uint8_t>(
+            started.type,
+            xap::audioio::PLAYLISTEVENT_STARTED
+        );
+        xap::test::assert_equal<uint64_t>(started.item, items[k]);
+        xap::test::assert_equal<uint64_t>(started.frame, frame);
+        for (size_t i = 0U; i < ITEM_FRAMES[k]; ++i) {
+            xap::test::assert_equal<int16_t>(
+                timeline[frame + i],
+                get_sample(k, i)
+            );
+        }
+        frame += ITEM_FRAMES[k];
+        xap::test::assert_equal<uint8_t>(
+            finished.type,
+            xap::audioio::PLAYLISTEVENT_FINISHED
+        );
+        xap::test::assert_equal<uint64_t>(finished.item, items[k]);
+        xap::test::assert_equal<uint64_t>(finished.frame, frame);
+    }
+    xap::test::assert_equal<uint64_t>(playlist.get_gap_frame_count(), 0U);
+
+    //  Items appended later continue the playlist.
+    uint64_t item = playlist.append(get_path(1U).c_str());
+    xap::test::assert_equal<uint64_t>(item, items.back() + 1U);
+    events.clear();
+    play(playlist, events);
+    xap::test::assert_equal<size_t>(events.size(), 2U);
+    xap::test::assert_equal<uint64_t>(
+        events[1].frame - events[0].frame,
+        ITEM_FRAMES[1]
+    );
+    xap::test::assert_equal<uint64_t>(playlist.get_gap_frame_count(), 0U);
+}
+
+/**
+ *  Test crossfades.
+ */
+static void crossfades() {
+    const size_t fade = 100U;
+    xap::audioio::PromptCache cache;
+    xap::audioio::PlaylistOptions options;
+    options.cache = &cache;
+    options.crossfade_frames = fade;
+    xap::audioio::PlaylistSource playlist(get_format(), options);
+    playlist.append(get_path(0U).c_str());
+    playlist.append(get_path(2U).c_str());
+    std::vector<xap::audioio::PlaylistEvent> events;
+    std::vector<int16_t> timeline = play(playlist, events);
+
+    xap::test::assert_equal<size_t>(events.size(), 4U);
+    uint64_t first = events[0].frame;
+    xap::test::assert_equal<uint8_t>(
+        events[1].type,
+        xap::audioio::PLAYLISTEVENT_STARTED
+    );
+    xap::test::assert_equal<uint64_t>(
+        events[1].frame,
+        first + ITEM_FRAMES[0] - fade
+    );
+    xap::test::assert_equal<uint64_t>(
+        events[3].frame,
+        first + ITEM_FRAMES[0] + ITEM_FRAMES[2] - fade
+    );
+
+    //  Before, within and after the crossfade.
+    for (size_t i = 0U; i < ITEM_FRAMES[0] - fade; ++i) {
+        xap::test::assert_equal<int16_t>(
+            timeline[first + i],
+            get_sample(0U, i)
+        );
+    }
+    for (size_t i = 0U; i < fade; ++i) {
+        double angle = (static_cast<double>(i) + 0.5) * 0.5 * PI / 
+                       static_cast<double>(fade);
+        double expected = 
+            static_cast<double>(get_sample(0U, ITEM_FRAMES[0] - fade + i)) * 
+                cos(angle) + 
+            static_cast<double>(get_sample(2U, i)) * sin(angle);
+        double actual = static_cast<double>(
+            timeline[first + ITEM_FRAMES[0] - fade + i]
+        );
+        xap::test::assert_ok(fabs(actual - expected) <= 0.5);
+    }
+    for (size_t i = fade; i < ITEM_FRAMES[2]; ++i) {
+        xap::test::assert_equal<int16_t>(
+            timeline[first + ITEM_FRAMES[0] - fade + i],
+            get_sample(2U, i)
+        );
+    }
+    xap::test::assert_equal<uint64_t>(playlist.get_gap_frame_count(), 0U);
+}
+
+/**
+ *  Test failures.
+ */
+static void failures() {
+    xap::audioio::PromptCache cache;
+    xap::audioio::PlaylistOptions options;
+    options.cache = &cache;
+    xap::audioio::PlaylistSource playlist(get_format(), options);
+    uint64_t first = playlist.append(get_path(1U).c_str());
+    uint64_t missing = playlist.append("playlist.unittest.missing.tmp");
+    uint64_t last = playlist.append(get_path(3U).c_str());
+    std::vector<xap::audioio::PlaylistEvent> events;
+    std::vector<int16_t> timeline = play(playlist, events);
+
+    size_t started_count = 0U;
+    size_t failed_count = 0U;
+    uint64_t end = 0U;
+    for (const xap::audioio::PlaylistEvent &event : events) {
+        if (event.type == xap::audioio::PLAYLISTEVENT_FAILED) {
+            xap::test::assert_equal<uint64_t>(event.item, missing);
+            xap::test::assert_equal<uint16_t>(
+                event.error,
+                xap::audioio::ERROR_IO
+            );
+            ++failed_count;
+        } else if (event.type == xap::audioio::PLAYLISTEVENT_STARTED) {
+            xap::test::assert_ok(event.item == first || event.item == last);
+            if (event.item == last) {
+                xap::test::assert_equal<uint64_t>(event.frame, end);
+            }
+            ++started_count;
+        } else if (event.item == first) {
+            end = event.frame;
+        }
+    }
+    xap::test::assert_equal<size_t>(started_count, 2U);
+    xap::test::assert_equal<size_t>(failed_count, 1U);
+    xap::test::assert_equal<int16_t>(timeline[end], get_sample(3U, 0U));
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::AudioFormat format = get_format();
+    format.sample_format = xap::audioio::SAMPLEFORMAT_ULAW;
+    try {
+        xap::audioio::PlaylistSource playlist(format);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+    xap::audioio::PlaylistOptions options;
+    options.lookahead = 0U;
+    try {
+        xap::audioio::PlaylistSource playlist(get_format(), options);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::PlaylistSource playlist(get_format());
+    xap::test::assert_ok(playlist.is_finished());
+    format = get_format();
+    format.channel_count = 2U;
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        playlist.read(output);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    write_items();
+
+    //
+    //  Case 1.
+    //
+    printf("Gapless...\n");
+    gapless();
+
+    //
+    //  Case 2.
+    //
+    printf("Crossfades...\n");
+    crossfades();
+
+    //
+    //  Case 3.
+    //
+    printf("Failures...\n");
+    failures();
+
+    //
+    //  Case 4.
+    //
+    printf("Errors...\n");
+    errors();
+
+    remove_items();
+    return 0;
+}
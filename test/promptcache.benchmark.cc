@@ -0,0 +1,148 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PROMPT_COUNT  = 64U;
+const static size_t PROMPT_FRAMES = 16000U;   //  2s at 8kHz.
+const static size_t LOOKUP_COUNT  = 200000U;  //  Per thread.
+
+/**
+ *  Get the path of a benchmark prompt.
+ */
+static std::string get_path(size_t prompt) {
+    return "promptcache.benchmark." + std::to_string(prompt) + ".tmp";
+}
+
+/**
+ *  Get the format of the benchmark prompts (16-bit mono 8kHz).
+ */
+static xap::audioio::AudioFormat get_format() {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 8000U;
+    return format;
+}
+
+/**
+ *  Write the benchmark prompts (noise).
+ */
+static void write_prompts() {
+    xap::audioio::AudioFormat format = get_format();
+    uint32_t seed = 1U;
+    for (size_t p = 0U; p < PROMPT_COUNT; ++p) {
+        xap::audioio::AudioFileWriter writer(get_path(p).c_str(), format);
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, PROMPT_FRAMES);
+        for (size_t i = 0U; i < PROMPT_FRAMES; ++i) {
+            seed = seed * 1664525U + 1013904223U;
+            data.get_samples<int16_t>()[i] = static_cast<int16_t>(seed >> 16);
+        }
+        writer.process(data);
+        writer.close();
+    }
+}
+
+/**
+ *  Measure decoding each playback (no cache).
+ */
+static void run_uncached() {
+    xap::audioio::AudioFormat format = get_format();
+    xap::audioio::PromptCache cache;
+    size_t count = 0U;
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < 4U * PROMPT_COUNT; ++i) {
+        cache.load(get_path(i % PROMPT_COUNT).c_str(), format);
+        cache.clear();
+        ++count;
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    printf(
+        "uncached |       1 | %16.0f\n",
+        static_cast<double>(count) / elapsed
+    );
+}
+
+/**
+ *  Measure cached lookups (each followed by one period of playback).
+ * 
+ *  @param thread_count
+ *      The count of threads.
+ */
+static void run_cached(size_t thread_count) {
+    xap::audioio::AudioFormat format = get_format();
+    xap::audioio::PromptCache cache;
+    for (size_t p = 0U; p < PROMPT_COUNT; ++p) {
+        cache.load(get_path(p).c_str(), format);
+    }
+    std::vector<std::string> paths;
+    for (size_t p = 0U; p < PROMPT_COUNT; ++p) {
+        paths.push_back(get_path(p));
+    }
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0U; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            xap::audioio::AudioBuffer output = 
+                xap::audioio::AudioBuffer::allocate(format, 160U);
+            uint32_t seed = static_cast<uint32_t>(t + 1U);
+            for (size_t i = 0U; i < LOOKUP_COUNT; ++i) {
+                seed = seed * 1664525U + 1013904223U;
+                xap::audioio::PromptSource prompt(cache.load(
+                    paths[(seed >> 16) % PROMPT_COUNT].c_str(),
+                    format
+                ));
+                prompt.read(output);
+            }
+        });
+    }
+    for (size_t t = 0U; t < thread_count; ++t) {
+        threads[t].join();
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    printf(
+        "  cached | %7zu | %16.0f\n",
+        thread_count,
+        static_cast<double>(thread_count * LOOKUP_COUNT) / elapsed
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    write_prompts();
+
+    printf("    Mode | Threads | Playbacks/second\n");
+    run_uncached();
+    run_cached(1U);
+    run_cached(4U);
+    run_cached(8U);
+
+    for (size_t p = 0U; p < PROMPT_COUNT; ++p) {
+        remove(get_path(p).c_str());
+    }
+    return 0;
+}
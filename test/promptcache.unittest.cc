@@ -0,0 +1,368 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+
+//  Count of test prompts.
+const static size_t PROMPT_COUNT = 16U;
+
+//  Count of frames of each test prompt.
+const static size_t PROMPT_FRAMES = 1000U;
+
+//  Size of each test prompt (16-bit mono).
+const static size_t PROMPT_SIZE = PROMPT_FRAMES * 2U;
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build an audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat  sample_format,
+    uint8_t                     channel_count,
+    uint32_t                    sample_rate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = channel_count;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Get the path of a test prompt.
+ */
+static std::string get_path(size_t prompt) {
+    return "promptcache.unittest." + std::to_string(prompt) + ".tmp";
+}
+
+/**
+ *  Get a sample of a test prompt.
+ */
+static int16_t get_sample(size_t prompt, size_t frame) {
+    return static_cast<int16_t>(prompt * 1000U + frame % 997U);
+}
+
+/**
+ *  Write the test prompts (16-bit mono 8kHz).
+ */
+static void write_prompts() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    for (size_t p = 0U; p < PROMPT_COUNT; ++p) {
+        xap::audioio::AudioFileWriter writer(get_path(p).c_str(), format);
+        xap::audioio::AudioBuffer data = 
+            xap::audioio::AudioBuffer::allocate(format, PROMPT_FRAMES);
+        for (size_t i = 0U; i < PROMPT_FRAMES; ++i) {
+            data.get_samples<int16_t>()[i] = get_sample(p, i);
+        }
+        writer.process(data);
+        writer.close();
+    }
+}
+
+/**
+ *  Remove the test prompts.
+ */
+static void remove_prompts() {
+    for (size_t p = 0U; p < PROMPT_COUNT; ++p) {
+        remove(get_path(p).c_str());
+    }
+}
+
+/**
+ *  Check the audio data of a test prompt (16-bit mono).
+ */
+static void check_prompt(const xap::audioio::AudioBuffer &buffer, size_t p) {
+    xap::test::assert_equal<size_t>(buffer.get_frame_count(), PROMPT_FRAMES);
+    const int16_t *samples = buffer.get_samples<int16_t>();
+    for (size_t i = 0U; i < PROMPT_FRAMES; ++i) {
+        xap::test::assert_equal<int16_t>(samples[i], get_sample(p, i));
+    }
+}
+
+/**
+ *  Test lookups (the decoded audio data is shared).
+ */
+static void lookups() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    xap::audioio::PromptCache cache;
+
+    xap::audioio::AudioBuffer first = cache.load(get_path(0U).c_str(), format);
+    check_prompt(first, 0U);
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 1U);
+    xap::test::assert_equal<size_t>(cache.get_size(), PROMPT_SIZE);
+
+    xap::audioio::AudioBuffer second = 
+        cache.load(get_path(0U).c_str(), format);
+    xap::test::assert_ok(
+        second.get_pointer() == first.get_pointer(),
+        "The audio data was not shared."
+    );
+    xap::test::assert_equal<uint64_t>(cache.get_hit_count(), 1U);
+
+    //  Another format is another prompt.
+    xap::audioio::AudioBuffer converted = cache.load(
+        get_path(0U).c_str(),
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U, 8000U)
+    );
+    xap::test::assert_ok(
+        converted.get_pointer() != first.get_pointer(),
+        "The formats were not distinguished."
+    );
+    xap::test::assert_equal<size_t>(converted.get_frame_count(), PROMPT_FRAMES);
+    xap::test::assert_equal<float>(
+        converted.get_samples<float>()[2U * 5U + 1U],
+        static_cast<float>(get_sample(0U, 5U)) / 32768.0F
+    );
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 2U);
+    xap::test::assert_equal<size_t>(
+        cache.get_size(),
+        PROMPT_SIZE + PROMPT_FRAMES * 8U
+    );
+
+    //  Removal (in all formats).
+    cache.remove(get_path(0U).c_str());
+    xap::test::assert_equal<size_t>(cache.get_size(), 0U);
+    check_prompt(first, 0U);
+    cache.load(get_path(0U).c_str(), format);
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 3U);
+    cache.clear();
+    xap::test::assert_equal<size_t>(cache.get_size(), 0U);
+}
+
+/**
+ *  Test the eviction (least recently used first).
+ */
+static void eviction() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    xap::audioio::PromptCacheOptions options;
+    options.budget = 3U * PROMPT_SIZE;
+    options.shard_count = 1U;
+    xap::audioio::PromptCache cache(options);
+
+    xap::audioio::AudioBuffer held = cache.load(get_path(1U).c_str(), format);
+    cache.load(get_path(0U).c_str(), format);
+    cache.load(get_path(2U).c_str(), format);
+    xap::test::assert_equal<size_t>(cache.get_size(), 3U * PROMPT_SIZE);
+
+    //  Prompt 1 is the least recently used now.
+    cache.load(get_path(0U).c_str(), format);
+    cache.load(get_path(2U).c_str(), format);
+    cache.load(get_path(3U).c_str(), format);
+    xap::test::assert_equal<size_t>(cache.get_size(), 3U * PROMPT_SIZE);
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 4U);
+    cache.load(get_path(0U).c_str(), format);
+    cache.load(get_path(2U).c_str(), format);
+    cache.load(get_path(3U).c_str(), format);
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 4U);
+
+    //  The evicted audio data is still valid for its holders.
+    check_prompt(held, 1U);
+    cache.load(get_path(1U).c_str(), format);
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 5U);
+
+    //  Shrink the budget.
+    cache.set_budget(PROMPT_SIZE);
+    xap::test::assert_equal<size_t>(cache.get_size(), PROMPT_SIZE);
+    cache.load(get_path(1U).c_str(), format);
+    xap::test::assert_equal<uint64_t>(cache.get_miss_count(), 5U);
+
+    //  Prompts larger than the budget are not cached.
+    cache.set_budget(PROMPT_SIZE - 1U);
+    xap::test::assert_equal<size_t>(cache.get_size(), 0U);
+    check_prompt(cache.load(get_path(4U).c_str(), format), 4U);
+    xap::test::assert_equal<size_t>(cache.get_size(), 0U);
+}
+
+/**
+ *  Test concurrent lookups.
+ */
+static void concurrency() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    xap::audioio::PromptCacheOptions options;
+    options.budget = 16U * PROMPT_COUNT * PROMPT_SIZE;
+    options.shard_count = 4U;
+    xap::audioio::PromptCache cache(options);
+
+    const size_t thread_count = 8U;
+    const size_t lookup_count = 2000U;
+    std::vector<std::thread> threads;
+    std::vector<size_t> errors(thread_count, 0U);
+    for (size_t t = 0U; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            uint32_t seed = static_cast<uint32_t>(t + 1U);
+            for (size_t i = 0U; i < lookup_count; ++i) {
+                seed = seed * 1664525U + 1013904223U;
+                size_t p = (seed >> 16) % PROMPT_COUNT;
+                xap::audioio::AudioBuffer prompt = 
+                    cache.load(get_path(p).c_str(), format);
+                const int16_t *samples = prompt.get_samples<int16_t>();
+                if (prompt.get_frame_count() != PROMPT_FRAMES || 
+                    samples[0] != get_sample(p, 0U) || 
+                    samples[PROMPT_FRAMES - 1U] != 
+                        get_sample(p, PROMPT_FRAMES - 1U)) {
+                    ++errors[t];
+                }
+            }
+        });
+    }
+    for (size_t t = 0U; t < thread_count; ++t) {
+        threads[t].join();
+        xap::test::assert_equal<size_t>(errors[t], 0U);
+    }
+    xap::test::assert_equal<uint64_t>(
+        cache.get_hit_count() + cache.get_miss_count(),
+        thread_count * lookup_count
+    );
+    xap::test::assert_equal<size_t>(
+        cache.get_size(),
+        PROMPT_COUNT * PROMPT_SIZE
+    );
+}
+
+/**
+ *  Test the prompt source.
+ */
+static void source() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    xap::audioio::PromptCache cache;
+    xap::audioio::PromptSource prompt(
+        cache.load(get_path(5U).c_str(), format)
+    );
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 160U);
+    std::vector<int16_t> played;
+    while (!prompt.is_finished()) {
+        size_t count = prompt.read(output);
+        played.insert(
+            played.end(),
+            output.get_samples<int16_t>(),
+            output.get_samples<int16_t>() + count
+        );
+    }
+    xap::test::assert_equal<size_t>(played.size(), PROMPT_FRAMES);
+    for (size_t i = 0U; i < PROMPT_FRAMES; ++i) {
+        xap::test::assert_equal<int16_t>(played[i], get_sample(5U, i));
+    }
+    xap::test::assert_equal<size_t>(prompt.read(output), 0U);
+
+    //  Seek.
+    prompt.seek(990U);
+    xap::test::assert_equal<size_t>(prompt.get_position(), 990U);
+    xap::test::assert_equal<size_t>(prompt.read(output), 10U);
+    xap::test::assert_equal<int16_t>(
+        output.get_samples<int16_t>()[0],
+        get_sample(5U, 990U)
+    );
+
+    //  Format mismatch.
+    xap::audioio::AudioBuffer mismatched = xap::audioio::AudioBuffer::allocate(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 2U, 8000U),
+        160U
+    );
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        prompt.read(mismatched);
+    });
+}
+
+/**
+ *  Test errors.
+ */
+static void errors() {
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U);
+    xap::audioio::PromptCacheOptions options;
+    options.shard_count = 0U;
+    try {
+        xap::audioio::PromptCache cache(options);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_PARAMETER
+        );
+    }
+
+    xap::audioio::PromptCache cache;
+    try {
+        cache.load("promptcache.unittest.missing.tmp", format);
+        xap::test::assert_ok(false);
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(),
+            xap::audioio::ERROR_IO
+        );
+    }
+    xap::test::assert_equal<size_t>(cache.get_size(), 0U);
+
+    //  The process-wide cache.
+    xap::test::assert_ok(
+        &xap::audioio::get_default_prompt_cache() == 
+            &xap::audioio::get_default_prompt_cache(),
+        "The process-wide cache was not unique."
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    write_prompts();
+
+    //
+    //  Case 1.
+    //
+    printf("Lookups...\n");
+    lookups();
+
+    //
+    //  Case 2.
+    //
+    printf("Eviction...\n");
+    eviction();
+
+    //
+    //  Case 3.
+    //
+    printf("Concurrency...\n");
+    concurrency();
+
+    //
+    //  Case 4.
+    //
+    printf("Source...\n");
+    source();
+
+    //
+    //  Case 5.
+    //
+    printf("Errors...\n");
+    errors();
+
+    remove_prompts();
+    return 0;
+}
@@ -9,21 +9,273 @@
 //
 #include "common.h"
 
+#include <algorithm>
+#include <atomic>
+#include <math.h>
 #include <memory>
 #include <mutex>
+#include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <vector>
 #include <xap/audioio/all.h>
 #include <xap/core/buffer/buffer.h>
 #include <xap/core/buffer/queue.h>
 
+//
+//  Private constants.
+//
+
+//  Upper bound of a plausible time to first sample (in seconds, the 
+//  latency of the output device plus a few periods).
+const static double MAX_TIME_TO_FIRST_SAMPLE = 0.5;
+
+/**
+ *  Allocator which counts outstanding allocations.
+ */
+class CountingAllocator: public xap::audioio::IAllocator {
+public:
+    CountingAllocator() noexcept : m_count(0) {}
+
+    virtual void *allocate(size_t size, size_t alignment) noexcept override {
+        void *pointer = this->m_system.allocate(size, alignment);
+        if (pointer != nullptr) {
+            ++(this->m_count);
+        }
+        return pointer;
+    }
+
+    virtual void deallocate(
+        void   *pointer, 
+        size_t  size, 
+        size_t  alignment
+    ) noexcept override {
+        --(this->m_count);
+        this->m_system.deallocate(pointer, size, alignment);
+    }
+
+    int get_count() const noexcept {
+        return this->m_count.load();
+    }
+
+private:
+    xap::audioio::DefaultAllocator m_system;
+    std::atomic<int>               m_count;
+};
+
+//
+//  Test cases.
+//
+
+/**
+ *  Test the channel map of direct monitoring.
+ */
+static void monitor_map() {
+    //
+    //  Default: the input channel of the same index (modulo the count of 
+    //  input channels).
+    //
+    xap::audioio::MonitorOptions options;
+    options.enabled = true;
+    options.channel_count = 2U;
+    xap::audioio::MonitorMixer mixer(options, 5U);
+    xap::test::assert_ok(mixer.is_enabled(), "Monitor is not enabled.");
+    for (size_t k = 0U; k < 5U; ++k) {
+        xap::test::assert_equal<size_t>(mixer.get_input_channel(k), k % 2U);
+    }
+    xap::test::assert_equal<size_t>(mixer.get_input_channel(5U), SIZE_MAX);
+
+    //
+    //  Explicit entries and NONE.
+    //
+    options.channel_map[0] = xap::audioio::MONITOR_CHANNEL_NONE;
+    options.channel_map[1] = 0;
+    options.channel_map[3] = 1;
+    xap::audioio::MonitorMixer mapped(options, 4U);
+    xap::test::assert_equal<size_t>(mapped.get_input_channel(0U), SIZE_MAX);
+    xap::test::assert_equal<size_t>(mapped.get_input_channel(1U), 0U);
+    xap::test::assert_equal<size_t>(mapped.get_input_channel(2U), 0U);
+    xap::test::assert_equal<size_t>(mapped.get_input_channel(3U), 1U);
+
+    //
+    //  The input is summed into the bus without saturation.
+    //
+    const int16_t input[2] = {16384, -32768};
+    float bus[4] = {0.75F, 0.75F, 0.75F, -0.75F};
+    mapped.mix(input, bus, 1U);
+    xap::test::assert_ok(bus[0] == 0.75F, "Unmapped channel was changed.");
+    xap::test::assert_ok(bus[1] == 1.25F, "Channel 1 was not mixed.");
+    xap::test::assert_ok(bus[2] == 1.25F, "Channel 2 was not mixed.");
+    xap::test::assert_ok(bus[3] == -1.75F, "Channel 3 was not mixed.");
+
+    //
+    //  Disabled: nothing is mixed, the gain can not be set.
+    //
+    xap::audioio::MonitorOptions disabled;
+    xap::audioio::MonitorMixer idle(disabled, 2U);
+    xap::test::assert_ok(!idle.is_enabled(), "Monitor is enabled.");
+    idle.mix(input, bus, 1U);
+    xap::test::assert_ok(bus[0] == 0.75F, "Disabled monitor mixed.");
+    try {
+        idle.set_gain(0.0F);
+        xap::test::assert_ok(false, "Set the gain of a disabled monitor.");
+    } catch (xap::audioio::Exception &error) {
+        xap::test::assert_equal<uint16_t>(
+            error.get_code(), 
+            xap::audioio::ERROR_INVALIDOPERATION
+        );
+    }
+}
+
+/**
+ *  Test the gain ramp of direct monitoring.
+ */
+static void monitor_ramp() {
+    const size_t frame_count = 64U;
+    xap::audioio::MonitorOptions options;
+    options.enabled = true;
+    xap::audioio::MonitorMixer mixer(options, 1U);
+
+    std::vector<int16_t> input(frame_count, 16384);
+    std::vector<float> bus(frame_count, 0.0F);
+
+    //
+    //  Mute: the gain falls linearly from 1 to 0 over the next call.
+    //
+    mixer.set_gain(-INFINITY);
+    mixer.mix(input.data(), bus.data(), frame_count);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        float expected = 0.5F * (1.0F - static_cast<float>(i + 1U) / 
+                                        static_cast<float>(frame_count));
+        xap::test::assert_ok(
+            fabsf(bus[i] - expected) < 1e-5F, 
+            "The gain was not ramped down."
+        );
+    }
+
+    //
+    //  Muted: nothing is mixed.
+    //
+    std::fill(bus.begin(), bus.end(), 0.0F);
+    mixer.mix(input.data(), bus.data(), frame_count);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        xap::test::assert_ok(bus[i] == 0.0F, "Muted monitor mixed.");
+    }
+
+    //
+    //  +6dB: ramped up from 0, then constant.
+    //
+    mixer.set_gain(20.0F * log10f(2.0F));
+    mixer.mix(input.data(), bus.data(), frame_count);
+    for (size_t i = 1U; i < frame_count; ++i) {
+        xap::test::assert_ok(
+            bus[i] > bus[i - 1U], 
+            "The gain was not ramped up."
+        );
+    }
+    xap::test::assert_ok(fabsf(bus[frame_count - 1U] - 1.0F) < 1e-5F);
+    std::fill(bus.begin(), bus.end(), 0.0F);
+    mixer.mix(input.data(), bus.data(), frame_count);
+    for (size_t i = 0U; i < frame_count; ++i) {
+        xap::test::assert_ok(fabsf(bus[i] - 1.0F) < 1e-5F);
+    }
+
+    //
+    //  Invalid gains.
+    //
+    const float gains[] = {xap::audioio::MONITOR_MAX_GAIN + 1.0F, NAN};
+    for (float gain : gains) {
+        try {
+            mixer.set_gain(gain);
+            xap::test::assert_ok(false, "Set an invalid gain.");
+        } catch (xap::audioio::Exception &error) {
+            xap::test::assert_equal<uint16_t>(
+                error.get_code(), 
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+    }
+}
+
+/**
+ *  Test that the player rejects invalid options of direct monitoring.
+ * 
+ *  @param allocator
+ *      The allocator.
+ */
+static void monitor_options(xap::audioio::IAllocator *allocator) {
+    xap::audioio::PlayerFactory factory(allocator);
+    for (size_t index = 0U; index < 6U; ++index) {
+        xap::audioio::PlayerOptions options;
+        options.channel_count = 2U;
+        options.frame_pre_buffer = 256U;
+        options.sample_rate = 16000U;
+        options.monitor.enabled = true;
+        options.monitor.channel_count = 2U;
+        switch (index) {
+        case 0U:
+            //  No input channel.
+            options.monitor.channel_count = 0U;
+            break;
+        case 1U:
+            //  Too many output channels.
+            options.channel_count = static_cast<uint8_t>(
+                xap::audioio::MONITOR_MAX_CHANNELS + 1U
+            );
+            break;
+        case 2U:
+            //  Gain above the maximum.
+            options.monitor.gain = xap::audioio::MONITOR_MAX_GAIN + 0.5F;
+            break;
+        case 3U:
+            //  Invalid gain.
+            options.monitor.gain = NAN;
+            break;
+        case 4U:
+            //  Input channel out of range.
+            options.monitor.channel_map[1] = 2;
+            break;
+        default:
+            //  Invalid special entry.
+            options.monitor.channel_map[0] = -3;
+            break;
+        }
+        try {
+            std::unique_ptr<xap::audioio::IPlayer> player = 
+                factory.load_unique_pointer(options);
+            xap::test::assert_ok(false, "Invalid monitor options accepted.");
+        } catch (xap::audioio::Exception &error) {
+            xap::test::assert_equal<uint16_t>(
+                error.get_code(), 
+                xap::audioio::ERROR_PARAMETER
+            );
+        }
+    }
+}
+
 //
 //  Entry.
 //
 int main() {
+    CountingAllocator              allocator;
     xap::core::buffer::BufferQueue audio_queue;
     std::mutex                     audio_queue_lock;
 
+    //
+    //  Direct monitoring.
+    //
+    printf("Monitor channel map...\n");
+    monitor_map();
+    printf("Monitor gain ramp...\n");
+    monitor_ramp();
+    printf("Monitor options...\n");
+    monitor_options(&allocator);
+    xap::test::assert_equal(
+        allocator.get_count(), 
+        0, 
+        "Rejected player memory was not released by the allocator."
+    );
+
     std::shared_ptr<xap::audioio::DeviceManager> device_mgr = 
         xap::audioio::DeviceManager::load_shared_instance();
 
@@ -37,7 +289,7 @@ int main() {
     //
     printf("Recording...\n");
     std::unique_ptr<xap::audioio::RecorderFactory> recorder_factory = 
-        std::make_unique<xap::audioio::RecorderFactory>();
+        std::make_unique<xap::audioio::RecorderFactory>(&allocator);
     xap::audioio::RecorderOptions recorder_options;
     recorder_options.device = input_device;
     recorder_options.channel_count = 1U;
@@ -52,6 +304,19 @@ int main() {
         };
     recorder->set_audio_callback(audio_callback);
 
+    int64_t next_timestamp = 0;
+    std::function<void(const xap::audioio::AudioBuffer &)> frame_callback = 
+        [&] (const xap::audioio::AudioBuffer &data) {
+            xap::test::assert_ok(
+                data.get_timestamp() >= next_timestamp,
+                "Frame timestamp went backwards."
+            );
+            xap::test::assert_equal<uint8_t>(data.get_channel_count(), 1U);
+            next_timestamp = data.get_timestamp() + 
+                             static_cast<int64_t>(data.get_frame_count());
+        };
+    recorder->set_frame_callback(frame_callback);
+
     std::function<void(const xap::audioio::Exception &)> error_callback = 
         [] (const xap::audioio::Exception &error) {
             printf("Recorder exception : %s\n", error.what());
@@ -59,18 +324,46 @@ int main() {
         };
     recorder->set_error_callback(error_callback);
 
+    xap::test::assert_throw<xap::audioio::Exception>(
+        [&]() { recorder->pause(); },
+        "Paused a recorder which is not running."
+    );
+
     recorder->start();
-    usleep(3000U * 1000U);
+    usleep(1500U * 1000U);
+
+    //
+    //  Pause & resume.
+    //
+    recorder->pause();
+    xap::test::assert_ok(recorder->is_paused(), "Recorder is not paused.");
+    xap::test::assert_throw<xap::audioio::Exception>(
+        [&]() { recorder->pause(); },
+        "Paused a recorder which was already paused."
+    );
+    usleep(500U * 1000U);
+    recorder->resume();
+    xap::test::assert_ok(!recorder->is_paused(), "Recorder is still paused.");
+
+    usleep(1500U * 1000U);
     recorder->stop();
 
     printf("Finished recording...\n");
+    xap::test::assert_ok(next_timestamp > 0, "No frame was delivered.");
+
+    recorder.reset();
+    xap::test::assert_equal(
+        allocator.get_count(), 
+        0, 
+        "Recorder memory was not released by the allocator."
+    );
 
     //
     //  Player.
     //
     printf("Start to play...\n");
     std::unique_ptr<xap::audioio::PlayerFactory> player_factory = 
-        std::make_unique<xap::audioio::PlayerFactory>();
+        std::make_unique<xap::audioio::PlayerFactory>(&allocator);
 
     xap::audioio::PlayerOptions player_options;
     player_options.channel_count = 1U;
@@ -78,8 +371,14 @@ int main() {
     player_options.frame_pre_buffer = 1024U;
     player_options.sample_rate = 16000U;
     player_options.suggested_latency = output_device.default_low_latency;
+    player_options.prime_output_buffers = true;
     std::unique_ptr<xap::audioio::IPlayer> player = 
         player_factory->load_unique_pointer(player_options);
+    xap::test::assert_equal<size_t>(
+        player->get_limiter_latency(), 
+        0U, 
+        "The limiter without look-ahead has latency."
+    );
     std::function<void(xap::core::buffer::Buffer &)> player_audio_cbk = 
         [&](xap::core::buffer::Buffer &data) {
             //
@@ -106,8 +405,33 @@ int main() {
     player->set_audio_callback(player_audio_cbk);
     player->set_error_callback(player_error_cbk);
 
+    //
+    //  Pre-roll.
+    //
+    if (audio_queue.get_remaining_size() >= 2048U) {
+        xap::core::buffer::Buffer preroll_data = audio_queue.pop(2048U);
+        player->preroll(preroll_data);
+    }
+    xap::test::assert_ok(
+        player->get_time_to_first_sample() < 0.0,
+        "Time to first sample is available before started."
+    );
+
     player->start();
 
+    //
+    //  Pause & resume.
+    //
+    usleep(500U * 1000U);
+    player->pause();
+    xap::test::assert_ok(player->is_paused(), "Player is not paused.");
+    usleep(500U * 1000U);
+    player->resume();
+    xap::test::assert_throw<xap::audioio::Exception>(
+        [&]() { player->resume(); },
+        "Resumed a player which is not paused."
+    );
+
     while (true) {
         {
             //
@@ -125,5 +449,25 @@ int main() {
     player->stop(false);
     printf("Finsihed playing...\n");
 
+    printf(
+        "Time to first sample: %.2f ms\n", 
+        player->get_time_to_first_sample() * 1000.0
+    );
+    xap::test::assert_ok(
+        player->get_time_to_first_sample() >= 0.0,
+        "Time to first sample is not available."
+    );
+    xap::test::assert_ok(
+        player->get_time_to_first_sample() <= MAX_TIME_TO_FIRST_SAMPLE,
+        "Time to first sample is not plausible."
+    );
+
+    player.reset();
+    xap::test::assert_equal(
+        allocator.get_count(), 
+        0, 
+        "Player memory was not released by the allocator."
+    );
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private constants.
+//
+const static size_t PERIOD_FRAMES = 160U;     //  20ms at 8kHz.
+const static size_t PERIOD_COUNT  = 500U;     //  10s.
+
+/**
+ *  Run the benchmark with 'generator_count' concurrent 8kHz generators.
+ * 
+ *  @param generator_count
+ *      The count of generators.
+ */
+static void run(size_t generator_count) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = xap::audioio::SAMPLEFORMAT_INT16;
+    format.channel_count = 1U;
+    format.sample_rate = 8000U;
+
+    std::vector<std::unique_ptr<xap::audioio::ToneGenerator>> generators;
+    for (size_t i = 0U; i < generator_count; ++i) {
+        generators.emplace_back(new xap::audioio::ToneGenerator(format));
+        generators.back()->play(
+            xap::audioio::build_dtmf_sequence("0123456789*#ABCD", 40U, 40U)
+        );
+    }
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, PERIOD_FRAMES);
+
+    std::chrono::steady_clock::time_point begin = 
+        std::chrono::steady_clock::now();
+    for (size_t i = 0U; i < PERIOD_COUNT; ++i) {
+        for (size_t j = 0U; j < generator_count; ++j) {
+            generators[j]->read(output);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin
+    ).count();
+    double audio = static_cast<double>(PERIOD_FRAMES * PERIOD_COUNT) / 8000.0;
+
+    printf(
+        "%10lu | %20.1f | %14.2f\n",
+        static_cast<unsigned long>(generator_count),
+        audio / elapsed,
+        elapsed / static_cast<double>(PERIOD_COUNT) * 1000000.0
+    );
+}
+
+//
+//  Main.
+//
+int main() {
+    printf("Generators | Real-time (x faster) | Period (us/op)\n");
+    for (size_t generators = 1U; generators <= 4096U; generators *= 4U) {
+        run(generators);
+    }
+
+    return 0;
+}
@@ -0,0 +1,297 @@
+//
+//  Copyright 2019 - 2021 The XOrange Studio. All rights reserved.
+//  Use of this source code is governed by a BSD-style license that can be
+//  found in the LICENSE.md file.
+//
+
+//
+//  Imports.
+//
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <xap/audioio/all.h>
+
+//
+//  Private functions.
+//
+
+/**
+ *  Build an audio format.
+ * 
+ *  @param sample_format
+ *      The sample format.
+ *  @param channel_count
+ *      The count of channels.
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The audio format.
+ */
+static xap::audioio::AudioFormat build_format(
+    xap::audioio::SampleFormat sample_format,
+    uint8_t                    channel_count,
+    uint32_t                   sample_rate
+) {
+    xap::audioio::AudioFormat format;
+    format.sample_format = sample_format;
+    format.channel_count = channel_count;
+    format.sample_rate = sample_rate;
+    return format;
+}
+
+/**
+ *  Build a tone sequence of one segment.
+ * 
+ *  @param frequency
+ *      The frequency.
+ *  @param on_duration
+ *      The on duration.
+ *  @param off_duration
+ *      The off duration.
+ *  @param repeat_count
+ *      The repeat count.
+ *  @return
+ *      The sequence.
+ */
+static xap::audioio::ToneSequence build_tone(
+    float    frequency, 
+    uint32_t on_duration, 
+    uint32_t off_duration, 
+    uint32_t repeat_count
+) {
+    xap::audioio::ToneSequence sequence;
+    memset(&sequence, 0, sizeof(sequence));
+    sequence.segments[0].frequencies[0] = frequency;
+    sequence.segments[0].levels[0] = 0.5F;
+    sequence.segments[0].on_duration = on_duration;
+    sequence.segments[0].off_duration = off_duration;
+    sequence.segment_count = 1U;
+    sequence.repeat_count = repeat_count;
+    return sequence;
+}
+
+/**
+ *  Read 16-bit mono frames from a generator in chunks.
+ * 
+ *  @param generator
+ *      The generator.
+ *  @param frame_count
+ *      The count of frames.
+ *  @param chunk
+ *      The count of frames per read.
+ *  @param sample_rate
+ *      The sample rate.
+ *  @return
+ *      The samples.
+ */
+static std::vector<int16_t> read_all(
+    xap::audioio::ToneGenerator &generator, 
+    size_t                       frame_count, 
+    size_t                       chunk,
+    uint32_t                     sample_rate
+) {
+    std::vector<int16_t> samples;
+    xap::audioio::AudioBuffer output = xap::audioio::AudioBuffer::allocate(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, sample_rate), 
+        chunk
+    );
+    while (samples.size() < frame_count) {
+        xap::test::assert_equal<size_t>(generator.read(output), chunk);
+        samples.insert(
+            samples.end(), 
+            output.get_samples<int16_t>(), 
+            output.get_samples<int16_t>() + chunk
+        );
+    }
+    samples.resize(frame_count);
+    return samples;
+}
+
+/**
+ *  Get the maximum difference of adjacent samples.
+ * 
+ *  @param samples
+ *      The samples.
+ *  @return
+ *      The maximum difference.
+ */
+static int get_max_step(const std::vector<int16_t> &samples) {
+    int rst = 0;
+    for (size_t i = 1U; i < samples.size(); ++i) {
+        int step = abs(static_cast<int>(samples[i]) - samples[i - 1U]);
+        if (step > rst) {
+            rst = step;
+        }
+    }
+    return rst;
+}
+
+//
+//  Test cases.
+//
+
+void dtmf_digits() {
+    xap::audioio::ToneGenerator generator(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U)
+    );
+    xap::test::assert_ok(generator.play(
+        xap::audioio::build_dtmf_sequence("159#", 100U, 100U), 
+        800
+    ));
+
+    std::vector<xap::audioio::DtmfEvent> events;
+    std::function<void(const xap::audioio::DtmfEvent &)> callback = 
+        [&](const xap::audioio::DtmfEvent &event) {
+            events.push_back(event);
+        };
+    xap::audioio::DtmfDetector detector(1U);
+    detector.set_event_callback(callback);
+
+    std::vector<int16_t> samples = read_all(generator, 8000U, 160U, 8000U);
+    detector.process(samples.data(), samples.size(), 0);
+
+    xap::test::assert_equal<size_t>(events.size(), 4U);
+    for (size_t i = 0U; i < 4U; ++i) {
+        xap::test::assert_equal<char>(events[i].digit, "159#"[i]);
+        int64_t start = 800 + static_cast<int64_t>(i) * 1600;
+        xap::test::assert_ok(
+            events[i].timestamp >= start - 205 && 
+                events[i].timestamp <= start + 205,
+            "Timestamp out of range."
+        );
+    }
+    xap::test::assert_ok(!generator.is_active(), "Sequence did not end.");
+
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::build_dtmf_sequence("12x");
+    });
+}
+
+void sample_accurate_start() {
+    xap::audioio::ToneGenerator generator(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 8000U)
+    );
+    generator.play(build_tone(1000.0F, 1000U, 0U, 0U), 1000);
+    std::vector<int16_t> samples = read_all(generator, 2000U, 37U, 8000U);
+    for (size_t i = 0U; i <= 1000U; ++i) {
+        xap::test::assert_equal<int16_t>(samples[i], 0);
+    }
+    xap::test::assert_ok(samples[1002U] != 0, "Tone did not start.");
+    xap::test::assert_equal<int64_t>(generator.get_position(), 2035);
+}
+
+void phase_continuity() {
+    xap::audioio::ToneGenerator a(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 48000U)
+    );
+    xap::audioio::ToneGenerator b(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 48000U)
+    );
+    a.play(build_tone(440.0F, 2000U, 0U, 0U));
+    b.play(build_tone(440.0F, 2000U, 0U, 0U));
+    std::vector<int16_t> chunked = read_all(a, 48000U, 37U, 48000U);
+    std::vector<int16_t> whole = read_all(b, 48000U, 48000U, 48000U);
+    for (size_t i = 0U; i < whole.size(); ++i) {
+        xap::test::assert_ok(
+            abs(static_cast<int>(chunked[i]) - whole[i]) <= 1, 
+            "Phase discontinuity."
+        );
+    }
+}
+
+void click_free() {
+    //
+    //  Replace a playing tone, then stop: no jumps larger than the 
+    //  steepest slope of both tones.
+    //
+    xap::audioio::ToneGenerator generator(
+        build_format(xap::audioio::SAMPLEFORMAT_INT16, 1U, 48000U)
+    );
+    generator.play(build_tone(440.0F, 10000U, 0U, 0U));
+    generator.play(build_tone(1000.0F, 10000U, 0U, 0U), 3001);
+    generator.stop(7003);
+    std::vector<int16_t> samples = read_all(generator, 12000U, 256U, 48000U);
+    xap::test::assert_ok(get_max_step(samples) < 3500, "Click.");
+
+    //  Silent after the fade-out.
+    for (size_t i = 7003U + 192U; i < samples.size(); ++i) {
+        xap::test::assert_equal<int16_t>(samples[i], 0);
+    }
+    xap::test::assert_ok(!generator.is_active(), "Still active.");
+}
+
+void cadence() {
+    //
+    //  100ms on, 100ms off, 3 times, on stereo float output.
+    //
+    xap::audioio::AudioFormat format = 
+        build_format(xap::audioio::SAMPLEFORMAT_FLOAT32, 2U, 8000U);
+    xap::audioio::ToneGenerator generator(format);
+    generator.play(build_tone(425.0F, 100U, 100U, 3U));
+
+    xap::audioio::AudioBuffer output = 
+        xap::audioio::AudioBuffer::allocate(format, 8000U);
+    generator.read(output);
+    const float *samples = output.get_samples<float>();
+    for (size_t window = 0U; window < 10U; ++window) {
+        float peak = 0.0F;
+        for (size_t i = window * 800U; i < (window + 1U) * 800U; ++i) {
+            xap::test::assert_ok(samples[i * 2U] == samples[i * 2U + 1U]);
+            if (samples[i * 2U] > peak) {
+                peak = samples[i * 2U];
+            }
+        }
+        bool expected = (window % 2U == 0U && window < 6U);
+        xap::test::assert_ok(
+            expected ? peak > 0.45F : peak == 0.0F, 
+            "Cadence mismatched."
+        );
+    }
+
+    xap::test::assert_throw<xap::audioio::Exception>([&]() {
+        xap::audioio::ToneSequence empty;
+        memset(&empty, 0, sizeof(empty));
+        generator.play(empty);
+    });
+}
+
+//
+//  Main.
+//
+int main() {
+    //
+    //  Case 1.
+    //
+    printf("DTMF digits...\n");
+    dtmf_digits();
+
+    //
+    //  Case 2.
+    //
+    printf("Sample-accurate start...\n");
+    sample_accurate_start();
+
+    //
+    //  Case 3.
+    //
+    printf("Phase continuity...\n");
+    phase_continuity();
+
+    //
+    //  Case 4.
+    //
+    printf("Click-free transitions...\n");
+    click_free();
+
+    //
+    //  Case 5.
+    //
+    printf("Cadence...\n");
+    cadence();
+
+    return 0;
+}